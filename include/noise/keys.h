@@ -24,6 +24,9 @@
 #define NOISE_KEYS_H
 
 #include <noise/keys/certificate.h>
+#include <noise/keys/keystore.h>
 #include <noise/keys/loader.h>
+#include <noise/keys/revocation.h>
+#include <noise/keys/verifier.h>
 
 #endif
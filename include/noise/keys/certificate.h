@@ -44,6 +44,8 @@ int Noise_Certificate_new(Noise_Certificate **obj);
 int Noise_Certificate_free(Noise_Certificate *obj);
 int Noise_Certificate_write(NoiseProtobuf *pbuf, int tag, const Noise_Certificate *obj);
 int Noise_Certificate_read(NoiseProtobuf *pbuf, int tag, Noise_Certificate **obj);
+size_t Noise_Certificate_measure(int tag, const Noise_Certificate *obj);
+int Noise_Certificate_encode(NoiseProtobuf *pbuf, int tag, const Noise_Certificate *obj);
 int Noise_Certificate_clear_version(Noise_Certificate *obj);
 int Noise_Certificate_has_version(const Noise_Certificate *obj);
 uint32_t Noise_Certificate_get_version(const Noise_Certificate *obj);
@@ -63,6 +65,8 @@ int Noise_CertificateChain_new(Noise_CertificateChain **obj);
 int Noise_CertificateChain_free(Noise_CertificateChain *obj);
 int Noise_CertificateChain_write(NoiseProtobuf *pbuf, int tag, const Noise_CertificateChain *obj);
 int Noise_CertificateChain_read(NoiseProtobuf *pbuf, int tag, Noise_CertificateChain **obj);
+size_t Noise_CertificateChain_measure(int tag, const Noise_CertificateChain *obj);
+int Noise_CertificateChain_encode(NoiseProtobuf *pbuf, int tag, const Noise_CertificateChain *obj);
 int Noise_CertificateChain_clear_certs(Noise_CertificateChain *obj);
 int Noise_CertificateChain_has_certs(const Noise_CertificateChain *obj);
 size_t Noise_CertificateChain_count_certs(const Noise_CertificateChain *obj);
@@ -74,6 +78,8 @@ int Noise_SubjectInfo_new(Noise_SubjectInfo **obj);
 int Noise_SubjectInfo_free(Noise_SubjectInfo *obj);
 int Noise_SubjectInfo_write(NoiseProtobuf *pbuf, int tag, const Noise_SubjectInfo *obj);
 int Noise_SubjectInfo_read(NoiseProtobuf *pbuf, int tag, Noise_SubjectInfo **obj);
+size_t Noise_SubjectInfo_measure(int tag, const Noise_SubjectInfo *obj);
+int Noise_SubjectInfo_encode(NoiseProtobuf *pbuf, int tag, const Noise_SubjectInfo *obj);
 int Noise_SubjectInfo_clear_id(Noise_SubjectInfo *obj);
 int Noise_SubjectInfo_has_id(const Noise_SubjectInfo *obj);
 const char *Noise_SubjectInfo_get_id(const Noise_SubjectInfo *obj);
@@ -106,6 +112,8 @@ int Noise_PublicKeyInfo_new(Noise_PublicKeyInfo **obj);
 int Noise_PublicKeyInfo_free(Noise_PublicKeyInfo *obj);
 int Noise_PublicKeyInfo_write(NoiseProtobuf *pbuf, int tag, const Noise_PublicKeyInfo *obj);
 int Noise_PublicKeyInfo_read(NoiseProtobuf *pbuf, int tag, Noise_PublicKeyInfo **obj);
+size_t Noise_PublicKeyInfo_measure(int tag, const Noise_PublicKeyInfo *obj);
+int Noise_PublicKeyInfo_encode(NoiseProtobuf *pbuf, int tag, const Noise_PublicKeyInfo *obj);
 int Noise_PublicKeyInfo_clear_algorithm(Noise_PublicKeyInfo *obj);
 int Noise_PublicKeyInfo_has_algorithm(const Noise_PublicKeyInfo *obj);
 const char *Noise_PublicKeyInfo_get_algorithm(const Noise_PublicKeyInfo *obj);
@@ -121,6 +129,8 @@ int Noise_MetaInfo_new(Noise_MetaInfo **obj);
 int Noise_MetaInfo_free(Noise_MetaInfo *obj);
 int Noise_MetaInfo_write(NoiseProtobuf *pbuf, int tag, const Noise_MetaInfo *obj);
 int Noise_MetaInfo_read(NoiseProtobuf *pbuf, int tag, Noise_MetaInfo **obj);
+size_t Noise_MetaInfo_measure(int tag, const Noise_MetaInfo *obj);
+int Noise_MetaInfo_encode(NoiseProtobuf *pbuf, int tag, const Noise_MetaInfo *obj);
 int Noise_MetaInfo_clear_name(Noise_MetaInfo *obj);
 int Noise_MetaInfo_has_name(const Noise_MetaInfo *obj);
 const char *Noise_MetaInfo_get_name(const Noise_MetaInfo *obj);
@@ -136,6 +146,8 @@ int Noise_Signature_new(Noise_Signature **obj);
 int Noise_Signature_free(Noise_Signature *obj);
 int Noise_Signature_write(NoiseProtobuf *pbuf, int tag, const Noise_Signature *obj);
 int Noise_Signature_read(NoiseProtobuf *pbuf, int tag, Noise_Signature **obj);
+size_t Noise_Signature_measure(int tag, const Noise_Signature *obj);
+int Noise_Signature_encode(NoiseProtobuf *pbuf, int tag, const Noise_Signature *obj);
 int Noise_Signature_clear_id(Noise_Signature *obj);
 int Noise_Signature_has_id(const Noise_Signature *obj);
 const char *Noise_Signature_get_id(const Noise_Signature *obj);
@@ -169,6 +181,8 @@ int Noise_ExtraSignedInfo_new(Noise_ExtraSignedInfo **obj);
 int Noise_ExtraSignedInfo_free(Noise_ExtraSignedInfo *obj);
 int Noise_ExtraSignedInfo_write(NoiseProtobuf *pbuf, int tag, const Noise_ExtraSignedInfo *obj);
 int Noise_ExtraSignedInfo_read(NoiseProtobuf *pbuf, int tag, Noise_ExtraSignedInfo **obj);
+size_t Noise_ExtraSignedInfo_measure(int tag, const Noise_ExtraSignedInfo *obj);
+int Noise_ExtraSignedInfo_encode(NoiseProtobuf *pbuf, int tag, const Noise_ExtraSignedInfo *obj);
 int Noise_ExtraSignedInfo_clear_nonce(Noise_ExtraSignedInfo *obj);
 int Noise_ExtraSignedInfo_has_nonce(const Noise_ExtraSignedInfo *obj);
 const void *Noise_ExtraSignedInfo_get_nonce(const Noise_ExtraSignedInfo *obj);
@@ -195,6 +209,8 @@ int Noise_EncryptedPrivateKey_new(Noise_EncryptedPrivateKey **obj);
 int Noise_EncryptedPrivateKey_free(Noise_EncryptedPrivateKey *obj);
 int Noise_EncryptedPrivateKey_write(NoiseProtobuf *pbuf, int tag, const Noise_EncryptedPrivateKey *obj);
 int Noise_EncryptedPrivateKey_read(NoiseProtobuf *pbuf, int tag, Noise_EncryptedPrivateKey **obj);
+size_t Noise_EncryptedPrivateKey_measure(int tag, const Noise_EncryptedPrivateKey *obj);
+int Noise_EncryptedPrivateKey_encode(NoiseProtobuf *pbuf, int tag, const Noise_EncryptedPrivateKey *obj);
 int Noise_EncryptedPrivateKey_clear_version(Noise_EncryptedPrivateKey *obj);
 int Noise_EncryptedPrivateKey_has_version(const Noise_EncryptedPrivateKey *obj);
 uint32_t Noise_EncryptedPrivateKey_get_version(const Noise_EncryptedPrivateKey *obj);
@@ -223,6 +239,8 @@ int Noise_PrivateKey_new(Noise_PrivateKey **obj);
 int Noise_PrivateKey_free(Noise_PrivateKey *obj);
 int Noise_PrivateKey_write(NoiseProtobuf *pbuf, int tag, const Noise_PrivateKey *obj);
 int Noise_PrivateKey_read(NoiseProtobuf *pbuf, int tag, Noise_PrivateKey **obj);
+size_t Noise_PrivateKey_measure(int tag, const Noise_PrivateKey *obj);
+int Noise_PrivateKey_encode(NoiseProtobuf *pbuf, int tag, const Noise_PrivateKey *obj);
 int Noise_PrivateKey_clear_id(Noise_PrivateKey *obj);
 int Noise_PrivateKey_has_id(const Noise_PrivateKey *obj);
 const char *Noise_PrivateKey_get_id(const Noise_PrivateKey *obj);
@@ -255,6 +273,8 @@ int Noise_PrivateKeyInfo_new(Noise_PrivateKeyInfo **obj);
 int Noise_PrivateKeyInfo_free(Noise_PrivateKeyInfo *obj);
 int Noise_PrivateKeyInfo_write(NoiseProtobuf *pbuf, int tag, const Noise_PrivateKeyInfo *obj);
 int Noise_PrivateKeyInfo_read(NoiseProtobuf *pbuf, int tag, Noise_PrivateKeyInfo **obj);
+size_t Noise_PrivateKeyInfo_measure(int tag, const Noise_PrivateKeyInfo *obj);
+int Noise_PrivateKeyInfo_encode(NoiseProtobuf *pbuf, int tag, const Noise_PrivateKeyInfo *obj);
 int Noise_PrivateKeyInfo_clear_algorithm(Noise_PrivateKeyInfo *obj);
 int Noise_PrivateKeyInfo_has_algorithm(const Noise_PrivateKeyInfo *obj);
 const char *Noise_PrivateKeyInfo_get_algorithm(const Noise_PrivateKeyInfo *obj);
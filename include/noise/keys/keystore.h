@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef NOISE_KEYS_KEYSTORE_H
+#define NOISE_KEYS_KEYSTORE_H
+
+#include <noise/protocol.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct NoiseKeyStore_s NoiseKeyStore;
+typedef struct NoiseKeyStoreSlot_s NoiseKeyStoreSlot;
+typedef struct NoiseKeyStoreBuilder_s NoiseKeyStoreBuilder;
+
+typedef struct
+{
+    const uint8_t *psk;         /**< Pre-shared key, or NULL if none */
+    size_t psk_len;             /**< Length of the pre-shared key */
+    const uint8_t *metadata;    /**< Application-defined metadata */
+    size_t metadata_len;        /**< Length of the metadata */
+
+} NoiseKeyStoreEntry;
+
+int noise_keystore_open(NoiseKeyStore **store, const char *filename);
+int noise_keystore_ref(NoiseKeyStore *store);
+int noise_keystore_close(NoiseKeyStore *store);
+size_t noise_keystore_get_count(const NoiseKeyStore *store);
+size_t noise_keystore_get_key_length(const NoiseKeyStore *store);
+int noise_keystore_lookup
+    (const NoiseKeyStore *store, const uint8_t *key, size_t key_len,
+     NoiseKeyStoreEntry *entry);
+int noise_keystore_lookup_dhstate
+    (const NoiseKeyStore *store, const NoiseDHState *dh,
+     NoiseKeyStoreEntry *entry);
+
+int noise_keystore_slot_new(NoiseKeyStoreSlot **slot);
+int noise_keystore_slot_free(NoiseKeyStoreSlot *slot);
+int noise_keystore_slot_set(NoiseKeyStoreSlot *slot, NoiseKeyStore *store);
+NoiseKeyStore *noise_keystore_slot_acquire(NoiseKeyStoreSlot *slot);
+
+int noise_keystore_builder_new
+    (NoiseKeyStoreBuilder **builder, size_t key_len, size_t psk_len);
+int noise_keystore_builder_free(NoiseKeyStoreBuilder *builder);
+int noise_keystore_builder_add
+    (NoiseKeyStoreBuilder *builder, const uint8_t *key, size_t key_len,
+     const uint8_t *psk, size_t psk_len,
+     const void *metadata, size_t metadata_len);
+int noise_keystore_builder_save
+    (NoiseKeyStoreBuilder *builder, const char *filename);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
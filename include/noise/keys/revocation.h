@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef NOISE_KEYS_REVOCATION_H
+#define NOISE_KEYS_REVOCATION_H
+
+#include <noise/protocol.h>
+#include <noise/keys/certificate.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NOISE_REVOCATION_FINGERPRINT_LEN 32
+
+typedef struct NoiseRevocationSet_s NoiseRevocationSet;
+typedef struct NoiseRevocationBuilder_s NoiseRevocationBuilder;
+
+int noise_revocation_open(NoiseRevocationSet **set, const char *filename);
+int noise_revocation_ref(NoiseRevocationSet *set);
+int noise_revocation_close(NoiseRevocationSet *set);
+size_t noise_revocation_get_count(const NoiseRevocationSet *set);
+int noise_revocation_check_fingerprint
+    (const NoiseRevocationSet *set, const uint8_t *fingerprint,
+     size_t fingerprint_len);
+int noise_revocation_check_key
+    (const NoiseRevocationSet *set, const uint8_t *key, size_t key_len);
+int noise_revocation_check_dhstate
+    (const NoiseRevocationSet *set, const NoiseDHState *dh);
+int noise_revocation_check_certificate
+    (const NoiseRevocationSet *set, const Noise_Certificate *cert);
+int noise_revocation_check_chain
+    (const NoiseRevocationSet *set, const Noise_CertificateChain *chain);
+int noise_revocation_attach
+    (NoiseRevocationSet *set, NoiseHandshakeState *state);
+
+int noise_revocation_builder_new(NoiseRevocationBuilder **builder);
+int noise_revocation_builder_free(NoiseRevocationBuilder *builder);
+int noise_revocation_builder_add_fingerprint
+    (NoiseRevocationBuilder *builder, const uint8_t *fingerprint,
+     size_t fingerprint_len);
+int noise_revocation_builder_add_key
+    (NoiseRevocationBuilder *builder, const uint8_t *key, size_t key_len);
+int noise_revocation_builder_save
+    (NoiseRevocationBuilder *builder, const char *filename);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
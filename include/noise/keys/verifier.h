@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef NOISE_KEYS_VERIFIER_H
+#define NOISE_KEYS_VERIFIER_H
+
+#include <noise/keys/certificate.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct NoiseCertVerifier_s NoiseCertVerifier;
+
+int noise_certificate_compute_signed_hash
+    (const Noise_Certificate *cert, const Noise_Signature *sig,
+     uint8_t *hash, size_t max_len, size_t *hash_len);
+
+int noise_cert_verifier_new(NoiseCertVerifier **verifier, size_t cache_size);
+int noise_cert_verifier_free(NoiseCertVerifier *verifier);
+int noise_cert_verifier_add_trust_anchor
+    (NoiseCertVerifier *verifier, const Noise_PublicKeyInfo *key);
+int noise_cert_verifier_add_trusted_certificate
+    (NoiseCertVerifier *verifier, const Noise_Certificate *cert);
+int noise_cert_verifier_verify_certificate
+    (NoiseCertVerifier *verifier, const Noise_Certificate *cert);
+int noise_cert_verifier_verify_chain
+    (NoiseCertVerifier *verifier, const Noise_CertificateChain *chain);
+int noise_cert_verifier_clear_cache(NoiseCertVerifier *verifier);
+int noise_cert_verifier_get_cache_stats
+    (const NoiseCertVerifier *verifier, size_t *hits, size_t *misses);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
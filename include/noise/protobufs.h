@@ -31,20 +31,85 @@
 extern "C" {
 #endif
 
+typedef struct
+{
+    uint8_t *data;
+    size_t size;
+    size_t posn;
+
+} NoiseProtobufArena;
+
 typedef struct
 {
     uint8_t *data;
     size_t size;
     size_t posn;
     int error;
+    NoiseProtobufArena *arena;
 
 } NoiseProtobuf;
 
+#define NOISE_PROTOBUF_TYPE_INT32       1
+#define NOISE_PROTOBUF_TYPE_UINT32      2
+#define NOISE_PROTOBUF_TYPE_INT64       3
+#define NOISE_PROTOBUF_TYPE_UINT64      4
+#define NOISE_PROTOBUF_TYPE_SINT32      5
+#define NOISE_PROTOBUF_TYPE_SINT64      6
+#define NOISE_PROTOBUF_TYPE_FIXED32     7
+#define NOISE_PROTOBUF_TYPE_SFIXED32    8
+#define NOISE_PROTOBUF_TYPE_FIXED64     9
+#define NOISE_PROTOBUF_TYPE_SFIXED64    10
+#define NOISE_PROTOBUF_TYPE_FLOAT       11
+#define NOISE_PROTOBUF_TYPE_DOUBLE      12
+#define NOISE_PROTOBUF_TYPE_BOOL        13
+#define NOISE_PROTOBUF_TYPE_STRING      14
+#define NOISE_PROTOBUF_TYPE_BYTES       15
+#define NOISE_PROTOBUF_TYPE_MESSAGE     16
+
+#define NOISE_PROTOBUF_QUAL_OPTIONAL    0
+#define NOISE_PROTOBUF_QUAL_REQUIRED    1
+#define NOISE_PROTOBUF_QUAL_REPEATED    2
+#define NOISE_PROTOBUF_QUAL_PACKED      3
+
+typedef struct _NoiseProtobufMessageDesc NoiseProtobufMessageDesc;
+
+typedef struct
+{
+    uint32_t tag;
+    uint8_t type;
+    uint8_t qualifier;
+    uint16_t offset;
+    uint16_t size_offset;
+    uint16_t count_offset;
+    uint16_t max_offset;
+    const NoiseProtobufMessageDesc *message;
+
+} NoiseProtobufFieldDesc;
+
+struct _NoiseProtobufMessageDesc
+{
+    size_t struct_size;
+    uint16_t cache_offset;
+    uint16_t num_fields;
+    const NoiseProtobufFieldDesc *fields;
+
+};
+
+int noise_protobuf_arena_init
+    (NoiseProtobufArena *arena, void *data, size_t size);
+void noise_protobuf_arena_reset(NoiseProtobufArena *arena);
+void *noise_protobuf_arena_alloc(NoiseProtobufArena *arena, size_t size);
+
 int noise_protobuf_prepare_input
     (NoiseProtobuf *pbuf, const uint8_t *data, size_t size);
+int noise_protobuf_prepare_input_arena
+    (NoiseProtobuf *pbuf, const uint8_t *data, size_t size,
+     NoiseProtobufArena *arena);
 int noise_protobuf_prepare_output
     (NoiseProtobuf *pbuf, uint8_t *data, size_t size);
 int noise_protobuf_prepare_measure(NoiseProtobuf *pbuf, size_t max_size);
+int noise_protobuf_prepare_encode
+    (NoiseProtobuf *pbuf, uint8_t *data, size_t size);
 
 int noise_protobuf_finish_input(NoiseProtobuf *pbuf);
 int noise_protobuf_finish_output
@@ -52,6 +117,7 @@ int noise_protobuf_finish_output
 int noise_protobuf_finish_output_shift
     (NoiseProtobuf *pbuf, uint8_t **data, size_t *size);
 int noise_protobuf_finish_measure(NoiseProtobuf *pbuf, size_t *size);
+int noise_protobuf_finish_encode(NoiseProtobuf *pbuf, size_t *size);
 
 int noise_protobuf_write_int32(NoiseProtobuf *pbuf, int tag, int32_t value);
 int noise_protobuf_write_uint32(NoiseProtobuf *pbuf, int tag, uint32_t value);
@@ -74,6 +140,57 @@ int noise_protobuf_write_end_element(NoiseProtobuf *pbuf, size_t *end_posn);
 int noise_protobuf_write_start_element
     (NoiseProtobuf *pbuf, int tag, size_t end_posn);
 
+size_t noise_protobuf_size_int32(int tag, int32_t value);
+size_t noise_protobuf_size_uint32(int tag, uint32_t value);
+size_t noise_protobuf_size_int64(int tag, int64_t value);
+size_t noise_protobuf_size_uint64(int tag, uint64_t value);
+size_t noise_protobuf_size_sint32(int tag, int32_t value);
+size_t noise_protobuf_size_sint64(int tag, int64_t value);
+size_t noise_protobuf_size_sfixed32(int tag, int32_t value);
+size_t noise_protobuf_size_fixed32(int tag, uint32_t value);
+size_t noise_protobuf_size_sfixed64(int tag, int64_t value);
+size_t noise_protobuf_size_fixed64(int tag, uint64_t value);
+size_t noise_protobuf_size_float(int tag, float value);
+size_t noise_protobuf_size_double(int tag, double value);
+size_t noise_protobuf_size_bool(int tag, int value);
+size_t noise_protobuf_size_string(int tag, size_t size);
+size_t noise_protobuf_size_bytes(int tag, size_t size);
+size_t noise_protobuf_size_element(int tag, size_t size);
+
+int noise_protobuf_encode_int32(NoiseProtobuf *pbuf, int tag, int32_t value);
+int noise_protobuf_encode_uint32(NoiseProtobuf *pbuf, int tag, uint32_t value);
+int noise_protobuf_encode_int64(NoiseProtobuf *pbuf, int tag, int64_t value);
+int noise_protobuf_encode_uint64(NoiseProtobuf *pbuf, int tag, uint64_t value);
+int noise_protobuf_encode_sint32(NoiseProtobuf *pbuf, int tag, int32_t value);
+int noise_protobuf_encode_sint64(NoiseProtobuf *pbuf, int tag, int64_t value);
+int noise_protobuf_encode_sfixed32(NoiseProtobuf *pbuf, int tag, int32_t value);
+int noise_protobuf_encode_fixed32(NoiseProtobuf *pbuf, int tag, uint32_t value);
+int noise_protobuf_encode_sfixed64(NoiseProtobuf *pbuf, int tag, int64_t value);
+int noise_protobuf_encode_fixed64(NoiseProtobuf *pbuf, int tag, uint64_t value);
+int noise_protobuf_encode_float(NoiseProtobuf *pbuf, int tag, float value);
+int noise_protobuf_encode_double(NoiseProtobuf *pbuf, int tag, double value);
+int noise_protobuf_encode_bool(NoiseProtobuf *pbuf, int tag, int value);
+int noise_protobuf_encode_string
+    (NoiseProtobuf *pbuf, int tag, const char *str, size_t size);
+int noise_protobuf_encode_bytes
+    (NoiseProtobuf *pbuf, int tag, const void *data, size_t size);
+int noise_protobuf_encode_start_element
+    (NoiseProtobuf *pbuf, int tag, size_t size);
+
+/* The measure functions cache the size of each message body inside the
+   object, which is passed to them as const.  The cache is accessed with
+   relaxed atomics so that a stray concurrent access is not undefined */
+#if defined(__ATOMIC_RELAXED)
+#define noise_protobuf_store_size_cache(cache, size) \
+    __atomic_store_n((size_t *)(cache), (size), __ATOMIC_RELAXED)
+#define noise_protobuf_load_size_cache(cache) \
+    __atomic_load_n((cache), __ATOMIC_RELAXED)
+#else
+#define noise_protobuf_store_size_cache(cache, size) \
+    (*((size_t *)(cache)) = (size))
+#define noise_protobuf_load_size_cache(cache) (*(cache))
+#endif
+
 int noise_protobuf_peek_tag(const NoiseProtobuf *pbuf);
 size_t noise_protobuf_peek_size(const NoiseProtobuf *pbuf);
 int noise_protobuf_read_int32(NoiseProtobuf *pbuf, int tag, int32_t *value);
@@ -114,12 +231,45 @@ int noise_protobuf_add_to_bytes_array
     (void ***array, size_t **len_array, size_t *count, size_t *max,
      const void *value, size_t size);
 
+void *noise_protobuf_new_object(NoiseProtobuf *pbuf, size_t size);
+int noise_protobuf_read_add_to_array
+    (NoiseProtobuf *pbuf, void **array, size_t *count, size_t *max,
+     const void *value, size_t size);
+int noise_protobuf_read_add_to_block_array
+    (NoiseProtobuf *pbuf, void ***array, size_t **len_array,
+     size_t *count, size_t *max, void *value, size_t size);
+
 int noise_protobuf_insert_into_array
     (void **array, size_t *count, size_t *max, size_t index,
      const void *value, size_t size);
 
 void noise_protobuf_free_memory(void *ptr, size_t size);
 
+int noise_protobuf_table_new
+    (const NoiseProtobufMessageDesc *desc, void **obj);
+int noise_protobuf_table_free
+    (const NoiseProtobufMessageDesc *desc, void *obj);
+int noise_protobuf_table_write
+    (NoiseProtobuf *pbuf, int tag, const NoiseProtobufMessageDesc *desc,
+     const void *obj);
+int noise_protobuf_table_read
+    (NoiseProtobuf *pbuf, int tag, const NoiseProtobufMessageDesc *desc,
+     void **obj);
+size_t noise_protobuf_table_measure
+    (int tag, const NoiseProtobufMessageDesc *desc, const void *obj);
+int noise_protobuf_table_encode
+    (NoiseProtobuf *pbuf, int tag, const NoiseProtobufMessageDesc *desc,
+     const void *obj);
+int noise_protobuf_table_clear_field
+    (const NoiseProtobufFieldDesc *field, void *obj);
+int noise_protobuf_table_set_field
+    (const NoiseProtobufFieldDesc *field, void *obj,
+     const void *value, size_t size);
+int noise_protobuf_table_get_new_field
+    (const NoiseProtobufFieldDesc *field, void *obj, void **value);
+int noise_protobuf_table_add_field
+    (const NoiseProtobufFieldDesc *field, void *obj, void **value);
+
 #ifdef __cplusplus
 };
 #endif
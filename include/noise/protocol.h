@@ -27,13 +27,18 @@
 #include <noise/protocol/errors.h>
 #include <noise/protocol/names.h>
 #include <noise/protocol/buffer.h>
+#include <noise/protocol/backend.h>
 #include <noise/protocol/cipherstate.h>
+#include <noise/protocol/compactsession.h>
+#include <noise/protocol/cookie.h>
 #include <noise/protocol/hashstate.h>
 #include <noise/protocol/dhstate.h>
 #include <noise/protocol/signstate.h>
 #include <noise/protocol/randstate.h>
+#include <noise/protocol/secmem.h>
 #include <noise/protocol/symmetricstate.h>
 #include <noise/protocol/handshakestate.h>
+#include <noise/protocol/ticket.h>
 #include <noise/protocol/util.h>
 
 #endif
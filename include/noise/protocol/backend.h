@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef NOISE_BACKEND_H
+#define NOISE_BACKEND_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* CPU features that alternative backends may depend upon */
+#define NOISE_CPU_SSE2      (1 << 0)
+#define NOISE_CPU_SSSE3     (1 << 1)
+#define NOISE_CPU_SSE41     (1 << 2)
+#define NOISE_CPU_AVX       (1 << 3)
+#define NOISE_CPU_AVX2      (1 << 4)
+#define NOISE_CPU_AESNI     (1 << 5)
+#define NOISE_CPU_PCLMUL    (1 << 6)
+#define NOISE_CPU_SHANI     (1 << 7)
+
+int noise_backend_get_cpu_features(void);
+int noise_backend_get_count(int id);
+const char *noise_backend_get_name(int id, int index);
+int noise_backend_is_supported(int id, int index);
+const char *noise_backend_get_active(int id);
+int noise_backend_select(int id, const char *name);
+int noise_backend_self_check(int id);
+void noise_backend_set_self_check(int enable);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
@@ -51,6 +51,12 @@ int noise_cipherstate_decrypt(NoiseCipherState *state, NoiseBuffer *buffer);
 int noise_cipherstate_derive
     (NoiseCipherState *state, uint8_t *data, size_t len);
 int noise_cipherstate_set_nonce(NoiseCipherState *state, uint64_t nonce);
+int noise_cipherstate_export
+    (const NoiseCipherState *state, const uint8_t *wrap_key,
+     size_t wrap_key_len, NoiseBuffer *blob);
+int noise_cipherstate_import
+    (NoiseCipherState **state, const uint8_t *wrap_key,
+     size_t wrap_key_len, const NoiseBuffer *blob);
 int noise_cipherstate_get_max_key_length(void);
 int noise_cipherstate_get_max_mac_length(void);
 
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef NOISE_COMPACTSESSION_H
+#define NOISE_COMPACTSESSION_H
+
+#include <noise/protocol/cipherstate.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct NoiseCompactSession_s NoiseCompactSession;
+
+int noise_compactsession_new
+    (NoiseCompactSession **session, int cipher_id,
+     const uint8_t *send_key, const uint8_t *receive_key, size_t key_len);
+int noise_compactsession_free(NoiseCompactSession *session);
+int noise_compactsession_get_cipher_id(const NoiseCompactSession *session);
+size_t noise_compactsession_get_size(void);
+int noise_compactsession_encrypt_with_ad
+    (NoiseCompactSession *session, NoiseCipherState *cipher,
+     const uint8_t *ad, size_t ad_len, NoiseBuffer *buffer);
+int noise_compactsession_decrypt_with_ad
+    (NoiseCompactSession *session, NoiseCipherState *cipher,
+     const uint8_t *ad, size_t ad_len, NoiseBuffer *buffer);
+int noise_compactsession_encrypt
+    (NoiseCompactSession *session, NoiseCipherState *cipher,
+     NoiseBuffer *buffer);
+int noise_compactsession_decrypt
+    (NoiseCompactSession *session, NoiseCipherState *cipher,
+     NoiseBuffer *buffer);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
@@ -51,6 +51,7 @@ extern "C" {
 #define NOISE_DH_CURVE25519             NOISE_ID('D', 1)
 #define NOISE_DH_CURVE448               NOISE_ID('D', 2)
 #define NOISE_DH_NEWHOPE                NOISE_ID('D', 3)
+#define NOISE_DH_MLKEM768               NOISE_ID('D', 4)
 
 /* Handshake patterns */
 #define NOISE_PATTERN_NONE              0
@@ -128,6 +129,10 @@ extern "C" {
 #define NOISE_ERROR_INVALID_PUBLIC_KEY  NOISE_ID('E', 15)
 #define NOISE_ERROR_INVALID_FORMAT      NOISE_ID('E', 16)
 #define NOISE_ERROR_INVALID_SIGNATURE   NOISE_ID('E', 17)
+#define NOISE_ERROR_SELF_CHECK_FAILED   NOISE_ID('E', 18)
+#define NOISE_ERROR_KEY_REVOKED         NOISE_ID('E', 19)
+#define NOISE_ERROR_TICKET_EXPIRED      NOISE_ID('E', 20)
+#define NOISE_ERROR_COOKIE_REQUIRED     NOISE_ID('E', 21)
 
 /* Maximum length of a packet payload */
 #define NOISE_MAX_PAYLOAD_LEN           65535
@@ -138,6 +143,24 @@ extern "C" {
 /* Recommended maximum length for fingerprint buffers */
 #define NOISE_MAX_FINGERPRINT_LEN       256
 
+/* Length of the key that wraps exported CipherState, SymmetricState,
+   and HandshakeState objects */
+#define NOISE_EXPORT_KEY_LEN            32
+
+/* Length of a resumption secret and the maximum length of a
+   resumption ticket */
+#define NOISE_RESUMPTION_SECRET_LEN     32
+#define NOISE_MAX_TICKET_LEN            128
+
+/* Number of bytes that the cookie layer appends to the first handshake
+   message, and the maximum length of a cookie reply */
+#define NOISE_COOKIE_MACS_LEN           32
+#define NOISE_MAX_COOKIE_REPLY_LEN      64
+
+/* Maximum length of an exported CipherState, SymmetricState, or
+   HandshakeState object */
+#define NOISE_MAX_EXPORT_LEN            1024
+
 #ifdef __cplusplus
 };
 #endif
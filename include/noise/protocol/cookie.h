@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef NOISE_COOKIE_H
+#define NOISE_COOKIE_H
+
+#include <noise/protocol/buffer.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct NoiseCookieChecker_s NoiseCookieChecker;
+typedef struct NoiseCookieMaker_s NoiseCookieMaker;
+
+int noise_cookiechecker_new
+    (NoiseCookieChecker **checker, const uint8_t *public_key,
+     size_t public_key_len);
+int noise_cookiechecker_free(NoiseCookieChecker *checker);
+int noise_cookiechecker_set_threshold
+    (NoiseCookieChecker *checker, size_t threshold);
+int noise_cookiechecker_tick(NoiseCookieChecker *checker);
+int noise_cookiechecker_rotate(NoiseCookieChecker *checker);
+int noise_cookiechecker_is_under_load(const NoiseCookieChecker *checker);
+int noise_cookiechecker_check
+    (NoiseCookieChecker *checker, const uint8_t *source, size_t source_len,
+     NoiseBuffer *message);
+int noise_cookiechecker_make_reply
+    (NoiseCookieChecker *checker, const uint8_t *source, size_t source_len,
+     const NoiseBuffer *message, NoiseBuffer *reply);
+
+int noise_cookiemaker_new
+    (NoiseCookieMaker **maker, const uint8_t *public_key,
+     size_t public_key_len);
+int noise_cookiemaker_free(NoiseCookieMaker *maker);
+int noise_cookiemaker_add_macs(NoiseCookieMaker *maker, NoiseBuffer *message);
+int noise_cookiemaker_consume_reply
+    (NoiseCookieMaker *maker, const NoiseBuffer *reply);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
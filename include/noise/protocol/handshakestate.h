@@ -25,6 +25,7 @@
 
 #include <noise/protocol/symmetricstate.h>
 #include <noise/protocol/dhstate.h>
+#include <noise/protocol/compactsession.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -32,6 +33,9 @@ extern "C" {
 
 typedef struct NoiseHandshakeState_s NoiseHandshakeState;
 
+typedef int (*NoiseRemoteStaticCheckFunc)
+    (void *user_data, const NoiseDHState *dh);
+
 int noise_handshakestate_new_by_id
     (NoiseHandshakeState **state, const NoiseProtocolId *protocol_id, int role);
 int noise_handshakestate_new_by_name
@@ -46,12 +50,17 @@ NoiseDHState *noise_handshakestate_get_remote_public_key_dh
     (const NoiseHandshakeState *state);
 NoiseDHState *noise_handshakestate_get_fixed_ephemeral_dh
     (NoiseHandshakeState *state);
+NoiseDHState *noise_handshakestate_get_fixed_hybrid_ephemeral_dh
+    (NoiseHandshakeState *state);
 int noise_handshakestate_needs_pre_shared_key(const NoiseHandshakeState *state);
 int noise_handshakestate_has_pre_shared_key(const NoiseHandshakeState *state);
 int noise_handshakestate_set_pre_shared_key
     (NoiseHandshakeState *state, const uint8_t *key, size_t key_len);
 int noise_handshakestate_set_prologue
     (NoiseHandshakeState *state, const void *prologue, size_t prologue_len);
+int noise_handshakestate_set_remote_static_check
+    (NoiseHandshakeState *state, NoiseRemoteStaticCheckFunc check,
+     void *user_data);
 int noise_handshakestate_needs_local_keypair(const NoiseHandshakeState *state);
 int noise_handshakestate_has_local_keypair(const NoiseHandshakeState *state);
 int noise_handshakestate_needs_remote_public_key(const NoiseHandshakeState *state);
@@ -69,8 +78,21 @@ int noise_handshakestate_split
 int noise_handshakestate_split_with_key
     (NoiseHandshakeState *state, NoiseCipherState **send, NoiseCipherState **receive,
      const uint8_t *secondary_key, size_t secondary_key_len);
+int noise_handshakestate_split_multi
+    (NoiseHandshakeState **states, NoiseCipherState **send,
+     NoiseCipherState **receive, size_t count);
+int noise_handshakestate_split_compact
+    (NoiseHandshakeState *state, NoiseCompactSession **session);
 int noise_handshakestate_get_handshake_hash
     (const NoiseHandshakeState *state, uint8_t *hash, size_t max_len);
+int noise_handshakestate_get_resumption_secret
+    (const NoiseHandshakeState *state, uint8_t *secret, size_t secret_len);
+int noise_handshakestate_export
+    (const NoiseHandshakeState *state, const uint8_t *wrap_key,
+     size_t wrap_key_len, NoiseBuffer *blob);
+int noise_handshakestate_import
+    (NoiseHandshakeState **state, const uint8_t *wrap_key,
+     size_t wrap_key_len, const NoiseBuffer *blob);
 
 #ifdef __cplusplus
 };
@@ -54,6 +54,16 @@ int noise_hashstate_hkdf
      const uint8_t *data, size_t data_len,
      uint8_t *output1, size_t output1_len,
      uint8_t *output2, size_t output2_len);
+int noise_hashstate_update_multi
+    (NoiseHashState **states, const uint8_t **data, size_t data_len,
+     size_t count);
+int noise_hashstate_finalize_multi
+    (NoiseHashState **states, uint8_t **hashes, size_t hash_len, size_t count);
+int noise_hashstate_hkdf_multi
+    (NoiseHashState **states, const uint8_t **keys, size_t key_len,
+     const uint8_t **data, size_t data_len,
+     uint8_t **output1, size_t output1_len,
+     uint8_t **output2, size_t output2_len, size_t count);
 int noise_hashstate_pbkdf2
     (NoiseHashState *state, const uint8_t *passphrase, size_t passphrase_len,
      const uint8_t *salt, size_t salt_len, size_t iterations,
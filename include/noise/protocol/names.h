@@ -37,7 +37,7 @@ typedef struct
     int dh_id;          /**< Diffie-Hellman algorithm identifier */
     int cipher_id;      /**< Cipher algorithm identifier */
     int hash_id;        /**< Hash algorithm identifier */
-    int reserved_id;    /**< Reserved for future use, must be zero */
+    int hybrid_id;      /**< Hybrid ephemeral DH identifier, or zero */
 
 } NoiseProtocolId;
 
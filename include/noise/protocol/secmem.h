@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef NOISE_SECMEM_H
+#define NOISE_SECMEM_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Flags for noise_secmem_init() */
+#define NOISE_SECMEM_LOCK       (1 << 0)
+#define NOISE_SECMEM_GUARD      (1 << 1)
+#define NOISE_SECMEM_NO_DUMP    (1 << 2)
+#define NOISE_SECMEM_DEFAULT    \
+    (NOISE_SECMEM_LOCK | NOISE_SECMEM_GUARD | NOISE_SECMEM_NO_DUMP)
+
+/**
+ * \brief Statistics about the secure memory allocator.
+ */
+typedef struct
+{
+    size_t reserved_bytes;  /**< Size of the reserved address range */
+    size_t slab_bytes;      /**< Bytes that have been carved into slabs */
+    size_t locked_bytes;    /**< Bytes of slab memory locked into RAM */
+    size_t lock_failures;   /**< Number of slabs that could not be locked */
+    size_t fallbacks;       /**< Allocations sent to the heap when full */
+    int flags;              /**< Flags that were passed to the allocator */
+
+} NoiseSecMemStats;
+
+int noise_secmem_init(size_t max_size, int flags);
+void noise_secmem_disable(void);
+int noise_secmem_is_enabled(void);
+int noise_secmem_get_stats(NoiseSecMemStats *stats);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
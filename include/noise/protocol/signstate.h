@@ -61,6 +61,10 @@ int noise_signstate_sign
 int noise_signstate_verify
     (const NoiseSignState *state, const uint8_t *message, size_t message_len,
      const uint8_t *signature, size_t signature_len);
+int noise_signstate_verify_batch
+    (const NoiseSignState **states, const uint8_t **messages,
+     const size_t *message_lens, const uint8_t **signatures,
+     size_t signature_len, size_t count, int *valid);
 int noise_signstate_copy(NoiseSignState *state, const NoiseSignState *from);
 int noise_signstate_format_fingerprint
     (const NoiseSignState *state, int fingerprint_type,
@@ -51,6 +51,12 @@ size_t noise_symmetricstate_get_mac_length(const NoiseSymmetricState *state);
 int noise_symmetricstate_split
     (NoiseSymmetricState *state, NoiseCipherState **c1, NoiseCipherState **c2,
      const uint8_t *secondary_key, size_t secondary_key_len);
+int noise_symmetricstate_export
+    (const NoiseSymmetricState *state, const uint8_t *wrap_key,
+     size_t wrap_key_len, NoiseBuffer *blob);
+int noise_symmetricstate_import
+    (NoiseSymmetricState **state, const uint8_t *wrap_key,
+     size_t wrap_key_len, const NoiseBuffer *blob);
 
 #ifdef __cplusplus
 };
@@ -22,30 +22,54 @@
 
 #include "internal.h"
 #include "crypto/aes/rijndael-alg-fst.h"
+#include "crypto/aes/aes-bitsliced.h"
 #include "crypto/ghash/ghash.h"
 #include <string.h>
+#include <stddef.h>
+
+/* Number of keystream blocks that the bitsliced engine produces along
+   with the hash nonce when the IV is set up.  The bitsliced engine
+   encrypts a batch of counters in one pass, so the extra blocks come
+   almost for free and short messages only need a single pass */
+#define NOISE_AESGCM_EARLY_BLOCKS (AES_BITSLICED_CTR_BLOCKS - 1)
 
 typedef struct
 {
     struct NoiseCipherState_s parent;
-    uint32_t aes[4 * (MAXNR + 1)];
     ghash_state ghash;
     uint8_t counter[16];
     uint8_t hash[16];
+    int bitsliced;
+    union {
+        uint32_t ref[4 * (MAXNR + 1)];
+        struct {
+            aes_bitsliced_state aes;
+            uint8_t keystream[NOISE_AESGCM_EARLY_BLOCKS * 16];
+        } bitsliced;
+    } aes;
 
 } NoiseAESGCMState;
 
+/* Only allocate the part of the key schedule union that is used */
+#define NOISE_AESGCM_REF_SIZE \
+    (offsetof(NoiseAESGCMState, aes) + sizeof(uint32_t) * 4 * (MAXNR + 1))
+
 static void noise_aesgcm_init_key
     (NoiseCipherState *state, const uint8_t *key)
 {
     NoiseAESGCMState *st = (NoiseAESGCMState *)state;
 
-    /* Set the encryption key */
-    rijndaelKeySetupEnc(st->aes, key, 256);
-
-    /* Construct the hashing key by encrypting a block of zeroes */
+    /* Set the encryption key and construct the hashing key by
+       encrypting a block of zeroes */
     memset(st->counter, 0, 16);
-    rijndaelEncrypt(st->aes, MAXNR, st->counter, st->hash);
+    if (st->bitsliced) {
+        aes_bitsliced_setup_key(&(st->aes.bitsliced.aes), key, 32);
+        aes_bitsliced_encrypt
+            (&(st->aes.bitsliced.aes), st->counter, st->hash, 1);
+    } else {
+        rijndaelKeySetupEnc(st->aes.ref, key, 256);
+        rijndaelEncrypt(st->aes.ref, MAXNR, st->counter, st->hash);
+    }
     ghash_reset(&(st->ghash), st->hash);
 }
 
@@ -82,13 +106,70 @@ static void noise_aesgcm_setup_iv(NoiseAESGCMState *st)
     st->counter[14] = 0;
     st->counter[15] = 1;
 
-    /* Encrypt the counter to create the value to XOR with the hash later */
-    rijndaelEncrypt(st->aes, MAXNR, st->counter, st->hash);
+    /* Encrypt the counter to create the value to XOR with the hash later.
+       The bitsliced engine also encrypts the first few data counters */
+    if (st->bitsliced) {
+        uint8_t blocks[(NOISE_AESGCM_EARLY_BLOCKS + 1) * 16];
+        aes_bitsliced_ctr(&(st->aes.bitsliced.aes), st->counter, 1,
+                          blocks, NOISE_AESGCM_EARLY_BLOCKS + 1);
+        memcpy(st->hash, blocks, 16);
+        memcpy(st->aes.bitsliced.keystream, blocks + 16,
+               NOISE_AESGCM_EARLY_BLOCKS * 16);
+        noise_clean(blocks, sizeof(blocks));
+    } else {
+        rijndaelEncrypt(st->aes.ref, MAXNR, st->counter, st->hash);
+    }
 
     /* Reset the GHASH state, but keep the same key as before */
     ghash_reset(&(st->ghash), 0);
 }
 
+/**
+ * \brief Encrypts or decrypts a block with the bitsliced AES engine.
+ *
+ * \param st The cipher state for AESGCM.
+ * \param data The data to be encrypted or decrypted.
+ * \param len The length of the data to be encrypted or decrypted in bytes.
+ *
+ * The first blocks use the keystream that was generated along with the
+ * hash nonce.  After that, keystream is generated 8 blocks at a time.
+ */
+static void noise_aesgcm_bitsliced_crypt
+    (NoiseAESGCMState *st, uint8_t *data, size_t len)
+{
+    uint8_t keystream[AES_BITSLICED_CTR_BLOCKS * 16];
+    uint32_t counter = NOISE_AESGCM_EARLY_BLOCKS + 2;
+    size_t temp, index;
+
+    /* Use up the keystream from noise_aesgcm_setup_iv() */
+    temp = NOISE_AESGCM_EARLY_BLOCKS * 16;
+    if (temp > len)
+        temp = len;
+    for (index = 0; index < temp; ++index)
+        data[index] ^= st->aes.bitsliced.keystream[index];
+    noise_clean(st->aes.bitsliced.keystream, NOISE_AESGCM_EARLY_BLOCKS * 16);
+    data += temp;
+    len -= temp;
+
+    /* Generate the rest of the keystream in batches */
+    while (len > 0) {
+        size_t blocks = (len + 15) / 16;
+        if (blocks > AES_BITSLICED_CTR_BLOCKS)
+            blocks = AES_BITSLICED_CTR_BLOCKS;
+        aes_bitsliced_ctr(&(st->aes.bitsliced.aes), st->counter, counter,
+                          keystream, blocks);
+        temp = blocks * 16;
+        if (temp > len)
+            temp = len;
+        for (index = 0; index < temp; ++index)
+            data[index] ^= keystream[index];
+        counter += (uint32_t)blocks;
+        data += temp;
+        len -= temp;
+    }
+    noise_clean(keystream, sizeof(keystream));
+}
+
 /**
  * \brief Encrypts or decrypts a block.
  *
@@ -101,6 +182,10 @@ static void noise_aesgcm_encrypt_or_decrypt
 {
     uint8_t temp, index;
     uint8_t keystream[16];
+    if (st->bitsliced) {
+        noise_aesgcm_bitsliced_crypt(st, data, len);
+        return;
+    }
     while (len > 0) {
         /* Increment the counter block and encrypt to get keystream data.
            We only need to increment the last two bytes of the counter
@@ -110,7 +195,7 @@ static void noise_aesgcm_encrypt_or_decrypt
                            (((uint16_t)(st->counter[14])) << 8)) + 1;
         st->counter[15] = (uint8_t)counter;
         st->counter[14] = (uint8_t)(counter >> 8);
-        rijndaelEncrypt(st->aes, MAXNR, st->counter, keystream);
+        rijndaelEncrypt(st->aes.ref, MAXNR, st->counter, keystream);
 
         /* XOR the input with the keystream block to generate the output */
         temp = 16;
@@ -135,7 +220,6 @@ static void noise_aesgcm_encrypt_or_decrypt
 static void noise_aesgcm_finalize_hash
     (NoiseAESGCMState *st, uint8_t *hash, size_t ad_len, size_t data_len)
 {
-    uint8_t *value;
     uint8_t index;
     uint8_t block[16];
 
@@ -147,10 +231,10 @@ static void noise_aesgcm_finalize_hash
     PUT_UINT64(block + 8, ((uint64_t)data_len) * 8);
     ghash_update(&(st->ghash), block, 16);
 
-    /* Read the result directly out of ghash.Y and XOR with the hash nonce */
-    value = (uint8_t *)(st->ghash.Y);
+    /* Get the GHASH result and XOR it with the hash nonce */
+    ghash_finalize(&(st->ghash), block, 16);
     for (index = 0; index < 16; ++index)
-        hash[index] = st->hash[index] ^ value[index];
+        hash[index] = st->hash[index] ^ block[index];
 }
 
 static int noise_aesgcm_encrypt
@@ -189,7 +273,8 @@ static int noise_aesgcm_decrypt
 
 NoiseCipherState *noise_aesgcm_new(void)
 {
-    NoiseAESGCMState *state = noise_new(NoiseAESGCMState);
+    NoiseAESGCMState *state =
+        (NoiseAESGCMState *)noise_new_object(NOISE_AESGCM_REF_SIZE);
     if (!state)
         return 0;
     state->parent.cipher_id = NOISE_CIPHER_AESGCM;
@@ -201,3 +286,19 @@ NoiseCipherState *noise_aesgcm_new(void)
     state->parent.decrypt = noise_aesgcm_decrypt;
     return &(state->parent);
 }
+
+NoiseCipherState *noise_aesgcm_bitsliced_new(void)
+{
+    NoiseAESGCMState *state = noise_new(NoiseAESGCMState);
+    if (!state)
+        return 0;
+    state->parent.cipher_id = NOISE_CIPHER_AESGCM;
+    state->parent.key_len = 32;
+    state->parent.mac_len = 16;
+    state->parent.create = noise_aesgcm_bitsliced_new;
+    state->parent.init_key = noise_aesgcm_init_key;
+    state->parent.encrypt = noise_aesgcm_encrypt;
+    state->parent.decrypt = noise_aesgcm_decrypt;
+    state->bitsliced = 1;
+    return &(state->parent);
+}
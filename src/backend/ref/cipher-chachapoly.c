@@ -34,7 +34,7 @@ typedef struct
 
 } NoiseChaChaPolyState;
 
-static void noise_chachapoly_init_key
+NOISE_BACKEND_FUNC void noise_chachapoly_init_key
     (NoiseCipherState *state, const uint8_t *key)
 {
     NoiseChaChaPolyState *st = (NoiseChaChaPolyState *)state;
@@ -104,7 +104,7 @@ static void noise_chachapoly_auth_lengths
     poly1305_update(&(st->poly1305), st->block, 16);
 }
 
-static int noise_chachapoly_encrypt
+NOISE_BACKEND_FUNC int noise_chachapoly_encrypt
     (NoiseCipherState *state, const uint8_t *ad, size_t ad_len,
      uint8_t *data, size_t len)
 {
@@ -122,7 +122,7 @@ static int noise_chachapoly_encrypt
     return NOISE_ERROR_NONE;
 }
 
-static int noise_chachapoly_decrypt
+NOISE_BACKEND_FUNC int noise_chachapoly_decrypt
     (NoiseCipherState *state, const uint8_t *ad, size_t ad_len,
      uint8_t *data, size_t len)
 {
@@ -39,7 +39,7 @@ typedef struct
 
 } NoiseCurve25519State;
 
-static int noise_curve25519_generate_keypair
+NOISE_BACKEND_FUNC int noise_curve25519_generate_keypair
     (NoiseDHState *state, const NoiseDHState *other)
 {
     NoiseCurve25519State *st = (NoiseCurve25519State *)state;
@@ -50,7 +50,7 @@ static int noise_curve25519_generate_keypair
     return NOISE_ERROR_NONE;
 }
 
-static int noise_curve25519_set_keypair
+NOISE_BACKEND_FUNC int noise_curve25519_set_keypair
         (NoiseDHState *state, const uint8_t *private_key,
          const uint8_t *public_key)
 {
@@ -65,7 +65,7 @@ static int noise_curve25519_set_keypair
     return NOISE_ERROR_INVALID_PUBLIC_KEY & (equal - 1);
 }
 
-static int noise_curve25519_set_keypair_private
+NOISE_BACKEND_FUNC int noise_curve25519_set_keypair_private
         (NoiseDHState *state, const uint8_t *private_key)
 {
     NoiseCurve25519State *st = (NoiseCurve25519State *)state;
@@ -74,14 +74,14 @@ static int noise_curve25519_set_keypair_private
     return NOISE_ERROR_NONE;
 }
 
-static int noise_curve25519_validate_public_key
+NOISE_BACKEND_FUNC int noise_curve25519_validate_public_key
         (const NoiseDHState *state, const uint8_t *public_key)
 {
     /* Nothing to do here yet */
     return NOISE_ERROR_NONE;
 }
 
-static int noise_curve25519_copy
+NOISE_BACKEND_FUNC int noise_curve25519_copy
     (NoiseDHState *state, const NoiseDHState *from, const NoiseDHState *other)
 {
     NoiseCurve25519State *st = (NoiseCurve25519State *)state;
@@ -91,7 +91,7 @@ static int noise_curve25519_copy
     return NOISE_ERROR_NONE;
 }
 
-static int noise_curve25519_calculate
+NOISE_BACKEND_FUNC int noise_curve25519_calculate
     (const NoiseDHState *private_key_state,
      const NoiseDHState *public_key_state,
      uint8_t *shared_key)
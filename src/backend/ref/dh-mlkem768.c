@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "internal.h"
+#include "crypto/mlkem/mlkem.h"
+#include <string.h>
+
+/* ML-KEM fits the same dependent key pair model as New Hope.  The
+   initiator's key pair is a KEM key pair, and the responder's "key pair"
+   is an encapsulation against the initiator's public key: the ciphertext
+   is the public key and the shared secret is kept back for calculate() */
+
+typedef struct NoiseMLKEM768State_s
+{
+    struct NoiseDHState_s parent;
+    uint8_t random_data[MLKEM768_KEYGEN_SEEDBYTES];
+    uint16_t generated;
+    uint8_t secret_key[MLKEM768_SECRETKEYBYTES];
+    uint8_t public_key[MLKEM768_PUBLICKEYBYTES];
+
+} NoiseMLKEM768State;
+
+static int noise_mlkem768_generate_keypair
+    (NoiseDHState *state, const NoiseDHState *other)
+{
+    NoiseMLKEM768State *st = (NoiseMLKEM768State *)state;
+    NoiseMLKEM768State *os = (NoiseMLKEM768State *)other;
+    if (st->parent.role == NOISE_ROLE_RESPONDER) {
+        /* Encapsulate against the initiator's public key */
+        if (!os || os->parent.key_type == NOISE_KEY_TYPE_NO_KEY)
+            return NOISE_ERROR_INVALID_STATE;
+        noise_rand_bytes(st->random_data, st->parent.private_key_len);
+        mlkem768_encaps(st->public_key, st->secret_key,
+                        os->public_key, st->random_data);
+    } else {
+        /* Generate the key pair for the initiator */
+        noise_rand_bytes(st->random_data, st->parent.private_key_len);
+        mlkem768_keygen(st->public_key, st->secret_key, st->random_data);
+    }
+    st->generated = 1;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_mlkem768_set_keypair_private
+        (NoiseDHState *state, const uint8_t *private_key)
+{
+    /* The "private key" is the 64 or 32 bytes of random seed data */
+    NoiseMLKEM768State *st = (NoiseMLKEM768State *)state;
+    memcpy(st->random_data, private_key, st->parent.private_key_len);
+    if (st->parent.role == NOISE_ROLE_RESPONDER) {
+        /* The ciphertext depends upon the initiator's public key, which
+           we don't have yet.  Defer encapsulation until calculate() */
+        memset(st->public_key, 0, sizeof(st->public_key));
+        st->generated = 0;
+    } else {
+        mlkem768_keygen(st->public_key, st->secret_key, st->random_data);
+        st->generated = 1;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_mlkem768_set_keypair
+        (NoiseDHState *state, const uint8_t *private_key,
+         const uint8_t *public_key)
+{
+    /* Ignore the public key and re-generate from the private key */
+    return noise_mlkem768_set_keypair_private(state, private_key);
+}
+
+static int noise_mlkem768_validate_public_key
+        (const NoiseDHState *state, const uint8_t *public_key)
+{
+    /* Encapsulation keys must be in canonical form, as required by
+       FIPS 203.  Any ciphertext is acceptable to decapsulation */
+    if (state->role != NOISE_ROLE_RESPONDER &&
+            !mlkem768_check_public_key(public_key))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_mlkem768_copy
+    (NoiseDHState *state, const NoiseDHState *from, const NoiseDHState *other)
+{
+    NoiseMLKEM768State *st = (NoiseMLKEM768State *)state;
+    const NoiseMLKEM768State *from_st = (const NoiseMLKEM768State *)from;
+    const NoiseMLKEM768State *other_st = (const NoiseMLKEM768State *)other;
+    memcpy(st->random_data, from_st->random_data, sizeof(st->random_data));
+    st->generated = from_st->generated;
+    memcpy(st->secret_key, from_st->secret_key, sizeof(st->secret_key));
+    memcpy(st->public_key, from_st->public_key, sizeof(st->public_key));
+    if (st->parent.role == NOISE_ROLE_RESPONDER && !(st->generated) &&
+            from_st->parent.key_type == NOISE_KEY_TYPE_KEYPAIR && other_st) {
+        /* We now have the initiator's public key, so perform the
+           encapsulation that was deferred when the seed was set */
+        mlkem768_encaps(st->public_key, st->secret_key,
+                        other_st->public_key, st->random_data);
+        st->generated = 1;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_mlkem768_calculate
+    (const NoiseDHState *private_key_state,
+     const NoiseDHState *public_key_state,
+     uint8_t *shared_key)
+{
+    NoiseMLKEM768State *priv_st = (NoiseMLKEM768State *)private_key_state;
+    NoiseMLKEM768State *pub_st = (NoiseMLKEM768State *)public_key_state;
+    if (priv_st->parent.role == NOISE_ROLE_RESPONDER) {
+        if (!priv_st->generated) {
+            /* The seed was set explicitly before the initiator's public
+               key was known, so encapsulate now */
+            mlkem768_encaps(priv_st->public_key, shared_key,
+                            pub_st->public_key, priv_st->random_data);
+        } else {
+            /* The shared secret was produced by the encapsulation */
+            memcpy(shared_key, priv_st->secret_key, MLKEM768_SHAREDBYTES);
+        }
+    } else {
+        mlkem768_decaps(shared_key, pub_st->public_key, priv_st->secret_key);
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static void noise_mlkem768_change_role(NoiseDHState *state)
+{
+    /* Change the size of the keys based on the object's role */
+    if (state->role == NOISE_ROLE_RESPONDER) {
+        state->private_key_len = MLKEM768_ENCAPS_SEEDBYTES;
+        state->public_key_len = MLKEM768_CIPHERTEXTBYTES;
+    } else {
+        state->private_key_len = MLKEM768_KEYGEN_SEEDBYTES;
+        state->public_key_len = MLKEM768_PUBLICKEYBYTES;
+    }
+}
+
+NoiseDHState *noise_mlkem768_new(void)
+{
+    NoiseMLKEM768State *state = noise_new(NoiseMLKEM768State);
+    if (!state)
+        return 0;
+    state->parent.dh_id = NOISE_DH_MLKEM768;
+    state->parent.ephemeral_only = 1;
+    state->parent.nulls_allowed = 0;
+    state->parent.private_key_len = MLKEM768_KEYGEN_SEEDBYTES;
+    state->parent.public_key_len = MLKEM768_PUBLICKEYBYTES;
+    state->parent.shared_key_len = MLKEM768_SHAREDBYTES;
+    state->parent.private_key = state->random_data;
+    state->parent.public_key = state->public_key;
+    state->parent.generate_keypair = noise_mlkem768_generate_keypair;
+    state->parent.set_keypair = noise_mlkem768_set_keypair;
+    state->parent.set_keypair_private = noise_mlkem768_set_keypair_private;
+    state->parent.validate_public_key = noise_mlkem768_validate_public_key;
+    state->parent.copy = noise_mlkem768_copy;
+    state->parent.calculate = noise_mlkem768_calculate;
+    state->parent.change_role = noise_mlkem768_change_role;
+    return &(state->parent);
+}
@@ -33,6 +33,7 @@ typedef struct NoiseNewHopeState_s
     uint16_t generated;
     poly private_key;
     uint8_t public_key[MAX_OF(NEWHOPE_SENDABYTES, NEWHOPE_SENDBBYTES)];
+    const poly_ops *ops;
 
 } NoiseNewHopeState;
 
@@ -47,11 +48,12 @@ static int noise_newhope_generate_keypair
             return NOISE_ERROR_INVALID_STATE;
         noise_rand_bytes(st->random_data, st->parent.private_key_len);
         newhope_sharedb((uint8_t *)&(st->private_key), st->public_key,
-                        os->public_key, st->random_data);
+                        os->public_key, st->random_data, st->ops);
     } else {
         /* Generate the keypair for Alice */
         noise_rand_bytes(st->random_data, st->parent.private_key_len);
-        newhope_keygen(st->public_key, &(st->private_key), st->random_data);
+        newhope_keygen(st->public_key, &(st->private_key), st->random_data,
+                       st->ops);
     }
     st->generated = 1;
     return NOISE_ERROR_NONE;
@@ -71,7 +73,8 @@ static int noise_newhope_set_keypair_private
         st->generated = 0;
     } else {
         /* Generate the key pair for Alice from the supplied random data */
-        newhope_keygen(st->public_key, &(st->private_key), st->random_data);
+        newhope_keygen(st->public_key, &(st->private_key), st->random_data,
+                       st->ops);
         st->generated = 1;
     }
     return NOISE_ERROR_NONE;
@@ -109,7 +112,7 @@ static int noise_newhope_copy
            public key for Alice when we set Bob's private key.  We have
            the public key for Alice now so generate Bob's actual key */
         newhope_sharedb((uint8_t *)&(st->private_key), st->public_key,
-                        other_st->public_key, st->random_data);
+                        other_st->public_key, st->random_data, st->ops);
         st->generated = 1;
     }
     return NOISE_ERROR_NONE;
@@ -128,7 +131,8 @@ static int noise_newhope_calculate
                didn't know Alice's public key at the time.  We do know
                Alice's public key now, so generate Bob's key pair now */
             newhope_sharedb(shared_key, priv_st->public_key,
-                            pub_st->public_key, priv_st->random_data);
+                            pub_st->public_key, priv_st->random_data,
+                            priv_st->ops);
         } else {
             /* We already generated the shared secret for Bob when we
              * generated the "keypair" for him. */
@@ -136,7 +140,8 @@ static int noise_newhope_calculate
         }
     } else {
         /* Generate the shared secret for Alice */
-        newhope_shareda(shared_key, &(priv_st->private_key), pub_st->public_key);
+        newhope_shareda(shared_key, &(priv_st->private_key),
+                        pub_st->public_key, priv_st->ops);
     }
     return NOISE_ERROR_NONE;
 }
@@ -173,9 +178,23 @@ NoiseDHState *noise_newhope_new(void)
     state->parent.copy = noise_newhope_copy;
     state->parent.calculate = noise_newhope_calculate;
     state->parent.change_role = noise_newhope_change_role;
+    state->ops = &poly_ops_ref;
     return &(state->parent);
 }
 
+#if NEWHOPE_HAVE_AVX2 && !defined(NOISE_SINGLE_SUITE)
+
+NoiseDHState *noise_newhope_avx2_new(void)
+{
+    NoiseDHState *state = noise_newhope_new();
+    if (!state)
+        return 0;
+    ((NoiseNewHopeState *)state)->ops = &poly_ops_avx2;
+    return state;
+}
+
+#endif
+
 /* Implementation of random number generation needed by New Hope */
 void randombytes(unsigned char *x,unsigned long long xlen)
 {
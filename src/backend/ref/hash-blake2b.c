@@ -61,3 +61,29 @@ NoiseHashState *noise_blake2b_new(void)
     state->parent.finalize = noise_blake2b_finalize;
     return &(state->parent);
 }
+
+#if BLAKE2B_HAVE_AVX2 && !defined(NOISE_SINGLE_SUITE)
+
+static void noise_blake2b_avx2_update(NoiseHashState *state, const uint8_t *data, size_t len)
+{
+    NoiseBLAKE2bState *st = (NoiseBLAKE2bState *)state;
+    BLAKE2b_update_avx2(&(st->blake2), data, len);
+}
+
+static void noise_blake2b_avx2_finalize(NoiseHashState *state, uint8_t *hash)
+{
+    NoiseBLAKE2bState *st = (NoiseBLAKE2bState *)state;
+    BLAKE2b_finish_avx2(&(st->blake2), hash);
+}
+
+NoiseHashState *noise_blake2b_avx2_new(void)
+{
+    NoiseHashState *state = noise_blake2b_new();
+    if (!state)
+        return 0;
+    state->update = noise_blake2b_avx2_update;
+    state->finalize = noise_blake2b_avx2_finalize;
+    return state;
+}
+
+#endif
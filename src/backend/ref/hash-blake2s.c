@@ -30,19 +30,19 @@ typedef struct
 
 } NoiseBLAKE2sState;
 
-static void noise_blake2s_reset(NoiseHashState *state)
+NOISE_BACKEND_FUNC void noise_blake2s_reset(NoiseHashState *state)
 {
     NoiseBLAKE2sState *st = (NoiseBLAKE2sState *)state;
     BLAKE2s_reset(&(st->blake2));
 }
 
-static void noise_blake2s_update(NoiseHashState *state, const uint8_t *data, size_t len)
+NOISE_BACKEND_FUNC void noise_blake2s_update(NoiseHashState *state, const uint8_t *data, size_t len)
 {
     NoiseBLAKE2sState *st = (NoiseBLAKE2sState *)state;
     BLAKE2s_update(&(st->blake2), data, len);
 }
 
-static void noise_blake2s_finalize(NoiseHashState *state, uint8_t *hash)
+NOISE_BACKEND_FUNC void noise_blake2s_finalize(NoiseHashState *state, uint8_t *hash)
 {
     NoiseBLAKE2sState *st = (NoiseBLAKE2sState *)state;
     BLAKE2s_finish(&(st->blake2), hash);
@@ -61,3 +61,58 @@ NoiseHashState *noise_blake2s_new(void)
     state->parent.finalize = noise_blake2s_finalize;
     return &(state->parent);
 }
+
+#if BLAKE2S_HAVE_AVX2 && !defined(NOISE_SINGLE_SUITE)
+
+static void noise_blake2s_avx2_update(NoiseHashState *state, const uint8_t *data, size_t len)
+{
+    NoiseBLAKE2sState *st = (NoiseBLAKE2sState *)state;
+    BLAKE2s_update_avx2(&(st->blake2), data, len);
+}
+
+static void noise_blake2s_avx2_finalize(NoiseHashState *state, uint8_t *hash)
+{
+    NoiseBLAKE2sState *st = (NoiseBLAKE2sState *)state;
+    BLAKE2s_finish_avx2(&(st->blake2), hash);
+}
+
+/* Below this many lanes, the single-stream AVX2 code is faster */
+#define NOISE_BLAKE2S_MIN_LANES 4
+
+static int noise_blake2s_avx2_update_multi
+    (NoiseHashState **states, const uint8_t **data, size_t len, size_t count)
+{
+    BLAKE2s_context_t *contexts[BLAKE2S_MAX_LANES];
+    size_t lane;
+    if (count < NOISE_BLAKE2S_MIN_LANES)
+        return 0;
+    for (lane = 0; lane < count; ++lane)
+        contexts[lane] = &(((NoiseBLAKE2sState *)(states[lane]))->blake2);
+    return BLAKE2s_update_multi_avx2(contexts, data, len, (unsigned)count);
+}
+
+static int noise_blake2s_avx2_finalize_multi
+    (NoiseHashState **states, uint8_t **hashes, size_t count)
+{
+    BLAKE2s_context_t *contexts[BLAKE2S_MAX_LANES];
+    size_t lane;
+    if (count < NOISE_BLAKE2S_MIN_LANES)
+        return 0;
+    for (lane = 0; lane < count; ++lane)
+        contexts[lane] = &(((NoiseBLAKE2sState *)(states[lane]))->blake2);
+    return BLAKE2s_finish_multi_avx2(contexts, hashes, (unsigned)count);
+}
+
+NoiseHashState *noise_blake2s_avx2_new(void)
+{
+    NoiseHashState *state = noise_blake2s_new();
+    if (!state)
+        return 0;
+    state->update = noise_blake2s_avx2_update;
+    state->finalize = noise_blake2s_avx2_finalize;
+    state->update_multi = noise_blake2s_avx2_update_multi;
+    state->finalize_multi = noise_blake2s_avx2_finalize_multi;
+    return state;
+}
+
+#endif
@@ -61,3 +61,72 @@ NoiseHashState *noise_sha256_new(void)
     state->parent.finalize = noise_sha256_finalize;
     return &(state->parent);
 }
+
+#if SHA256_HAVE_SHANI && !defined(NOISE_SINGLE_SUITE)
+
+static void noise_sha256_shani_update(NoiseHashState *state, const uint8_t *data, size_t len)
+{
+    NoiseSHA256State *st = (NoiseSHA256State *)state;
+    sha256_update_shani(&(st->sha256), data, len);
+}
+
+static void noise_sha256_shani_finalize(NoiseHashState *state, uint8_t *hash)
+{
+    NoiseSHA256State *st = (NoiseSHA256State *)state;
+    sha256_finish_shani(&(st->sha256), hash);
+}
+
+NoiseHashState *noise_sha256_shani_new(void)
+{
+    NoiseHashState *state = noise_sha256_new();
+    if (!state)
+        return 0;
+    state->update = noise_sha256_shani_update;
+    state->finalize = noise_sha256_shani_finalize;
+    return state;
+}
+
+#endif
+
+#if SHA256_HAVE_AVX2 && !defined(NOISE_SINGLE_SUITE)
+
+/* Minimum number of lanes before the multi-buffer code is faster than
+   hashing the states one at a time with the reference code.  The SHA
+   extensions are faster again, so the "shani" backend doesn't use it */
+#define NOISE_SHA256_MIN_LANES 3
+
+static int noise_sha256_avx2_update_multi
+    (NoiseHashState **states, const uint8_t **data, size_t len, size_t count)
+{
+    sha256_context_t *contexts[SHA256_MAX_LANES];
+    size_t lane;
+    if (count < NOISE_SHA256_MIN_LANES)
+        return 0;
+    for (lane = 0; lane < count; ++lane)
+        contexts[lane] = &(((NoiseSHA256State *)(states[lane]))->sha256);
+    return sha256_update_multi_avx2(contexts, data, len, (unsigned)count);
+}
+
+static int noise_sha256_avx2_finalize_multi
+    (NoiseHashState **states, uint8_t **hashes, size_t count)
+{
+    sha256_context_t *contexts[SHA256_MAX_LANES];
+    size_t lane;
+    if (count < NOISE_SHA256_MIN_LANES)
+        return 0;
+    for (lane = 0; lane < count; ++lane)
+        contexts[lane] = &(((NoiseSHA256State *)(states[lane]))->sha256);
+    return sha256_finish_multi_avx2(contexts, hashes, (unsigned)count);
+}
+
+NoiseHashState *noise_sha256_avx2_new(void)
+{
+    NoiseHashState *state = noise_sha256_new();
+    if (!state)
+        return 0;
+    state->update_multi = noise_sha256_avx2_update_multi;
+    state->finalize_multi = noise_sha256_avx2_finalize_multi;
+    return state;
+}
+
+#endif
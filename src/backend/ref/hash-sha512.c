@@ -61,3 +61,29 @@ NoiseHashState *noise_sha512_new(void)
     state->parent.finalize = noise_sha512_finalize;
     return &(state->parent);
 }
+
+#if SHA512_HAVE_AVX2 && !defined(NOISE_SINGLE_SUITE)
+
+static void noise_sha512_avx2_update(NoiseHashState *state, const uint8_t *data, size_t len)
+{
+    NoiseSHA512State *st = (NoiseSHA512State *)state;
+    sha512_update_avx2(&(st->sha512), data, len);
+}
+
+static void noise_sha512_avx2_finalize(NoiseHashState *state, uint8_t *hash)
+{
+    NoiseSHA512State *st = (NoiseSHA512State *)state;
+    sha512_finish_avx2(&(st->sha512), hash);
+}
+
+NoiseHashState *noise_sha512_avx2_new(void)
+{
+    NoiseHashState *state = noise_sha512_new();
+    if (!state)
+        return 0;
+    state->update = noise_sha512_avx2_update;
+    state->finalize = noise_sha512_avx2_finalize;
+    return state;
+}
+
+#endif
@@ -28,6 +28,7 @@ typedef struct
     struct NoiseSignState_s parent;
     uint8_t private_key[32];
     uint8_t public_key[32];
+    ed25519_expanded_key expanded_key;
 
 } NoiseEd25519State;
 
@@ -71,12 +72,23 @@ static int noise_ed25519_sign
         (const NoiseSignState *state, const uint8_t *message,
          size_t message_len, uint8_t *signature)
 {
+    /* The key was expanded when it was set, so the SHA-512 hash of the
+       private key and the clamping do not need to be repeated here */
     const NoiseEd25519State *st = (const NoiseEd25519State *)state;
-    ed25519_sign(message, message_len, st->private_key,
-                 st->public_key, signature);
+    ed25519_sign_expanded(message, message_len, st->expanded_key,
+                          st->public_key, signature);
     return NOISE_ERROR_NONE;
 }
 
+static void noise_ed25519_key_changed(NoiseSignState *state)
+{
+    NoiseEd25519State *st = (NoiseEd25519State *)state;
+    if (state->key_type == NOISE_KEY_TYPE_KEYPAIR)
+        ed25519_expand_secret_key(st->private_key, st->expanded_key);
+    else
+        noise_clean(st->expanded_key, sizeof(st->expanded_key));
+}
+
 static int noise_ed25519_verify
         (const NoiseSignState *state, const uint8_t *message,
          size_t message_len, const uint8_t *signature)
@@ -87,6 +99,56 @@ static int noise_ed25519_verify
     return result ? NOISE_ERROR_INVALID_SIGNATURE : NOISE_ERROR_NONE;
 }
 
+/* Maximum number of signatures to pass to ed25519-donna at once;
+   it internally processes batches of up to 64 */
+#define ED25519_MAX_BATCH 64
+
+static int noise_ed25519_verify_batch
+        (const NoiseSignState **states, const uint8_t **messages,
+         const size_t *message_lens, const uint8_t **signatures,
+         size_t count, int *valid)
+{
+    const unsigned char *m[ED25519_MAX_BATCH];
+    const unsigned char *pk[ED25519_MAX_BATCH];
+    const unsigned char *rs[ED25519_MAX_BATCH];
+    size_t mlen[ED25519_MAX_BATCH];
+    int ok[ED25519_MAX_BATCH];
+    size_t index[ED25519_MAX_BATCH];
+    size_t posn, num, i;
+    int result = NOISE_ERROR_NONE;
+
+    posn = 0;
+    while (posn < count) {
+        /* Gather up the next batch.  The batch code does not reject
+           non-canonical S values like ed25519_sign_open() does, so we
+           filter those out here to keep the two paths consistent */
+        num = 0;
+        while (posn < count && num < ED25519_MAX_BATCH) {
+            if (signatures[posn][63] & 0xE0) {
+                valid[posn] = 0;
+                result = NOISE_ERROR_INVALID_SIGNATURE;
+            } else {
+                m[num] = messages[posn];
+                mlen[num] = message_lens[posn];
+                pk[num] = ((const NoiseEd25519State *)(states[posn]))->public_key;
+                rs[num] = signatures[posn];
+                index[num] = posn;
+                ++num;
+            }
+            ++posn;
+        }
+        if (!num)
+            continue;
+
+        /* Verify the batch and scatter the results */
+        if (ed25519_sign_open_batch(m, mlen, pk, rs, num, ok) != 0)
+            result = NOISE_ERROR_INVALID_SIGNATURE;
+        for (i = 0; i < num; ++i)
+            valid[index[i]] = ok[i];
+    }
+    return result;
+}
+
 NoiseSignState *noise_ed25519_new(void)
 {
     NoiseEd25519State *state = noise_new(NoiseEd25519State);
@@ -104,5 +166,7 @@ NoiseSignState *noise_ed25519_new(void)
     state->parent.derive_public_key = noise_ed25519_derive_public_key;
     state->parent.sign = noise_ed25519_sign;
     state->parent.verify = noise_ed25519_verify;
+    state->parent.verify_batch = noise_ed25519_verify_batch;
+    state->parent.key_changed = noise_ed25519_key_changed;
     return &(state->parent);
 }
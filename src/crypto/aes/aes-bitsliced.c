@@ -0,0 +1,594 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+    Constant-time bitsliced AES, adapted from the "ct64" implementation
+    in BearSSL.
+
+    Four blocks are packed into eight 64-bit words, where word i holds
+    bit i of every byte of the four blocks.  The S-box is the Boyar-Peralta
+    circuit of 113 boolean gates, and ShiftRows and MixColumns become shifts
+    and rotations within the words.  There are no table lookups or
+    secret-dependent branches, so this version does not leak the key
+    through the cache like the T-table version in rijndael-alg-fst.c does.
+
+    With GCC or clang, each word is a vector of two 64-bit lanes so that
+    8 blocks are encrypted per pass with the same instruction count.  This
+    maps onto SSE2 on x86-64 and NEON on ARM without any intrinsics.  Other
+    compilers use a single lane and two passes for 8 blocks.
+*/
+
+#include "aes-bitsliced.h"
+#include <string.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+typedef uint64_t aes_word __attribute__((vector_size(16)));
+#define AES_LANES 2
+#define AES_LANE(x, lane) ((x)[(lane)])
+#else
+typedef uint64_t aes_word;
+#define AES_LANES 1
+#define AES_LANE(x, lane) (x)
+#endif
+
+/* Number of blocks that are encrypted in each pass */
+#define AES_PASS_BLOCKS (4 * AES_LANES)
+
+static uint32_t load_le32(const uint8_t *buf)
+{
+    return ((uint32_t)(buf[0])) |
+           (((uint32_t)(buf[1])) << 8) |
+           (((uint32_t)(buf[2])) << 16) |
+           (((uint32_t)(buf[3])) << 24);
+}
+
+static void store_le32(uint8_t *buf, uint32_t x)
+{
+    buf[0] = (uint8_t)x;
+    buf[1] = (uint8_t)(x >> 8);
+    buf[2] = (uint8_t)(x >> 16);
+    buf[3] = (uint8_t)(x >> 24);
+}
+
+/* Applies the AES S-box to all 32 bytes in the bitsliced state */
+static void aes_sbox(aes_word *q)
+{
+    /* Variables x* (input) and s* (output) are numbered in "reverse"
+       order, with x0 being the high bit and x7 the low bit */
+    aes_word x0, x1, x2, x3, x4, x5, x6, x7;
+    aes_word y1, y2, y3, y4, y5, y6, y7, y8, y9;
+    aes_word y10, y11, y12, y13, y14, y15, y16, y17, y18, y19;
+    aes_word y20, y21;
+    aes_word z0, z1, z2, z3, z4, z5, z6, z7, z8, z9;
+    aes_word z10, z11, z12, z13, z14, z15, z16, z17;
+    aes_word t0, t1, t2, t3, t4, t5, t6, t7, t8, t9;
+    aes_word t10, t11, t12, t13, t14, t15, t16, t17, t18, t19;
+    aes_word t20, t21, t22, t23, t24, t25, t26, t27, t28, t29;
+    aes_word t30, t31, t32, t33, t34, t35, t36, t37, t38, t39;
+    aes_word t40, t41, t42, t43, t44, t45, t46, t47, t48, t49;
+    aes_word t50, t51, t52, t53, t54, t55, t56, t57, t58, t59;
+    aes_word t60, t61, t62, t63, t64, t65, t66, t67;
+    aes_word s0, s1, s2, s3, s4, s5, s6, s7;
+
+    x0 = q[7];
+    x1 = q[6];
+    x2 = q[5];
+    x3 = q[4];
+    x4 = q[3];
+    x5 = q[2];
+    x6 = q[1];
+    x7 = q[0];
+
+    /* Top linear transformation */
+    y14 = x3 ^ x5;
+    y13 = x0 ^ x6;
+    y9 = x0 ^ x3;
+    y8 = x0 ^ x5;
+    t0 = x1 ^ x2;
+    y1 = t0 ^ x7;
+    y4 = y1 ^ x3;
+    y12 = y13 ^ y14;
+    y2 = y1 ^ x0;
+    y5 = y1 ^ x6;
+    y3 = y5 ^ y8;
+    t1 = x4 ^ y12;
+    y15 = t1 ^ x5;
+    y20 = t1 ^ x1;
+    y6 = y15 ^ x7;
+    y10 = y15 ^ t0;
+    y11 = y20 ^ y9;
+    y7 = x7 ^ y11;
+    y17 = y10 ^ y11;
+    y19 = y10 ^ y8;
+    y16 = t0 ^ y11;
+    y21 = y13 ^ y16;
+    y18 = x0 ^ y16;
+
+    /* Non-linear section */
+    t2 = y12 & y15;
+    t3 = y3 & y6;
+    t4 = t3 ^ t2;
+    t5 = y4 & x7;
+    t6 = t5 ^ t2;
+    t7 = y13 & y16;
+    t8 = y5 & y1;
+    t9 = t8 ^ t7;
+    t10 = y2 & y7;
+    t11 = t10 ^ t7;
+    t12 = y9 & y11;
+    t13 = y14 & y17;
+    t14 = t13 ^ t12;
+    t15 = y8 & y10;
+    t16 = t15 ^ t12;
+    t17 = t4 ^ t14;
+    t18 = t6 ^ t16;
+    t19 = t9 ^ t14;
+    t20 = t11 ^ t16;
+    t21 = t17 ^ y20;
+    t22 = t18 ^ y19;
+    t23 = t19 ^ y21;
+    t24 = t20 ^ y18;
+
+    t25 = t21 ^ t22;
+    t26 = t21 & t23;
+    t27 = t24 ^ t26;
+    t28 = t25 & t27;
+    t29 = t28 ^ t22;
+    t30 = t23 ^ t24;
+    t31 = t22 ^ t26;
+    t32 = t31 & t30;
+    t33 = t32 ^ t24;
+    t34 = t23 ^ t33;
+    t35 = t27 ^ t33;
+    t36 = t24 & t35;
+    t37 = t36 ^ t34;
+    t38 = t27 ^ t36;
+    t39 = t29 & t38;
+    t40 = t25 ^ t39;
+
+    t41 = t40 ^ t37;
+    t42 = t29 ^ t33;
+    t43 = t29 ^ t40;
+    t44 = t33 ^ t37;
+    t45 = t42 ^ t41;
+    z0 = t44 & y15;
+    z1 = t37 & y6;
+    z2 = t33 & x7;
+    z3 = t43 & y16;
+    z4 = t40 & y1;
+    z5 = t29 & y7;
+    z6 = t42 & y11;
+    z7 = t45 & y17;
+    z8 = t41 & y10;
+    z9 = t44 & y12;
+    z10 = t37 & y3;
+    z11 = t33 & y4;
+    z12 = t43 & y13;
+    z13 = t40 & y5;
+    z14 = t29 & y2;
+    z15 = t42 & y9;
+    z16 = t45 & y14;
+    z17 = t41 & y8;
+
+    /* Bottom linear transformation */
+    t46 = z15 ^ z16;
+    t47 = z10 ^ z11;
+    t48 = z5 ^ z13;
+    t49 = z9 ^ z10;
+    t50 = z2 ^ z12;
+    t51 = z2 ^ z5;
+    t52 = z7 ^ z8;
+    t53 = z0 ^ z3;
+    t54 = z6 ^ z7;
+    t55 = z16 ^ z17;
+    t56 = z12 ^ t48;
+    t57 = t50 ^ t53;
+    t58 = z4 ^ t46;
+    t59 = z3 ^ t54;
+    t60 = t46 ^ t57;
+    t61 = z14 ^ t57;
+    t62 = t52 ^ t58;
+    t63 = t49 ^ t58;
+    t64 = z4 ^ t59;
+    t65 = t61 ^ t62;
+    t66 = z1 ^ t63;
+    s0 = t59 ^ t63;
+    s6 = t56 ^ ~t62;
+    s7 = t48 ^ ~t60;
+    t67 = t64 ^ t65;
+    s3 = t53 ^ t66;
+    s4 = t51 ^ t66;
+    s5 = t47 ^ t65;
+    s1 = t64 ^ ~s3;
+    s2 = t55 ^ ~t67;
+
+    q[7] = s0;
+    q[6] = s1;
+    q[5] = s2;
+    q[4] = s3;
+    q[3] = s4;
+    q[2] = s5;
+    q[1] = s6;
+    q[0] = s7;
+}
+
+/* Converts between the interleaved and bitsliced representations.
+   The transformation is its own inverse */
+static void aes_ortho(aes_word *q)
+{
+#define SWAPN(cl, ch, s, x, y) \
+    do { \
+        aes_word a = (x); \
+        aes_word b = (y); \
+        (x) = (a & (uint64_t)(cl)) | ((b & (uint64_t)(cl)) << (s)); \
+        (y) = ((a & (uint64_t)(ch)) >> (s)) | (b & (uint64_t)(ch)); \
+    } while (0)
+#define SWAP2(x, y) \
+    SWAPN(0x5555555555555555ULL, 0xAAAAAAAAAAAAAAAAULL, 1, x, y)
+#define SWAP4(x, y) \
+    SWAPN(0x3333333333333333ULL, 0xCCCCCCCCCCCCCCCCULL, 2, x, y)
+#define SWAP8(x, y) \
+    SWAPN(0x0F0F0F0F0F0F0F0FULL, 0xF0F0F0F0F0F0F0F0ULL, 4, x, y)
+
+    SWAP2(q[0], q[1]);
+    SWAP2(q[2], q[3]);
+    SWAP2(q[4], q[5]);
+    SWAP2(q[6], q[7]);
+
+    SWAP4(q[0], q[2]);
+    SWAP4(q[1], q[3]);
+    SWAP4(q[4], q[6]);
+    SWAP4(q[5], q[7]);
+
+    SWAP8(q[0], q[4]);
+    SWAP8(q[1], q[5]);
+    SWAP8(q[2], q[6]);
+    SWAP8(q[3], q[7]);
+
+#undef SWAPN
+#undef SWAP2
+#undef SWAP4
+#undef SWAP8
+}
+
+/* Spreads the four 32-bit words of a block across two 64-bit words */
+static void aes_interleave_in(uint64_t *q0, uint64_t *q1, const uint32_t *w)
+{
+    uint64_t x0, x1, x2, x3;
+
+    x0 = w[0];
+    x1 = w[1];
+    x2 = w[2];
+    x3 = w[3];
+    x0 |= (x0 << 16);
+    x1 |= (x1 << 16);
+    x2 |= (x2 << 16);
+    x3 |= (x3 << 16);
+    x0 &= 0x0000FFFF0000FFFFULL;
+    x1 &= 0x0000FFFF0000FFFFULL;
+    x2 &= 0x0000FFFF0000FFFFULL;
+    x3 &= 0x0000FFFF0000FFFFULL;
+    x0 |= (x0 << 8);
+    x1 |= (x1 << 8);
+    x2 |= (x2 << 8);
+    x3 |= (x3 << 8);
+    x0 &= 0x00FF00FF00FF00FFULL;
+    x1 &= 0x00FF00FF00FF00FFULL;
+    x2 &= 0x00FF00FF00FF00FFULL;
+    x3 &= 0x00FF00FF00FF00FFULL;
+    *q0 = x0 | (x2 << 8);
+    *q1 = x1 | (x3 << 8);
+}
+
+/* Inverse of aes_interleave_in() */
+static void aes_interleave_out(uint32_t *w, uint64_t q0, uint64_t q1)
+{
+    uint64_t x0, x1, x2, x3;
+
+    x0 = q0 & 0x00FF00FF00FF00FFULL;
+    x1 = q1 & 0x00FF00FF00FF00FFULL;
+    x2 = (q0 >> 8) & 0x00FF00FF00FF00FFULL;
+    x3 = (q1 >> 8) & 0x00FF00FF00FF00FFULL;
+    x0 |= (x0 >> 8);
+    x1 |= (x1 >> 8);
+    x2 |= (x2 >> 8);
+    x3 |= (x3 >> 8);
+    x0 &= 0x0000FFFF0000FFFFULL;
+    x1 &= 0x0000FFFF0000FFFFULL;
+    x2 &= 0x0000FFFF0000FFFFULL;
+    x3 &= 0x0000FFFF0000FFFFULL;
+    w[0] = (uint32_t)x0 | (uint32_t)(x0 >> 16);
+    w[1] = (uint32_t)x1 | (uint32_t)(x1 >> 16);
+    w[2] = (uint32_t)x2 | (uint32_t)(x2 >> 16);
+    w[3] = (uint32_t)x3 | (uint32_t)(x3 >> 16);
+}
+
+/* Applies the S-box to the four bytes of a key schedule word */
+static uint32_t aes_sub_word(uint32_t x)
+{
+    aes_word q[8];
+    memset(q, 0, sizeof(q));
+    AES_LANE(q[0], 0) = x;
+    aes_ortho(q);
+    aes_sbox(q);
+    aes_ortho(q);
+    return (uint32_t)(AES_LANE(q[0], 0));
+}
+
+static void aes_add_round_key(aes_word *q, const uint64_t *sk)
+{
+    q[0] ^= sk[0];
+    q[1] ^= sk[1];
+    q[2] ^= sk[2];
+    q[3] ^= sk[3];
+    q[4] ^= sk[4];
+    q[5] ^= sk[5];
+    q[6] ^= sk[6];
+    q[7] ^= sk[7];
+}
+
+static void aes_shift_rows(aes_word *q)
+{
+    int i;
+    for (i = 0; i < 8; ++i) {
+        aes_word x = q[i];
+        q[i] = (x & 0x000000000000FFFFULL) |
+               ((x & 0x00000000FFF00000ULL) >> 4) |
+               ((x & 0x00000000000F0000ULL) << 12) |
+               ((x & 0x0000FF0000000000ULL) >> 8) |
+               ((x & 0x000000FF00000000ULL) << 8) |
+               ((x & 0xF000000000000000ULL) >> 12) |
+               ((x & 0x0FFF000000000000ULL) << 4);
+    }
+}
+
+static aes_word aes_rotr32(aes_word x)
+{
+    return (x << 32) | (x >> 32);
+}
+
+static void aes_mix_columns(aes_word *q)
+{
+    aes_word q0, q1, q2, q3, q4, q5, q6, q7;
+    aes_word r0, r1, r2, r3, r4, r5, r6, r7;
+
+    q0 = q[0];
+    q1 = q[1];
+    q2 = q[2];
+    q3 = q[3];
+    q4 = q[4];
+    q5 = q[5];
+    q6 = q[6];
+    q7 = q[7];
+    r0 = (q0 >> 16) | (q0 << 48);
+    r1 = (q1 >> 16) | (q1 << 48);
+    r2 = (q2 >> 16) | (q2 << 48);
+    r3 = (q3 >> 16) | (q3 << 48);
+    r4 = (q4 >> 16) | (q4 << 48);
+    r5 = (q5 >> 16) | (q5 << 48);
+    r6 = (q6 >> 16) | (q6 << 48);
+    r7 = (q7 >> 16) | (q7 << 48);
+
+    q[0] = q7 ^ r7 ^ r0 ^ aes_rotr32(q0 ^ r0);
+    q[1] = q0 ^ r0 ^ q7 ^ r7 ^ r1 ^ aes_rotr32(q1 ^ r1);
+    q[2] = q1 ^ r1 ^ r2 ^ aes_rotr32(q2 ^ r2);
+    q[3] = q2 ^ r2 ^ q7 ^ r7 ^ r3 ^ aes_rotr32(q3 ^ r3);
+    q[4] = q3 ^ r3 ^ q7 ^ r7 ^ r4 ^ aes_rotr32(q4 ^ r4);
+    q[5] = q4 ^ r4 ^ r5 ^ aes_rotr32(q5 ^ r5);
+    q[6] = q5 ^ r5 ^ r6 ^ aes_rotr32(q6 ^ r6);
+    q[7] = q6 ^ r6 ^ r7 ^ aes_rotr32(q7 ^ r7);
+}
+
+/* Encrypts all blocks in the bitsliced state */
+static void aes_encrypt_bitsliced
+    (const aes_bitsliced_state *state, aes_word *q)
+{
+    unsigned round;
+    aes_add_round_key(q, state->sk);
+    for (round = 1; round < state->num_rounds; ++round) {
+        aes_sbox(q);
+        aes_shift_rows(q);
+        aes_mix_columns(q);
+        aes_add_round_key(q, state->sk + (round << 3));
+    }
+    aes_sbox(q);
+    aes_shift_rows(q);
+    aes_add_round_key(q, state->sk + (state->num_rounds << 3));
+}
+
+/* Encrypts a pass of blocks that have been split into 32-bit words */
+static void aes_encrypt_words
+    (const aes_bitsliced_state *state, uint32_t w[AES_PASS_BLOCKS * 4])
+{
+    aes_word q[8];
+    uint64_t q0, q1;
+    int i, lane;
+    for (lane = 0; lane < AES_LANES; ++lane) {
+        for (i = 0; i < 4; ++i) {
+            aes_interleave_in(&q0, &q1, w + (lane << 4) + (i << 2));
+            AES_LANE(q[i], lane) = q0;
+            AES_LANE(q[i + 4], lane) = q1;
+        }
+    }
+    aes_ortho(q);
+    aes_encrypt_bitsliced(state, q);
+    aes_ortho(q);
+    for (lane = 0; lane < AES_LANES; ++lane) {
+        for (i = 0; i < 4; ++i) {
+            aes_interleave_out(w + (lane << 4) + (i << 2),
+                               AES_LANE(q[i], lane), AES_LANE(q[i + 4], lane));
+        }
+    }
+    memset(q, 0, sizeof(q));
+}
+
+/**
+ * \brief Sets up the key schedule for the bitsliced AES engine.
+ *
+ * \param state The state to initialize.
+ * \param key Points to the key.
+ * \param key_len Length of the key in bytes: 16, 24, or 32.
+ *
+ * \return Non-zero if the key was set up, or zero if the key length
+ * is not supported.
+ */
+int aes_bitsliced_setup_key
+    (aes_bitsliced_state *state, const uint8_t *key, size_t key_len)
+{
+    static uint8_t const rcon[10] = {
+        0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1B, 0x36
+    };
+    uint32_t skey[60];
+    uint32_t tmp;
+    unsigned num_rounds;
+    int i, j, k, nk, nkf;
+
+    switch (key_len) {
+    case 16: num_rounds = 10; break;
+    case 24: num_rounds = 12; break;
+    case 32: num_rounds = 14; break;
+    default: return 0;
+    }
+    nk = (int)(key_len >> 2);
+    nkf = (int)((num_rounds + 1) << 2);
+
+    /* Standard AES key expansion, using the bitsliced S-box */
+    for (i = 0; i < nk; ++i)
+        skey[i] = load_le32(key + i * 4);
+    tmp = skey[nk - 1];
+    for (i = nk, j = 0, k = 0; i < nkf; ++i) {
+        if (j == 0) {
+            tmp = (tmp << 24) | (tmp >> 8);
+            tmp = aes_sub_word(tmp) ^ rcon[k];
+        } else if (nk > 6 && j == 4) {
+            tmp = aes_sub_word(tmp);
+        }
+        tmp ^= skey[i - nk];
+        skey[i] = tmp;
+        if (++j == nk) {
+            j = 0;
+            ++k;
+        }
+    }
+
+    /* Convert each round key into bitsliced form, replicated across
+       all four block positions */
+    for (i = 0; i < nkf; i += 4) {
+        aes_word q[8];
+        uint64_t q0, q1;
+        uint64_t *sk = state->sk + (i << 1);
+        memset(q, 0, sizeof(q));
+        aes_interleave_in(&q0, &q1, skey + i);
+        for (j = 0; j < 4; ++j) {
+            AES_LANE(q[j], 0) = q0;
+            AES_LANE(q[j + 4], 0) = q1;
+        }
+        aes_ortho(q);
+        for (j = 0; j < 8; ++j) {
+            const aes_word *g = q + ((j >> 2) << 2);
+            uint64_t x = AES_LANE(g[0], 0) & 0x1111111111111111ULL;
+            x |= AES_LANE(g[1], 0) & 0x2222222222222222ULL;
+            x |= AES_LANE(g[2], 0) & 0x4444444444444444ULL;
+            x |= AES_LANE(g[3], 0) & 0x8888888888888888ULL;
+            x = (x >> (j & 3)) & 0x1111111111111111ULL;
+            sk[j] = (x << 4) - x;
+        }
+    }
+    state->num_rounds = num_rounds;
+    memset(skey, 0, sizeof(skey));
+    return 1;
+}
+
+/**
+ * \brief Encrypts blocks in ECB mode with the bitsliced AES engine.
+ *
+ * \param state The key schedule from aes_bitsliced_setup_key().
+ * \param in Points to the input blocks.
+ * \param out Points to the output blocks, which may be the same as \a in.
+ * \param num_blocks The number of 16-byte blocks to encrypt.
+ */
+void aes_bitsliced_encrypt
+    (const aes_bitsliced_state *state, const uint8_t *in, uint8_t *out,
+     size_t num_blocks)
+{
+    uint32_t w[AES_PASS_BLOCKS * 4];
+    size_t n, i;
+    while (num_blocks > 0) {
+        n = num_blocks < AES_PASS_BLOCKS ? num_blocks : AES_PASS_BLOCKS;
+        memset(w, 0, sizeof(w));
+        for (i = 0; i < n * 4; ++i)
+            w[i] = load_le32(in + i * 4);
+        aes_encrypt_words(state, w);
+        for (i = 0; i < n * 4; ++i)
+            store_le32(out + i * 4, w[i]);
+        in += n * 16;
+        out += n * 16;
+        num_blocks -= n;
+    }
+    memset(w, 0, sizeof(w));
+}
+
+/**
+ * \brief Generates keystream blocks in counter mode with the bitsliced
+ * AES engine.
+ *
+ * \param state The key schedule from aes_bitsliced_setup_key().
+ * \param iv The first 12 bytes of each counter block.
+ * \param counter The value of the big endian 32-bit counter at the end
+ * of the first block.  It is incremented for each following block.
+ * \param keystream Returns the encrypted counter blocks.
+ * \param num_blocks The number of 16-byte blocks to generate, which must
+ * be no more than AES_BITSLICED_CTR_BLOCKS.
+ */
+void aes_bitsliced_ctr
+    (const aes_bitsliced_state *state, const uint8_t iv[12],
+     uint32_t counter, uint8_t *keystream, size_t num_blocks)
+{
+    uint32_t ivw[3];
+    uint32_t w[AES_PASS_BLOCKS * 4];
+    size_t n, i;
+    uint32_t c;
+
+    ivw[0] = load_le32(iv);
+    ivw[1] = load_le32(iv + 4);
+    ivw[2] = load_le32(iv + 8);
+    if (num_blocks > AES_BITSLICED_CTR_BLOCKS)
+        num_blocks = AES_BITSLICED_CTR_BLOCKS;
+    while (num_blocks > 0) {
+        n = num_blocks < AES_PASS_BLOCKS ? num_blocks : AES_PASS_BLOCKS;
+        for (i = 0; i < AES_PASS_BLOCKS; ++i) {
+            c = counter + (uint32_t)i;
+            w[i * 4] = ivw[0];
+            w[i * 4 + 1] = ivw[1];
+            w[i * 4 + 2] = ivw[2];
+            w[i * 4 + 3] = (c >> 24) | ((c >> 8) & 0x0000FF00U) |
+                           ((c << 8) & 0x00FF0000U) | (c << 24);
+        }
+        aes_encrypt_words(state, w);
+        for (i = 0; i < n * 4; ++i)
+            store_le32(keystream + i * 4, w[i]);
+        keystream += n * 16;
+        counter += AES_PASS_BLOCKS;
+        num_blocks -= n;
+    }
+    memset(w, 0, sizeof(w));
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CRYPTO_AES_BITSLICED_h
+#define CRYPTO_AES_BITSLICED_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Maximum number of blocks that aes_bitsliced_ctr() handles per call */
+#define AES_BITSLICED_CTR_BLOCKS 8
+
+/* Expanded key schedule for the bitsliced AES engine.  The round keys are
+   stored pre-bitsliced so that each round only needs 8 XOR's */
+typedef struct {
+    uint64_t sk[8 * 15];
+    unsigned num_rounds;
+} aes_bitsliced_state;
+
+int aes_bitsliced_setup_key
+    (aes_bitsliced_state *state, const uint8_t *key, size_t key_len);
+void aes_bitsliced_encrypt
+    (const aes_bitsliced_state *state, const uint8_t *in, uint8_t *out,
+     size_t num_blocks);
+void aes_bitsliced_ctr
+    (const aes_bitsliced_state *state, const uint8_t iv[12],
+     uint32_t counter, uint8_t *keystream, size_t num_blocks);
+
+#endif
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+    BLAKE2b compression function using AVX2 instructions.  Each row of
+    the 4x4 state of 64-bit words fits in a single 256-bit register, so
+    each half of the round computes all four column (or diagonal)
+    quarter rounds at once.  The whole function is compiled for AVX2 with
+    a target attribute so that the rest of the library can still run on
+    CPUs without it.
+*/
+
+#include "blake2b.h"
+
+#if BLAKE2B_HAVE_AVX2
+
+#include <immintrin.h>
+#include <string.h>
+
+/* Initialization vectors for BLAKE2b */
+#define BLAKE2b_IV0 0x6a09e667f3bcc908ULL
+#define BLAKE2b_IV1 0xbb67ae8584caa73bULL
+#define BLAKE2b_IV2 0x3c6ef372fe94f82bULL
+#define BLAKE2b_IV3 0xa54ff53a5f1d36f1ULL
+#define BLAKE2b_IV4 0x510e527fade682d1ULL
+#define BLAKE2b_IV5 0x9b05688c2b3e6c1fULL
+#define BLAKE2b_IV6 0x1f83d9abfb41bd6bULL
+#define BLAKE2b_IV7 0x5be0cd19137e2179ULL
+
+/* Permutation on the message input state for BLAKE2b */
+static const uint8_t sigma[12][16] = {
+    { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15},
+    {14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3},
+    {11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4},
+    { 7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8},
+    { 9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13},
+    { 2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9},
+    {12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11},
+    {13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10},
+    { 6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5},
+    {10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13 , 0},
+    { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15},
+    {14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3},
+};
+
+/* Load four message words for one half of a round */
+#define loadMessage(i0, i1, i2, i3) \
+    _mm256_setr_epi64x((long long)m[sigma_row[(i0)]], \
+                       (long long)m[sigma_row[(i1)]], \
+                       (long long)m[sigma_row[(i2)]], \
+                       (long long)m[sigma_row[(i3)]])
+
+/* Rotate every 64-bit lane right by a certain number of bits */
+#define rotr32(x) _mm256_shuffle_epi32((x), _MM_SHUFFLE(2, 3, 0, 1))
+#define rotr24(x) _mm256_shuffle_epi8((x), rot24)
+#define rotr16(x) _mm256_shuffle_epi8((x), rot16)
+#define rotr63(x) \
+    _mm256_or_si256(_mm256_srli_epi64((x), 63), _mm256_add_epi64((x), (x)))
+
+/* Perform four BLAKE2b quarter rounds in parallel */
+#define quarterRoundRows(row1, row2, row3, row4, mv0, mv1) \
+    do { \
+        row1 = _mm256_add_epi64(_mm256_add_epi64(row1, mv0), row2); \
+        row4 = rotr32(_mm256_xor_si256(row4, row1)); \
+        row3 = _mm256_add_epi64(row3, row4); \
+        row2 = rotr24(_mm256_xor_si256(row2, row3)); \
+        row1 = _mm256_add_epi64(_mm256_add_epi64(row1, mv1), row2); \
+        row4 = rotr16(_mm256_xor_si256(row4, row1)); \
+        row3 = _mm256_add_epi64(row3, row4); \
+        row2 = rotr63(_mm256_xor_si256(row2, row3)); \
+    } while (0)
+
+__attribute__((target("avx2")))
+void BLAKE2b_transform_avx2
+    (BLAKE2b_context_t *context, const uint8_t *data, uint64_t f0)
+{
+    const __m256i rot24 = _mm256_setr_epi8
+        (3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10,
+         3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10);
+    const __m256i rot16 = _mm256_setr_epi8
+        (2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9,
+         2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9);
+    uint64_t m[16];
+    __m256i row1, row2, row3, row4, mv0, mv1;
+    __m256i h0, h1;
+    const uint8_t *sigma_row;
+    uint8_t index;
+
+    /* x86 is little-endian, so the block can be used as-is */
+    memcpy(m, data, sizeof(m));
+
+    /* Format the block to be hashed */
+    h0 = _mm256_loadu_si256((const __m256i *)&(context->h[0]));
+    h1 = _mm256_loadu_si256((const __m256i *)&(context->h[4]));
+    row1 = h0;
+    row2 = h1;
+    row3 = _mm256_setr_epi64x((long long)BLAKE2b_IV0, (long long)BLAKE2b_IV1,
+                              (long long)BLAKE2b_IV2, (long long)BLAKE2b_IV3);
+    row4 = _mm256_setr_epi64x((long long)(BLAKE2b_IV4 ^ context->length),
+                              (long long)BLAKE2b_IV5,
+                              (long long)(BLAKE2b_IV6 ^ f0),
+                              (long long)BLAKE2b_IV7);
+
+    /* Perform the 12 BLAKE2b rounds */
+    sigma_row = sigma[0];
+    for (index = 0; index < 12; ++index, sigma_row += 16) {
+        /* Column round */
+        mv0 = loadMessage(0, 2, 4, 6);
+        mv1 = loadMessage(1, 3, 5, 7);
+        quarterRoundRows(row1, row2, row3, row4, mv0, mv1);
+
+        /* Rotate the rows so that the diagonals line up as columns */
+        row2 = _mm256_permute4x64_epi64(row2, _MM_SHUFFLE(0, 3, 2, 1));
+        row3 = _mm256_permute4x64_epi64(row3, _MM_SHUFFLE(1, 0, 3, 2));
+        row4 = _mm256_permute4x64_epi64(row4, _MM_SHUFFLE(2, 1, 0, 3));
+
+        /* Diagonal round */
+        mv0 = loadMessage(8, 10, 12, 14);
+        mv1 = loadMessage(9, 11, 13, 15);
+        quarterRoundRows(row1, row2, row3, row4, mv0, mv1);
+
+        /* Put the rows back into their original positions */
+        row2 = _mm256_permute4x64_epi64(row2, _MM_SHUFFLE(2, 1, 0, 3));
+        row3 = _mm256_permute4x64_epi64(row3, _MM_SHUFFLE(1, 0, 3, 2));
+        row4 = _mm256_permute4x64_epi64(row4, _MM_SHUFFLE(0, 3, 2, 1));
+    }
+
+    /* Combine the new and old hash values */
+    h0 = _mm256_xor_si256(h0, _mm256_xor_si256(row1, row3));
+    h1 = _mm256_xor_si256(h1, _mm256_xor_si256(row2, row4));
+    _mm256_storeu_si256((__m256i *)&(context->h[0]), h0);
+    _mm256_storeu_si256((__m256i *)&(context->h[4]), h1);
+}
+
+#endif /* BLAKE2B_HAVE_AVX2 */
@@ -142,7 +142,13 @@ static void blake2b_transform
         context->h[index] ^= (v[index] ^ v[index + 8]);
 }
 
-void BLAKE2b_update(BLAKE2b_context_t *context, const void *data, size_t size)
+/* Function that compresses a single block */
+typedef void (*blake2b_transform_t)
+    (BLAKE2b_context_t *context, const uint8_t *data, uint64_t f0);
+
+static void blake2b_update
+    (BLAKE2b_context_t *context, const void *data, size_t size,
+     blake2b_transform_t transform)
 {
     /* Break the input up into 512-bit chunks and process each in turn */
     const uint8_t *d = (const uint8_t *)data;
@@ -151,13 +157,13 @@ void BLAKE2b_update(BLAKE2b_context_t *context, const void *data, size_t size)
         if (context->posn == 128) {
             /* Previous chunk was full and we know that it wasn't the
                last chunk, so we can process it now with f0 set to zero. */
-            blake2b_transform(context, context->m, 0);
+            (*transform)(context, context->m, 0);
             context->posn = 0;
         }
         if (size > 128 && context->posn == 0) {
             /* This chunk can be processed directly from the input buffer */
             context->length += 128;
-            blake2b_transform(context, d, 0);
+            (*transform)(context, d, 0);
             d += 128;
             size -= 128;
         } else {
@@ -174,11 +180,13 @@ void BLAKE2b_update(BLAKE2b_context_t *context, const void *data, size_t size)
     }
 }
 
-void BLAKE2b_finish(BLAKE2b_context_t *context, uint8_t *hash)
+static void blake2b_finish
+    (BLAKE2b_context_t *context, uint8_t *hash,
+     blake2b_transform_t transform)
 {
     /* Pad the last chunk and hash it with f0 set to all-ones */
     memset(context->m + context->posn, 0, 128 - context->posn);
-    blake2b_transform(context, context->m, 0xFFFFFFFFFFFFFFFF);
+    (*transform)(context, context->m, 0xFFFFFFFFFFFFFFFF);
 
     /* Copy the hash to the caller's return buffer in little-endian */
 #if BLAKE2_LITTLE_ENDIAN
@@ -200,3 +208,28 @@ void BLAKE2b_finish(BLAKE2b_context_t *context, uint8_t *hash)
     }
 #endif
 }
+
+void BLAKE2b_update(BLAKE2b_context_t *context, const void *data, size_t size)
+{
+    blake2b_update(context, data, size, blake2b_transform);
+}
+
+void BLAKE2b_finish(BLAKE2b_context_t *context, uint8_t *hash)
+{
+    blake2b_finish(context, hash, blake2b_transform);
+}
+
+#if BLAKE2B_HAVE_AVX2
+
+void BLAKE2b_update_avx2
+    (BLAKE2b_context_t *context, const void *data, size_t size)
+{
+    blake2b_update(context, data, size, BLAKE2b_transform_avx2);
+}
+
+void BLAKE2b_finish_avx2(BLAKE2b_context_t *context, uint8_t *hash)
+{
+    blake2b_finish(context, hash, BLAKE2b_transform_avx2);
+}
+
+#endif
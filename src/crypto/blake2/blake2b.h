@@ -43,6 +43,18 @@ void BLAKE2b_reset(BLAKE2b_context_t *context);
 void BLAKE2b_update(BLAKE2b_context_t *context, const void *data, size_t size);
 void BLAKE2b_finish(BLAKE2b_context_t *context, uint8_t *hash);
 
+/* AVX2 versions of the functions above.  The caller is responsible
+   for checking that the CPU supports AVX2 before calling them */
+#if (defined(__GNUC__) || defined(__clang__)) && \
+        (defined(__x86_64__) || defined(__i386__))
+#define BLAKE2B_HAVE_AVX2 1
+void BLAKE2b_update_avx2
+    (BLAKE2b_context_t *context, const void *data, size_t size);
+void BLAKE2b_finish_avx2(BLAKE2b_context_t *context, uint8_t *hash);
+void BLAKE2b_transform_avx2
+    (BLAKE2b_context_t *context, const uint8_t *data, uint64_t f0);
+#endif
+
 #ifdef __cplusplus
 };
 #endif
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+    BLAKE2s compression function using AVX2 instructions.  The 4x4 state
+    is kept as four rows of 128-bit vectors so that each half of the
+    round computes all four column (or diagonal) quarter rounds at once.
+    The 16-bit and 8-bit rotations use byte shuffles.  The whole function
+    is compiled for AVX2 with a target attribute so that the rest of the
+    library can still run on CPUs without it.
+*/
+
+#include "blake2s.h"
+
+#if BLAKE2S_HAVE_AVX2
+
+#include <immintrin.h>
+#include <string.h>
+
+#define BLAKE2s_IV0 0x6A09E667
+#define BLAKE2s_IV1 0xBB67AE85
+#define BLAKE2s_IV2 0x3C6EF372
+#define BLAKE2s_IV3 0xA54FF53A
+#define BLAKE2s_IV4 0x510E527F
+#define BLAKE2s_IV5 0x9B05688C
+#define BLAKE2s_IV6 0x1F83D9AB
+#define BLAKE2s_IV7 0x5BE0CD19
+
+/* Permutation on the message input state for BLAKE2s */
+static const uint8_t sigma[10][16] = {
+    { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15},
+    {14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3},
+    {11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4},
+    { 7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8},
+    { 9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13},
+    { 2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9},
+    {12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11},
+    {13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10},
+    { 6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5},
+    {10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13 , 0}
+};
+
+/* Load four message words for one half of a round */
+#define loadMessage(i0, i1, i2, i3) \
+    _mm_setr_epi32((int)m[sigma_row[(i0)]], (int)m[sigma_row[(i1)]], \
+                   (int)m[sigma_row[(i2)]], (int)m[sigma_row[(i3)]])
+
+/* Rotate every 32-bit lane right by a certain number of bits */
+#define rotr16(x) _mm_shuffle_epi8((x), rot16)
+#define rotr8(x)  _mm_shuffle_epi8((x), rot8)
+#define rotr(x, n) \
+    _mm_or_si128(_mm_srli_epi32((x), (n)), _mm_slli_epi32((x), 32 - (n)))
+
+/* Perform four BLAKE2s quarter rounds in parallel */
+#define quarterRoundRows(row1, row2, row3, row4, mv0, mv1) \
+    do { \
+        row1 = _mm_add_epi32(_mm_add_epi32(row1, mv0), row2); \
+        row4 = rotr16(_mm_xor_si128(row4, row1)); \
+        row3 = _mm_add_epi32(row3, row4); \
+        row2 = rotr(_mm_xor_si128(row2, row3), 12); \
+        row1 = _mm_add_epi32(_mm_add_epi32(row1, mv1), row2); \
+        row4 = rotr8(_mm_xor_si128(row4, row1)); \
+        row3 = _mm_add_epi32(row3, row4); \
+        row2 = rotr(_mm_xor_si128(row2, row3), 7); \
+    } while (0)
+
+__attribute__((target("avx2")))
+void BLAKE2s_transform_avx2
+    (BLAKE2s_context_t *context, const uint8_t *data, uint32_t f0)
+{
+    const __m128i rot16 = _mm_setr_epi8
+        (2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    const __m128i rot8 = _mm_setr_epi8
+        (1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12);
+    uint32_t m[16];
+    __m128i row1, row2, row3, row4, mv0, mv1;
+    __m128i h0, h1;
+    const uint8_t *sigma_row;
+    uint8_t index;
+
+    /* x86 is little-endian, so the block can be used as-is */
+    memcpy(m, data, sizeof(m));
+
+    /* Format the block to be hashed */
+    h0 = _mm_loadu_si128((const __m128i *)&(context->h[0]));
+    h1 = _mm_loadu_si128((const __m128i *)(((const uint32_t *)context->h) + 4));
+    row1 = h0;
+    row2 = h1;
+    row3 = _mm_setr_epi32((int)BLAKE2s_IV0, (int)BLAKE2s_IV1,
+                          (int)BLAKE2s_IV2, (int)BLAKE2s_IV3);
+    row4 = _mm_setr_epi32((int)(BLAKE2s_IV4 ^ (uint32_t)(context->length)),
+                          (int)(BLAKE2s_IV5 ^ (uint32_t)(context->length >> 32)),
+                          (int)(BLAKE2s_IV6 ^ f0), (int)BLAKE2s_IV7);
+
+    /* Perform the 10 BLAKE2s rounds */
+    sigma_row = sigma[0];
+    for (index = 0; index < 10; ++index, sigma_row += 16) {
+        /* Column round */
+        mv0 = loadMessage(0, 2, 4, 6);
+        mv1 = loadMessage(1, 3, 5, 7);
+        quarterRoundRows(row1, row2, row3, row4, mv0, mv1);
+
+        /* Rotate the rows so that the diagonals line up as columns */
+        row2 = _mm_shuffle_epi32(row2, _MM_SHUFFLE(0, 3, 2, 1));
+        row3 = _mm_shuffle_epi32(row3, _MM_SHUFFLE(1, 0, 3, 2));
+        row4 = _mm_shuffle_epi32(row4, _MM_SHUFFLE(2, 1, 0, 3));
+
+        /* Diagonal round */
+        mv0 = loadMessage(8, 10, 12, 14);
+        mv1 = loadMessage(9, 11, 13, 15);
+        quarterRoundRows(row1, row2, row3, row4, mv0, mv1);
+
+        /* Put the rows back into their original positions */
+        row2 = _mm_shuffle_epi32(row2, _MM_SHUFFLE(2, 1, 0, 3));
+        row3 = _mm_shuffle_epi32(row3, _MM_SHUFFLE(1, 0, 3, 2));
+        row4 = _mm_shuffle_epi32(row4, _MM_SHUFFLE(0, 3, 2, 1));
+    }
+
+    /* Combine the new and old hash values */
+    h0 = _mm_xor_si128(h0, _mm_xor_si128(row1, row3));
+    h1 = _mm_xor_si128(h1, _mm_xor_si128(row2, row4));
+    _mm_storeu_si128((__m128i *)&(context->h[0]), h0);
+    _mm_storeu_si128((__m128i *)(((uint32_t *)context->h) + 4), h1);
+}
+
+#endif /* BLAKE2S_HAVE_AVX2 */
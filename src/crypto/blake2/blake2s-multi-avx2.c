@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+    Multi-buffer BLAKE2s compression function using AVX2.
+
+    Eight independent BLAKE2s contexts are compressed at once, with one
+    32-bit lane of each 256-bit register belonging to each context.
+    The 16 working variables each get a register of their own, so the
+    column and diagonal quarter rounds need no shuffling between them.
+    The hash states and message blocks are transposed into this layout
+    with an 8x8 word transpose.  The function is compiled with a target
+    attribute so that the rest of the library can still run on CPUs
+    without AVX2.
+*/
+
+#include "blake2s.h"
+
+#if BLAKE2S_HAVE_AVX2
+
+#include <immintrin.h>
+
+#define BLAKE2s_IV0 0x6A09E667
+#define BLAKE2s_IV1 0xBB67AE85
+#define BLAKE2s_IV2 0x3C6EF372
+#define BLAKE2s_IV3 0xA54FF53A
+#define BLAKE2s_IV4 0x510E527F
+#define BLAKE2s_IV5 0x9B05688C
+#define BLAKE2s_IV6 0x1F83D9AB
+#define BLAKE2s_IV7 0x5BE0CD19
+
+/* Permutation on the message input state for BLAKE2s */
+static const uint8_t sigma[10][16] = {
+    { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15},
+    {14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3},
+    {11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4},
+    { 7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8},
+    { 9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13},
+    { 2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9},
+    {12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11},
+    {13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10},
+    { 6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5},
+    {10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13 , 0}
+};
+
+/* Transpose an 8x8 matrix of 32-bit words held in eight registers */
+#define transpose8x8(r0, r1, r2, r3, r4, r5, r6, r7) \
+    do { \
+        __m256i t0 = _mm256_unpacklo_epi32((r0), (r1)); \
+        __m256i t1 = _mm256_unpackhi_epi32((r0), (r1)); \
+        __m256i t2 = _mm256_unpacklo_epi32((r2), (r3)); \
+        __m256i t3 = _mm256_unpackhi_epi32((r2), (r3)); \
+        __m256i t4 = _mm256_unpacklo_epi32((r4), (r5)); \
+        __m256i t5 = _mm256_unpackhi_epi32((r4), (r5)); \
+        __m256i t6 = _mm256_unpacklo_epi32((r6), (r7)); \
+        __m256i t7 = _mm256_unpackhi_epi32((r6), (r7)); \
+        __m256i u0 = _mm256_unpacklo_epi64(t0, t2); \
+        __m256i u1 = _mm256_unpackhi_epi64(t0, t2); \
+        __m256i u2 = _mm256_unpacklo_epi64(t1, t3); \
+        __m256i u3 = _mm256_unpackhi_epi64(t1, t3); \
+        __m256i u4 = _mm256_unpacklo_epi64(t4, t6); \
+        __m256i u5 = _mm256_unpackhi_epi64(t4, t6); \
+        __m256i u6 = _mm256_unpacklo_epi64(t5, t7); \
+        __m256i u7 = _mm256_unpackhi_epi64(t5, t7); \
+        (r0) = _mm256_permute2x128_si256(u0, u4, 0x20); \
+        (r1) = _mm256_permute2x128_si256(u1, u5, 0x20); \
+        (r2) = _mm256_permute2x128_si256(u2, u6, 0x20); \
+        (r3) = _mm256_permute2x128_si256(u3, u7, 0x20); \
+        (r4) = _mm256_permute2x128_si256(u0, u4, 0x31); \
+        (r5) = _mm256_permute2x128_si256(u1, u5, 0x31); \
+        (r6) = _mm256_permute2x128_si256(u2, u6, 0x31); \
+        (r7) = _mm256_permute2x128_si256(u3, u7, 0x31); \
+    } while (0)
+
+/* Load 32 bytes from each of the eight blocks and transpose them into
+   eight registers of message words, one lane per block */
+#define loadWords(w, offset) \
+    do { \
+        (w)[0] = _mm256_loadu_si256((const __m256i *)(blocks[0] + (offset))); \
+        (w)[1] = _mm256_loadu_si256((const __m256i *)(blocks[1] + (offset))); \
+        (w)[2] = _mm256_loadu_si256((const __m256i *)(blocks[2] + (offset))); \
+        (w)[3] = _mm256_loadu_si256((const __m256i *)(blocks[3] + (offset))); \
+        (w)[4] = _mm256_loadu_si256((const __m256i *)(blocks[4] + (offset))); \
+        (w)[5] = _mm256_loadu_si256((const __m256i *)(blocks[5] + (offset))); \
+        (w)[6] = _mm256_loadu_si256((const __m256i *)(blocks[6] + (offset))); \
+        (w)[7] = _mm256_loadu_si256((const __m256i *)(blocks[7] + (offset))); \
+        transpose8x8((w)[0], (w)[1], (w)[2], (w)[3], \
+                     (w)[4], (w)[5], (w)[6], (w)[7]); \
+    } while (0)
+
+/* Rotate every 32-bit lane right by a certain number of bits */
+#define rotr16(x) _mm256_shuffle_epi8((x), rot16)
+#define rotr8(x)  _mm256_shuffle_epi8((x), rot8)
+#define rotr(x, n) \
+    _mm256_or_si256(_mm256_srli_epi32((x), (n)), _mm256_slli_epi32((x), 32 - (n)))
+
+/* Perform a BLAKE2s quarter round operation on all eight lanes */
+#define quarterRound(a, b, c, d, i) \
+    do { \
+        (a) = _mm256_add_epi32 \
+            (_mm256_add_epi32((a), (b)), m[sigma_row[2 * (i)]]); \
+        (d) = rotr16(_mm256_xor_si256((d), (a))); \
+        (c) = _mm256_add_epi32((c), (d)); \
+        (b) = rotr(_mm256_xor_si256((b), (c)), 12); \
+        (a) = _mm256_add_epi32 \
+            (_mm256_add_epi32((a), (b)), m[sigma_row[2 * (i) + 1]]); \
+        (d) = rotr8(_mm256_xor_si256((d), (a))); \
+        (c) = _mm256_add_epi32((c), (d)); \
+        (b) = rotr(_mm256_xor_si256((b), (c)), 7); \
+    } while (0)
+
+/* Lane-wise 32-bit values taken from the length fields of the contexts */
+#define lengthWords(shift) \
+    _mm256_setr_epi32((int)(uint32_t)(contexts[0]->length >> (shift)), \
+                      (int)(uint32_t)(contexts[1]->length >> (shift)), \
+                      (int)(uint32_t)(contexts[2]->length >> (shift)), \
+                      (int)(uint32_t)(contexts[3]->length >> (shift)), \
+                      (int)(uint32_t)(contexts[4]->length >> (shift)), \
+                      (int)(uint32_t)(contexts[5]->length >> (shift)), \
+                      (int)(uint32_t)(contexts[6]->length >> (shift)), \
+                      (int)(uint32_t)(contexts[7]->length >> (shift)))
+
+__attribute__((target("avx2")))
+void BLAKE2s_transform_x8_avx2
+    (BLAKE2s_context_t **contexts, const uint8_t **blocks, uint32_t f0)
+{
+    const __m256i rot16 = _mm256_setr_epi8
+        (2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+         2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    const __m256i rot8 = _mm256_setr_epi8
+        (1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12,
+         1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12);
+    __m256i m[16];
+    __m256i h[8];
+    __m256i v0, v1, v2, v3, v4, v5, v6, v7;
+    __m256i v8, v9, v10, v11, v12, v13, v14, v15;
+    const uint8_t *sigma_row;
+    uint8_t index;
+
+    /* Transpose the hash states so that each register holds one word
+       of the state from all eight contexts */
+    for (index = 0; index < 8; ++index)
+        h[index] = _mm256_loadu_si256((const __m256i *)(contexts[index]->h));
+    transpose8x8(h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7]);
+
+    /* Load the 16 message words from each block; x86 is little-endian
+       so no byte swapping is required */
+    loadWords(m, 0);
+    loadWords(m + 8, 32);
+
+    /* Format the blocks to be hashed */
+    v0 = h[0]; v1 = h[1]; v2 = h[2]; v3 = h[3];
+    v4 = h[4]; v5 = h[5]; v6 = h[6]; v7 = h[7];
+    v8  = _mm256_set1_epi32((int)BLAKE2s_IV0);
+    v9  = _mm256_set1_epi32((int)BLAKE2s_IV1);
+    v10 = _mm256_set1_epi32((int)BLAKE2s_IV2);
+    v11 = _mm256_set1_epi32((int)BLAKE2s_IV3);
+    v12 = _mm256_xor_si256(_mm256_set1_epi32((int)BLAKE2s_IV4), lengthWords(0));
+    v13 = _mm256_xor_si256(_mm256_set1_epi32((int)BLAKE2s_IV5), lengthWords(32));
+    v14 = _mm256_set1_epi32((int)(BLAKE2s_IV6 ^ f0));
+    v15 = _mm256_set1_epi32((int)BLAKE2s_IV7);
+
+    /* Perform the 10 BLAKE2s rounds */
+    sigma_row = sigma[0];
+    for (index = 0; index < 10; ++index, sigma_row += 16) {
+        /* Column round */
+        quarterRound(v0, v4, v8,  v12, 0);
+        quarterRound(v1, v5, v9,  v13, 1);
+        quarterRound(v2, v6, v10, v14, 2);
+        quarterRound(v3, v7, v11, v15, 3);
+
+        /* Diagonal round */
+        quarterRound(v0, v5, v10, v15, 4);
+        quarterRound(v1, v6, v11, v12, 5);
+        quarterRound(v2, v7, v8,  v13, 6);
+        quarterRound(v3, v4, v9,  v14, 7);
+    }
+
+    /* Combine the new and old hash values and transpose them back
+       into the per-context layout */
+    h[0] = _mm256_xor_si256(h[0], _mm256_xor_si256(v0, v8));
+    h[1] = _mm256_xor_si256(h[1], _mm256_xor_si256(v1, v9));
+    h[2] = _mm256_xor_si256(h[2], _mm256_xor_si256(v2, v10));
+    h[3] = _mm256_xor_si256(h[3], _mm256_xor_si256(v3, v11));
+    h[4] = _mm256_xor_si256(h[4], _mm256_xor_si256(v4, v12));
+    h[5] = _mm256_xor_si256(h[5], _mm256_xor_si256(v5, v13));
+    h[6] = _mm256_xor_si256(h[6], _mm256_xor_si256(v6, v14));
+    h[7] = _mm256_xor_si256(h[7], _mm256_xor_si256(v7, v15));
+    transpose8x8(h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7]);
+    for (index = 0; index < 8; ++index)
+        _mm256_storeu_si256((__m256i *)(contexts[index]->h), h[index]);
+}
+
+#endif /* BLAKE2S_HAVE_AVX2 */
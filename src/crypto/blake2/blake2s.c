@@ -210,7 +210,13 @@ static void blake2s_transform
 #endif /* !BLAKE2S_USE_VECTOR_MATH */
 }
 
-void BLAKE2s_update(BLAKE2s_context_t *context, const void *data, size_t size)
+/* Function that compresses a single block */
+typedef void (*blake2s_transform_t)
+    (BLAKE2s_context_t *context, const uint8_t *data, uint32_t f0);
+
+static void blake2s_update
+    (BLAKE2s_context_t *context, const void *data, size_t size,
+     blake2s_transform_t transform)
 {
     /* Break the input up into 512-bit chunks and process each in turn */
     const uint8_t *d = (const uint8_t *)data;
@@ -219,13 +225,13 @@ void BLAKE2s_update(BLAKE2s_context_t *context, const void *data, size_t size)
         if (context->posn == 64) {
             /* Previous chunk was full and we know that it wasn't the
                last chunk, so we can process it now with f0 set to zero. */
-            blake2s_transform(context, context->m, 0);
+            (*transform)(context, context->m, 0);
             context->posn = 0;
         }
         if (size > 64 && context->posn == 0) {
             /* This chunk can be processed directly from the input buffer */
             context->length += 64;
-            blake2s_transform(context, d, 0);
+            (*transform)(context, d, 0);
             d += 64;
             size -= 64;
         } else {
@@ -242,11 +248,13 @@ void BLAKE2s_update(BLAKE2s_context_t *context, const void *data, size_t size)
     }
 }
 
-void BLAKE2s_finish(BLAKE2s_context_t *context, uint8_t *hash)
+static void blake2s_finish
+    (BLAKE2s_context_t *context, uint8_t *hash,
+     blake2s_transform_t transform)
 {
     /* Pad the last chunk and hash it with f0 set to all-ones */
     memset(context->m + context->posn, 0, 64 - context->posn);
-    blake2s_transform(context, context->m, 0xFFFFFFFF);
+    (*transform)(context, context->m, 0xFFFFFFFF);
 
     /* Copy the hash to the caller's return buffer in little-endian */
 #if BLAKE2_LITTLE_ENDIAN
@@ -264,3 +272,130 @@ void BLAKE2s_finish(BLAKE2s_context_t *context, uint8_t *hash)
     }
 #endif
 }
+
+void BLAKE2s_update(BLAKE2s_context_t *context, const void *data, size_t size)
+{
+    blake2s_update(context, data, size, blake2s_transform);
+}
+
+void BLAKE2s_finish(BLAKE2s_context_t *context, uint8_t *hash)
+{
+    blake2s_finish(context, hash, blake2s_transform);
+}
+
+#if BLAKE2S_HAVE_AVX2
+
+void BLAKE2s_update_avx2
+    (BLAKE2s_context_t *context, const void *data, size_t size)
+{
+    blake2s_update(context, data, size, BLAKE2s_transform_avx2);
+}
+
+void BLAKE2s_finish_avx2(BLAKE2s_context_t *context, uint8_t *hash)
+{
+    blake2s_finish(context, hash, BLAKE2s_transform_avx2);
+}
+
+/* Determine if a set of contexts can be advanced in parallel lanes */
+static int blake2s_lanes_in_sync(BLAKE2s_context_t **contexts, unsigned count)
+{
+    unsigned lane;
+    if (count < 1 || count > BLAKE2S_MAX_LANES)
+        return 0;
+    for (lane = 1; lane < count; ++lane) {
+        if (contexts[lane]->posn != contexts[0]->posn)
+            return 0;
+    }
+    return 1;
+}
+
+/* Fill out the unused lanes with a scratch context */
+static void blake2s_fill_lanes
+    (BLAKE2s_context_t **lanes, BLAKE2s_context_t **contexts,
+     unsigned count, BLAKE2s_context_t *scratch)
+{
+    unsigned lane;
+    BLAKE2s_reset(scratch);
+    for (lane = 0; lane < BLAKE2S_MAX_LANES; ++lane)
+        lanes[lane] = (lane < count) ? contexts[lane] : scratch;
+}
+
+int BLAKE2s_update_multi_avx2
+    (BLAKE2s_context_t **contexts, const uint8_t **data, size_t size,
+     unsigned count)
+{
+    BLAKE2s_context_t *lanes[BLAKE2S_MAX_LANES];
+    const uint8_t *blocks[BLAKE2S_MAX_LANES];
+    BLAKE2s_context_t scratch;
+    size_t offset = 0;
+    size_t len;
+    unsigned posn, lane;
+
+    if (!blake2s_lanes_in_sync(contexts, count))
+        return 0;
+    blake2s_fill_lanes(lanes, contexts, count, &scratch);
+    posn = contexts[0]->posn;
+    while (size > 0) {
+        if (posn == 64) {
+            /* Previous chunks were full and we know that they weren't
+               the last chunks, so we can process them now */
+            for (lane = 0; lane < BLAKE2S_MAX_LANES; ++lane)
+                blocks[lane] = lanes[lane]->m;
+            BLAKE2s_transform_x8_avx2(lanes, blocks, 0);
+            posn = 0;
+        }
+        if (size > 64 && posn == 0) {
+            /* These chunks can be processed directly from the input */
+            for (lane = 0; lane < BLAKE2S_MAX_LANES; ++lane)
+                blocks[lane] = data[lane < count ? lane : 0] + offset;
+            for (lane = 0; lane < count; ++lane)
+                contexts[lane]->length += 64;
+            BLAKE2s_transform_x8_avx2(lanes, blocks, 0);
+            offset += 64;
+            size -= 64;
+        } else {
+            /* Buffer the blocks for later */
+            len = 64 - posn;
+            if (len > size)
+                len = size;
+            for (lane = 0; lane < count; ++lane) {
+                memcpy(contexts[lane]->m + posn, data[lane] + offset, len);
+                contexts[lane]->length += len;
+            }
+            posn += len;
+            offset += len;
+            size -= len;
+        }
+    }
+    for (lane = 0; lane < count; ++lane)
+        contexts[lane]->posn = (uint8_t)posn;
+    return 1;
+}
+
+int BLAKE2s_finish_multi_avx2
+    (BLAKE2s_context_t **contexts, uint8_t **hashes, unsigned count)
+{
+    BLAKE2s_context_t *lanes[BLAKE2S_MAX_LANES];
+    const uint8_t *blocks[BLAKE2S_MAX_LANES];
+    BLAKE2s_context_t scratch;
+    unsigned posn, lane;
+
+    if (!blake2s_lanes_in_sync(contexts, count))
+        return 0;
+    blake2s_fill_lanes(lanes, contexts, count, &scratch);
+
+    /* Pad the last chunks and hash them with f0 set to all-ones */
+    posn = contexts[0]->posn;
+    for (lane = 0; lane < BLAKE2S_MAX_LANES; ++lane) {
+        memset(lanes[lane]->m + posn, 0, 64 - posn);
+        blocks[lane] = lanes[lane]->m;
+    }
+    BLAKE2s_transform_x8_avx2(lanes, blocks, 0xFFFFFFFF);
+
+    /* Copy the hashes to the caller's return buffers; x86 is little-endian */
+    for (lane = 0; lane < count; ++lane)
+        memcpy(hashes[lane], contexts[lane]->h, sizeof(contexts[lane]->h));
+    return 1;
+}
+
+#endif
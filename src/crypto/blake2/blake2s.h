@@ -54,6 +54,32 @@ void BLAKE2s_reset(BLAKE2s_context_t *context);
 void BLAKE2s_update(BLAKE2s_context_t *context, const void *data, size_t size);
 void BLAKE2s_finish(BLAKE2s_context_t *context, uint8_t *hash);
 
+/* AVX2 versions of the functions above.  The caller is responsible
+   for checking that the CPU supports AVX2 before calling them */
+#if (defined(__GNUC__) || defined(__clang__)) && \
+        (defined(__x86_64__) || defined(__i386__)) && \
+        !defined(NOISE_SINGLE_SUITE)
+#define BLAKE2S_HAVE_AVX2 1
+void BLAKE2s_update_avx2
+    (BLAKE2s_context_t *context, const void *data, size_t size);
+void BLAKE2s_finish_avx2(BLAKE2s_context_t *context, uint8_t *hash);
+void BLAKE2s_transform_avx2
+    (BLAKE2s_context_t *context, const uint8_t *data, uint32_t f0);
+
+/* Multi-buffer versions that advance up to BLAKE2S_MAX_LANES independent
+   contexts in the lanes of AVX2 registers.  All contexts must be at the
+   same position within their current block; the functions return zero
+   without doing anything if they are not */
+#define BLAKE2S_MAX_LANES 8
+int BLAKE2s_update_multi_avx2
+    (BLAKE2s_context_t **contexts, const uint8_t **data, size_t size,
+     unsigned count);
+int BLAKE2s_finish_multi_avx2
+    (BLAKE2s_context_t **contexts, uint8_t **hashes, unsigned count);
+void BLAKE2s_transform_x8_avx2
+    (BLAKE2s_context_t **contexts, const uint8_t **blocks, uint32_t f0);
+#endif
+
 #ifdef __cplusplus
 };
 #endif
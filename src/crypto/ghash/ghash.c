@@ -22,192 +22,197 @@
 
 #include "ghash.h"
 #include <string.h>
-#if defined(__WIN32__) || defined(WIN32)
-#ifndef __BIG_ENDIAN
-#define __BIG_ENDIAN 4321
-#endif
-#ifndef __LITTLE_ENDIAN
-#define __LITTLE_ENDIAN 1234
-#endif
-#ifndef __BYTE_ORDER
-#define __BYTE_ORDER __LITTLE_ENDIAN
-#endif
-#else
-#include <endian.h>
-#endif
-
-#if defined(GHASH_WORD64)
-
-/* 64-bit version of GHASH */
-
-static uint64_t swapEndian(uint64_t x)
-{
-#if __BYTE_ORDER == __BIG_ENDIAN
-    return x;
-#else
-    return ((x >> 56) & 0x00000000000000FF) |
-           ((x >> 40) & 0x000000000000FF00) |
-           ((x >> 24) & 0x0000000000FF0000) |
-           ((x >>  8) & 0x00000000FF000000) |
-           ((x <<  8) & 0x000000FF00000000) |
-           ((x << 24) & 0x0000FF0000000000) |
-           ((x << 40) & 0x00FF000000000000) |
-           ((x << 56) & 0xFF00000000000000);
-#endif
-}
 
-static void GF128_mulInit(uint64_t H[2], const void *key)
+/*
+    GHASH multiplies in GF(2^128) with a constant-time word-level
+    carryless multiply, adapted from the "ctmul64" method in BearSSL.
+
+    Plain integer multiplication is used to compute carryless products of
+    64-bit words.  Each operand is split into four masks with a hole of
+    three zero bits between the data bits, so that the carries from each
+    column of partial products fall into the holes and can be masked away.
+    The 128x128 product is assembled from three 64x64 products (Karatsuba),
+    and the upper halves come from multiplying the bit-reversed operands.
+
+    There are no secret-dependent branches or table lookups, and a block
+    costs a few dozen multiplies instead of the 128 iterations of the
+    bit-by-bit method that this replaces.
+*/
+
+static uint64_t load_be64(const uint8_t *buf)
 {
-    /* Copy the key into H and convert from big endian to host order */
-    memcpy(H, key, 16);
-    H[0] = swapEndian(H[0]);
-    H[1] = swapEndian(H[1]);
+    return (((uint64_t)(buf[0])) << 56) |
+           (((uint64_t)(buf[1])) << 48) |
+           (((uint64_t)(buf[2])) << 40) |
+           (((uint64_t)(buf[3])) << 32) |
+           (((uint64_t)(buf[4])) << 24) |
+           (((uint64_t)(buf[5])) << 16) |
+           (((uint64_t)(buf[6])) << 8) |
+            ((uint64_t)(buf[7]));
 }
 
-static void GF128_mul(uint64_t Y[2], const uint64_t H[2])
+static void store_be64(uint8_t *buf, uint64_t x)
 {
-    uint64_t Z0 = 0;        /* Z = 0 */
-    uint64_t Z1 = 0;
-    uint64_t V0 = H[0];     /* V = H */
-    uint64_t V1 = H[1];
-
-    /* Multiply Z by V for the set bits in Y, starting at the top.
-       This is a very simple bit by bit version that may not be very
-       fast but it should be resistant to cache timing attacks. */
-    for (uint8_t posn = 0; posn < 16; ++posn) {
-        uint8_t value = ((const uint8_t *)Y)[posn];
-        for (uint8_t bit = 0; bit < 8; ++bit, value <<= 1) {
-            /* Extract the high bit of "value" and turn it into a mask */
-            uint64_t mask = (~((uint64_t)(value >> 7))) + 1;
-
-            /* XOR V with Z if the bit is 1 */
-            Z0 ^= (V0 & mask);
-            Z1 ^= (V1 & mask);
-
-            /* Rotate V right by 1 bit */
-            mask = ((~(V1 & 0x01)) + 1) & 0xE100000000000000ULL;
-            V1 = (V1 >> 1) | (V0 << 63);
-            V0 = (V0 >> 1) ^ mask;
-        }
-    }
-
-    /* We have finished the block so copy Z into Y and byte-swap */
-    Y[0] = swapEndian(Z0);
-    Y[1] = swapEndian(Z1);
+    buf[0] = (uint8_t)(x >> 56);
+    buf[1] = (uint8_t)(x >> 48);
+    buf[2] = (uint8_t)(x >> 40);
+    buf[3] = (uint8_t)(x >> 32);
+    buf[4] = (uint8_t)(x >> 24);
+    buf[5] = (uint8_t)(x >> 16);
+    buf[6] = (uint8_t)(x >> 8);
+    buf[7] = (uint8_t)x;
 }
 
-#else /* GHASH_WORD32 */
-
-/* Default 32-bit version of GHASH */
-
-static uint32_t swapEndian(uint32_t x)
+/* Carryless multiply of two 64-bit values, keeping the low 64 bits */
+static uint64_t bmul64(uint64_t x, uint64_t y)
 {
-#if __BYTE_ORDER == __BIG_ENDIAN
-    return x;
-#else
-    return ((x >> 24) & 0x000000FF) |
-           ((x >>  8) & 0x0000FF00) |
-           ((x <<  8) & 0x00FF0000) |
-           ((x << 24) & 0xFF000000);
-#endif
+    uint64_t x0, x1, x2, x3;
+    uint64_t y0, y1, y2, y3;
+    uint64_t z0, z1, z2, z3;
+
+    x0 = x & 0x1111111111111111ULL;
+    x1 = x & 0x2222222222222222ULL;
+    x2 = x & 0x4444444444444444ULL;
+    x3 = x & 0x8888888888888888ULL;
+    y0 = y & 0x1111111111111111ULL;
+    y1 = y & 0x2222222222222222ULL;
+    y2 = y & 0x4444444444444444ULL;
+    y3 = y & 0x8888888888888888ULL;
+    z0 = (x0 * y0) ^ (x1 * y3) ^ (x2 * y2) ^ (x3 * y1);
+    z1 = (x0 * y1) ^ (x1 * y0) ^ (x2 * y3) ^ (x3 * y2);
+    z2 = (x0 * y2) ^ (x1 * y1) ^ (x2 * y0) ^ (x3 * y3);
+    z3 = (x0 * y3) ^ (x1 * y2) ^ (x2 * y1) ^ (x3 * y0);
+    z0 &= 0x1111111111111111ULL;
+    z1 &= 0x2222222222222222ULL;
+    z2 &= 0x4444444444444444ULL;
+    z3 &= 0x8888888888888888ULL;
+    return z0 | z1 | z2 | z3;
 }
 
-static void GF128_mulInit(uint32_t H[4], const void *key)
+/* Reverses the order of the bits in a 64-bit value */
+static uint64_t rev64(uint64_t x)
 {
-    /* Copy the key into H and convert from big endian to host order */
-    memcpy(H, key, 16);
-    H[0] = swapEndian(H[0]);
-    H[1] = swapEndian(H[1]);
-    H[2] = swapEndian(H[2]);
-    H[3] = swapEndian(H[3]);
+#define RMS(m, s) \
+    (x = ((x & (uint64_t)(m)) << (s)) | ((x >> (s)) & (uint64_t)(m)))
+    RMS(0x5555555555555555ULL, 1);
+    RMS(0x3333333333333333ULL, 2);
+    RMS(0x0F0F0F0F0F0F0F0FULL, 4);
+    RMS(0x00FF00FF00FF00FFULL, 8);
+    RMS(0x0000FFFF0000FFFFULL, 16);
+#undef RMS
+    return (x << 32) | (x >> 32);
 }
 
-static void GF128_mul(uint32_t Y[4], const uint32_t H[4])
+/* Absorbs a 16-byte block and multiplies the running value by H */
+static void GF128_mul(ghash_state *state, const uint8_t *block)
 {
-    uint32_t Z0 = 0;        /* Z = 0 */
-    uint32_t Z1 = 0;
-    uint32_t Z2 = 0;
-    uint32_t Z3 = 0;
-    uint32_t V0 = H[0];     /* V = H */
-    uint32_t V1 = H[1];
-    uint32_t V2 = H[2];
-    uint32_t V3 = H[3];
-
-    /* Multiply Z by V for the set bits in Y, starting at the top.
-       This is a very simple bit by bit version that may not be very
-       fast but it should be resistant to cache timing attacks. */
-    for (uint8_t posn = 0; posn < 16; ++posn) {
-        uint8_t value = ((const uint8_t *)Y)[posn];
-        for (uint8_t bit = 0; bit < 8; ++bit, value <<= 1) {
-            /* Extract the high bit of "value" and turn it into a mask */
-            uint32_t mask = (~((uint32_t)(value >> 7))) + 1;
-
-            /* XOR V with Z if the bit is 1 */
-            Z0 ^= (V0 & mask);
-            Z1 ^= (V1 & mask);
-            Z2 ^= (V2 & mask);
-            Z3 ^= (V3 & mask);
-
-            /* Rotate V right by 1 bit */
-            mask = ((~(V3 & 0x01)) + 1) & 0xE1000000;
-            V3 = (V3 >> 1) | (V2 << 31);
-            V2 = (V2 >> 1) | (V1 << 31);
-            V1 = (V1 >> 1) | (V0 << 31);
-            V0 = (V0 >> 1) ^ mask;
-        }
-    }
-
-    /* We have finished the block so copy Z into Y and byte-swap */
-    Y[0] = swapEndian(Z0);
-    Y[1] = swapEndian(Z1);
-    Y[2] = swapEndian(Z2);
-    Y[3] = swapEndian(Z3);
+    uint64_t y0, y1, y2, y0r, y1r, y2r;
+    uint64_t z0, z1, z2, z0h, z1h, z2h;
+    uint64_t v0, v1, v2, v3;
+
+    y1 = state->Y[1] ^ load_be64(block);
+    y0 = state->Y[0] ^ load_be64(block + 8);
+    y0r = rev64(y0);
+    y1r = rev64(y1);
+    y2 = y0 ^ y1;
+    y2r = y0r ^ y1r;
+
+    /* Karatsuba: three products for the low halves and three for the
+       bit-reversed values, which give the high halves */
+    z0 = bmul64(y0, state->H[0]);
+    z1 = bmul64(y1, state->H[1]);
+    z2 = bmul64(y2, state->H[0] ^ state->H[1]);
+    z0h = bmul64(y0r, state->Hr[0]);
+    z1h = bmul64(y1r, state->Hr[1]);
+    z2h = bmul64(y2r, state->Hr[0] ^ state->Hr[1]);
+    z2 ^= z0 ^ z1;
+    z2h ^= z0h ^ z1h;
+    z0h = rev64(z0h) >> 1;
+    z1h = rev64(z1h) >> 1;
+    z2h = rev64(z2h) >> 1;
+    v0 = z0;
+    v1 = z0h ^ z2;
+    v2 = z1 ^ z2h;
+    v3 = z1h;
+
+    /* GHASH is bit-reflected, so shift the 256-bit product left by 1 */
+    v3 = (v3 << 1) | (v2 >> 63);
+    v2 = (v2 << 1) | (v1 >> 63);
+    v1 = (v1 << 1) | (v0 >> 63);
+    v0 = (v0 << 1);
+
+    /* Reduce modulo x^128 + x^7 + x^2 + x + 1 */
+    v2 ^= v0 ^ (v0 >> 1) ^ (v0 >> 2) ^ (v0 >> 7);
+    v1 ^= (v0 << 63) ^ (v0 << 62) ^ (v0 << 57);
+    v3 ^= v1 ^ (v1 >> 1) ^ (v1 >> 2) ^ (v1 >> 7);
+    v2 ^= (v1 << 63) ^ (v1 << 62) ^ (v1 << 57);
+    state->Y[0] = v2;
+    state->Y[1] = v3;
 }
 
-#endif /* GHASH_WORD32 */
-
 void ghash_reset(ghash_state *state, const void *key)
 {
-    if (key)
-        GF128_mulInit(state->H, (const void *)key);
-    memset(state->Y, 0, sizeof(state->Y));
+    if (key) {
+        state->H[1] = load_be64((const uint8_t *)key);
+        state->H[0] = load_be64(((const uint8_t *)key) + 8);
+        state->Hr[0] = rev64(state->H[0]);
+        state->Hr[1] = rev64(state->H[1]);
+    }
+    state->Y[0] = 0;
+    state->Y[1] = 0;
     state->posn = 0;
 }
 
 void ghash_update(ghash_state *state, const void *data, size_t len)
 {
     const uint8_t *d = (const uint8_t *)data;
-    while (len > 0) {
-        uint8_t size = 16 - state->posn;
+
+    /* Finish off a partial block from last time */
+    if (state->posn != 0) {
+        size_t size = 16 - state->posn;
         if (size > len)
             size = len;
-        uint8_t *y = ((uint8_t *)state->Y) + state->posn;
-        for (uint8_t i = 0; i < size; ++i)
-            y[i] ^= d[i];
+        memcpy(state->buf + state->posn, d, size);
         state->posn += size;
         len -= size;
         d += size;
-        if (state->posn == 16) {
-            GF128_mul(state->Y, state->H);
-            state->posn = 0;
-        }
+        if (state->posn < 16)
+            return;
+        GF128_mul(state, state->buf);
+        state->posn = 0;
+    }
+
+    /* Process full blocks directly from the input */
+    while (len >= 16) {
+        GF128_mul(state, d);
+        d += 16;
+        len -= 16;
+    }
+
+    /* Save the leftover data for next time */
+    if (len > 0) {
+        memcpy(state->buf, d, len);
+        state->posn = (uint8_t)len;
     }
 }
 
 void ghash_finalize(ghash_state *state, void *token, size_t len)
 {
+    uint8_t value[16];
     ghash_pad(state);
+    store_be64(value, state->Y[1]);
+    store_be64(value + 8, state->Y[0]);
     if (len > 16)
         len = 16;
-    memcpy(token, state->Y, len);
+    memcpy(token, value, len);
 }
 
 void ghash_pad(ghash_state *state)
 {
     if (state->posn != 0) {
-        /* Padding involves XOR'ing the rest of state->Y with zeroes,
-           which does nothing.  Immediately process the next chunk */
-        GF128_mul(state->Y, state->H);
+        /* Pad the rest of the block with zeroes and process it */
+        memset(state->buf + state->posn, 0, 16 - state->posn);
+        GF128_mul(state, state->buf);
         state->posn = 0;
     }
 }
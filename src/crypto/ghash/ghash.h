@@ -26,28 +26,18 @@
 #include <stdint.h>
 #include <stddef.h>
 
-#if __WORDSIZE == 64 && !defined(GHASH_WORD64)
-#define GHASH_WORD64 1
-#endif
-
-#if defined(GHASH_WORD64)
-
+/* The hash key and the running value are kept as pairs of 64-bit words
+   in host byte order.  H[1] and Y[1] hold the first 8 bytes of the block
+   in big endian order and H[0] and Y[0] hold the last 8 bytes.  Hr is the
+   bit-reversed form of H, which is needed by the carryless multiply */
 typedef struct {
     uint64_t H[2];
+    uint64_t Hr[2];
     uint64_t Y[2];
+    uint8_t buf[16];
     uint8_t posn;
 } ghash_state;
 
-#else
-
-typedef struct {
-    uint32_t H[4];
-    uint32_t Y[4];
-    uint8_t posn;
-} ghash_state;
-
-#endif
-
 void ghash_reset(ghash_state *state, const void *key);
 void ghash_update(ghash_state *state, const void *data, size_t len);
 void ghash_finalize(ghash_state *state, void *token, size_t len);
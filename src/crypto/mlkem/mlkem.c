@@ -0,0 +1,629 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* Implementation of ML-KEM-768 from FIPS 203.  The arithmetic follows the
+   structure of the Kyber reference code: coefficients are signed 16-bit
+   values, multiplication uses Montgomery reduction, and the NTT leaves
+   its output in bit-reversed order so that pairs of coefficients can be
+   multiplied as degree-1 polynomials.  Nothing branches or indexes memory
+   on secret data; rejection sampling only looks at public matrix seeds */
+
+#include "mlkem.h"
+#include "crypto/newhope/fips202.h"
+#include <string.h>
+
+#define MLKEM_N             256
+#define MLKEM_Q             3329
+#define MLKEM_K             3
+#define MLKEM_SYMBYTES      32
+#define MLKEM_POLYBYTES     384
+#define MLKEM_POLYVECBYTES  (MLKEM_K * MLKEM_POLYBYTES)
+
+/* Compressed sizes for du = 10 and dv = 4 */
+#define MLKEM_POLYVECCOMPRESSEDBYTES    (MLKEM_K * 320)
+#define MLKEM_POLYCOMPRESSEDBYTES       128
+
+#define MLKEM_INDCPA_SECRETKEYBYTES     MLKEM_POLYVECBYTES
+
+/* q^-1 mod 2^16, as a signed value */
+#define MLKEM_QINV          -3327
+
+typedef struct
+{
+    int16_t coeffs[MLKEM_N];
+
+} mlkem_poly;
+
+typedef struct
+{
+    mlkem_poly vec[MLKEM_K];
+
+} mlkem_polyvec;
+
+/* 2^16 * 17^bitrev7(i) mod q, centered around zero */
+static int16_t const zetas[128] = {
+    -1044,  -758,  -359, -1517,  1493,  1422,   287,   202,
+     -171,   622,  1577,   182,   962, -1202, -1474,  1468,
+      573, -1325,   264,   383,  -829,  1458, -1602,  -130,
+     -681,  1017,   732,   608, -1542,   411,  -205, -1571,
+     1223,   652,  -552,  1015, -1293,  1491,  -282, -1544,
+      516,    -8,  -320,  -666, -1618, -1162,   126,  1469,
+     -853,   -90,  -271,   830,   107, -1421,  -247,  -951,
+     -398,   961, -1508,  -725,   448, -1065,   677, -1275,
+    -1103,   430,   555,   843, -1251,   871,  1550,   105,
+      422,   587,   177,  -235,  -291,  -460,  1574,  1653,
+     -246,   778,  1159,  -147,  -777,  1483,  -602,  1119,
+    -1590,   644,  -872,   349,   418,   329,  -156,   -75,
+      817,  1097,   603,   610,  1322, -1285, -1465,   384,
+    -1215,  -136,  1218, -1335,  -874,   220, -1187, -1659,
+    -1185, -1530, -1278,   794, -1510,  -854,  -870,   478,
+     -108,  -308,   996,   991,   958, -1460,  1522,  1628
+};
+
+/* Returns a value congruent to a * 2^-16 mod q in the range -q..q */
+static int16_t montgomery_reduce(int32_t a)
+{
+    int16_t t = (int16_t)a * MLKEM_QINV;
+    return (int16_t)((a - (int32_t)t * MLKEM_Q) >> 16);
+}
+
+/* Returns a value congruent to a mod q in the range -(q-1)/2..(q-1)/2 */
+static int16_t barrett_reduce(int16_t a)
+{
+    const int16_t v = ((1 << 26) + MLKEM_Q / 2) / MLKEM_Q;
+    int16_t t = (int16_t)(((int32_t)v * a + (1 << 25)) >> 26);
+    return a - t * MLKEM_Q;
+}
+
+/* Maps a centered coefficient into the range 0..q-1 */
+static uint16_t to_unsigned(int16_t a)
+{
+    return (uint16_t)(a + ((a >> 15) & MLKEM_Q));
+}
+
+static int16_t fqmul(int16_t a, int16_t b)
+{
+    return montgomery_reduce((int32_t)a * b);
+}
+
+/* Forward NTT; input in standard order, output in bit-reversed order */
+static void ntt(int16_t r[MLKEM_N])
+{
+    unsigned len, start, j, k = 1;
+    int16_t t, zeta;
+    for (len = 128; len >= 2; len >>= 1) {
+        for (start = 0; start < MLKEM_N; start = j + len) {
+            zeta = zetas[k++];
+            for (j = start; j < start + len; ++j) {
+                t = fqmul(zeta, r[j + len]);
+                r[j + len] = r[j] - t;
+                r[j] = r[j] + t;
+            }
+        }
+    }
+}
+
+/* Inverse NTT, which also multiplies by the Montgomery factor 2^16 */
+static void invntt(int16_t r[MLKEM_N])
+{
+    const int16_t f = 1441; /* 2^32 / 128 mod q */
+    unsigned len, start, j, k = 127;
+    int16_t t, zeta;
+    for (len = 2; len <= 128; len <<= 1) {
+        for (start = 0; start < MLKEM_N; start = j + len) {
+            zeta = zetas[k--];
+            for (j = start; j < start + len; ++j) {
+                t = r[j];
+                r[j] = barrett_reduce(t + r[j + len]);
+                r[j + len] = fqmul(zeta, r[j + len] - t);
+            }
+        }
+    }
+    for (j = 0; j < MLKEM_N; ++j)
+        r[j] = fqmul(r[j], f);
+}
+
+/* Multiplication of a0 + a1*X by b0 + b1*X modulo X^2 - zeta */
+static void basemul
+    (int16_t r[2], const int16_t a[2], const int16_t b[2], int16_t zeta)
+{
+    r[0] = fqmul(fqmul(a[1], b[1]), zeta) + fqmul(a[0], b[0]);
+    r[1] = fqmul(a[0], b[1]) + fqmul(a[1], b[0]);
+}
+
+static void poly_reduce(mlkem_poly *r)
+{
+    unsigned i;
+    for (i = 0; i < MLKEM_N; ++i)
+        r->coeffs[i] = barrett_reduce(r->coeffs[i]);
+}
+
+static void poly_add(mlkem_poly *r, const mlkem_poly *a, const mlkem_poly *b)
+{
+    unsigned i;
+    for (i = 0; i < MLKEM_N; ++i)
+        r->coeffs[i] = a->coeffs[i] + b->coeffs[i];
+}
+
+static void poly_sub(mlkem_poly *r, const mlkem_poly *a, const mlkem_poly *b)
+{
+    unsigned i;
+    for (i = 0; i < MLKEM_N; ++i)
+        r->coeffs[i] = a->coeffs[i] - b->coeffs[i];
+}
+
+static void poly_ntt(mlkem_poly *r)
+{
+    ntt(r->coeffs);
+    poly_reduce(r);
+}
+
+static void poly_tomont(mlkem_poly *r)
+{
+    const int16_t f = 1353; /* 2^32 mod q */
+    unsigned i;
+    for (i = 0; i < MLKEM_N; ++i)
+        r->coeffs[i] = montgomery_reduce((int32_t)r->coeffs[i] * f);
+}
+
+static void poly_basemul
+    (mlkem_poly *r, const mlkem_poly *a, const mlkem_poly *b)
+{
+    unsigned i;
+    for (i = 0; i < MLKEM_N / 4; ++i) {
+        basemul(&r->coeffs[4 * i], &a->coeffs[4 * i],
+                &b->coeffs[4 * i], zetas[64 + i]);
+        basemul(&r->coeffs[4 * i + 2], &a->coeffs[4 * i + 2],
+                &b->coeffs[4 * i + 2], -zetas[64 + i]);
+    }
+}
+
+/* r = sum(a[i] * b[i]) in the NTT domain, with a factor of 2^-16 */
+static void polyvec_basemul_acc
+    (mlkem_poly *r, const mlkem_polyvec *a, const mlkem_polyvec *b)
+{
+    mlkem_poly t;
+    unsigned i;
+    poly_basemul(r, &a->vec[0], &b->vec[0]);
+    for (i = 1; i < MLKEM_K; ++i) {
+        poly_basemul(&t, &a->vec[i], &b->vec[i]);
+        poly_add(r, r, &t);
+    }
+    poly_reduce(r);
+}
+
+/* ByteEncode12 and ByteDecode12 */
+static void poly_tobytes(uint8_t *r, const mlkem_poly *a)
+{
+    unsigned i;
+    uint16_t t0, t1;
+    for (i = 0; i < MLKEM_N / 2; ++i) {
+        t0 = to_unsigned(a->coeffs[2 * i]);
+        t1 = to_unsigned(a->coeffs[2 * i + 1]);
+        r[3 * i] = (uint8_t)t0;
+        r[3 * i + 1] = (uint8_t)((t0 >> 8) | (t1 << 4));
+        r[3 * i + 2] = (uint8_t)(t1 >> 4);
+    }
+}
+
+static void poly_frombytes(mlkem_poly *r, const uint8_t *a)
+{
+    unsigned i;
+    for (i = 0; i < MLKEM_N / 2; ++i) {
+        r->coeffs[2 * i] =
+            (int16_t)((a[3 * i] | ((uint16_t)a[3 * i + 1] << 8)) & 0xFFF);
+        r->coeffs[2 * i + 1] =
+            (int16_t)(((a[3 * i + 1] >> 4) | ((uint16_t)a[3 * i + 2] << 4)) & 0xFFF);
+    }
+}
+
+/* Compress_1 and Decompress_1 for the message */
+static void poly_frommsg(mlkem_poly *r, const uint8_t *msg)
+{
+    unsigned i, j;
+    int16_t mask;
+    for (i = 0; i < MLKEM_N / 8; ++i) {
+        for (j = 0; j < 8; ++j) {
+            mask = -(int16_t)((msg[i] >> j) & 1);
+            r->coeffs[8 * i + j] = mask & ((MLKEM_Q + 1) / 2);
+        }
+    }
+}
+
+static void poly_tomsg(uint8_t *msg, const mlkem_poly *a)
+{
+    unsigned i, j;
+    uint32_t t;
+    for (i = 0; i < MLKEM_N / 8; ++i) {
+        msg[i] = 0;
+        for (j = 0; j < 8; ++j) {
+            /* round(2 * t / q) mod 2 without a division.  The multiplier
+               is slightly less than 2^28 / q, which the rounding constant
+               of (q + 1) / 2 compensates for across all t in 0..q-1 */
+            t = to_unsigned(a->coeffs[8 * i + j]);
+            t = (((t << 1) + (MLKEM_Q + 1) / 2) * 80635) >> 28;
+            msg[i] |= (uint8_t)((t & 1) << j);
+        }
+    }
+}
+
+/* Compress_4 and Decompress_4 for the second ciphertext component */
+static void poly_compress(uint8_t *r, const mlkem_poly *a)
+{
+    unsigned i;
+    uint64_t t0, t1;
+    for (i = 0; i < MLKEM_N / 2; ++i) {
+        t0 = to_unsigned(a->coeffs[2 * i]);
+        t1 = to_unsigned(a->coeffs[2 * i + 1]);
+        t0 = (((t0 << 4) + (MLKEM_Q + 1) / 2) * 80635) >> 28;
+        t1 = (((t1 << 4) + (MLKEM_Q + 1) / 2) * 80635) >> 28;
+        r[i] = (uint8_t)((t0 & 0x0F) | ((t1 & 0x0F) << 4));
+    }
+}
+
+static void poly_decompress(mlkem_poly *r, const uint8_t *a)
+{
+    unsigned i;
+    for (i = 0; i < MLKEM_N / 2; ++i) {
+        r->coeffs[2 * i] = (int16_t)(((a[i] & 0x0F) * MLKEM_Q + 8) >> 4);
+        r->coeffs[2 * i + 1] = (int16_t)(((a[i] >> 4) * MLKEM_Q + 8) >> 4);
+    }
+}
+
+/* Compress_10 and Decompress_10 for the first ciphertext component */
+static void polyvec_compress(uint8_t *r, const mlkem_polyvec *a)
+{
+    unsigned i, j, k;
+    uint16_t t[4];
+    uint64_t d;
+    for (i = 0; i < MLKEM_K; ++i) {
+        for (j = 0; j < MLKEM_N / 4; ++j) {
+            for (k = 0; k < 4; ++k) {
+                d = to_unsigned(a->vec[i].coeffs[4 * j + k]);
+                d = (((d << 10) + (MLKEM_Q + 1) / 2) * 1290167) >> 32;
+                t[k] = (uint16_t)(d & 0x3FF);
+            }
+            r[0] = (uint8_t)t[0];
+            r[1] = (uint8_t)((t[0] >> 8) | (t[1] << 2));
+            r[2] = (uint8_t)((t[1] >> 6) | (t[2] << 4));
+            r[3] = (uint8_t)((t[2] >> 4) | (t[3] << 6));
+            r[4] = (uint8_t)(t[3] >> 2);
+            r += 5;
+        }
+    }
+}
+
+static void polyvec_decompress(mlkem_polyvec *r, const uint8_t *a)
+{
+    unsigned i, j, k;
+    uint32_t t[4];
+    for (i = 0; i < MLKEM_K; ++i) {
+        for (j = 0; j < MLKEM_N / 4; ++j) {
+            t[0] = a[0] | ((uint32_t)a[1] << 8);
+            t[1] = (a[1] >> 2) | ((uint32_t)a[2] << 6);
+            t[2] = (a[2] >> 4) | ((uint32_t)a[3] << 4);
+            t[3] = (a[3] >> 6) | ((uint32_t)a[4] << 2);
+            a += 5;
+            for (k = 0; k < 4; ++k) {
+                r->vec[i].coeffs[4 * j + k] =
+                    (int16_t)(((t[k] & 0x3FF) * MLKEM_Q + 512) >> 10);
+            }
+        }
+    }
+}
+
+/* SamplePolyCBD_2 applied to 128 bytes of PRF output */
+static void poly_cbd2(mlkem_poly *r, const uint8_t *buf)
+{
+    unsigned i, j;
+    uint32_t t, d;
+    int16_t a, b;
+    for (i = 0; i < MLKEM_N / 8; ++i) {
+        t = buf[4 * i] | ((uint32_t)buf[4 * i + 1] << 8) |
+            ((uint32_t)buf[4 * i + 2] << 16) | ((uint32_t)buf[4 * i + 3] << 24);
+        d = (t & 0x55555555) + ((t >> 1) & 0x55555555);
+        for (j = 0; j < 8; ++j) {
+            a = (int16_t)((d >> (4 * j)) & 0x03);
+            b = (int16_t)((d >> (4 * j + 2)) & 0x03);
+            r->coeffs[8 * i + j] = a - b;
+        }
+    }
+}
+
+/* Noise polynomial from PRF_2(seed, nonce) = SHAKE256(seed || nonce) */
+static void poly_getnoise(mlkem_poly *r, const uint8_t *seed, uint8_t nonce)
+{
+    uint8_t extseed[MLKEM_SYMBYTES + 1];
+    uint8_t buf[2 * MLKEM_N / 4];
+    memcpy(extseed, seed, MLKEM_SYMBYTES);
+    extseed[MLKEM_SYMBYTES] = nonce;
+    shake256(buf, sizeof(buf), extseed, sizeof(extseed));
+    poly_cbd2(r, buf);
+}
+
+/* SampleNTT: uniform polynomial from SHAKE128(rho || j || i) */
+static void poly_uniform
+    (mlkem_poly *r, const uint8_t *rho, uint8_t j, uint8_t i)
+{
+    uint8_t extseed[MLKEM_SYMBYTES + 2];
+    uint8_t buf[SHAKE128_RATE];
+    uint64_t state[25];
+    unsigned ctr = 0;
+    unsigned posn;
+    uint16_t d1, d2;
+    memcpy(extseed, rho, MLKEM_SYMBYTES);
+    extseed[MLKEM_SYMBYTES] = j;
+    extseed[MLKEM_SYMBYTES + 1] = i;
+    shake128_absorb(state, extseed, sizeof(extseed));
+    while (ctr < MLKEM_N) {
+        /* The rate is a multiple of 3, so no samples straddle blocks */
+        shake128_squeezeblocks(buf, 1, state);
+        for (posn = 0; posn < SHAKE128_RATE && ctr < MLKEM_N; posn += 3) {
+            d1 = buf[posn] | ((uint16_t)(buf[posn + 1] & 0x0F) << 8);
+            d2 = (buf[posn + 1] >> 4) | ((uint16_t)buf[posn + 2] << 4);
+            if (d1 < MLKEM_Q)
+                r->coeffs[ctr++] = (int16_t)d1;
+            if (d2 < MLKEM_Q && ctr < MLKEM_N)
+                r->coeffs[ctr++] = (int16_t)d2;
+        }
+    }
+}
+
+/* Expands the matrix A, or its transpose, from the public seed */
+static void gen_matrix
+    (mlkem_polyvec a[MLKEM_K], const uint8_t *rho, int transposed)
+{
+    unsigned i, j;
+    for (i = 0; i < MLKEM_K; ++i) {
+        for (j = 0; j < MLKEM_K; ++j) {
+            if (transposed)
+                poly_uniform(&a[i].vec[j], rho, (uint8_t)i, (uint8_t)j);
+            else
+                poly_uniform(&a[i].vec[j], rho, (uint8_t)j, (uint8_t)i);
+        }
+    }
+}
+
+/* K-PKE.KeyGen from a 32-byte seed d */
+static void indcpa_keygen(uint8_t *pk, uint8_t *sk, const uint8_t *d)
+{
+    uint8_t buf[2 * MLKEM_SYMBYTES];
+    const uint8_t *rho = buf;
+    const uint8_t *sigma = buf + MLKEM_SYMBYTES;
+    mlkem_polyvec a[MLKEM_K], s, e, t;
+    uint8_t nonce = 0;
+    unsigned i;
+
+    /* (rho, sigma) = G(d || k) */
+    memcpy(buf, d, MLKEM_SYMBYTES);
+    buf[MLKEM_SYMBYTES] = MLKEM_K;
+    sha3512(buf, buf, MLKEM_SYMBYTES + 1);
+
+    gen_matrix(a, rho, 0);
+    for (i = 0; i < MLKEM_K; ++i)
+        poly_getnoise(&s.vec[i], sigma, nonce++);
+    for (i = 0; i < MLKEM_K; ++i)
+        poly_getnoise(&e.vec[i], sigma, nonce++);
+    for (i = 0; i < MLKEM_K; ++i) {
+        poly_ntt(&s.vec[i]);
+        poly_ntt(&e.vec[i]);
+    }
+
+    /* t = A * s + e */
+    for (i = 0; i < MLKEM_K; ++i) {
+        polyvec_basemul_acc(&t.vec[i], &a[i], &s);
+        poly_tomont(&t.vec[i]);
+        poly_add(&t.vec[i], &t.vec[i], &e.vec[i]);
+        poly_reduce(&t.vec[i]);
+    }
+
+    for (i = 0; i < MLKEM_K; ++i) {
+        poly_tobytes(sk + i * MLKEM_POLYBYTES, &s.vec[i]);
+        poly_tobytes(pk + i * MLKEM_POLYBYTES, &t.vec[i]);
+    }
+    memcpy(pk + MLKEM_POLYVECBYTES, rho, MLKEM_SYMBYTES);
+
+    memset(buf, 0, sizeof(buf));
+    memset(&s, 0, sizeof(s));
+    memset(&e, 0, sizeof(e));
+}
+
+/* K-PKE.Encrypt of the 32-byte message m with the randomness r */
+static void indcpa_encrypt
+    (uint8_t *ct, const uint8_t *m, const uint8_t *pk, const uint8_t *r)
+{
+    mlkem_polyvec at[MLKEM_K], t, y, e1, u;
+    mlkem_poly e2, k, v;
+    uint8_t nonce = 0;
+    unsigned i;
+
+    for (i = 0; i < MLKEM_K; ++i)
+        poly_frombytes(&t.vec[i], pk + i * MLKEM_POLYBYTES);
+    gen_matrix(at, pk + MLKEM_POLYVECBYTES, 1);
+
+    for (i = 0; i < MLKEM_K; ++i)
+        poly_getnoise(&y.vec[i], r, nonce++);
+    for (i = 0; i < MLKEM_K; ++i)
+        poly_getnoise(&e1.vec[i], r, nonce++);
+    poly_getnoise(&e2, r, nonce++);
+    for (i = 0; i < MLKEM_K; ++i)
+        poly_ntt(&y.vec[i]);
+
+    /* u = A^T * y + e1, v = t^T * y + e2 + Decompress_1(m) */
+    for (i = 0; i < MLKEM_K; ++i) {
+        polyvec_basemul_acc(&u.vec[i], &at[i], &y);
+        invntt(u.vec[i].coeffs);
+        poly_add(&u.vec[i], &u.vec[i], &e1.vec[i]);
+        poly_reduce(&u.vec[i]);
+    }
+    polyvec_basemul_acc(&v, &t, &y);
+    invntt(v.coeffs);
+    poly_frommsg(&k, m);
+    poly_add(&v, &v, &e2);
+    poly_add(&v, &v, &k);
+    poly_reduce(&v);
+
+    polyvec_compress(ct, &u);
+    poly_compress(ct + MLKEM_POLYVECCOMPRESSEDBYTES, &v);
+
+    memset(&y, 0, sizeof(y));
+    memset(&e1, 0, sizeof(e1));
+    memset(&e2, 0, sizeof(e2));
+    memset(&k, 0, sizeof(k));
+}
+
+/* K-PKE.Decrypt */
+static void indcpa_decrypt(uint8_t *m, const uint8_t *ct, const uint8_t *sk)
+{
+    mlkem_polyvec u, s;
+    mlkem_poly v, w;
+    unsigned i;
+
+    polyvec_decompress(&u, ct);
+    poly_decompress(&v, ct + MLKEM_POLYVECCOMPRESSEDBYTES);
+    for (i = 0; i < MLKEM_K; ++i) {
+        poly_frombytes(&s.vec[i], sk + i * MLKEM_POLYBYTES);
+        poly_ntt(&u.vec[i]);
+    }
+
+    /* w = v - s^T * u */
+    polyvec_basemul_acc(&w, &s, &u);
+    invntt(w.coeffs);
+    poly_sub(&w, &v, &w);
+    poly_reduce(&w);
+    poly_tomsg(m, &w);
+
+    memset(&s, 0, sizeof(s));
+    memset(&w, 0, sizeof(w));
+}
+
+/**
+ * \brief Generates an ML-KEM-768 key pair deterministically.
+ *
+ * \param pk Returns the 1184-byte encapsulation key.
+ * \param sk Returns the 2400-byte decapsulation key.
+ * \param seed The 64 bytes of randomness d || z.
+ */
+void mlkem768_keygen(uint8_t *pk, uint8_t *sk, const uint8_t *seed)
+{
+    indcpa_keygen(pk, sk, seed);
+    memcpy(sk + MLKEM_INDCPA_SECRETKEYBYTES, pk, MLKEM768_PUBLICKEYBYTES);
+    sha3256(sk + MLKEM768_SECRETKEYBYTES - 2 * MLKEM_SYMBYTES,
+            pk, MLKEM768_PUBLICKEYBYTES);
+    memcpy(sk + MLKEM768_SECRETKEYBYTES - MLKEM_SYMBYTES,
+           seed + MLKEM_SYMBYTES, MLKEM_SYMBYTES);
+}
+
+/**
+ * \brief Performs the FIPS 203 modulus check on an encapsulation key.
+ *
+ * \param pk The 1184-byte encapsulation key.
+ *
+ * \return Non-zero if every coefficient in \a pk is less than q,
+ * or zero if the key is not in canonical form.
+ */
+int mlkem768_check_public_key(const uint8_t *pk)
+{
+    mlkem_poly t;
+    unsigned i, j;
+    uint16_t bad = 0;
+    for (i = 0; i < MLKEM_K; ++i) {
+        poly_frombytes(&t, pk + i * MLKEM_POLYBYTES);
+        for (j = 0; j < MLKEM_N; ++j)
+            bad |= (uint16_t)(MLKEM_Q - 1 - t.coeffs[j]) >> 15;
+    }
+    return !bad;
+}
+
+/**
+ * \brief Encapsulates a shared secret deterministically.
+ *
+ * \param ct Returns the 1088-byte ciphertext.
+ * \param ss Returns the 32-byte shared secret.
+ * \param pk The encapsulation key, which must have passed
+ * mlkem768_check_public_key().
+ * \param seed The 32 bytes of randomness m.
+ */
+void mlkem768_encaps
+    (uint8_t *ct, uint8_t *ss, const uint8_t *pk, const uint8_t *seed)
+{
+    uint8_t buf[2 * MLKEM_SYMBYTES];
+    uint8_t kr[2 * MLKEM_SYMBYTES];
+
+    /* (K, r) = G(m || H(ek)) */
+    memcpy(buf, seed, MLKEM_SYMBYTES);
+    sha3256(buf + MLKEM_SYMBYTES, pk, MLKEM768_PUBLICKEYBYTES);
+    sha3512(kr, buf, sizeof(buf));
+
+    indcpa_encrypt(ct, buf, pk, kr + MLKEM_SYMBYTES);
+    memcpy(ss, kr, MLKEM_SYMBYTES);
+
+    memset(buf, 0, sizeof(buf));
+    memset(kr, 0, sizeof(kr));
+}
+
+/**
+ * \brief Decapsulates a shared secret.
+ *
+ * \param ss Returns the 32-byte shared secret.
+ * \param ct The 1088-byte ciphertext.
+ * \param sk The 2400-byte decapsulation key.
+ *
+ * If the ciphertext does not re-encrypt to the same value then \a ss is
+ * set to the implicit rejection value SHAKE256(z || ct) instead, without
+ * revealing which path was taken.
+ */
+void mlkem768_decaps(uint8_t *ss, const uint8_t *ct, const uint8_t *sk)
+{
+    const uint8_t *pk = sk + MLKEM_INDCPA_SECRETKEYBYTES;
+    const uint8_t *z = sk + MLKEM768_SECRETKEYBYTES - MLKEM_SYMBYTES;
+    uint8_t buf[2 * MLKEM_SYMBYTES];
+    uint8_t kr[2 * MLKEM_SYMBYTES];
+    uint8_t cmp[MLKEM768_CIPHERTEXTBYTES];
+    uint8_t rej[MLKEM_SYMBYTES + MLKEM768_CIPHERTEXTBYTES];
+    uint8_t diff = 0;
+    uint8_t mask;
+    unsigned i;
+
+    /* m' = Decrypt(c), (K', r') = G(m' || h) */
+    indcpa_decrypt(buf, ct, sk);
+    memcpy(buf + MLKEM_SYMBYTES,
+           sk + MLKEM768_SECRETKEYBYTES - 2 * MLKEM_SYMBYTES, MLKEM_SYMBYTES);
+    sha3512(kr, buf, sizeof(buf));
+
+    /* Re-encrypt and compare in constant time */
+    indcpa_encrypt(cmp, buf, pk, kr + MLKEM_SYMBYTES);
+    for (i = 0; i < MLKEM768_CIPHERTEXTBYTES; ++i)
+        diff |= ct[i] ^ cmp[i];
+
+    /* K_bar = J(z || c), selected if the comparison failed */
+    memcpy(rej, z, MLKEM_SYMBYTES);
+    memcpy(rej + MLKEM_SYMBYTES, ct, MLKEM768_CIPHERTEXTBYTES);
+    shake256(ss, MLKEM_SYMBYTES, rej, sizeof(rej));
+    mask = (uint8_t)(((uint16_t)diff - 1) >> 8); /* 0xFF if equal */
+    for (i = 0; i < MLKEM_SYMBYTES; ++i)
+        ss[i] ^= mask & (ss[i] ^ kr[i]);
+
+    memset(buf, 0, sizeof(buf));
+    memset(kr, 0, sizeof(kr));
+    memset(rej, 0, MLKEM_SYMBYTES);
+}
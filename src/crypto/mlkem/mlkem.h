@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CRYPTO_MLKEM_h
+#define CRYPTO_MLKEM_h
+
+#include <stdint.h>
+
+/* Sizes of the encoded values for ML-KEM-768 from FIPS 203 */
+#define MLKEM768_PUBLICKEYBYTES     1184
+#define MLKEM768_SECRETKEYBYTES     2400
+#define MLKEM768_CIPHERTEXTBYTES    1088
+#define MLKEM768_SHAREDBYTES        32
+#define MLKEM768_KEYGEN_SEEDBYTES   64
+#define MLKEM768_ENCAPS_SEEDBYTES   32
+
+void mlkem768_keygen(uint8_t *pk, uint8_t *sk, const uint8_t *seed);
+int mlkem768_check_public_key(const uint8_t *pk);
+void mlkem768_encaps
+    (uint8_t *ct, uint8_t *ss, const uint8_t *pk, const uint8_t *seed);
+void mlkem768_decaps(uint8_t *ss, const uint8_t *ct, const uint8_t *sk);
+
+#endif
@@ -404,6 +404,25 @@ void shake128(unsigned char *output, unsigned int outputByteLen, const unsigned
 */
 
 
+void shake256(unsigned char *output, unsigned int outputByteLen, const unsigned char *input, unsigned int inputByteLen)
+{
+  uint64_t s[25];
+  unsigned char t[SHAKE256_RATE];
+  unsigned int i;
+
+  keccak_absorb(s, SHAKE256_RATE, input, inputByteLen, 0x1F);
+  while(outputByteLen > 0)
+  {
+    unsigned int len = MIN(outputByteLen, SHAKE256_RATE);
+    keccak_squeezeblocks(t, 1, s, SHAKE256_RATE);
+    for(i=0;i<len;i++)
+      output[i] = t[i];
+    output += len;
+    outputByteLen -= len;
+  }
+}
+
+
 void sha3256(unsigned char *output, const unsigned char *input, unsigned int inputByteLen)
 {
   uint64_t s[25];
@@ -415,3 +434,16 @@ void sha3256(unsigned char *output, const unsigned char *input, unsigned int inp
   for(i=0;i<32;i++)
     output[i] = t[i];
 }
+
+
+void sha3512(unsigned char *output, const unsigned char *input, unsigned int inputByteLen)
+{
+  uint64_t s[25];
+  unsigned char t[SHA3_512_RATE];
+  int i;
+
+  keccak_absorb(s, SHA3_512_RATE, input, inputByteLen, 0x06);
+  keccak_squeezeblocks(t, 1, s, SHA3_512_RATE);
+  for(i=0;i<64;i++)
+    output[i] = t[i];
+}
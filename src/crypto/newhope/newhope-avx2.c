@@ -0,0 +1,917 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+    AVX2 versions of the New Hope polynomial operations.
+
+    The results are bit-for-bit identical to the portable code in poly.c
+    and ntt.c.  The NTT and the Montgomery multiplications use 32-bit
+    lanes and reproduce the scalar arithmetic exactly, including the
+    truncation to 16 bits wherever the scalar code stores an intermediate
+    value in a uint16_t.  The first three levels of the NTT have butterflies
+    that are less than 8 coefficients apart, so they are performed on
+    transposed 8x8 tiles with pre-arranged twiddle factors.
+
+    The noise sampler generates its ChaCha20 stream 8 blocks at a time,
+    and the Batcher sorting network in poly_uniform() sorts all 16 of its
+    independent columns at once in 16-bit lanes.  The SHAKE-128 stream
+    for the public parameter "a" is a single sequential sponge, so it
+    stays with the scalar Keccak permutation.
+
+    The functions are compiled with a target attribute so that the rest
+    of the library can still run on CPUs without AVX2.
+*/
+
+#include "poly.h"
+
+#if NEWHOPE_HAVE_AVX2
+
+#include "ntt.h"
+#include "fips202.h"
+#include <immintrin.h>
+#include <string.h>
+
+#define AVX2 __attribute__((target("avx2")))
+
+/* Twiddle factors for the first three levels of the NTT, arranged by
+   level, tile, and butterfly so that each row can be loaded directly */
+static uint16_t const omegas_tiles[3 * 16 * 4][8] = {
+    { 4075,  3262,  6364,  2344,  4536,  3818,  4789,  5456},
+    { 6974,  5079,  1018, 11011,  1050,  6118,  7822,  4449},
+    { 7373,   522,  1041,  5574,  6844,  2683,  7540,  3789},
+    { 7965,  2169,  8775,  1973,  3860,  1190,  6752, 12142},
+    {11973,  6843, 11316,  3998, 11889,  5862,  8724,  7083},
+    {  382,  5339,  1254, 10256,  1728,  6136,   654,  6760},
+    { 3988,  6196,  5435, 10367,  6137,  3643, 10302,    56},
+    {  468,  3710, 10930,  3879,  4948,  6874,  1702,  3199},
+    { 9987,  5594,  6212,  4080,   975,  5681,   241,  5009},
+    {  605,  9260,  4624, 11868,  8077,  3477, 12231,  1956},
+    {11785,  6403,  9026,  6221,  8851,  1105,  1003,  6008},
+    { 8076,  4782,  8689,  3602,  9445,   142,  3532, 11404},
+    { 7377,  7591,  2920, 11279, 12138,   431,  5874,  2766},
+    { 2049,  5057,  7048,  6821,  2127,  1579,   677,  1323},
+    {10968,  3445,  3127, 11502,  2839,  6383,  3336,  9115},
+    {12097,  4780,  8120,  8807,  3957,  9784,  6234, 12237},
+    { 2031,  3969,  4737, 11871,  2882, 11713,  8174, 12071},
+    { 6956,  3991, 10996,  3772,  1805,  3963,  3030,  2908},
+    { 6413, 12133,  4774,   453,  2051,  2447,  1843,  3529},
+    { 2281,  9522,  5429,  5908,  1954,  6142,  2361,  3434},
+    { 3202, 11939, 11026,  1489, 10431,  3757,  5868, 10596},
+    { 7796,  1512,    49,  9789,  7535, 10314,  9551,  9280},
+    { 2057,  6906, 10806,  5942,   426,  9364,  9634, 11566},
+    { 5369, 10474,  5915, 10706,  8974,   347,  6554,   174},
+    { 2948, 11606,  8455,  1747,  6065, 11580,  1058,  7967},
+    { 2503,  2459,  5257,  9166,   835,  4046,  8210,  1958},
+    { 6507,    64,  5919,  5486,  3570, 10970, 11848, 10211},
+    {10723,  3656,  7856,  9235,  4240,  9139,   922,  1112},
+    { 3728,  1404,  6190,  8212,  6119,  2555,  7991,  5106},
+    { 4049,   325,   295,  8273,  6992,  6167,  3329,  5961},
+    {11130,   948, 11637,  2919,  8333,  1200,  9597, 10695},
+    { 5990, 11143,  5766,  8527,  1360,  7105, 12121, 10327},
+    { 3051,    81,  4611,  4255,  1062,  2747,  1170,  9275},
+    { 9923,  3091,   726, 11112,  2294,  4846,  2319,  9088},
+    { 4896,  1000,  1853,  2768,  3553,  8577,   790,  1326},
+    { 9326,  7969, 12149, 10654,  4805,  9154, 11334,  5086},
+    { 9094,  3504,  1479, 11567,  4978,  4591,  9650,  2975},
+    { 6429,  3542,     1, 10984, 10938,  5728,  7468, 11726},
+    {11077,  8668,  8246,  4134,  5777,  6461,   949,  2744},
+    {10643,  9744,  7143,  5736,  8961,  5023,  9664,  9283},
+    {10092,  3748,  9452,  3296, 10908,  8011, 11809, 11950},
+    { 5067, 11336,  5374,  3949,  2525, 10616,  9447,  9821},
+    {12171,  6522, 12159,  9893,  3584,  4989, 12280, 11745},
+    { 2476,   827,  7935,  4452,  8112,  6958,  1022,  5791},
+    { 5092,  3289,  7901, 11955,  4890,  8830,  5179,   355},
+    { 2089,  2013,  1260,  2426,  5911,  3637,  8595,  3382},
+    { 9005,  9048,  5755, 10593,  3932,  5542,  3707,  4231},
+    { 2881,   729,  4632,  1428,  9558,   145, 10530,  9741},
+    { 1207, 10146, 10911,  4096,  6039,  8643,  7278,  1607},
+    { 9041, 11224, 10377,   493,  2422,  9852,  1002,  7313},
+    { 7012,  4645,   435,  9908,  2187,  9302,  4284,   875},
+    { 1168, 11885,  7952,  6845,  9723,  6022,  5088,  8509},
+    { 9430,  7428, 11847, 11516,  7270, 12047,  4885,  3066},
+    { 1045,   354,  2401,   390,   545,  1537,  1017,    27},
+    { 2481,  6591,  1067,  8511,  8585,  4143,  5084,  1440},
+    { 5012,  9377,  7188,  8456,  9611,  4714,  1632,  8526},
+    { 9273,  3400,  8758, 11869,  2249,  2126,  2686,  9424},
+    {12046,  9890, 11813,  6730,  4048,  1630,  9042,  9919},
+    {11618,  3136,  7384, 10745,  2884,  9103,  2969,  8779},
+    { 9289,  7098,  3985, 10111, 11136,  5407,  8311,  5332},
+    {10626,  7351,  8374,  9140,  4895,  2305, 10600,  4414},
+    { 1777,  3636,  2166, 12129, 10805,  7247,  3364,  9442},
+    { 4654,  9585,  4919,  7852,  2780,  9644,  3271,  7917},
+    {10863,  5291, 12176, 12286,  5195,  4053,  4057,  2174},
+    { 4075,  7373,  3262,   522,  6364,  1041,  2344,  5574},
+    { 4075,  7373,  3262,   522,  6364,  1041,  2344,  5574},
+    { 6974,  7965,  5079,  2169,  1018,  8775, 11011,  1973},
+    { 6974,  7965,  5079,  2169,  1018,  8775, 11011,  1973},
+    { 4536,  6844,  3818,  2683,  4789,  7540,  5456,  3789},
+    { 4536,  6844,  3818,  2683,  4789,  7540,  5456,  3789},
+    { 1050,  3860,  6118,  1190,  7822,  6752,  4449, 12142},
+    { 1050,  3860,  6118,  1190,  7822,  6752,  4449, 12142},
+    {11973,  3988,  6843,  6196, 11316,  5435,  3998, 10367},
+    {11973,  3988,  6843,  6196, 11316,  5435,  3998, 10367},
+    {  382,   468,  5339,  3710,  1254, 10930, 10256,  3879},
+    {  382,   468,  5339,  3710,  1254, 10930, 10256,  3879},
+    {11889,  6137,  5862,  3643,  8724, 10302,  7083,    56},
+    {11889,  6137,  5862,  3643,  8724, 10302,  7083,    56},
+    { 1728,  4948,  6136,  6874,   654,  1702,  6760,  3199},
+    { 1728,  4948,  6136,  6874,   654,  1702,  6760,  3199},
+    { 9987, 11785,  5594,  6403,  6212,  9026,  4080,  6221},
+    { 9987, 11785,  5594,  6403,  6212,  9026,  4080,  6221},
+    {  605,  8076,  9260,  4782,  4624,  8689, 11868,  3602},
+    {  605,  8076,  9260,  4782,  4624,  8689, 11868,  3602},
+    {  975,  8851,  5681,  1105,   241,  1003,  5009,  6008},
+    {  975,  8851,  5681,  1105,   241,  1003,  5009,  6008},
+    { 8077,  9445,  3477,   142, 12231,  3532,  1956, 11404},
+    { 8077,  9445,  3477,   142, 12231,  3532,  1956, 11404},
+    { 7377, 10968,  7591,  3445,  2920,  3127, 11279, 11502},
+    { 7377, 10968,  7591,  3445,  2920,  3127, 11279, 11502},
+    { 2049, 12097,  5057,  4780,  7048,  8120,  6821,  8807},
+    { 2049, 12097,  5057,  4780,  7048,  8120,  6821,  8807},
+    {12138,  2839,   431,  6383,  5874,  3336,  2766,  9115},
+    {12138,  2839,   431,  6383,  5874,  3336,  2766,  9115},
+    { 2127,  3957,  1579,  9784,   677,  6234,  1323, 12237},
+    { 2127,  3957,  1579,  9784,   677,  6234,  1323, 12237},
+    { 2031,  6413,  3969, 12133,  4737,  4774, 11871,   453},
+    { 2031,  6413,  3969, 12133,  4737,  4774, 11871,   453},
+    { 6956,  2281,  3991,  9522, 10996,  5429,  3772,  5908},
+    { 6956,  2281,  3991,  9522, 10996,  5429,  3772,  5908},
+    { 2882,  2051, 11713,  2447,  8174,  1843, 12071,  3529},
+    { 2882,  2051, 11713,  2447,  8174,  1843, 12071,  3529},
+    { 1805,  1954,  3963,  6142,  3030,  2361,  2908,  3434},
+    { 1805,  1954,  3963,  6142,  3030,  2361,  2908,  3434},
+    { 3202,  2057, 11939,  6906, 11026, 10806,  1489,  5942},
+    { 3202,  2057, 11939,  6906, 11026, 10806,  1489,  5942},
+    { 7796,  5369,  1512, 10474,    49,  5915,  9789, 10706},
+    { 7796,  5369,  1512, 10474,    49,  5915,  9789, 10706},
+    {10431,   426,  3757,  9364,  5868,  9634, 10596, 11566},
+    {10431,   426,  3757,  9364,  5868,  9634, 10596, 11566},
+    { 7535,  8974, 10314,   347,  9551,  6554,  9280,   174},
+    { 7535,  8974, 10314,   347,  9551,  6554,  9280,   174},
+    { 2948,  6507, 11606,    64,  8455,  5919,  1747,  5486},
+    { 2948,  6507, 11606,    64,  8455,  5919,  1747,  5486},
+    { 2503, 10723,  2459,  3656,  5257,  7856,  9166,  9235},
+    { 2503, 10723,  2459,  3656,  5257,  7856,  9166,  9235},
+    { 6065,  3570, 11580, 10970,  1058, 11848,  7967, 10211},
+    { 6065,  3570, 11580, 10970,  1058, 11848,  7967, 10211},
+    {  835,  4240,  4046,  9139,  8210,   922,  1958,  1112},
+    {  835,  4240,  4046,  9139,  8210,   922,  1958,  1112},
+    { 3728, 11130,  1404,   948,  6190, 11637,  8212,  2919},
+    { 3728, 11130,  1404,   948,  6190, 11637,  8212,  2919},
+    { 4049,  5990,   325, 11143,   295,  5766,  8273,  8527},
+    { 4049,  5990,   325, 11143,   295,  5766,  8273,  8527},
+    { 6119,  8333,  2555,  1200,  7991,  9597,  5106, 10695},
+    { 6119,  8333,  2555,  1200,  7991,  9597,  5106, 10695},
+    { 6992,  1360,  6167,  7105,  3329, 12121,  5961, 10327},
+    { 6992,  1360,  6167,  7105,  3329, 12121,  5961, 10327},
+    { 4075,  6974,  7373,  7965,  3262,  5079,   522,  2169},
+    { 4075,  6974,  7373,  7965,  3262,  5079,   522,  2169},
+    { 4075,  6974,  7373,  7965,  3262,  5079,   522,  2169},
+    { 4075,  6974,  7373,  7965,  3262,  5079,   522,  2169},
+    { 6364,  1018,  1041,  8775,  2344, 11011,  5574,  1973},
+    { 6364,  1018,  1041,  8775,  2344, 11011,  5574,  1973},
+    { 6364,  1018,  1041,  8775,  2344, 11011,  5574,  1973},
+    { 6364,  1018,  1041,  8775,  2344, 11011,  5574,  1973},
+    { 4536,  1050,  6844,  3860,  3818,  6118,  2683,  1190},
+    { 4536,  1050,  6844,  3860,  3818,  6118,  2683,  1190},
+    { 4536,  1050,  6844,  3860,  3818,  6118,  2683,  1190},
+    { 4536,  1050,  6844,  3860,  3818,  6118,  2683,  1190},
+    { 4789,  7822,  7540,  6752,  5456,  4449,  3789, 12142},
+    { 4789,  7822,  7540,  6752,  5456,  4449,  3789, 12142},
+    { 4789,  7822,  7540,  6752,  5456,  4449,  3789, 12142},
+    { 4789,  7822,  7540,  6752,  5456,  4449,  3789, 12142},
+    {11973,   382,  3988,   468,  6843,  5339,  6196,  3710},
+    {11973,   382,  3988,   468,  6843,  5339,  6196,  3710},
+    {11973,   382,  3988,   468,  6843,  5339,  6196,  3710},
+    {11973,   382,  3988,   468,  6843,  5339,  6196,  3710},
+    {11316,  1254,  5435, 10930,  3998, 10256, 10367,  3879},
+    {11316,  1254,  5435, 10930,  3998, 10256, 10367,  3879},
+    {11316,  1254,  5435, 10930,  3998, 10256, 10367,  3879},
+    {11316,  1254,  5435, 10930,  3998, 10256, 10367,  3879},
+    {11889,  1728,  6137,  4948,  5862,  6136,  3643,  6874},
+    {11889,  1728,  6137,  4948,  5862,  6136,  3643,  6874},
+    {11889,  1728,  6137,  4948,  5862,  6136,  3643,  6874},
+    {11889,  1728,  6137,  4948,  5862,  6136,  3643,  6874},
+    { 8724,   654, 10302,  1702,  7083,  6760,    56,  3199},
+    { 8724,   654, 10302,  1702,  7083,  6760,    56,  3199},
+    { 8724,   654, 10302,  1702,  7083,  6760,    56,  3199},
+    { 8724,   654, 10302,  1702,  7083,  6760,    56,  3199},
+    { 9987,   605, 11785,  8076,  5594,  9260,  6403,  4782},
+    { 9987,   605, 11785,  8076,  5594,  9260,  6403,  4782},
+    { 9987,   605, 11785,  8076,  5594,  9260,  6403,  4782},
+    { 9987,   605, 11785,  8076,  5594,  9260,  6403,  4782},
+    { 6212,  4624,  9026,  8689,  4080, 11868,  6221,  3602},
+    { 6212,  4624,  9026,  8689,  4080, 11868,  6221,  3602},
+    { 6212,  4624,  9026,  8689,  4080, 11868,  6221,  3602},
+    { 6212,  4624,  9026,  8689,  4080, 11868,  6221,  3602},
+    {  975,  8077,  8851,  9445,  5681,  3477,  1105,   142},
+    {  975,  8077,  8851,  9445,  5681,  3477,  1105,   142},
+    {  975,  8077,  8851,  9445,  5681,  3477,  1105,   142},
+    {  975,  8077,  8851,  9445,  5681,  3477,  1105,   142},
+    {  241, 12231,  1003,  3532,  5009,  1956,  6008, 11404},
+    {  241, 12231,  1003,  3532,  5009,  1956,  6008, 11404},
+    {  241, 12231,  1003,  3532,  5009,  1956,  6008, 11404},
+    {  241, 12231,  1003,  3532,  5009,  1956,  6008, 11404},
+    { 7377,  2049, 10968, 12097,  7591,  5057,  3445,  4780},
+    { 7377,  2049, 10968, 12097,  7591,  5057,  3445,  4780},
+    { 7377,  2049, 10968, 12097,  7591,  5057,  3445,  4780},
+    { 7377,  2049, 10968, 12097,  7591,  5057,  3445,  4780},
+    { 2920,  7048,  3127,  8120, 11279,  6821, 11502,  8807},
+    { 2920,  7048,  3127,  8120, 11279,  6821, 11502,  8807},
+    { 2920,  7048,  3127,  8120, 11279,  6821, 11502,  8807},
+    { 2920,  7048,  3127,  8120, 11279,  6821, 11502,  8807},
+    {12138,  2127,  2839,  3957,   431,  1579,  6383,  9784},
+    {12138,  2127,  2839,  3957,   431,  1579,  6383,  9784},
+    {12138,  2127,  2839,  3957,   431,  1579,  6383,  9784},
+    {12138,  2127,  2839,  3957,   431,  1579,  6383,  9784},
+    { 5874,   677,  3336,  6234,  2766,  1323,  9115, 12237},
+    { 5874,   677,  3336,  6234,  2766,  1323,  9115, 12237},
+    { 5874,   677,  3336,  6234,  2766,  1323,  9115, 12237},
+    { 5874,   677,  3336,  6234,  2766,  1323,  9115, 12237}
+};
+
+static uint16_t const omegas_inv_tiles[3 * 16 * 4][8] = {
+    { 4075, 10120, 10316,  3514,   147,  5537, 11099,  8429},
+    { 5315, 11767,  6715, 11248,  8500,  4749,  9606,  5445},
+    { 4324,  7210,  1278, 11271,  7840,  4467,  6171, 11239},
+    { 4916,  9027,  9945,  5925,  6833,  7500,  8471,  7753},
+    { 9090, 10587,  5415,  7341,  8410,  1359,  8579, 11821},
+    {12233,  1987,  8646,  6152,  1922,  6854,  6093,  8301},
+    { 5529, 11635,  6153, 10561,  2033, 11035,  6950, 11907},
+    { 5206,  3565,  6427,   400,  8291,   973,  5446,   316},
+    {   52,  6055,  2505,  8332,  3482,  4169,  7509,   192},
+    { 3174,  8953,  5906,  9450,   787,  9162,  8844,  1321},
+    {10966, 11612, 10710, 10162,  5468,  5241,  7232, 10240},
+    { 9523,  6415, 11858,   151,  1010,  9369,  4698,  4912},
+    {  885,  8757, 12147,  2844,  8687,  3600,  7507,  4213},
+    { 6281, 11286, 11184,  3438,  6068,  3263,  5886,   504},
+    {10333,    58,  8812,  4212,   421,  7665,  3029, 11684},
+    { 7280, 12048,  6608, 11314,  8209,  6077,  6695,  2302},
+    { 1962,   168,  5184, 10929,  3762,  6523,  1146,  6299},
+    { 1594,  2692, 11089,  3956,  9370,   652, 11341,  1159},
+    { 6328,  8960,  6122,  5297,  4016, 11994, 11964,  8240},
+    { 7183,  4298,  9734,  6170,  4077,  6099, 10885,  8561},
+    {11177, 11367,  3150,  8049,  3054,  4433,  8633,  1566},
+    { 2078,   441,  1319,  8719,  6803,  6370, 12225,  5782},
+    {10331,  4079,  8243, 11454,  3123,  7032,  9830,  9786},
+    { 4322, 11231,   709,  6224, 10542,  3834,   683,  9341},
+    {12115,  5735, 11942,  3315,  1583,  6374,  1815,  6920},
+    {  723,  2655,  2925, 11863,  6347,  1483,  5383, 10232},
+    { 3009,  2738,  1975,  4754,  2500, 12240, 10777,  4493},
+    { 1693,  6421,  8532,  1858, 10800,  1263,   350,  9087},
+    { 8855,  9928,  6147, 10335,  6381,  6860,  2767, 10008},
+    { 8760, 10446,  9842, 10238, 11836,  7515,   156,  5876},
+    { 9381,  9259,  8326, 10484,  8517,  1293,  8298,  5333},
+    {  218,  4115,   576,  9407,   418,  7552,  8320, 10258},
+    {10115,  8232,  8236,  7094,     3,   113,  6998,  1426},
+    { 4372,  9018,  2645,  9509,  4437,  7370,  2704,  7635},
+    { 2847,  8925,  5042,  1484,   160, 10123,  8653, 10512},
+    { 7875,  1689,  9984,  7394,  3149,  3915,  4938,  1663},
+    { 6957,  3978,  6882,  1153,  2178,  8304,  5191,  3000},
+    { 3510,  9320,  3186,  9405,  1544,  4905,  9153,   671},
+    { 2370,  3247, 10659,  8241,  5559,   476,  2399,   243},
+    { 2865,  9603, 10163, 10040,   420,  3531,  8889,  3016},
+    { 3763, 10657,  7575,  2678,  3833,  5101,  2912,  7277},
+    {10849,  7205,  8146,  3704,  3778, 11222,  5698,  9808},
+    {12262, 11272, 10752, 11744, 11899,  9888, 11935, 11244},
+    { 9223,  7404,   242,  5019,   773,   442,  4861,  2859},
+    { 3780,  7201,  6267,  2566,  5444,  4337,   404, 11121},
+    {11414,  8005,  2987, 10102,  2381, 11854,  7644,  5277},
+    { 4976, 11287,  2437,  9867, 11796,  1912,  1065,  3248},
+    {10682,  5011,  3646,  6250,  8193,  1378,  2143, 11082},
+    { 2548,  1759, 12144,  2731, 10861,  7657, 11560,  9408},
+    { 8058,  8582,  6747,  8357,  1696,  6534,  3241,  3284},
+    { 8907,  3694,  8652,  6378,  9863, 11029, 10276, 10200},
+    {11934,  7110,  3459,  7399,   334,  4388,  9000,  7197},
+    { 6498, 11267,  5331,  4177,  7837,  4354, 11462,  9813},
+    {  544,     9,  7300,  8705,  2396,   130,  5767,   118},
+    { 2468,  2842,  1673,  9764,  8340,  6915,   953,  7222},
+    {  339,   480,  4278,  1381,  8993,  2837,  8541,  2197},
+    { 3006,  2625,  7266,  3328,  6553,  5146,  2545,  1646},
+    { 9545, 11340,  5828,  6512,  8155,  4043,  3621,  1212},
+    {  563,  4821,  6561,  1351,  1305, 12288,  8747,  5860},
+    { 9314,  2639,  7698,  7311,   722, 10810,  8785,  3195},
+    { 7203,   955,  3135,  7484,  1635,   140,  4320,  2963},
+    {10963, 11499,  3712,  8736,  9521, 10436, 11289,  7393},
+    { 3201,  9970,  7443,  9995,  1177, 11563,  9198,  2366},
+    { 3014, 11119,  9542, 11227,  8034,  7678, 12208,  9238},
+    { 4075,  4324, 10120,  7210, 10316,  1278,  3514, 11271},
+    { 4075,  4324, 10120,  7210, 10316,  1278,  3514, 11271},
+    { 5315,  4916, 11767,  9027,  6715,  9945, 11248,  5925},
+    { 5315,  4916, 11767,  9027,  6715,  9945, 11248,  5925},
+    {  147,  7840,  5537,  4467, 11099,  6171,  8429, 11239},
+    {  147,  7840,  5537,  4467, 11099,  6171,  8429, 11239},
+    { 8500,  6833,  4749,  7500,  9606,  8471,  5445,  7753},
+    { 8500,  6833,  4749,  7500,  9606,  8471,  5445,  7753},
+    { 9090,  5529, 10587, 11635,  5415,  6153,  7341, 10561},
+    { 9090,  5529, 10587, 11635,  5415,  6153,  7341, 10561},
+    {12233,  5206,  1987,  3565,  8646,  6427,  6152,   400},
+    {12233,  5206,  1987,  3565,  8646,  6427,  6152,   400},
+    { 8410,  2033,  1359, 11035,  8579,  6950, 11821, 11907},
+    { 8410,  2033,  1359, 11035,  8579,  6950, 11821, 11907},
+    { 1922,  8291,  6854,   973,  6093,  5446,  8301,   316},
+    { 1922,  8291,  6854,   973,  6093,  5446,  8301,   316},
+    {   52, 10966,  6055, 11612,  2505, 10710,  8332, 10162},
+    {   52, 10966,  6055, 11612,  2505, 10710,  8332, 10162},
+    { 3174,  9523,  8953,  6415,  5906, 11858,  9450,   151},
+    { 3174,  9523,  8953,  6415,  5906, 11858,  9450,   151},
+    { 3482,  5468,  4169,  5241,  7509,  7232,   192, 10240},
+    { 3482,  5468,  4169,  5241,  7509,  7232,   192, 10240},
+    {  787,  1010,  9162,  9369,  8844,  4698,  1321,  4912},
+    {  787,  1010,  9162,  9369,  8844,  4698,  1321,  4912},
+    {  885, 10333,  8757,    58, 12147,  8812,  2844,  4212},
+    {  885, 10333,  8757,    58, 12147,  8812,  2844,  4212},
+    { 6281,  7280, 11286, 12048, 11184,  6608,  3438, 11314},
+    { 6281,  7280, 11286, 12048, 11184,  6608,  3438, 11314},
+    { 8687,   421,  3600,  7665,  7507,  3029,  4213, 11684},
+    { 8687,   421,  3600,  7665,  7507,  3029,  4213, 11684},
+    { 6068,  8209,  3263,  6077,  5886,  6695,   504,  2302},
+    { 6068,  8209,  3263,  6077,  5886,  6695,   504,  2302},
+    { 1962,  6328,   168,  8960,  5184,  6122, 10929,  5297},
+    { 1962,  6328,   168,  8960,  5184,  6122, 10929,  5297},
+    { 1594,  7183,  2692,  4298, 11089,  9734,  3956,  6170},
+    { 1594,  7183,  2692,  4298, 11089,  9734,  3956,  6170},
+    { 3762,  4016,  6523, 11994,  1146, 11964,  6299,  8240},
+    { 3762,  4016,  6523, 11994,  1146, 11964,  6299,  8240},
+    { 9370,  4077,   652,  6099, 11341, 10885,  1159,  8561},
+    { 9370,  4077,   652,  6099, 11341, 10885,  1159,  8561},
+    {11177, 10331, 11367,  4079,  3150,  8243,  8049, 11454},
+    {11177, 10331, 11367,  4079,  3150,  8243,  8049, 11454},
+    { 2078,  4322,   441, 11231,  1319,   709,  8719,  6224},
+    { 2078,  4322,   441, 11231,  1319,   709,  8719,  6224},
+    { 3054,  3123,  4433,  7032,  8633,  9830,  1566,  9786},
+    { 3054,  3123,  4433,  7032,  8633,  9830,  1566,  9786},
+    { 6803, 10542,  6370,  3834, 12225,   683,  5782,  9341},
+    { 6803, 10542,  6370,  3834, 12225,   683,  5782,  9341},
+    {12115,  3009,  5735,  2738, 11942,  1975,  3315,  4754},
+    {12115,  3009,  5735,  2738, 11942,  1975,  3315,  4754},
+    {  723,  1693,  2655,  6421,  2925,  8532, 11863,  1858},
+    {  723,  1693,  2655,  6421,  2925,  8532, 11863,  1858},
+    { 1583,  2500,  6374, 12240,  1815, 10777,  6920,  4493},
+    { 1583,  2500,  6374, 12240,  1815, 10777,  6920,  4493},
+    { 6347, 10800,  1483,  1263,  5383,   350, 10232,  9087},
+    { 6347, 10800,  1483,  1263,  5383,   350, 10232,  9087},
+    { 8855,  9381,  9928,  9259,  6147,  8326, 10335, 10484},
+    { 8855,  9381,  9928,  9259,  6147,  8326, 10335, 10484},
+    { 8760,   218, 10446,  4115,  9842,   576, 10238,  9407},
+    { 8760,   218, 10446,  4115,  9842,   576, 10238,  9407},
+    { 6381,  8517,  6860,  1293,  2767,  8298, 10008,  5333},
+    { 6381,  8517,  6860,  1293,  2767,  8298, 10008,  5333},
+    {11836,   418,  7515,  7552,   156,  8320,  5876, 10258},
+    {11836,   418,  7515,  7552,   156,  8320,  5876, 10258},
+    { 4075,  5315,  4324,  4916, 10120, 11767,  7210,  9027},
+    { 4075,  5315,  4324,  4916, 10120, 11767,  7210,  9027},
+    { 4075,  5315,  4324,  4916, 10120, 11767,  7210,  9027},
+    { 4075,  5315,  4324,  4916, 10120, 11767,  7210,  9027},
+    {10316,  6715,  1278,  9945,  3514, 11248, 11271,  5925},
+    {10316,  6715,  1278,  9945,  3514, 11248, 11271,  5925},
+    {10316,  6715,  1278,  9945,  3514, 11248, 11271,  5925},
+    {10316,  6715,  1278,  9945,  3514, 11248, 11271,  5925},
+    {  147,  8500,  7840,  6833,  5537,  4749,  4467,  7500},
+    {  147,  8500,  7840,  6833,  5537,  4749,  4467,  7500},
+    {  147,  8500,  7840,  6833,  5537,  4749,  4467,  7500},
+    {  147,  8500,  7840,  6833,  5537,  4749,  4467,  7500},
+    {11099,  9606,  6171,  8471,  8429,  5445, 11239,  7753},
+    {11099,  9606,  6171,  8471,  8429,  5445, 11239,  7753},
+    {11099,  9606,  6171,  8471,  8429,  5445, 11239,  7753},
+    {11099,  9606,  6171,  8471,  8429,  5445, 11239,  7753},
+    { 9090, 12233,  5529,  5206, 10587,  1987, 11635,  3565},
+    { 9090, 12233,  5529,  5206, 10587,  1987, 11635,  3565},
+    { 9090, 12233,  5529,  5206, 10587,  1987, 11635,  3565},
+    { 9090, 12233,  5529,  5206, 10587,  1987, 11635,  3565},
+    { 5415,  8646,  6153,  6427,  7341,  6152, 10561,   400},
+    { 5415,  8646,  6153,  6427,  7341,  6152, 10561,   400},
+    { 5415,  8646,  6153,  6427,  7341,  6152, 10561,   400},
+    { 5415,  8646,  6153,  6427,  7341,  6152, 10561,   400},
+    { 8410,  1922,  2033,  8291,  1359,  6854, 11035,   973},
+    { 8410,  1922,  2033,  8291,  1359,  6854, 11035,   973},
+    { 8410,  1922,  2033,  8291,  1359,  6854, 11035,   973},
+    { 8410,  1922,  2033,  8291,  1359,  6854, 11035,   973},
+    { 8579,  6093,  6950,  5446, 11821,  8301, 11907,   316},
+    { 8579,  6093,  6950,  5446, 11821,  8301, 11907,   316},
+    { 8579,  6093,  6950,  5446, 11821,  8301, 11907,   316},
+    { 8579,  6093,  6950,  5446, 11821,  8301, 11907,   316},
+    {   52,  3174, 10966,  9523,  6055,  8953, 11612,  6415},
+    {   52,  3174, 10966,  9523,  6055,  8953, 11612,  6415},
+    {   52,  3174, 10966,  9523,  6055,  8953, 11612,  6415},
+    {   52,  3174, 10966,  9523,  6055,  8953, 11612,  6415},
+    { 2505,  5906, 10710, 11858,  8332,  9450, 10162,   151},
+    { 2505,  5906, 10710, 11858,  8332,  9450, 10162,   151},
+    { 2505,  5906, 10710, 11858,  8332,  9450, 10162,   151},
+    { 2505,  5906, 10710, 11858,  8332,  9450, 10162,   151},
+    { 3482,   787,  5468,  1010,  4169,  9162,  5241,  9369},
+    { 3482,   787,  5468,  1010,  4169,  9162,  5241,  9369},
+    { 3482,   787,  5468,  1010,  4169,  9162,  5241,  9369},
+    { 3482,   787,  5468,  1010,  4169,  9162,  5241,  9369},
+    { 7509,  8844,  7232,  4698,   192,  1321, 10240,  4912},
+    { 7509,  8844,  7232,  4698,   192,  1321, 10240,  4912},
+    { 7509,  8844,  7232,  4698,   192,  1321, 10240,  4912},
+    { 7509,  8844,  7232,  4698,   192,  1321, 10240,  4912},
+    {  885,  6281, 10333,  7280,  8757, 11286,    58, 12048},
+    {  885,  6281, 10333,  7280,  8757, 11286,    58, 12048},
+    {  885,  6281, 10333,  7280,  8757, 11286,    58, 12048},
+    {  885,  6281, 10333,  7280,  8757, 11286,    58, 12048},
+    {12147, 11184,  8812,  6608,  2844,  3438,  4212, 11314},
+    {12147, 11184,  8812,  6608,  2844,  3438,  4212, 11314},
+    {12147, 11184,  8812,  6608,  2844,  3438,  4212, 11314},
+    {12147, 11184,  8812,  6608,  2844,  3438,  4212, 11314},
+    { 8687,  6068,   421,  8209,  3600,  3263,  7665,  6077},
+    { 8687,  6068,   421,  8209,  3600,  3263,  7665,  6077},
+    { 8687,  6068,   421,  8209,  3600,  3263,  7665,  6077},
+    { 8687,  6068,   421,  8209,  3600,  3263,  7665,  6077},
+    { 7507,  5886,  3029,  6695,  4213,   504, 11684,  2302},
+    { 7507,  5886,  3029,  6695,  4213,   504, 11684,  2302},
+    { 7507,  5886,  3029,  6695,  4213,   504, 11684,  2302},
+    { 7507,  5886,  3029,  6695,  4213,   504, 11684,  2302}
+};
+
+/* Comparator network from batcher84() in batcher.c */
+static uint8_t const batcher84_pairs[904][2] = {
+    {0, 1}, {2, 3}, {0, 2}, {1, 3}, {1, 2}, {4, 5}, {6, 7},
+    {4, 6}, {5, 7}, {5, 6}, {0, 4}, {2, 6}, {2, 4}, {1, 5},
+    {3, 7}, {3, 5}, {1, 2}, {3, 4}, {5, 6}, {8, 9}, {10, 11},
+    {8, 10}, {9, 11}, {9, 10}, {12, 13}, {14, 15}, {12, 14}, {13, 15},
+    {13, 14}, {8, 12}, {10, 14}, {10, 12}, {9, 13}, {11, 15}, {11, 13},
+    {9, 10}, {11, 12}, {13, 14}, {0, 8}, {4, 12}, {4, 8}, {2, 10},
+    {6, 14}, {6, 10}, {2, 4}, {6, 8}, {10, 12}, {1, 9}, {5, 13},
+    {5, 9}, {3, 11}, {7, 15}, {7, 11}, {3, 5}, {7, 9}, {11, 13},
+    {1, 2}, {3, 4}, {5, 6}, {7, 8}, {9, 10}, {11, 12}, {13, 14},
+    {16, 17}, {18, 19}, {16, 18}, {17, 19}, {17, 18}, {20, 21}, {22, 23},
+    {20, 22}, {21, 23}, {21, 22}, {16, 20}, {18, 22}, {18, 20}, {17, 21},
+    {19, 23}, {19, 21}, {17, 18}, {19, 20}, {21, 22}, {24, 25}, {26, 27},
+    {24, 26}, {25, 27}, {25, 26}, {28, 29}, {30, 31}, {28, 30}, {29, 31},
+    {29, 30}, {24, 28}, {26, 30}, {26, 28}, {25, 29}, {27, 31}, {27, 29},
+    {25, 26}, {27, 28}, {29, 30}, {16, 24}, {20, 28}, {20, 24}, {18, 26},
+    {22, 30}, {22, 26}, {18, 20}, {22, 24}, {26, 28}, {17, 25}, {21, 29},
+    {21, 25}, {19, 27}, {23, 31}, {23, 27}, {19, 21}, {23, 25}, {27, 29},
+    {17, 18}, {19, 20}, {21, 22}, {23, 24}, {25, 26}, {27, 28}, {29, 30},
+    {0, 16}, {8, 24}, {8, 16}, {4, 20}, {12, 28}, {12, 20}, {4, 8},
+    {12, 16}, {20, 24}, {2, 18}, {10, 26}, {10, 18}, {6, 22}, {14, 30},
+    {14, 22}, {6, 10}, {14, 18}, {22, 26}, {2, 4}, {6, 8}, {10, 12},
+    {14, 16}, {18, 20}, {22, 24}, {26, 28}, {1, 17}, {9, 25}, {9, 17},
+    {5, 21}, {13, 29}, {13, 21}, {5, 9}, {13, 17}, {21, 25}, {3, 19},
+    {11, 27}, {11, 19}, {7, 23}, {15, 31}, {15, 23}, {7, 11}, {15, 19},
+    {23, 27}, {3, 5}, {7, 9}, {11, 13}, {15, 17}, {19, 21}, {23, 25},
+    {27, 29}, {1, 2}, {3, 4}, {5, 6}, {7, 8}, {9, 10}, {11, 12},
+    {13, 14}, {15, 16}, {17, 18}, {19, 20}, {21, 22}, {23, 24}, {25, 26},
+    {27, 28}, {29, 30}, {32, 33}, {34, 35}, {32, 34}, {33, 35}, {33, 34},
+    {36, 37}, {38, 39}, {36, 38}, {37, 39}, {37, 38}, {32, 36}, {34, 38},
+    {34, 36}, {33, 37}, {35, 39}, {35, 37}, {33, 34}, {35, 36}, {37, 38},
+    {40, 41}, {42, 43}, {40, 42}, {41, 43}, {41, 42}, {44, 45}, {46, 47},
+    {44, 46}, {45, 47}, {45, 46}, {40, 44}, {42, 46}, {42, 44}, {41, 45},
+    {43, 47}, {43, 45}, {41, 42}, {43, 44}, {45, 46}, {32, 40}, {36, 44},
+    {36, 40}, {34, 42}, {38, 46}, {38, 42}, {34, 36}, {38, 40}, {42, 44},
+    {33, 41}, {37, 45}, {37, 41}, {35, 43}, {39, 47}, {39, 43}, {35, 37},
+    {39, 41}, {43, 45}, {33, 34}, {35, 36}, {37, 38}, {39, 40}, {41, 42},
+    {43, 44}, {45, 46}, {48, 49}, {50, 51}, {48, 50}, {49, 51}, {49, 50},
+    {52, 53}, {54, 55}, {52, 54}, {53, 55}, {53, 54}, {48, 52}, {50, 54},
+    {50, 52}, {49, 53}, {51, 55}, {51, 53}, {49, 50}, {51, 52}, {53, 54},
+    {56, 57}, {58, 59}, {56, 58}, {57, 59}, {57, 58}, {60, 61}, {62, 63},
+    {60, 62}, {61, 63}, {61, 62}, {56, 60}, {58, 62}, {58, 60}, {57, 61},
+    {59, 63}, {59, 61}, {57, 58}, {59, 60}, {61, 62}, {48, 56}, {52, 60},
+    {52, 56}, {50, 58}, {54, 62}, {54, 58}, {50, 52}, {54, 56}, {58, 60},
+    {49, 57}, {53, 61}, {53, 57}, {51, 59}, {55, 63}, {55, 59}, {51, 53},
+    {55, 57}, {59, 61}, {49, 50}, {51, 52}, {53, 54}, {55, 56}, {57, 58},
+    {59, 60}, {61, 62}, {32, 48}, {40, 56}, {40, 48}, {36, 52}, {44, 60},
+    {44, 52}, {36, 40}, {44, 48}, {52, 56}, {34, 50}, {42, 58}, {42, 50},
+    {38, 54}, {46, 62}, {46, 54}, {38, 42}, {46, 50}, {54, 58}, {34, 36},
+    {38, 40}, {42, 44}, {46, 48}, {50, 52}, {54, 56}, {58, 60}, {33, 49},
+    {41, 57}, {41, 49}, {37, 53}, {45, 61}, {45, 53}, {37, 41}, {45, 49},
+    {53, 57}, {35, 51}, {43, 59}, {43, 51}, {39, 55}, {47, 63}, {47, 55},
+    {39, 43}, {47, 51}, {55, 59}, {35, 37}, {39, 41}, {43, 45}, {47, 49},
+    {51, 53}, {55, 57}, {59, 61}, {33, 34}, {35, 36}, {37, 38}, {39, 40},
+    {41, 42}, {43, 44}, {45, 46}, {47, 48}, {49, 50}, {51, 52}, {53, 54},
+    {55, 56}, {57, 58}, {59, 60}, {61, 62}, {0, 32}, {16, 48}, {16, 32},
+    {8, 40}, {24, 56}, {24, 40}, {8, 16}, {24, 32}, {40, 48}, {4, 36},
+    {20, 52}, {20, 36}, {12, 44}, {28, 60}, {28, 44}, {12, 20}, {28, 36},
+    {44, 52}, {4, 8}, {12, 16}, {20, 24}, {28, 32}, {36, 40}, {44, 48},
+    {52, 56}, {2, 34}, {18, 50}, {18, 34}, {10, 42}, {26, 58}, {26, 42},
+    {10, 18}, {26, 34}, {42, 50}, {6, 38}, {22, 54}, {22, 38}, {14, 46},
+    {30, 62}, {30, 46}, {14, 22}, {30, 38}, {46, 54}, {6, 10}, {14, 18},
+    {22, 26}, {30, 34}, {38, 42}, {46, 50}, {54, 58}, {2, 4}, {6, 8},
+    {10, 12}, {14, 16}, {18, 20}, {22, 24}, {26, 28}, {30, 32}, {34, 36},
+    {38, 40}, {42, 44}, {46, 48}, {50, 52}, {54, 56}, {58, 60}, {1, 33},
+    {17, 49}, {17, 33}, {9, 41}, {25, 57}, {25, 41}, {9, 17}, {25, 33},
+    {41, 49}, {5, 37}, {21, 53}, {21, 37}, {13, 45}, {29, 61}, {29, 45},
+    {13, 21}, {29, 37}, {45, 53}, {5, 9}, {13, 17}, {21, 25}, {29, 33},
+    {37, 41}, {45, 49}, {53, 57}, {3, 35}, {19, 51}, {19, 35}, {11, 43},
+    {27, 59}, {27, 43}, {11, 19}, {27, 35}, {43, 51}, {7, 39}, {23, 55},
+    {23, 39}, {15, 47}, {31, 63}, {31, 47}, {15, 23}, {31, 39}, {47, 55},
+    {7, 11}, {15, 19}, {23, 27}, {31, 35}, {39, 43}, {47, 51}, {55, 59},
+    {3, 5}, {7, 9}, {11, 13}, {15, 17}, {19, 21}, {23, 25}, {27, 29},
+    {31, 33}, {35, 37}, {39, 41}, {43, 45}, {47, 49}, {51, 53}, {55, 57},
+    {59, 61}, {1, 2}, {3, 4}, {5, 6}, {7, 8}, {9, 10}, {11, 12},
+    {13, 14}, {15, 16}, {17, 18}, {19, 20}, {21, 22}, {23, 24}, {25, 26},
+    {27, 28}, {29, 30}, {31, 32}, {33, 34}, {35, 36}, {37, 38}, {39, 40},
+    {41, 42}, {43, 44}, {45, 46}, {47, 48}, {49, 50}, {51, 52}, {53, 54},
+    {55, 56}, {57, 58}, {59, 60}, {61, 62}, {64, 65}, {66, 67}, {64, 66},
+    {65, 67}, {65, 66}, {68, 69}, {70, 71}, {68, 70}, {69, 71}, {69, 70},
+    {64, 68}, {66, 70}, {66, 68}, {65, 69}, {67, 71}, {67, 69}, {65, 66},
+    {67, 68}, {69, 70}, {72, 73}, {74, 75}, {72, 74}, {73, 75}, {73, 74},
+    {76, 77}, {78, 79}, {76, 78}, {77, 79}, {77, 78}, {72, 76}, {74, 78},
+    {74, 76}, {73, 77}, {75, 79}, {75, 77}, {73, 74}, {75, 76}, {77, 78},
+    {64, 72}, {68, 76}, {68, 72}, {66, 74}, {70, 78}, {70, 74}, {66, 68},
+    {70, 72}, {74, 76}, {65, 73}, {69, 77}, {69, 73}, {67, 75}, {71, 79},
+    {71, 75}, {67, 69}, {71, 73}, {75, 77}, {65, 66}, {67, 68}, {69, 70},
+    {71, 72}, {73, 74}, {75, 76}, {77, 78}, {80, 81}, {82, 83}, {80, 82},
+    {81, 83}, {81, 82}, {81, 82}, {81, 82}, {64, 80}, {72, 80}, {68, 72},
+    {76, 80}, {66, 82}, {74, 82}, {70, 74}, {78, 82}, {66, 68}, {70, 72},
+    {74, 76}, {78, 80}, {65, 81}, {73, 81}, {69, 73}, {77, 81}, {67, 83},
+    {75, 83}, {71, 75}, {79, 83}, {67, 69}, {71, 73}, {75, 77}, {79, 81},
+    {65, 66}, {67, 68}, {69, 70}, {71, 72}, {73, 74}, {75, 76}, {77, 78},
+    {79, 80}, {81, 82}, {72, 80}, {68, 72}, {76, 80}, {74, 82}, {70, 74},
+    {78, 82}, {66, 68}, {70, 72}, {74, 76}, {78, 80}, {73, 81}, {69, 73},
+    {77, 81}, {75, 83}, {71, 75}, {79, 83}, {67, 69}, {71, 73}, {75, 77},
+    {79, 81}, {65, 66}, {67, 68}, {69, 70}, {71, 72}, {73, 74}, {75, 76},
+    {77, 78}, {79, 80}, {81, 82}, {0, 64}, {32, 64}, {16, 80}, {48, 80},
+    {16, 32}, {48, 64}, {8, 72}, {40, 72}, {24, 40}, {56, 72}, {8, 16},
+    {24, 32}, {40, 48}, {56, 64}, {72, 80}, {4, 68}, {36, 68}, {20, 36},
+    {52, 68}, {12, 76}, {44, 76}, {28, 44}, {60, 76}, {12, 20}, {28, 36},
+    {44, 52}, {60, 68}, {4, 8}, {12, 16}, {20, 24}, {28, 32}, {36, 40},
+    {44, 48}, {52, 56}, {60, 64}, {68, 72}, {76, 80}, {2, 66}, {34, 66},
+    {18, 82}, {50, 82}, {18, 34}, {50, 66}, {10, 74}, {42, 74}, {26, 42},
+    {58, 74}, {10, 18}, {26, 34}, {42, 50}, {58, 66}, {74, 82}, {6, 70},
+    {38, 70}, {22, 38}, {54, 70}, {14, 78}, {46, 78}, {30, 46}, {62, 78},
+    {14, 22}, {30, 38}, {46, 54}, {62, 70}, {6, 10}, {14, 18}, {22, 26},
+    {30, 34}, {38, 42}, {46, 50}, {54, 58}, {62, 66}, {70, 74}, {78, 82},
+    {2, 4}, {6, 8}, {10, 12}, {14, 16}, {18, 20}, {22, 24}, {26, 28},
+    {30, 32}, {34, 36}, {38, 40}, {42, 44}, {46, 48}, {50, 52}, {54, 56},
+    {58, 60}, {62, 64}, {66, 68}, {70, 72}, {74, 76}, {78, 80}, {1, 65},
+    {33, 65}, {17, 81}, {49, 81}, {17, 33}, {49, 65}, {9, 73}, {41, 73},
+    {25, 41}, {57, 73}, {9, 17}, {25, 33}, {41, 49}, {57, 65}, {73, 81},
+    {5, 69}, {37, 69}, {21, 37}, {53, 69}, {13, 77}, {45, 77}, {29, 45},
+    {61, 77}, {13, 21}, {29, 37}, {45, 53}, {61, 69}, {5, 9}, {13, 17},
+    {21, 25}, {29, 33}, {37, 41}, {45, 49}, {53, 57}, {61, 65}, {69, 73},
+    {77, 81}, {3, 67}, {35, 67}, {19, 83}, {51, 83}, {19, 35}, {51, 67},
+    {11, 75}, {43, 75}, {27, 43}, {59, 75}, {11, 19}, {27, 35}, {43, 51},
+    {59, 67}, {75, 83}, {7, 71}, {39, 71}, {23, 39}, {55, 71}, {15, 79},
+    {47, 79}, {31, 47}, {63, 79}, {15, 23}, {31, 39}, {47, 55}, {63, 71},
+    {7, 11}, {15, 19}, {23, 27}, {31, 35}, {39, 43}, {47, 51}, {55, 59},
+    {63, 67}, {71, 75}, {79, 83}, {3, 5}, {7, 9}, {11, 13}, {15, 17},
+    {19, 21}, {23, 25}, {27, 29}, {31, 33}, {35, 37}, {39, 41}, {43, 45},
+    {47, 49}, {51, 53}, {55, 57}, {59, 61}, {63, 65}, {67, 69}, {71, 73},
+    {75, 77}, {79, 81}, {1, 2}, {3, 4}, {5, 6}, {7, 8}, {9, 10},
+    {11, 12}, {13, 14}, {15, 16}, {17, 18}, {19, 20}, {21, 22}, {23, 24},
+    {25, 26}, {27, 28}, {29, 30}, {31, 32}, {33, 34}, {35, 36}, {37, 38},
+    {39, 40}, {41, 42}, {43, 44}, {45, 46}, {47, 48}, {49, 50}, {51, 52},
+    {53, 54}, {55, 56}, {57, 58}, {59, 60}, {61, 62}, {63, 64}, {65, 66},
+    {67, 68}, {69, 70}, {71, 72}, {73, 74}, {75, 76}, {77, 78}, {79, 80},
+    {81, 82}
+};
+
+/* Constants for the reductions */
+#define NH_Q        12289
+#define NH_QINV     12287
+
+/* Loads 8 coefficients into 32-bit lanes */
+#define LOAD8(ptr) \
+    _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(ptr)))
+
+/* Packs two vectors of 8 coefficients back into 16 uint16_t values */
+AVX2 static inline void store16(uint16_t *ptr, __m256i lo, __m256i hi)
+{
+    __m256i x = _mm256_packus_epi32(lo, hi);
+    x = _mm256_permute4x64_epi64(x, 0xD8);
+    _mm256_storeu_si256((__m256i *)ptr, x);
+}
+
+/* Same as montgomery_reduce() in reduce.c */
+AVX2 static inline __m256i montgomery_reduce_x8(__m256i a)
+{
+    __m256i u = _mm256_mullo_epi32(a, _mm256_set1_epi32(NH_QINV));
+    u = _mm256_and_si256(u, _mm256_set1_epi32((1 << 18) - 1));
+    u = _mm256_mullo_epi32(u, _mm256_set1_epi32(NH_Q));
+    return _mm256_srli_epi32(_mm256_add_epi32(a, u), 18);
+}
+
+/* Same as barrett_reduce() in reduce.c, for 16-bit values in 32-bit lanes */
+AVX2 static inline __m256i barrett_reduce_x8(__m256i a)
+{
+    __m256i u = _mm256_add_epi32(_mm256_slli_epi32(a, 2), a);
+    u = _mm256_srli_epi32(u, 16);
+    u = _mm256_mullo_epi16(u, _mm256_set1_epi32(NH_Q));
+    return _mm256_and_si256(_mm256_sub_epi32(a, u), _mm256_set1_epi32(0xFFFF));
+}
+
+/* One butterfly of ntt() for 8 coefficient pairs.  Even levels leave
+   the sum unreduced and odd levels apply the Barrett reduction */
+AVX2 static inline void butterfly_x8(__m256i *a, __m256i *b, __m256i w, int odd)
+{
+    __m256i t = *a;
+    __m256i s = _mm256_and_si256(_mm256_add_epi32(t, *b),
+                                 _mm256_set1_epi32(0xFFFF));
+    __m256i d = _mm256_sub_epi32
+        (_mm256_add_epi32(t, _mm256_set1_epi32(3 * NH_Q)), *b);
+    *a = odd ? barrett_reduce_x8(s) : s;
+    *b = montgomery_reduce_x8(_mm256_mullo_epi32(w, d));
+}
+
+/* Transposes an 8x8 matrix of 32-bit values */
+AVX2 static inline void transpose_8x8(__m256i *r)
+{
+    __m256i t0, t1, t2, t3, t4, t5, t6, t7;
+    __m256i u0, u1, u2, u3, u4, u5, u6, u7;
+    t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+    t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+    t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+    t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+    t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+    t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+    t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+    t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+    u0 = _mm256_unpacklo_epi64(t0, t2);
+    u1 = _mm256_unpackhi_epi64(t0, t2);
+    u2 = _mm256_unpacklo_epi64(t1, t3);
+    u3 = _mm256_unpackhi_epi64(t1, t3);
+    u4 = _mm256_unpacklo_epi64(t4, t6);
+    u5 = _mm256_unpackhi_epi64(t4, t6);
+    u6 = _mm256_unpacklo_epi64(t5, t7);
+    u7 = _mm256_unpackhi_epi64(t5, t7);
+    r[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+    r[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+    r[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+    r[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+    r[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+    r[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+    r[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+    r[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+/* Same as ntt() in ntt.c, on coefficients in 32-bit lanes */
+AVX2 static void ntt_x8(__m256i *x, const uint16_t *omega,
+                        uint16_t const tiles[3 * 16 * 4][8])
+{
+    __m256i r[8];
+    __m256i w;
+    int g, level, k, s, dv;
+
+    /* Levels 0, 1, and 2 on transposed tiles of 64 coefficients.  After
+       the transpose, r[m] holds coefficient m of each 8-coefficient row */
+    for (g = 0; g < 16; ++g) {
+        const uint16_t (*t)[8] = tiles + g * 4;
+        memcpy(r, x + g * 8, sizeof(r));
+        transpose_8x8(r);
+        butterfly_x8(&r[0], &r[1], LOAD8(t[0]), 0);
+        butterfly_x8(&r[2], &r[3], LOAD8(t[1]), 0);
+        butterfly_x8(&r[4], &r[5], LOAD8(t[2]), 0);
+        butterfly_x8(&r[6], &r[7], LOAD8(t[3]), 0);
+        t += 16 * 4;
+        butterfly_x8(&r[0], &r[2], LOAD8(t[0]), 1);
+        butterfly_x8(&r[1], &r[3], LOAD8(t[1]), 1);
+        butterfly_x8(&r[4], &r[6], LOAD8(t[2]), 1);
+        butterfly_x8(&r[5], &r[7], LOAD8(t[3]), 1);
+        t += 16 * 4;
+        butterfly_x8(&r[0], &r[4], LOAD8(t[0]), 0);
+        butterfly_x8(&r[1], &r[5], LOAD8(t[1]), 0);
+        butterfly_x8(&r[2], &r[6], LOAD8(t[2]), 0);
+        butterfly_x8(&r[3], &r[7], LOAD8(t[3]), 0);
+        transpose_8x8(r);
+        memcpy(x + g * 8, r, sizeof(r));
+    }
+
+    /* The remaining levels have butterflies at least 8 apart, so each
+       vector of 8 coefficients shares a single twiddle factor */
+    for (level = 3; level < 10; ++level) {
+        dv = 1 << (level - 3);
+        for (k = 0; k < PARAM_N / (16 * dv); ++k) {
+            __m256i *a = x + k * 2 * dv;
+            w = _mm256_set1_epi32(omega[k]);
+            for (s = 0; s < dv; ++s)
+                butterfly_x8(&a[s], &a[s + dv], w, level & 1);
+        }
+    }
+}
+
+/* Montgomery multiplication of 8 coefficients by 8 factors */
+AVX2 static inline __m256i mul_coefficients_x8(__m256i x, const uint16_t *f)
+{
+    return montgomery_reduce_x8(_mm256_mullo_epi32(x, LOAD8(f)));
+}
+
+AVX2 static void poly_ntt_avx2(poly *r)
+{
+    __m256i x[PARAM_N / 8];
+    int i;
+    for (i = 0; i < PARAM_N / 8; ++i) {
+        x[i] = mul_coefficients_x8(LOAD8(r->coeffs + i * 8),
+                                   psis_bitrev_montgomery + i * 8);
+    }
+    ntt_x8(x, omegas_montgomery, omegas_tiles);
+    for (i = 0; i < PARAM_N / 8; i += 2)
+        store16(r->coeffs + i * 8, x[i], x[i + 1]);
+}
+
+AVX2 static void poly_invntt_avx2(poly *r)
+{
+    __m256i x[PARAM_N / 8];
+    int i;
+    bitrev_vector(r->coeffs);
+    for (i = 0; i < PARAM_N / 8; ++i)
+        x[i] = LOAD8(r->coeffs + i * 8);
+    ntt_x8(x, omegas_inv_montgomery, omegas_inv_tiles);
+    for (i = 0; i < PARAM_N / 8; i += 2) {
+        store16(r->coeffs + i * 8,
+                mul_coefficients_x8(x[i], psis_inv_montgomery + i * 8),
+                mul_coefficients_x8(x[i + 1], psis_inv_montgomery + i * 8 + 8));
+    }
+}
+
+AVX2 static void poly_pointwise_avx2(poly *r, const poly *a, const poly *b)
+{
+    __m256i t[2];
+    int i, j;
+    for (i = 0; i < PARAM_N; i += 16) {
+        for (j = 0; j < 2; ++j) {
+            __m256i bv = LOAD8(b->coeffs + i + j * 8);
+            bv = montgomery_reduce_x8
+                (_mm256_mullo_epi32(bv, _mm256_set1_epi32(3186)));
+            t[j] = montgomery_reduce_x8
+                (_mm256_mullo_epi32(LOAD8(a->coeffs + i + j * 8), bv));
+        }
+        store16(r->coeffs + i, t[0], t[1]);
+    }
+}
+
+AVX2 static void poly_add_avx2(poly *r, const poly *a, const poly *b)
+{
+    /* Barrett reduction on 16 coefficients at a time in 16-bit lanes */
+    const __m256i five = _mm256_set1_epi16(5);
+    const __m256i q = _mm256_set1_epi16(NH_Q);
+    int i;
+    for (i = 0; i < PARAM_N; i += 16) {
+        __m256i s = _mm256_add_epi16
+            (_mm256_loadu_si256((const __m256i *)(a->coeffs + i)),
+             _mm256_loadu_si256((const __m256i *)(b->coeffs + i)));
+        __m256i u = _mm256_mulhi_epu16(s, five);
+        s = _mm256_sub_epi16(s, _mm256_mullo_epi16(u, q));
+        _mm256_storeu_si256((__m256i *)(r->coeffs + i), s);
+    }
+}
+
+/* Rotates the 32-bit lanes of a vector left */
+#define ROTL32(x, bits) \
+    _mm256_or_si256(_mm256_slli_epi32((x), (bits)), \
+                    _mm256_srli_epi32((x), 32 - (bits)))
+#define ROTL32_BYTES(x, shuf) _mm256_shuffle_epi8((x), (shuf))
+
+#define QUARTERROUND_X8(a, b, c, d) \
+    do { \
+        (a) = _mm256_add_epi32((a), (b)); \
+        (d) = ROTL32_BYTES(_mm256_xor_si256((d), (a)), rot16); \
+        (c) = _mm256_add_epi32((c), (d)); \
+        (b) = ROTL32(_mm256_xor_si256((b), (c)), 12); \
+        (a) = _mm256_add_epi32((a), (b)); \
+        (d) = ROTL32_BYTES(_mm256_xor_si256((d), (a)), rot8); \
+        (c) = _mm256_add_epi32((c), (d)); \
+        (b) = ROTL32(_mm256_xor_si256((b), (c)), 7); \
+    } while (0)
+
+/* Converts 8 ChaCha20 output words into noise coefficients, with the
+   same binomial sampler as poly_getnoise() in poly.c */
+AVX2 static inline __m256i noise_x8(__m256i t)
+{
+    const __m256i m = _mm256_set1_epi32(0x01010101);
+    const __m256i ff = _mm256_set1_epi32(0xFF);
+    __m256i d = _mm256_and_si256(t, m);
+    __m256i a, b;
+    int j;
+    for (j = 1; j < 8; ++j)
+        d = _mm256_add_epi32(d, _mm256_and_si256(_mm256_srli_epi32(t, j), m));
+    a = _mm256_add_epi32(_mm256_and_si256(_mm256_srli_epi32(d, 8), ff),
+                         _mm256_and_si256(d, ff));
+    b = _mm256_add_epi32(_mm256_srli_epi32(d, 24),
+                         _mm256_and_si256(_mm256_srli_epi32(d, 16), ff));
+    return _mm256_sub_epi32(_mm256_add_epi32(a, _mm256_set1_epi32(NH_Q)), b);
+}
+
+AVX2 static void poly_getnoise_avx2(poly *r, unsigned char *seed, unsigned char nonce)
+{
+    static uint32_t const sigma[4] = {
+        0x61707865, 0x3320646e, 0x79622d32, 0x6b206574
+    };
+    const __m256i rot16 = _mm256_set_epi8
+        (13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2,
+         13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2);
+    const __m256i rot8 = _mm256_set_epi8
+        (14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3,
+         14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3);
+    __m256i init[16];
+    __m256i x[16];
+    uint32_t key[8];
+    int i, block, round;
+
+    /* Set up the initial state for blocks 0..7 of the stream, with the
+       nonce in the first byte of the 8-byte IV */
+    memcpy(key, seed, sizeof(key));
+    for (i = 0; i < 4; ++i)
+        init[i] = _mm256_set1_epi32((int)(sigma[i]));
+    for (i = 0; i < 8; ++i)
+        init[i + 4] = _mm256_set1_epi32((int)(key[i]));
+    init[12] = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    init[13] = _mm256_setzero_si256();
+    init[14] = _mm256_set1_epi32(nonce);
+    init[15] = _mm256_setzero_si256();
+
+    for (block = 0; block < PARAM_N / 16; block += 8) {
+        memcpy(x, init, sizeof(x));
+        for (round = 0; round < 20; round += 2) {
+            QUARTERROUND_X8(x[0], x[4], x[8], x[12]);
+            QUARTERROUND_X8(x[1], x[5], x[9], x[13]);
+            QUARTERROUND_X8(x[2], x[6], x[10], x[14]);
+            QUARTERROUND_X8(x[3], x[7], x[11], x[15]);
+            QUARTERROUND_X8(x[0], x[5], x[10], x[15]);
+            QUARTERROUND_X8(x[1], x[6], x[11], x[12]);
+            QUARTERROUND_X8(x[2], x[7], x[8], x[13]);
+            QUARTERROUND_X8(x[3], x[4], x[9], x[14]);
+        }
+        for (i = 0; i < 16; ++i)
+            x[i] = noise_x8(_mm256_add_epi32(x[i], init[i]));
+
+        /* x[w] holds word w of 8 consecutive blocks.  Transpose so that
+           x[b] and x[b + 8] hold the 16 words of block b */
+        transpose_8x8(x);
+        transpose_8x8(x + 8);
+        for (i = 0; i < 8; ++i)
+            store16(r->coeffs + (block + i) * 16, x[i], x[i + 8]);
+        init[12] = _mm256_add_epi32(init[12], _mm256_set1_epi32(8));
+    }
+    memset(x, 0, sizeof(x));
+    memset(init, 0, sizeof(init));
+    memset(key, 0, sizeof(key));
+}
+
+/* Same as discardtopoly() in poly.c.  Row i of the 84x16 matrix of
+   candidate coefficients is one vector, and the comparator network runs
+   down all 16 columns at once */
+AVX2 static int discardtopoly_avx2(poly *a, const unsigned char *buf)
+{
+    const __m256i sign = _mm256_set1_epi16((short)0x8000);
+    const __m256i limit = _mm256_set1_epi16((short)(61444 ^ 0x8000));
+    __m256i rows[84];
+    __m256i c, t;
+    int i;
+
+    for (i = 0; i < 84; ++i)
+        rows[i] = _mm256_loadu_si256((const __m256i *)(buf + i * 32));
+
+    /* Move values that are 5q or higher down the column */
+    for (i = 0; i < (int)(sizeof(batcher84_pairs) / 2); ++i) {
+        __m256i *x = rows + batcher84_pairs[i][0];
+        __m256i *y = rows + batcher84_pairs[i][1];
+        c = _mm256_cmpgt_epi16(_mm256_xor_si256(*x, sign), limit);
+        t = _mm256_and_si256(_mm256_xor_si256(*x, *y), c);
+        *x = _mm256_xor_si256(*x, t);
+        *y = _mm256_xor_si256(*y, t);
+    }
+
+    /* Check whether we're safe */
+    c = _mm256_cmpgt_epi16(_mm256_xor_si256(rows[63], sign), limit);
+    if (!_mm256_testz_si256(c, c))
+        return -1;
+
+    /* If we are, copy coefficients to polynomial */
+    for (i = 0; i < PARAM_N / 16; ++i)
+        _mm256_storeu_si256((__m256i *)(a->coeffs + i * 16), rows[i]);
+    return 0;
+}
+
+AVX2 static void poly_uniform_avx2(poly *a, const unsigned char *seed)
+{
+    uint64_t state[25];
+    unsigned char buf[SHAKE128_RATE * 16];
+
+    shake128_absorb(state, seed, NEWHOPE_SEEDBYTES);
+    do {
+        shake128_squeezeblocks(buf, 16, state);
+    } while (discardtopoly_avx2(a, buf));
+}
+
+const poly_ops poly_ops_avx2 = {
+    poly_uniform_avx2,
+    poly_getnoise_avx2,
+    poly_add_avx2,
+    poly_ntt_avx2,
+    poly_invntt_avx2,
+    poly_pointwise_avx2
+};
+
+#endif /* NEWHOPE_HAVE_AVX2 */
@@ -41,15 +41,15 @@ static void decode_b(poly *b, poly *c, const unsigned char *r)
   }
 }
 
-static void gen_a(poly *a, const unsigned char *seed)
+static void gen_a(poly *a, const unsigned char *seed, const poly_ops *ops)
 {
-    poly_uniform(a,seed);
+    ops->uniform(a,seed);
 }
 
 
 // API FUNCTIONS 
 
-void newhope_keygen(unsigned char *send, poly *sk, const unsigned char *random_data)
+void newhope_keygen(unsigned char *send, poly *sk, const unsigned char *random_data, const poly_ops *ops)
 {
   poly a, e, r, pk;
   unsigned char seed[NEWHOPE_SEEDBYTES];
@@ -67,22 +67,22 @@ void newhope_keygen(unsigned char *send, poly *sk, const unsigned char *random_d
   }
   sha3256(seed, seed, NEWHOPE_SEEDBYTES); /* Don't send output of system RNG */
 
-  gen_a(&a, seed);
+  gen_a(&a, seed, ops);
 
-  poly_getnoise(sk,noiseseed,0);
-  poly_ntt(sk);
+  ops->getnoise(sk,noiseseed,0);
+  ops->ntt(sk);
   
-  poly_getnoise(&e,noiseseed,1);
-  poly_ntt(&e);
+  ops->getnoise(&e,noiseseed,1);
+  ops->ntt(&e);
 
-  poly_pointwise(&r,sk,&a);
-  poly_add(&pk,&e,&r);
+  ops->pointwise(&r,sk,&a);
+  ops->add(&pk,&e,&r);
 
   encode_a(send, &pk, seed);
 }
 
 
-void newhope_sharedb(unsigned char *sharedkey, unsigned char *send, const unsigned char *received, const unsigned char *random_data)
+void newhope_sharedb(unsigned char *sharedkey, unsigned char *send, const unsigned char *received, const unsigned char *random_data, const poly_ops *ops)
 {
   poly sp, ep, v, a, pka, c, epp, bp;
   unsigned char seed[NEWHOPE_SEEDBYTES];
@@ -94,21 +94,21 @@ void newhope_sharedb(unsigned char *sharedkey, unsigned char *send, const unsign
     randombytes(noiseseed, 32);
 
   decode_a(&pka, seed, received);
-  gen_a(&a, seed);
+  gen_a(&a, seed, ops);
 
-  poly_getnoise(&sp,noiseseed,0);
-  poly_ntt(&sp);
-  poly_getnoise(&ep,noiseseed,1);
-  poly_ntt(&ep);
+  ops->getnoise(&sp,noiseseed,0);
+  ops->ntt(&sp);
+  ops->getnoise(&ep,noiseseed,1);
+  ops->ntt(&ep);
 
-  poly_pointwise(&bp, &a, &sp);
-  poly_add(&bp, &bp, &ep);
+  ops->pointwise(&bp, &a, &sp);
+  ops->add(&bp, &bp, &ep);
   
-  poly_pointwise(&v, &pka, &sp);
-  poly_invntt(&v);
+  ops->pointwise(&v, &pka, &sp);
+  ops->invntt(&v);
 
-  poly_getnoise(&epp,noiseseed,2);
-  poly_add(&v, &v, &epp);
+  ops->getnoise(&epp,noiseseed,2);
+  ops->add(&v, &v, &epp);
 
   helprec(&c, &v, noiseseed, 3);
 
@@ -122,14 +122,14 @@ void newhope_sharedb(unsigned char *sharedkey, unsigned char *send, const unsign
 }
 
 
-void newhope_shareda(unsigned char *sharedkey, const poly *sk, const unsigned char *received)
+void newhope_shareda(unsigned char *sharedkey, const poly *sk, const unsigned char *received, const poly_ops *ops)
 {
   poly v,bp, c;
 
   decode_b(&bp, &c, received);
 
-  poly_pointwise(&v,sk,&bp);
-  poly_invntt(&v);
+  ops->pointwise(&v,sk,&bp);
+  ops->invntt(&v);
  
   rec(sharedkey, &v, &c);
 
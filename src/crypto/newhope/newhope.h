@@ -8,8 +8,8 @@
 #include <math.h>
 #include <stdio.h>
 
-void newhope_keygen(unsigned char *send, poly *sk, const unsigned char *random_data);
-void newhope_sharedb(unsigned char *sharedkey, unsigned char *send, const unsigned char *received, const unsigned char *random_data);
-void newhope_shareda(unsigned char *sharedkey, const poly *ska, const unsigned char *received);
+void newhope_keygen(unsigned char *send, poly *sk, const unsigned char *random_data, const poly_ops *ops);
+void newhope_sharedb(unsigned char *sharedkey, unsigned char *send, const unsigned char *received, const unsigned char *random_data, const poly_ops *ops);
+void newhope_shareda(unsigned char *sharedkey, const poly *ska, const unsigned char *received, const poly_ops *ops);
 
 #endif
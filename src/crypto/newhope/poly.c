@@ -158,3 +158,12 @@ void poly_invntt(poly *r)
   ntt((uint16_t *)r->coeffs, omegas_inv_montgomery);
   mul_coefficients(r->coeffs, psis_inv_montgomery);
 }
+
+const poly_ops poly_ops_ref = {
+  poly_uniform,
+  poly_getnoise,
+  poly_add,
+  poly_ntt,
+  poly_invntt,
+  poly_pointwise
+};
@@ -19,4 +19,25 @@ void poly_pointwise(poly *r, const poly *a, const poly *b);
 void poly_frombytes(poly *r, const unsigned char *a);
 void poly_tobytes(unsigned char *r, const poly *p);
 
+/* The polynomial operations that newhope.c uses, so that it can run with
+   either the portable versions above or a vectorized implementation */
+typedef struct {
+  void (*uniform)(poly *a, const unsigned char *seed);
+  void (*getnoise)(poly *r, unsigned char *seed, unsigned char nonce);
+  void (*add)(poly *r, const poly *a, const poly *b);
+  void (*ntt)(poly *r);
+  void (*invntt)(poly *r);
+  void (*pointwise)(poly *r, const poly *a, const poly *b);
+} poly_ops;
+
+extern const poly_ops poly_ops_ref;
+
+/* AVX2 versions in newhope-avx2.c, which produce identical results.  The
+   caller is responsible for checking that the CPU supports AVX2 */
+#if (defined(__GNUC__) || defined(__clang__)) && \
+        (defined(__x86_64__) || defined(__i386__))
+#define NEWHOPE_HAVE_AVX2 1
+extern const poly_ops poly_ops_avx2;
+#endif
+
 #endif
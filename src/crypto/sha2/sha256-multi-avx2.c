@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+    Multi-buffer SHA-256 compression function using AVX2.
+
+    Eight independent SHA-256 contexts are advanced at once, with one
+    32-bit lane of each 256-bit register belonging to each context.
+    The hash state and message blocks are transposed into this layout
+    with an 8x8 word transpose, after which the round function is the
+    scalar algorithm applied to all lanes in parallel.  This is slower
+    than a single-stream implementation for one message but gives a
+    much higher aggregate rate when many short messages need to be
+    hashed at the same time, such as the HMAC computations of a batch
+    of handshakes.  The function is compiled with a target attribute
+    so that the rest of the library can still run on CPUs without AVX2.
+*/
+
+#include "sha256.h"
+
+#if SHA256_HAVE_AVX2
+
+#include <immintrin.h>
+
+static uint32_t const k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/* Transpose an 8x8 matrix of 32-bit words held in eight registers */
+#define transpose8x8(r0, r1, r2, r3, r4, r5, r6, r7) \
+    do { \
+        __m256i t0 = _mm256_unpacklo_epi32((r0), (r1)); \
+        __m256i t1 = _mm256_unpackhi_epi32((r0), (r1)); \
+        __m256i t2 = _mm256_unpacklo_epi32((r2), (r3)); \
+        __m256i t3 = _mm256_unpackhi_epi32((r2), (r3)); \
+        __m256i t4 = _mm256_unpacklo_epi32((r4), (r5)); \
+        __m256i t5 = _mm256_unpackhi_epi32((r4), (r5)); \
+        __m256i t6 = _mm256_unpacklo_epi32((r6), (r7)); \
+        __m256i t7 = _mm256_unpackhi_epi32((r6), (r7)); \
+        __m256i u0 = _mm256_unpacklo_epi64(t0, t2); \
+        __m256i u1 = _mm256_unpackhi_epi64(t0, t2); \
+        __m256i u2 = _mm256_unpacklo_epi64(t1, t3); \
+        __m256i u3 = _mm256_unpackhi_epi64(t1, t3); \
+        __m256i u4 = _mm256_unpacklo_epi64(t4, t6); \
+        __m256i u5 = _mm256_unpackhi_epi64(t4, t6); \
+        __m256i u6 = _mm256_unpacklo_epi64(t5, t7); \
+        __m256i u7 = _mm256_unpackhi_epi64(t5, t7); \
+        (r0) = _mm256_permute2x128_si256(u0, u4, 0x20); \
+        (r1) = _mm256_permute2x128_si256(u1, u5, 0x20); \
+        (r2) = _mm256_permute2x128_si256(u2, u6, 0x20); \
+        (r3) = _mm256_permute2x128_si256(u3, u7, 0x20); \
+        (r4) = _mm256_permute2x128_si256(u0, u4, 0x31); \
+        (r5) = _mm256_permute2x128_si256(u1, u5, 0x31); \
+        (r6) = _mm256_permute2x128_si256(u2, u6, 0x31); \
+        (r7) = _mm256_permute2x128_si256(u3, u7, 0x31); \
+    } while (0)
+
+#define rightRotate(v, n) \
+    _mm256_or_si256(_mm256_srli_epi32((v), (n)), \
+                    _mm256_slli_epi32((v), 32 - (n)))
+
+/* Load 32 bytes from each of the eight blocks and convert them into
+   eight registers of big-endian message words, one lane per block */
+#define loadWords(w, offset) \
+    do { \
+        (w)[0] = _mm256_loadu_si256((const __m256i *)(blocks[0] + (offset))); \
+        (w)[1] = _mm256_loadu_si256((const __m256i *)(blocks[1] + (offset))); \
+        (w)[2] = _mm256_loadu_si256((const __m256i *)(blocks[2] + (offset))); \
+        (w)[3] = _mm256_loadu_si256((const __m256i *)(blocks[3] + (offset))); \
+        (w)[4] = _mm256_loadu_si256((const __m256i *)(blocks[4] + (offset))); \
+        (w)[5] = _mm256_loadu_si256((const __m256i *)(blocks[5] + (offset))); \
+        (w)[6] = _mm256_loadu_si256((const __m256i *)(blocks[6] + (offset))); \
+        (w)[7] = _mm256_loadu_si256((const __m256i *)(blocks[7] + (offset))); \
+        transpose8x8((w)[0], (w)[1], (w)[2], (w)[3], \
+                     (w)[4], (w)[5], (w)[6], (w)[7]); \
+        (w)[0] = _mm256_shuffle_epi8((w)[0], bswap); \
+        (w)[1] = _mm256_shuffle_epi8((w)[1], bswap); \
+        (w)[2] = _mm256_shuffle_epi8((w)[2], bswap); \
+        (w)[3] = _mm256_shuffle_epi8((w)[3], bswap); \
+        (w)[4] = _mm256_shuffle_epi8((w)[4], bswap); \
+        (w)[5] = _mm256_shuffle_epi8((w)[5], bswap); \
+        (w)[6] = _mm256_shuffle_epi8((w)[6], bswap); \
+        (w)[7] = _mm256_shuffle_epi8((w)[7], bswap); \
+    } while (0)
+
+/* Extend the message schedule by one word in the circular buffer */
+#define SHA256_SCHEDULE(n) \
+    (w[(n) & 15] = _mm256_add_epi32 \
+        (_mm256_add_epi32(w[(n) & 15], w[((n) + 9) & 15]), \
+         _mm256_add_epi32 \
+            (_mm256_xor_si256 \
+                (_mm256_xor_si256(rightRotate(w[((n) + 1) & 15], 7), \
+                                  rightRotate(w[((n) + 1) & 15], 18)), \
+                 _mm256_srli_epi32(w[((n) + 1) & 15], 3)), \
+             _mm256_xor_si256 \
+                (_mm256_xor_si256(rightRotate(w[((n) + 14) & 15], 17), \
+                                  rightRotate(w[((n) + 14) & 15], 19)), \
+                 _mm256_srli_epi32(w[((n) + 14) & 15], 10)))))
+
+/* Round function applied to all eight lanes */
+#define SHA256_ROUND(a, b, c, d, e, f, g, h, n) \
+    do { \
+        temp1 = _mm256_add_epi32 \
+            (_mm256_add_epi32((h), _mm256_set1_epi32((int)k[index + (n)])), \
+             w[(n)]); \
+        temp1 = _mm256_add_epi32 \
+            (temp1, _mm256_xor_si256 \
+                (_mm256_xor_si256(rightRotate((e), 6), rightRotate((e), 11)), \
+                 rightRotate((e), 25))); \
+        temp1 = _mm256_add_epi32 \
+            (temp1, _mm256_xor_si256(_mm256_and_si256((e), (f)), \
+                                     _mm256_andnot_si256((e), (g)))); \
+        temp2 = _mm256_add_epi32 \
+            (_mm256_xor_si256 \
+                (_mm256_xor_si256(rightRotate((a), 2), rightRotate((a), 13)), \
+                 rightRotate((a), 22)), \
+             _mm256_or_si256(_mm256_and_si256((a), (b)), \
+                             _mm256_and_si256(_mm256_or_si256((a), (b)), (c)))); \
+        (d) = _mm256_add_epi32((d), temp1); \
+        (h) = _mm256_add_epi32(temp1, temp2); \
+    } while (0)
+
+__attribute__((target("avx2")))
+void sha256_transform_x8_avx2
+    (sha256_context_t **contexts, const uint8_t **blocks)
+{
+    const __m256i bswap = _mm256_set_epi8
+        (12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+         12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+    __m256i a, b, c, d, e, f, g, h;
+    __m256i a0, b0, c0, d0, e0, f0, g0, h0;
+    __m256i temp1, temp2;
+    __m256i w[16];
+    unsigned index;
+
+    /* Transpose the hash states so that each register holds one word
+       of the state from all eight contexts */
+    a = _mm256_loadu_si256((const __m256i *)(contexts[0]->h));
+    b = _mm256_loadu_si256((const __m256i *)(contexts[1]->h));
+    c = _mm256_loadu_si256((const __m256i *)(contexts[2]->h));
+    d = _mm256_loadu_si256((const __m256i *)(contexts[3]->h));
+    e = _mm256_loadu_si256((const __m256i *)(contexts[4]->h));
+    f = _mm256_loadu_si256((const __m256i *)(contexts[5]->h));
+    g = _mm256_loadu_si256((const __m256i *)(contexts[6]->h));
+    h = _mm256_loadu_si256((const __m256i *)(contexts[7]->h));
+    transpose8x8(a, b, c, d, e, f, g, h);
+    a0 = a; b0 = b; c0 = c; d0 = d;
+    e0 = e; f0 = f; g0 = g; h0 = h;
+
+    /* Load the 16 message words from each block */
+    loadWords(w, 0);
+    loadWords(w + 8, 32);
+
+    /* The first 16 rounds use the message words directly */
+    index = 0;
+    SHA256_ROUND(a, b, c, d, e, f, g, h, 0);
+    SHA256_ROUND(h, a, b, c, d, e, f, g, 1);
+    SHA256_ROUND(g, h, a, b, c, d, e, f, 2);
+    SHA256_ROUND(f, g, h, a, b, c, d, e, 3);
+    SHA256_ROUND(e, f, g, h, a, b, c, d, 4);
+    SHA256_ROUND(d, e, f, g, h, a, b, c, 5);
+    SHA256_ROUND(c, d, e, f, g, h, a, b, 6);
+    SHA256_ROUND(b, c, d, e, f, g, h, a, 7);
+    SHA256_ROUND(a, b, c, d, e, f, g, h, 8);
+    SHA256_ROUND(h, a, b, c, d, e, f, g, 9);
+    SHA256_ROUND(g, h, a, b, c, d, e, f, 10);
+    SHA256_ROUND(f, g, h, a, b, c, d, e, 11);
+    SHA256_ROUND(e, f, g, h, a, b, c, d, 12);
+    SHA256_ROUND(d, e, f, g, h, a, b, c, 13);
+    SHA256_ROUND(c, d, e, f, g, h, a, b, 14);
+    SHA256_ROUND(b, c, d, e, f, g, h, a, 15);
+
+    /* The remaining 48 rounds extend the schedule in place as they go */
+    for (index = 16; index < 64; index += 16) {
+        SHA256_SCHEDULE(0);  SHA256_ROUND(a, b, c, d, e, f, g, h, 0);
+        SHA256_SCHEDULE(1);  SHA256_ROUND(h, a, b, c, d, e, f, g, 1);
+        SHA256_SCHEDULE(2);  SHA256_ROUND(g, h, a, b, c, d, e, f, 2);
+        SHA256_SCHEDULE(3);  SHA256_ROUND(f, g, h, a, b, c, d, e, 3);
+        SHA256_SCHEDULE(4);  SHA256_ROUND(e, f, g, h, a, b, c, d, 4);
+        SHA256_SCHEDULE(5);  SHA256_ROUND(d, e, f, g, h, a, b, c, 5);
+        SHA256_SCHEDULE(6);  SHA256_ROUND(c, d, e, f, g, h, a, b, 6);
+        SHA256_SCHEDULE(7);  SHA256_ROUND(b, c, d, e, f, g, h, a, 7);
+        SHA256_SCHEDULE(8);  SHA256_ROUND(a, b, c, d, e, f, g, h, 8);
+        SHA256_SCHEDULE(9);  SHA256_ROUND(h, a, b, c, d, e, f, g, 9);
+        SHA256_SCHEDULE(10); SHA256_ROUND(g, h, a, b, c, d, e, f, 10);
+        SHA256_SCHEDULE(11); SHA256_ROUND(f, g, h, a, b, c, d, e, 11);
+        SHA256_SCHEDULE(12); SHA256_ROUND(e, f, g, h, a, b, c, d, 12);
+        SHA256_SCHEDULE(13); SHA256_ROUND(d, e, f, g, h, a, b, c, 13);
+        SHA256_SCHEDULE(14); SHA256_ROUND(c, d, e, f, g, h, a, b, 14);
+        SHA256_SCHEDULE(15); SHA256_ROUND(b, c, d, e, f, g, h, a, 15);
+    }
+
+    /* Add the compressed chunk to the current hash values and transpose
+       them back into the per-context layout */
+    a = _mm256_add_epi32(a, a0);
+    b = _mm256_add_epi32(b, b0);
+    c = _mm256_add_epi32(c, c0);
+    d = _mm256_add_epi32(d, d0);
+    e = _mm256_add_epi32(e, e0);
+    f = _mm256_add_epi32(f, f0);
+    g = _mm256_add_epi32(g, g0);
+    h = _mm256_add_epi32(h, h0);
+    transpose8x8(a, b, c, d, e, f, g, h);
+    _mm256_storeu_si256((__m256i *)(contexts[0]->h), a);
+    _mm256_storeu_si256((__m256i *)(contexts[1]->h), b);
+    _mm256_storeu_si256((__m256i *)(contexts[2]->h), c);
+    _mm256_storeu_si256((__m256i *)(contexts[3]->h), d);
+    _mm256_storeu_si256((__m256i *)(contexts[4]->h), e);
+    _mm256_storeu_si256((__m256i *)(contexts[5]->h), f);
+    _mm256_storeu_si256((__m256i *)(contexts[6]->h), g);
+    _mm256_storeu_si256((__m256i *)(contexts[7]->h), h);
+}
+
+#endif /* SHA256_HAVE_AVX2 */
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+    SHA-256 compression function using the Intel SHA extensions.
+
+    The state is rearranged into the ABEF/CDGH register layout that the
+    sha256rnds2 instruction expects, and the message schedule is computed
+    four words at a time with sha256msg1 and sha256msg2 while the rounds
+    for the previous words are in flight.  The function is compiled with
+    a target attribute so that the rest of the library can still run on
+    CPUs without the SHA extensions.
+*/
+
+#include "sha256.h"
+
+#if SHA256_HAVE_SHANI
+
+#include <immintrin.h>
+
+static uint32_t const k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/* Perform four rounds using the message words in "cur".  If "msg2" is
+   set, then the schedule for "next" is completed from "prev" and "cur".
+   If "msg1" is set, then the schedule for "prev" is started from "cur" */
+#define SHA256_ROUNDS4(n, cur, prev, next, msg2, msg1) \
+    do { \
+        msg = _mm_add_epi32 \
+            ((cur), _mm_loadu_si128((const __m128i *)&(k[(n) * 4]))); \
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg); \
+        if (msg2) { \
+            tmp = _mm_alignr_epi8((cur), (prev), 4); \
+            (next) = _mm_add_epi32((next), tmp); \
+            (next) = _mm_sha256msg2_epu32((next), (cur)); \
+        } \
+        msg = _mm_shuffle_epi32(msg, 0x0E); \
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg); \
+        if (msg1) \
+            (prev) = _mm_sha256msg1_epu32((prev), (cur)); \
+    } while (0)
+
+__attribute__((target("sha,sse4.1")))
+void sha256_transform_shani(sha256_context_t *context, const uint8_t *m)
+{
+    const __m128i bswap = _mm_set_epi64x
+        (0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i state0, state1, abef, cdgh;
+    __m128i msg, tmp, m0, m1, m2, m3;
+
+    /* Convert the state from ABCD/EFGH into ABEF/CDGH order */
+    tmp = _mm_loadu_si128((const __m128i *)&(context->h[0]));
+    state1 = _mm_loadu_si128((const __m128i *)&(context->h[4]));
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);
+    state1 = _mm_shuffle_epi32(state1, 0x1B);
+    state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+    abef = state0;
+    cdgh = state1;
+
+    /* Load the 16 message words and convert them from big endian */
+    m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(m + 0)), bswap);
+    m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(m + 16)), bswap);
+    m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(m + 32)), bswap);
+    m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(m + 48)), bswap);
+
+    /* Perform the 64 rounds, four at a time */
+    SHA256_ROUNDS4( 0, m0, m3, m1, 0, 0);
+    SHA256_ROUNDS4( 1, m1, m0, m2, 0, 1);
+    SHA256_ROUNDS4( 2, m2, m1, m3, 0, 1);
+    SHA256_ROUNDS4( 3, m3, m2, m0, 1, 1);
+    SHA256_ROUNDS4( 4, m0, m3, m1, 1, 1);
+    SHA256_ROUNDS4( 5, m1, m0, m2, 1, 1);
+    SHA256_ROUNDS4( 6, m2, m1, m3, 1, 1);
+    SHA256_ROUNDS4( 7, m3, m2, m0, 1, 1);
+    SHA256_ROUNDS4( 8, m0, m3, m1, 1, 1);
+    SHA256_ROUNDS4( 9, m1, m0, m2, 1, 1);
+    SHA256_ROUNDS4(10, m2, m1, m3, 1, 1);
+    SHA256_ROUNDS4(11, m3, m2, m0, 1, 1);
+    SHA256_ROUNDS4(12, m0, m3, m1, 1, 1);
+    SHA256_ROUNDS4(13, m1, m0, m2, 1, 0);
+    SHA256_ROUNDS4(14, m2, m1, m3, 1, 0);
+    SHA256_ROUNDS4(15, m3, m2, m0, 0, 0);
+
+    /* Add the compressed chunk to the current hash value */
+    state0 = _mm_add_epi32(state0, abef);
+    state1 = _mm_add_epi32(state1, cdgh);
+
+    /* Convert the state back into ABCD/EFGH order */
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+    _mm_storeu_si128((__m128i *)&(context->h[0]), state0);
+    _mm_storeu_si128((__m128i *)&(context->h[4]), state1);
+}
+
+#endif /* SHA256_HAVE_SHANI */
@@ -126,12 +126,17 @@ static void sha256_transform(sha256_context_t *context, const uint8_t *m)
     context->h[7] += h;
 }
 
-void sha256_update(sha256_context_t *context, const void *data, size_t size)
+/* Function that compresses a single block */
+typedef void (*sha256_transform_t)(sha256_context_t *context, const uint8_t *m);
+
+static void sha256_update_with
+    (sha256_context_t *context, const void *data, size_t size,
+     sha256_transform_t transform)
 {
     const uint8_t *d = (const uint8_t *)data;
     while (size > 0) {
         if (context->posn == 0 && size >= 64) {
-            sha256_transform(context, d);
+            (*transform)(context, d);
             d += 64;
             size -= 64;
             context->length += 64 * 8;
@@ -142,7 +147,7 @@ void sha256_update(sha256_context_t *context, const void *data, size_t size)
             memcpy(context->m + context->posn, d, temp);
             context->posn += temp;
             if (context->posn >= 64) {
-                sha256_transform(context, context->m);
+                (*transform)(context, context->m);
                 context->posn = 0;
             }
             d += temp;
@@ -160,7 +165,9 @@ static void write_be32(uint8_t *out, uint32_t value)
     out[3] = (uint8_t)value;
 }
 
-void sha256_finish(sha256_context_t *context, uint8_t *hash)
+static void sha256_finish_with
+    (sha256_context_t *context, uint8_t *hash,
+     sha256_transform_t transform)
 {
     uint8_t posn = context->posn;
     if (posn <= (64 - 9)) {
@@ -169,13 +176,150 @@ void sha256_finish(sha256_context_t *context, uint8_t *hash)
     } else {
         context->m[posn] = 0x80;
         memset(context->m + posn + 1, 0, 64 - (posn + 1));
-        sha256_transform(context, context->m);
+        (*transform)(context, context->m);
         memset(context->m, 0, 64 - 8);
     }
     write_be32(context->m + 64 - 8, (uint32_t)(context->length >> 32));
     write_be32(context->m + 64 - 4, (uint32_t)context->length);
-    sha256_transform(context, context->m);
+    (*transform)(context, context->m);
     context->posn = 0;
     for (posn = 0; posn < 8; ++posn)
         write_be32(hash + posn * 4, context->h[posn]);
 }
+
+void sha256_update(sha256_context_t *context, const void *data, size_t size)
+{
+    sha256_update_with(context, data, size, sha256_transform);
+}
+
+void sha256_finish(sha256_context_t *context, uint8_t *hash)
+{
+    sha256_finish_with(context, hash, sha256_transform);
+}
+
+#if SHA256_HAVE_SHANI
+
+void sha256_update_shani
+    (sha256_context_t *context, const void *data, size_t size)
+{
+    sha256_update_with(context, data, size, sha256_transform_shani);
+}
+
+void sha256_finish_shani(sha256_context_t *context, uint8_t *hash)
+{
+    sha256_finish_with(context, hash, sha256_transform_shani);
+}
+
+#endif
+
+#if SHA256_HAVE_AVX2
+
+/* Determine if a set of contexts can be advanced in parallel lanes */
+static int sha256_lanes_in_sync(sha256_context_t **contexts, unsigned count)
+{
+    unsigned lane;
+    if (count < 1 || count > SHA256_MAX_LANES)
+        return 0;
+    for (lane = 1; lane < count; ++lane) {
+        if (contexts[lane]->posn != contexts[0]->posn)
+            return 0;
+    }
+    return 1;
+}
+
+/* Fill out the unused lanes with a scratch context */
+static void sha256_fill_lanes
+    (sha256_context_t **lanes, sha256_context_t **contexts,
+     unsigned count, sha256_context_t *scratch)
+{
+    unsigned lane;
+    sha256_reset(scratch);
+    for (lane = 0; lane < SHA256_MAX_LANES; ++lane)
+        lanes[lane] = (lane < count) ? contexts[lane] : scratch;
+}
+
+int sha256_update_multi_avx2
+    (sha256_context_t **contexts, const uint8_t **data, size_t size,
+     unsigned count)
+{
+    sha256_context_t *lanes[SHA256_MAX_LANES];
+    const uint8_t *blocks[SHA256_MAX_LANES];
+    sha256_context_t scratch;
+    size_t offset = 0;
+    unsigned posn, lane;
+
+    if (!sha256_lanes_in_sync(contexts, count))
+        return 0;
+    sha256_fill_lanes(lanes, contexts, count, &scratch);
+    posn = contexts[0]->posn;
+    while (size > 0) {
+        if (posn == 0 && size >= 64) {
+            for (lane = 0; lane < SHA256_MAX_LANES; ++lane)
+                blocks[lane] = data[lane < count ? lane : 0] + offset;
+            sha256_transform_x8_avx2(lanes, blocks);
+            offset += 64;
+            size -= 64;
+            for (lane = 0; lane < count; ++lane)
+                contexts[lane]->length += 64 * 8;
+        } else {
+            size_t temp = 64 - posn;
+            if (temp > size)
+                temp = size;
+            for (lane = 0; lane < count; ++lane) {
+                memcpy(contexts[lane]->m + posn, data[lane] + offset, temp);
+                contexts[lane]->length += temp * 8;
+            }
+            posn += temp;
+            if (posn >= 64) {
+                for (lane = 0; lane < SHA256_MAX_LANES; ++lane)
+                    blocks[lane] = lanes[lane]->m;
+                sha256_transform_x8_avx2(lanes, blocks);
+                posn = 0;
+            }
+            offset += temp;
+            size -= temp;
+        }
+    }
+    for (lane = 0; lane < count; ++lane)
+        contexts[lane]->posn = (uint8_t)posn;
+    return 1;
+}
+
+int sha256_finish_multi_avx2
+    (sha256_context_t **contexts, uint8_t **hashes, unsigned count)
+{
+    sha256_context_t *lanes[SHA256_MAX_LANES];
+    const uint8_t *blocks[SHA256_MAX_LANES];
+    sha256_context_t scratch;
+    unsigned posn, lane, index;
+
+    if (!sha256_lanes_in_sync(contexts, count))
+        return 0;
+    sha256_fill_lanes(lanes, contexts, count, &scratch);
+    for (lane = 0; lane < SHA256_MAX_LANES; ++lane)
+        blocks[lane] = lanes[lane]->m;
+    posn = contexts[0]->posn;
+    for (lane = 0; lane < count; ++lane) {
+        contexts[lane]->m[posn] = 0x80;
+        memset(contexts[lane]->m + posn + 1, 0, 64 - (posn + 1));
+    }
+    if (posn > (64 - 9)) {
+        sha256_transform_x8_avx2(lanes, blocks);
+        for (lane = 0; lane < count; ++lane)
+            memset(contexts[lane]->m, 0, 64 - 8);
+    }
+    for (lane = 0; lane < count; ++lane) {
+        sha256_context_t *context = contexts[lane];
+        write_be32(context->m + 64 - 8, (uint32_t)(context->length >> 32));
+        write_be32(context->m + 64 - 4, (uint32_t)context->length);
+    }
+    sha256_transform_x8_avx2(lanes, blocks);
+    for (lane = 0; lane < count; ++lane) {
+        contexts[lane]->posn = 0;
+        for (index = 0; index < 8; ++index)
+            write_be32(hashes[lane] + index * 4, contexts[lane]->h[index]);
+    }
+    return 1;
+}
+
+#endif
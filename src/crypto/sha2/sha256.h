@@ -43,6 +43,33 @@ void sha256_reset(sha256_context_t *context);
 void sha256_update(sha256_context_t *context, const void *data, size_t size);
 void sha256_finish(sha256_context_t *context, uint8_t *hash);
 
+/* Versions of the functions above that use Intel SHA extensions.  The caller
+   is responsible for checking that the CPU supports them before use */
+#if (defined(__GNUC__) || defined(__clang__)) && \
+        (defined(__x86_64__) || defined(__i386__)) && \
+        !defined(NOISE_SINGLE_SUITE)
+#define SHA256_HAVE_SHANI 1
+void sha256_update_shani
+    (sha256_context_t *context, const void *data, size_t size);
+void sha256_finish_shani(sha256_context_t *context, uint8_t *hash);
+void sha256_transform_shani(sha256_context_t *context, const uint8_t *m);
+
+/* Multi-buffer versions that advance up to SHA256_MAX_LANES independent
+   contexts in the lanes of AVX2 registers.  All contexts must be at the
+   same position within their current block; the functions return zero
+   without doing anything if they are not.  The caller is responsible for
+   checking that the CPU supports AVX2 before use */
+#define SHA256_HAVE_AVX2 1
+#define SHA256_MAX_LANES 8
+int sha256_update_multi_avx2
+    (sha256_context_t **contexts, const uint8_t **data, size_t size,
+     unsigned count);
+int sha256_finish_multi_avx2
+    (sha256_context_t **contexts, uint8_t **hashes, unsigned count);
+void sha256_transform_x8_avx2
+    (sha256_context_t **contexts, const uint8_t **blocks);
+#endif
+
 #ifdef __cplusplus
 };
 #endif
@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+    SHA-512 compression function with an AVX2 message schedule.
+
+    The 16 message words are byte-swapped with vector shuffles and the
+    remaining 64 schedule words are computed four at a time in 256-bit
+    registers, keeping a sliding window of the last 16 words in four
+    registers.  The sigma1 term depends on the two words before it, so
+    each group of four is computed as two halves.  The schedule is
+    combined with the round constants as it is produced so that the
+    scalar round function only needs one load per round.  The function is compiled with a
+    target attribute so that the rest of the library can still run on
+    CPUs without AVX2.
+*/
+
+#include "sha512.h"
+
+#if SHA512_HAVE_AVX2
+
+#include <immintrin.h>
+
+static uint64_t const k[80] = {
+    0x428A2F98D728AE22ULL, 0x7137449123EF65CDULL, 0xB5C0FBCFEC4D3B2FULL,
+    0xE9B5DBA58189DBBCULL, 0x3956C25BF348B538ULL, 0x59F111F1B605D019ULL,
+    0x923F82A4AF194F9BULL, 0xAB1C5ED5DA6D8118ULL, 0xD807AA98A3030242ULL,
+    0x12835B0145706FBEULL, 0x243185BE4EE4B28CULL, 0x550C7DC3D5FFB4E2ULL,
+    0x72BE5D74F27B896FULL, 0x80DEB1FE3B1696B1ULL, 0x9BDC06A725C71235ULL,
+    0xC19BF174CF692694ULL, 0xE49B69C19EF14AD2ULL, 0xEFBE4786384F25E3ULL,
+    0x0FC19DC68B8CD5B5ULL, 0x240CA1CC77AC9C65ULL, 0x2DE92C6F592B0275ULL,
+    0x4A7484AA6EA6E483ULL, 0x5CB0A9DCBD41FBD4ULL, 0x76F988DA831153B5ULL,
+    0x983E5152EE66DFABULL, 0xA831C66D2DB43210ULL, 0xB00327C898FB213FULL,
+    0xBF597FC7BEEF0EE4ULL, 0xC6E00BF33DA88FC2ULL, 0xD5A79147930AA725ULL,
+    0x06CA6351E003826FULL, 0x142929670A0E6E70ULL, 0x27B70A8546D22FFCULL,
+    0x2E1B21385C26C926ULL, 0x4D2C6DFC5AC42AEDULL, 0x53380D139D95B3DFULL,
+    0x650A73548BAF63DEULL, 0x766A0ABB3C77B2A8ULL, 0x81C2C92E47EDAEE6ULL,
+    0x92722C851482353BULL, 0xA2BFE8A14CF10364ULL, 0xA81A664BBC423001ULL,
+    0xC24B8B70D0F89791ULL, 0xC76C51A30654BE30ULL, 0xD192E819D6EF5218ULL,
+    0xD69906245565A910ULL, 0xF40E35855771202AULL, 0x106AA07032BBD1B8ULL,
+    0x19A4C116B8D2D0C8ULL, 0x1E376C085141AB53ULL, 0x2748774CDF8EEB99ULL,
+    0x34B0BCB5E19B48A8ULL, 0x391C0CB3C5C95A63ULL, 0x4ED8AA4AE3418ACBULL,
+    0x5B9CCA4F7763E373ULL, 0x682E6FF3D6B2B8A3ULL, 0x748F82EE5DEFB2FCULL,
+    0x78A5636F43172F60ULL, 0x84C87814A1F0AB72ULL, 0x8CC702081A6439ECULL,
+    0x90BEFFFA23631E28ULL, 0xA4506CEBDE82BDE9ULL, 0xBEF9A3F7B2C67915ULL,
+    0xC67178F2E372532BULL, 0xCA273ECEEA26619CULL, 0xD186B8C721C0C207ULL,
+    0xEADA7DD6CDE0EB1EULL, 0xF57D4F7FEE6ED178ULL, 0x06F067AA72176FBAULL,
+    0x0A637DC5A2C898A6ULL, 0x113F9804BEF90DAEULL, 0x1B710B35131C471BULL,
+    0x28DB77F523047D84ULL, 0x32CAAB7B40C72493ULL, 0x3C9EBE0A15C9BEBCULL,
+    0x431D67C49C100D4CULL, 0x4CC5D4BECB3E42B6ULL, 0x597F299CFC657E2AULL,
+    0x5FCB6FAB3AD6FAECULL, 0x6C44198C4A475817ULL
+};
+
+#define rightRotate(v, n) (((v) >> (n)) | ((v) << (64 - (n))))
+
+/* Rotate every 64-bit lane of a vector right by a certain number of bits */
+#define rightRotate256(v, n) \
+    _mm256_or_si256(_mm256_srli_epi64((v), (n)), _mm256_slli_epi64((v), 64 - (n)))
+#define rightRotate128(v, n) \
+    _mm_or_si128(_mm_srli_epi64((v), (n)), _mm_slli_epi64((v), 64 - (n)))
+
+/* Message schedule functions on vectors of words */
+#define sigma0_256(v) \
+    _mm256_xor_si256(_mm256_xor_si256(rightRotate256((v), 1), \
+                                      rightRotate256((v), 8)), \
+                     _mm256_srli_epi64((v), 7))
+#define sigma1_128(v) \
+    _mm_xor_si128(_mm_xor_si128(rightRotate128((v), 19), \
+                                rightRotate128((v), 61)), \
+                  _mm_srli_epi64((v), 6))
+
+/* Extract words 1..4 from the 8-word window formed by two vectors */
+#define shiftWindow(a, b) \
+    _mm256_alignr_epi8(_mm256_permute2x128_si256((a), (b), 0x21), (a), 8)
+
+__attribute__((target("avx2")))
+void sha512_transform_avx2(sha512_context_t *context, const uint8_t *m)
+{
+    const __m256i bswap = _mm256_setr_epi8
+        (7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+         7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    uint64_t wk[80];
+    __m256i w0, w1, w2, w3, x;
+    __m128i lo, hi;
+    unsigned index;
+    uint64_t temp1, temp2;
+
+    /* Initialise working variables to the current hash value */
+    uint64_t a = context->h[0];
+    uint64_t b = context->h[1];
+    uint64_t c = context->h[2];
+    uint64_t d = context->h[3];
+    uint64_t e = context->h[4];
+    uint64_t f = context->h[5];
+    uint64_t g = context->h[6];
+    uint64_t h = context->h[7];
+
+    /* Convert the 16 message words from big endian to host byte order.
+       The last 16 schedule words are kept in w0..w3 from now on */
+    w0 = _mm256_shuffle_epi8
+        (_mm256_loadu_si256((const __m256i *)(m + 0)), bswap);
+    w1 = _mm256_shuffle_epi8
+        (_mm256_loadu_si256((const __m256i *)(m + 32)), bswap);
+    w2 = _mm256_shuffle_epi8
+        (_mm256_loadu_si256((const __m256i *)(m + 64)), bswap);
+    w3 = _mm256_shuffle_epi8
+        (_mm256_loadu_si256((const __m256i *)(m + 96)), bswap);
+    for (index = 0; index < 16; index += 4) {
+        x = _mm256_add_epi64
+            (w0, _mm256_loadu_si256((const __m256i *)&(k[index])));
+        _mm256_storeu_si256((__m256i *)&(wk[index]), x);
+        x = w0; w0 = w1; w1 = w2; w2 = w3; w3 = x;
+    }
+
+    /* Round function */
+#define SHA512_ROUND(a, b, c, d, e, f, g, h, n) \
+    (temp1 = (h) + wk[index + (n)] + \
+        (rightRotate((e), 14) ^ rightRotate((e), 18) ^ rightRotate((e), 41)) + \
+        (((e) & (f)) ^ ((~(e)) & (g))), \
+     temp2 = (rightRotate((a), 28) ^ rightRotate((a), 34) ^ rightRotate((a), 39)) + \
+        (((a) & (b)) ^ ((a) & (c)) ^ ((b) & (c))), \
+     (d) += temp1, \
+     (h) = temp1 + temp2)
+
+    /* Extend the schedule by four words: w[n..n+3] is computed from
+       w[n - 16] + w[n - 7] + sigma0(w[n - 15]) + sigma1(w[n - 2]).
+       The sigma1 term depends on the two words before it, so the
+       low half has to be computed before the high half */
+#define SHA512_SCHEDULE(n) \
+    do { \
+        x = _mm256_add_epi64(w0, shiftWindow(w2, w3)); \
+        x = _mm256_add_epi64(x, sigma0_256(shiftWindow(w0, w1))); \
+        lo = _mm256_extracti128_si256(w3, 1); \
+        lo = _mm_add_epi64(_mm256_castsi256_si128(x), sigma1_128(lo)); \
+        hi = _mm_add_epi64(_mm256_extracti128_si256(x, 1), sigma1_128(lo)); \
+        w0 = w1; \
+        w1 = w2; \
+        w2 = w3; \
+        w3 = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1); \
+        x = _mm256_add_epi64 \
+            (w3, _mm256_loadu_si256((const __m256i *)&(k[(n)]))); \
+        _mm256_storeu_si256((__m256i *)&(wk[(n)]), x); \
+    } while (0)
+
+    /* Compression function main loop.  The vector unit extends the
+       schedule 16 words ahead while the scalar rounds are running */
+    for (index = 0; index < 80; index += 8) {
+        if (index < 64)
+            SHA512_SCHEDULE(index + 16);
+        SHA512_ROUND(a, b, c, d, e, f, g, h, 0);
+        SHA512_ROUND(h, a, b, c, d, e, f, g, 1);
+        SHA512_ROUND(g, h, a, b, c, d, e, f, 2);
+        SHA512_ROUND(f, g, h, a, b, c, d, e, 3);
+        if (index < 64)
+            SHA512_SCHEDULE(index + 20);
+        SHA512_ROUND(e, f, g, h, a, b, c, d, 4);
+        SHA512_ROUND(d, e, f, g, h, a, b, c, 5);
+        SHA512_ROUND(c, d, e, f, g, h, a, b, 6);
+        SHA512_ROUND(b, c, d, e, f, g, h, a, 7);
+    }
+
+    /* Add the compressed chunk to the current hash value */
+    context->h[0] += a;
+    context->h[1] += b;
+    context->h[2] += c;
+    context->h[3] += d;
+    context->h[4] += e;
+    context->h[5] += f;
+    context->h[6] += g;
+    context->h[7] += h;
+}
+
+#endif /* SHA512_HAVE_AVX2 */
@@ -139,12 +139,17 @@ static void sha512_transform(sha512_context_t *context, const uint8_t *m)
     context->h[7] += h;
 }
 
-void sha512_update(sha512_context_t *context, const void *data, size_t size)
+/* Function that compresses a single block */
+typedef void (*sha512_transform_t)(sha512_context_t *context, const uint8_t *m);
+
+static void sha512_update_with
+    (sha512_context_t *context, const void *data, size_t size,
+     sha512_transform_t transform)
 {
     const uint8_t *d = (const uint8_t *)data;
     while (size > 0) {
         if (context->posn == 0 && size >= 128) {
-            sha512_transform(context, d);
+            (*transform)(context, d);
             d += 128;
             size -= 128;
             context->length += 128 * 8;
@@ -155,7 +160,7 @@ void sha512_update(sha512_context_t *context, const void *data, size_t size)
             memcpy(context->m + context->posn, d, temp);
             context->posn += temp;
             if (context->posn >= 128) {
-                sha512_transform(context, context->m);
+                (*transform)(context, context->m);
                 context->posn = 0;
             }
             d += temp;
@@ -177,7 +182,9 @@ static void write_be64(uint8_t *out, uint64_t value)
     out[7] = (uint8_t)value;
 }
 
-void sha512_finish(sha512_context_t *context, uint8_t *hash)
+static void sha512_finish_with
+    (sha512_context_t *context, uint8_t *hash,
+     sha512_transform_t transform)
 {
     uint8_t posn = context->posn;
     if (posn <= (128 - 17)) {
@@ -186,17 +193,42 @@ void sha512_finish(sha512_context_t *context, uint8_t *hash)
     } else {
         context->m[posn] = 0x80;
         memset(context->m + posn + 1, 0, 128 - (posn + 1));
-        sha512_transform(context, context->m);
+        (*transform)(context, context->m);
         memset(context->m, 0, 128 - 16);
     }
     write_be64(context->m + 128 - 16, 0);
     write_be64(context->m + 128 - 8, context->length);
-    sha512_transform(context, context->m);
+    (*transform)(context, context->m);
     context->posn = 0;
     for (posn = 0; posn < 8; ++posn)
         write_be64(hash + posn * 8, context->h[posn]);
 }
 
+void sha512_update(sha512_context_t *context, const void *data, size_t size)
+{
+    sha512_update_with(context, data, size, sha512_transform);
+}
+
+void sha512_finish(sha512_context_t *context, uint8_t *hash)
+{
+    sha512_finish_with(context, hash, sha512_transform);
+}
+
+#if SHA512_HAVE_AVX2
+
+void sha512_update_avx2
+    (sha512_context_t *context, const void *data, size_t size)
+{
+    sha512_update_with(context, data, size, sha512_transform_avx2);
+}
+
+void sha512_finish_avx2(sha512_context_t *context, uint8_t *hash)
+{
+    sha512_finish_with(context, hash, sha512_transform_avx2);
+}
+
+#endif
+
 void sha512_hash(uint8_t *hash, const void *data, size_t size)
 {
     sha512_context_t context;
@@ -42,6 +42,18 @@ typedef struct
 void sha512_reset(sha512_context_t *context);
 void sha512_update(sha512_context_t *context, const void *data, size_t size);
 void sha512_finish(sha512_context_t *context, uint8_t *hash);
+
+/* Versions of the functions above that use AVX2.  The caller
+   is responsible for checking that the CPU supports them before use */
+#if (defined(__GNUC__) || defined(__clang__)) && \
+        (defined(__x86_64__) || defined(__i386__)) && \
+        !defined(NOISE_SINGLE_SUITE)
+#define SHA512_HAVE_AVX2 1
+void sha512_update_avx2
+    (sha512_context_t *context, const void *data, size_t size);
+void sha512_finish_avx2(sha512_context_t *context, uint8_t *hash);
+void sha512_transform_avx2(sha512_context_t *context, const uint8_t *m);
+#endif
 void sha512_hash(uint8_t *hash, const void *data, size_t size);
 
 #ifdef __cplusplus
@@ -30,12 +30,14 @@ struct _Noise_Certificate {
     Noise_Signature **signatures;
     size_t signatures_count_;
     size_t signatures_max_;
+    size_t size_cache_;
 };
 
 struct _Noise_CertificateChain {
     Noise_Certificate **certs;
     size_t certs_count_;
     size_t certs_max_;
+    size_t size_cache_;
 };
 
 struct _Noise_SubjectInfo {
@@ -51,6 +53,7 @@ struct _Noise_SubjectInfo {
     Noise_MetaInfo **meta;
     size_t meta_count_;
     size_t meta_max_;
+    size_t size_cache_;
 };
 
 struct _Noise_PublicKeyInfo {
@@ -58,6 +61,7 @@ struct _Noise_PublicKeyInfo {
     size_t algorithm_size_;
     void *key;
     size_t key_size_;
+    size_t size_cache_;
 };
 
 struct _Noise_MetaInfo {
@@ -65,6 +69,7 @@ struct _Noise_MetaInfo {
     size_t name_size_;
     char *value;
     size_t value_size_;
+    size_t size_cache_;
 };
 
 struct _Noise_Signature {
@@ -78,6 +83,7 @@ struct _Noise_Signature {
     Noise_ExtraSignedInfo *extra_signed_info;
     void *signature;
     size_t signature_size_;
+    size_t size_cache_;
 };
 
 struct _Noise_ExtraSignedInfo {
@@ -90,6 +96,7 @@ struct _Noise_ExtraSignedInfo {
     Noise_MetaInfo **meta;
     size_t meta_count_;
     size_t meta_max_;
+    size_t size_cache_;
 };
 
 struct _Noise_EncryptedPrivateKey {
@@ -101,6 +108,7 @@ struct _Noise_EncryptedPrivateKey {
     uint32_t iterations;
     void *encrypted_data;
     size_t encrypted_data_size_;
+    size_t size_cache_;
 };
 
 struct _Noise_PrivateKey {
@@ -116,6 +124,7 @@ struct _Noise_PrivateKey {
     Noise_MetaInfo **meta;
     size_t meta_count_;
     size_t meta_max_;
+    size_t size_cache_;
 };
 
 struct _Noise_PrivateKeyInfo {
@@ -123,6 +132,7 @@ struct _Noise_PrivateKeyInfo {
     size_t algorithm_size_;
     void *key;
     size_t key_size_;
+    size_t size_cache_;
 };
 
 int Noise_Certificate_new(Noise_Certificate **obj)
@@ -173,9 +183,9 @@ int Noise_Certificate_read(NoiseProtobuf *pbuf, int tag, Noise_Certificate **obj
     *obj = 0;
     if (!pbuf)
         return NOISE_ERROR_INVALID_PARAM;
-    err = Noise_Certificate_new(obj);
-    if (err != NOISE_ERROR_NONE)
-        return err;
+    *obj = (Noise_Certificate *)noise_protobuf_new_object(pbuf, sizeof(Noise_Certificate));
+    if (!(*obj))
+        return NOISE_ERROR_NO_MEMORY;
     noise_protobuf_read_start_element(pbuf, tag, &end_posn);
     while (!noise_protobuf_read_at_end_element(pbuf, end_posn)) {
         switch (noise_protobuf_peek_tag(pbuf)) {
@@ -183,17 +193,15 @@ int Noise_Certificate_read(NoiseProtobuf *pbuf, int tag, Noise_Certificate **obj
                 noise_protobuf_read_uint32(pbuf, 1, &((*obj)->version));
             } break;
             case 2: {
-                Noise_SubjectInfo_free((*obj)->subject);
+                if (!pbuf->arena)
+                    Noise_SubjectInfo_free((*obj)->subject);
                 (*obj)->subject = 0;
                 Noise_SubjectInfo_read(pbuf, 2, &((*obj)->subject));
             } break;
             case 3: {
                 Noise_Signature *value = 0;
-                int err;
                 Noise_Signature_read(pbuf, 3, &value);
-                err = noise_protobuf_add_to_array((void **)&((*obj)->signatures), &((*obj)->signatures_count_), &((*obj)->signatures_max_), &value, sizeof(value));
-                if (err != NOISE_ERROR_NONE && pbuf->error != NOISE_ERROR_NONE)
-                   pbuf->error = err;
+                noise_protobuf_read_add_to_array(pbuf, (void **)&((*obj)->signatures), &((*obj)->signatures_count_), &((*obj)->signatures_max_), &value, sizeof(value));
             } break;
             default: {
                 noise_protobuf_read_skip(pbuf);
@@ -202,12 +210,45 @@ int Noise_Certificate_read(NoiseProtobuf *pbuf, int tag, Noise_Certificate **obj
     }
     err = noise_protobuf_read_end_element(pbuf, end_posn);
     if (err != NOISE_ERROR_NONE) {
-        Noise_Certificate_free(*obj);
+        if (!pbuf->arena)
+            Noise_Certificate_free(*obj);
         *obj = 0;
     }
     return err;
 }
 
+size_t Noise_Certificate_measure(int tag, const Noise_Certificate *obj)
+{
+    size_t size = 0;
+    size_t index;
+    if (!obj)
+        return 0;
+    if (obj->version)
+        size += noise_protobuf_size_uint32(1, obj->version);
+    if (obj->subject)
+        size += Noise_SubjectInfo_measure(2, obj->subject);
+    for (index = 0; index < obj->signatures_count_; ++index)
+        size += Noise_Signature_measure(3, obj->signatures[index]);
+    noise_protobuf_store_size_cache(&(obj->size_cache_), size);
+    return noise_protobuf_size_element(tag, size);
+}
+
+int Noise_Certificate_encode(NoiseProtobuf *pbuf, int tag, const Noise_Certificate *obj)
+{
+    size_t index;
+    if (!pbuf || !obj)
+        return NOISE_ERROR_INVALID_PARAM;
+    noise_protobuf_encode_start_element
+        (pbuf, tag, noise_protobuf_load_size_cache(&(obj->size_cache_)));
+    if (obj->version)
+        noise_protobuf_encode_uint32(pbuf, 1, obj->version);
+    if (obj->subject)
+        Noise_SubjectInfo_encode(pbuf, 2, obj->subject);
+    for (index = 0; index < obj->signatures_count_; ++index)
+        Noise_Signature_encode(pbuf, 3, obj->signatures[index]);
+    return pbuf->error;
+}
+
 int Noise_Certificate_clear_version(Noise_Certificate *obj)
 {
     if (obj) {
@@ -375,19 +416,16 @@ int Noise_CertificateChain_read(NoiseProtobuf *pbuf, int tag, Noise_CertificateC
     *obj = 0;
     if (!pbuf)
         return NOISE_ERROR_INVALID_PARAM;
-    err = Noise_CertificateChain_new(obj);
-    if (err != NOISE_ERROR_NONE)
-        return err;
+    *obj = (Noise_CertificateChain *)noise_protobuf_new_object(pbuf, sizeof(Noise_CertificateChain));
+    if (!(*obj))
+        return NOISE_ERROR_NO_MEMORY;
     noise_protobuf_read_start_element(pbuf, tag, &end_posn);
     while (!noise_protobuf_read_at_end_element(pbuf, end_posn)) {
         switch (noise_protobuf_peek_tag(pbuf)) {
             case 8: {
                 Noise_Certificate *value = 0;
-                int err;
                 Noise_Certificate_read(pbuf, 8, &value);
-                err = noise_protobuf_add_to_array((void **)&((*obj)->certs), &((*obj)->certs_count_), &((*obj)->certs_max_), &value, sizeof(value));
-                if (err != NOISE_ERROR_NONE && pbuf->error != NOISE_ERROR_NONE)
-                   pbuf->error = err;
+                noise_protobuf_read_add_to_array(pbuf, (void **)&((*obj)->certs), &((*obj)->certs_count_), &((*obj)->certs_max_), &value, sizeof(value));
             } break;
             default: {
                 noise_protobuf_read_skip(pbuf);
@@ -396,12 +434,37 @@ int Noise_CertificateChain_read(NoiseProtobuf *pbuf, int tag, Noise_CertificateC
     }
     err = noise_protobuf_read_end_element(pbuf, end_posn);
     if (err != NOISE_ERROR_NONE) {
-        Noise_CertificateChain_free(*obj);
+        if (!pbuf->arena)
+            Noise_CertificateChain_free(*obj);
         *obj = 0;
     }
     return err;
 }
 
+size_t Noise_CertificateChain_measure(int tag, const Noise_CertificateChain *obj)
+{
+    size_t size = 0;
+    size_t index;
+    if (!obj)
+        return 0;
+    for (index = 0; index < obj->certs_count_; ++index)
+        size += Noise_Certificate_measure(8, obj->certs[index]);
+    noise_protobuf_store_size_cache(&(obj->size_cache_), size);
+    return noise_protobuf_size_element(tag, size);
+}
+
+int Noise_CertificateChain_encode(NoiseProtobuf *pbuf, int tag, const Noise_CertificateChain *obj)
+{
+    size_t index;
+    if (!pbuf || !obj)
+        return NOISE_ERROR_INVALID_PARAM;
+    noise_protobuf_encode_start_element
+        (pbuf, tag, noise_protobuf_load_size_cache(&(obj->size_cache_)));
+    for (index = 0; index < obj->certs_count_; ++index)
+        Noise_Certificate_encode(pbuf, 8, obj->certs[index]);
+    return pbuf->error;
+}
+
 int Noise_CertificateChain_clear_certs(Noise_CertificateChain *obj)
 {
     size_t index;
@@ -519,45 +582,42 @@ int Noise_SubjectInfo_read(NoiseProtobuf *pbuf, int tag, Noise_SubjectInfo **obj
     *obj = 0;
     if (!pbuf)
         return NOISE_ERROR_INVALID_PARAM;
-    err = Noise_SubjectInfo_new(obj);
-    if (err != NOISE_ERROR_NONE)
-        return err;
+    *obj = (Noise_SubjectInfo *)noise_protobuf_new_object(pbuf, sizeof(Noise_SubjectInfo));
+    if (!(*obj))
+        return NOISE_ERROR_NO_MEMORY;
     noise_protobuf_read_start_element(pbuf, tag, &end_posn);
     while (!noise_protobuf_read_at_end_element(pbuf, end_posn)) {
         switch (noise_protobuf_peek_tag(pbuf)) {
             case 1: {
-                noise_protobuf_free_memory((*obj)->id, (*obj)->id_size_);
+                if (!pbuf->arena)
+                    noise_protobuf_free_memory((*obj)->id, (*obj)->id_size_);
                 (*obj)->id = 0;
                 (*obj)->id_size_ = 0;
                 noise_protobuf_read_alloc_string(pbuf, 1, &((*obj)->id), 0, &((*obj)->id_size_));
             } break;
             case 2: {
-                noise_protobuf_free_memory((*obj)->name, (*obj)->name_size_);
+                if (!pbuf->arena)
+                    noise_protobuf_free_memory((*obj)->name, (*obj)->name_size_);
                 (*obj)->name = 0;
                 (*obj)->name_size_ = 0;
                 noise_protobuf_read_alloc_string(pbuf, 2, &((*obj)->name), 0, &((*obj)->name_size_));
             } break;
             case 3: {
-                noise_protobuf_free_memory((*obj)->role, (*obj)->role_size_);
+                if (!pbuf->arena)
+                    noise_protobuf_free_memory((*obj)->role, (*obj)->role_size_);
                 (*obj)->role = 0;
                 (*obj)->role_size_ = 0;
                 noise_protobuf_read_alloc_string(pbuf, 3, &((*obj)->role), 0, &((*obj)->role_size_));
             } break;
             case 4: {
                 Noise_PublicKeyInfo *value = 0;
-                int err;
                 Noise_PublicKeyInfo_read(pbuf, 4, &value);
-                err = noise_protobuf_add_to_array((void **)&((*obj)->keys), &((*obj)->keys_count_), &((*obj)->keys_max_), &value, sizeof(value));
-                if (err != NOISE_ERROR_NONE && pbuf->error != NOISE_ERROR_NONE)
-                   pbuf->error = err;
+                noise_protobuf_read_add_to_array(pbuf, (void **)&((*obj)->keys), &((*obj)->keys_count_), &((*obj)->keys_max_), &value, sizeof(value));
             } break;
             case 5: {
                 Noise_MetaInfo *value = 0;
-                int err;
                 Noise_MetaInfo_read(pbuf, 5, &value);
-                err = noise_protobuf_add_to_array((void **)&((*obj)->meta), &((*obj)->meta_count_), &((*obj)->meta_max_), &value, sizeof(value));
-                if (err != NOISE_ERROR_NONE && pbuf->error != NOISE_ERROR_NONE)
-                   pbuf->error = err;
+                noise_protobuf_read_add_to_array(pbuf, (void **)&((*obj)->meta), &((*obj)->meta_count_), &((*obj)->meta_max_), &value, sizeof(value));
             } break;
             default: {
                 noise_protobuf_read_skip(pbuf);
@@ -566,12 +626,53 @@ int Noise_SubjectInfo_read(NoiseProtobuf *pbuf, int tag, Noise_SubjectInfo **obj
     }
     err = noise_protobuf_read_end_element(pbuf, end_posn);
     if (err != NOISE_ERROR_NONE) {
-        Noise_SubjectInfo_free(*obj);
+        if (!pbuf->arena)
+            Noise_SubjectInfo_free(*obj);
         *obj = 0;
     }
     return err;
 }
 
+size_t Noise_SubjectInfo_measure(int tag, const Noise_SubjectInfo *obj)
+{
+    size_t size = 0;
+    size_t index;
+    if (!obj)
+        return 0;
+    if (obj->id)
+        size += noise_protobuf_size_string(1, obj->id_size_);
+    if (obj->name)
+        size += noise_protobuf_size_string(2, obj->name_size_);
+    if (obj->role)
+        size += noise_protobuf_size_string(3, obj->role_size_);
+    for (index = 0; index < obj->keys_count_; ++index)
+        size += Noise_PublicKeyInfo_measure(4, obj->keys[index]);
+    for (index = 0; index < obj->meta_count_; ++index)
+        size += Noise_MetaInfo_measure(5, obj->meta[index]);
+    noise_protobuf_store_size_cache(&(obj->size_cache_), size);
+    return noise_protobuf_size_element(tag, size);
+}
+
+int Noise_SubjectInfo_encode(NoiseProtobuf *pbuf, int tag, const Noise_SubjectInfo *obj)
+{
+    size_t index;
+    if (!pbuf || !obj)
+        return NOISE_ERROR_INVALID_PARAM;
+    noise_protobuf_encode_start_element
+        (pbuf, tag, noise_protobuf_load_size_cache(&(obj->size_cache_)));
+    if (obj->id)
+        noise_protobuf_encode_string(pbuf, 1, obj->id, obj->id_size_);
+    if (obj->name)
+        noise_protobuf_encode_string(pbuf, 2, obj->name, obj->name_size_);
+    if (obj->role)
+        noise_protobuf_encode_string(pbuf, 3, obj->role, obj->role_size_);
+    for (index = 0; index < obj->keys_count_; ++index)
+        Noise_PublicKeyInfo_encode(pbuf, 4, obj->keys[index]);
+    for (index = 0; index < obj->meta_count_; ++index)
+        Noise_MetaInfo_encode(pbuf, 5, obj->meta[index]);
+    return pbuf->error;
+}
+
 int Noise_SubjectInfo_clear_id(Noise_SubjectInfo *obj)
 {
     if (obj) {
@@ -866,20 +967,22 @@ int Noise_PublicKeyInfo_read(NoiseProtobuf *pbuf, int tag, Noise_PublicKeyInfo *
     *obj = 0;
     if (!pbuf)
         return NOISE_ERROR_INVALID_PARAM;
-    err = Noise_PublicKeyInfo_new(obj);
-    if (err != NOISE_ERROR_NONE)
-        return err;
+    *obj = (Noise_PublicKeyInfo *)noise_protobuf_new_object(pbuf, sizeof(Noise_PublicKeyInfo));
+    if (!(*obj))
+        return NOISE_ERROR_NO_MEMORY;
     noise_protobuf_read_start_element(pbuf, tag, &end_posn);
     while (!noise_protobuf_read_at_end_element(pbuf, end_posn)) {
         switch (noise_protobuf_peek_tag(pbuf)) {
             case 1: {
-                noise_protobuf_free_memory((*obj)->algorithm, (*obj)->algorithm_size_);
+                if (!pbuf->arena)
+                    noise_protobuf_free_memory((*obj)->algorithm, (*obj)->algorithm_size_);
                 (*obj)->algorithm = 0;
                 (*obj)->algorithm_size_ = 0;
                 noise_protobuf_read_alloc_string(pbuf, 1, &((*obj)->algorithm), 0, &((*obj)->algorithm_size_));
             } break;
             case 2: {
-                noise_protobuf_free_memory((*obj)->key, (*obj)->key_size_);
+                if (!pbuf->arena)
+                    noise_protobuf_free_memory((*obj)->key, (*obj)->key_size_);
                 (*obj)->key = 0;
                 (*obj)->key_size_ = 0;
                 noise_protobuf_read_alloc_bytes(pbuf, 2, &((*obj)->key), 0, &((*obj)->key_size_));
@@ -891,12 +994,39 @@ int Noise_PublicKeyInfo_read(NoiseProtobuf *pbuf, int tag, Noise_PublicKeyInfo *
     }
     err = noise_protobuf_read_end_element(pbuf, end_posn);
     if (err != NOISE_ERROR_NONE) {
-        Noise_PublicKeyInfo_free(*obj);
+        if (!pbuf->arena)
+            Noise_PublicKeyInfo_free(*obj);
         *obj = 0;
     }
     return err;
 }
 
+size_t Noise_PublicKeyInfo_measure(int tag, const Noise_PublicKeyInfo *obj)
+{
+    size_t size = 0;
+    if (!obj)
+        return 0;
+    if (obj->algorithm)
+        size += noise_protobuf_size_string(1, obj->algorithm_size_);
+    if (obj->key)
+        size += noise_protobuf_size_bytes(2, obj->key_size_);
+    noise_protobuf_store_size_cache(&(obj->size_cache_), size);
+    return noise_protobuf_size_element(tag, size);
+}
+
+int Noise_PublicKeyInfo_encode(NoiseProtobuf *pbuf, int tag, const Noise_PublicKeyInfo *obj)
+{
+    if (!pbuf || !obj)
+        return NOISE_ERROR_INVALID_PARAM;
+    noise_protobuf_encode_start_element
+        (pbuf, tag, noise_protobuf_load_size_cache(&(obj->size_cache_)));
+    if (obj->algorithm)
+        noise_protobuf_encode_string(pbuf, 1, obj->algorithm, obj->algorithm_size_);
+    if (obj->key)
+        noise_protobuf_encode_bytes(pbuf, 2, obj->key, obj->key_size_);
+    return pbuf->error;
+}
+
 int Noise_PublicKeyInfo_clear_algorithm(Noise_PublicKeyInfo *obj)
 {
     if (obj) {
@@ -1026,20 +1156,22 @@ int Noise_MetaInfo_read(NoiseProtobuf *pbuf, int tag, Noise_MetaInfo **obj)
     *obj = 0;
     if (!pbuf)
         return NOISE_ERROR_INVALID_PARAM;
-    err = Noise_MetaInfo_new(obj);
-    if (err != NOISE_ERROR_NONE)
-        return err;
+    *obj = (Noise_MetaInfo *)noise_protobuf_new_object(pbuf, sizeof(Noise_MetaInfo));
+    if (!(*obj))
+        return NOISE_ERROR_NO_MEMORY;
     noise_protobuf_read_start_element(pbuf, tag, &end_posn);
     while (!noise_protobuf_read_at_end_element(pbuf, end_posn)) {
         switch (noise_protobuf_peek_tag(pbuf)) {
             case 1: {
-                noise_protobuf_free_memory((*obj)->name, (*obj)->name_size_);
+                if (!pbuf->arena)
+                    noise_protobuf_free_memory((*obj)->name, (*obj)->name_size_);
                 (*obj)->name = 0;
                 (*obj)->name_size_ = 0;
                 noise_protobuf_read_alloc_string(pbuf, 1, &((*obj)->name), 0, &((*obj)->name_size_));
             } break;
             case 2: {
-                noise_protobuf_free_memory((*obj)->value, (*obj)->value_size_);
+                if (!pbuf->arena)
+                    noise_protobuf_free_memory((*obj)->value, (*obj)->value_size_);
                 (*obj)->value = 0;
                 (*obj)->value_size_ = 0;
                 noise_protobuf_read_alloc_string(pbuf, 2, &((*obj)->value), 0, &((*obj)->value_size_));
@@ -1051,12 +1183,39 @@ int Noise_MetaInfo_read(NoiseProtobuf *pbuf, int tag, Noise_MetaInfo **obj)
     }
     err = noise_protobuf_read_end_element(pbuf, end_posn);
     if (err != NOISE_ERROR_NONE) {
-        Noise_MetaInfo_free(*obj);
+        if (!pbuf->arena)
+            Noise_MetaInfo_free(*obj);
         *obj = 0;
     }
     return err;
 }
 
+size_t Noise_MetaInfo_measure(int tag, const Noise_MetaInfo *obj)
+{
+    size_t size = 0;
+    if (!obj)
+        return 0;
+    if (obj->name)
+        size += noise_protobuf_size_string(1, obj->name_size_);
+    if (obj->value)
+        size += noise_protobuf_size_string(2, obj->value_size_);
+    noise_protobuf_store_size_cache(&(obj->size_cache_), size);
+    return noise_protobuf_size_element(tag, size);
+}
+
+int Noise_MetaInfo_encode(NoiseProtobuf *pbuf, int tag, const Noise_MetaInfo *obj)
+{
+    if (!pbuf || !obj)
+        return NOISE_ERROR_INVALID_PARAM;
+    noise_protobuf_encode_start_element
+        (pbuf, tag, noise_protobuf_load_size_cache(&(obj->size_cache_)));
+    if (obj->name)
+        noise_protobuf_encode_string(pbuf, 1, obj->name, obj->name_size_);
+    if (obj->value)
+        noise_protobuf_encode_string(pbuf, 2, obj->value, obj->value_size_);
+    return pbuf->error;
+}
+
 int Noise_MetaInfo_clear_name(Noise_MetaInfo *obj)
 {
     if (obj) {
@@ -1199,42 +1358,48 @@ int Noise_Signature_read(NoiseProtobuf *pbuf, int tag, Noise_Signature **obj)
     *obj = 0;
     if (!pbuf)
         return NOISE_ERROR_INVALID_PARAM;
-    err = Noise_Signature_new(obj);
-    if (err != NOISE_ERROR_NONE)
-        return err;
+    *obj = (Noise_Signature *)noise_protobuf_new_object(pbuf, sizeof(Noise_Signature));
+    if (!(*obj))
+        return NOISE_ERROR_NO_MEMORY;
     noise_protobuf_read_start_element(pbuf, tag, &end_posn);
     while (!noise_protobuf_read_at_end_element(pbuf, end_posn)) {
         switch (noise_protobuf_peek_tag(pbuf)) {
             case 1: {
-                noise_protobuf_free_memory((*obj)->id, (*obj)->id_size_);
+                if (!pbuf->arena)
+                    noise_protobuf_free_memory((*obj)->id, (*obj)->id_size_);
                 (*obj)->id = 0;
                 (*obj)->id_size_ = 0;
                 noise_protobuf_read_alloc_string(pbuf, 1, &((*obj)->id), 0, &((*obj)->id_size_));
             } break;
             case 2: {
-                noise_protobuf_free_memory((*obj)->name, (*obj)->name_size_);
+                if (!pbuf->arena)
+                    noise_protobuf_free_memory((*obj)->name, (*obj)->name_size_);
                 (*obj)->name = 0;
                 (*obj)->name_size_ = 0;
                 noise_protobuf_read_alloc_string(pbuf, 2, &((*obj)->name), 0, &((*obj)->name_size_));
             } break;
             case 3: {
-                Noise_PublicKeyInfo_free((*obj)->signing_key);
+                if (!pbuf->arena)
+                    Noise_PublicKeyInfo_free((*obj)->signing_key);
                 (*obj)->signing_key = 0;
                 Noise_PublicKeyInfo_read(pbuf, 3, &((*obj)->signing_key));
             } break;
             case 4: {
-                noise_protobuf_free_memory((*obj)->hash_algorithm, (*obj)->hash_algorithm_size_);
+                if (!pbuf->arena)
+                    noise_protobuf_free_memory((*obj)->hash_algorithm, (*obj)->hash_algorithm_size_);
                 (*obj)->hash_algorithm = 0;
                 (*obj)->hash_algorithm_size_ = 0;
                 noise_protobuf_read_alloc_string(pbuf, 4, &((*obj)->hash_algorithm), 0, &((*obj)->hash_algorithm_size_));
             } break;
             case 5: {
-                Noise_ExtraSignedInfo_free((*obj)->extra_signed_info);
+                if (!pbuf->arena)
+                    Noise_ExtraSignedInfo_free((*obj)->extra_signed_info);
                 (*obj)->extra_signed_info = 0;
                 Noise_ExtraSignedInfo_read(pbuf, 5, &((*obj)->extra_signed_info));
             } break;
             case 15: {
-                noise_protobuf_free_memory((*obj)->signature, (*obj)->signature_size_);
+                if (!pbuf->arena)
+                    noise_protobuf_free_memory((*obj)->signature, (*obj)->signature_size_);
                 (*obj)->signature = 0;
                 (*obj)->signature_size_ = 0;
                 noise_protobuf_read_alloc_bytes(pbuf, 15, &((*obj)->signature), 0, &((*obj)->signature_size_));
@@ -1246,12 +1411,55 @@ int Noise_Signature_read(NoiseProtobuf *pbuf, int tag, Noise_Signature **obj)
     }
     err = noise_protobuf_read_end_element(pbuf, end_posn);
     if (err != NOISE_ERROR_NONE) {
-        Noise_Signature_free(*obj);
+        if (!pbuf->arena)
+            Noise_Signature_free(*obj);
         *obj = 0;
     }
     return err;
 }
 
+size_t Noise_Signature_measure(int tag, const Noise_Signature *obj)
+{
+    size_t size = 0;
+    if (!obj)
+        return 0;
+    if (obj->id)
+        size += noise_protobuf_size_string(1, obj->id_size_);
+    if (obj->name)
+        size += noise_protobuf_size_string(2, obj->name_size_);
+    if (obj->signing_key)
+        size += Noise_PublicKeyInfo_measure(3, obj->signing_key);
+    if (obj->hash_algorithm)
+        size += noise_protobuf_size_string(4, obj->hash_algorithm_size_);
+    if (obj->extra_signed_info)
+        size += Noise_ExtraSignedInfo_measure(5, obj->extra_signed_info);
+    if (obj->signature)
+        size += noise_protobuf_size_bytes(15, obj->signature_size_);
+    noise_protobuf_store_size_cache(&(obj->size_cache_), size);
+    return noise_protobuf_size_element(tag, size);
+}
+
+int Noise_Signature_encode(NoiseProtobuf *pbuf, int tag, const Noise_Signature *obj)
+{
+    if (!pbuf || !obj)
+        return NOISE_ERROR_INVALID_PARAM;
+    noise_protobuf_encode_start_element
+        (pbuf, tag, noise_protobuf_load_size_cache(&(obj->size_cache_)));
+    if (obj->id)
+        noise_protobuf_encode_string(pbuf, 1, obj->id, obj->id_size_);
+    if (obj->name)
+        noise_protobuf_encode_string(pbuf, 2, obj->name, obj->name_size_);
+    if (obj->signing_key)
+        Noise_PublicKeyInfo_encode(pbuf, 3, obj->signing_key);
+    if (obj->hash_algorithm)
+        noise_protobuf_encode_string(pbuf, 4, obj->hash_algorithm, obj->hash_algorithm_size_);
+    if (obj->extra_signed_info)
+        Noise_ExtraSignedInfo_encode(pbuf, 5, obj->extra_signed_info);
+    if (obj->signature)
+        noise_protobuf_encode_bytes(pbuf, 15, obj->signature, obj->signature_size_);
+    return pbuf->error;
+}
+
 int Noise_Signature_clear_id(Noise_Signature *obj)
 {
     if (obj) {
@@ -1551,37 +1759,37 @@ int Noise_ExtraSignedInfo_read(NoiseProtobuf *pbuf, int tag, Noise_ExtraSignedIn
     *obj = 0;
     if (!pbuf)
         return NOISE_ERROR_INVALID_PARAM;
-    err = Noise_ExtraSignedInfo_new(obj);
-    if (err != NOISE_ERROR_NONE)
-        return err;
+    *obj = (Noise_ExtraSignedInfo *)noise_protobuf_new_object(pbuf, sizeof(Noise_ExtraSignedInfo));
+    if (!(*obj))
+        return NOISE_ERROR_NO_MEMORY;
     noise_protobuf_read_start_element(pbuf, tag, &end_posn);
     while (!noise_protobuf_read_at_end_element(pbuf, end_posn)) {
         switch (noise_protobuf_peek_tag(pbuf)) {
             case 1: {
-                noise_protobuf_free_memory((*obj)->nonce, (*obj)->nonce_size_);
+                if (!pbuf->arena)
+                    noise_protobuf_free_memory((*obj)->nonce, (*obj)->nonce_size_);
                 (*obj)->nonce = 0;
                 (*obj)->nonce_size_ = 0;
                 noise_protobuf_read_alloc_bytes(pbuf, 1, &((*obj)->nonce), 0, &((*obj)->nonce_size_));
             } break;
             case 2: {
-                noise_protobuf_free_memory((*obj)->valid_from, (*obj)->valid_from_size_);
+                if (!pbuf->arena)
+                    noise_protobuf_free_memory((*obj)->valid_from, (*obj)->valid_from_size_);
                 (*obj)->valid_from = 0;
                 (*obj)->valid_from_size_ = 0;
                 noise_protobuf_read_alloc_string(pbuf, 2, &((*obj)->valid_from), 0, &((*obj)->valid_from_size_));
             } break;
             case 3: {
-                noise_protobuf_free_memory((*obj)->valid_to, (*obj)->valid_to_size_);
+                if (!pbuf->arena)
+                    noise_protobuf_free_memory((*obj)->valid_to, (*obj)->valid_to_size_);
                 (*obj)->valid_to = 0;
                 (*obj)->valid_to_size_ = 0;
                 noise_protobuf_read_alloc_string(pbuf, 3, &((*obj)->valid_to), 0, &((*obj)->valid_to_size_));
             } break;
             case 4: {
                 Noise_MetaInfo *value = 0;
-                int err;
                 Noise_MetaInfo_read(pbuf, 4, &value);
-                err = noise_protobuf_add_to_array((void **)&((*obj)->meta), &((*obj)->meta_count_), &((*obj)->meta_max_), &value, sizeof(value));
-                if (err != NOISE_ERROR_NONE && pbuf->error != NOISE_ERROR_NONE)
-                   pbuf->error = err;
+                noise_protobuf_read_add_to_array(pbuf, (void **)&((*obj)->meta), &((*obj)->meta_count_), &((*obj)->meta_max_), &value, sizeof(value));
             } break;
             default: {
                 noise_protobuf_read_skip(pbuf);
@@ -1590,12 +1798,49 @@ int Noise_ExtraSignedInfo_read(NoiseProtobuf *pbuf, int tag, Noise_ExtraSignedIn
     }
     err = noise_protobuf_read_end_element(pbuf, end_posn);
     if (err != NOISE_ERROR_NONE) {
-        Noise_ExtraSignedInfo_free(*obj);
+        if (!pbuf->arena)
+            Noise_ExtraSignedInfo_free(*obj);
         *obj = 0;
     }
     return err;
 }
 
+size_t Noise_ExtraSignedInfo_measure(int tag, const Noise_ExtraSignedInfo *obj)
+{
+    size_t size = 0;
+    size_t index;
+    if (!obj)
+        return 0;
+    if (obj->nonce)
+        size += noise_protobuf_size_bytes(1, obj->nonce_size_);
+    if (obj->valid_from)
+        size += noise_protobuf_size_string(2, obj->valid_from_size_);
+    if (obj->valid_to)
+        size += noise_protobuf_size_string(3, obj->valid_to_size_);
+    for (index = 0; index < obj->meta_count_; ++index)
+        size += Noise_MetaInfo_measure(4, obj->meta[index]);
+    noise_protobuf_store_size_cache(&(obj->size_cache_), size);
+    return noise_protobuf_size_element(tag, size);
+}
+
+int Noise_ExtraSignedInfo_encode(NoiseProtobuf *pbuf, int tag, const Noise_ExtraSignedInfo *obj)
+{
+    size_t index;
+    if (!pbuf || !obj)
+        return NOISE_ERROR_INVALID_PARAM;
+    noise_protobuf_encode_start_element
+        (pbuf, tag, noise_protobuf_load_size_cache(&(obj->size_cache_)));
+    if (obj->nonce)
+        noise_protobuf_encode_bytes(pbuf, 1, obj->nonce, obj->nonce_size_);
+    if (obj->valid_from)
+        noise_protobuf_encode_string(pbuf, 2, obj->valid_from, obj->valid_from_size_);
+    if (obj->valid_to)
+        noise_protobuf_encode_string(pbuf, 3, obj->valid_to, obj->valid_to_size_);
+    for (index = 0; index < obj->meta_count_; ++index)
+        Noise_MetaInfo_encode(pbuf, 4, obj->meta[index]);
+    return pbuf->error;
+}
+
 int Noise_ExtraSignedInfo_clear_nonce(Noise_ExtraSignedInfo *obj)
 {
     if (obj) {
@@ -1836,9 +2081,9 @@ int Noise_EncryptedPrivateKey_read(NoiseProtobuf *pbuf, int tag, Noise_Encrypted
     *obj = 0;
     if (!pbuf)
         return NOISE_ERROR_INVALID_PARAM;
-    err = Noise_EncryptedPrivateKey_new(obj);
-    if (err != NOISE_ERROR_NONE)
-        return err;
+    *obj = (Noise_EncryptedPrivateKey *)noise_protobuf_new_object(pbuf, sizeof(Noise_EncryptedPrivateKey));
+    if (!(*obj))
+        return NOISE_ERROR_NO_MEMORY;
     noise_protobuf_read_start_element(pbuf, tag, &end_posn);
     while (!noise_protobuf_read_at_end_element(pbuf, end_posn)) {
         switch (noise_protobuf_peek_tag(pbuf)) {
@@ -1846,13 +2091,15 @@ int Noise_EncryptedPrivateKey_read(NoiseProtobuf *pbuf, int tag, Noise_Encrypted
                 noise_protobuf_read_uint32(pbuf, 10, &((*obj)->version));
             } break;
             case 11: {
-                noise_protobuf_free_memory((*obj)->algorithm, (*obj)->algorithm_size_);
+                if (!pbuf->arena)
+                    noise_protobuf_free_memory((*obj)->algorithm, (*obj)->algorithm_size_);
                 (*obj)->algorithm = 0;
                 (*obj)->algorithm_size_ = 0;
                 noise_protobuf_read_alloc_string(pbuf, 11, &((*obj)->algorithm), 0, &((*obj)->algorithm_size_));
             } break;
             case 12: {
-                noise_protobuf_free_memory((*obj)->salt, (*obj)->salt_size_);
+                if (!pbuf->arena)
+                    noise_protobuf_free_memory((*obj)->salt, (*obj)->salt_size_);
                 (*obj)->salt = 0;
                 (*obj)->salt_size_ = 0;
                 noise_protobuf_read_alloc_bytes(pbuf, 12, &((*obj)->salt), 0, &((*obj)->salt_size_));
@@ -1861,7 +2108,8 @@ int Noise_EncryptedPrivateKey_read(NoiseProtobuf *pbuf, int tag, Noise_Encrypted
                 noise_protobuf_read_uint32(pbuf, 13, &((*obj)->iterations));
             } break;
             case 15: {
-                noise_protobuf_free_memory((*obj)->encrypted_data, (*obj)->encrypted_data_size_);
+                if (!pbuf->arena)
+                    noise_protobuf_free_memory((*obj)->encrypted_data, (*obj)->encrypted_data_size_);
                 (*obj)->encrypted_data = 0;
                 (*obj)->encrypted_data_size_ = 0;
                 noise_protobuf_read_alloc_bytes(pbuf, 15, &((*obj)->encrypted_data), 0, &((*obj)->encrypted_data_size_));
@@ -1873,12 +2121,51 @@ int Noise_EncryptedPrivateKey_read(NoiseProtobuf *pbuf, int tag, Noise_Encrypted
     }
     err = noise_protobuf_read_end_element(pbuf, end_posn);
     if (err != NOISE_ERROR_NONE) {
-        Noise_EncryptedPrivateKey_free(*obj);
+        if (!pbuf->arena)
+            Noise_EncryptedPrivateKey_free(*obj);
         *obj = 0;
     }
     return err;
 }
 
+size_t Noise_EncryptedPrivateKey_measure(int tag, const Noise_EncryptedPrivateKey *obj)
+{
+    size_t size = 0;
+    if (!obj)
+        return 0;
+    if (obj->version)
+        size += noise_protobuf_size_uint32(10, obj->version);
+    if (obj->algorithm)
+        size += noise_protobuf_size_string(11, obj->algorithm_size_);
+    if (obj->salt)
+        size += noise_protobuf_size_bytes(12, obj->salt_size_);
+    if (obj->iterations)
+        size += noise_protobuf_size_uint32(13, obj->iterations);
+    if (obj->encrypted_data)
+        size += noise_protobuf_size_bytes(15, obj->encrypted_data_size_);
+    noise_protobuf_store_size_cache(&(obj->size_cache_), size);
+    return noise_protobuf_size_element(tag, size);
+}
+
+int Noise_EncryptedPrivateKey_encode(NoiseProtobuf *pbuf, int tag, const Noise_EncryptedPrivateKey *obj)
+{
+    if (!pbuf || !obj)
+        return NOISE_ERROR_INVALID_PARAM;
+    noise_protobuf_encode_start_element
+        (pbuf, tag, noise_protobuf_load_size_cache(&(obj->size_cache_)));
+    if (obj->version)
+        noise_protobuf_encode_uint32(pbuf, 10, obj->version);
+    if (obj->algorithm)
+        noise_protobuf_encode_string(pbuf, 11, obj->algorithm, obj->algorithm_size_);
+    if (obj->salt)
+        noise_protobuf_encode_bytes(pbuf, 12, obj->salt, obj->salt_size_);
+    if (obj->iterations)
+        noise_protobuf_encode_uint32(pbuf, 13, obj->iterations);
+    if (obj->encrypted_data)
+        noise_protobuf_encode_bytes(pbuf, 15, obj->encrypted_data, obj->encrypted_data_size_);
+    return pbuf->error;
+}
+
 int Noise_EncryptedPrivateKey_clear_version(Noise_EncryptedPrivateKey *obj)
 {
     if (obj) {
@@ -2122,45 +2409,42 @@ int Noise_PrivateKey_read(NoiseProtobuf *pbuf, int tag, Noise_PrivateKey **obj)
     *obj = 0;
     if (!pbuf)
         return NOISE_ERROR_INVALID_PARAM;
-    err = Noise_PrivateKey_new(obj);
-    if (err != NOISE_ERROR_NONE)
-        return err;
+    *obj = (Noise_PrivateKey *)noise_protobuf_new_object(pbuf, sizeof(Noise_PrivateKey));
+    if (!(*obj))
+        return NOISE_ERROR_NO_MEMORY;
     noise_protobuf_read_start_element(pbuf, tag, &end_posn);
     while (!noise_protobuf_read_at_end_element(pbuf, end_posn)) {
         switch (noise_protobuf_peek_tag(pbuf)) {
             case 1: {
-                noise_protobuf_free_memory((*obj)->id, (*obj)->id_size_);
+                if (!pbuf->arena)
+                    noise_protobuf_free_memory((*obj)->id, (*obj)->id_size_);
                 (*obj)->id = 0;
                 (*obj)->id_size_ = 0;
                 noise_protobuf_read_alloc_string(pbuf, 1, &((*obj)->id), 0, &((*obj)->id_size_));
             } break;
             case 2: {
-                noise_protobuf_free_memory((*obj)->name, (*obj)->name_size_);
+                if (!pbuf->arena)
+                    noise_protobuf_free_memory((*obj)->name, (*obj)->name_size_);
                 (*obj)->name = 0;
                 (*obj)->name_size_ = 0;
                 noise_protobuf_read_alloc_string(pbuf, 2, &((*obj)->name), 0, &((*obj)->name_size_));
             } break;
             case 3: {
-                noise_protobuf_free_memory((*obj)->role, (*obj)->role_size_);
+                if (!pbuf->arena)
+                    noise_protobuf_free_memory((*obj)->role, (*obj)->role_size_);
                 (*obj)->role = 0;
                 (*obj)->role_size_ = 0;
                 noise_protobuf_read_alloc_string(pbuf, 3, &((*obj)->role), 0, &((*obj)->role_size_));
             } break;
             case 4: {
                 Noise_PrivateKeyInfo *value = 0;
-                int err;
                 Noise_PrivateKeyInfo_read(pbuf, 4, &value);
-                err = noise_protobuf_add_to_array((void **)&((*obj)->keys), &((*obj)->keys_count_), &((*obj)->keys_max_), &value, sizeof(value));
-                if (err != NOISE_ERROR_NONE && pbuf->error != NOISE_ERROR_NONE)
-                   pbuf->error = err;
+                noise_protobuf_read_add_to_array(pbuf, (void **)&((*obj)->keys), &((*obj)->keys_count_), &((*obj)->keys_max_), &value, sizeof(value));
             } break;
             case 5: {
                 Noise_MetaInfo *value = 0;
-                int err;
                 Noise_MetaInfo_read(pbuf, 5, &value);
-                err = noise_protobuf_add_to_array((void **)&((*obj)->meta), &((*obj)->meta_count_), &((*obj)->meta_max_), &value, sizeof(value));
-                if (err != NOISE_ERROR_NONE && pbuf->error != NOISE_ERROR_NONE)
-                   pbuf->error = err;
+                noise_protobuf_read_add_to_array(pbuf, (void **)&((*obj)->meta), &((*obj)->meta_count_), &((*obj)->meta_max_), &value, sizeof(value));
             } break;
             default: {
                 noise_protobuf_read_skip(pbuf);
@@ -2169,12 +2453,53 @@ int Noise_PrivateKey_read(NoiseProtobuf *pbuf, int tag, Noise_PrivateKey **obj)
     }
     err = noise_protobuf_read_end_element(pbuf, end_posn);
     if (err != NOISE_ERROR_NONE) {
-        Noise_PrivateKey_free(*obj);
+        if (!pbuf->arena)
+            Noise_PrivateKey_free(*obj);
         *obj = 0;
     }
     return err;
 }
 
+size_t Noise_PrivateKey_measure(int tag, const Noise_PrivateKey *obj)
+{
+    size_t size = 0;
+    size_t index;
+    if (!obj)
+        return 0;
+    if (obj->id)
+        size += noise_protobuf_size_string(1, obj->id_size_);
+    if (obj->name)
+        size += noise_protobuf_size_string(2, obj->name_size_);
+    if (obj->role)
+        size += noise_protobuf_size_string(3, obj->role_size_);
+    for (index = 0; index < obj->keys_count_; ++index)
+        size += Noise_PrivateKeyInfo_measure(4, obj->keys[index]);
+    for (index = 0; index < obj->meta_count_; ++index)
+        size += Noise_MetaInfo_measure(5, obj->meta[index]);
+    noise_protobuf_store_size_cache(&(obj->size_cache_), size);
+    return noise_protobuf_size_element(tag, size);
+}
+
+int Noise_PrivateKey_encode(NoiseProtobuf *pbuf, int tag, const Noise_PrivateKey *obj)
+{
+    size_t index;
+    if (!pbuf || !obj)
+        return NOISE_ERROR_INVALID_PARAM;
+    noise_protobuf_encode_start_element
+        (pbuf, tag, noise_protobuf_load_size_cache(&(obj->size_cache_)));
+    if (obj->id)
+        noise_protobuf_encode_string(pbuf, 1, obj->id, obj->id_size_);
+    if (obj->name)
+        noise_protobuf_encode_string(pbuf, 2, obj->name, obj->name_size_);
+    if (obj->role)
+        noise_protobuf_encode_string(pbuf, 3, obj->role, obj->role_size_);
+    for (index = 0; index < obj->keys_count_; ++index)
+        Noise_PrivateKeyInfo_encode(pbuf, 4, obj->keys[index]);
+    for (index = 0; index < obj->meta_count_; ++index)
+        Noise_MetaInfo_encode(pbuf, 5, obj->meta[index]);
+    return pbuf->error;
+}
+
 int Noise_PrivateKey_clear_id(Noise_PrivateKey *obj)
 {
     if (obj) {
@@ -2469,20 +2794,22 @@ int Noise_PrivateKeyInfo_read(NoiseProtobuf *pbuf, int tag, Noise_PrivateKeyInfo
     *obj = 0;
     if (!pbuf)
         return NOISE_ERROR_INVALID_PARAM;
-    err = Noise_PrivateKeyInfo_new(obj);
-    if (err != NOISE_ERROR_NONE)
-        return err;
+    *obj = (Noise_PrivateKeyInfo *)noise_protobuf_new_object(pbuf, sizeof(Noise_PrivateKeyInfo));
+    if (!(*obj))
+        return NOISE_ERROR_NO_MEMORY;
     noise_protobuf_read_start_element(pbuf, tag, &end_posn);
     while (!noise_protobuf_read_at_end_element(pbuf, end_posn)) {
         switch (noise_protobuf_peek_tag(pbuf)) {
             case 1: {
-                noise_protobuf_free_memory((*obj)->algorithm, (*obj)->algorithm_size_);
+                if (!pbuf->arena)
+                    noise_protobuf_free_memory((*obj)->algorithm, (*obj)->algorithm_size_);
                 (*obj)->algorithm = 0;
                 (*obj)->algorithm_size_ = 0;
                 noise_protobuf_read_alloc_string(pbuf, 1, &((*obj)->algorithm), 0, &((*obj)->algorithm_size_));
             } break;
             case 2: {
-                noise_protobuf_free_memory((*obj)->key, (*obj)->key_size_);
+                if (!pbuf->arena)
+                    noise_protobuf_free_memory((*obj)->key, (*obj)->key_size_);
                 (*obj)->key = 0;
                 (*obj)->key_size_ = 0;
                 noise_protobuf_read_alloc_bytes(pbuf, 2, &((*obj)->key), 0, &((*obj)->key_size_));
@@ -2494,12 +2821,39 @@ int Noise_PrivateKeyInfo_read(NoiseProtobuf *pbuf, int tag, Noise_PrivateKeyInfo
     }
     err = noise_protobuf_read_end_element(pbuf, end_posn);
     if (err != NOISE_ERROR_NONE) {
-        Noise_PrivateKeyInfo_free(*obj);
+        if (!pbuf->arena)
+            Noise_PrivateKeyInfo_free(*obj);
         *obj = 0;
     }
     return err;
 }
 
+size_t Noise_PrivateKeyInfo_measure(int tag, const Noise_PrivateKeyInfo *obj)
+{
+    size_t size = 0;
+    if (!obj)
+        return 0;
+    if (obj->algorithm)
+        size += noise_protobuf_size_string(1, obj->algorithm_size_);
+    if (obj->key)
+        size += noise_protobuf_size_bytes(2, obj->key_size_);
+    noise_protobuf_store_size_cache(&(obj->size_cache_), size);
+    return noise_protobuf_size_element(tag, size);
+}
+
+int Noise_PrivateKeyInfo_encode(NoiseProtobuf *pbuf, int tag, const Noise_PrivateKeyInfo *obj)
+{
+    if (!pbuf || !obj)
+        return NOISE_ERROR_INVALID_PARAM;
+    noise_protobuf_encode_start_element
+        (pbuf, tag, noise_protobuf_load_size_cache(&(obj->size_cache_)));
+    if (obj->algorithm)
+        noise_protobuf_encode_string(pbuf, 1, obj->algorithm, obj->algorithm_size_);
+    if (obj->key)
+        noise_protobuf_encode_bytes(pbuf, 2, obj->key, obj->key_size_);
+    return pbuf->error;
+}
+
 int Noise_PrivateKeyInfo_clear_algorithm(Noise_PrivateKeyInfo *obj)
 {
     if (obj) {
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef NOISE_KEYS_INTERNAL_H
+#define NOISE_KEYS_INTERNAL_H
+
+#include <noise/keys.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \file internal.h
+ * \brief Internal definitions for the key management library.
+ *
+ * This file is not part of the public API and should not be included
+ * by applications.
+ */
+
+/**
+ * \brief Read-only view of a file that has been mapped into memory.
+ */
+typedef struct
+{
+    /** \brief Points to the start of the file's contents */
+    const uint8_t *data;
+
+    /** \brief Size of the file's contents in bytes */
+    size_t size;
+
+} NoiseMappedFile;
+
+int noise_mapped_file_open
+    (NoiseMappedFile *file, const char *filename, size_t min_size);
+void noise_mapped_file_close(NoiseMappedFile *file);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif
@@ -0,0 +1,1062 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * \file keystore.h
+ * \brief Static key and pre-shared key directory interface
+ */
+
+/**
+ * \file keystore.c
+ * \brief Static key and pre-shared key directory implementation
+ */
+
+/**
+ * \defgroup keystore Static key and pre-shared key directory
+ *
+ * A key store maps the static public keys of remote parties to a
+ * pre-shared key and a block of application-defined metadata, such as
+ * the identity or permissions of the key's owner.  It is intended for
+ * responders that need to decide if the remote static key that was
+ * received during a handshake is acceptable, or to pick the pre-shared
+ * key to use for a particular client.
+ *
+ * Key stores are built offline with a NoiseKeyStoreBuilder or the
+ * "noise-keytool keystore" command, and then memory-mapped with
+ * noise_keystore_open().  The file contains an open-addressed hash table
+ * so lookups take the same small amount of time no matter how many
+ * millions of keys are present, and only the pages that are touched by
+ * lookups are ever read from disk.
+ *
+ * Lookups always examine the same number of hash table slots and compare
+ * keys with noise_is_equal(), so the time taken does not reveal whether
+ * a key was present or how close a near-miss was.
+ *
+ * Key stores are reference-counted.  A server that wants to reload its
+ * key store without pausing places it in a NoiseKeyStoreSlot.  Each
+ * connection acquires a reference from the slot with
+ * noise_keystore_slot_acquire(), and a reload thread replaces the
+ * contents of the slot with noise_keystore_slot_set().  Connections that
+ * are still using the old key store keep it alive until they release it.
+ *
+ * The file format is as follows, with all integers in little-endian
+ * byte order:
+ *
+ * \li 64-byte header: the magic number "NoiseKS1", a 32-bit version
+ * number (1), 16-bit public key and pre-shared key lengths, the 32-bit
+ * record size, the 32-bit maximum probe distance, the 64-bit number of
+ * records, the 64-bit number of hash buckets, the 64-bit hash seed,
+ * the 64-bit size of the metadata area, and 8 reserved bytes.
+ * \li Hash buckets: one 32-bit record number per bucket, padded to a
+ * multiple of 8 bytes.  Record numbers start at 1; 0 is an empty bucket.
+ * \li Records: the public key, the pre-shared key, 32-bit flags,
+ * and the 32-bit offset and length of the metadata, padded to a multiple
+ * of 8 bytes.
+ * \li Metadata: the metadata for all records, concatenated.
+ */
+/**@{*/
+
+/**
+ * \typedef NoiseKeyStore
+ * \brief Opaque object that represents a memory-mapped key store.
+ */
+
+/**
+ * \typedef NoiseKeyStoreSlot
+ * \brief Opaque object that holds the current key store for a server
+ * and allows it to be replaced while other threads are using it.
+ */
+
+/**
+ * \typedef NoiseKeyStoreBuilder
+ * \brief Opaque object that is used to build a new key store file.
+ */
+
+/**
+ * \typedef NoiseKeyStoreEntry
+ * \brief Information about a record that was found in a key store.
+ *
+ * The pointers refer to the key store's memory and remain valid until
+ * the reference to the NoiseKeyStore is released.
+ */
+
+/** @cond */
+
+#define NOISE_KEYSTORE_MAGIC        "NoiseKS1"
+#define NOISE_KEYSTORE_VERSION      1
+#define NOISE_KEYSTORE_HEADER_SIZE  64
+#define NOISE_KEYSTORE_MAX_KEY_LEN  1024
+#define NOISE_KEYSTORE_MAX_PSK_LEN  64
+#define NOISE_KEYSTORE_MAX_RECORDS  0x7FFFFFFFUL
+#define NOISE_KEYSTORE_FLAG_PSK     0x00000001
+
+#if defined(__ATOMIC_ACQUIRE) && defined(__ATOMIC_RELEASE)
+#define NOISE_KEYSTORE_HAVE_ATOMICS 1
+#endif
+
+/** @endcond */
+
+/**
+ * \brief Internal structure of the NoiseKeyStore type.
+ */
+struct NoiseKeyStore_s
+{
+    /** \brief Number of references to this key store */
+    uint32_t refs;
+
+    /** \brief The key store file, mapped into memory */
+    NoiseMappedFile file;
+
+    /** \brief Length of the public keys in the records */
+    size_t key_len;
+
+    /** \brief Length of the pre-shared keys in the records */
+    size_t psk_len;
+
+    /** \brief Size of each record */
+    size_t record_size;
+
+    /** \brief Number of buckets to examine for every lookup */
+    size_t probes;
+
+    /** \brief Number of records in the key store */
+    size_t num_records;
+
+    /** \brief Mask to convert a hash value into a bucket number */
+    size_t bucket_mask;
+
+    /** \brief Seed for the hash function */
+    uint64_t seed;
+
+    /** \brief Points to the hash buckets */
+    const uint8_t *buckets;
+
+    /** \brief Points to the records */
+    const uint8_t *records;
+
+    /** \brief Points to the metadata */
+    const uint8_t *metadata;
+
+    /** \brief Size of the metadata area */
+    size_t metadata_size;
+};
+
+/**
+ * \brief Internal structure of the NoiseKeyStoreSlot type.
+ */
+struct NoiseKeyStoreSlot_s
+{
+    /** \brief The current key store, or NULL if none */
+    NoiseKeyStore *store;
+
+    /** \brief Spin lock that protects reading and replacing \a store */
+    uint32_t lock;
+};
+
+/**
+ * \brief Record that has been added to a key store builder.
+ */
+typedef struct
+{
+    /** \brief Offset of the record's data in the builder's data buffer */
+    size_t offset;
+
+    /** \brief Hash of the public key */
+    uint64_t hash;
+
+} NoiseKeyStoreBuilderRecord;
+
+/**
+ * \brief Internal structure of the NoiseKeyStoreBuilder type.
+ */
+struct NoiseKeyStoreBuilder_s
+{
+    /** \brief Length of the public keys */
+    size_t key_len;
+
+    /** \brief Length of the pre-shared keys */
+    size_t psk_len;
+
+    /** \brief Size of each record in the file */
+    size_t record_size;
+
+    /** \brief Seed for the hash function */
+    uint64_t seed;
+
+    /** \brief Records that have been added so far */
+    NoiseKeyStoreBuilderRecord *records;
+
+    /** \brief Number of records that have been added */
+    size_t num_records;
+
+    /** \brief Maximum number of records before \a records is resized */
+    size_t max_records;
+
+    /** \brief Record data in file format, with the metadata offsets
+        relative to the start of \a metadata */
+    uint8_t *data;
+
+    /** \brief Metadata for all records */
+    uint8_t *metadata;
+
+    /** \brief Number of bytes of metadata */
+    size_t metadata_size;
+
+    /** \brief Maximum size of \a metadata before it is resized */
+    size_t max_metadata_size;
+};
+
+/**
+ * \brief Reads a little-endian 16-bit value.
+ */
+static uint16_t noise_keystore_get_le16(const uint8_t *data)
+{
+    return (uint16_t)(data[0] | (data[1] << 8));
+}
+
+/**
+ * \brief Reads a little-endian 32-bit value.
+ */
+static uint32_t noise_keystore_get_le32(const uint8_t *data)
+{
+    return ((uint32_t)(data[0])) |
+           (((uint32_t)(data[1])) << 8) |
+           (((uint32_t)(data[2])) << 16) |
+           (((uint32_t)(data[3])) << 24);
+}
+
+/**
+ * \brief Reads a little-endian 64-bit value.
+ */
+static uint64_t noise_keystore_get_le64(const uint8_t *data)
+{
+    return ((uint64_t)noise_keystore_get_le32(data)) |
+           (((uint64_t)noise_keystore_get_le32(data + 4)) << 32);
+}
+
+/**
+ * \brief Writes a little-endian 16-bit value.
+ */
+static void noise_keystore_put_le16(uint8_t *data, uint16_t value)
+{
+    data[0] = (uint8_t)value;
+    data[1] = (uint8_t)(value >> 8);
+}
+
+/**
+ * \brief Writes a little-endian 32-bit value.
+ */
+static void noise_keystore_put_le32(uint8_t *data, uint32_t value)
+{
+    data[0] = (uint8_t)value;
+    data[1] = (uint8_t)(value >> 8);
+    data[2] = (uint8_t)(value >> 16);
+    data[3] = (uint8_t)(value >> 24);
+}
+
+/**
+ * \brief Writes a little-endian 64-bit value.
+ */
+static void noise_keystore_put_le64(uint8_t *data, uint64_t value)
+{
+    noise_keystore_put_le32(data, (uint32_t)value);
+    noise_keystore_put_le32(data + 4, (uint32_t)(value >> 32));
+}
+
+/**
+ * \brief Mixes the bits of a 64-bit value.
+ */
+static uint64_t noise_keystore_mix(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/**
+ * \brief Hashes a public key to find its starting bucket.
+ *
+ * \param seed The seed for the hash function from the key store header.
+ * \param key Points to the public key.
+ * \param key_len Length of the public key in bytes.
+ *
+ * \return The hash value.
+ *
+ * Public keys are already close to uniformly random, so a fast mixing
+ * function is sufficient.  The seed stops a carefully chosen set of keys
+ * from creating long probe sequences in every key store.
+ */
+static uint64_t noise_keystore_hash
+    (uint64_t seed, const uint8_t *key, size_t key_len)
+{
+    uint64_t h = seed ^ (((uint64_t)key_len) * 0x9E3779B97F4A7C15ULL);
+    uint64_t tail = 0;
+    size_t index;
+    while (key_len >= 8) {
+        h = noise_keystore_mix(h ^ noise_keystore_get_le64(key));
+        key += 8;
+        key_len -= 8;
+    }
+    for (index = 0; index < key_len; ++index)
+        tail |= ((uint64_t)(key[index])) << (index * 8);
+    return noise_keystore_mix(h ^ tail);
+}
+
+/**
+ * \brief Rounds a size up to the next multiple of 8 bytes.
+ */
+#define noise_keystore_align8(size) (((size) + 7) & ~((size_t)7))
+
+/**
+ * \brief Parses and validates the header of a key store.
+ *
+ * \param store The key store, with the data already mapped.
+ *
+ * \return NOISE_ERROR_NONE on success or NOISE_ERROR_INVALID_FORMAT if
+ * the header is invalid or inconsistent with the size of the file.
+ *
+ * The individual buckets and records are not examined here because
+ * that would touch every page of the file.  Instead, noise_keystore_lookup()
+ * range-checks the values that it uses.
+ */
+static int noise_keystore_parse_header(NoiseKeyStore *store)
+{
+    const uint8_t *header = store->file.data;
+    uint64_t num_records, num_buckets, metadata_size, probes;
+    uint64_t buckets_size, records_size;
+
+    /* Check the magic number and version */
+    if (memcmp(header, NOISE_KEYSTORE_MAGIC, 8) != 0 ||
+            noise_keystore_get_le32(header + 8) != NOISE_KEYSTORE_VERSION)
+        return NOISE_ERROR_INVALID_FORMAT;
+
+    /* Check the record layout */
+    store->key_len = noise_keystore_get_le16(header + 12);
+    store->psk_len = noise_keystore_get_le16(header + 14);
+    store->record_size = noise_keystore_get_le32(header + 16);
+    if (!(store->key_len) || store->key_len > NOISE_KEYSTORE_MAX_KEY_LEN ||
+            store->psk_len > NOISE_KEYSTORE_MAX_PSK_LEN ||
+            store->record_size != noise_keystore_align8
+                (store->key_len + store->psk_len + 12))
+        return NOISE_ERROR_INVALID_FORMAT;
+
+    /* Check the table sizes against the size of the file */
+    probes = noise_keystore_get_le32(header + 20);
+    num_records = noise_keystore_get_le64(header + 24);
+    num_buckets = noise_keystore_get_le64(header + 32);
+    store->seed = noise_keystore_get_le64(header + 40);
+    metadata_size = noise_keystore_get_le64(header + 48);
+    if (num_records > NOISE_KEYSTORE_MAX_RECORDS ||
+            num_buckets > (NOISE_KEYSTORE_MAX_RECORDS + 1) * 2 ||
+            num_buckets < 2 || (num_buckets & (num_buckets - 1)) != 0 ||
+            num_records >= num_buckets || probes >= num_buckets)
+        return NOISE_ERROR_INVALID_FORMAT;
+    buckets_size = noise_keystore_align8(num_buckets * 4);
+    records_size = num_records * store->record_size;
+    if (metadata_size > store->file.size ||
+            (NOISE_KEYSTORE_HEADER_SIZE + buckets_size + records_size +
+                metadata_size) != (uint64_t)(store->file.size))
+        return NOISE_ERROR_INVALID_FORMAT;
+
+    /* Fill in the rest of the store details */
+    store->probes = (size_t)probes + 1;
+    store->num_records = (size_t)num_records;
+    store->bucket_mask = (size_t)(num_buckets - 1);
+    store->buckets = store->file.data + NOISE_KEYSTORE_HEADER_SIZE;
+    store->records = store->buckets + (size_t)buckets_size;
+    store->metadata = store->records + (size_t)records_size;
+    store->metadata_size = (size_t)metadata_size;
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Opens a key store file.
+ *
+ * \param store Points to the variable where to store the pointer to
+ * the new NoiseKeyStore object.
+ * \param filename The name of the key store file to open.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a store or \a filename is NULL.
+ * \return NOISE_ERROR_SYSTEM if the file could not be opened or mapped
+ * into memory, with further information in the system errno variable.
+ * \return NOISE_ERROR_INVALID_FORMAT if the file is not a valid key store.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory to
+ * allocate the new object.
+ *
+ * The file is mapped into memory read-only.  Key store files should be
+ * replaced by renaming a new file over the top of the old one, as
+ * noise_keystore_builder_save() does, and never modified in place while
+ * they are open.
+ *
+ * The new object has a single reference, which is released by
+ * noise_keystore_close().
+ *
+ * \sa noise_keystore_close(), noise_keystore_lookup()
+ */
+int noise_keystore_open(NoiseKeyStore **store, const char *filename)
+{
+    int err;
+
+    /* Validate the parameters */
+    if (!store)
+        return NOISE_ERROR_INVALID_PARAM;
+    *store = 0;
+    if (!filename)
+        return NOISE_ERROR_INVALID_PARAM;
+
+    /* Allocate the object and map the file into memory */
+    *store = (NoiseKeyStore *)calloc(1, sizeof(NoiseKeyStore));
+    if (!(*store))
+        return NOISE_ERROR_NO_MEMORY;
+    (*store)->refs = 1;
+    err = noise_mapped_file_open
+        (&((*store)->file), filename, NOISE_KEYSTORE_HEADER_SIZE);
+    if (err == NOISE_ERROR_NONE)
+        err = noise_keystore_parse_header(*store);
+    if (err != NOISE_ERROR_NONE) {
+        noise_mapped_file_close(&((*store)->file));
+        free(*store);
+        *store = 0;
+    }
+    return err;
+}
+
+/**
+ * \brief Adds a reference to a key store.
+ *
+ * \param store The NoiseKeyStore object.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a store is NULL.
+ *
+ * Each call to this function must be matched by a call to
+ * noise_keystore_close().
+ */
+int noise_keystore_ref(NoiseKeyStore *store)
+{
+    if (!store)
+        return NOISE_ERROR_INVALID_PARAM;
+#if NOISE_KEYSTORE_HAVE_ATOMICS
+    __atomic_add_fetch(&(store->refs), 1, __ATOMIC_RELAXED);
+#else
+    ++(store->refs);
+#endif
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Releases a reference to a key store.
+ *
+ * \param store The NoiseKeyStore object.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a store is NULL.
+ *
+ * When the last reference is released, the key store is unmapped from
+ * memory and all NoiseKeyStoreEntry values that refer to it become invalid.
+ *
+ * \sa noise_keystore_open(), noise_keystore_ref()
+ */
+int noise_keystore_close(NoiseKeyStore *store)
+{
+    uint32_t refs;
+    if (!store)
+        return NOISE_ERROR_INVALID_PARAM;
+#if NOISE_KEYSTORE_HAVE_ATOMICS
+    refs = __atomic_sub_fetch(&(store->refs), 1, __ATOMIC_ACQ_REL);
+#else
+    refs = --(store->refs);
+#endif
+    if (!refs) {
+        noise_mapped_file_close(&(store->file));
+        free(store);
+    }
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Gets the number of records in a key store.
+ *
+ * \param store The NoiseKeyStore object.
+ *
+ * \return The number of records, or zero if \a store is NULL.
+ */
+size_t noise_keystore_get_count(const NoiseKeyStore *store)
+{
+    return store ? store->num_records : 0;
+}
+
+/**
+ * \brief Gets the length of the public keys in a key store.
+ *
+ * \param store The NoiseKeyStore object.
+ *
+ * \return The public key length in bytes, or zero if \a store is NULL.
+ */
+size_t noise_keystore_get_key_length(const NoiseKeyStore *store)
+{
+    return store ? store->key_len : 0;
+}
+
+/**
+ * \brief Looks up a public key in a key store.
+ *
+ * \param store The NoiseKeyStore object.
+ * \param key Points to the public key to look up.
+ * \param key_len The length of the public key in bytes.
+ * \param entry Returns information about the record for \a key.
+ * This parameter may be NULL if the caller only needs to know if
+ * the key is present.
+ *
+ * \return NOISE_ERROR_NONE if the key was found.
+ * \return NOISE_ERROR_INVALID_PARAM if \a store or \a key is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if \a key_len is not the length of
+ * the public keys in the key store.
+ * \return NOISE_ERROR_INVALID_PUBLIC_KEY if the key is not present.
+ * \return NOISE_ERROR_INVALID_FORMAT if the record for the key is corrupt.
+ *
+ * The same number of hash buckets are examined for every lookup, and all
+ * key comparisons are performed in constant time, so the time taken does
+ * not depend upon whether the key is present.
+ */
+int noise_keystore_lookup
+    (const NoiseKeyStore *store, const uint8_t *key, size_t key_len,
+     NoiseKeyStoreEntry *entry)
+{
+    const uint8_t *record;
+    size_t bucket, probe, index;
+    size_t found_index = 0;
+    uint32_t value, meta_offset, meta_len, flags;
+    int found = 0;
+    int present, equal;
+
+    /* Validate the parameters */
+    if (entry)
+        memset(entry, 0, sizeof(NoiseKeyStoreEntry));
+    if (!store || !key)
+        return NOISE_ERROR_INVALID_PARAM;
+    if (key_len != store->key_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+    if (!(store->num_records))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+
+    /* Examine every bucket within the maximum probe distance.  Empty
+       buckets compare against record 0 so that they take the same time */
+    bucket = (size_t)noise_keystore_hash(store->seed, key, key_len);
+    for (probe = 0; probe < store->probes; ++probe, ++bucket) {
+        bucket &= store->bucket_mask;
+        value = noise_keystore_get_le32(store->buckets + bucket * 4);
+        present = (value != 0) & (value <= store->num_records);
+        index = ((size_t)value - 1) & (((size_t)0) - (size_t)present);
+        record = store->records + index * store->record_size;
+        equal = noise_is_equal(record, key, key_len) & present;
+        found_index |= index & (((size_t)0) - (size_t)equal);
+        found |= equal;
+    }
+    if (!found)
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+
+    /* Decode the record that we found */
+    record = store->records + found_index * store->record_size +
+             store->key_len;
+    flags = noise_keystore_get_le32(record + store->psk_len);
+    meta_offset = noise_keystore_get_le32(record + store->psk_len + 4);
+    meta_len = noise_keystore_get_le32(record + store->psk_len + 8);
+    if (meta_offset > store->metadata_size ||
+            meta_len > (store->metadata_size - meta_offset))
+        return NOISE_ERROR_INVALID_FORMAT;
+    if (entry) {
+        if ((flags & NOISE_KEYSTORE_FLAG_PSK) != 0 && store->psk_len) {
+            entry->psk = record;
+            entry->psk_len = store->psk_len;
+        }
+        entry->metadata = store->metadata + meta_offset;
+        entry->metadata_len = meta_len;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Looks up the public key from a DHState object in a key store.
+ *
+ * \param store The NoiseKeyStore object.
+ * \param dh The DHState object containing the public key, usually from
+ * noise_handshakestate_get_remote_public_key_dh().
+ * \param entry Returns information about the record for the key.
+ * This parameter may be NULL.
+ *
+ * \return NOISE_ERROR_NONE if the key was found.
+ * \return NOISE_ERROR_INVALID_PARAM if \a store or \a dh is NULL.
+ * \return NOISE_ERROR_INVALID_STATE if \a dh does not have a public key.
+ * \return NOISE_ERROR_INVALID_LENGTH if the public key in \a dh does not
+ * have the same length as the public keys in the key store.
+ * \return NOISE_ERROR_INVALID_PUBLIC_KEY if the key is not present.
+ * \return NOISE_ERROR_INVALID_FORMAT if the record for the key is corrupt.
+ *
+ * \sa noise_keystore_lookup()
+ */
+int noise_keystore_lookup_dhstate
+    (const NoiseKeyStore *store, const NoiseDHState *dh,
+     NoiseKeyStoreEntry *entry)
+{
+    uint8_t key[NOISE_KEYSTORE_MAX_KEY_LEN];
+    size_t key_len;
+    int err;
+
+    /* Validate the parameters */
+    if (entry)
+        memset(entry, 0, sizeof(NoiseKeyStoreEntry));
+    if (!store || !dh)
+        return NOISE_ERROR_INVALID_PARAM;
+    if (!noise_dhstate_has_public_key(dh))
+        return NOISE_ERROR_INVALID_STATE;
+    key_len = noise_dhstate_get_public_key_length(dh);
+    if (key_len != store->key_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* Fetch the public key and look it up */
+    err = noise_dhstate_get_public_key(dh, key, key_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    return noise_keystore_lookup(store, key, key_len, entry);
+}
+
+/**
+ * \brief Creates a new key store slot.
+ *
+ * \param slot Points to the variable where to store the pointer to
+ * the new NoiseKeyStoreSlot object.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a slot is NULL.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory to
+ * allocate the new object.
+ *
+ * The slot is initially empty.
+ *
+ * \sa noise_keystore_slot_set(), noise_keystore_slot_acquire()
+ */
+int noise_keystore_slot_new(NoiseKeyStoreSlot **slot)
+{
+    if (!slot)
+        return NOISE_ERROR_INVALID_PARAM;
+    *slot = (NoiseKeyStoreSlot *)calloc(1, sizeof(NoiseKeyStoreSlot));
+    return *slot ? NOISE_ERROR_NONE : NOISE_ERROR_NO_MEMORY;
+}
+
+/**
+ * \brief Frees a key store slot and releases its key store.
+ *
+ * \param slot The NoiseKeyStoreSlot object.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a slot is NULL.
+ */
+int noise_keystore_slot_free(NoiseKeyStoreSlot *slot)
+{
+    if (!slot)
+        return NOISE_ERROR_INVALID_PARAM;
+    if (slot->store)
+        noise_keystore_close(slot->store);
+    free(slot);
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Locks a key store slot.
+ *
+ * \param slot The NoiseKeyStoreSlot object.
+ *
+ * The lock is only ever held for a few instructions while the pointer to
+ * the key store is read or replaced, so spinning is cheaper than sleeping.
+ */
+static void noise_keystore_slot_lock(NoiseKeyStoreSlot *slot)
+{
+#if NOISE_KEYSTORE_HAVE_ATOMICS
+    while (__atomic_exchange_n(&(slot->lock), 1, __ATOMIC_ACQUIRE) != 0) {
+        while (__atomic_load_n(&(slot->lock), __ATOMIC_RELAXED) != 0)
+            ;
+    }
+#else
+    (void)slot;
+#endif
+}
+
+/**
+ * \brief Unlocks a key store slot.
+ *
+ * \param slot The NoiseKeyStoreSlot object.
+ */
+static void noise_keystore_slot_unlock(NoiseKeyStoreSlot *slot)
+{
+#if NOISE_KEYSTORE_HAVE_ATOMICS
+    __atomic_store_n(&(slot->lock), 0, __ATOMIC_RELEASE);
+#else
+    (void)slot;
+#endif
+}
+
+/**
+ * \brief Replaces the key store in a slot.
+ *
+ * \param slot The NoiseKeyStoreSlot object.
+ * \param store The new key store, or NULL to empty the slot.  The slot
+ * takes over the caller's reference to \a store.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a slot is NULL.
+ *
+ * The previous key store in the slot is released.  Threads that acquired
+ * it earlier can keep using it until they release their own references.
+ *
+ * \sa noise_keystore_slot_acquire()
+ */
+int noise_keystore_slot_set(NoiseKeyStoreSlot *slot, NoiseKeyStore *store)
+{
+    NoiseKeyStore *old_store;
+    if (!slot)
+        return NOISE_ERROR_INVALID_PARAM;
+    noise_keystore_slot_lock(slot);
+    old_store = slot->store;
+    slot->store = store;
+    noise_keystore_slot_unlock(slot);
+    if (old_store)
+        noise_keystore_close(old_store);
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Acquires a reference to the current key store in a slot.
+ *
+ * \param slot The NoiseKeyStoreSlot object.
+ *
+ * \return The current key store, or NULL if \a slot is NULL or empty.
+ * The caller must release the reference with noise_keystore_close().
+ *
+ * A connection should acquire the key store once and use the same
+ * reference for all lookups during its handshake, so that a reload in
+ * the middle of the handshake cannot give inconsistent answers.
+ */
+NoiseKeyStore *noise_keystore_slot_acquire(NoiseKeyStoreSlot *slot)
+{
+    NoiseKeyStore *store;
+    if (!slot)
+        return 0;
+    noise_keystore_slot_lock(slot);
+    store = slot->store;
+    if (store)
+        noise_keystore_ref(store);
+    noise_keystore_slot_unlock(slot);
+    return store;
+}
+
+/**
+ * \brief Creates a new key store builder.
+ *
+ * \param builder Points to the variable where to store the pointer to
+ * the new NoiseKeyStoreBuilder object.
+ * \param key_len The length of the public keys, which must be the same
+ * for all records; e.g. 32 for Curve25519.
+ * \param psk_len The length of the pre-shared keys, or zero if the key
+ * store will not contain pre-shared keys.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a builder is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if \a key_len or \a psk_len is
+ * out of range.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory to
+ * allocate the new object.
+ *
+ * \sa noise_keystore_builder_add(), noise_keystore_builder_save()
+ */
+int noise_keystore_builder_new
+    (NoiseKeyStoreBuilder **builder, size_t key_len, size_t psk_len)
+{
+    /* Validate the parameters */
+    if (!builder)
+        return NOISE_ERROR_INVALID_PARAM;
+    *builder = 0;
+    if (!key_len || key_len > NOISE_KEYSTORE_MAX_KEY_LEN ||
+            psk_len > NOISE_KEYSTORE_MAX_PSK_LEN)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* Allocate the builder and choose a random hash seed */
+    *builder = (NoiseKeyStoreBuilder *)calloc(1, sizeof(NoiseKeyStoreBuilder));
+    if (!(*builder))
+        return NOISE_ERROR_NO_MEMORY;
+    (*builder)->key_len = key_len;
+    (*builder)->psk_len = psk_len;
+    (*builder)->record_size = noise_keystore_align8(key_len + psk_len + 12);
+    {
+        uint8_t seed[8];
+        noise_randstate_generate_simple(seed, sizeof(seed));
+        (*builder)->seed = noise_keystore_get_le64(seed);
+    }
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Frees a key store builder.
+ *
+ * \param builder The NoiseKeyStoreBuilder object.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a builder is NULL.
+ *
+ * The pre-shared keys in the builder are securely erased.
+ */
+int noise_keystore_builder_free(NoiseKeyStoreBuilder *builder)
+{
+    if (!builder)
+        return NOISE_ERROR_INVALID_PARAM;
+    if (builder->data)
+        noise_free(builder->data, builder->max_records * builder->record_size);
+    free(builder->records);
+    free(builder->metadata);
+    free(builder);
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Adds a record to a key store builder.
+ *
+ * \param builder The NoiseKeyStoreBuilder object.
+ * \param key Points to the public key.
+ * \param key_len The length of the public key in bytes, which must be
+ * the same as the length that was given to noise_keystore_builder_new().
+ * \param psk Points to the pre-shared key for the record, or NULL if
+ * there is no pre-shared key.
+ * \param psk_len The length of the pre-shared key in bytes, which must
+ * be the same as the length given to noise_keystore_builder_new(),
+ * or zero if \a psk is NULL.
+ * \param metadata Points to the metadata for the record, or NULL if none.
+ * \param metadata_len The length of the metadata in bytes.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a builder or \a key is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if \a key_len or \a psk_len is
+ * incorrect, or there are too many records or too much metadata.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory to
+ * add the record.
+ *
+ * Duplicate public keys are reported by noise_keystore_builder_save().
+ */
+int noise_keystore_builder_add
+    (NoiseKeyStoreBuilder *builder, const uint8_t *key, size_t key_len,
+     const uint8_t *psk, size_t psk_len,
+     const void *metadata, size_t metadata_len)
+{
+    NoiseKeyStoreBuilderRecord *rec;
+    uint8_t *data;
+
+    /* Validate the parameters */
+    if (!builder || !key || (!metadata && metadata_len))
+        return NOISE_ERROR_INVALID_PARAM;
+    if (key_len != builder->key_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+    if (psk ? (psk_len != builder->psk_len || !psk_len) : (psk_len != 0))
+        return NOISE_ERROR_INVALID_LENGTH;
+    if (builder->num_records >= NOISE_KEYSTORE_MAX_RECORDS ||
+            metadata_len > (0xFFFFFFFFUL - builder->metadata_size))
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* Grow the record arrays if necessary */
+    if (builder->num_records >= builder->max_records) {
+        size_t new_max = builder->max_records ? builder->max_records * 2 : 64;
+        NoiseKeyStoreBuilderRecord *new_records;
+        new_records = (NoiseKeyStoreBuilderRecord *)realloc
+            (builder->records, new_max * sizeof(NoiseKeyStoreBuilderRecord));
+        if (!new_records)
+            return NOISE_ERROR_NO_MEMORY;
+        builder->records = new_records;
+        data = (uint8_t *)calloc(new_max, builder->record_size);
+        if (!data)
+            return NOISE_ERROR_NO_MEMORY;
+        if (builder->data) {
+            memcpy(data, builder->data,
+                   builder->num_records * builder->record_size);
+            noise_free(builder->data,
+                       builder->max_records * builder->record_size);
+        }
+        builder->data = data;
+        builder->max_records = new_max;
+    }
+
+    /* Grow the metadata buffer if necessary */
+    if (metadata_len > (builder->max_metadata_size - builder->metadata_size)) {
+        size_t new_max = builder->max_metadata_size ?
+            builder->max_metadata_size : 1024;
+        uint8_t *new_metadata;
+        while (new_max < (builder->metadata_size + metadata_len))
+            new_max *= 2;
+        new_metadata = (uint8_t *)realloc(builder->metadata, new_max);
+        if (!new_metadata)
+            return NOISE_ERROR_NO_MEMORY;
+        builder->metadata = new_metadata;
+        builder->max_metadata_size = new_max;
+    }
+
+    /* Format the record */
+    rec = &(builder->records[builder->num_records]);
+    rec->offset = builder->num_records * builder->record_size;
+    rec->hash = noise_keystore_hash(builder->seed, key, key_len);
+    data = builder->data + rec->offset;
+    memcpy(data, key, key_len);
+    data += key_len;
+    if (psk)
+        memcpy(data, psk, psk_len);
+    data += builder->psk_len;
+    noise_keystore_put_le32(data, psk ? NOISE_KEYSTORE_FLAG_PSK : 0);
+    noise_keystore_put_le32(data + 4, (uint32_t)(builder->metadata_size));
+    noise_keystore_put_le32(data + 8, (uint32_t)metadata_len);
+    if (metadata_len) {
+        memcpy(builder->metadata + builder->metadata_size,
+               metadata, metadata_len);
+        builder->metadata_size += metadata_len;
+    }
+    ++(builder->num_records);
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Saves the contents of a key store builder to a file.
+ *
+ * \param builder The NoiseKeyStoreBuilder object.
+ * \param filename The name of the key store file to save to.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a builder or \a filename is NULL,
+ * or the same public key was added more than once.
+ * \return NOISE_ERROR_SYSTEM if there was a problem writing the file,
+ * with further information in the system errno variable.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory to
+ * build the hash table.
+ *
+ * The data is written to a temporary file called "filename.tmp" which is
+ * then renamed to \a filename.  Servers that have the previous version
+ * of the file open will continue to see the old contents until they
+ * open the file again.
+ */
+int noise_keystore_builder_save
+    (NoiseKeyStoreBuilder *builder, const char *filename)
+{
+    uint8_t header[NOISE_KEYSTORE_HEADER_SIZE];
+    uint8_t *buckets = 0;
+    size_t num_buckets, buckets_size, bucket, index, probe, other;
+    size_t max_probe = 0;
+    char *temp_name = 0;
+    FILE *file = 0;
+    int err = NOISE_ERROR_NONE;
+
+    /* Validate the parameters */
+    if (!builder || !filename)
+        return NOISE_ERROR_INVALID_PARAM;
+
+    /* Build the hash table with a load factor of at most 1/2 */
+    num_buckets = 16;
+    while (num_buckets < builder->num_records * 2)
+        num_buckets *= 2;
+    buckets_size = noise_keystore_align8(num_buckets * 4);
+    buckets = (uint8_t *)calloc(1, buckets_size);
+    if (!buckets)
+        return NOISE_ERROR_NO_MEMORY;
+    for (index = 0; index < builder->num_records; ++index) {
+        bucket = (size_t)(builder->records[index].hash);
+        for (probe = 0; ; ++probe, ++bucket) {
+            bucket &= num_buckets - 1;
+            other = noise_keystore_get_le32(buckets + bucket * 4);
+            if (!other)
+                break;
+            if (memcmp(builder->data + builder->records[other - 1].offset,
+                       builder->data + builder->records[index].offset,
+                       builder->key_len) == 0) {
+                free(buckets);
+                return NOISE_ERROR_INVALID_PARAM;
+            }
+        }
+        noise_keystore_put_le32(buckets + bucket * 4, (uint32_t)(index + 1));
+        if (probe > max_probe)
+            max_probe = probe;
+    }
+
+    /* Format the header */
+    memset(header, 0, sizeof(header));
+    memcpy(header, NOISE_KEYSTORE_MAGIC, 8);
+    noise_keystore_put_le32(header + 8, NOISE_KEYSTORE_VERSION);
+    noise_keystore_put_le16(header + 12, (uint16_t)(builder->key_len));
+    noise_keystore_put_le16(header + 14, (uint16_t)(builder->psk_len));
+    noise_keystore_put_le32(header + 16, (uint32_t)(builder->record_size));
+    noise_keystore_put_le32(header + 20, (uint32_t)max_probe);
+    noise_keystore_put_le64(header + 24, builder->num_records);
+    noise_keystore_put_le64(header + 32, num_buckets);
+    noise_keystore_put_le64(header + 40, builder->seed);
+    noise_keystore_put_le64(header + 48, builder->metadata_size);
+
+    /* Write everything to a temporary file and then rename it */
+    temp_name = (char *)malloc(strlen(filename) + 5);
+    if (!temp_name) {
+        free(buckets);
+        return NOISE_ERROR_NO_MEMORY;
+    }
+    strcpy(temp_name, filename);
+    strcat(temp_name, ".tmp");
+    file = fopen(temp_name, "wb");
+    if (!file) {
+        err = NOISE_ERROR_SYSTEM;
+    } else {
+        if (fwrite(header, 1, sizeof(header), file) != sizeof(header) ||
+                fwrite(buckets, 1, buckets_size, file) != buckets_size ||
+                (builder->num_records &&
+                 fwrite(builder->data, builder->record_size,
+                        builder->num_records, file) != builder->num_records) ||
+                (builder->metadata_size &&
+                 fwrite(builder->metadata, 1, builder->metadata_size, file)
+                        != builder->metadata_size))
+            err = NOISE_ERROR_SYSTEM;
+        if (fclose(file) != 0)
+            err = NOISE_ERROR_SYSTEM;
+#if defined(__WIN32__) || defined(WIN32)
+        if (err == NOISE_ERROR_NONE)
+            remove(filename);
+#endif
+        if (err == NOISE_ERROR_NONE && rename(temp_name, filename) != 0)
+            err = NOISE_ERROR_SYSTEM;
+        if (err != NOISE_ERROR_NONE)
+            remove(temp_name);
+    }
+
+    /* Clean up and exit */
+    free(temp_name);
+    free(buckets);
+    return err;
+}
+
+/**@}*/
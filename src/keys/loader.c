@@ -95,6 +95,7 @@ static int noise_load_file
     pbuf->size = 0;
     pbuf->posn = 0;
     pbuf->error = NOISE_ERROR_NONE;
+    pbuf->arena = 0;
 
     /* Attempt to open the file */
     if (!filename)
@@ -208,6 +209,10 @@ int noise_load_certificate_from_file
  * No verification will be performed on the certificate even if the
  * remaining certificates in the chain would allow verification.
  *
+ * If \a pbuf was prepared with noise_protobuf_prepare_input_arena(),
+ * then the certificate is decoded into the arena and must be discarded
+ * with noise_protobuf_arena_reset() instead of Noise_Certificate_free().
+ *
  * \sa noise_load_certificate_from_file(), noise_save_certificate_to_buffer()
  */
 int noise_load_certificate_from_buffer
@@ -236,12 +241,13 @@ int noise_load_certificate_from_buffer
                 break;
             if (!(*cert))
                 *cert = cert2;
-            else
+            else if (!pbuf->arena)
                 Noise_Certificate_free(cert2);
         }
         err = noise_protobuf_read_end_element(pbuf, end_posn);
         if (err != NOISE_ERROR_NONE) {
-            Noise_Certificate_free(*cert);
+            if (!pbuf->arena)
+                Noise_Certificate_free(*cert);
             *cert = 0;
         }
         return err;
@@ -251,6 +257,52 @@ int noise_load_certificate_from_buffer
     return Noise_Certificate_read(pbuf, 0, cert);
 }
 
+/**
+ * \brief Loads a singleton certificate into an arena as a certificate chain.
+ *
+ * \param chain Variable that returns the certificate chain if one is loaded.
+ * \param pbuf The protobuf to load the certificate from, which must have
+ * been prepared with an arena.
+ *
+ * \return NOISE_ERROR_NONE on success, or an error code otherwise.
+ *
+ * The chain cannot be assembled with the regular accessor functions because
+ * they allocate from the heap.  Instead the certificate is re-encoded as a
+ * chain containing a single certificate in the arena and then parsed.
+ */
+static int noise_load_certificate_as_chain_arena
+    (Noise_CertificateChain **chain, NoiseProtobuf *pbuf)
+{
+    NoiseProtobuf wrapped;
+    size_t len = pbuf->size - pbuf->posn;
+    size_t size = len + 16;
+    uint8_t *data;
+    int err;
+
+    /* Wrap the certificate in a "certs" field, allowing extra room
+       for the tag and length varints */
+    data = (uint8_t *)noise_protobuf_arena_alloc(pbuf->arena, size);
+    if (!data) {
+        pbuf->error = NOISE_ERROR_NO_MEMORY;
+        return pbuf->error;
+    }
+    noise_protobuf_prepare_output(&wrapped, data, size);
+    noise_protobuf_write_bytes(&wrapped, 8, pbuf->data + pbuf->posn, len);
+    err = noise_protobuf_finish_output(&wrapped, &data, &size);
+
+    /* Parse the wrapped version as a certificate chain */
+    if (err == NOISE_ERROR_NONE) {
+        noise_protobuf_prepare_input_arena
+            (&wrapped, data, size, pbuf->arena);
+        err = Noise_CertificateChain_read(&wrapped, 0, chain);
+    }
+    if (err == NOISE_ERROR_NONE)
+        pbuf->posn = pbuf->size;
+    else
+        pbuf->error = err;
+    return err;
+}
+
 /**
  * \brief Loads a certificate chain from a file.
  *
@@ -308,6 +360,12 @@ int noise_load_certificate_chain_from_file
  * function will load the certificate and convert it into a chain containing
  * a single certificate.
  *
+ * If \a pbuf was prepared with noise_protobuf_prepare_input_arena(),
+ * then the chain is decoded into the arena and must be discarded with
+ * noise_protobuf_arena_reset() instead of Noise_CertificateChain_free().
+ * This avoids a separate heap allocation for every certificate, key,
+ * signature, and string in the chain.
+ *
  * \sa noise_load_certificate_chain_from_file(),
  * noise_save_certificate_chain_to_buffer()
  */
@@ -329,6 +387,8 @@ int noise_load_certificate_chain_from_buffer
     if (noise_protobuf_peek_tag(pbuf) != 8) {
         Noise_Certificate *cert = 0;
         int err;
+        if (pbuf->arena)
+            return noise_load_certificate_as_chain_arena(chain, pbuf);
         err = Noise_CertificateChain_new(chain);
         if (err != NOISE_ERROR_NONE)
             return err;
@@ -445,6 +505,9 @@ static int noise_parse_protect_name
  * The private key is expected to occupy the entire buffer.  Trailing
  * unknown data will be rejected as invalid.
  *
+ * The private key is always allocated from the heap, even if \a pbuf
+ * was prepared with an arena.
+ *
  * \sa noise_load_private_key_from_file(), noise_save_private_key_to_buffer()
  */
 int noise_load_private_key_from_buffer
@@ -452,6 +515,7 @@ int noise_load_private_key_from_buffer
      const void *passphrase, size_t passphrase_len)
 {
     Noise_EncryptedPrivateKey *enc_key = 0;
+    NoiseProtobuf pcopy;
     NoiseCipherState *cipher = 0;
     NoiseHashState *hash = 0;
     uint8_t key_data[40];
@@ -467,8 +531,14 @@ int noise_load_private_key_from_buffer
     if (!pbuf || !passphrase)
         return NOISE_ERROR_INVALID_PARAM;
 
-    /* Load the encrypted version of the private key */
-    err = Noise_EncryptedPrivateKey_read(pbuf, 0, &enc_key);
+    /* Load the encrypted version of the private key.  This is always
+       decoded onto the heap, ignoring any arena, because the encrypted
+       data is decrypted in-place and must not alias the caller's input */
+    pcopy = *pbuf;
+    pcopy.arena = 0;
+    err = Noise_EncryptedPrivateKey_read(&pcopy, 0, &enc_key);
+    pbuf->posn = pcopy.posn;
+    pbuf->error = pcopy.error;
     if (err != NOISE_ERROR_NONE)
         return err;
 
@@ -502,13 +572,14 @@ int noise_load_private_key_from_buffer
     memset(&buf, 0, sizeof(buf));
     if (err == NOISE_ERROR_NONE) {
         /* Generate the key material using PBKDF2 */
-        noise_hashstate_pbkdf2
+        err = noise_hashstate_pbkdf2
             (hash, (const uint8_t *)passphrase, passphrase_len,
              (const uint8_t *)Noise_EncryptedPrivateKey_get_salt(enc_key),
              Noise_EncryptedPrivateKey_get_size_salt(enc_key),
              Noise_EncryptedPrivateKey_get_iterations(enc_key),
              key_data, sizeof(key_data));
-
+    }
+    if (err == NOISE_ERROR_NONE) {
         /* Set the decryption key */
         noise_cipherstate_init_key(cipher, key_data, 32);
 
@@ -550,9 +621,14 @@ int noise_load_private_key_from_buffer
 /** @cond */
 
 /**
- * \brief Prototype for a protobuf object write function.
+ * \brief Prototype for a protobuf object measure function.
+ */
+typedef size_t (*NoiseMeasureFunc)(int tag, const void *obj);
+
+/**
+ * \brief Prototype for a protobuf object encode function.
  */
-typedef int (*NoiseWriteFunc)(NoiseProtobuf *pbuf, int tag, const void *obj);
+typedef int (*NoiseEncodeFunc)(NoiseProtobuf *pbuf, int tag, const void *obj);
 
 /** @endcond */
 
@@ -561,16 +637,21 @@ typedef int (*NoiseWriteFunc)(NoiseProtobuf *pbuf, int tag, const void *obj);
  *
  * \param obj The object to save.
  * \param filename The name of the file to save in.
- * \param func Pointer to the write function to use to serialize the object.
+ * \param measure Pointer to the measure function for the object's type.
+ * \param encode Pointer to the encode function for the object's type.
  *
  * \return NOISE_ERROR_NONE on success, or an error code otherwise.
+ *
+ * The object is measured once to size the buffer exactly and then
+ * encoded in a single forwards pass.
  */
 static int noise_save_to_file
-    (const void *obj, const char *filename, NoiseWriteFunc func)
+    (const void *obj, const char *filename,
+     NoiseMeasureFunc measure, NoiseEncodeFunc encode)
 {
     NoiseProtobuf pbuf;
-    uint8_t *data = 0;
-    size_t size = 0;
+    uint8_t *data;
+    size_t size;
     int err;
     FILE *file;
 
@@ -579,26 +660,20 @@ static int noise_save_to_file
         return NOISE_ERROR_INVALID_PARAM;
 
     /* Measure the size of the serialized object */
-    noise_protobuf_prepare_measure(&pbuf, NOISE_MAX_PAYLOAD_LEN);
-    err = (*func)(&pbuf, 0, obj); 
-    if (err != NOISE_ERROR_NONE)
-        return err;
-    err = noise_protobuf_finish_measure(&pbuf, &size);
-    if (err != NOISE_ERROR_NONE)
-        return err;
+    size = (*measure)(0, obj);
+    if (size > NOISE_MAX_PAYLOAD_LEN)
+        return NOISE_ERROR_INVALID_LENGTH;
 
     /* Allocate memory to hold the serialized form temporarily */
-    pbuf.data = (uint8_t *)malloc(size);
-    if (!(pbuf.data))
+    data = (uint8_t *)malloc(size ? size : 1);
+    if (!data)
         return NOISE_ERROR_NO_MEMORY;
-    pbuf.size = size;
-    pbuf.posn = size;
-    pbuf.error = NOISE_ERROR_NONE;
-    err = (*func)(&pbuf, 0, obj); 
+    noise_protobuf_prepare_encode(&pbuf, data, size);
+    err = (*encode)(&pbuf, 0, obj);
     if (err == NOISE_ERROR_NONE)
-        err = noise_protobuf_finish_output(&pbuf, &data, &size);
+        err = noise_protobuf_finish_encode(&pbuf, &size);
     if (err != NOISE_ERROR_NONE) {
-        noise_free(pbuf.data, pbuf.size);
+        noise_free(data, pbuf.size);
         return err;
     }
 
@@ -613,7 +688,7 @@ static int noise_save_to_file
     }
 
     /* Clean up and exit */
-    noise_free(pbuf.data, pbuf.size);
+    noise_free(data, pbuf.size);
     return err;
 }
 
@@ -637,7 +712,8 @@ int noise_save_certificate_to_file
     (const Noise_Certificate *cert, const char *filename)
 {
     return noise_save_to_file
-        (cert, filename, (NoiseWriteFunc)Noise_Certificate_write);
+        (cert, filename, (NoiseMeasureFunc)Noise_Certificate_measure,
+         (NoiseEncodeFunc)Noise_Certificate_encode);
 }
 
 /**
@@ -678,7 +754,8 @@ int noise_save_certificate_chain_to_file
     (const Noise_CertificateChain *chain, const char *filename)
 {
     return noise_save_to_file
-        (chain, filename, (NoiseWriteFunc)Noise_CertificateChain_write);
+        (chain, filename, (NoiseMeasureFunc)Noise_CertificateChain_measure,
+         (NoiseEncodeFunc)Noise_CertificateChain_encode);
 }
 
 /**
@@ -758,6 +835,7 @@ int noise_save_private_key_to_file
     pbuf.posn = size;
     pbuf.size = size;
     pbuf.error = NOISE_ERROR_NONE;
+    pbuf.arena = 0;
     err = noise_save_private_key_to_buffer
         (key, &pbuf, passphrase, passphrase_len, protect_name);
     if (err == NOISE_ERROR_NONE &&
@@ -882,10 +960,12 @@ int noise_save_private_key_to_buffer
         do {
             /* Generate the key material using PBKDF2 */
             retry = 0;
-            noise_hashstate_pbkdf2
+            err = noise_hashstate_pbkdf2
                 (hash, (const uint8_t *)passphrase, passphrase_len,
                  salt, sizeof(salt), NOISE_KEY_ITERATIONS,
                  key_data, sizeof(key_data));
+            if (err != NOISE_ERROR_NONE)
+                break;
 
             /* Set the encryption key */
             noise_cipherstate_init_key(cipher, key_data, 32);
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#if defined(__WIN32__) || defined(WIN32)
+#define NOISE_USE_MMAP 0
+#else
+#define NOISE_USE_MMAP 1
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ * \file mapfile.c
+ * \brief Maps read-only data files into memory.
+ *
+ * Key stores and revocation sets are designed to be mapped into memory
+ * directly rather than parsed, so that opening a file with millions of
+ * entries is instant and only the pages that are actually used are read.
+ * Platforms without mmap() fall back to reading the whole file.
+ */
+
+/**
+ * \brief Maps the contents of a file into memory.
+ *
+ * \param file The object to fill with the mapped file details.
+ * \param filename The name of the file.
+ * \param min_size The minimum size of the file, usually the size of
+ * its header.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_SYSTEM if the file could not be opened or mapped,
+ * with further information in the system errno variable.
+ * \return NOISE_ERROR_INVALID_FORMAT if the file is smaller than
+ * \a min_size.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory.
+ *
+ * \sa noise_mapped_file_close()
+ */
+int noise_mapped_file_open
+    (NoiseMappedFile *file, const char *filename, size_t min_size)
+{
+#if NOISE_USE_MMAP
+    struct stat st;
+    void *data;
+    int fd;
+    file->data = 0;
+    file->size = 0;
+    fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return NOISE_ERROR_SYSTEM;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return NOISE_ERROR_SYSTEM;
+    }
+    if ((uint64_t)(st.st_size) < (uint64_t)min_size ||
+            (uint64_t)(st.st_size) > (uint64_t)(~((size_t)0))) {
+        close(fd);
+        return NOISE_ERROR_INVALID_FORMAT;
+    }
+    if (!(st.st_size)) {
+        /* Cannot map an empty file, but it is not an error either */
+        close(fd);
+        return NOISE_ERROR_NONE;
+    }
+    data = mmap(0, (size_t)(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return NOISE_ERROR_SYSTEM;
+    file->data = (const uint8_t *)data;
+    file->size = (size_t)(st.st_size);
+    return NOISE_ERROR_NONE;
+#else
+    FILE *fp;
+    uint8_t *data;
+    long length;
+    file->data = 0;
+    file->size = 0;
+    fp = fopen(filename, "rb");
+    if (!fp)
+        return NOISE_ERROR_SYSTEM;
+    if (fseek(fp, 0L, SEEK_END) < 0 || (length = ftell(fp)) < 0 ||
+            fseek(fp, 0L, SEEK_SET) < 0) {
+        fclose(fp);
+        return NOISE_ERROR_SYSTEM;
+    }
+    if ((unsigned long)length < (unsigned long)min_size) {
+        fclose(fp);
+        return NOISE_ERROR_INVALID_FORMAT;
+    }
+    data = (uint8_t *)malloc(length ? (size_t)length : 1);
+    if (!data) {
+        fclose(fp);
+        return NOISE_ERROR_NO_MEMORY;
+    }
+    if (fread(data, 1, (size_t)length, fp) != (size_t)length) {
+        free(data);
+        fclose(fp);
+        return NOISE_ERROR_SYSTEM;
+    }
+    fclose(fp);
+    file->data = data;
+    file->size = (size_t)length;
+    return NOISE_ERROR_NONE;
+#endif
+}
+
+/**
+ * \brief Releases a file that was mapped with noise_mapped_file_open().
+ *
+ * \param file The mapped file details.  May refer to a file that
+ * failed to open, in which case this function does nothing.
+ */
+void noise_mapped_file_close(NoiseMappedFile *file)
+{
+#if NOISE_USE_MMAP
+    if (file->data)
+        munmap((void *)(file->data), file->size);
+#else
+    free((void *)(file->data));
+#endif
+    file->data = 0;
+    file->size = 0;
+}
@@ -0,0 +1,855 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "internal.h"
+#include "crypto/sha2/sha256.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * \file revocation.h
+ * \brief Key revocation set interface
+ */
+
+/**
+ * \file revocation.c
+ * \brief Key revocation set implementation
+ */
+
+/**
+ * \defgroup revocation Key revocation sets
+ *
+ * A revocation set is a list of public keys that must no longer be
+ * accepted, identified by their full SHA-256 fingerprint as reported by
+ * noise_format_fingerprint() with NOISE_FINGERPRINT_FULL.  Revocation sets
+ * are built offline with a NoiseRevocationBuilder or the
+ * "noise-keytool revoke" command and then memory-mapped with
+ * noise_revocation_open().
+ *
+ * The file starts with a Bloom filter over the fingerprints, followed by
+ * the fingerprints themselves in sorted order.  Checking a key that is
+ * not revoked almost always touches only the Bloom filter, which is
+ * about 2 to 4 bytes per revoked key.  Only keys that pass the filter
+ * need a binary search of the exact list, so false positives in the
+ * filter can never cause a valid key to be rejected.
+ *
+ * To check remote static keys during a handshake, call
+ * noise_revocation_attach() before the handshake starts.  The key is
+ * then checked as soon as the "s" token is decrypted and
+ * noise_handshakestate_read_message() fails with NOISE_ERROR_KEY_REVOKED
+ * if the key has been revoked.
+ *
+ * The file format is as follows, with all integers in little-endian
+ * byte order:
+ *
+ * \li 64-byte header: the magic number "NoiseRV1", a 32-bit version
+ * number (1), the 32-bit number of Bloom filter hash functions, the
+ * 64-bit number of bits in the Bloom filter (a power of two, 64 or more),
+ * the 64-bit number of fingerprints, and 32 reserved bytes.
+ * \li The Bloom filter bits.
+ * \li The 32-byte fingerprints in ascending order with no duplicates.
+ */
+/**@{*/
+
+/**
+ * \typedef NoiseRevocationSet
+ * \brief Opaque object that represents a memory-mapped revocation set.
+ */
+
+/**
+ * \typedef NoiseRevocationBuilder
+ * \brief Opaque object that is used to build a new revocation set file.
+ */
+
+/**
+ * \def NOISE_REVOCATION_FINGERPRINT_LEN
+ * \brief Length of the key fingerprints in a revocation set.
+ */
+
+/** @cond */
+
+#define NOISE_REVOCATION_MAGIC          "NoiseRV1"
+#define NOISE_REVOCATION_VERSION        1
+#define NOISE_REVOCATION_HEADER_SIZE    64
+#define NOISE_REVOCATION_MAX_HASHES     32
+#define NOISE_REVOCATION_NUM_HASHES     11
+#define NOISE_REVOCATION_BITS_PER_KEY   16
+#define NOISE_REVOCATION_MIN_BITS       512
+
+#if defined(__ATOMIC_ACQUIRE) && defined(__ATOMIC_RELEASE)
+#define NOISE_REVOCATION_HAVE_ATOMICS 1
+#endif
+
+/** @endcond */
+
+/**
+ * \brief Internal structure of the NoiseRevocationSet type.
+ */
+struct NoiseRevocationSet_s
+{
+    /** \brief Number of references to this revocation set */
+    uint32_t refs;
+
+    /** \brief The revocation set file, mapped into memory */
+    NoiseMappedFile file;
+
+    /** \brief Number of hash functions for the Bloom filter */
+    unsigned num_hashes;
+
+    /** \brief Mask to convert a hash value into a Bloom filter bit number */
+    uint64_t bit_mask;
+
+    /** \brief Points to the Bloom filter */
+    const uint8_t *filter;
+
+    /** \brief Points to the sorted fingerprints */
+    const uint8_t *fingerprints;
+
+    /** \brief Number of fingerprints */
+    size_t count;
+};
+
+/**
+ * \brief Internal structure of the NoiseRevocationBuilder type.
+ */
+struct NoiseRevocationBuilder_s
+{
+    /** \brief Fingerprints that have been added so far */
+    uint8_t *fingerprints;
+
+    /** \brief Number of fingerprints that have been added */
+    size_t count;
+
+    /** \brief Maximum number of fingerprints before resizing */
+    size_t max_count;
+};
+
+/**
+ * \brief Reads a little-endian 32-bit value.
+ */
+static uint32_t noise_revocation_get_le32(const uint8_t *data)
+{
+    return ((uint32_t)(data[0])) |
+           (((uint32_t)(data[1])) << 8) |
+           (((uint32_t)(data[2])) << 16) |
+           (((uint32_t)(data[3])) << 24);
+}
+
+/**
+ * \brief Reads a little-endian 64-bit value.
+ */
+static uint64_t noise_revocation_get_le64(const uint8_t *data)
+{
+    return ((uint64_t)noise_revocation_get_le32(data)) |
+           (((uint64_t)noise_revocation_get_le32(data + 4)) << 32);
+}
+
+/**
+ * \brief Writes a little-endian 32-bit value.
+ */
+static void noise_revocation_put_le32(uint8_t *data, uint32_t value)
+{
+    data[0] = (uint8_t)value;
+    data[1] = (uint8_t)(value >> 8);
+    data[2] = (uint8_t)(value >> 16);
+    data[3] = (uint8_t)(value >> 24);
+}
+
+/**
+ * \brief Writes a little-endian 64-bit value.
+ */
+static void noise_revocation_put_le64(uint8_t *data, uint64_t value)
+{
+    noise_revocation_put_le32(data, (uint32_t)value);
+    noise_revocation_put_le32(data + 4, (uint32_t)(value >> 32));
+}
+
+/**
+ * \brief Computes the Bloom filter bit numbers for a fingerprint.
+ *
+ * \param fingerprint The fingerprint, which is already uniformly
+ * distributed because it is the output of SHA-256.
+ * \param h1 Returns the first bit number.
+ * \param h2 Returns the step between successive bit numbers.
+ *
+ * The bit numbers are h1, h1 + h2, h1 + 2 * h2, and so on, modulo the
+ * size of the filter.  This double hashing approach performs as well
+ * as independent hash functions for Bloom filters.
+ */
+static void noise_revocation_bloom_hashes
+    (const uint8_t *fingerprint, uint64_t *h1, uint64_t *h2)
+{
+    *h1 = noise_revocation_get_le64(fingerprint);
+    *h2 = noise_revocation_get_le64(fingerprint + 8) | 1;
+}
+
+/**
+ * \brief Computes the fingerprint of a public key.
+ *
+ * \param key Points to the public key.
+ * \param key_len The length of the public key in bytes.
+ * \param fingerprint Returns the fingerprint.
+ *
+ * The fingerprint is the SHA256 hash of the key.  The hash is computed
+ * on the stack because this is called for every revocation check, using
+ * the Intel SHA extensions if the CPU has them.
+ */
+static void noise_revocation_fingerprint
+    (const uint8_t *key, size_t key_len,
+     uint8_t fingerprint[NOISE_REVOCATION_FINGERPRINT_LEN])
+{
+    sha256_context_t context;
+#if SHA256_HAVE_SHANI
+    const int shani = NOISE_CPU_SHANI | NOISE_CPU_SSE41;
+    if ((noise_backend_get_cpu_features() & shani) == shani) {
+        sha256_reset(&context);
+        sha256_update_shani(&context, key, key_len);
+        sha256_finish_shani(&context, fingerprint);
+        return;
+    }
+#endif
+    sha256_reset(&context);
+    sha256_update(&context, key, key_len);
+    sha256_finish(&context, fingerprint);
+}
+
+/**
+ * \brief Opens a revocation set file.
+ *
+ * \param set Points to the variable where to store the pointer to
+ * the new NoiseRevocationSet object.
+ * \param filename The name of the revocation set file to open.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a set or \a filename is NULL.
+ * \return NOISE_ERROR_SYSTEM if the file could not be opened or mapped
+ * into memory, with further information in the system errno variable.
+ * \return NOISE_ERROR_INVALID_FORMAT if the file is not a valid
+ * revocation set.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory to
+ * allocate the new object.
+ *
+ * The new object has a single reference, which is released by
+ * noise_revocation_close().
+ *
+ * \sa noise_revocation_close(), noise_revocation_check_key()
+ */
+int noise_revocation_open(NoiseRevocationSet **set, const char *filename)
+{
+    const uint8_t *header;
+    uint64_t num_bits, count;
+    int err;
+
+    /* Validate the parameters */
+    if (!set)
+        return NOISE_ERROR_INVALID_PARAM;
+    *set = 0;
+    if (!filename)
+        return NOISE_ERROR_INVALID_PARAM;
+
+    /* Allocate the object and map the file into memory */
+    *set = (NoiseRevocationSet *)calloc(1, sizeof(NoiseRevocationSet));
+    if (!(*set))
+        return NOISE_ERROR_NO_MEMORY;
+    (*set)->refs = 1;
+    err = noise_mapped_file_open
+        (&((*set)->file), filename, NOISE_REVOCATION_HEADER_SIZE);
+
+    /* Validate the header against the size of the file */
+    if (err == NOISE_ERROR_NONE) {
+        header = (*set)->file.data;
+        (*set)->num_hashes = noise_revocation_get_le32(header + 12);
+        num_bits = noise_revocation_get_le64(header + 16);
+        count = noise_revocation_get_le64(header + 24);
+        if (memcmp(header, NOISE_REVOCATION_MAGIC, 8) != 0 ||
+                noise_revocation_get_le32(header + 8) !=
+                    NOISE_REVOCATION_VERSION ||
+                !((*set)->num_hashes) ||
+                (*set)->num_hashes > NOISE_REVOCATION_MAX_HASHES ||
+                num_bits < 64 || (num_bits & (num_bits - 1)) != 0 ||
+                (num_bits / 8) > (*set)->file.size ||
+                count > ((*set)->file.size /
+                            NOISE_REVOCATION_FINGERPRINT_LEN) ||
+                (NOISE_REVOCATION_HEADER_SIZE + num_bits / 8 +
+                    count * NOISE_REVOCATION_FINGERPRINT_LEN) !=
+                        (uint64_t)((*set)->file.size)) {
+            err = NOISE_ERROR_INVALID_FORMAT;
+        } else {
+            (*set)->bit_mask = num_bits - 1;
+            (*set)->filter = header + NOISE_REVOCATION_HEADER_SIZE;
+            (*set)->fingerprints = (*set)->filter + (size_t)(num_bits / 8);
+            (*set)->count = (size_t)count;
+        }
+    }
+    if (err != NOISE_ERROR_NONE) {
+        noise_mapped_file_close(&((*set)->file));
+        free(*set);
+        *set = 0;
+    }
+    return err;
+}
+
+/**
+ * \brief Adds a reference to a revocation set.
+ *
+ * \param set The NoiseRevocationSet object.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a set is NULL.
+ *
+ * Each call to this function must be matched by a call to
+ * noise_revocation_close().
+ */
+int noise_revocation_ref(NoiseRevocationSet *set)
+{
+    if (!set)
+        return NOISE_ERROR_INVALID_PARAM;
+#if NOISE_REVOCATION_HAVE_ATOMICS
+    __atomic_add_fetch(&(set->refs), 1, __ATOMIC_RELAXED);
+#else
+    ++(set->refs);
+#endif
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Releases a reference to a revocation set.
+ *
+ * \param set The NoiseRevocationSet object.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a set is NULL.
+ *
+ * When the last reference is released, the revocation set is unmapped
+ * from memory.
+ *
+ * \sa noise_revocation_open(), noise_revocation_ref()
+ */
+int noise_revocation_close(NoiseRevocationSet *set)
+{
+    uint32_t refs;
+    if (!set)
+        return NOISE_ERROR_INVALID_PARAM;
+#if NOISE_REVOCATION_HAVE_ATOMICS
+    refs = __atomic_sub_fetch(&(set->refs), 1, __ATOMIC_ACQ_REL);
+#else
+    refs = --(set->refs);
+#endif
+    if (!refs) {
+        noise_mapped_file_close(&(set->file));
+        free(set);
+    }
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Gets the number of revoked keys in a revocation set.
+ *
+ * \param set The NoiseRevocationSet object.
+ *
+ * \return The number of revoked keys, or zero if \a set is NULL.
+ */
+size_t noise_revocation_get_count(const NoiseRevocationSet *set)
+{
+    return set ? set->count : 0;
+}
+
+/**
+ * \brief Checks if a key fingerprint has been revoked.
+ *
+ * \param set The NoiseRevocationSet object.
+ * \param fingerprint Points to the full SHA-256 fingerprint of the key.
+ * \param fingerprint_len The length of the fingerprint, which must be
+ * NOISE_REVOCATION_FINGERPRINT_LEN.
+ *
+ * \return NOISE_ERROR_NONE if the key has not been revoked.
+ * \return NOISE_ERROR_KEY_REVOKED if the key has been revoked.
+ * \return NOISE_ERROR_INVALID_PARAM if \a set or \a fingerprint is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if \a fingerprint_len is incorrect.
+ *
+ * \sa noise_revocation_check_key()
+ */
+int noise_revocation_check_fingerprint
+    (const NoiseRevocationSet *set, const uint8_t *fingerprint,
+     size_t fingerprint_len)
+{
+    uint64_t h1, h2, bit;
+    size_t low, high, mid;
+    unsigned index;
+    int cmp;
+
+    /* Validate the parameters */
+    if (!set || !fingerprint)
+        return NOISE_ERROR_INVALID_PARAM;
+    if (fingerprint_len != NOISE_REVOCATION_FINGERPRINT_LEN)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* Check the Bloom filter first, which rules out almost all keys */
+    noise_revocation_bloom_hashes(fingerprint, &h1, &h2);
+    for (index = 0; index < set->num_hashes; ++index) {
+        bit = (h1 + h2 * index) & set->bit_mask;
+        if (!(set->filter[bit / 8] & (1 << (bit % 8))))
+            return NOISE_ERROR_NONE;
+    }
+
+    /* Possible match, so search the exact list of fingerprints */
+    low = 0;
+    high = set->count;
+    while (low < high) {
+        mid = low + (high - low) / 2;
+        cmp = memcmp(set->fingerprints +
+                        mid * NOISE_REVOCATION_FINGERPRINT_LEN,
+                     fingerprint, NOISE_REVOCATION_FINGERPRINT_LEN);
+        if (cmp == 0)
+            return NOISE_ERROR_KEY_REVOKED;
+        else if (cmp < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Checks if a public key has been revoked.
+ *
+ * \param set The NoiseRevocationSet object.
+ * \param key Points to the public key.
+ * \param key_len The length of the public key in bytes.
+ *
+ * \return NOISE_ERROR_NONE if the key has not been revoked.
+ * \return NOISE_ERROR_KEY_REVOKED if the key has been revoked.
+ * \return NOISE_ERROR_INVALID_PARAM if \a set or \a key is NULL.
+ *
+ * \sa noise_revocation_check_fingerprint(), noise_revocation_check_dhstate()
+ */
+int noise_revocation_check_key
+    (const NoiseRevocationSet *set, const uint8_t *key, size_t key_len)
+{
+    uint8_t fingerprint[NOISE_REVOCATION_FINGERPRINT_LEN];
+    if (!set || !key)
+        return NOISE_ERROR_INVALID_PARAM;
+    if (!(set->count))
+        return NOISE_ERROR_NONE;
+    noise_revocation_fingerprint(key, key_len, fingerprint);
+    return noise_revocation_check_fingerprint
+        (set, fingerprint, sizeof(fingerprint));
+}
+
+/**
+ * \brief Checks if the public key in a DHState object has been revoked.
+ *
+ * \param set The NoiseRevocationSet object.
+ * \param dh The DHState object.
+ *
+ * \return NOISE_ERROR_NONE if the key has not been revoked.
+ * \return NOISE_ERROR_KEY_REVOKED if the key has been revoked.
+ * \return NOISE_ERROR_INVALID_PARAM if \a set or \a dh is NULL.
+ * \return NOISE_ERROR_INVALID_STATE if \a dh does not have a public key.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory.
+ *
+ * \sa noise_revocation_attach()
+ */
+int noise_revocation_check_dhstate
+    (const NoiseRevocationSet *set, const NoiseDHState *dh)
+{
+    uint8_t *key;
+    size_t key_len;
+    int err;
+    if (!set || !dh)
+        return NOISE_ERROR_INVALID_PARAM;
+    if (!noise_dhstate_has_public_key(dh))
+        return NOISE_ERROR_INVALID_STATE;
+    if (!(set->count))
+        return NOISE_ERROR_NONE;
+    key_len = noise_dhstate_get_public_key_length(dh);
+    key = (uint8_t *)malloc(key_len);
+    if (!key)
+        return NOISE_ERROR_NO_MEMORY;
+    err = noise_dhstate_get_public_key(dh, key, key_len);
+    if (err == NOISE_ERROR_NONE)
+        err = noise_revocation_check_key(set, key, key_len);
+    free(key);
+    return err;
+}
+
+/**
+ * \brief Checks if a PublicKeyInfo block refers to a revoked key.
+ *
+ * \param set The NoiseRevocationSet object.
+ * \param info The PublicKeyInfo block, or NULL.
+ *
+ * \return NOISE_ERROR_NONE or NOISE_ERROR_KEY_REVOKED.
+ */
+static int noise_revocation_check_key_info
+    (const NoiseRevocationSet *set, const Noise_PublicKeyInfo *info)
+{
+    if (!info || !Noise_PublicKeyInfo_has_key(info))
+        return NOISE_ERROR_NONE;
+    return noise_revocation_check_key
+        (set, (const uint8_t *)Noise_PublicKeyInfo_get_key(info),
+         Noise_PublicKeyInfo_get_size_key(info));
+}
+
+/**
+ * \brief Checks if a certificate refers to any revoked keys.
+ *
+ * \param set The NoiseRevocationSet object.
+ * \param cert The certificate to check.
+ *
+ * \return NOISE_ERROR_NONE if none of the keys have been revoked.
+ * \return NOISE_ERROR_KEY_REVOKED if the certificate contains a revoked
+ * subject key or was signed by a revoked key.
+ * \return NOISE_ERROR_INVALID_PARAM if \a set or \a cert is NULL.
+ *
+ * This function does not verify the signatures on the certificate.
+ *
+ * \sa noise_revocation_check_chain(), noise_cert_verifier_verify_chain()
+ */
+int noise_revocation_check_certificate
+    (const NoiseRevocationSet *set, const Noise_Certificate *cert)
+{
+    const Noise_SubjectInfo *subject;
+    size_t count, index;
+    int err;
+
+    /* Validate the parameters */
+    if (!set || !cert)
+        return NOISE_ERROR_INVALID_PARAM;
+
+    /* Check the subject's keys */
+    subject = Noise_Certificate_get_subject(cert);
+    if (subject) {
+        count = Noise_SubjectInfo_count_keys(subject);
+        for (index = 0; index < count; ++index) {
+            err = noise_revocation_check_key_info
+                (set, Noise_SubjectInfo_get_at_keys(subject, index));
+            if (err != NOISE_ERROR_NONE)
+                return err;
+        }
+    }
+
+    /* Check the keys that signed the certificate */
+    count = Noise_Certificate_count_signatures(cert);
+    for (index = 0; index < count; ++index) {
+        const Noise_Signature *sig =
+            Noise_Certificate_get_at_signatures(cert, index);
+        err = noise_revocation_check_key_info
+            (set, Noise_Signature_get_signing_key(sig));
+        if (err != NOISE_ERROR_NONE)
+            return err;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Checks if any certificate in a chain refers to revoked keys.
+ *
+ * \param set The NoiseRevocationSet object.
+ * \param chain The certificate chain to check.
+ *
+ * \return NOISE_ERROR_NONE if none of the keys have been revoked.
+ * \return NOISE_ERROR_KEY_REVOKED if any certificate in the chain
+ * contains a revoked subject key or was signed by a revoked key.
+ * \return NOISE_ERROR_INVALID_PARAM if \a set or \a chain is NULL.
+ *
+ * \sa noise_revocation_check_certificate()
+ */
+int noise_revocation_check_chain
+    (const NoiseRevocationSet *set, const Noise_CertificateChain *chain)
+{
+    size_t count, index;
+    int err;
+    if (!set || !chain)
+        return NOISE_ERROR_INVALID_PARAM;
+    count = Noise_CertificateChain_count_certs(chain);
+    for (index = 0; index < count; ++index) {
+        err = noise_revocation_check_certificate
+            (set, Noise_CertificateChain_get_at_certs(chain, index));
+        if (err != NOISE_ERROR_NONE)
+            return err;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Remote static key callback for noise_revocation_attach().
+ */
+static int noise_revocation_handshake_check
+    (void *user_data, const NoiseDHState *dh)
+{
+    return noise_revocation_check_dhstate
+        ((const NoiseRevocationSet *)user_data, dh);
+}
+
+/**
+ * \brief Attaches a revocation set to a HandshakeState so that the
+ * remote static key is checked as soon as it is received.
+ *
+ * \param set The NoiseRevocationSet object, or NULL to detach.
+ * \param state The HandshakeState object.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a state is NULL.
+ *
+ * The revocation set does not gain a reference.  The caller must keep
+ * \a set open until the handshake has finished.
+ *
+ * \sa noise_handshakestate_set_remote_static_check()
+ */
+int noise_revocation_attach
+    (NoiseRevocationSet *set, NoiseHandshakeState *state)
+{
+    if (!state)
+        return NOISE_ERROR_INVALID_PARAM;
+    return noise_handshakestate_set_remote_static_check
+        (state, set ? noise_revocation_handshake_check : 0, set);
+}
+
+/**
+ * \brief Creates a new revocation set builder.
+ *
+ * \param builder Points to the variable where to store the pointer to
+ * the new NoiseRevocationBuilder object.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a builder is NULL.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory to
+ * allocate the new object.
+ *
+ * \sa noise_revocation_builder_add_key(), noise_revocation_builder_save()
+ */
+int noise_revocation_builder_new(NoiseRevocationBuilder **builder)
+{
+    if (!builder)
+        return NOISE_ERROR_INVALID_PARAM;
+    *builder = (NoiseRevocationBuilder *)
+        calloc(1, sizeof(NoiseRevocationBuilder));
+    return *builder ? NOISE_ERROR_NONE : NOISE_ERROR_NO_MEMORY;
+}
+
+/**
+ * \brief Frees a revocation set builder.
+ *
+ * \param builder The NoiseRevocationBuilder object.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a builder is NULL.
+ */
+int noise_revocation_builder_free(NoiseRevocationBuilder *builder)
+{
+    if (!builder)
+        return NOISE_ERROR_INVALID_PARAM;
+    free(builder->fingerprints);
+    free(builder);
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Adds a key fingerprint to a revocation set builder.
+ *
+ * \param builder The NoiseRevocationBuilder object.
+ * \param fingerprint Points to the full SHA-256 fingerprint of the key.
+ * \param fingerprint_len The length of the fingerprint, which must be
+ * NOISE_REVOCATION_FINGERPRINT_LEN.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a builder or \a fingerprint is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if \a fingerprint_len is incorrect.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory.
+ *
+ * Adding the same fingerprint more than once is harmless.
+ */
+int noise_revocation_builder_add_fingerprint
+    (NoiseRevocationBuilder *builder, const uint8_t *fingerprint,
+     size_t fingerprint_len)
+{
+    if (!builder || !fingerprint)
+        return NOISE_ERROR_INVALID_PARAM;
+    if (fingerprint_len != NOISE_REVOCATION_FINGERPRINT_LEN)
+        return NOISE_ERROR_INVALID_LENGTH;
+    if (builder->count >= builder->max_count) {
+        size_t new_max = builder->max_count ? builder->max_count * 2 : 256;
+        uint8_t *new_fingerprints = (uint8_t *)realloc
+            (builder->fingerprints,
+             new_max * NOISE_REVOCATION_FINGERPRINT_LEN);
+        if (!new_fingerprints)
+            return NOISE_ERROR_NO_MEMORY;
+        builder->fingerprints = new_fingerprints;
+        builder->max_count = new_max;
+    }
+    memcpy(builder->fingerprints +
+                builder->count * NOISE_REVOCATION_FINGERPRINT_LEN,
+           fingerprint, NOISE_REVOCATION_FINGERPRINT_LEN);
+    ++(builder->count);
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Adds a public key to a revocation set builder.
+ *
+ * \param builder The NoiseRevocationBuilder object.
+ * \param key Points to the public key to revoke.
+ * \param key_len The length of the public key in bytes.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a builder or \a key is NULL.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory.
+ *
+ * \sa noise_revocation_builder_add_fingerprint()
+ */
+int noise_revocation_builder_add_key
+    (NoiseRevocationBuilder *builder, const uint8_t *key, size_t key_len)
+{
+    uint8_t fingerprint[NOISE_REVOCATION_FINGERPRINT_LEN];
+    if (!builder || !key)
+        return NOISE_ERROR_INVALID_PARAM;
+    noise_revocation_fingerprint(key, key_len, fingerprint);
+    return noise_revocation_builder_add_fingerprint
+        (builder, fingerprint, sizeof(fingerprint));
+}
+
+/**
+ * \brief Compares two fingerprints for qsort().
+ */
+static int noise_revocation_compare(const void *a, const void *b)
+{
+    return memcmp(a, b, NOISE_REVOCATION_FINGERPRINT_LEN);
+}
+
+/**
+ * \brief Saves the contents of a revocation set builder to a file.
+ *
+ * \param builder The NoiseRevocationBuilder object.
+ * \param filename The name of the revocation set file to save to.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a builder or \a filename is NULL.
+ * \return NOISE_ERROR_SYSTEM if there was a problem writing the file,
+ * with further information in the system errno variable.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory to
+ * build the Bloom filter.
+ *
+ * The data is written to a temporary file called "filename.tmp" which is
+ * then renamed to \a filename, so that servers never see a partial file.
+ */
+int noise_revocation_builder_save
+    (NoiseRevocationBuilder *builder, const char *filename)
+{
+    uint8_t header[NOISE_REVOCATION_HEADER_SIZE];
+    uint8_t *filter;
+    uint8_t *fp;
+    uint64_t num_bits, h1, h2, bit;
+    size_t count, index;
+    unsigned hash;
+    char *temp_name;
+    FILE *file;
+    int err = NOISE_ERROR_NONE;
+
+    /* Validate the parameters */
+    if (!builder || !filename)
+        return NOISE_ERROR_INVALID_PARAM;
+
+    /* Sort the fingerprints and remove duplicates */
+    count = builder->count;
+    if (count > 1) {
+        qsort(builder->fingerprints, count, NOISE_REVOCATION_FINGERPRINT_LEN,
+              noise_revocation_compare);
+        count = 1;
+        for (index = 1; index < builder->count; ++index) {
+            fp = builder->fingerprints +
+                 index * NOISE_REVOCATION_FINGERPRINT_LEN;
+            if (memcmp(fp - NOISE_REVOCATION_FINGERPRINT_LEN, fp,
+                       NOISE_REVOCATION_FINGERPRINT_LEN) == 0)
+                continue;
+            memmove(builder->fingerprints +
+                        count * NOISE_REVOCATION_FINGERPRINT_LEN,
+                    fp, NOISE_REVOCATION_FINGERPRINT_LEN);
+            ++count;
+        }
+        builder->count = count;
+    }
+
+    /* Build the Bloom filter */
+    num_bits = NOISE_REVOCATION_MIN_BITS;
+    while (num_bits < ((uint64_t)count) * NOISE_REVOCATION_BITS_PER_KEY)
+        num_bits *= 2;
+    filter = (uint8_t *)calloc(1, (size_t)(num_bits / 8));
+    if (!filter)
+        return NOISE_ERROR_NO_MEMORY;
+    for (index = 0; index < count; ++index) {
+        noise_revocation_bloom_hashes
+            (builder->fingerprints + index * NOISE_REVOCATION_FINGERPRINT_LEN,
+             &h1, &h2);
+        for (hash = 0; hash < NOISE_REVOCATION_NUM_HASHES; ++hash) {
+            bit = (h1 + h2 * hash) & (num_bits - 1);
+            filter[bit / 8] |= (uint8_t)(1 << (bit % 8));
+        }
+    }
+
+    /* Format the header */
+    memset(header, 0, sizeof(header));
+    memcpy(header, NOISE_REVOCATION_MAGIC, 8);
+    noise_revocation_put_le32(header + 8, NOISE_REVOCATION_VERSION);
+    noise_revocation_put_le32(header + 12, NOISE_REVOCATION_NUM_HASHES);
+    noise_revocation_put_le64(header + 16, num_bits);
+    noise_revocation_put_le64(header + 24, count);
+
+    /* Write everything to a temporary file and then rename it */
+    temp_name = (char *)malloc(strlen(filename) + 5);
+    if (!temp_name) {
+        free(filter);
+        return NOISE_ERROR_NO_MEMORY;
+    }
+    strcpy(temp_name, filename);
+    strcat(temp_name, ".tmp");
+    file = fopen(temp_name, "wb");
+    if (!file) {
+        err = NOISE_ERROR_SYSTEM;
+    } else {
+        if (fwrite(header, 1, sizeof(header), file) != sizeof(header) ||
+                fwrite(filter, 1, (size_t)(num_bits / 8), file) !=
+                    (size_t)(num_bits / 8) ||
+                (count && fwrite(builder->fingerprints,
+                                 NOISE_REVOCATION_FINGERPRINT_LEN, count,
+                                 file) != count))
+            err = NOISE_ERROR_SYSTEM;
+        if (fclose(file) != 0)
+            err = NOISE_ERROR_SYSTEM;
+#if defined(__WIN32__) || defined(WIN32)
+        if (err == NOISE_ERROR_NONE)
+            remove(filename);
+#endif
+        if (err == NOISE_ERROR_NONE && rename(temp_name, filename) != 0)
+            err = NOISE_ERROR_SYSTEM;
+        if (err != NOISE_ERROR_NONE)
+            remove(temp_name);
+    }
+
+    /* Clean up and exit */
+    free(temp_name);
+    free(filter);
+    return err;
+}
+
+/**@}*/
@@ -0,0 +1,1065 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <noise/keys.h>
+#include <noise/protocol.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * \file verifier.h
+ * \brief Certificate verification interface
+ */
+
+/**
+ * \file verifier.c
+ * \brief Certificate verification implementation
+ */
+
+/**
+ * \defgroup certverifier Certificate verification API
+ *
+ * A NoiseCertVerifier holds a set of trust anchors, which are the public
+ * signing keys that the application trusts directly.  A certificate is
+ * trusted if it carries a valid signature from a trust anchor.  A chain
+ * is trusted if its first certificate is trusted, either directly or via
+ * a valid signature from a subject key of another certificate in the
+ * chain that is itself trusted.
+ *
+ * All of the relevant signatures in a chain are checked together with
+ * noise_signstate_verify_batch().  Signatures that have been verified
+ * before are remembered in a bounded cache so that repeated chains from
+ * the same issuers only cost a hash computation and a cache lookup.
+ *
+ * The cache is lock-free: each slot is protected by a sequence counter
+ * that readers check before and after copying the slot, and writers claim
+ * a slot with an atomic compare-and-swap.  Once the trust anchors have
+ * been added, several threads can verify certificates against the same
+ * NoiseCertVerifier at the same time.  The cache is disabled if the
+ * compiler does not provide GNU-style atomic builtins.
+ *
+ * The verifier only checks signatures.  The "valid_from" and "valid_to"
+ * times in the extra signed information are left to the application.
+ */
+/**@{*/
+
+/**
+ * \typedef NoiseCertVerifier
+ * \brief Opaque object that represents a certificate verifier.
+ */
+
+/** @cond */
+
+/**
+ * \brief Maximum length of a hash value for a signature.
+ */
+#define NOISE_CERT_MAX_HASH_LEN     64
+
+/**
+ * \brief Number of 32-bit words in a cache tag.
+ */
+#define NOISE_CERT_TAG_WORDS        8
+
+/**
+ * \brief Maximum number of slots in the verified signature cache.
+ */
+#define NOISE_CERT_MAX_CACHE_SIZE   (1U << 24)
+
+#if defined(__ATOMIC_ACQUIRE) && defined(__ATOMIC_RELEASE)
+#define NOISE_CERT_HAVE_ATOMICS 1
+#define noise_cert_load_acquire(ptr)  __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define noise_cert_load_relaxed(ptr)  __atomic_load_n((ptr), __ATOMIC_RELAXED)
+#define noise_cert_store_release(ptr, value) \
+    __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+#define noise_cert_store_relaxed(ptr, value) \
+    __atomic_store_n((ptr), (value), __ATOMIC_RELAXED)
+#define noise_cert_fetch_add(ptr, value) \
+    __atomic_fetch_add((ptr), (value), __ATOMIC_RELAXED)
+#else
+#define NOISE_CERT_HAVE_ATOMICS 0
+#define noise_cert_load_relaxed(ptr)  (*(ptr))
+#define noise_cert_store_relaxed(ptr, value) (*(ptr) = (value))
+#define noise_cert_fetch_add(ptr, value) (*(ptr) += (value))
+#endif
+
+/**
+ * \brief Slot in the verified signature cache.
+ *
+ * The \a seq field is even when the slot is stable and odd while a writer
+ * is updating the \a tag.  A value of zero indicates an empty slot.
+ */
+typedef struct
+{
+    uint32_t seq;
+    uint32_t tag[NOISE_CERT_TAG_WORDS];
+
+} NoiseCertCacheSlot;
+
+/**
+ * \brief Public signing key that is trusted by a verifier.
+ */
+typedef struct
+{
+    int sign_id;
+    size_t key_len;
+    uint8_t *key;
+
+} NoiseCertAnchor;
+
+/**
+ * \brief Signature that needs to be checked while verifying a chain.
+ */
+typedef struct
+{
+    size_t cert;                /**< Index of the signed certificate */
+    const Noise_PublicKeyInfo *signer;  /**< Key that made the signature */
+    int is_anchor;              /**< Non-zero if signed by a trust anchor */
+    NoiseSignState *state;      /**< SignState containing the signer's key */
+    const uint8_t *signature;   /**< The signature to be verified */
+    size_t hash_len;            /**< Length of the signed hash */
+    uint8_t hash[NOISE_CERT_MAX_HASH_LEN];  /**< The signed hash */
+    uint32_t tag[NOISE_CERT_TAG_WORDS];     /**< Cache tag */
+    int valid;                  /**< Non-zero once the signature is valid */
+
+} NoiseCertJob;
+
+/** @endcond */
+
+/**
+ * \brief Internal structure of the NoiseCertVerifier type.
+ */
+struct NoiseCertVerifier_s
+{
+    /** \brief Array of trust anchors */
+    NoiseCertAnchor *anchors;
+
+    /** \brief Number of trust anchors in the array */
+    size_t num_anchors;
+
+    /** \brief Maximum number of trust anchors before the array resizes */
+    size_t max_anchors;
+
+    /** \brief Slots in the verified signature cache, or NULL if disabled */
+    NoiseCertCacheSlot *slots;
+
+    /** \brief Mask to convert a tag into a slot index */
+    size_t slot_mask;
+
+    /** \brief Round-robin counter for choosing cache eviction victims */
+    uint32_t victim;
+
+    /** \brief Number of signatures that were found in the cache */
+    size_t hits;
+
+    /** \brief Number of signatures that had to be verified */
+    size_t misses;
+};
+
+/**
+ * \brief Hashes the contents of the signed information in a certificate.
+ *
+ * \param cert The certificate.
+ * \param sig The signature block within \a cert.
+ * \param hash The return buffer for the hash value.
+ * \param max_len The maximum length of \a hash in bytes.
+ * \param hash_len Returns the actual length of the hash value.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if one of the parameters is NULL.
+ * \return NOISE_ERROR_INVALID_FORMAT if \a cert does not have a subject
+ * or \a sig does not specify a hash algorithm.
+ * \return NOISE_ERROR_UNKNOWN_NAME if the hash algorithm is not supported.
+ * \return NOISE_ERROR_INVALID_LENGTH if \a max_len is not large enough
+ * for the hash value, or the signed information is larger than
+ * NOISE_MAX_PAYLOAD_LEN when serialized.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory to
+ * serialize the signed information.
+ *
+ * The hash covers the canonical protobuf encoding of the contents of the
+ * "subject" field, followed by the contents of the "extra_signed_info"
+ * field from \a sig.  Other signature blocks in \a cert are ignored.
+ * The value that is returned is what the signer should sign with the
+ * "signing_key".
+ *
+ * The \a sig block does not need to have been added to \a cert yet,
+ * which allows the same function to be used when signing a certificate.
+ * Neither \a cert nor \a sig is modified, so the same objects may be
+ * hashed by several threads at once.
+ */
+int noise_certificate_compute_signed_hash
+    (const Noise_Certificate *cert, const Noise_Signature *sig,
+     uint8_t *hash, size_t max_len, size_t *hash_len)
+{
+    const Noise_SubjectInfo *subject;
+    const Noise_ExtraSignedInfo *extra;
+    NoiseHashState *state;
+    NoiseProtobuf pbuf;
+    uint8_t *data;
+    uint8_t *output;
+    size_t size;
+    int hash_id;
+    int err;
+
+    /* Validate the parameters */
+    if (hash_len)
+        *hash_len = 0;
+    if (!cert || !sig || !hash || !hash_len)
+        return NOISE_ERROR_INVALID_PARAM;
+    subject = Noise_Certificate_get_subject(cert);
+    extra = Noise_Signature_get_extra_signed_info(sig);
+    if (!subject || !Noise_Signature_has_hash_algorithm(sig))
+        return NOISE_ERROR_INVALID_FORMAT;
+
+    /* Create the hash object */
+    hash_id = noise_name_to_id
+        (NOISE_HASH_CATEGORY, Noise_Signature_get_hash_algorithm(sig),
+         Noise_Signature_get_size_hash_algorithm(sig));
+    if (!hash_id)
+        return NOISE_ERROR_UNKNOWN_NAME;
+    err = noise_hashstate_new_by_id(&state, hash_id);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_hashstate_get_hash_length(state) > max_len) {
+        noise_hashstate_free(state);
+        return NOISE_ERROR_INVALID_LENGTH;
+    }
+
+    /* Serialize the signed information into a temporary buffer.  This
+       uses the reverse writer because the measure functions for the
+       single-pass encoder cache the field sizes in the objects, which
+       are owned by the caller and may be shared with other threads */
+    noise_protobuf_prepare_measure(&pbuf, NOISE_MAX_PAYLOAD_LEN);
+    if (extra)
+        Noise_ExtraSignedInfo_write(&pbuf, 0, extra);
+    Noise_SubjectInfo_write(&pbuf, 0, subject);
+    err = noise_protobuf_finish_measure(&pbuf, &size);
+    if (err != NOISE_ERROR_NONE) {
+        noise_hashstate_free(state);
+        return err;
+    }
+    data = (uint8_t *)malloc(size + 1);
+    if (!data) {
+        noise_hashstate_free(state);
+        return NOISE_ERROR_NO_MEMORY;
+    }
+    noise_protobuf_prepare_output(&pbuf, data, size);
+    if (extra)
+        Noise_ExtraSignedInfo_write(&pbuf, 0, extra);
+    Noise_SubjectInfo_write(&pbuf, 0, subject);
+    err = noise_protobuf_finish_output(&pbuf, &output, &size);
+
+    /* Hash the serialized data */
+    if (err == NOISE_ERROR_NONE) {
+        *hash_len = noise_hashstate_get_hash_length(state);
+        err = noise_hashstate_hash_one(state, output, size, hash, *hash_len);
+    }
+
+    /* Clean up */
+    free(data);
+    noise_hashstate_free(state);
+    return err;
+}
+
+/**
+ * \brief Creates a new certificate verifier.
+ *
+ * \param verifier Points to the variable where to store the pointer to
+ * the new NoiseCertVerifier object.
+ * \param cache_size The number of verified signatures to remember,
+ * or zero to disable the cache.  The size is rounded up to the next
+ * power of two.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a verifier is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if \a cache_size is too large.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory to
+ * allocate the new object.
+ *
+ * The new verifier does not trust any keys until
+ * noise_cert_verifier_add_trust_anchor() or
+ * noise_cert_verifier_add_trusted_certificate() is called.
+ *
+ * \sa noise_cert_verifier_free()
+ */
+int noise_cert_verifier_new(NoiseCertVerifier **verifier, size_t cache_size)
+{
+    size_t num_slots;
+
+    /* Validate the parameters */
+    if (!verifier)
+        return NOISE_ERROR_INVALID_PARAM;
+    *verifier = 0;
+    if (cache_size > NOISE_CERT_MAX_CACHE_SIZE)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* Allocate the verifier */
+    *verifier = (NoiseCertVerifier *)calloc(1, sizeof(NoiseCertVerifier));
+    if (!(*verifier))
+        return NOISE_ERROR_NO_MEMORY;
+
+    /* Allocate the cache.  Each tag has two candidate slots next to
+       each other, so there must be at least two slots */
+    if (NOISE_CERT_HAVE_ATOMICS && cache_size > 0) {
+        num_slots = 2;
+        while (num_slots < cache_size)
+            num_slots <<= 1;
+        (*verifier)->slots = (NoiseCertCacheSlot *)
+            calloc(num_slots, sizeof(NoiseCertCacheSlot));
+        if (!((*verifier)->slots)) {
+            free(*verifier);
+            *verifier = 0;
+            return NOISE_ERROR_NO_MEMORY;
+        }
+        (*verifier)->slot_mask = num_slots - 1;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Frees a certificate verifier after destroying its contents.
+ *
+ * \param verifier The NoiseCertVerifier object to free.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a verifier is NULL.
+ *
+ * \sa noise_cert_verifier_new()
+ */
+int noise_cert_verifier_free(NoiseCertVerifier *verifier)
+{
+    size_t index;
+    if (!verifier)
+        return NOISE_ERROR_INVALID_PARAM;
+    for (index = 0; index < verifier->num_anchors; ++index)
+        free(verifier->anchors[index].key);
+    free(verifier->anchors);
+    free(verifier->slots);
+    free(verifier);
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Determine if a public key matches a specific signing key.
+ *
+ * \param key The public key information from a certificate.
+ * \param sign_id The signature algorithm identifier to match.
+ * \param data Points to the public key value to match.
+ * \param len The length of the public key value to match.
+ *
+ * \return Non-zero if the key matches, zero if not.
+ */
+static int noise_cert_key_matches
+    (const Noise_PublicKeyInfo *key, int sign_id,
+     const uint8_t *data, size_t len)
+{
+    if (!key || !Noise_PublicKeyInfo_has_algorithm(key))
+        return 0;
+    if (Noise_PublicKeyInfo_get_size_key(key) != len)
+        return 0;
+    if (memcmp(Noise_PublicKeyInfo_get_key(key), data, len) != 0)
+        return 0;
+    return noise_name_to_id
+        (NOISE_SIGN_CATEGORY, Noise_PublicKeyInfo_get_algorithm(key),
+         Noise_PublicKeyInfo_get_size_algorithm(key)) == sign_id;
+}
+
+/**
+ * \brief Determine if two public keys are the same.
+ *
+ * \param key1 The first key.
+ * \param key2 The second key.
+ *
+ * \return Non-zero if the keys are the same, zero if not.
+ */
+static int noise_cert_keys_equal
+    (const Noise_PublicKeyInfo *key1, const Noise_PublicKeyInfo *key2)
+{
+    size_t len;
+    if (!key1 || !key2)
+        return 0;
+    len = Noise_PublicKeyInfo_get_size_algorithm(key1);
+    if (len != Noise_PublicKeyInfo_get_size_algorithm(key2) ||
+            memcmp(Noise_PublicKeyInfo_get_algorithm(key1),
+                   Noise_PublicKeyInfo_get_algorithm(key2), len) != 0)
+        return 0;
+    len = Noise_PublicKeyInfo_get_size_key(key1);
+    if (len != Noise_PublicKeyInfo_get_size_key(key2) ||
+            memcmp(Noise_PublicKeyInfo_get_key(key1),
+                   Noise_PublicKeyInfo_get_key(key2), len) != 0)
+        return 0;
+    return Noise_PublicKeyInfo_has_algorithm(key1);
+}
+
+/**
+ * \brief Determine if a key is one of the subject keys of a certificate.
+ *
+ * \param cert The certificate.
+ * \param key The key to look for.
+ *
+ * \return Non-zero if \a key is in the subject of \a cert, zero if not.
+ */
+static int noise_cert_has_subject_key
+    (const Noise_Certificate *cert, const Noise_PublicKeyInfo *key)
+{
+    const Noise_SubjectInfo *subject = Noise_Certificate_get_subject(cert);
+    size_t count = Noise_SubjectInfo_count_keys(subject);
+    size_t index;
+    for (index = 0; index < count; ++index) {
+        if (noise_cert_keys_equal
+                (Noise_SubjectInfo_get_at_keys(subject, index), key))
+            return 1;
+    }
+    return 0;
+}
+
+/**
+ * \brief Determine if a key is one of the trust anchors in a verifier.
+ *
+ * \param verifier The certificate verifier.
+ * \param key The key to look for.
+ *
+ * \return Non-zero if \a key is a trust anchor, zero if not.
+ */
+static int noise_cert_is_anchor
+    (const NoiseCertVerifier *verifier, const Noise_PublicKeyInfo *key)
+{
+    const NoiseCertAnchor *anchor;
+    size_t index;
+    for (index = 0; index < verifier->num_anchors; ++index) {
+        anchor = &(verifier->anchors[index]);
+        if (noise_cert_key_matches
+                (key, anchor->sign_id, anchor->key, anchor->key_len))
+            return 1;
+    }
+    return 0;
+}
+
+/**
+ * \brief Adds a trust anchor to a certificate verifier.
+ *
+ * \param verifier The NoiseCertVerifier object.
+ * \param key The public signing key to trust.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a verifier or \a key is NULL.
+ * \return NOISE_ERROR_UNKNOWN_NAME if the algorithm for \a key is not
+ * a supported signature algorithm.
+ * \return NOISE_ERROR_INVALID_LENGTH if the key value has the wrong
+ * length for the algorithm.
+ * \return NOISE_ERROR_INVALID_PUBLIC_KEY if the key value is invalid.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory to
+ * add the key.
+ *
+ * Adding the same key more than once has no further effect.  Trust anchors
+ * must be added before the verifier is shared between threads.
+ *
+ * \sa noise_cert_verifier_add_trusted_certificate()
+ */
+int noise_cert_verifier_add_trust_anchor
+    (NoiseCertVerifier *verifier, const Noise_PublicKeyInfo *key)
+{
+    NoiseSignState *state;
+    NoiseCertAnchor *anchor;
+    size_t key_len;
+    int sign_id;
+    int err;
+
+    /* Validate the parameters */
+    if (!verifier || !key)
+        return NOISE_ERROR_INVALID_PARAM;
+    sign_id = noise_name_to_id
+        (NOISE_SIGN_CATEGORY, Noise_PublicKeyInfo_get_algorithm(key),
+         Noise_PublicKeyInfo_get_size_algorithm(key));
+    if (!sign_id)
+        return NOISE_ERROR_UNKNOWN_NAME;
+    key_len = Noise_PublicKeyInfo_get_size_key(key);
+
+    /* Let the signature algorithm validate the public key */
+    err = noise_signstate_new_by_id(&state, sign_id);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_signstate_set_public_key
+        (state, (const uint8_t *)Noise_PublicKeyInfo_get_key(key), key_len);
+    noise_signstate_free(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_cert_is_anchor(verifier, key))
+        return NOISE_ERROR_NONE;
+
+    /* Add the key to the array of anchors */
+    if (verifier->num_anchors >= verifier->max_anchors) {
+        size_t new_max = verifier->max_anchors ? verifier->max_anchors * 2 : 8;
+        NoiseCertAnchor *new_anchors = (NoiseCertAnchor *)realloc
+            (verifier->anchors, new_max * sizeof(NoiseCertAnchor));
+        if (!new_anchors)
+            return NOISE_ERROR_NO_MEMORY;
+        verifier->anchors = new_anchors;
+        verifier->max_anchors = new_max;
+    }
+    anchor = &(verifier->anchors[verifier->num_anchors]);
+    anchor->key = (uint8_t *)malloc(key_len);
+    if (!(anchor->key))
+        return NOISE_ERROR_NO_MEMORY;
+    memcpy(anchor->key, Noise_PublicKeyInfo_get_key(key), key_len);
+    anchor->key_len = key_len;
+    anchor->sign_id = sign_id;
+    ++(verifier->num_anchors);
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Adds the subject keys of a trusted certificate to a verifier.
+ *
+ * \param verifier The NoiseCertVerifier object.
+ * \param cert The trusted certificate, usually a root certificate that
+ * was loaded from local storage.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a verifier or \a cert is NULL.
+ * \return NOISE_ERROR_INVALID_PUBLIC_KEY if one of the signing keys in
+ * \a cert is invalid.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory to
+ * add the keys.
+ *
+ * Only the subject keys that use a supported signature algorithm are
+ * added as trust anchors.  Other keys, such as Diffie-Hellman keys, are
+ * ignored.  The signatures on \a cert itself are not checked.
+ *
+ * \sa noise_cert_verifier_add_trust_anchor()
+ */
+int noise_cert_verifier_add_trusted_certificate
+    (NoiseCertVerifier *verifier, const Noise_Certificate *cert)
+{
+    const Noise_SubjectInfo *subject;
+    size_t count, index;
+    int err;
+
+    /* Validate the parameters */
+    if (!verifier || !cert)
+        return NOISE_ERROR_INVALID_PARAM;
+
+    /* Add all of the signing keys from the subject */
+    subject = Noise_Certificate_get_subject(cert);
+    count = Noise_SubjectInfo_count_keys(subject);
+    for (index = 0; index < count; ++index) {
+        err = noise_cert_verifier_add_trust_anchor
+            (verifier, Noise_SubjectInfo_get_at_keys(subject, index));
+        if (err != NOISE_ERROR_NONE && err != NOISE_ERROR_UNKNOWN_NAME)
+            return err;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Computes the cache tag for a signature job.
+ *
+ * \param hash The BLAKE2s object to use to compute the tag.
+ * \param job The job to compute the tag for.
+ *
+ * The tag covers the signature algorithm, the signer's public key, the
+ * signature, and the signed hash.  A cache hit on the tag therefore means
+ * that exactly this signature has been verified with exactly this key.
+ */
+static void noise_cert_compute_tag(NoiseHashState *hash, NoiseCertJob *job)
+{
+    uint8_t id[4];
+    uint8_t tag[NOISE_CERT_TAG_WORDS * 4];
+    int sign_id = noise_signstate_get_sign_id(job->state);
+    int index;
+    id[0] = (uint8_t)(sign_id >> 24);
+    id[1] = (uint8_t)(sign_id >> 16);
+    id[2] = (uint8_t)(sign_id >> 8);
+    id[3] = (uint8_t)sign_id;
+    noise_hashstate_reset(hash);
+    noise_hashstate_update(hash, id, sizeof(id));
+    noise_hashstate_update
+        (hash, (const uint8_t *)Noise_PublicKeyInfo_get_key(job->signer),
+         Noise_PublicKeyInfo_get_size_key(job->signer));
+    noise_hashstate_update
+        (hash, job->signature,
+         noise_signstate_get_signature_length(job->state));
+    noise_hashstate_update(hash, job->hash, job->hash_len);
+    noise_hashstate_finalize(hash, tag, sizeof(tag));
+    for (index = 0; index < NOISE_CERT_TAG_WORDS; ++index) {
+        job->tag[index] = ((uint32_t)(tag[index * 4])) |
+                          (((uint32_t)(tag[index * 4 + 1])) << 8) |
+                          (((uint32_t)(tag[index * 4 + 2])) << 16) |
+                          (((uint32_t)(tag[index * 4 + 3])) << 24);
+    }
+}
+
+#if NOISE_CERT_HAVE_ATOMICS
+
+/**
+ * \brief Looks for a tag in a single cache slot.
+ *
+ * \param slot The cache slot.
+ * \param tag The tag to look for.
+ *
+ * \return Non-zero if the slot contains \a tag, zero if not.
+ */
+static int noise_cert_slot_matches
+    (NoiseCertCacheSlot *slot, const uint32_t *tag)
+{
+    uint32_t seq, diff;
+    int index;
+    seq = noise_cert_load_acquire(&(slot->seq));
+    if (!seq || (seq & 1) != 0)
+        return 0;
+    diff = 0;
+    for (index = 0; index < NOISE_CERT_TAG_WORDS; ++index)
+        diff |= noise_cert_load_relaxed(&(slot->tag[index])) ^ tag[index];
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return !diff && noise_cert_load_relaxed(&(slot->seq)) == seq;
+}
+
+/**
+ * \brief Looks for a tag in the verified signature cache.
+ *
+ * \param verifier The certificate verifier.
+ * \param tag The tag to look for.
+ *
+ * \return Non-zero if the tag is present, zero if not.
+ */
+static int noise_cert_cache_lookup
+    (NoiseCertVerifier *verifier, const uint32_t *tag)
+{
+    NoiseCertCacheSlot *slots =
+        verifier->slots + (tag[0] & verifier->slot_mask & ~((size_t)1));
+    return noise_cert_slot_matches(&(slots[0]), tag) ||
+           noise_cert_slot_matches(&(slots[1]), tag);
+}
+
+/**
+ * \brief Inserts a tag into the verified signature cache.
+ *
+ * \param verifier The certificate verifier.
+ * \param tag The tag to insert.
+ *
+ * If another thread is currently writing to the chosen slot, then the
+ * insertion is abandoned.  The signature will simply be verified again
+ * the next time that it is seen.
+ */
+static void noise_cert_cache_insert
+    (NoiseCertVerifier *verifier, const uint32_t *tag)
+{
+    NoiseCertCacheSlot *slot =
+        verifier->slots + (tag[0] & verifier->slot_mask & ~((size_t)1));
+    uint32_t seq;
+    int index;
+
+    /* Choose one of the two candidate slots.  An empty slot is used if
+       there is one; otherwise the victim is chosen in round-robin order */
+    if (noise_cert_slot_matches(&(slot[0]), tag) ||
+            noise_cert_slot_matches(&(slot[1]), tag))
+        return;
+    if (noise_cert_load_relaxed(&(slot[0].seq)) != 0) {
+        if (noise_cert_load_relaxed(&(slot[1].seq)) == 0)
+            slot += 1;
+        else
+            slot += noise_cert_fetch_add(&(verifier->victim), 1) & 1;
+    }
+
+    /* Claim the slot by making the sequence number odd */
+    seq = noise_cert_load_relaxed(&(slot->seq));
+    if ((seq & 1) != 0)
+        return;
+    if (!__atomic_compare_exchange_n(&(slot->seq), &seq, seq + 1, 0,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        return;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    /* Write the new tag and release the slot.  Skip over zero when the
+       sequence number wraps around because zero indicates "empty" */
+    for (index = 0; index < NOISE_CERT_TAG_WORDS; ++index)
+        noise_cert_store_relaxed(&(slot->tag[index]), tag[index]);
+    seq += 2;
+    if (!seq)
+        seq = 2;
+    noise_cert_store_release(&(slot->seq), seq);
+}
+
+#else /* !NOISE_CERT_HAVE_ATOMICS */
+
+#define noise_cert_cache_lookup(verifier, tag) 0
+#define noise_cert_cache_insert(verifier, tag) do { ; } while (0)
+
+#endif /* !NOISE_CERT_HAVE_ATOMICS */
+
+/**
+ * \brief Verifies a list of certificates.
+ *
+ * \param verifier The certificate verifier.
+ * \param certs The list of certificates, with the subject first.
+ * \param count The number of certificates in \a certs.
+ *
+ * \return NOISE_ERROR_NONE if the first certificate is trusted.
+ * \return NOISE_ERROR_INVALID_SIGNATURE if there is no path of valid
+ * signatures from a trust anchor to the first certificate.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory.
+ */
+static int noise_cert_verifier_verify_list
+    (NoiseCertVerifier *verifier, const Noise_Certificate **certs,
+     size_t count)
+{
+    NoiseCertJob *jobs = 0;
+    size_t num_jobs = 0;
+    size_t max_jobs = 0;
+    NoiseCertJob *job;
+    NoiseHashState *tag_hash = 0;
+    const NoiseSignState **states = 0;
+    const uint8_t **messages = 0;
+    const uint8_t **signatures = 0;
+    size_t *message_lens = 0;
+    int *valid = 0;
+    int *trusted = 0;
+    size_t cert, sig, num_sigs, index, other, batch;
+    const Noise_Signature *signature;
+    const Noise_PublicKeyInfo *signer;
+    size_t signature_len;
+    int sign_id;
+    int changed;
+    int err = NOISE_ERROR_NONE;
+
+    /* Count the signatures so that we can allocate the job array */
+    for (cert = 0; cert < count; ++cert)
+        max_jobs += Noise_Certificate_count_signatures(certs[cert]);
+    if (!max_jobs)
+        return NOISE_ERROR_INVALID_SIGNATURE;
+    jobs = (NoiseCertJob *)calloc(max_jobs, sizeof(NoiseCertJob));
+    states = (const NoiseSignState **)calloc(max_jobs, sizeof(NoiseSignState *));
+    messages = (const uint8_t **)calloc(max_jobs, sizeof(uint8_t *));
+    signatures = (const uint8_t **)calloc(max_jobs, sizeof(uint8_t *));
+    message_lens = (size_t *)calloc(max_jobs, sizeof(size_t));
+    valid = (int *)calloc(max_jobs, sizeof(int));
+    trusted = (int *)calloc(count, sizeof(int));
+    if (!jobs || !states || !messages || !signatures || !message_lens ||
+            !valid || !trusted) {
+        err = NOISE_ERROR_NO_MEMORY;
+        goto cleanup;
+    }
+    if (verifier->slots) {
+        err = noise_hashstate_new_by_id(&tag_hash, NOISE_HASH_BLAKE2s);
+        if (err != NOISE_ERROR_NONE)
+            goto cleanup;
+    }
+
+    /* Collect the signatures that were made by a trust anchor or by a
+       key from another certificate in the list.  Signatures from keys
+       that we know nothing about can never contribute to trust */
+    for (cert = 0; cert < count; ++cert) {
+        num_sigs = Noise_Certificate_count_signatures(certs[cert]);
+        for (sig = 0; sig < num_sigs; ++sig) {
+            signature = Noise_Certificate_get_at_signatures(certs[cert], sig);
+            signer = Noise_Signature_get_signing_key(signature);
+            if (!signer || !Noise_Signature_has_signature(signature))
+                continue;
+            job = &(jobs[num_jobs]);
+            job->is_anchor = noise_cert_is_anchor(verifier, signer);
+            if (!(job->is_anchor)) {
+                for (other = 0; other < count; ++other) {
+                    if (other != cert &&
+                            noise_cert_has_subject_key(certs[other], signer))
+                        break;
+                }
+                if (other >= count)
+                    continue;
+            }
+            sign_id = noise_name_to_id
+                (NOISE_SIGN_CATEGORY, Noise_PublicKeyInfo_get_algorithm(signer),
+                 Noise_PublicKeyInfo_get_size_algorithm(signer));
+            if (!sign_id)
+                continue;
+            err = noise_signstate_new_by_id(&(job->state), sign_id);
+            if (err != NOISE_ERROR_NONE)
+                goto cleanup;
+            signature_len = noise_signstate_get_signature_length(job->state);
+            if (Noise_Signature_get_size_signature(signature) != signature_len ||
+                    noise_signstate_set_public_key
+                        (job->state,
+                         (const uint8_t *)Noise_PublicKeyInfo_get_key(signer),
+                         Noise_PublicKeyInfo_get_size_key(signer))
+                            != NOISE_ERROR_NONE) {
+                noise_signstate_free(job->state);
+                job->state = 0;
+                continue;
+            }
+            err = noise_certificate_compute_signed_hash
+                (certs[cert], signature, job->hash, sizeof(job->hash),
+                 &(job->hash_len));
+            if (err != NOISE_ERROR_NONE) {
+                noise_signstate_free(job->state);
+                job->state = 0;
+                if (err == NOISE_ERROR_NO_MEMORY)
+                    goto cleanup;
+                err = NOISE_ERROR_NONE;
+                continue;
+            }
+            job->cert = cert;
+            job->signer = signer;
+            job->signature =
+                (const uint8_t *)Noise_Signature_get_signature(signature);
+            ++num_jobs;
+        }
+    }
+
+    /* Check the cache for signatures that we have verified before */
+    for (index = 0; index < num_jobs; ++index) {
+        job = &(jobs[index]);
+        if (tag_hash) {
+            noise_cert_compute_tag(tag_hash, job);
+            if (noise_cert_cache_lookup(verifier, job->tag)) {
+                job->valid = 1;
+                noise_cert_fetch_add(&(verifier->hits), 1);
+            }
+        }
+    }
+
+    /* Verify the remaining signatures in batches, one batch for each
+       signature algorithm that is present in the list */
+    for (index = 0; index < num_jobs; ++index) {
+        if (jobs[index].valid)
+            continue;
+        sign_id = noise_signstate_get_sign_id(jobs[index].state);
+        signature_len = noise_signstate_get_signature_length(jobs[index].state);
+        batch = 0;
+        for (other = index; other < num_jobs; ++other) {
+            job = &(jobs[other]);
+            if (job->valid || noise_signstate_get_sign_id(job->state) != sign_id)
+                continue;
+            states[batch] = job->state;
+            messages[batch] = job->hash;
+            message_lens[batch] = job->hash_len;
+            signatures[batch] = job->signature;
+            ++batch;
+        }
+        noise_cert_fetch_add(&(verifier->misses), batch);
+        noise_signstate_verify_batch
+            (states, messages, message_lens, signatures, signature_len,
+             batch, valid);
+        batch = 0;
+        for (other = index; other < num_jobs; ++other) {
+            job = &(jobs[other]);
+            if (job->valid || noise_signstate_get_sign_id(job->state) != sign_id)
+                continue;
+            job->valid = valid[batch++];
+            if (job->valid && tag_hash)
+                noise_cert_cache_insert(verifier, job->tag);
+            else if (!(job->valid))
+                job->valid = -1;
+        }
+    }
+
+    /* Propagate trust from the anchors through the list until nothing
+       changes.  The number of certificates is normally very small */
+    do {
+        changed = 0;
+        for (index = 0; index < num_jobs; ++index) {
+            job = &(jobs[index]);
+            if (job->valid != 1 || trusted[job->cert])
+                continue;
+            if (job->is_anchor) {
+                trusted[job->cert] = 1;
+                changed = 1;
+                continue;
+            }
+            for (other = 0; other < count; ++other) {
+                if (other != job->cert && trusted[other] &&
+                        noise_cert_has_subject_key(certs[other], job->signer)) {
+                    trusted[job->cert] = 1;
+                    changed = 1;
+                    break;
+                }
+            }
+        }
+    } while (changed && !trusted[0]);
+    err = trusted[0] ? NOISE_ERROR_NONE : NOISE_ERROR_INVALID_SIGNATURE;
+
+cleanup:
+    for (index = 0; index < num_jobs; ++index)
+        noise_signstate_free(jobs[index].state);
+    if (tag_hash)
+        noise_hashstate_free(tag_hash);
+    free(jobs);
+    free(states);
+    free(messages);
+    free(signatures);
+    free(message_lens);
+    free(valid);
+    free(trusted);
+    return err;
+}
+
+/**
+ * \brief Verifies a single certificate against the trust anchors.
+ *
+ * \param verifier The NoiseCertVerifier object.
+ * \param cert The certificate to verify.
+ *
+ * \return NOISE_ERROR_NONE if \a cert has at least one valid signature
+ * from a trust anchor.
+ * \return NOISE_ERROR_INVALID_PARAM if \a verifier or \a cert is NULL.
+ * \return NOISE_ERROR_INVALID_SIGNATURE if \a cert does not have a
+ * valid signature from a trust anchor.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory to
+ * verify the certificate.
+ *
+ * Signatures from keys that are not trust anchors are ignored, as are
+ * signatures that use unsupported algorithms.
+ *
+ * \sa noise_cert_verifier_verify_chain()
+ */
+int noise_cert_verifier_verify_certificate
+    (NoiseCertVerifier *verifier, const Noise_Certificate *cert)
+{
+    if (!verifier || !cert)
+        return NOISE_ERROR_INVALID_PARAM;
+    return noise_cert_verifier_verify_list(verifier, &cert, 1);
+}
+
+/**
+ * \brief Verifies a certificate chain against the trust anchors.
+ *
+ * \param verifier The NoiseCertVerifier object.
+ * \param chain The certificate chain to verify.  The first certificate
+ * in the chain is the subject to be verified.
+ *
+ * \return NOISE_ERROR_NONE if the subject certificate is trusted.
+ * \return NOISE_ERROR_INVALID_PARAM if \a verifier or \a chain is NULL,
+ * or \a chain does not contain any certificates.
+ * \return NOISE_ERROR_INVALID_SIGNATURE if there is no path of valid
+ * signatures from a trust anchor to the subject certificate.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory to
+ * verify the chain.
+ *
+ * The subject is trusted if it has a valid signature from a trust anchor,
+ * or from a subject key of another certificate in the chain that is itself
+ * trusted.  The remaining certificates may appear in any order.
+ *
+ * All signatures that could contribute to the trust decision are verified
+ * together in a single batch, skipping any signatures that are already
+ * present in the verified signature cache.
+ *
+ * \sa noise_cert_verifier_verify_certificate()
+ */
+int noise_cert_verifier_verify_chain
+    (NoiseCertVerifier *verifier, const Noise_CertificateChain *chain)
+{
+    const Noise_Certificate **certs;
+    size_t count, index;
+    int err;
+
+    /* Validate the parameters */
+    if (!verifier || !chain)
+        return NOISE_ERROR_INVALID_PARAM;
+    count = Noise_CertificateChain_count_certs(chain);
+    if (!count)
+        return NOISE_ERROR_INVALID_PARAM;
+
+    /* Verify the certificates in the chain */
+    certs = (const Noise_Certificate **)
+        malloc(count * sizeof(Noise_Certificate *));
+    if (!certs)
+        return NOISE_ERROR_NO_MEMORY;
+    for (index = 0; index < count; ++index)
+        certs[index] = Noise_CertificateChain_get_at_certs(chain, index);
+    err = noise_cert_verifier_verify_list(verifier, certs, count);
+    free(certs);
+    return err;
+}
+
+/**
+ * \brief Clears the verified signature cache in a certificate verifier.
+ *
+ * \param verifier The NoiseCertVerifier object.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a verifier is NULL.
+ *
+ * This can be used to force all signatures to be verified again, such as
+ * after the application has decided that a signing key was compromised.
+ * The cache statistics are also reset to zero.
+ */
+int noise_cert_verifier_clear_cache(NoiseCertVerifier *verifier)
+{
+#if NOISE_CERT_HAVE_ATOMICS
+    NoiseCertCacheSlot *slot;
+    size_t index;
+    uint32_t seq;
+    int word;
+#endif
+    if (!verifier)
+        return NOISE_ERROR_INVALID_PARAM;
+#if NOISE_CERT_HAVE_ATOMICS
+    if (verifier->slots) {
+        for (index = 0; index <= verifier->slot_mask; ++index) {
+            /* Wait for any writer on the slot to finish and then claim it */
+            slot = &(verifier->slots[index]);
+            do {
+                seq = noise_cert_load_relaxed(&(slot->seq)) & ~((uint32_t)1);
+            } while (!__atomic_compare_exchange_n
+                        (&(slot->seq), &seq, seq + 1, 0,
+                         __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+            __atomic_thread_fence(__ATOMIC_RELEASE);
+            /* The sequence number keeps counting up rather than going
+               back to zero so that readers cannot mistake the cleared
+               slot for the one they started reading */
+            for (word = 0; word < NOISE_CERT_TAG_WORDS; ++word)
+                noise_cert_store_relaxed(&(slot->tag[word]), 0);
+            seq += 2;
+            if (!seq)
+                seq = 2;
+            noise_cert_store_release(&(slot->seq), seq);
+        }
+    }
+    noise_cert_store_relaxed(&(verifier->hits), 0);
+    noise_cert_store_relaxed(&(verifier->misses), 0);
+#else
+    verifier->hits = 0;
+    verifier->misses = 0;
+#endif
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Gets the statistics for the verified signature cache.
+ *
+ * \param verifier The NoiseCertVerifier object.
+ * \param hits Returns the number of signatures that were found in the
+ * cache and did not need to be verified again.
+ * \param misses Returns the number of signatures that were verified.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a verifier, \a hits, or
+ * \a misses is NULL.
+ */
+int noise_cert_verifier_get_cache_stats
+    (const NoiseCertVerifier *verifier, size_t *hits, size_t *misses)
+{
+    if (!verifier || !hits || !misses)
+        return NOISE_ERROR_INVALID_PARAM;
+    *hits = noise_cert_load_relaxed(&(verifier->hits));
+    *misses = noise_cert_load_relaxed(&(verifier->misses));
+    return NOISE_ERROR_NONE;
+}
+
+/**@}*/
@@ -67,6 +67,16 @@
  *
  * These limitations may be addressed in future versions.
  *
+ * By default, <tt>noise-protoc</tt> emits specialized code for every
+ * field of every message.  The <tt>--tables</tt> option instead emits a
+ * compact descriptor table for each message, and the generated functions
+ * call the shared serializer in the \ref protobuf_tables "Table-driven
+ * Protobufs API".  The accessor API and the wire format are the same in
+ * both modes.  The table-driven code is considerably smaller but also
+ * slower, so the certificate code in the library uses the default mode.
+ * The unit tests build a second copy of the certificate code with
+ * <tt>--tables</tt> and run the protobuf tests against it.
+ *
  * TODO
  *
  * \section protobuf_writing Writing to a protobuf
@@ -150,6 +160,40 @@
  * same code to both measure and write a structure.  The difference is
  * only in how the protobuf is prepared and finished.
  *
+ * \section protobuf_encoding Single-pass encoding
+ *
+ * Writing in reverse order needs a measuring pass first to size the
+ * buffer, which visits every field twice.  The code that is generated by
+ * <tt>noise-protoc</tt> also provides "measure" and "encode" functions
+ * for each message type.  The "measure" function computes the size of
+ * the message and caches the size of every nested message inside the
+ * objects.  The "encode" function then uses the cached sizes to write
+ * the length prefixes up-front, filling the buffer from the start in a
+ * single forwards pass:
+ *
+ * \code
+ * size_t size = Person_measure(0, person);
+ * uint8_t *data = (uint8_t *)malloc(size);
+ * NoiseProtobuf pbuf;
+ * noise_protobuf_prepare_encode(&pbuf, data, size);
+ * Person_encode(&pbuf, 0, person);
+ * err = noise_protobuf_finish_encode(&pbuf, &size);
+ * \endcode
+ *
+ * The output is identical to that produced by the "write" function.
+ * The object must not be modified between the calls to "measure" and
+ * "encode", or the cached sizes will be out of date.  The encoder never
+ * writes outside the buffer if that happens but the output will not be
+ * valid.
+ *
+ * The "measure" function modifies the object even though it takes a
+ * const pointer, so it is not safe to run concurrently with another
+ * "measure", "encode", or modification of the same object.  The cached
+ * sizes are stored with relaxed atomic operations, which avoids undefined
+ * behaviour but not stale sizes.  Objects that are shared between threads,
+ * such as certificates in a verifier, should be serialized under a lock
+ * or with the "write" function, which does not modify the object.
+ *
  * \section protobuf_reading Reading from a protobuf
  *
  * Reading from a protobuf is similar to writing.  We start by calling
@@ -202,6 +246,40 @@
  *
  * If the application has not consumed the entire buffer's contents,
  * then an "invalid format" error will occur at this point.
+ *
+ * \section protobuf_arena Decoding into an arena
+ *
+ * By default, the code that is generated by <tt>noise-protoc</tt>
+ * allocates every object, array, string, and byte array that it decodes
+ * from the heap.  Decoding a certificate chain can therefore involve
+ * dozens of small allocations, all of which must be freed again later.
+ *
+ * Applications that decode the same kinds of structures over and over
+ * can instead supply an arena of memory to allocate from:
+ *
+ * \code
+ * uint8_t memory[4096];
+ * NoiseProtobufArena arena;
+ * NoiseProtobuf pbuf;
+ * Noise_CertificateChain *chain;
+ * noise_protobuf_arena_init(&arena, memory, sizeof(memory));
+ * noise_protobuf_prepare_input_arena(&pbuf, data, size, &arena);
+ * err = noise_load_certificate_chain_from_buffer(&chain, &pbuf);
+ * ...
+ * noise_protobuf_arena_reset(&arena);
+ * \endcode
+ *
+ * All objects and arrays are allocated from the arena, byte array fields
+ * point directly into the input data rather than being copied, and string
+ * fields are copied into the arena so that they can be NUL-terminated.
+ * The input data must therefore remain valid and unmodified for as long
+ * as the decoded objects are in use.
+ *
+ * Objects that were decoded into an arena must not be freed or modified
+ * with the generated "free", "clear", "set", or "add" functions.
+ * Instead, everything is discarded at once by calling
+ * noise_protobuf_arena_reset().  If decoding fails because the arena
+ * is too small, NOISE_ERROR_NO_MEMORY will be reported.
  */
 /**@{*/
 
@@ -226,6 +304,9 @@
 /* Maximum supported tag value */
 #define NOISE_PROTOBUF_MAX_TAG  ((((uint64_t)1) << 29) - 1)
 
+/* Alignment of the blocks that are allocated from an arena */
+#define NOISE_PROTOBUF_ARENA_ALIGN  (sizeof(void *) > 8 ? sizeof(void *) : 8)
+
 /** @endcond */
 
 /**
@@ -249,9 +330,111 @@ int noise_protobuf_prepare_input
     pbuf->size = size;
     pbuf->posn = 0;
     pbuf->error = NOISE_ERROR_NONE;
+    pbuf->arena = 0;
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Initializes an arena for decoding protobuf objects.
+ *
+ * \param arena The arena to initialize.
+ * \param data Points to the memory to allocate objects from.
+ * \param size The size of the memory at \a data in bytes.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a arena or \a data is NULL.
+ *
+ * The arena does not take ownership of \a data.  The caller is responsible
+ * for freeing it once all objects that were decoded into the arena are
+ * no longer required.
+ *
+ * \sa noise_protobuf_arena_reset(), noise_protobuf_prepare_input_arena()
+ */
+int noise_protobuf_arena_init
+    (NoiseProtobufArena *arena, void *data, size_t size)
+{
+    if (!arena || !data)
+        return NOISE_ERROR_INVALID_PARAM;
+    arena->data = (uint8_t *)data;
+    arena->size = size;
+    arena->posn = 0;
     return NOISE_ERROR_NONE;
 }
 
+/**
+ * \brief Resets an arena, freeing all objects that were allocated from it.
+ *
+ * \param arena The arena to reset.
+ *
+ * This function takes constant time regardless of the number of objects
+ * in the arena.  The memory is not cleared; the application should call
+ * noise_clean() on the arena's memory if it may contain sensitive data.
+ *
+ * \sa noise_protobuf_arena_init()
+ */
+void noise_protobuf_arena_reset(NoiseProtobufArena *arena)
+{
+    if (arena)
+        arena->posn = 0;
+}
+
+/**
+ * \brief Allocates a zeroed block of memory from an arena.
+ *
+ * \param arena The arena to allocate from.
+ * \param size The number of bytes to allocate.
+ *
+ * \return A pointer to the block or NULL if there is insufficient
+ * space remaining in \a arena.
+ *
+ * \sa noise_protobuf_arena_reset()
+ */
+void *noise_protobuf_arena_alloc(NoiseProtobufArena *arena, size_t size)
+{
+    size_t posn;
+    uint8_t *ptr;
+    if (!arena || !arena->data)
+        return 0;
+    posn = (size_t)(-(uintptr_t)(arena->data + arena->posn)) &
+           (NOISE_PROTOBUF_ARENA_ALIGN - 1);
+    if (posn > (arena->size - arena->posn))
+        return 0;
+    posn += arena->posn;
+    if (size > (arena->size - posn))
+        return 0;
+    ptr = arena->data + posn;
+    memset(ptr, 0, size);
+    arena->posn = posn + size;
+    return ptr;
+}
+
+/**
+ * \brief Prepares a protobuf for reading input into an arena.
+ *
+ * \param pbuf The protobuf to be prepared.
+ * \param data The data to be parsed.
+ * \param size The size of the data to be parsed in bytes.
+ * \param arena The arena to allocate decoded objects from, or NULL to
+ * allocate them from the heap.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a pbuf or \a data is NULL.
+ *
+ * Byte array fields that are decoded from \a pbuf will point directly
+ * into \a data, so \a data must outlive the decoded objects.
+ *
+ * \sa noise_protobuf_prepare_input(), noise_protobuf_arena_init()
+ */
+int noise_protobuf_prepare_input_arena
+    (NoiseProtobuf *pbuf, const uint8_t *data, size_t size,
+     NoiseProtobufArena *arena)
+{
+    int err = noise_protobuf_prepare_input(pbuf, data, size);
+    if (err == NOISE_ERROR_NONE)
+        pbuf->arena = arena;
+    return err;
+}
+
 /**
  * \brief Prepares a protobuf for writing output.
  *
@@ -273,6 +456,7 @@ int noise_protobuf_prepare_output
     pbuf->size = size;
     pbuf->posn = size;
     pbuf->error = NOISE_ERROR_NONE;
+    pbuf->arena = 0;
     return NOISE_ERROR_NONE;
 }
 
@@ -297,6 +481,36 @@ int noise_protobuf_prepare_measure(NoiseProtobuf *pbuf, size_t max_size)
     pbuf->size = max_size;
     pbuf->posn = max_size;
     pbuf->error = NOISE_ERROR_NONE;
+    pbuf->arena = 0;
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Prepares a protobuf for single-pass encoding of output.
+ *
+ * \param pbuf The protobuf to be prepared.
+ * \param data The data buffer to write to.
+ * \param size The maximum size of the storage at \a data in bytes.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a pbuf or \a data is NULL.
+ *
+ * Unlike noise_protobuf_prepare_output(), the protobuf is filled from
+ * the start of \a data forwards with the noise_protobuf_encode_*()
+ * functions.
+ *
+ * \sa noise_protobuf_finish_encode()
+ */
+int noise_protobuf_prepare_encode
+    (NoiseProtobuf *pbuf, uint8_t *data, size_t size)
+{
+    if (!pbuf || !data)
+        return NOISE_ERROR_INVALID_PARAM;
+    pbuf->data = data;
+    pbuf->size = size;
+    pbuf->posn = 0;
+    pbuf->error = NOISE_ERROR_NONE;
+    pbuf->arena = 0;
     return NOISE_ERROR_NONE;
 }
 
@@ -455,6 +669,36 @@ int noise_protobuf_finish_measure(NoiseProtobuf *pbuf, size_t *size)
     return NOISE_ERROR_NONE;
 }
 
+/**
+ * \brief Finishes single-pass encoding of output to a protobuf.
+ *
+ * \param pbuf The protobuf.
+ * \param size Receives the number of bytes that were written to the
+ * start of the buffer.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a pbuf or \a size is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if the available space in the buffer
+ * was insufficient to serialize the entire structure.
+ * \return NOISE_ERROR_INVALID_FORMAT if an attempt was made to write a
+ * string to the protobuf that was not in UTF-8.
+ *
+ * If an error occurred, then \a size will be set to zero.
+ *
+ * \sa noise_protobuf_prepare_encode()
+ */
+int noise_protobuf_finish_encode(NoiseProtobuf *pbuf, size_t *size)
+{
+    if (size)
+        *size = 0;
+    if (!pbuf || !size)
+        return NOISE_ERROR_INVALID_PARAM;
+    if (pbuf->error != NOISE_ERROR_NONE)
+        return pbuf->error;
+    *size = pbuf->posn;
+    return NOISE_ERROR_NONE;
+}
+
 /**
  * \brief Reserves space in a protobuf.
  *
@@ -490,54 +734,197 @@ static int noise_protobuf_reserve_space
 
 #define NOISE_PROTOBUF_UINT64_BITS(n) (((uint64_t)1) << (n))
 
+#if defined(__GNUC__) || defined(__clang__)
+#define NOISE_PROTOBUF_HAVE_BIT_SCAN 1
+#endif
+
 /** @endcond */
 
 /**
- * \brief Writes a variable-length integer to a protobuf.
+ * \brief Determines the number of bytes that are needed to encode
+ * a varint value.
  *
- * \param pbuf The protobuf.
- * \param value The integer value to write.
+ * \param value The value to be encoded.
  *
- * \return NOISE_ERROR_NONE on success.
- * \return NOISE_ERROR_INVALID_PARAM if \a pbuf is NULL.
- * \return NOISE_ERROR_INVALID_LENGTH if the protobuf has insufficient space.
+ * \return The number of bytes, between 1 and 10.
  */
-static int noise_protobuf_write_varint(NoiseProtobuf *pbuf, uint64_t value)
+static size_t noise_protobuf_varint_size(uint64_t value)
 {
-    size_t size;
-    uint8_t *data;
-    int err;
+#if defined(NOISE_PROTOBUF_HAVE_BIT_SCAN)
+    /* Every 7 bits of significance needs another byte.  Multiplying the
+       bit length by 9/64 rounds the same way as dividing by 7 does for
+       all lengths between 1 and 64, without a divide or a branch */
+    unsigned bits = 64 - (unsigned)__builtin_clzll(value | 1);
+    return (size_t)((bits * 9 + 64) / 64);
+#else
     if (value < NOISE_PROTOBUF_UINT64_BITS(7))
-        size = 1;
+        return 1;
     else if (value < NOISE_PROTOBUF_UINT64_BITS(14))
-        size = 2;
+        return 2;
     else if (value < NOISE_PROTOBUF_UINT64_BITS(21))
-        size = 3;
+        return 3;
     else if (value < NOISE_PROTOBUF_UINT64_BITS(28))
-        size = 4;
+        return 4;
     else if (value < NOISE_PROTOBUF_UINT64_BITS(35))
-        size = 5;
+        return 5;
     else if (value < NOISE_PROTOBUF_UINT64_BITS(42))
-        size = 6;
+        return 6;
     else if (value < NOISE_PROTOBUF_UINT64_BITS(49))
-        size = 7;
+        return 7;
     else if (value < NOISE_PROTOBUF_UINT64_BITS(56))
-        size = 8;
+        return 8;
     else if (value < NOISE_PROTOBUF_UINT64_BITS(63))
-        size = 9;
+        return 9;
     else
-        size = 10;
-    err = noise_protobuf_reserve_space(pbuf, size, &data);
-    if (err != NOISE_ERROR_NONE)
-        return err;
-    if (!data)
-        return NOISE_ERROR_NONE;
+        return 10;
+#endif
+}
+
+/**
+ * \brief Stores a varint value into a buffer one byte at a time.
+ *
+ * \param data Points to the buffer.
+ * \param value The value to store.
+ * \param size The encoded size of \a value from noise_protobuf_varint_size().
+ */
+static void noise_protobuf_store_varint
+    (uint8_t *data, uint64_t value, size_t size)
+{
     while (size > 1) {
         *data++ = ((uint8_t)value) | (uint8_t)0x80;
         value >>= 7;
         --size;
     }
     *data = ((uint8_t)value) & (uint8_t)0x7F;
+}
+
+/**
+ * \brief Stores a varint value of 8 bytes or less into a buffer as
+ * a single 64-bit word.
+ *
+ * \param data Points to the buffer, which must have at least 8 bytes
+ * of space available even if \a size is less than 8.
+ * \param value The value to store, which must be less than 2^56.
+ * \param size The encoded size of \a value from noise_protobuf_varint_size().
+ *
+ * The 7-bit groups are spread out to byte boundaries with shifts and masks
+ * and then the continuation bits are added for all bytes except the last.
+ * Bytes after the first \a size are written as zero.
+ */
+static void noise_protobuf_store_varint_word
+    (uint8_t *data, uint64_t value, size_t size)
+{
+    uint64_t word;
+    word  =  value        & (((uint64_t)0x7F));
+    word |= (value << 1)  & (((uint64_t)0x7F) << 8);
+    word |= (value << 2)  & (((uint64_t)0x7F) << 16);
+    word |= (value << 3)  & (((uint64_t)0x7F) << 24);
+    word |= (value << 4)  & (((uint64_t)0x7F) << 32);
+    word |= (value << 5)  & (((uint64_t)0x7F) << 40);
+    word |= (value << 6)  & (((uint64_t)0x7F) << 48);
+    word |= (value << 7)  & (((uint64_t)0x7F) << 56);
+    word |= ((uint64_t)0x0080808080808080ULL) >> (8 * (8 - size));
+    data[0] = (uint8_t)word;
+    data[1] = (uint8_t)(word >> 8);
+    data[2] = (uint8_t)(word >> 16);
+    data[3] = (uint8_t)(word >> 24);
+    data[4] = (uint8_t)(word >> 32);
+    data[5] = (uint8_t)(word >> 40);
+    data[6] = (uint8_t)(word >> 48);
+    data[7] = (uint8_t)(word >> 56);
+}
+
+/**
+ * \brief Loads a varint value from a buffer.
+ *
+ * \param data Points to the buffer.
+ * \param avail The number of bytes that are available at \a data.
+ * \param value Returns the value on exit.
+ *
+ * \return The number of bytes that were consumed, or zero if the
+ * varint is truncated or longer than 10 bytes.
+ *
+ * Single-byte values are handled first as they are the most common:
+ * tags and the lengths of short fields.  If at least 8 bytes are
+ * available, then the terminating byte is located in a 64-bit word
+ * with a bit scan and the 7-bit groups are gathered with shifts and
+ * masks.  Otherwise the bytes are processed one at a time.
+ */
+static size_t noise_protobuf_load_varint
+    (const uint8_t *data, size_t avail, uint64_t *value)
+{
+    unsigned shift;
+    size_t len;
+    uint8_t ch;
+    if (!avail) {
+        *value = 0;
+        return 0;
+    }
+    if (data[0] < 0x80) {
+        *value = data[0];
+        return 1;
+    }
+#if defined(NOISE_PROTOBUF_HAVE_BIT_SCAN)
+    if (avail >= 8) {
+        uint64_t word, stop;
+        word = ((uint64_t)(data[0])) |
+              (((uint64_t)(data[1])) << 8) |
+              (((uint64_t)(data[2])) << 16) |
+              (((uint64_t)(data[3])) << 24) |
+              (((uint64_t)(data[4])) << 32) |
+              (((uint64_t)(data[5])) << 40) |
+              (((uint64_t)(data[6])) << 48) |
+              (((uint64_t)(data[7])) << 56);
+        stop = ~word & (uint64_t)0x8080808080808080ULL;
+        if (stop) {
+            len = ((size_t)__builtin_ctzll(stop) + 1) / 8;
+            if (len < 8)
+                word &= NOISE_PROTOBUF_UINT64_BITS(8 * len) - 1;
+            *value =  (word        & (((uint64_t)0x7F)))       |
+                     ((word >> 1)  & (((uint64_t)0x7F) << 7))  |
+                     ((word >> 2)  & (((uint64_t)0x7F) << 14)) |
+                     ((word >> 3)  & (((uint64_t)0x7F) << 21)) |
+                     ((word >> 4)  & (((uint64_t)0x7F) << 28)) |
+                     ((word >> 5)  & (((uint64_t)0x7F) << 35)) |
+                     ((word >> 6)  & (((uint64_t)0x7F) << 42)) |
+                     ((word >> 7)  & (((uint64_t)0x7F) << 49));
+            return len;
+        }
+    }
+#endif
+    *value = 0;
+    shift = 0;
+    len = 0;
+    while (len < avail && len < 10) {
+        ch = data[len++];
+        *value |= (((uint64_t)(ch & 0x7F)) << shift);
+        if ((ch & 0x80) == 0)
+            return len;
+        shift += 7;
+    }
+    *value = 0;
+    return 0;
+}
+
+/**
+ * \brief Writes a variable-length integer to a protobuf.
+ *
+ * \param pbuf The protobuf.
+ * \param value The integer value to write.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a pbuf is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if the protobuf has insufficient space.
+ */
+static int noise_protobuf_write_varint(NoiseProtobuf *pbuf, uint64_t value)
+{
+    size_t size = noise_protobuf_varint_size(value);
+    uint8_t *data;
+    int err = noise_protobuf_reserve_space(pbuf, size, &data);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (data)
+        noise_protobuf_store_varint(data, value, size);
     return NOISE_ERROR_NONE;
 }
 
@@ -916,11 +1303,737 @@ static int noise_protobuf_is_utf8(const char *str, size_t size)
 }
 
 /**
- * \brief Writes a tagged UTF-8 string value to a protobuf.
+ * \brief Writes a tagged UTF-8 string value to a protobuf.
+ *
+ * \param pbuf The protobuf.
+ * \param tag The tag value to write, or zero for no tag.
+ * \param str Points to the string value to write, which can be NULL only
+ * if \a size is zero.
+ * \param size The size of the string in bytes.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a pbuf is NULL.
+ * \return NOISE_ERROR_INVALID_PARAM if \a str is NULL and \a size is non-zero.
+ * \return NOISE_ERROR_INVALID_LENGTH if the protobuf has insufficient space.
+ * \return NOISE_ERROR_INVALID_FORMAT if \a str contains characters that are
+ * not strict UTF-8.
+ */
+int noise_protobuf_write_string
+    (NoiseProtobuf *pbuf, int tag, const char *str, size_t size)
+{
+    if (!pbuf || (!str && size))
+        return NOISE_ERROR_INVALID_PARAM;
+    if (pbuf->error != NOISE_ERROR_NONE)
+        return pbuf->error;
+    if (!noise_protobuf_is_utf8(str, size)) {
+        pbuf->error = NOISE_ERROR_INVALID_FORMAT;
+        return pbuf->error;
+    }
+    return noise_protobuf_write_bytes(pbuf, tag, str, size);
+}
+
+/**
+ * \brief Writes a tagged byte array to a protobuf.
+ *
+ * \param pbuf The protobuf.
+ * \param tag The tag value to write, or zero for no tag.
+ * \param data Points to the byte array to write, which can be NULL only
+ * if \a size is zero.
+ * \param size The size of the byte array in bytes.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a pbuf is NULL.
+ * \return NOISE_ERROR_INVALID_PARAM if \a data is NULL and \a size is non-zero.
+ * \return NOISE_ERROR_INVALID_LENGTH if the protobuf has insufficient space.
+ */
+int noise_protobuf_write_bytes
+    (NoiseProtobuf *pbuf, int tag, const void *data, size_t size)
+{
+    uint8_t *out_data;
+    int err;
+    if (!pbuf || (!data && size))
+        return NOISE_ERROR_INVALID_PARAM;
+    err = noise_protobuf_reserve_space(pbuf, size, &out_data);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (out_data && size)
+        memcpy(out_data, data, size);
+    err = noise_protobuf_write_varint(pbuf, size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    return noise_protobuf_write_tag(pbuf, tag, NOISE_PROTOBUF_WIRE_DELIM);
+}
+
+/**
+ * \brief Writes the end of a nested element to a protobuf.
+ *
+ * \param pbuf The protobuf.
+ * \param end_posn Points to a variable to receive the end position
+ * of the nested element.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a pbuf or \a end_posn is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if the protobuf is already out
+ * of space.
+ *
+ * This function should be followed by calls to write the fields of
+ * the nested element in reverse order.  After all fields have been
+ * written, noise_protobuf_write_start_element() should be called to
+ * finalize the nested element.
+ *
+ * \sa noise_protobuf_write_start_element()
+ */
+int noise_protobuf_write_end_element(NoiseProtobuf *pbuf, size_t *end_posn)
+{
+    if (end_posn)
+        *end_posn = 0;
+    if (!pbuf || !end_posn)
+        return NOISE_ERROR_INVALID_PARAM;
+    if (pbuf->error != NOISE_ERROR_NONE)
+        return pbuf->error;
+    *end_posn = pbuf->posn;
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Writes the start of a tagged nested element to a protobuf.
+ *
+ * \param pbuf The protobuf.
+ * \param tag The tag value to write, or zero for no tag.
+ * \param end_posn The end position that was returned from a previous
+ * call to noise_protobuf_write_end_element().
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a pbuf is NULL.
+ * \return NOISE_ERROR_INVALID_PARAM if \a end_posn is out of range.
+ * \return NOISE_ERROR_INVALID_LENGTH if the protobuf has insufficient space.
+ *
+ * \sa noise_protobuf_write_end_element()
+ */
+int noise_protobuf_write_start_element
+    (NoiseProtobuf *pbuf, int tag, size_t end_posn)
+{
+    int err;
+    if (!pbuf || end_posn < pbuf->posn || end_posn > pbuf->size)
+        return NOISE_ERROR_INVALID_PARAM;
+    if (!tag)
+        return pbuf->error; /* No tag or size field necessary */
+    err = noise_protobuf_write_varint(pbuf, end_posn - pbuf->posn);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    return noise_protobuf_write_tag(pbuf, tag, NOISE_PROTOBUF_WIRE_DELIM);
+}
+
+/**
+ * \brief Determines the size of a tag value in a protobuf.
+ *
+ * \param tag The tag value, or zero for no tag.
+ *
+ * \return The number of bytes that are needed to encode \a tag.
+ */
+static size_t noise_protobuf_size_tag(int tag)
+{
+    if (!tag)
+        return 0;
+    return noise_protobuf_varint_size
+        ((uint64_t)(((int64_t)tag) << NOISE_PROTOBUF_WIRE_BITS));
+}
+
+/**
+ * \brief Determines the size of a tagged int32 value in a protobuf.
+ *
+ * \param tag The tag value, or zero for no tag.
+ * \param value The integer value.
+ *
+ * \return The number of bytes that noise_protobuf_encode_int32() or
+ * noise_protobuf_write_int32() will use to write the value.
+ */
+size_t noise_protobuf_size_int32(int tag, int32_t value)
+{
+    return noise_protobuf_size_tag(tag) +
+           noise_protobuf_varint_size((uint64_t)(int64_t)value);
+}
+
+/**
+ * \brief Determines the size of a tagged uint32 value in a protobuf.
+ *
+ * \param tag The tag value, or zero for no tag.
+ * \param value The integer value.
+ *
+ * \return The number of bytes that noise_protobuf_encode_uint32() or
+ * noise_protobuf_write_uint32() will use to write the value.
+ */
+size_t noise_protobuf_size_uint32(int tag, uint32_t value)
+{
+    return noise_protobuf_size_tag(tag) +
+           noise_protobuf_varint_size((uint64_t)value);
+}
+
+/**
+ * \brief Determines the size of a tagged int64 value in a protobuf.
+ *
+ * \param tag The tag value, or zero for no tag.
+ * \param value The integer value.
+ *
+ * \return The number of bytes that noise_protobuf_encode_int64() or
+ * noise_protobuf_write_int64() will use to write the value.
+ */
+size_t noise_protobuf_size_int64(int tag, int64_t value)
+{
+    return noise_protobuf_size_tag(tag) +
+           noise_protobuf_varint_size((uint64_t)value);
+}
+
+/**
+ * \brief Determines the size of a tagged uint64 value in a protobuf.
+ *
+ * \param tag The tag value, or zero for no tag.
+ * \param value The integer value.
+ *
+ * \return The number of bytes that noise_protobuf_encode_uint64() or
+ * noise_protobuf_write_uint64() will use to write the value.
+ */
+size_t noise_protobuf_size_uint64(int tag, uint64_t value)
+{
+    return noise_protobuf_size_tag(tag) + noise_protobuf_varint_size(value);
+}
+
+/**
+ * \brief Determines the size of a tagged sint32 value in a protobuf.
+ *
+ * \param tag The tag value, or zero for no tag.
+ * \param value The integer value.
+ *
+ * \return The number of bytes that noise_protobuf_encode_sint32() or
+ * noise_protobuf_write_sint32() will use to write the value.
+ */
+size_t noise_protobuf_size_sint32(int tag, int32_t value)
+{
+    value = (value << 1) ^ (value >> 31);
+    return noise_protobuf_size_tag(tag) +
+           noise_protobuf_varint_size((uint64_t)(uint32_t)value);
+}
+
+/**
+ * \brief Determines the size of a tagged sint64 value in a protobuf.
+ *
+ * \param tag The tag value, or zero for no tag.
+ * \param value The integer value.
+ *
+ * \return The number of bytes that noise_protobuf_encode_sint64() or
+ * noise_protobuf_write_sint64() will use to write the value.
+ */
+size_t noise_protobuf_size_sint64(int tag, int64_t value)
+{
+    value = (value << 1) ^ (value >> 63);
+    return noise_protobuf_size_tag(tag) +
+           noise_protobuf_varint_size((uint64_t)value);
+}
+
+/**
+ * \brief Determines the size of a tagged sfixed32 value in a protobuf.
+ *
+ * \param tag The tag value, or zero for no tag.
+ * \param value The integer value, which does not affect the size.
+ *
+ * \return The number of bytes that noise_protobuf_encode_sfixed32() or
+ * noise_protobuf_write_sfixed32() will use to write the value.
+ */
+size_t noise_protobuf_size_sfixed32(int tag, int32_t value)
+{
+    (void)value;
+    return noise_protobuf_size_tag(tag) + 4;
+}
+
+/**
+ * \brief Determines the size of a tagged fixed32 value in a protobuf.
+ *
+ * \param tag The tag value, or zero for no tag.
+ * \param value The integer value, which does not affect the size.
+ *
+ * \return The number of bytes that noise_protobuf_encode_fixed32() or
+ * noise_protobuf_write_fixed32() will use to write the value.
+ */
+size_t noise_protobuf_size_fixed32(int tag, uint32_t value)
+{
+    (void)value;
+    return noise_protobuf_size_tag(tag) + 4;
+}
+
+/**
+ * \brief Determines the size of a tagged sfixed64 value in a protobuf.
+ *
+ * \param tag The tag value, or zero for no tag.
+ * \param value The integer value, which does not affect the size.
+ *
+ * \return The number of bytes that noise_protobuf_encode_sfixed64() or
+ * noise_protobuf_write_sfixed64() will use to write the value.
+ */
+size_t noise_protobuf_size_sfixed64(int tag, int64_t value)
+{
+    (void)value;
+    return noise_protobuf_size_tag(tag) + 8;
+}
+
+/**
+ * \brief Determines the size of a tagged fixed64 value in a protobuf.
+ *
+ * \param tag The tag value, or zero for no tag.
+ * \param value The integer value, which does not affect the size.
+ *
+ * \return The number of bytes that noise_protobuf_encode_fixed64() or
+ * noise_protobuf_write_fixed64() will use to write the value.
+ */
+size_t noise_protobuf_size_fixed64(int tag, uint64_t value)
+{
+    (void)value;
+    return noise_protobuf_size_tag(tag) + 8;
+}
+
+/**
+ * \brief Determines the size of a tagged float value in a protobuf.
+ *
+ * \param tag The tag value, or zero for no tag.
+ * \param value The float value, which does not affect the size.
+ *
+ * \return The number of bytes that noise_protobuf_encode_float() or
+ * noise_protobuf_write_float() will use to write the value.
+ */
+size_t noise_protobuf_size_float(int tag, float value)
+{
+    (void)value;
+    return noise_protobuf_size_tag(tag) + 4;
+}
+
+/**
+ * \brief Determines the size of a tagged double value in a protobuf.
+ *
+ * \param tag The tag value, or zero for no tag.
+ * \param value The double value, which does not affect the size.
+ *
+ * \return The number of bytes that noise_protobuf_encode_double() or
+ * noise_protobuf_write_double() will use to write the value.
+ */
+size_t noise_protobuf_size_double(int tag, double value)
+{
+    (void)value;
+    return noise_protobuf_size_tag(tag) + 8;
+}
+
+/**
+ * \brief Determines the size of a tagged boolean value in a protobuf.
+ *
+ * \param tag The tag value, or zero for no tag.
+ * \param value The boolean value, which does not affect the size.
+ *
+ * \return The number of bytes that noise_protobuf_encode_bool() or
+ * noise_protobuf_write_bool() will use to write the value.
+ */
+size_t noise_protobuf_size_bool(int tag, int value)
+{
+    (void)value;
+    return noise_protobuf_size_tag(tag) + 1;
+}
+
+/**
+ * \brief Determines the size of a tagged string value in a protobuf.
+ *
+ * \param tag The tag value, or zero for no tag.
+ * \param size The size of the string in bytes.
+ *
+ * \return The number of bytes that noise_protobuf_encode_string() or
+ * noise_protobuf_write_string() will use to write the value.
+ */
+size_t noise_protobuf_size_string(int tag, size_t size)
+{
+    return noise_protobuf_size_tag(tag) +
+           noise_protobuf_varint_size((uint64_t)size) + size;
+}
+
+/**
+ * \brief Determines the size of a tagged byte array in a protobuf.
+ *
+ * \param tag The tag value, or zero for no tag.
+ * \param size The size of the byte array in bytes.
+ *
+ * \return The number of bytes that noise_protobuf_encode_bytes() or
+ * noise_protobuf_write_bytes() will use to write the value.
+ */
+size_t noise_protobuf_size_bytes(int tag, size_t size)
+{
+    return noise_protobuf_size_tag(tag) +
+           noise_protobuf_varint_size((uint64_t)size) + size;
+}
+
+/**
+ * \brief Determines the size of a tagged nested element in a protobuf.
+ *
+ * \param tag The tag value, or zero for no tag.
+ * \param size The size of the fields within the nested element in bytes.
+ *
+ * \return The number of bytes for the nested element, including the
+ * tag and size prefix if \a tag is non-zero.
+ *
+ * Nested elements without a tag have no size prefix, which matches
+ * the behaviour of noise_protobuf_write_start_element() and
+ * noise_protobuf_encode_start_element().
+ */
+size_t noise_protobuf_size_element(int tag, size_t size)
+{
+    if (!tag)
+        return size;
+    return noise_protobuf_size_tag(tag) +
+           noise_protobuf_varint_size((uint64_t)size) + size;
+}
+
+/**
+ * \brief Encodes a variable-length integer into a protobuf.
+ *
+ * \param pbuf The protobuf, which has been prepared for encoding.
+ * \param value The integer value to encode.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a pbuf is NULL or has not been
+ * prepared for encoding.
+ * \return NOISE_ERROR_INVALID_LENGTH if the protobuf has insufficient space.
+ */
+static int noise_protobuf_encode_varint(NoiseProtobuf *pbuf, uint64_t value)
+{
+    size_t size, avail;
+    uint8_t *data;
+    if (!pbuf || !pbuf->data)
+        return NOISE_ERROR_INVALID_PARAM;
+    if (pbuf->error != NOISE_ERROR_NONE)
+        return pbuf->error;
+    avail = pbuf->size - pbuf->posn;
+    data = pbuf->data + pbuf->posn;
+    if (value < 0x80 && avail > 0) {
+        /* Fast path for tags and short lengths */
+        *data = (uint8_t)value;
+        ++(pbuf->posn);
+        return NOISE_ERROR_NONE;
+    }
+    size = noise_protobuf_varint_size(value);
+    if (size > avail) {
+        pbuf->error = NOISE_ERROR_INVALID_LENGTH;
+        return pbuf->error;
+    }
+    if (size <= 8 && avail >= 8) {
+        /* The bytes after the varint are overwritten by the next field */
+        noise_protobuf_store_varint_word(data, value, size);
+    } else {
+        noise_protobuf_store_varint(data, value, size);
+    }
+    pbuf->posn += size;
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Encodes a tag value into a protobuf.
+ *
+ * \param pbuf The protobuf.
+ * \param tag The tag value to encode, or zero for no tag.
+ * \param type The wire representation type for the tag.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a pbuf is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if the protobuf has insufficient space.
+ */
+static int noise_protobuf_encode_tag(NoiseProtobuf *pbuf, int tag, int type)
+{
+    if (!pbuf)
+        return NOISE_ERROR_INVALID_PARAM;
+    if (pbuf->error != NOISE_ERROR_NONE)
+        return pbuf->error;
+    if (!tag)
+        return NOISE_ERROR_NONE;
+    return noise_protobuf_encode_varint
+        (pbuf, (uint64_t)((((int64_t)tag) << NOISE_PROTOBUF_WIRE_BITS) |
+                            (int64_t)type));
+}
+
+/**
+ * \brief Encodes a tagged integer value into a protobuf.
+ *
+ * \param pbuf The protobuf.
+ * \param tag The tag value to encode, or zero for no tag.
+ * \param value The integer value to encode.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a pbuf is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if the protobuf has insufficient space.
+ */
+static int noise_protobuf_encode_integer
+    (NoiseProtobuf *pbuf, int tag, uint64_t value)
+{
+    int err = noise_protobuf_encode_tag(pbuf, tag, NOISE_PROTOBUF_WIRE_VARINT);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    return noise_protobuf_encode_varint(pbuf, value);
+}
+
+/**
+ * \brief Encodes a tagged int32 value into a protobuf.
+ *
+ * \param pbuf The protobuf.
+ * \param tag The tag value to encode, or zero for no tag.
+ * \param value The integer value to encode.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a pbuf is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if the protobuf has insufficient space.
+ */
+int noise_protobuf_encode_int32(NoiseProtobuf *pbuf, int tag, int32_t value)
+{
+    return noise_protobuf_encode_integer(pbuf, tag, (uint64_t)(int64_t)value);
+}
+
+/**
+ * \brief Encodes a tagged uint32 value into a protobuf.
+ *
+ * \param pbuf The protobuf.
+ * \param tag The tag value to encode, or zero for no tag.
+ * \param value The integer value to encode.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a pbuf is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if the protobuf has insufficient space.
+ */
+int noise_protobuf_encode_uint32(NoiseProtobuf *pbuf, int tag, uint32_t value)
+{
+    return noise_protobuf_encode_integer(pbuf, tag, (uint64_t)value);
+}
+
+/**
+ * \brief Encodes a tagged int64 value into a protobuf.
+ *
+ * \param pbuf The protobuf.
+ * \param tag The tag value to encode, or zero for no tag.
+ * \param value The integer value to encode.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a pbuf is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if the protobuf has insufficient space.
+ */
+int noise_protobuf_encode_int64(NoiseProtobuf *pbuf, int tag, int64_t value)
+{
+    return noise_protobuf_encode_integer(pbuf, tag, (uint64_t)value);
+}
+
+/**
+ * \brief Encodes a tagged uint64 value into a protobuf.
+ *
+ * \param pbuf The protobuf.
+ * \param tag The tag value to encode, or zero for no tag.
+ * \param value The integer value to encode.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a pbuf is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if the protobuf has insufficient space.
+ */
+int noise_protobuf_encode_uint64(NoiseProtobuf *pbuf, int tag, uint64_t value)
+{
+    return noise_protobuf_encode_integer(pbuf, tag, value);
+}
+
+/**
+ * \brief Encodes a tagged sint32 value into a protobuf.
+ *
+ * \param pbuf The protobuf.
+ * \param tag The tag value to encode, or zero for no tag.
+ * \param value The integer value to encode.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a pbuf is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if the protobuf has insufficient space.
+ */
+int noise_protobuf_encode_sint32(NoiseProtobuf *pbuf, int tag, int32_t value)
+{
+    value = (value << 1) ^ (value >> 31);
+    return noise_protobuf_encode_integer(pbuf, tag, (uint64_t)(uint32_t)value);
+}
+
+/**
+ * \brief Encodes a tagged sint64 value into a protobuf.
+ *
+ * \param pbuf The protobuf.
+ * \param tag The tag value to encode, or zero for no tag.
+ * \param value The integer value to encode.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a pbuf is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if the protobuf has insufficient space.
+ */
+int noise_protobuf_encode_sint64(NoiseProtobuf *pbuf, int tag, int64_t value)
+{
+    value = (value << 1) ^ (value >> 63);
+    return noise_protobuf_encode_integer(pbuf, tag, (uint64_t)value);
+}
+
+/**
+ * \brief Encodes a tagged sfixed32 value into a protobuf.
+ *
+ * \param pbuf The protobuf.
+ * \param tag The tag value to encode, or zero for no tag.
+ * \param value The integer value to encode.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a pbuf is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if the protobuf has insufficient space.
+ */
+int noise_protobuf_encode_sfixed32(NoiseProtobuf *pbuf, int tag, int32_t value)
+{
+    return noise_protobuf_encode_fixed32(pbuf, tag, (uint32_t)value);
+}
+
+/**
+ * \brief Encodes a tagged fixed32 value into a protobuf.
+ *
+ * \param pbuf The protobuf.
+ * \param tag The tag value to encode, or zero for no tag.
+ * \param value The integer value to encode.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a pbuf is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if the protobuf has insufficient space.
+ */
+int noise_protobuf_encode_fixed32(NoiseProtobuf *pbuf, int tag, uint32_t value)
+{
+    uint8_t *data;
+    int err = noise_protobuf_encode_tag(pbuf, tag, NOISE_PROTOBUF_WIRE_32BIT);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (!pbuf->data)
+        return NOISE_ERROR_INVALID_PARAM;
+    if ((pbuf->size - pbuf->posn) < 4) {
+        pbuf->error = NOISE_ERROR_INVALID_LENGTH;
+        return pbuf->error;
+    }
+    data = pbuf->data + pbuf->posn;
+    data[0] = (uint8_t)value;
+    data[1] = (uint8_t)(value >> 8);
+    data[2] = (uint8_t)(value >> 16);
+    data[3] = (uint8_t)(value >> 24);
+    pbuf->posn += 4;
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Encodes a tagged sfixed64 value into a protobuf.
+ *
+ * \param pbuf The protobuf.
+ * \param tag The tag value to encode, or zero for no tag.
+ * \param value The integer value to encode.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a pbuf is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if the protobuf has insufficient space.
+ */
+int noise_protobuf_encode_sfixed64(NoiseProtobuf *pbuf, int tag, int64_t value)
+{
+    return noise_protobuf_encode_fixed64(pbuf, tag, (uint64_t)value);
+}
+
+/**
+ * \brief Encodes a tagged fixed64 value into a protobuf.
+ *
+ * \param pbuf The protobuf.
+ * \param tag The tag value to encode, or zero for no tag.
+ * \param value The integer value to encode.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a pbuf is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if the protobuf has insufficient space.
+ */
+int noise_protobuf_encode_fixed64(NoiseProtobuf *pbuf, int tag, uint64_t value)
+{
+    uint8_t *data;
+    int err = noise_protobuf_encode_tag(pbuf, tag, NOISE_PROTOBUF_WIRE_64BIT);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (!pbuf->data)
+        return NOISE_ERROR_INVALID_PARAM;
+    if ((pbuf->size - pbuf->posn) < 8) {
+        pbuf->error = NOISE_ERROR_INVALID_LENGTH;
+        return pbuf->error;
+    }
+    data = pbuf->data + pbuf->posn;
+    data[0] = (uint8_t)value;
+    data[1] = (uint8_t)(value >> 8);
+    data[2] = (uint8_t)(value >> 16);
+    data[3] = (uint8_t)(value >> 24);
+    data[4] = (uint8_t)(value >> 32);
+    data[5] = (uint8_t)(value >> 40);
+    data[6] = (uint8_t)(value >> 48);
+    data[7] = (uint8_t)(value >> 56);
+    pbuf->posn += 8;
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Encodes a tagged float value into a protobuf.
+ *
+ * \param pbuf The protobuf.
+ * \param tag The tag value to encode, or zero for no tag.
+ * \param value The float value to encode.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a pbuf is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if the protobuf has insufficient space.
+ */
+int noise_protobuf_encode_float(NoiseProtobuf *pbuf, int tag, float value)
+{
+    union {
+        float fvalue;
+        uint32_t ivalue;
+    } volatile un;
+    un.fvalue = value;
+    return noise_protobuf_encode_fixed32(pbuf, tag, un.ivalue);
+}
+
+/**
+ * \brief Encodes a tagged double value into a protobuf.
  *
  * \param pbuf The protobuf.
- * \param tag The tag value to write, or zero for no tag.
- * \param str Points to the string value to write, which can be NULL only
+ * \param tag The tag value to encode, or zero for no tag.
+ * \param value The double value to encode.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a pbuf is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if the protobuf has insufficient space.
+ */
+int noise_protobuf_encode_double(NoiseProtobuf *pbuf, int tag, double value)
+{
+    union {
+        double fvalue;
+        uint64_t ivalue;
+    } volatile un;
+    un.fvalue = value;
+    return noise_protobuf_encode_fixed64(pbuf, tag, un.ivalue);
+}
+
+/**
+ * \brief Encodes a tagged boolean value into a protobuf.
+ *
+ * \param pbuf The protobuf.
+ * \param tag The tag value to encode, or zero for no tag.
+ * \param value The boolean value to encode.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a pbuf is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if the protobuf has insufficient space.
+ */
+int noise_protobuf_encode_bool(NoiseProtobuf *pbuf, int tag, int value)
+{
+    return noise_protobuf_encode_integer(pbuf, tag, value ? 1 : 0);
+}
+
+/**
+ * \brief Encodes a tagged UTF-8 string value into a protobuf.
+ *
+ * \param pbuf The protobuf.
+ * \param tag The tag value to encode, or zero for no tag.
+ * \param str Points to the string value to encode, which can be NULL only
  * if \a size is zero.
  * \param size The size of the string in bytes.
  *
@@ -931,7 +2044,7 @@ static int noise_protobuf_is_utf8(const char *str, size_t size)
  * \return NOISE_ERROR_INVALID_FORMAT if \a str contains characters that are
  * not strict UTF-8.
  */
-int noise_protobuf_write_string
+int noise_protobuf_encode_string
     (NoiseProtobuf *pbuf, int tag, const char *str, size_t size)
 {
     if (!pbuf || (!str && size))
@@ -942,15 +2055,15 @@ int noise_protobuf_write_string
         pbuf->error = NOISE_ERROR_INVALID_FORMAT;
         return pbuf->error;
     }
-    return noise_protobuf_write_bytes(pbuf, tag, str, size);
+    return noise_protobuf_encode_bytes(pbuf, tag, str, size);
 }
 
 /**
- * \brief Writes a tagged byte array to a protobuf.
+ * \brief Encodes a tagged byte array into a protobuf.
  *
  * \param pbuf The protobuf.
- * \param tag The tag value to write, or zero for no tag.
- * \param data Points to the byte array to write, which can be NULL only
+ * \param tag The tag value to encode, or zero for no tag.
+ * \param data Points to the byte array to encode, which can be NULL only
  * if \a size is zero.
  * \param size The size of the byte array in bytes.
  *
@@ -959,82 +2072,70 @@ int noise_protobuf_write_string
  * \return NOISE_ERROR_INVALID_PARAM if \a data is NULL and \a size is non-zero.
  * \return NOISE_ERROR_INVALID_LENGTH if the protobuf has insufficient space.
  */
-int noise_protobuf_write_bytes
+int noise_protobuf_encode_bytes
     (NoiseProtobuf *pbuf, int tag, const void *data, size_t size)
 {
-    uint8_t *out_data;
     int err;
     if (!pbuf || (!data && size))
         return NOISE_ERROR_INVALID_PARAM;
-    err = noise_protobuf_reserve_space(pbuf, size, &out_data);
+    err = noise_protobuf_encode_tag(pbuf, tag, NOISE_PROTOBUF_WIRE_DELIM);
     if (err != NOISE_ERROR_NONE)
         return err;
-    if (out_data && size)
-        memcpy(out_data, data, size);
-    err = noise_protobuf_write_varint(pbuf, size);
+    err = noise_protobuf_encode_varint(pbuf, size);
     if (err != NOISE_ERROR_NONE)
         return err;
-    return noise_protobuf_write_tag(pbuf, tag, NOISE_PROTOBUF_WIRE_DELIM);
-}
-
-/**
- * \brief Writes the end of a nested element to a protobuf.
- *
- * \param pbuf The protobuf.
- * \param end_posn Points to a variable to receive the end position
- * of the nested element.
- *
- * \return NOISE_ERROR_NONE on success.
- * \return NOISE_ERROR_INVALID_PARAM if \a pbuf or \a end_posn is NULL.
- * \return NOISE_ERROR_INVALID_LENGTH if the protobuf is already out
- * of space.
- *
- * This function should be followed by calls to write the fields of
- * the nested element in reverse order.  After all fields have been
- * written, noise_protobuf_write_start_element() should be called to
- * finalize the nested element.
- *
- * \sa noise_protobuf_write_start_element()
- */
-int noise_protobuf_write_end_element(NoiseProtobuf *pbuf, size_t *end_posn)
-{
-    if (end_posn)
-        *end_posn = 0;
-    if (!pbuf || !end_posn)
-        return NOISE_ERROR_INVALID_PARAM;
-    if (pbuf->error != NOISE_ERROR_NONE)
+    if (size > (pbuf->size - pbuf->posn)) {
+        pbuf->error = NOISE_ERROR_INVALID_LENGTH;
         return pbuf->error;
-    *end_posn = pbuf->posn;
+    }
+    if (size)
+        memcpy(pbuf->data + pbuf->posn, data, size);
+    pbuf->posn += size;
     return NOISE_ERROR_NONE;
 }
 
 /**
- * \brief Writes the start of a tagged nested element to a protobuf.
+ * \brief Encodes the start of a tagged nested element into a protobuf.
  *
  * \param pbuf The protobuf.
- * \param tag The tag value to write, or zero for no tag.
- * \param end_posn The end position that was returned from a previous
- * call to noise_protobuf_write_end_element().
+ * \param tag The tag value to encode, or zero for no tag.
+ * \param size The size of the fields within the nested element, which
+ * is normally obtained ahead of time from the generated "measure"
+ * function for the element.
  *
  * \return NOISE_ERROR_NONE on success.
  * \return NOISE_ERROR_INVALID_PARAM if \a pbuf is NULL.
- * \return NOISE_ERROR_INVALID_PARAM if \a end_posn is out of range.
- * \return NOISE_ERROR_INVALID_LENGTH if the protobuf has insufficient space.
+ * \return NOISE_ERROR_INVALID_LENGTH if the protobuf has insufficient space
+ * for the element header or the \a size bytes of fields that follow it.
  *
- * \sa noise_protobuf_write_end_element()
+ * The fields of the nested element are encoded in forward order after
+ * this function returns.  No "end" call is necessary because the size
+ * of the element was known in advance.
+ *
+ * \sa noise_protobuf_size_element()
  */
-int noise_protobuf_write_start_element
-    (NoiseProtobuf *pbuf, int tag, size_t end_posn)
+int noise_protobuf_encode_start_element
+    (NoiseProtobuf *pbuf, int tag, size_t size)
 {
     int err;
-    if (!pbuf || end_posn < pbuf->posn || end_posn > pbuf->size)
+    if (!pbuf)
         return NOISE_ERROR_INVALID_PARAM;
-    if (!tag)
-        return pbuf->error; /* No tag or size field necessary */
-    err = noise_protobuf_write_varint(pbuf, end_posn - pbuf->posn);
-    if (err != NOISE_ERROR_NONE)
-        return err;
-    return noise_protobuf_write_tag(pbuf, tag, NOISE_PROTOBUF_WIRE_DELIM);
+    if (tag) {
+        err = noise_protobuf_encode_tag(pbuf, tag, NOISE_PROTOBUF_WIRE_DELIM);
+        if (err != NOISE_ERROR_NONE)
+            return err;
+        err = noise_protobuf_encode_varint(pbuf, size);
+        if (err != NOISE_ERROR_NONE)
+            return err;
+    } else if (pbuf->error != NOISE_ERROR_NONE) {
+        return pbuf->error;
+    }
+    if (size > (pbuf->size - pbuf->posn)) {
+        /* Fail early rather than writing a partial element */
+        pbuf->error = NOISE_ERROR_INVALID_LENGTH;
+        return pbuf->error;
+    }
+    return NOISE_ERROR_NONE;
 }
 
 /**
@@ -1050,9 +2151,7 @@ int noise_protobuf_write_start_element
 static int noise_protobuf_peek_varint
     (const NoiseProtobuf *pbuf, uint64_t *value, size_t *length)
 {
-    unsigned shift;
-    uint8_t ch;
-    size_t posn;
+    size_t posn, len;
     *value = 0;
     if (!pbuf || !pbuf->data)
         return NOISE_ERROR_INVALID_PARAM;
@@ -1061,25 +2160,12 @@ static int noise_protobuf_peek_varint
     posn = pbuf->posn + *length;
     if (posn >= pbuf->size)
         return NOISE_ERROR_INVALID_FORMAT;
-    ch = pbuf->data[posn];
-    ++(*length);
-    if ((ch & 0x80) == 0) {
-        *value = ch;
-        return NOISE_ERROR_NONE;
-    }
-    *value = (ch & 0x7F);
-    shift = 7;
-    while (shift <= 63) {
-        if (posn >= pbuf->size)
-            return NOISE_ERROR_INVALID_FORMAT;
-        ch = pbuf->data[posn++];
-        *value |= (((uint64_t)(ch & 0x7F)) << shift);
-        ++(*length);
-        if ((ch & 0x80) == 0)
-            return NOISE_ERROR_NONE;
-        shift += 7;
-    }
-    return NOISE_ERROR_INVALID_FORMAT;
+    len = noise_protobuf_load_varint
+        (pbuf->data + posn, pbuf->size - posn, value);
+    if (!len)
+        return NOISE_ERROR_INVALID_FORMAT;
+    *length += len;
+    return NOISE_ERROR_NONE;
 }
 
 /**
@@ -1155,8 +2241,7 @@ size_t noise_protobuf_peek_size(const NoiseProtobuf *pbuf)
  */
 static int noise_protobuf_read_varint(NoiseProtobuf *pbuf, uint64_t *value)
 {
-    unsigned shift;
-    uint8_t ch;
+    size_t len;
     *value = 0;
     if (!pbuf || !pbuf->data)
         return NOISE_ERROR_INVALID_PARAM;
@@ -1166,26 +2251,14 @@ static int noise_protobuf_read_varint(NoiseProtobuf *pbuf, uint64_t *value)
         pbuf->error = NOISE_ERROR_INVALID_FORMAT;
         return pbuf->error;
     }
-    ch = pbuf->data[(pbuf->posn++)];
-    if ((ch & 0x80) == 0) {
-        *value = ch;
-        return NOISE_ERROR_NONE;
-    }
-    *value = (ch & 0x7F);
-    shift = 7;
-    while (shift <= 63) {
-        if (pbuf->posn >= pbuf->size) {
-            pbuf->error = NOISE_ERROR_INVALID_FORMAT;
-            return pbuf->error;
-        }
-        ch = pbuf->data[(pbuf->posn++)];
-        *value |= (((uint64_t)(ch & 0x7F)) << shift);
-        if ((ch & 0x80) == 0)
-            return NOISE_ERROR_NONE;
-        shift += 7;
+    len = noise_protobuf_load_varint
+        (pbuf->data + pbuf->posn, pbuf->size - pbuf->posn, value);
+    if (!len) {
+        pbuf->error = NOISE_ERROR_INVALID_FORMAT;
+        return pbuf->error;
     }
-    pbuf->error = NOISE_ERROR_INVALID_FORMAT;
-    return pbuf->error;
+    pbuf->posn += len;
+    return NOISE_ERROR_NONE;
 }
 
 /**
@@ -1700,7 +2773,8 @@ int noise_protobuf_read_string
  * This function will validate the incoming data to ensure that it is
  * strict UTF-8 with no embedded NUL's.
  *
- * The memory is allocated with the system malloc() function.
+ * The memory is allocated with the system malloc() function, or from
+ * the arena if \a pbuf was prepared with noise_protobuf_prepare_input_arena().
  *
  * \sa noise_protobuf_read_string(), noise_protobuf_read_alloc_bytes()
  */
@@ -1736,7 +2810,11 @@ int noise_protobuf_read_alloc_string
         pbuf->error = NOISE_ERROR_INVALID_FORMAT;
         return pbuf->error;
     }
-    if ((*str = (char *)malloc(sz + 1)) == 0) {
+    if (pbuf->arena)
+        *str = (char *)noise_protobuf_arena_alloc(pbuf->arena, sz + 1);
+    else
+        *str = (char *)malloc(sz + 1);
+    if (!(*str)) {
         pbuf->error = NOISE_ERROR_NO_MEMORY;
         return pbuf->error;
     }
@@ -1814,7 +2892,9 @@ int noise_protobuf_read_bytes
  * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory to allocate
  * the byte array.
  *
- * The memory is allocated with the system malloc() function.
+ * The memory is allocated with the system malloc() function.  If \a pbuf
+ * was prepared with noise_protobuf_prepare_input_arena(), then no memory
+ * is allocated and \a data will point directly into the input instead.
  *
  * \sa noise_protobuf_read_alloc_string(), noise_protobuf_read_bytes()
  */
@@ -1846,7 +2926,10 @@ int noise_protobuf_read_alloc_bytes
     err = noise_protobuf_read_space(pbuf, sz, &d);
     if (err != NOISE_ERROR_NONE)
         return err;
-    if (sz > 0) {
+    if (pbuf->arena) {
+        /* Zero-copy view into the input data */
+        *data = (void *)d;
+    } else if (sz > 0) {
         if ((*data = malloc(sz)) == 0) {
             pbuf->error = NOISE_ERROR_NO_MEMORY;
             return pbuf->error;
@@ -2055,6 +3138,66 @@ static size_t noise_protobuf_grow_array(size_t max)
     return max;
 }
 
+/**
+ * \brief Allocates zeroed memory for an array of elements.
+ *
+ * \param arena The arena to allocate from, or NULL for the heap.
+ * \param count The number of elements.
+ * \param size The size of each element.
+ *
+ * \return A pointer to the array or NULL if out of memory.
+ */
+static void *noise_protobuf_alloc_array
+    (NoiseProtobufArena *arena, size_t count, size_t size)
+{
+    if (!arena)
+        return calloc(count, size);
+    if (size && count > (((size_t)-1) / size))
+        return 0;
+    return noise_protobuf_arena_alloc(arena, count * size);
+}
+
+/**
+ * \brief Frees memory that was allocated by noise_protobuf_alloc_array().
+ *
+ * \param arena The arena that the memory came from, or NULL for the heap.
+ * \param ptr Points to the memory to free.
+ * \param size The size of the memory in bytes.
+ *
+ * Memory in an arena is reclaimed all at once when the arena is reset,
+ * so nothing is done for individual blocks.
+ */
+static void noise_protobuf_free_array
+    (NoiseProtobufArena *arena, void *ptr, size_t size)
+{
+    if (!arena)
+        noise_protobuf_free_memory(ptr, size);
+}
+
+/**
+ * \brief Internal implementation of noise_protobuf_add_to_array()
+ * and noise_protobuf_read_add_to_array().
+ */
+static int noise_protobuf_append_to_array
+    (NoiseProtobufArena *arena, void **array, size_t *count, size_t *max,
+     const void *value, size_t size)
+{
+    if (*count >= *max) {
+        size_t new_max = noise_protobuf_grow_array(*max);
+        void *new_array = noise_protobuf_alloc_array(arena, new_max, size);
+        if (!new_array)
+            return NOISE_ERROR_NO_MEMORY;
+        if (*count)
+            memcpy(new_array, *array, *count * size);
+        noise_protobuf_free_array(arena, *array, *max * size);
+        *array = new_array;
+        *max = new_max;
+    }
+    memcpy(((uint8_t *)(*array)) + *count * size, value, size);
+    ++(*count);
+    return NOISE_ERROR_NONE;
+}
+
 /**
  * \brief Adds an element to an array of primitive values.
  *
@@ -2074,19 +3217,48 @@ static size_t noise_protobuf_grow_array(size_t max)
 int noise_protobuf_add_to_array
     (void **array, size_t *count, size_t *max, const void *value, size_t size)
 {
-    if (*count >= *max) {
-        size_t new_max = noise_protobuf_grow_array(*max);
-        void *new_array = calloc(new_max, size);
-        if (!new_array)
-            return NOISE_ERROR_NO_MEMORY;
-        if (*count)
-            memcpy(new_array, *array, *count * size);
-        noise_protobuf_free_memory(*array, *max * size);
-        *array = new_array;
-        *max = new_max;
+    return noise_protobuf_append_to_array(0, array, count, max, value, size);
+}
+
+/**
+ * \brief Grows a pair of value and length arrays if they are full.
+ *
+ * \param arena The arena to allocate from, or NULL for the heap.
+ * \param array Points to the array of values.
+ * \param len_array Points to the array of length values.
+ * \param count The current size of the arrays.
+ * \param max Points to the current maximum size of the arrays.
+ *
+ * \return NOISE_ERROR_NONE on success or NOISE_ERROR_NO_MEMORY.
+ */
+static int noise_protobuf_grow_block_array
+    (NoiseProtobufArena *arena, void ***array, size_t **len_array,
+     size_t count, size_t *max)
+{
+    size_t new_max;
+    void **new_array;
+    size_t *new_len_array;
+    if (count < *max)
+        return NOISE_ERROR_NONE;
+    new_max = noise_protobuf_grow_array(*max);
+    new_array = (void **)noise_protobuf_alloc_array
+        (arena, new_max, sizeof(void *));
+    new_len_array = (size_t *)noise_protobuf_alloc_array
+        (arena, new_max, sizeof(size_t));
+    if (!new_array || !new_len_array) {
+        noise_protobuf_free_array(arena, new_array, 0);
+        noise_protobuf_free_array(arena, new_len_array, 0);
+        return NOISE_ERROR_NO_MEMORY;
     }
-    memcpy(((uint8_t *)(*array)) + *count * size, value, size);
-    ++(*count);
+    if (count) {
+        memcpy(new_array, *array, count * sizeof(void *));
+        memcpy(new_len_array, *len_array, count * sizeof(size_t));
+    }
+    noise_protobuf_free_array(arena, *array, *max * sizeof(void *));
+    noise_protobuf_free_array(arena, *len_array, *max * sizeof(size_t));
+    *array = new_array;
+    *len_array = new_len_array;
+    *max = new_max;
     return NOISE_ERROR_NONE;
 }
 
@@ -2099,6 +3271,7 @@ static int noise_protobuf_add_to_block_array
      const void *value, size_t size, int add_nul)
 {
     void *data;
+    int err;
 
     /* Bail out if the value to add is NULL and non-zero in size */
     if (!value && size)
@@ -2114,27 +3287,10 @@ static int noise_protobuf_add_to_block_array
         ((uint8_t *)data)[size] = 0;
 
     /* Grow the size of the array if necessary */
-    if (*count >= *max) {
-        size_t new_max = noise_protobuf_grow_array(*max);
-        void **new_array = (void **)calloc(new_max, sizeof(void *));
-        size_t *new_len_array = (size_t *)calloc(new_max, sizeof(size_t));
-        if (!new_array || !new_len_array) {
-            if (new_array)
-                free(new_array);
-            if (new_len_array)
-                free(new_len_array);
-            noise_protobuf_free_memory(data, size);
-            return NOISE_ERROR_NO_MEMORY;
-        }
-        if (*count) {
-            memcpy(new_array, *array, *count * sizeof(void *));
-            memcpy(new_len_array, *len_array, *count * sizeof(size_t));
-        }
-        noise_protobuf_free_memory(*array, *max * sizeof(void *));
-        noise_protobuf_free_memory(*len_array, *max * sizeof(size_t));
-        *array = new_array;
-        *len_array = new_len_array;
-        *max = new_max;
+    err = noise_protobuf_grow_block_array(0, array, len_array, *count, max);
+    if (err != NOISE_ERROR_NONE) {
+        noise_protobuf_free_memory(data, size);
+        return err;
     }
 
     /* Add the new element to the array */
@@ -2194,6 +3350,103 @@ int noise_protobuf_add_to_bytes_array
         (array, len_array, count, max, value, size, size ? 0 : 1);
 }
 
+/**
+ * \brief Allocates a new zeroed object while reading from a protobuf.
+ *
+ * \param pbuf The protobuf that is being read.
+ * \param size The size of the object in bytes.
+ *
+ * \return A pointer to the new object, or NULL if there is insufficient
+ * memory.  The error in \a pbuf is also set to NOISE_ERROR_NO_MEMORY.
+ *
+ * The object is allocated from the arena if \a pbuf was prepared with
+ * noise_protobuf_prepare_input_arena(), or from the heap otherwise.
+ *
+ * This function is intended as a helper for the output of the
+ * noise-protoc complier.
+ */
+void *noise_protobuf_new_object(NoiseProtobuf *pbuf, size_t size)
+{
+    void *obj = noise_protobuf_alloc_array(pbuf->arena, 1, size);
+    if (!obj)
+        pbuf->error = NOISE_ERROR_NO_MEMORY;
+    return obj;
+}
+
+/**
+ * \brief Adds an element to an array while reading from a protobuf.
+ *
+ * \param pbuf The protobuf that is being read.
+ * \param array Points to the array to add to.
+ * \param count Points to the current size of the array.
+ * \param max Points to the current maximum size of the array.
+ * \param value Points to the value to add.
+ * \param size Size of the elements in the array.
+ *
+ * \return NOISE_ERROR_NONE on success or an error code otherwise.
+ * The error is also recorded in \a pbuf.
+ *
+ * This is the same as noise_protobuf_add_to_array() except that the array
+ * is grown within the arena for \a pbuf if it has one.
+ *
+ * This function is intended as a helper for the output of the
+ * noise-protoc complier.
+ */
+int noise_protobuf_read_add_to_array
+    (NoiseProtobuf *pbuf, void **array, size_t *count, size_t *max,
+     const void *value, size_t size)
+{
+    int err = noise_protobuf_append_to_array
+        (pbuf->arena, array, count, max, value, size);
+    if (err != NOISE_ERROR_NONE && pbuf->error == NOISE_ERROR_NONE)
+        pbuf->error = err;
+    return err;
+}
+
+/**
+ * \brief Adds a string or byte array to an array while reading from
+ * a protobuf.
+ *
+ * \param pbuf The protobuf that is being read.
+ * \param array Points to the array to add to.
+ * \param len_array Points to the array of length values to add to.
+ * \param count Points to the current size of the array.
+ * \param max Points to the current maximum size of the array.
+ * \param value The value that was returned by noise_protobuf_read_alloc_string()
+ * or noise_protobuf_read_alloc_bytes(), or NULL if the read failed.
+ * \param size Size of \a value in bytes.
+ *
+ * \return NOISE_ERROR_NONE on success or an error code otherwise.
+ * The error is also recorded in \a pbuf.
+ *
+ * Unlike noise_protobuf_add_to_string_array(), the array takes ownership
+ * of \a value rather than making a copy.  If the value cannot be added,
+ * then it will be freed.
+ *
+ * This function is intended as a helper for the output of the
+ * noise-protoc complier.
+ */
+int noise_protobuf_read_add_to_block_array
+    (NoiseProtobuf *pbuf, void ***array, size_t **len_array,
+     size_t *count, size_t *max, void *value, size_t size)
+{
+    int err;
+    if (!value)
+        return pbuf->error;
+    err = noise_protobuf_grow_block_array
+        (pbuf->arena, array, len_array, *count, max);
+    if (err != NOISE_ERROR_NONE) {
+        noise_protobuf_free_array(pbuf->arena, value, size);
+        if (pbuf->error == NOISE_ERROR_NONE)
+            pbuf->error = err;
+        return err;
+    }
+    (*array)[*count] = value;
+    (*len_array)[*count] = size;
+    ++(*count);
+    return NOISE_ERROR_NONE;
+}
+
 /**
  * \brief Inserts an item into a dynamically-sized array.
  *
@@ -0,0 +1,1043 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include <noise/protobufs.h>
+#include <string.h>
+#include <stdlib.h>
+
+/**
+ * \file table.c
+ * \brief Table-driven protobuf serialization implementation
+ */
+
+/**
+ * \defgroup protobuf_tables Table-driven Protobufs API
+ *
+ * When <tt>noise-protoc</tt> is run with the <tt>--tables</tt> option,
+ * the generated code describes each message type with a compact
+ * NoiseProtobufMessageDesc table instead of emitting specialized code
+ * for every field.  The functions in this module walk those tables to
+ * construct, destroy, write, read, measure, and encode objects.
+ *
+ * The public accessor API that is generated for each message is the
+ * same in both modes, and the bytes that are produced on the wire are
+ * identical.  The table-driven mode trades a small amount of speed for
+ * a much smaller code footprint when there are many message types.
+ *
+ * These functions are intended as helpers for the output of the
+ * noise-protoc compiler and are not normally called directly.
+ */
+/**@{*/
+
+/**
+ * \brief Gets a pointer to a member of an object at a specific offset.
+ */
+#define noise_protobuf_member(obj, offset) \
+    ((void *)(((uint8_t *)(obj)) + (offset)))
+
+/**
+ * \brief Gets a const pointer to a member of an object at a specific offset.
+ */
+#define noise_protobuf_const_member(obj, offset) \
+    ((const void *)(((const uint8_t *)(obj)) + (offset)))
+
+/**
+ * \brief Gets the size of the C representation of a numeric field type.
+ *
+ * \param type The NOISE_PROTOBUF_TYPE_* code for the field.
+ *
+ * \return The size of the C value in bytes.
+ */
+static size_t noise_protobuf_value_size(int type)
+{
+    switch (type) {
+    case NOISE_PROTOBUF_TYPE_INT32:
+    case NOISE_PROTOBUF_TYPE_UINT32:
+    case NOISE_PROTOBUF_TYPE_SINT32:
+    case NOISE_PROTOBUF_TYPE_FIXED32:
+    case NOISE_PROTOBUF_TYPE_SFIXED32:
+        return sizeof(uint32_t);
+    case NOISE_PROTOBUF_TYPE_INT64:
+    case NOISE_PROTOBUF_TYPE_UINT64:
+    case NOISE_PROTOBUF_TYPE_SINT64:
+    case NOISE_PROTOBUF_TYPE_FIXED64:
+    case NOISE_PROTOBUF_TYPE_SFIXED64:
+        return sizeof(uint64_t);
+    case NOISE_PROTOBUF_TYPE_FLOAT:
+        return sizeof(float);
+    case NOISE_PROTOBUF_TYPE_DOUBLE:
+        return sizeof(double);
+    case NOISE_PROTOBUF_TYPE_BOOL:
+        return sizeof(int);
+    }
+    return sizeof(void *);
+}
+
+/**
+ * \brief Determine if a numeric value is zero and can be omitted.
+ *
+ * \param type The NOISE_PROTOBUF_TYPE_* code for the field.
+ * \param value Points to the C value.
+ *
+ * \return Non-zero if the value is zero.  Floating-point values are
+ * never considered to be zero, which matches the generated code.
+ */
+static int noise_protobuf_value_is_zero(int type, const void *value)
+{
+    switch (type) {
+    case NOISE_PROTOBUF_TYPE_INT32:
+    case NOISE_PROTOBUF_TYPE_UINT32:
+    case NOISE_PROTOBUF_TYPE_SINT32:
+    case NOISE_PROTOBUF_TYPE_FIXED32:
+    case NOISE_PROTOBUF_TYPE_SFIXED32:
+        return *((const uint32_t *)value) == 0;
+    case NOISE_PROTOBUF_TYPE_INT64:
+    case NOISE_PROTOBUF_TYPE_UINT64:
+    case NOISE_PROTOBUF_TYPE_SINT64:
+    case NOISE_PROTOBUF_TYPE_FIXED64:
+    case NOISE_PROTOBUF_TYPE_SFIXED64:
+        return *((const uint64_t *)value) == 0;
+    case NOISE_PROTOBUF_TYPE_BOOL:
+        return *((const int *)value) == 0;
+    }
+    return 0;
+}
+
+/**
+ * \brief Writes a numeric value to a protobuf.
+ *
+ * \param pbuf The protobuf to write to.
+ * \param tag The tag to use, or zero for a packed array member.
+ * \param type The NOISE_PROTOBUF_TYPE_* code for the field.
+ * \param value Points to the C value to write.
+ */
+static void noise_protobuf_write_value
+    (NoiseProtobuf *pbuf, int tag, int type, const void *value)
+{
+    switch (type) {
+    case NOISE_PROTOBUF_TYPE_INT32:
+        noise_protobuf_write_int32(pbuf, tag, *((const int32_t *)value));
+        break;
+    case NOISE_PROTOBUF_TYPE_UINT32:
+        noise_protobuf_write_uint32(pbuf, tag, *((const uint32_t *)value));
+        break;
+    case NOISE_PROTOBUF_TYPE_INT64:
+        noise_protobuf_write_int64(pbuf, tag, *((const int64_t *)value));
+        break;
+    case NOISE_PROTOBUF_TYPE_UINT64:
+        noise_protobuf_write_uint64(pbuf, tag, *((const uint64_t *)value));
+        break;
+    case NOISE_PROTOBUF_TYPE_SINT32:
+        noise_protobuf_write_sint32(pbuf, tag, *((const int32_t *)value));
+        break;
+    case NOISE_PROTOBUF_TYPE_SINT64:
+        noise_protobuf_write_sint64(pbuf, tag, *((const int64_t *)value));
+        break;
+    case NOISE_PROTOBUF_TYPE_FIXED32:
+        noise_protobuf_write_fixed32(pbuf, tag, *((const uint32_t *)value));
+        break;
+    case NOISE_PROTOBUF_TYPE_SFIXED32:
+        noise_protobuf_write_sfixed32(pbuf, tag, *((const int32_t *)value));
+        break;
+    case NOISE_PROTOBUF_TYPE_FIXED64:
+        noise_protobuf_write_fixed64(pbuf, tag, *((const uint64_t *)value));
+        break;
+    case NOISE_PROTOBUF_TYPE_SFIXED64:
+        noise_protobuf_write_sfixed64(pbuf, tag, *((const int64_t *)value));
+        break;
+    case NOISE_PROTOBUF_TYPE_FLOAT:
+        noise_protobuf_write_float(pbuf, tag, *((const float *)value));
+        break;
+    case NOISE_PROTOBUF_TYPE_DOUBLE:
+        noise_protobuf_write_double(pbuf, tag, *((const double *)value));
+        break;
+    case NOISE_PROTOBUF_TYPE_BOOL:
+        noise_protobuf_write_bool(pbuf, tag, *((const int *)value));
+        break;
+    }
+}
+
+/**
+ * \brief Reads a numeric value from a protobuf.
+ *
+ * \param pbuf The protobuf to read from.
+ * \param tag The tag that is expected, or zero for a packed array member.
+ * \param type The NOISE_PROTOBUF_TYPE_* code for the field.
+ * \param value Points to the C value to set.
+ */
+static void noise_protobuf_read_value
+    (NoiseProtobuf *pbuf, int tag, int type, void *value)
+{
+    switch (type) {
+    case NOISE_PROTOBUF_TYPE_INT32:
+        noise_protobuf_read_int32(pbuf, tag, (int32_t *)value);
+        break;
+    case NOISE_PROTOBUF_TYPE_UINT32:
+        noise_protobuf_read_uint32(pbuf, tag, (uint32_t *)value);
+        break;
+    case NOISE_PROTOBUF_TYPE_INT64:
+        noise_protobuf_read_int64(pbuf, tag, (int64_t *)value);
+        break;
+    case NOISE_PROTOBUF_TYPE_UINT64:
+        noise_protobuf_read_uint64(pbuf, tag, (uint64_t *)value);
+        break;
+    case NOISE_PROTOBUF_TYPE_SINT32:
+        noise_protobuf_read_sint32(pbuf, tag, (int32_t *)value);
+        break;
+    case NOISE_PROTOBUF_TYPE_SINT64:
+        noise_protobuf_read_sint64(pbuf, tag, (int64_t *)value);
+        break;
+    case NOISE_PROTOBUF_TYPE_FIXED32:
+        noise_protobuf_read_fixed32(pbuf, tag, (uint32_t *)value);
+        break;
+    case NOISE_PROTOBUF_TYPE_SFIXED32:
+        noise_protobuf_read_sfixed32(pbuf, tag, (int32_t *)value);
+        break;
+    case NOISE_PROTOBUF_TYPE_FIXED64:
+        noise_protobuf_read_fixed64(pbuf, tag, (uint64_t *)value);
+        break;
+    case NOISE_PROTOBUF_TYPE_SFIXED64:
+        noise_protobuf_read_sfixed64(pbuf, tag, (int64_t *)value);
+        break;
+    case NOISE_PROTOBUF_TYPE_FLOAT:
+        noise_protobuf_read_float(pbuf, tag, (float *)value);
+        break;
+    case NOISE_PROTOBUF_TYPE_DOUBLE:
+        noise_protobuf_read_double(pbuf, tag, (double *)value);
+        break;
+    case NOISE_PROTOBUF_TYPE_BOOL:
+        noise_protobuf_read_bool(pbuf, tag, (int *)value);
+        break;
+    }
+}
+
+/**
+ * \brief Measures the encoded size of a numeric value.
+ *
+ * \param tag The tag to use, or zero for a packed array member.
+ * \param type The NOISE_PROTOBUF_TYPE_* code for the field.
+ * \param value Points to the C value to measure.
+ *
+ * \return The number of bytes that the value will occupy.
+ */
+static size_t noise_protobuf_size_value(int tag, int type, const void *value)
+{
+    switch (type) {
+    case NOISE_PROTOBUF_TYPE_INT32:
+        return noise_protobuf_size_int32(tag, *((const int32_t *)value));
+    case NOISE_PROTOBUF_TYPE_UINT32:
+        return noise_protobuf_size_uint32(tag, *((const uint32_t *)value));
+    case NOISE_PROTOBUF_TYPE_INT64:
+        return noise_protobuf_size_int64(tag, *((const int64_t *)value));
+    case NOISE_PROTOBUF_TYPE_UINT64:
+        return noise_protobuf_size_uint64(tag, *((const uint64_t *)value));
+    case NOISE_PROTOBUF_TYPE_SINT32:
+        return noise_protobuf_size_sint32(tag, *((const int32_t *)value));
+    case NOISE_PROTOBUF_TYPE_SINT64:
+        return noise_protobuf_size_sint64(tag, *((const int64_t *)value));
+    case NOISE_PROTOBUF_TYPE_FIXED32:
+        return noise_protobuf_size_fixed32(tag, *((const uint32_t *)value));
+    case NOISE_PROTOBUF_TYPE_SFIXED32:
+        return noise_protobuf_size_sfixed32(tag, *((const int32_t *)value));
+    case NOISE_PROTOBUF_TYPE_FIXED64:
+        return noise_protobuf_size_fixed64(tag, *((const uint64_t *)value));
+    case NOISE_PROTOBUF_TYPE_SFIXED64:
+        return noise_protobuf_size_sfixed64(tag, *((const int64_t *)value));
+    case NOISE_PROTOBUF_TYPE_FLOAT:
+        return noise_protobuf_size_float(tag, *((const float *)value));
+    case NOISE_PROTOBUF_TYPE_DOUBLE:
+        return noise_protobuf_size_double(tag, *((const double *)value));
+    case NOISE_PROTOBUF_TYPE_BOOL:
+        return noise_protobuf_size_bool(tag, *((const int *)value));
+    }
+    return 0;
+}
+
+/**
+ * \brief Encodes a numeric value into a protobuf.
+ *
+ * \param pbuf The protobuf to encode into.
+ * \param tag The tag to use, or zero for a packed array member.
+ * \param type The NOISE_PROTOBUF_TYPE_* code for the field.
+ * \param value Points to the C value to encode.
+ */
+static void noise_protobuf_encode_value
+    (NoiseProtobuf *pbuf, int tag, int type, const void *value)
+{
+    switch (type) {
+    case NOISE_PROTOBUF_TYPE_INT32:
+        noise_protobuf_encode_int32(pbuf, tag, *((const int32_t *)value));
+        break;
+    case NOISE_PROTOBUF_TYPE_UINT32:
+        noise_protobuf_encode_uint32(pbuf, tag, *((const uint32_t *)value));
+        break;
+    case NOISE_PROTOBUF_TYPE_INT64:
+        noise_protobuf_encode_int64(pbuf, tag, *((const int64_t *)value));
+        break;
+    case NOISE_PROTOBUF_TYPE_UINT64:
+        noise_protobuf_encode_uint64(pbuf, tag, *((const uint64_t *)value));
+        break;
+    case NOISE_PROTOBUF_TYPE_SINT32:
+        noise_protobuf_encode_sint32(pbuf, tag, *((const int32_t *)value));
+        break;
+    case NOISE_PROTOBUF_TYPE_SINT64:
+        noise_protobuf_encode_sint64(pbuf, tag, *((const int64_t *)value));
+        break;
+    case NOISE_PROTOBUF_TYPE_FIXED32:
+        noise_protobuf_encode_fixed32(pbuf, tag, *((const uint32_t *)value));
+        break;
+    case NOISE_PROTOBUF_TYPE_SFIXED32:
+        noise_protobuf_encode_sfixed32(pbuf, tag, *((const int32_t *)value));
+        break;
+    case NOISE_PROTOBUF_TYPE_FIXED64:
+        noise_protobuf_encode_fixed64(pbuf, tag, *((const uint64_t *)value));
+        break;
+    case NOISE_PROTOBUF_TYPE_SFIXED64:
+        noise_protobuf_encode_sfixed64(pbuf, tag, *((const int64_t *)value));
+        break;
+    case NOISE_PROTOBUF_TYPE_FLOAT:
+        noise_protobuf_encode_float(pbuf, tag, *((const float *)value));
+        break;
+    case NOISE_PROTOBUF_TYPE_DOUBLE:
+        noise_protobuf_encode_double(pbuf, tag, *((const double *)value));
+        break;
+    case NOISE_PROTOBUF_TYPE_BOOL:
+        noise_protobuf_encode_bool(pbuf, tag, *((const int *)value));
+        break;
+    }
+}
+
+/**
+ * \brief Determine if a field is repeated or packed.
+ */
+#define noise_protobuf_is_array(field) \
+    ((field)->qualifier == NOISE_PROTOBUF_QUAL_REPEATED || \
+     (field)->qualifier == NOISE_PROTOBUF_QUAL_PACKED)
+
+/**
+ * \brief Writes a string or bytes value to a protobuf.
+ *
+ * \param pbuf The protobuf to write to.
+ * \param tag The tag to use.
+ * \param type NOISE_PROTOBUF_TYPE_STRING or NOISE_PROTOBUF_TYPE_BYTES.
+ * \param data Points to the data to write.
+ * \param size The size of the data in bytes.
+ *
+ * Strings are validated as UTF-8 whereas bytes are written as-is.
+ */
+static void noise_protobuf_write_block
+    (NoiseProtobuf *pbuf, int tag, int type, const void *data, size_t size)
+{
+    if (type == NOISE_PROTOBUF_TYPE_STRING)
+        noise_protobuf_write_string(pbuf, tag, (const char *)data, size);
+    else
+        noise_protobuf_write_bytes(pbuf, tag, data, size);
+}
+
+/**
+ * \brief Encodes a string or bytes value into a protobuf.
+ *
+ * \param pbuf The protobuf to encode into.
+ * \param tag The tag to use.
+ * \param type NOISE_PROTOBUF_TYPE_STRING or NOISE_PROTOBUF_TYPE_BYTES.
+ * \param data Points to the data to encode.
+ * \param size The size of the data in bytes.
+ */
+static void noise_protobuf_encode_block
+    (NoiseProtobuf *pbuf, int tag, int type, const void *data, size_t size)
+{
+    if (type == NOISE_PROTOBUF_TYPE_STRING)
+        noise_protobuf_encode_string(pbuf, tag, (const char *)data, size);
+    else
+        noise_protobuf_encode_bytes(pbuf, tag, data, size);
+}
+
+/**
+ * \brief Frees the memory associated with a field, without resetting it.
+ *
+ * \param field The field descriptor.
+ * \param obj The object containing the field.
+ */
+static void noise_protobuf_table_free_field
+    (const NoiseProtobufFieldDesc *field, void *obj)
+{
+    void *value = *((void **)noise_protobuf_member(obj, field->offset));
+    size_t count, max, index;
+    if (noise_protobuf_is_array(field)) {
+        count = *((size_t *)noise_protobuf_member(obj, field->count_offset));
+        max = *((size_t *)noise_protobuf_member(obj, field->max_offset));
+        if (field->type == NOISE_PROTOBUF_TYPE_STRING ||
+                field->type == NOISE_PROTOBUF_TYPE_BYTES) {
+            size_t *sizes =
+                *((size_t **)noise_protobuf_member(obj, field->size_offset));
+            for (index = 0; index < count; ++index)
+                noise_protobuf_free_memory(((void **)value)[index], sizes[index]);
+            noise_protobuf_free_memory(value, max * sizeof(void *));
+            noise_protobuf_free_memory(sizes, max * sizeof(size_t));
+        } else if (field->type == NOISE_PROTOBUF_TYPE_MESSAGE) {
+            for (index = 0; index < count; ++index) {
+                noise_protobuf_table_free
+                    (field->message, ((void **)value)[index]);
+            }
+            noise_protobuf_free_memory(value, max * sizeof(void *));
+        } else {
+            noise_protobuf_free_memory
+                (value, max * noise_protobuf_value_size(field->type));
+        }
+    } else if (field->type == NOISE_PROTOBUF_TYPE_STRING ||
+               field->type == NOISE_PROTOBUF_TYPE_BYTES) {
+        noise_protobuf_free_memory
+            (value, *((size_t *)noise_protobuf_member(obj, field->size_offset)));
+    } else if (field->type == NOISE_PROTOBUF_TYPE_MESSAGE) {
+        noise_protobuf_table_free(field->message, value);
+    }
+}
+
+/**
+ * \brief Resets a field to its default value after freeing it.
+ *
+ * \param field The field descriptor.
+ * \param obj The object containing the field.
+ */
+static void noise_protobuf_table_reset_field
+    (const NoiseProtobufFieldDesc *field, void *obj)
+{
+    if (noise_protobuf_is_array(field)) {
+        *((void **)noise_protobuf_member(obj, field->offset)) = 0;
+        if (field->type == NOISE_PROTOBUF_TYPE_STRING ||
+                field->type == NOISE_PROTOBUF_TYPE_BYTES)
+            *((size_t **)noise_protobuf_member(obj, field->size_offset)) = 0;
+        *((size_t *)noise_protobuf_member(obj, field->count_offset)) = 0;
+        *((size_t *)noise_protobuf_member(obj, field->max_offset)) = 0;
+    } else if (field->type == NOISE_PROTOBUF_TYPE_STRING ||
+               field->type == NOISE_PROTOBUF_TYPE_BYTES) {
+        *((void **)noise_protobuf_member(obj, field->offset)) = 0;
+        *((size_t *)noise_protobuf_member(obj, field->size_offset)) = 0;
+    } else if (field->type == NOISE_PROTOBUF_TYPE_MESSAGE) {
+        *((void **)noise_protobuf_member(obj, field->offset)) = 0;
+    } else {
+        memset(noise_protobuf_member(obj, field->offset), 0,
+               noise_protobuf_value_size(field->type));
+    }
+}
+
+/**
+ * \brief Creates a new object from a message descriptor.
+ *
+ * \param desc The message descriptor.
+ * \param obj Variable that receives the new object.
+ *
+ * \return NOISE_ERROR_NONE on success, NOISE_ERROR_INVALID_PARAM if
+ * \a desc or \a obj is NULL, or NOISE_ERROR_NO_MEMORY if there is
+ * insufficient memory to allocate the object.
+ */
+int noise_protobuf_table_new
+    (const NoiseProtobufMessageDesc *desc, void **obj)
+{
+    if (!obj || !desc)
+        return NOISE_ERROR_INVALID_PARAM;
+    *obj = calloc(1, desc->struct_size);
+    if (!(*obj))
+        return NOISE_ERROR_NO_MEMORY;
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Frees an object and all of its fields using a message descriptor.
+ *
+ * \param desc The message descriptor.
+ * \param obj The object to free.
+ *
+ * \return NOISE_ERROR_NONE on success or NOISE_ERROR_INVALID_PARAM if
+ * \a desc or \a obj is NULL.
+ */
+int noise_protobuf_table_free
+    (const NoiseProtobufMessageDesc *desc, void *obj)
+{
+    size_t index;
+    if (!desc || !obj)
+        return NOISE_ERROR_INVALID_PARAM;
+    for (index = 0; index < desc->num_fields; ++index)
+        noise_protobuf_table_free_field(&(desc->fields[index]), obj);
+    noise_protobuf_free_memory(obj, desc->struct_size);
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Writes a single field to a protobuf in reverse order.
+ *
+ * \param pbuf The protobuf to write to.
+ * \param field The field descriptor.
+ * \param obj The object containing the field.
+ */
+static void noise_protobuf_table_write_field
+    (NoiseProtobuf *pbuf, const NoiseProtobufFieldDesc *field, const void *obj)
+{
+    const void *value = noise_protobuf_const_member(obj, field->offset);
+    int tag = (int)(field->tag);
+    size_t count, index, esize, end;
+    if (noise_protobuf_is_array(field)) {
+        const uint8_t *array = *((const uint8_t * const *)value);
+        count = *((const size_t *)noise_protobuf_const_member
+                    (obj, field->count_offset));
+        if (field->type == NOISE_PROTOBUF_TYPE_STRING ||
+                field->type == NOISE_PROTOBUF_TYPE_BYTES) {
+            const size_t *sizes = *((const size_t * const *)
+                noise_protobuf_const_member(obj, field->size_offset));
+            for (index = count; index > 0; --index) {
+                noise_protobuf_write_block
+                    (pbuf, tag, field->type,
+                     ((const void * const *)array)[index - 1],
+                     sizes[index - 1]);
+            }
+        } else if (field->type == NOISE_PROTOBUF_TYPE_MESSAGE) {
+            for (index = count; index > 0; --index) {
+                noise_protobuf_table_write
+                    (pbuf, tag, field->message,
+                     ((const void * const *)array)[index - 1]);
+            }
+        } else if (field->qualifier == NOISE_PROTOBUF_QUAL_PACKED) {
+            esize = noise_protobuf_value_size(field->type);
+            noise_protobuf_write_end_element(pbuf, &end);
+            for (index = count; index > 0; --index) {
+                noise_protobuf_write_value
+                    (pbuf, 0, field->type, array + (index - 1) * esize);
+            }
+            noise_protobuf_write_start_element(pbuf, tag, end);
+        } else {
+            esize = noise_protobuf_value_size(field->type);
+            for (index = count; index > 0; --index) {
+                noise_protobuf_write_value
+                    (pbuf, tag, field->type, array + (index - 1) * esize);
+            }
+        }
+    } else if (field->type == NOISE_PROTOBUF_TYPE_STRING ||
+               field->type == NOISE_PROTOBUF_TYPE_BYTES) {
+        const void *data = *((const void * const *)value);
+        if (data || field->qualifier == NOISE_PROTOBUF_QUAL_REQUIRED) {
+            noise_protobuf_write_block
+                (pbuf, tag, field->type, data, *((const size_t *)noise_protobuf_const_member
+                                        (obj, field->size_offset)));
+        }
+    } else if (field->type == NOISE_PROTOBUF_TYPE_MESSAGE) {
+        const void *child = *((const void * const *)value);
+        if (child) {
+            noise_protobuf_table_write(pbuf, tag, field->message, child);
+        } else if (field->qualifier == NOISE_PROTOBUF_QUAL_REQUIRED) {
+            /* A NULL required object is written as an empty object */
+            noise_protobuf_write_end_element(pbuf, &end);
+            noise_protobuf_write_start_element(pbuf, tag, end);
+        }
+    } else if (field->qualifier != NOISE_PROTOBUF_QUAL_OPTIONAL ||
+               !noise_protobuf_value_is_zero(field->type, value)) {
+        noise_protobuf_write_value(pbuf, tag, field->type, value);
+    }
+}
+
+/**
+ * \brief Writes an object to a protobuf using a message descriptor.
+ *
+ * \param pbuf The protobuf to write to.
+ * \param tag The tag to use for the object, or zero for the top level.
+ * \param desc The message descriptor.
+ * \param obj The object to write.
+ *
+ * \return NOISE_ERROR_NONE on success or an error code otherwise.
+ */
+int noise_protobuf_table_write
+    (NoiseProtobuf *pbuf, int tag, const NoiseProtobufMessageDesc *desc,
+     const void *obj)
+{
+    size_t end_posn;
+    size_t index;
+    if (!pbuf || !desc || !obj)
+        return NOISE_ERROR_INVALID_PARAM;
+    noise_protobuf_write_end_element(pbuf, &end_posn);
+    for (index = desc->num_fields; index > 0; --index)
+        noise_protobuf_table_write_field(pbuf, &(desc->fields[index - 1]), obj);
+    return noise_protobuf_write_start_element(pbuf, tag, end_posn);
+}
+
+/**
+ * \brief Reads a single field from a protobuf.
+ *
+ * \param pbuf The protobuf to read from.
+ * \param field The field descriptor.
+ * \param obj The object containing the field.
+ */
+static void noise_protobuf_table_read_field
+    (NoiseProtobuf *pbuf, const NoiseProtobufFieldDesc *field, void *obj)
+{
+    void *member = noise_protobuf_member(obj, field->offset);
+    int tag = (int)(field->tag);
+    if (field->type == NOISE_PROTOBUF_TYPE_STRING ||
+            field->type == NOISE_PROTOBUF_TYPE_BYTES) {
+        size_t *size =
+            (size_t *)noise_protobuf_member(obj, field->size_offset);
+        if (noise_protobuf_is_array(field)) {
+            void *value = 0;
+            size_t len = 0;
+            if (field->type == NOISE_PROTOBUF_TYPE_STRING)
+                noise_protobuf_read_alloc_string(pbuf, tag, (char **)&value, 0, &len);
+            else
+                noise_protobuf_read_alloc_bytes(pbuf, tag, &value, 0, &len);
+            noise_protobuf_read_add_to_block_array
+                (pbuf, (void ***)member, (size_t **)size,
+                 (size_t *)noise_protobuf_member(obj, field->count_offset),
+                 (size_t *)noise_protobuf_member(obj, field->max_offset),
+                 value, len);
+        } else {
+            if (!pbuf->arena)
+                noise_protobuf_free_memory(*((void **)member), *size);
+            *((void **)member) = 0;
+            *size = 0;
+            if (field->type == NOISE_PROTOBUF_TYPE_STRING)
+                noise_protobuf_read_alloc_string(pbuf, tag, (char **)member, 0, size);
+            else
+                noise_protobuf_read_alloc_bytes(pbuf, tag, (void **)member, 0, size);
+        }
+    } else if (field->type == NOISE_PROTOBUF_TYPE_MESSAGE) {
+        if (noise_protobuf_is_array(field)) {
+            void *value = 0;
+            noise_protobuf_table_read(pbuf, tag, field->message, &value);
+            noise_protobuf_read_add_to_array
+                (pbuf, (void **)member,
+                 (size_t *)noise_protobuf_member(obj, field->count_offset),
+                 (size_t *)noise_protobuf_member(obj, field->max_offset),
+                 &value, sizeof(value));
+        } else {
+            if (!pbuf->arena)
+                noise_protobuf_table_free(field->message, *((void **)member));
+            *((void **)member) = 0;
+            noise_protobuf_table_read(pbuf, tag, field->message, (void **)member);
+        }
+    } else if (noise_protobuf_is_array(field)) {
+        size_t *count =
+            (size_t *)noise_protobuf_member(obj, field->count_offset);
+        size_t *max = (size_t *)noise_protobuf_member(obj, field->max_offset);
+        size_t esize = noise_protobuf_value_size(field->type);
+        size_t end_packed = 0;
+        uint64_t value;
+        if (field->qualifier == NOISE_PROTOBUF_QUAL_PACKED) {
+            noise_protobuf_read_start_element(pbuf, tag, &end_packed);
+            while (!noise_protobuf_read_at_end_element(pbuf, end_packed)) {
+                value = 0;
+                noise_protobuf_read_value(pbuf, 0, field->type, &value);
+                noise_protobuf_read_add_to_array
+                    (pbuf, (void **)member, count, max, &value, esize);
+            }
+            noise_protobuf_read_end_element(pbuf, end_packed);
+        } else {
+            value = 0;
+            noise_protobuf_read_value(pbuf, tag, field->type, &value);
+            noise_protobuf_read_add_to_array
+                (pbuf, (void **)member, count, max, &value, esize);
+        }
+    } else {
+        noise_protobuf_read_value(pbuf, tag, field->type, member);
+    }
+}
+
+/**
+ * \brief Reads an object from a protobuf using a message descriptor.
+ *
+ * \param pbuf The protobuf to read from.
+ * \param tag The tag to expect for the object, or zero for the top level.
+ * \param desc The message descriptor.
+ * \param obj Variable that receives the new object.
+ *
+ * \return NOISE_ERROR_NONE on success or an error code otherwise.
+ *
+ * Fields are looked up by tag, starting just after the previously
+ * matched field so that fields in the usual tag order are found with
+ * a single comparison.  Unknown fields are skipped.
+ */
+int noise_protobuf_table_read
+    (NoiseProtobuf *pbuf, int tag, const NoiseProtobufMessageDesc *desc,
+     void **obj)
+{
+    const NoiseProtobufFieldDesc *field;
+    size_t end_posn;
+    size_t next = 0;
+    size_t index;
+    uint32_t field_tag;
+    int err;
+    if (!obj)
+        return NOISE_ERROR_INVALID_PARAM;
+    *obj = 0;
+    if (!pbuf || !desc)
+        return NOISE_ERROR_INVALID_PARAM;
+    *obj = noise_protobuf_new_object(pbuf, desc->struct_size);
+    if (!(*obj))
+        return NOISE_ERROR_NO_MEMORY;
+    noise_protobuf_read_start_element(pbuf, tag, &end_posn);
+    while (!noise_protobuf_read_at_end_element(pbuf, end_posn)) {
+        field_tag = (uint32_t)noise_protobuf_peek_tag(pbuf);
+        field = 0;
+        for (index = next; index < desc->num_fields; ++index) {
+            if (desc->fields[index].tag == field_tag) {
+                field = &(desc->fields[index]);
+                break;
+            }
+        }
+        if (!field) {
+            for (index = 0; index < next; ++index) {
+                if (desc->fields[index].tag == field_tag) {
+                    field = &(desc->fields[index]);
+                    break;
+                }
+            }
+        }
+        if (field_tag && field) {
+            noise_protobuf_table_read_field(pbuf, field, *obj);
+            next = index + 1;
+            if (next >= desc->num_fields)
+                next = 0;
+        } else {
+            noise_protobuf_read_skip(pbuf);
+        }
+    }
+    err = noise_protobuf_read_end_element(pbuf, end_posn);
+    if (err != NOISE_ERROR_NONE) {
+        if (!pbuf->arena)
+            noise_protobuf_table_free(desc, *obj);
+        *obj = 0;
+    }
+    return err;
+}
+
+/**
+ * \brief Measures the encoded size of an object using a message descriptor.
+ *
+ * \param tag The tag to use for the object, or zero for the top level.
+ * \param desc The message descriptor.
+ * \param obj The object to measure.
+ *
+ * \return The number of bytes that the object will occupy, or zero if
+ * \a desc or \a obj is NULL.
+ *
+ * The size of the message body is cached in the object so that
+ * noise_protobuf_table_encode() can write the length prefix before
+ * the fields.  The object is modified even though it is const, so it
+ * must not be measured or encoded by two threads at once.
+ */
+size_t noise_protobuf_table_measure
+    (int tag, const NoiseProtobufMessageDesc *desc, const void *obj)
+{
+    const NoiseProtobufFieldDesc *field;
+    const void *value;
+    size_t size = 0;
+    size_t packed, count, index, esize, field_index;
+    int field_tag;
+    if (!desc || !obj)
+        return 0;
+    for (field_index = 0; field_index < desc->num_fields; ++field_index) {
+        field = &(desc->fields[field_index]);
+        field_tag = (int)(field->tag);
+        value = noise_protobuf_const_member(obj, field->offset);
+        if (noise_protobuf_is_array(field)) {
+            const uint8_t *array = *((const uint8_t * const *)value);
+            count = *((const size_t *)noise_protobuf_const_member
+                        (obj, field->count_offset));
+            if (field->type == NOISE_PROTOBUF_TYPE_STRING ||
+                    field->type == NOISE_PROTOBUF_TYPE_BYTES) {
+                const size_t *sizes = *((const size_t * const *)
+                    noise_protobuf_const_member(obj, field->size_offset));
+                for (index = 0; index < count; ++index)
+                    size += noise_protobuf_size_bytes(field_tag, sizes[index]);
+            } else if (field->type == NOISE_PROTOBUF_TYPE_MESSAGE) {
+                for (index = 0; index < count; ++index) {
+                    size += noise_protobuf_table_measure
+                        (field_tag, field->message,
+                         ((const void * const *)array)[index]);
+                }
+            } else if (field->qualifier == NOISE_PROTOBUF_QUAL_PACKED) {
+                esize = noise_protobuf_value_size(field->type);
+                packed = 0;
+                for (index = 0; index < count; ++index) {
+                    packed += noise_protobuf_size_value
+                        (0, field->type, array + index * esize);
+                }
+                size += noise_protobuf_size_element(field_tag, packed);
+            } else {
+                esize = noise_protobuf_value_size(field->type);
+                for (index = 0; index < count; ++index) {
+                    size += noise_protobuf_size_value
+                        (field_tag, field->type, array + index * esize);
+                }
+            }
+        } else if (field->type == NOISE_PROTOBUF_TYPE_STRING ||
+                   field->type == NOISE_PROTOBUF_TYPE_BYTES) {
+            if (*((const void * const *)value) ||
+                    field->qualifier == NOISE_PROTOBUF_QUAL_REQUIRED) {
+                size += noise_protobuf_size_bytes
+                    (field_tag, *((const size_t *)noise_protobuf_const_member
+                                    (obj, field->size_offset)));
+            }
+        } else if (field->type == NOISE_PROTOBUF_TYPE_MESSAGE) {
+            const void *child = *((const void * const *)value);
+            if (child) {
+                size += noise_protobuf_table_measure
+                    (field_tag, field->message, child);
+            } else if (field->qualifier == NOISE_PROTOBUF_QUAL_REQUIRED) {
+                size += noise_protobuf_size_element(field_tag, 0);
+            }
+        } else if (field->qualifier != NOISE_PROTOBUF_QUAL_OPTIONAL ||
+                   !noise_protobuf_value_is_zero(field->type, value)) {
+            size += noise_protobuf_size_value(field_tag, field->type, value);
+        }
+    }
+    noise_protobuf_store_size_cache
+        ((const size_t *)noise_protobuf_const_member(obj, desc->cache_offset),
+         size);
+    return noise_protobuf_size_element(tag, size);
+}
+
+/**
+ * \brief Encodes a single field into a protobuf in forward order.
+ *
+ * \param pbuf The protobuf to encode into.
+ * \param field The field descriptor.
+ * \param obj The object containing the field.
+ */
+static void noise_protobuf_table_encode_field
+    (NoiseProtobuf *pbuf, const NoiseProtobufFieldDesc *field, const void *obj)
+{
+    const void *value = noise_protobuf_const_member(obj, field->offset);
+    int tag = (int)(field->tag);
+    size_t count, index, esize, packed;
+    if (noise_protobuf_is_array(field)) {
+        const uint8_t *array = *((const uint8_t * const *)value);
+        count = *((const size_t *)noise_protobuf_const_member
+                    (obj, field->count_offset));
+        if (field->type == NOISE_PROTOBUF_TYPE_STRING ||
+                field->type == NOISE_PROTOBUF_TYPE_BYTES) {
+            const size_t *sizes = *((const size_t * const *)
+                noise_protobuf_const_member(obj, field->size_offset));
+            for (index = 0; index < count; ++index) {
+                noise_protobuf_encode_block
+                    (pbuf, tag, field->type,
+                     ((const void * const *)array)[index],
+                     sizes[index]);
+            }
+        } else if (field->type == NOISE_PROTOBUF_TYPE_MESSAGE) {
+            for (index = 0; index < count; ++index) {
+                noise_protobuf_table_encode
+                    (pbuf, tag, field->message,
+                     ((const void * const *)array)[index]);
+            }
+        } else if (field->qualifier == NOISE_PROTOBUF_QUAL_PACKED) {
+            esize = noise_protobuf_value_size(field->type);
+            packed = 0;
+            for (index = 0; index < count; ++index) {
+                packed += noise_protobuf_size_value
+                    (0, field->type, array + index * esize);
+            }
+            noise_protobuf_encode_start_element(pbuf, tag, packed);
+            for (index = 0; index < count; ++index) {
+                noise_protobuf_encode_value
+                    (pbuf, 0, field->type, array + index * esize);
+            }
+        } else {
+            esize = noise_protobuf_value_size(field->type);
+            for (index = 0; index < count; ++index) {
+                noise_protobuf_encode_value
+                    (pbuf, tag, field->type, array + index * esize);
+            }
+        }
+    } else if (field->type == NOISE_PROTOBUF_TYPE_STRING ||
+               field->type == NOISE_PROTOBUF_TYPE_BYTES) {
+        const void *data = *((const void * const *)value);
+        if (data || field->qualifier == NOISE_PROTOBUF_QUAL_REQUIRED) {
+            noise_protobuf_encode_block
+                (pbuf, tag, field->type, data, *((const size_t *)noise_protobuf_const_member
+                                        (obj, field->size_offset)));
+        }
+    } else if (field->type == NOISE_PROTOBUF_TYPE_MESSAGE) {
+        const void *child = *((const void * const *)value);
+        if (child)
+            noise_protobuf_table_encode(pbuf, tag, field->message, child);
+        else if (field->qualifier == NOISE_PROTOBUF_QUAL_REQUIRED)
+            noise_protobuf_encode_start_element(pbuf, tag, 0);
+    } else if (field->qualifier != NOISE_PROTOBUF_QUAL_OPTIONAL ||
+               !noise_protobuf_value_is_zero(field->type, value)) {
+        noise_protobuf_encode_value(pbuf, tag, field->type, value);
+    }
+}
+
+/**
+ * \brief Encodes an object into a protobuf using a message descriptor.
+ *
+ * \param pbuf The protobuf to encode into.
+ * \param tag The tag to use for the object, or zero for the top level.
+ * \param desc The message descriptor.
+ * \param obj The object to encode.
+ *
+ * \return NOISE_ERROR_NONE on success or an error code otherwise.
+ *
+ * The object must have been measured with noise_protobuf_table_measure()
+ * immediately beforehand so that the cached body sizes are up to date.
+ */
+int noise_protobuf_table_encode
+    (NoiseProtobuf *pbuf, int tag, const NoiseProtobufMessageDesc *desc,
+     const void *obj)
+{
+    size_t index;
+    if (!pbuf || !desc || !obj)
+        return NOISE_ERROR_INVALID_PARAM;
+    noise_protobuf_encode_start_element
+        (pbuf, tag, noise_protobuf_load_size_cache
+                        ((const size_t *)noise_protobuf_const_member
+                            (obj, desc->cache_offset)));
+    for (index = 0; index < desc->num_fields; ++index)
+        noise_protobuf_table_encode_field(pbuf, &(desc->fields[index]), obj);
+    return pbuf->error;
+}
+
+/**
+ * \brief Clears a field in an object back to its default value.
+ *
+ * \param field The field descriptor.
+ * \param obj The object containing the field.
+ *
+ * \return NOISE_ERROR_NONE on success or NOISE_ERROR_INVALID_PARAM if
+ * \a field or \a obj is NULL.
+ */
+int noise_protobuf_table_clear_field
+    (const NoiseProtobufFieldDesc *field, void *obj)
+{
+    if (field && obj) {
+        noise_protobuf_table_free_field(field, obj);
+        noise_protobuf_table_reset_field(field, obj);
+        return NOISE_ERROR_NONE;
+    }
+    return NOISE_ERROR_INVALID_PARAM;
+}
+
+/**
+ * \brief Sets the value of a non-repeated string or bytes field.
+ *
+ * \param field The field descriptor.
+ * \param obj The object containing the field.
+ * \param value Points to the new value.
+ * \param size The size of the new value in bytes.
+ *
+ * \return NOISE_ERROR_NONE on success, NOISE_ERROR_INVALID_PARAM if
+ * \a field or \a obj is NULL, or NOISE_ERROR_NO_MEMORY if there is
+ * insufficient memory to copy the value.
+ *
+ * String values are always stored with a terminating NUL.
+ */
+int noise_protobuf_table_set_field
+    (const NoiseProtobufFieldDesc *field, void *obj,
+     const void *value, size_t size)
+{
+    uint8_t **member;
+    size_t *member_size;
+    if (!field || !obj)
+        return NOISE_ERROR_INVALID_PARAM;
+    member = (uint8_t **)noise_protobuf_member(obj, field->offset);
+    member_size = (size_t *)noise_protobuf_member(obj, field->size_offset);
+    noise_protobuf_free_memory(*member, *member_size);
+    if (field->type == NOISE_PROTOBUF_TYPE_STRING)
+        *member = (uint8_t *)malloc(size + 1);
+    else
+        *member = (uint8_t *)malloc(size ? size : 1);
+    if (!(*member)) {
+        *member_size = 0;
+        return NOISE_ERROR_NO_MEMORY;
+    }
+    memcpy(*member, value, size);
+    if (field->type == NOISE_PROTOBUF_TYPE_STRING)
+        (*member)[size] = 0;
+    *member_size = size;
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Replaces a non-repeated message field with a new empty object.
+ *
+ * \param field The field descriptor.
+ * \param obj The object containing the field.
+ * \param value Variable that receives the new object.
+ *
+ * \return NOISE_ERROR_NONE on success, NOISE_ERROR_INVALID_PARAM if
+ * a parameter is NULL, or NOISE_ERROR_NO_MEMORY if there is insufficient
+ * memory to allocate the new object.
+ */
+int noise_protobuf_table_get_new_field
+    (const NoiseProtobufFieldDesc *field, void *obj, void **value)
+{
+    void **member;
+    int err;
+    if (!value)
+        return NOISE_ERROR_INVALID_PARAM;
+    *value = 0;
+    if (!field || !obj)
+        return NOISE_ERROR_INVALID_PARAM;
+    err = noise_protobuf_table_new(field->message, value);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    member = (void **)noise_protobuf_member(obj, field->offset);
+    noise_protobuf_table_free(field->message, *member);
+    *member = *value;
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Adds a new empty object to the end of a repeated message field.
+ *
+ * \param field The field descriptor.
+ * \param obj The object containing the field.
+ * \param value Variable that receives the new object.
+ *
+ * \return NOISE_ERROR_NONE on success, NOISE_ERROR_INVALID_PARAM if
+ * a parameter is NULL, or NOISE_ERROR_NO_MEMORY if there is insufficient
+ * memory to allocate the new object.
+ */
+int noise_protobuf_table_add_field
+    (const NoiseProtobufFieldDesc *field, void *obj, void **value)
+{
+    int err;
+    if (!value)
+        return NOISE_ERROR_INVALID_PARAM;
+    *value = 0;
+    if (!field || !obj)
+        return NOISE_ERROR_INVALID_PARAM;
+    err = noise_protobuf_table_new(field->message, value);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_protobuf_add_to_array
+        ((void **)noise_protobuf_member(obj, field->offset),
+         (size_t *)noise_protobuf_member(obj, field->count_offset),
+         (size_t *)noise_protobuf_member(obj, field->max_offset),
+         value, sizeof(*value));
+    if (err != NOISE_ERROR_NONE) {
+        noise_protobuf_table_free(field->message, *value);
+        *value = 0;
+        return err;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+/**@}*/
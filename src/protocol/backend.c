@@ -0,0 +1,884 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "internal.h"
+#include <stdlib.h>
+#include <string.h>
+#if (defined(__GNUC__) || defined(__clang__)) && \
+        (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define NOISE_HAVE_CPUID 1
+#endif
+#if defined(HAVE_LIBPTHREAD)
+#include <pthread.h>
+#endif
+
+/**
+ * \file backend.h
+ * \brief Backend registry interface
+ */
+
+/**
+ * \file backend.c
+ * \brief Backend registry implementation
+ */
+
+/**
+ * \defgroup backend Backend Registry API
+ *
+ * Each algorithm may have several implementations registered; for example
+ * a portable reference version and versions that use SSE2, AVX2, AES-NI,
+ * or SHA-NI instructions.  The first time that an object is created,
+ * the registry queries the CPU and selects the fastest implementation
+ * that the CPU supports for each algorithm.  This allows a single binary
+ * to run on a heterogeneous collection of machines.
+ *
+ * The selection can be overridden with noise_backend_select() or with
+ * the <tt>NOISE_BACKEND</tt> environment variable.  The variable
+ * contains a comma-separated list of entries.  An entry of the form
+ * <tt>Algorithm=name</tt> selects the named implementation for one
+ * algorithm; e.g. <tt>BLAKE2s=ref</tt>.  An entry consisting of just
+ * a name selects that implementation for every algorithm that has it;
+ * e.g. <tt>NOISE_BACKEND=ref</tt> forces the reference implementations.
+ *
+ * If self-checking is enabled with noise_backend_set_self_check() or by
+ * setting the <tt>NOISE_BACKEND_SELF_CHECK</tt> environment variable to
+ * a non-empty value other than "0", then the first use of an alternative
+ * implementation compares its output against the reference
+ * implementation.  If the results differ, then the registry falls back
+ * to the reference implementation for that algorithm.
+ */
+/**@{*/
+
+/** @cond */
+
+/* Helper macros for declaring the registry entries */
+#define CIPHER(id, name, features, func) \
+    {(id), (name), (features), (func), 0, 0, 0}
+#define HASH(id, name, features, func) \
+    {(id), (name), (features), 0, (func), 0, 0}
+#define DH(id, name, features, func) \
+    {(id), (name), (features), 0, 0, (func), 0}
+#define SIGN(id, name, features, func) \
+    {(id), (name), (features), 0, 0, 0, (func)}
+
+/* Registered implementations for each algorithm, in order of preference.
+   The "ref" implementation must be last for each algorithm because it
+   is the fallback when nothing else is supported by the CPU.  Single-suite
+   builds only include the algorithms for Noise_XX_25519_ChaChaPoly_BLAKE2s
+   plus Ed25519, which is needed by the certificate code. */
+static NoiseBackend const noise_backends[] = {
+#if NOISE_HAVE_X86_BACKENDS
+    HASH(NOISE_HASH_BLAKE2s,        "avx2", NOISE_CPU_AVX2, noise_blake2s_avx2_new),
+    HASH(NOISE_HASH_BLAKE2b,        "avx2", NOISE_CPU_AVX2, noise_blake2b_avx2_new),
+    HASH(NOISE_HASH_SHA256,         "shani", NOISE_CPU_SHANI | NOISE_CPU_SSE41,
+         noise_sha256_shani_new),
+    HASH(NOISE_HASH_SHA256,         "avx2", NOISE_CPU_AVX2, noise_sha256_avx2_new),
+    HASH(NOISE_HASH_SHA512,         "avx2", NOISE_CPU_AVX2, noise_sha512_avx2_new),
+    DH(NOISE_DH_NEWHOPE,            "avx2", NOISE_CPU_AVX2, noise_newhope_avx2_new),
+#endif
+    CIPHER(NOISE_CIPHER_CHACHAPOLY, "ref", 0, noise_chachapoly_new),
+    HASH(NOISE_HASH_BLAKE2s,        "ref", 0, noise_blake2s_new),
+    DH(NOISE_DH_CURVE25519,         "ref", 0, noise_curve25519_new),
+    SIGN(NOISE_SIGN_ED25519,        "ref", 0, noise_ed25519_new),
+#if !defined(NOISE_SINGLE_SUITE)
+    CIPHER(NOISE_CIPHER_AESGCM,     "bitsliced", 0, noise_aesgcm_bitsliced_new),
+    CIPHER(NOISE_CIPHER_AESGCM,     "ref", 0, noise_aesgcm_new),
+    HASH(NOISE_HASH_BLAKE2b,        "ref", 0, noise_blake2b_new),
+    HASH(NOISE_HASH_SHA256,         "ref", 0, noise_sha256_new),
+    HASH(NOISE_HASH_SHA512,         "ref", 0, noise_sha512_new),
+    DH(NOISE_DH_CURVE448,           "ref", 0, noise_curve448_new),
+    DH(NOISE_DH_NEWHOPE,            "ref", 0, noise_newhope_new),
+    DH(NOISE_DH_MLKEM768,           "ref", 0, noise_mlkem768_new),
+#endif
+};
+#define NOISE_NUM_BACKENDS (sizeof(noise_backends) / sizeof(noise_backends[0]))
+
+/* Name of the reference implementation for all algorithms */
+#define NOISE_BACKEND_REF "ref"
+
+/* Current selection for each algorithm.  The "active" and "checked" fields
+   are only accessed with the atomic helpers below.  "checked" points to the
+   last implementation that passed the self-check, so that a new selection
+   is always checked again without having to update both fields at once */
+typedef struct
+{
+    int id;
+    const NoiseBackend *active;
+    const NoiseBackend *checked;
+
+} NoiseBackendSelection;
+static NoiseBackendSelection noise_selections[] = {
+    {NOISE_CIPHER_CHACHAPOLY, 0, 0},
+    {NOISE_HASH_BLAKE2s, 0, 0},
+    {NOISE_DH_CURVE25519, 0, 0},
+    {NOISE_SIGN_ED25519, 0, 0},
+#if !defined(NOISE_SINGLE_SUITE)
+    {NOISE_CIPHER_AESGCM, 0, 0},
+    {NOISE_HASH_BLAKE2b, 0, 0},
+    {NOISE_HASH_SHA256, 0, 0},
+    {NOISE_HASH_SHA512, 0, 0},
+    {NOISE_DH_CURVE448, 0, 0},
+    {NOISE_DH_NEWHOPE, 0, 0},
+    {NOISE_DH_MLKEM768, 0, 0},
+#endif
+};
+#define NOISE_NUM_SELECTIONS \
+    (sizeof(noise_selections) / sizeof(noise_selections[0]))
+
+/* Global state for the registry.  Initialization runs exactly once and
+   other threads wait for it to finish.  After that, the selections and the
+   self-check flag are read and written with atomic operations */
+#if defined(HAVE_LIBPTHREAD)
+static pthread_once_t noise_backend_once = PTHREAD_ONCE_INIT;
+#else
+static int noise_backend_initialized = 0;
+#endif
+static int noise_cpu_features = 0;
+static int noise_self_check = 0;
+
+#if defined(__ATOMIC_ACQUIRE) && defined(__ATOMIC_RELEASE)
+#define noise_backend_load(ptr)  __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define noise_backend_store(ptr, value) \
+    __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+#define noise_backend_replace(ptr, expected, value) \
+    __atomic_compare_exchange_n((ptr), (expected), (value), 0, \
+                                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#else
+#define noise_backend_load(ptr)  (*(ptr))
+#define noise_backend_store(ptr, value) (*(ptr) = (value))
+#define noise_backend_replace(ptr, expected, value) \
+    (*(ptr) == *(expected) ? (*(ptr) = (value), 1) \
+                           : (*(expected) = *(ptr), 0))
+#endif
+
+/**
+ * \brief Detects the features of the CPU that we are running on.
+ *
+ * \return A bitmask of NOISE_CPU_* values.
+ */
+static int noise_backend_detect_cpu(void)
+{
+    int features = 0;
+#if defined(NOISE_HAVE_CPUID)
+    unsigned int eax, ebx, ecx, edx;
+    unsigned int xcr0_lo = 0, xcr0_hi = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return 0;
+    if (edx & (1 << 26))
+        features |= NOISE_CPU_SSE2;
+    if (ecx & (1 << 9))
+        features |= NOISE_CPU_SSSE3;
+    if (ecx & (1 << 19))
+        features |= NOISE_CPU_SSE41;
+    if (ecx & (1 << 25))
+        features |= NOISE_CPU_AESNI;
+    if (ecx & (1 << 1))
+        features |= NOISE_CPU_PCLMUL;
+
+    /* AVX needs the OS to save the YMM registers across context switches */
+    if ((ecx & (1 << 27)) && (ecx & (1 << 28))) {
+        __asm__ __volatile__ ("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+        if ((xcr0_lo & 0x06) == 0x06)
+            features |= NOISE_CPU_AVX;
+    }
+    if (__get_cpuid_max(0, 0) >= 7) {
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        if ((ebx & (1 << 5)) && (features & NOISE_CPU_AVX))
+            features |= NOISE_CPU_AVX2;
+        if (ebx & (1 << 29))
+            features |= NOISE_CPU_SHANI;
+    }
+#endif
+    return features;
+}
+
+/**
+ * \brief Finds the selection record for an algorithm.
+ *
+ * \param id The algorithm identifier.
+ *
+ * \return A pointer to the selection or NULL if \a id is unknown.
+ */
+static NoiseBackendSelection *noise_backend_find_selection(int id)
+{
+    size_t index;
+    for (index = 0; index < NOISE_NUM_SELECTIONS; ++index) {
+        if (noise_selections[index].id == id)
+            return &(noise_selections[index]);
+    }
+    return 0;
+}
+
+/**
+ * \brief Finds a named implementation of an algorithm.
+ *
+ * \param id The algorithm identifier.
+ * \param name Points to the name of the implementation.
+ * \param len The length of the name.
+ *
+ * \return A pointer to the implementation or NULL if not found.
+ */
+static const NoiseBackend *noise_backend_find
+    (int id, const char *name, size_t len)
+{
+    size_t index;
+    for (index = 0; index < NOISE_NUM_BACKENDS; ++index) {
+        if (noise_backends[index].id == id &&
+                strlen(noise_backends[index].name) == len &&
+                !memcmp(noise_backends[index].name, name, len))
+            return &(noise_backends[index]);
+    }
+    return 0;
+}
+
+/**
+ * \brief Determines if the CPU supports an implementation.
+ *
+ * \param backend The implementation.
+ *
+ * \return Non-zero if supported, zero if not.
+ */
+static int noise_backend_supported(const NoiseBackend *backend)
+{
+    return (backend->cpu_features & noise_cpu_features) ==
+                backend->cpu_features;
+}
+
+/**
+ * \brief Finds the fastest supported implementation of an algorithm.
+ *
+ * \param id The algorithm identifier.
+ *
+ * \return A pointer to the implementation or NULL if none is supported.
+ */
+static const NoiseBackend *noise_backend_choose_auto(int id)
+{
+    size_t index;
+    for (index = 0; index < NOISE_NUM_BACKENDS; ++index) {
+        if (noise_backends[index].id == id &&
+                noise_backend_supported(&(noise_backends[index])))
+            return &(noise_backends[index]);
+    }
+    return 0;
+}
+
+/**
+ * \brief Applies one entry from the NOISE_BACKEND environment variable.
+ *
+ * \param chosen The implementations that have been chosen so far,
+ * indexed in the same order as the selection records.
+ * \param entry Points to the entry.
+ * \param len Length of the entry.
+ */
+static void noise_backend_apply_entry
+    (const NoiseBackend **chosen, const char *entry, size_t len)
+{
+    const char *equals = memchr(entry, '=', len);
+    const NoiseBackend *backend;
+    size_t index;
+    int id;
+
+    if (equals) {
+        /* "Algorithm=name" applies to a single algorithm */
+        id = noise_name_to_id(0, entry, equals - entry);
+        ++equals;
+        len -= equals - entry;
+        entry = equals;
+        backend = noise_backend_find(id, entry, len);
+        if (backend && noise_backend_supported(backend))
+            chosen[noise_backend_find_selection(id) - noise_selections] =
+                backend;
+    } else {
+        /* "name" applies to all algorithms that have that implementation */
+        for (index = 0; index < NOISE_NUM_SELECTIONS; ++index) {
+            backend = noise_backend_find
+                (noise_selections[index].id, entry, len);
+            if (backend && noise_backend_supported(backend))
+                chosen[index] = backend;
+        }
+    }
+}
+
+/**
+ * \brief Computes the initial selections and publishes them.
+ *
+ * The selections are computed in a local array and then published with
+ * one store per algorithm, so that a concurrent lookup never sees an
+ * algorithm without an implementation or with an overridden one.
+ */
+static void noise_backend_do_init(void)
+{
+    const NoiseBackend *chosen[NOISE_NUM_SELECTIONS];
+    const char *env;
+    const char *end;
+    size_t index;
+
+    /* Select the fastest implementations that the CPU supports */
+    noise_cpu_features = noise_backend_detect_cpu();
+    for (index = 0; index < NOISE_NUM_SELECTIONS; ++index)
+        chosen[index] = noise_backend_choose_auto(noise_selections[index].id);
+
+    /* Apply the overrides from the environment */
+    env = getenv("NOISE_BACKEND");
+    while (env && *env != '\0') {
+        end = strchr(env, ',');
+        if (!end)
+            end = env + strlen(env);
+        if (end > env)
+            noise_backend_apply_entry(chosen, env, end - env);
+        env = (*end == ',') ? end + 1 : end;
+    }
+    env = getenv("NOISE_BACKEND_SELF_CHECK");
+    if (env && *env != '\0' && strcmp(env, "0") != 0)
+        noise_backend_store(&noise_self_check, 1);
+
+    /* Publish the selections */
+    for (index = 0; index < NOISE_NUM_SELECTIONS; ++index)
+        noise_backend_store(&(noise_selections[index].active), chosen[index]);
+}
+
+/**
+ * \brief Initializes the registry the first time that it is used.
+ *
+ * If several threads call this at once, one of them performs the
+ * initialization and the others wait for it to finish.
+ */
+static void noise_backend_init(void)
+{
+#if defined(HAVE_LIBPTHREAD)
+    pthread_once(&noise_backend_once, noise_backend_do_init);
+#else
+    if (!noise_backend_initialized) {
+        noise_backend_do_init();
+        noise_backend_initialized = 1;
+    }
+#endif
+}
+
+/* Fixed input data for the self-checks */
+static uint8_t const noise_check_data[] = {
+    0x54, 0x68, 0x65, 0x20, 0x71, 0x75, 0x69, 0x63,
+    0x6b, 0x20, 0x62, 0x72, 0x6f, 0x77, 0x6e, 0x20,
+    0x66, 0x6f, 0x78, 0x20, 0x6a, 0x75, 0x6d, 0x70,
+    0x73, 0x20, 0x6f, 0x76, 0x65, 0x72, 0x20, 0x74,
+    0x68, 0x65, 0x20, 0x6c, 0x61, 0x7a, 0x79, 0x20,
+    0x64, 0x6f, 0x67, 0x2e, 0x11, 0x22, 0x33, 0x44,
+    0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc,
+    0xdd, 0xee, 0xff, 0x00, 0x13, 0x57, 0x9b, 0xdf
+};
+
+/**
+ * \brief Fills a buffer with self-check data.
+ *
+ * \param data The buffer to fill.
+ * \param len The length of the buffer.
+ * \param seed Value to mix into the data so that different calls
+ * produce different buffers.
+ */
+static void noise_backend_fill(uint8_t *data, size_t len, uint8_t seed)
+{
+    size_t index;
+    for (index = 0; index < len; ++index) {
+        data[index] = noise_check_data[index % sizeof(noise_check_data)] ^
+                      (uint8_t)(seed + index / sizeof(noise_check_data));
+    }
+}
+
+/**
+ * \brief Compares two CipherState implementations.
+ *
+ * \param impl The implementation to check.
+ * \param ref The reference implementation.
+ *
+ * \return NOISE_ERROR_NONE, NOISE_ERROR_SELF_CHECK_FAILED, or
+ * NOISE_ERROR_NO_MEMORY.
+ */
+static int noise_backend_check_cipher
+    (const NoiseBackend *impl, const NoiseBackend *ref)
+{
+    static size_t const sizes[] = {0, 1, 15, 16, 17, 63, 64, 65, 300};
+    NoiseCipherState *state1 = (*(impl->new_cipher))();
+    NoiseCipherState *state2 = (*(ref->new_cipher))();
+    uint8_t key[32];
+    uint8_t data1[300 + 16];
+    uint8_t data2[300 + 16];
+    NoiseBuffer mbuf1, mbuf2;
+    int err = NOISE_ERROR_NONE;
+    size_t index;
+    if (!state1 || !state2) {
+        err = NOISE_ERROR_NO_MEMORY;
+        goto cleanup;
+    }
+    noise_backend_fill(key, sizeof(key), 0x01);
+    noise_cipherstate_init_key(state1, key, sizeof(key));
+    noise_cipherstate_init_key(state2, key, sizeof(key));
+    for (index = 0; index < sizeof(sizes) / sizeof(sizes[0]); ++index) {
+        noise_backend_fill(data1, sizes[index], (uint8_t)index);
+        memcpy(data2, data1, sizes[index]);
+        noise_buffer_set_inout(mbuf1, data1, sizes[index], sizeof(data1));
+        noise_buffer_set_inout(mbuf2, data2, sizes[index], sizeof(data2));
+        noise_cipherstate_encrypt_with_ad
+            (state1, key, index, &mbuf1);
+        noise_cipherstate_encrypt_with_ad
+            (state2, key, index, &mbuf2);
+        if (mbuf1.size != mbuf2.size ||
+                memcmp(data1, data2, mbuf1.size) != 0) {
+            err = NOISE_ERROR_SELF_CHECK_FAILED;
+            break;
+        }
+    }
+cleanup:
+    noise_cipherstate_free(state1);
+    noise_cipherstate_free(state2);
+    return err;
+}
+
+/**
+ * \brief Compares two HashState implementations.
+ *
+ * \param impl The implementation to check.
+ * \param ref The reference implementation.
+ *
+ * \return NOISE_ERROR_NONE, NOISE_ERROR_SELF_CHECK_FAILED, or
+ * NOISE_ERROR_NO_MEMORY.
+ */
+static int noise_backend_check_hash
+    (const NoiseBackend *impl, const NoiseBackend *ref)
+{
+    static size_t const sizes[] = {0, 1, 63, 64, 65, 127, 128, 129, 300};
+    NoiseHashState *state1 = (*(impl->new_hash))();
+    NoiseHashState *state2 = (*(ref->new_hash))();
+    uint8_t data[300];
+    uint8_t hash1[64];
+    uint8_t hash2[64];
+    int err = NOISE_ERROR_NONE;
+    size_t hash_len;
+    size_t index;
+    if (!state1 || !state2) {
+        err = NOISE_ERROR_NO_MEMORY;
+        goto cleanup;
+    }
+    hash_len = noise_hashstate_get_hash_length(state2);
+    for (index = 0; index < sizeof(sizes) / sizeof(sizes[0]); ++index) {
+        noise_backend_fill(data, sizes[index], (uint8_t)index);
+        memset(hash1, 0, sizeof(hash1));
+        memset(hash2, 0xFF, sizeof(hash2));
+        noise_hashstate_hash_one(state1, data, sizes[index], hash1, hash_len);
+        noise_hashstate_hash_one(state2, data, sizes[index], hash2, hash_len);
+        if (memcmp(hash1, hash2, hash_len) != 0) {
+            err = NOISE_ERROR_SELF_CHECK_FAILED;
+            break;
+        }
+    }
+cleanup:
+    noise_hashstate_free(state1);
+    noise_hashstate_free(state2);
+    return err;
+}
+
+/**
+ * \brief Compares two DHState implementations.
+ *
+ * \param impl The implementation to check.
+ * \param ref The reference implementation.
+ *
+ * \return NOISE_ERROR_NONE, NOISE_ERROR_SELF_CHECK_FAILED, or
+ * NOISE_ERROR_NO_MEMORY.
+ */
+static int noise_backend_check_dh
+    (const NoiseBackend *impl, const NoiseBackend *ref)
+{
+    NoiseDHState *state1 = (*(impl->new_dh))();
+    NoiseDHState *state2 = (*(ref->new_dh))();
+    NoiseDHState *other = (*(ref->new_dh))();
+    uint8_t *buf = 0;
+    size_t priv_len, pub_len, shared_len;
+    int err = NOISE_ERROR_NONE;
+    if (!state1 || !state2 || !other) {
+        err = NOISE_ERROR_NO_MEMORY;
+        goto cleanup;
+    }
+    priv_len = state2->private_key_len;
+    pub_len = state2->public_key_len;
+    shared_len = state2->shared_key_len;
+    buf = (uint8_t *)malloc(priv_len + pub_len * 2 + shared_len * 2);
+    if (!buf) {
+        err = NOISE_ERROR_NO_MEMORY;
+        goto cleanup;
+    }
+
+    /* Derive the public key from a fixed private key on both sides */
+    noise_backend_fill(buf, priv_len, 0x02);
+    noise_dhstate_set_keypair_private(state1, buf, priv_len);
+    noise_dhstate_set_keypair_private(state2, buf, priv_len);
+    noise_dhstate_get_public_key(state1, buf + priv_len, pub_len);
+    noise_dhstate_get_public_key(state2, buf + priv_len + pub_len, pub_len);
+    if (memcmp(buf + priv_len, buf + priv_len + pub_len, pub_len) != 0) {
+        err = NOISE_ERROR_SELF_CHECK_FAILED;
+        goto cleanup;
+    }
+
+    /* Calculate a shared key with another fixed key.  Ephemeral-only
+       algorithms cannot do this without generating random keys */
+    if (!state2->ephemeral_only) {
+        noise_backend_fill(buf, priv_len, 0x03);
+        noise_dhstate_set_keypair_private(other, buf, priv_len);
+        memset(buf + priv_len + pub_len * 2, 0, shared_len);
+        memset(buf + priv_len + pub_len * 2 + shared_len, 0xFF, shared_len);
+        noise_dhstate_calculate
+            (state1, other, buf + priv_len + pub_len * 2, shared_len);
+        noise_dhstate_calculate
+            (state2, other, buf + priv_len + pub_len * 2 + shared_len,
+             shared_len);
+        if (memcmp(buf + priv_len + pub_len * 2,
+                   buf + priv_len + pub_len * 2 + shared_len,
+                   shared_len) != 0)
+            err = NOISE_ERROR_SELF_CHECK_FAILED;
+    }
+
+cleanup:
+    if (buf)
+        free(buf);
+    noise_dhstate_free(state1);
+    noise_dhstate_free(state2);
+    noise_dhstate_free(other);
+    return err;
+}
+
+/**
+ * \brief Compares two SignState implementations.
+ *
+ * \param impl The implementation to check.
+ * \param ref The reference implementation.
+ *
+ * \return NOISE_ERROR_NONE, NOISE_ERROR_SELF_CHECK_FAILED, or
+ * NOISE_ERROR_NO_MEMORY.
+ */
+static int noise_backend_check_sign
+    (const NoiseBackend *impl, const NoiseBackend *ref)
+{
+    NoiseSignState *state1 = (*(impl->new_sign))();
+    NoiseSignState *state2 = (*(ref->new_sign))();
+    uint8_t key[64];
+    uint8_t sig1[128];
+    uint8_t sig2[128];
+    size_t key_len, sig_len;
+    int err = NOISE_ERROR_NONE;
+    if (!state1 || !state2) {
+        err = NOISE_ERROR_NO_MEMORY;
+        goto cleanup;
+    }
+    key_len = noise_signstate_get_private_key_length(state2);
+    sig_len = noise_signstate_get_signature_length(state2);
+    if (key_len > sizeof(key) || sig_len > sizeof(sig1)) {
+        err = NOISE_ERROR_INVALID_LENGTH;
+        goto cleanup;
+    }
+    noise_backend_fill(key, key_len, 0x04);
+    noise_signstate_set_keypair_private(state1, key, key_len);
+    noise_signstate_set_keypair_private(state2, key, key_len);
+    memset(sig1, 0, sizeof(sig1));
+    memset(sig2, 0xFF, sizeof(sig2));
+    noise_signstate_sign(state1, noise_check_data, sizeof(noise_check_data),
+                         sig1, sig_len);
+    noise_signstate_sign(state2, noise_check_data, sizeof(noise_check_data),
+                         sig2, sig_len);
+    if (memcmp(sig1, sig2, sig_len) != 0)
+        err = NOISE_ERROR_SELF_CHECK_FAILED;
+cleanup:
+    noise_signstate_free(state1);
+    noise_signstate_free(state2);
+    return err;
+}
+
+/**
+ * \brief Compares an implementation against the reference implementation.
+ *
+ * \param backend The implementation to check.
+ *
+ * \return NOISE_ERROR_NONE if the implementation produces the same
+ * results as the reference implementation.  The reference implementation
+ * is compared against a fresh copy of itself, which checks that it is
+ * deterministic.
+ * \return NOISE_ERROR_SELF_CHECK_FAILED if the results differ.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory to
+ * run the check.
+ */
+static int noise_backend_check(const NoiseBackend *backend)
+{
+    const NoiseBackend *ref;
+    ref = noise_backend_find(backend->id, NOISE_BACKEND_REF,
+                             strlen(NOISE_BACKEND_REF));
+    if (!ref)
+        return NOISE_ERROR_NONE;
+    if (backend->new_cipher)
+        return noise_backend_check_cipher(backend, ref);
+    else if (backend->new_hash)
+        return noise_backend_check_hash(backend, ref);
+    else if (backend->new_dh)
+        return noise_backend_check_dh(backend, ref);
+    else
+        return noise_backend_check_sign(backend, ref);
+}
+
+/** @endcond */
+
+/**
+ * \brief Gets the features of the CPU that are relevant to selecting
+ * between alternative implementations.
+ *
+ * \return A bitmask of NOISE_CPU_SSE2, NOISE_CPU_AVX2, etc.  Returns zero
+ * on CPU's that are not x86 or x86-64.
+ */
+int noise_backend_get_cpu_features(void)
+{
+    noise_backend_init();
+    return noise_cpu_features;
+}
+
+/**
+ * \brief Gets the number of implementations that are registered for
+ * an algorithm.
+ *
+ * \param id The algorithm identifier; NOISE_CIPHER_CHACHAPOLY,
+ * NOISE_HASH_BLAKE2s, etc.
+ *
+ * \return The number of implementations, including those that are not
+ * supported by this CPU, or zero if \a id is unknown.
+ *
+ * \sa noise_backend_get_name(), noise_backend_is_supported()
+ */
+int noise_backend_get_count(int id)
+{
+    size_t index;
+    int count = 0;
+    for (index = 0; index < NOISE_NUM_BACKENDS; ++index) {
+        if (noise_backends[index].id == id)
+            ++count;
+    }
+    return count;
+}
+
+/**
+ * \brief Gets the name of one of the implementations of an algorithm.
+ *
+ * \param id The algorithm identifier.
+ * \param index The index of the implementation, between 0 and
+ * noise_backend_get_count() - 1.  Implementations are listed in
+ * order of preference.
+ *
+ * \return The name of the implementation; e.g. "ref", "avx2", or NULL
+ * if \a id or \a index is invalid.
+ *
+ * \sa noise_backend_get_count()
+ */
+const char *noise_backend_get_name(int id, int index)
+{
+    size_t posn;
+    for (posn = 0; posn < NOISE_NUM_BACKENDS; ++posn) {
+        if (noise_backends[posn].id == id) {
+            if (index == 0)
+                return noise_backends[posn].name;
+            --index;
+        }
+    }
+    return 0;
+}
+
+/**
+ * \brief Determines if this CPU supports one of the implementations
+ * of an algorithm.
+ *
+ * \param id The algorithm identifier.
+ * \param index The index of the implementation, between 0 and
+ * noise_backend_get_count() - 1.
+ *
+ * \return Non-zero if the implementation is supported, or zero if it
+ * is not supported or \a id or \a index is invalid.
+ *
+ * \sa noise_backend_get_count(), noise_backend_get_name()
+ */
+int noise_backend_is_supported(int id, int index)
+{
+    const char *name = noise_backend_get_name(id, index);
+    if (!name)
+        return 0;
+    noise_backend_init();
+    return noise_backend_supported
+        (noise_backend_find(id, name, strlen(name)));
+}
+
+/**
+ * \brief Gets the name of the implementation that is currently in use
+ * for an algorithm.
+ *
+ * \param id The algorithm identifier.
+ *
+ * \return The name of the active implementation, or NULL if \a id
+ * is unknown.
+ *
+ * \sa noise_backend_select()
+ */
+const char *noise_backend_get_active(int id)
+{
+    const NoiseBackend *backend = noise_backend_lookup(id);
+    return backend ? backend->name : 0;
+}
+
+/**
+ * \brief Forces a specific implementation to be used for an algorithm.
+ *
+ * \param id The algorithm identifier.
+ * \param name The name of the implementation to use, or NULL to go back
+ * to automatically selecting the fastest supported implementation.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_UNKNOWN_ID if \a id is unknown.
+ * \return NOISE_ERROR_UNKNOWN_NAME if \a name is not a registered
+ * implementation of the algorithm.
+ * \return NOISE_ERROR_NOT_APPLICABLE if the implementation is not
+ * supported by this CPU.
+ *
+ * The new selection only affects objects that are created afterwards.
+ * Existing objects keep using the implementation they were created with.
+ *
+ * The selection is published atomically, so it is safe to call this
+ * while other threads are creating Noise objects.  Those objects may use
+ * either the old or the new implementation.  Selections are normally made
+ * at startup.
+ *
+ * \sa noise_backend_get_active()
+ */
+int noise_backend_select(int id, const char *name)
+{
+    NoiseBackendSelection *selection;
+    const NoiseBackend *backend;
+    noise_backend_init();
+    selection = noise_backend_find_selection(id);
+    if (!selection)
+        return NOISE_ERROR_UNKNOWN_ID;
+    if (!name) {
+        noise_backend_store(&(selection->active),
+                            noise_backend_choose_auto(id));
+        return NOISE_ERROR_NONE;
+    }
+    backend = noise_backend_find(id, name, strlen(name));
+    if (!backend)
+        return NOISE_ERROR_UNKNOWN_NAME;
+    if (!noise_backend_supported(backend))
+        return NOISE_ERROR_NOT_APPLICABLE;
+    noise_backend_store(&(selection->active), backend);
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Checks the active implementation of an algorithm against the
+ * reference implementation.
+ *
+ * \param id The algorithm identifier.
+ *
+ * \return NOISE_ERROR_NONE if the active implementation produces the
+ * same results as the reference implementation.
+ * \return NOISE_ERROR_UNKNOWN_ID if \a id is unknown.
+ * \return NOISE_ERROR_SELF_CHECK_FAILED if the results differ.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory to
+ * run the check.
+ *
+ * This function only reports the result.  It does not change the
+ * active implementation.
+ *
+ * \sa noise_backend_set_self_check()
+ */
+int noise_backend_self_check(int id)
+{
+    const NoiseBackend *backend = noise_backend_lookup(id);
+    if (!backend)
+        return NOISE_ERROR_UNKNOWN_ID;
+    return noise_backend_check(backend);
+}
+
+/**
+ * \brief Enables or disables automatic self-checks of alternative
+ * implementations.
+ *
+ * \param enable Non-zero to check each alternative implementation
+ * against the reference implementation the first time that it is used,
+ * or zero to disable the checks.
+ *
+ * An implementation that fails the check is replaced with the reference
+ * implementation for the rest of the process's lifetime, unless another
+ * implementation is explicitly selected with noise_backend_select().
+ *
+ * \sa noise_backend_self_check()
+ */
+void noise_backend_set_self_check(int enable)
+{
+    noise_backend_init();
+    noise_backend_store(&noise_self_check, enable);
+}
+
+/**
+ * \brief Looks up the active implementation of an algorithm.
+ *
+ * \param id The algorithm identifier.
+ *
+ * \return A pointer to the active implementation, or NULL if \a id
+ * is unknown.
+ *
+ * This is used by noise_cipherstate_new_by_id(), noise_hashstate_new_by_id(),
+ * etc to find the constructor to call.  If self-checks are enabled and
+ * this is the first use of the implementation, then it is checked against
+ * the reference implementation first.
+ */
+const NoiseBackend *noise_backend_lookup(int id)
+{
+    NoiseBackendSelection *selection;
+    const NoiseBackend *active;
+    int err;
+    noise_backend_init();
+    selection = noise_backend_find_selection(id);
+    if (!selection)
+        return 0;
+    active = noise_backend_load(&(selection->active));
+    if (noise_backend_load(&noise_self_check) && active &&
+            noise_backend_load(&(selection->checked)) != active &&
+            strcmp(active->name, NOISE_BACKEND_REF) != 0) {
+        /* Several threads may check the same implementation at once,
+           which is harmless because they all reach the same answer */
+        err = noise_backend_check(active);
+        if (err == NOISE_ERROR_SELF_CHECK_FAILED) {
+            /* Fall back to the reference implementation, unless another
+               thread has already changed the selection */
+            (void)noise_backend_replace
+                (&(selection->active), &active,
+                 noise_backend_find(id, NOISE_BACKEND_REF,
+                                    strlen(NOISE_BACKEND_REF)));
+            active = noise_backend_load(&(selection->active));
+        } else if (err == NOISE_ERROR_NONE) {
+            noise_backend_store(&(selection->checked), active);
+        }
+    }
+    return active;
+}
+
+/**@}*/
@@ -50,9 +50,6 @@
 
 /** @cond */
 
-/** Maximum length of an encryption key across all back ends */
-#define NOISE_MAX_KEY_LEN   32
-
 /** Maximum length of a MAC value across all back ends */
 #define NOISE_MAX_MAC_LEN   16
 
@@ -76,24 +73,19 @@
  */
 int noise_cipherstate_new_by_id(NoiseCipherState **state, int id)
 {
+    const NoiseBackend *backend;
+
     /* The "state" argument must be non-NULL */
     if (!state)
         return NOISE_ERROR_INVALID_PARAM;
 
-    /* Create the CipherState object for the "id" */
+    /* Create the CipherState object for the "id" using the implementation
+       that is currently selected in the backend registry */
     *state = 0;
-    switch (id) {
-    case NOISE_CIPHER_CHACHAPOLY:
-        *state = noise_chachapoly_new();
-        break;
-
-    case NOISE_CIPHER_AESGCM:
-        *state = noise_aesgcm_new();
-        break;
-
-    default:
+    backend = noise_backend_lookup(id);
+    if (!backend || !(backend->new_cipher))
         return NOISE_ERROR_UNKNOWN_ID;
-    }
+    *state = (*(backend->new_cipher))();
 
     /* Bail out if insufficient memory */
     if (!(*state))
@@ -228,7 +220,8 @@ int noise_cipherstate_init_key
         return NOISE_ERROR_INVALID_LENGTH;
 
     /* Set the key */
-    (*(state->init_key))(state, key);
+    noise_cipher_init_key(state, key);
+    memcpy(state->key, key, key_len);
     state->has_key = 1;
     state->n = 0;
     return NOISE_ERROR_NONE;
@@ -322,7 +315,7 @@ int noise_cipherstate_encrypt_with_ad
         return NOISE_ERROR_INVALID_NONCE;
 
     /* Encrypt the plaintext and authenticate it */
-    err = (*(state->encrypt))(state, ad, ad_len, buffer->data, buffer->size);
+    err = noise_cipher_encrypt(state, ad, ad_len, buffer->data, buffer->size);
     ++(state->n);
     if (err != NOISE_ERROR_NONE)
         return err;
@@ -397,7 +390,7 @@ int noise_cipherstate_decrypt_with_ad
         return NOISE_ERROR_INVALID_NONCE;
 
     /* Decrypt the ciphertext and check the MAC */
-    err = (*(state->decrypt))
+    err = noise_cipher_decrypt
         (state, ad, ad_len, buffer->data, buffer->size - state->mac_len);
     ++(state->n);
     if (err != NOISE_ERROR_NONE)
@@ -541,7 +534,7 @@ int noise_cipherstate_derive(NoiseCipherState *state, uint8_t *data, size_t len)
     memset(buffer, 0, sizeof(buffer));
     nonce = state->n;
     state->n = 0xFFFFFFFFFFFFFFFFULL;
-    err = (*(state->encrypt))(state, 0, 0, buffer, len);
+    err = noise_cipher_encrypt(state, 0, 0, buffer, len);
     state->n = nonce;
 
     /* Discard the MAC and return the ciphertext */
@@ -588,6 +581,173 @@ int noise_cipherstate_set_nonce(NoiseCipherState *state, uint64_t nonce)
     return NOISE_ERROR_NONE;
 }
 
+/**
+ * \brief Writes the cipher, key, and nonce of a CipherState to the
+ * body of an exported object.
+ *
+ * \param state The CipherState object.
+ * \param body The body buffer.
+ *
+ * \note Not part of the public API.
+ */
+void noise_cipherstate_write_export
+    (const NoiseCipherState *state, NoiseBuffer *body)
+{
+    noise_export_put_uint(body, (uint64_t)(state->cipher_id), 2);
+    noise_export_put_uint(body, state->has_key, 1);
+    noise_export_put_uint(body, state->n, 8);
+    if (state->has_key)
+        noise_export_put_bytes(body, state->key, state->key_len);
+}
+
+/**
+ * \brief Reads the cipher, key, and nonce of a CipherState from the
+ * body of an exported object.
+ *
+ * \param state The CipherState object, which must have been created for
+ * the same cipher algorithm as the exported object.
+ * \param body The body buffer.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_FORMAT if the body is malformed or is
+ * for a different cipher algorithm.
+ *
+ * \note Not part of the public API.
+ */
+int noise_cipherstate_read_export(NoiseCipherState *state, NoiseBuffer *body)
+{
+    uint8_t key[NOISE_MAX_KEY_LEN];
+    uint64_t n;
+    int has_key;
+
+    if (noise_export_get_uint(body, 2) != (uint64_t)(state->cipher_id))
+        return NOISE_ERROR_INVALID_FORMAT;
+    has_key = (int)noise_export_get_uint(body, 1);
+    n = noise_export_get_uint(body, 8);
+    if (has_key > 1 || body->size > body->max_size)
+        return NOISE_ERROR_INVALID_FORMAT;
+    if (has_key) {
+        noise_export_get_bytes(body, key, state->key_len);
+        if (body->size > body->max_size)
+            return NOISE_ERROR_INVALID_FORMAT;
+        noise_cipherstate_init_key(state, key, state->key_len);
+        noise_clean(key, sizeof(key));
+    }
+    state->n = n;
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Exports the key and nonce of a CipherState in an encrypted and
+ * authenticated blob.
+ *
+ * \param state The CipherState object.
+ * \param wrap_key Points to the key to wrap the blob with.  This key
+ * should be local to the machine or cluster; e.g. generated at startup
+ * by the parent process and passed to its workers.
+ * \param wrap_key_len The length of \a wrap_key, which must be
+ * NOISE_EXPORT_KEY_LEN.
+ * \param blob The buffer to write the blob to.  NOISE_MAX_EXPORT_LEN
+ * bytes are always sufficient.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a state, \a wrap_key, or
+ * \a blob is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if \a wrap_key_len is incorrect or
+ * \a blob is not large enough.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory.
+ *
+ * This is intended for migrating live sessions between processes; e.g.
+ * handing a session over to another worker along with its socket during
+ * a rolling restart, without the client having to perform a new handshake.
+ *
+ * The blob contains the cipher algorithm, the key, and the nonce.  Once a
+ * CipherState has been exported, it should be freed without being used
+ * again.  Otherwise the same nonce may be used twice with the same key.
+ *
+ * \sa noise_cipherstate_import()
+ */
+int noise_cipherstate_export
+    (const NoiseCipherState *state, const uint8_t *wrap_key,
+     size_t wrap_key_len, NoiseBuffer *blob)
+{
+    uint8_t data[NOISE_MAX_EXPORT_LEN];
+    NoiseBuffer body;
+    int err;
+
+    if (!state)
+        return NOISE_ERROR_INVALID_PARAM;
+    noise_buffer_set_output(body, data, sizeof(data));
+    noise_cipherstate_write_export(state, &body);
+    err = noise_export_seal
+        (NOISE_EXPORT_CIPHERSTATE, wrap_key, wrap_key_len, &body, blob);
+    noise_clean(data, sizeof(data));
+    return err;
+}
+
+/**
+ * \brief Imports a CipherState from an encrypted and authenticated blob.
+ *
+ * \param state Points to the variable where to store the pointer to
+ * the new CipherState object.
+ * \param wrap_key Points to the key that the blob was wrapped with.
+ * \param wrap_key_len The length of \a wrap_key, which must be
+ * NOISE_EXPORT_KEY_LEN.
+ * \param blob The blob that was created by noise_cipherstate_export().
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a state, \a wrap_key, or
+ * \a blob is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if \a wrap_key_len is incorrect.
+ * \return NOISE_ERROR_INVALID_FORMAT if \a blob is not an exported
+ * CipherState.
+ * \return NOISE_ERROR_MAC_FAILURE if \a blob was not wrapped with
+ * \a wrap_key or it has been modified.
+ * \return NOISE_ERROR_UNKNOWN_ID if the cipher algorithm is not
+ * supported by this build.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory.
+ *
+ * The blob does not contain any protection against replay.  If the same
+ * blob is imported twice, then both copies will reuse the same nonces.
+ * Applications should ensure that a blob is only imported once; e.g. by
+ * passing it over a local socket rather than storing it.
+ *
+ * \sa noise_cipherstate_export()
+ */
+int noise_cipherstate_import
+    (NoiseCipherState **state, const uint8_t *wrap_key,
+     size_t wrap_key_len, const NoiseBuffer *blob)
+{
+    uint8_t data[NOISE_MAX_EXPORT_LEN];
+    NoiseBuffer body;
+    int err;
+
+    /* Validate the parameters */
+    if (!state)
+        return NOISE_ERROR_INVALID_PARAM;
+    *state = 0;
+
+    /* Unwrap the blob and create a CipherState for its algorithm */
+    noise_buffer_set_output(body, data, sizeof(data));
+    err = noise_export_open
+        (NOISE_EXPORT_CIPHERSTATE, wrap_key, wrap_key_len, blob, &body);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_cipherstate_new_by_id
+        (state, (int)((data[0] << 8) | data[1]));
+    if (err == NOISE_ERROR_NONE) {
+        err = noise_cipherstate_read_export(*state, &body);
+        if (err == NOISE_ERROR_NONE && body.size != body.max_size)
+            err = NOISE_ERROR_INVALID_FORMAT;
+        if (err != NOISE_ERROR_NONE) {
+            noise_cipherstate_free(*state);
+            *state = 0;
+        }
+    }
+    noise_clean(data, sizeof(data));
+    return err;
+}
+
 /**
  * \brief Gets the maximum key length for the supported algorithms.
  *
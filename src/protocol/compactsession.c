@@ -0,0 +1,353 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "internal.h"
+#include <string.h>
+
+/**
+ * \file compactsession.h
+ * \brief Compact transport session interface
+ */
+
+/**
+ * \file compactsession.c
+ * \brief Compact transport session implementation
+ */
+
+/**
+ * \defgroup compactsession Compact Session API
+ *
+ * After a handshake has been split, each direction of the session is
+ * normally a full CipherState object with its own heap allocation that
+ * holds function pointers and the cipher's expanded working state; e.g.
+ * the AES key schedule and GHASH table.  That is wasteful for servers
+ * that hold millions of sessions that are idle most of the time.
+ *
+ * A CompactSession holds nothing more than the key and nonce for each
+ * direction in a single small allocation.  It is created with
+ * noise_handshakestate_split_compact() or noise_compactsession_new().
+ * To process a message, the caller supplies a working CipherState for the
+ * same algorithm; e.g. one per worker thread.  The session's key and nonce
+ * are loaded into the working CipherState, the message is processed, and
+ * the updated nonce is stored back into the session.
+ *
+ * The cost is that the key is expanded again for every message.  This is
+ * a copy for ChaChaPoly and a key schedule plus GHASH setup for AESGCM.
+ * The session's key is only present in the working CipherState while the
+ * message is being processed.  Afterwards, the working CipherState is
+ * re-keyed with an all-zero key and marked as having no key, so it cannot
+ * be used to encrypt or decrypt under the session's key.
+ *
+ * The compact form is only intended for transport messages.  Rekeying
+ * and noise_cipherstate_derive() need a full CipherState.
+ */
+/**@{*/
+
+/**
+ * \typedef NoiseCompactSession
+ * \brief Opaque object that represents a compact transport session.
+ */
+
+/** @cond */
+
+/* Key length for all supported ciphers */
+#define NOISE_COMPACT_KEY_LEN 32
+
+/** @endcond */
+
+/**
+ * \brief Creates a new CompactSession object from a pair of keys.
+ *
+ * \param session Points to the variable where to store the pointer to
+ * the new CompactSession object.
+ * \param cipher_id The identifier for the cipher algorithm;
+ * e.g. NOISE_CIPHER_CHACHAPOLY.
+ * \param send_key The key for packets sent from the local party.
+ * \param receive_key The key for packets received from the remote party.
+ * \param key_len The length of the keys in bytes, which must be 32.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a session, \a send_key, or
+ * \a receive_key is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if \a key_len is not 32.
+ * \return NOISE_ERROR_UNKNOWN_ID if \a cipher_id is unknown.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory to
+ * allocate the new CompactSession object.
+ *
+ * Both nonces start at zero.  The usual way to create a CompactSession
+ * is with noise_handshakestate_split_compact().
+ *
+ * \sa noise_compactsession_free(), noise_handshakestate_split_compact()
+ */
+int noise_compactsession_new
+    (NoiseCompactSession **session, int cipher_id,
+     const uint8_t *send_key, const uint8_t *receive_key, size_t key_len)
+{
+    const NoiseBackend *backend;
+
+    /* Validate the parameters */
+    if (!session)
+        return NOISE_ERROR_INVALID_PARAM;
+    *session = 0;
+    if (!send_key || !receive_key)
+        return NOISE_ERROR_INVALID_PARAM;
+    if (key_len != NOISE_COMPACT_KEY_LEN)
+        return NOISE_ERROR_INVALID_LENGTH;
+    backend = noise_backend_lookup(cipher_id);
+    if (!backend || !(backend->new_cipher))
+        return NOISE_ERROR_UNKNOWN_ID;
+
+    /* Create the session and copy the keys into it */
+    *session = noise_new(NoiseCompactSession);
+    if (!(*session))
+        return NOISE_ERROR_NO_MEMORY;
+    (*session)->cipher_id = cipher_id;
+    memcpy((*session)->send_key, send_key, NOISE_COMPACT_KEY_LEN);
+    memcpy((*session)->receive_key, receive_key, NOISE_COMPACT_KEY_LEN);
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Frees a CompactSession object after destroying all sensitive material.
+ *
+ * \param session The CompactSession object to free.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a session is NULL.
+ *
+ * \sa noise_compactsession_new()
+ */
+int noise_compactsession_free(NoiseCompactSession *session)
+{
+    if (!session)
+        return NOISE_ERROR_INVALID_PARAM;
+    noise_free(session, session->size);
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Gets the algorithm identifier for the cipher in a CompactSession.
+ *
+ * \param session The CompactSession object.
+ *
+ * \return The cipher algorithm identifier, or NOISE_CIPHER_NONE if
+ * \a session is NULL.
+ *
+ * The working CipherState that is passed to
+ * noise_compactsession_encrypt() and noise_compactsession_decrypt()
+ * must be created with this algorithm identifier.
+ */
+int noise_compactsession_get_cipher_id(const NoiseCompactSession *session)
+{
+    return session ? session->cipher_id : NOISE_CIPHER_NONE;
+}
+
+/**
+ * \brief Gets the number of bytes that are allocated for each
+ * CompactSession object.
+ *
+ * \return The size of a CompactSession object, not counting the
+ * overhead of the memory allocator.
+ */
+size_t noise_compactsession_get_size(void)
+{
+    return sizeof(NoiseCompactSession);
+}
+
+/**
+ * \brief Loads a key and nonce from a CompactSession into a working
+ * CipherState.
+ *
+ * \param session The CompactSession object.
+ * \param cipher The working CipherState object.
+ * \param key The key to load.
+ * \param n The nonce to load.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a session or \a cipher is NULL.
+ * \return NOISE_ERROR_NOT_APPLICABLE if \a cipher is for a different
+ * algorithm than \a session.
+ */
+static int noise_compactsession_expand
+    (const NoiseCompactSession *session, NoiseCipherState *cipher,
+     const uint8_t *key, uint64_t n)
+{
+    if (!session || !cipher)
+        return NOISE_ERROR_INVALID_PARAM;
+    if (cipher->cipher_id != session->cipher_id)
+        return NOISE_ERROR_NOT_APPLICABLE;
+    noise_cipher_init_key(cipher, key);
+    memcpy(cipher->key, key, NOISE_COMPACT_KEY_LEN);
+    cipher->has_key = 1;
+    cipher->n = n;
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Removes a session's key from a working CipherState.
+ *
+ * \param cipher The working CipherState object.
+ *
+ * The expanded key schedule is overwritten by loading an all-zero key,
+ * and then the CipherState is marked as having no key.
+ */
+static void noise_compactsession_release(NoiseCipherState *cipher)
+{
+    static uint8_t const zero_key[NOISE_COMPACT_KEY_LEN] = {0};
+    noise_cipher_init_key(cipher, zero_key);
+    noise_clean(cipher->key, sizeof(cipher->key));
+    cipher->has_key = 0;
+    cipher->n = 0;
+}
+
+/**
+ * \brief Encrypts a transport message with a CompactSession.
+ *
+ * \param session The CompactSession object.
+ * \param cipher A working CipherState for the same cipher algorithm
+ * as \a session.  It is left without a key on exit.
+ * \param ad Points to the associated data, which can be NULL only if
+ * \a ad_len is zero.
+ * \param ad_len The length of the associated data in bytes.
+ * \param buffer The buffer containing the plaintext on entry and the
+ * ciphertext plus MAC on exit.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a session, \a cipher, or
+ * \a buffer is NULL.
+ * \return NOISE_ERROR_NOT_APPLICABLE if \a cipher is for a different
+ * algorithm than \a session.
+ * \return NOISE_ERROR_INVALID_NONCE if the nonce previously overflowed.
+ * \return NOISE_ERROR_INVALID_LENGTH if the ciphertext plus MAC is
+ * too large to fit within the maximum size of \a buffer and to also
+ * remain within 65535 bytes.
+ *
+ * Apart from the working CipherState, this behaves the same as
+ * noise_cipherstate_encrypt_with_ad() on the session's sending CipherState.
+ *
+ * \sa noise_compactsession_decrypt_with_ad(), noise_compactsession_encrypt()
+ */
+int noise_compactsession_encrypt_with_ad
+    (NoiseCompactSession *session, NoiseCipherState *cipher,
+     const uint8_t *ad, size_t ad_len, NoiseBuffer *buffer)
+{
+    int err = noise_compactsession_expand
+        (session, cipher, session ? session->send_key : 0,
+         session ? session->send_n : 0);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_cipherstate_encrypt_with_ad(cipher, ad, ad_len, buffer);
+    session->send_n = cipher->n;
+    noise_compactsession_release(cipher);
+    return err;
+}
+
+/**
+ * \brief Decrypts a transport message with a CompactSession.
+ *
+ * \param session The CompactSession object.
+ * \param cipher A working CipherState for the same cipher algorithm
+ * as \a session.  It is left without a key on exit.
+ * \param ad Points to the associated data, which can be NULL only if
+ * \a ad_len is zero.
+ * \param ad_len The length of the associated data in bytes.
+ * \param buffer The buffer containing the ciphertext plus MAC on entry
+ * and the plaintext on exit.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a session, \a cipher, or
+ * \a buffer is NULL.
+ * \return NOISE_ERROR_NOT_APPLICABLE if \a cipher is for a different
+ * algorithm than \a session.
+ * \return NOISE_ERROR_MAC_FAILURE if the MAC check failed.
+ * \return NOISE_ERROR_INVALID_NONCE if the nonce previously overflowed.
+ * \return NOISE_ERROR_INVALID_LENGTH if the size of \a buffer is larger
+ * than 65535 bytes or is too small to contain the MAC value.
+ *
+ * Apart from the working CipherState, this behaves the same as
+ * noise_cipherstate_decrypt_with_ad() on the session's receiving
+ * CipherState.
+ *
+ * \sa noise_compactsession_encrypt_with_ad(), noise_compactsession_decrypt()
+ */
+int noise_compactsession_decrypt_with_ad
+    (NoiseCompactSession *session, NoiseCipherState *cipher,
+     const uint8_t *ad, size_t ad_len, NoiseBuffer *buffer)
+{
+    int err = noise_compactsession_expand
+        (session, cipher, session ? session->receive_key : 0,
+         session ? session->receive_n : 0);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_cipherstate_decrypt_with_ad(cipher, ad, ad_len, buffer);
+    session->receive_n = cipher->n;
+    noise_compactsession_release(cipher);
+    return err;
+}
+
+/**
+ * \brief Encrypts a transport message with a CompactSession.
+ *
+ * \param session The CompactSession object.
+ * \param cipher A working CipherState for the same cipher algorithm
+ * as \a session.
+ * \param buffer The buffer containing the plaintext on entry and the
+ * ciphertext plus MAC on exit.
+ *
+ * \return The same values as noise_compactsession_encrypt_with_ad().
+ *
+ * This is a convenience function which encrypts the contents of a buffer
+ * without any associated data.
+ *
+ * \sa noise_compactsession_encrypt_with_ad()
+ */
+int noise_compactsession_encrypt
+    (NoiseCompactSession *session, NoiseCipherState *cipher,
+     NoiseBuffer *buffer)
+{
+    return noise_compactsession_encrypt_with_ad(session, cipher, 0, 0, buffer);
+}
+
+/**
+ * \brief Decrypts a transport message with a CompactSession.
+ *
+ * \param session The CompactSession object.
+ * \param cipher A working CipherState for the same cipher algorithm
+ * as \a session.
+ * \param buffer The buffer containing the ciphertext plus MAC on entry
+ * and the plaintext on exit.
+ *
+ * \return The same values as noise_compactsession_decrypt_with_ad().
+ *
+ * This is a convenience function which decrypts the contents of a buffer
+ * without any associated data.
+ *
+ * \sa noise_compactsession_decrypt_with_ad()
+ */
+int noise_compactsession_decrypt
+    (NoiseCompactSession *session, NoiseCipherState *cipher,
+     NoiseBuffer *buffer)
+{
+    return noise_compactsession_decrypt_with_ad(session, cipher, 0, 0, buffer);
+}
+
+/**@}*/
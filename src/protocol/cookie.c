@@ -0,0 +1,706 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "internal.h"
+#include <string.h>
+
+/**
+ * \file cookie.h
+ * \brief Cookie interface for shedding load during handshake floods
+ */
+
+/**
+ * \file cookie.c
+ * \brief Cookie implementation for shedding load during handshake floods
+ */
+
+/**
+ * \defgroup cookie Cookie API
+ *
+ * A responder that reads the first message of a pattern like IK, XK,
+ * or NK must allocate a HandshakeState and perform at least one DH
+ * operation before it knows whether the message came from a real
+ * initiator.  A flood of junk messages can keep every core busy.
+ *
+ * The cookie layer is modelled on the one in WireGuard.  It wraps the
+ * first handshake message in two MAC's, which the responder can check
+ * without allocating memory or performing DH:
+ *
+ * \li "mac1" is keyed with a hash of the responder's static public key.
+ * Because the initiator needs that key anyway for these patterns, a
+ * valid "mac1" costs a real initiator nothing.  Messages that were not
+ * meant for this responder are dropped cheaply.
+ * \li "mac2" is keyed with a cookie that the responder previously gave
+ * to the initiator's source address.  It proves that the initiator can
+ * receive packets at that address.
+ *
+ * Normally the responder only checks "mac1".  When the rate of messages
+ * rises above a threshold, the responder also requires "mac2".  Messages
+ * without a valid "mac2" get a small "cookie reply" instead of a
+ * handshake response.  The reply contains a cookie for the source address,
+ * encrypted so that only an initiator that knows the responder's static
+ * public key and sent the message can use it.  The initiator sends the
+ * handshake message again with the cookie.  Under load, only initiators
+ * that proved they can receive packets at their address cost the
+ * responder a DH.
+ *
+ * The responder uses a NoiseCookieChecker object:
+ *
+ * \li noise_cookiechecker_check() checks and strips the MAC's from the
+ * first handshake message before passing it to the HandshakeState.
+ * \li noise_cookiechecker_make_reply() formats a cookie reply when the
+ * check returns NOISE_ERROR_COOKIE_REQUIRED.
+ * \li noise_cookiechecker_tick() should be called once a second to
+ * update the measured rate of messages.
+ * \li noise_cookiechecker_rotate() should be called every two minutes
+ * to replace the secret that cookies are derived from.
+ *
+ * The initiator uses a NoiseCookieMaker object:
+ *
+ * \li noise_cookiemaker_add_macs() appends the MAC's to the first
+ * handshake message after it is written by the HandshakeState.
+ * \li noise_cookiemaker_consume_reply() stores the cookie from a
+ * cookie reply.  The initiator then writes a new first handshake
+ * message and sends it again.
+ *
+ * The MAC's are computed with HMAC-BLAKE2s, truncated to 16 bytes, and
+ * the cookie reply is encrypted with ChaChaPoly.  The source address is
+ * supplied by the application as an opaque string of bytes; e.g. the
+ * IP address and port of the initiator.  The application's framing must
+ * distinguish cookie replies from handshake responses.
+ *
+ * Neither object type is thread-safe.  Each NoiseCookieChecker has its own
+ * random secret, so a cookie from one checker is not accepted by another.
+ * A multi-threaded responder should share one checker under a lock or
+ * make sure that messages from a given source address always reach the
+ * same thread.
+ */
+/**@{*/
+
+/**
+ * \typedef NoiseCookieChecker
+ * \brief Opaque object that checks the MAC's on first handshake messages
+ * on behalf of a responder.
+ */
+
+/**
+ * \typedef NoiseCookieMaker
+ * \brief Opaque object that adds MAC's to first handshake messages
+ * on behalf of an initiator.
+ */
+
+/** @cond */
+
+/* Length of each MAC and of a cookie */
+#define NOISE_COOKIE_MAC_LEN        16
+
+/* Length of the salt that randomizes the key for a cookie reply */
+#define NOISE_COOKIE_SALT_LEN       16
+
+/* Format of a cookie reply:
+ *
+ *      'N' 'C' version 0
+ *      salt (16 bytes)
+ *      encrypted cookie (16 bytes)
+ *      MAC (16 bytes)
+ *
+ * The associated data is the header and salt, followed by the "mac1"
+ * value from the message that the cookie reply is for.
+ */
+#define NOISE_COOKIE_VERSION        1
+#define NOISE_COOKIE_HEADER_LEN     (4 + NOISE_COOKIE_SALT_LEN)
+#define NOISE_COOKIE_REPLY_LEN \
+    (NOISE_COOKIE_HEADER_LEN + NOISE_COOKIE_MAC_LEN * 2)
+
+/** @endcond */
+
+/**
+ * \brief Creates the objects and keys that are common to
+ * CookieChecker and CookieMaker objects.
+ *
+ * \param hash Returns the BLAKE2s object.
+ * \param cipher Returns the ChaChaPoly object.
+ * \param mac1_key Returns the key for "mac1".
+ * \param cookie_key Returns the key for cookie replies.
+ * \param public_key The responder's static public key.
+ * \param public_key_len The length of \a public_key in bytes.
+ *
+ * \return NOISE_ERROR_NONE on success, or an error code otherwise.
+ * The objects in \a hash and \a cipher may need to be freed by the
+ * caller even if an error is returned.
+ */
+static int noise_cookie_init
+    (NoiseHashState **hash, NoiseCipherState **cipher,
+     uint8_t *mac1_key, uint8_t *cookie_key,
+     const uint8_t *public_key, size_t public_key_len)
+{
+    int err;
+    err = noise_hashstate_new_by_id(hash, NOISE_HASH_BLAKE2s);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_cipherstate_new_by_id(cipher, NOISE_CIPHER_CHACHAPOLY);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    noise_hashstate_hash_two
+        (*hash, (const uint8_t *)"mac1----", 8, public_key, public_key_len,
+         mac1_key, 32);
+    noise_hashstate_hash_two
+        (*hash, (const uint8_t *)"cookie--", 8, public_key, public_key_len,
+         cookie_key, 32);
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Computes a truncated HMAC-BLAKE2s value.
+ *
+ * \param hash The BLAKE2s object to use.
+ * \param key Points to the key.
+ * \param key_len The length of the key in bytes.
+ * \param data1 Points to the first data block.
+ * \param data1_len The length of the first data block in bytes.
+ * \param data2 Points to the second data block (may be NULL).
+ * \param data2_len The length of the second data block in bytes.
+ * \param mac Returns the first NOISE_COOKIE_MAC_LEN bytes of the HMAC value.
+ */
+static void noise_cookie_mac
+    (NoiseHashState *hash, const uint8_t *key, size_t key_len,
+     const uint8_t *data1, size_t data1_len,
+     const uint8_t *data2, size_t data2_len, uint8_t *mac)
+{
+    uint8_t temp[32];
+    noise_hashstate_hmac
+        (hash, key, key_len, data1, data1_len, data2, data2_len, temp);
+    memcpy(mac, temp, NOISE_COOKIE_MAC_LEN);
+    noise_clean(temp, sizeof(temp));
+}
+
+/**
+ * \brief Keys the ChaChaPoly object for a cookie reply.
+ *
+ * \param hash The BLAKE2s object to use.
+ * \param cipher The ChaChaPoly object to key.
+ * \param cookie_key The key for cookie replies.
+ * \param header Points to the header and salt of the cookie reply.
+ * \param mac1 Points to the "mac1" value of the message that the reply
+ * is for.
+ * \param ad Returns the associated data for the cookie reply.
+ */
+static void noise_cookie_reply_key
+    (NoiseHashState *hash, NoiseCipherState *cipher,
+     const uint8_t *cookie_key, const uint8_t *header, const uint8_t *mac1,
+     uint8_t *ad)
+{
+    uint8_t key[32];
+    noise_hashstate_hmac
+        (hash, cookie_key, 32, header, NOISE_COOKIE_HEADER_LEN, 0, 0, key);
+    noise_cipherstate_init_key(cipher, key, sizeof(key));
+    noise_clean(key, sizeof(key));
+    memcpy(ad, header, NOISE_COOKIE_HEADER_LEN);
+    memcpy(ad + NOISE_COOKIE_HEADER_LEN, mac1, NOISE_COOKIE_MAC_LEN);
+}
+
+/**
+ * \brief Creates a new CookieChecker object for a responder.
+ *
+ * \param checker Points to the variable where to store the pointer to
+ * the new CookieChecker object.
+ * \param public_key The responder's static public key.
+ * \param public_key_len The length of \a public_key in bytes.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a checker or \a public_key is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if \a public_key_len is zero.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory to
+ * allocate the new CookieChecker object.
+ *
+ * The new object never requires cookies until a threshold is set with
+ * noise_cookiechecker_set_threshold().
+ *
+ * \sa noise_cookiechecker_free(), noise_cookiemaker_new()
+ */
+int noise_cookiechecker_new
+    (NoiseCookieChecker **checker, const uint8_t *public_key,
+     size_t public_key_len)
+{
+    int err;
+
+    /* Validate the parameters */
+    if (!checker)
+        return NOISE_ERROR_INVALID_PARAM;
+    *checker = 0;
+    if (!public_key)
+        return NOISE_ERROR_INVALID_PARAM;
+    if (!public_key_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* Create the checker and derive the keys */
+    *checker = noise_new(NoiseCookieChecker);
+    if (!(*checker))
+        return NOISE_ERROR_NO_MEMORY;
+    err = noise_cookie_init
+        (&((*checker)->hash), &((*checker)->cipher), (*checker)->mac1_key,
+         (*checker)->cookie_key, public_key, public_key_len);
+    if (err != NOISE_ERROR_NONE) {
+        noise_cookiechecker_free(*checker);
+        *checker = 0;
+        return err;
+    }
+    noise_rand_bytes((*checker)->secret, sizeof((*checker)->secret));
+    noise_rand_bytes((*checker)->previous_secret,
+                     sizeof((*checker)->previous_secret));
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Frees a CookieChecker object after destroying all sensitive material.
+ *
+ * \param checker The CookieChecker object to free.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a checker is NULL.
+ *
+ * \sa noise_cookiechecker_new()
+ */
+int noise_cookiechecker_free(NoiseCookieChecker *checker)
+{
+    if (!checker)
+        return NOISE_ERROR_INVALID_PARAM;
+    if (checker->hash)
+        noise_hashstate_free(checker->hash);
+    if (checker->cipher)
+        noise_cipherstate_free(checker->cipher);
+    noise_free(checker, checker->size);
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Sets the rate of messages above which cookies are required.
+ *
+ * \param checker The CookieChecker object.
+ * \param threshold The number of messages with a valid "mac1" per tick
+ * above which cookies are required, or zero to never require cookies.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a checker is NULL.
+ *
+ * The threshold should be set a little below the number of handshakes
+ * per second that the responder can process.  The checker is under
+ * load if the threshold has been exceeded during the current tick or
+ * the previous one.
+ *
+ * \sa noise_cookiechecker_tick(), noise_cookiechecker_is_under_load()
+ */
+int noise_cookiechecker_set_threshold
+    (NoiseCookieChecker *checker, size_t threshold)
+{
+    if (!checker)
+        return NOISE_ERROR_INVALID_PARAM;
+    checker->threshold = threshold;
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Starts a new period for measuring the rate of messages.
+ *
+ * \param checker The CookieChecker object.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a checker is NULL.
+ *
+ * This should be called once a second from the application's timer.
+ * The library does not read the clock itself.
+ *
+ * \sa noise_cookiechecker_set_threshold()
+ */
+int noise_cookiechecker_tick(NoiseCookieChecker *checker)
+{
+    if (!checker)
+        return NOISE_ERROR_INVALID_PARAM;
+    checker->previous_count = checker->count;
+    checker->count = 0;
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Replaces the secret that cookies are derived from.
+ *
+ * \param checker The CookieChecker object.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a checker is NULL.
+ *
+ * Cookies from the current and previous secrets are accepted, so a
+ * cookie lives for between one and two rotation periods.  This should
+ * be called every two minutes so that a cookie that was handed out to
+ * an address stops working soon after the address changes hands.
+ */
+int noise_cookiechecker_rotate(NoiseCookieChecker *checker)
+{
+    if (!checker)
+        return NOISE_ERROR_INVALID_PARAM;
+    memcpy(checker->previous_secret, checker->secret, sizeof(checker->secret));
+    noise_rand_bytes(checker->secret, sizeof(checker->secret));
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Determine if a CookieChecker is currently requiring cookies.
+ *
+ * \param checker The CookieChecker object.
+ *
+ * \return Returns 1 if cookies are required or 0 if they are not.
+ *
+ * \sa noise_cookiechecker_set_threshold()
+ */
+int noise_cookiechecker_is_under_load(const NoiseCookieChecker *checker)
+{
+    if (!checker || !(checker->threshold))
+        return 0;
+    return checker->count > checker->threshold ||
+           checker->previous_count > checker->threshold;
+}
+
+/**
+ * \brief Checks and removes the MAC's on the first handshake message.
+ *
+ * \param checker The CookieChecker object.
+ * \param source Points to the source address of the message.
+ * \param source_len The length of the source address in bytes.
+ * \param message The message that was received.  On success, the MAC's
+ * are removed from the end of the message so that it can be passed to
+ * noise_handshakestate_read_message().
+ *
+ * \return NOISE_ERROR_NONE if the message should be processed.
+ * \return NOISE_ERROR_INVALID_PARAM if \a checker, \a source, or
+ * \a message is NULL.
+ * \return NOISE_ERROR_INVALID_FORMAT if \a message is shorter than a
+ * cookie reply.
+ * \return NOISE_ERROR_MAC_FAILURE if "mac1" is incorrect.  The message
+ * should be dropped silently.
+ * \return NOISE_ERROR_COOKIE_REQUIRED if the responder is under load and
+ * "mac2" is incorrect.  The application should send a cookie reply from
+ * noise_cookiechecker_make_reply() instead of processing the message.
+ *
+ * The message is left unchanged if an error is returned.
+ *
+ * \sa noise_cookiechecker_make_reply(), noise_cookiemaker_add_macs()
+ */
+int noise_cookiechecker_check
+    (NoiseCookieChecker *checker, const uint8_t *source, size_t source_len,
+     NoiseBuffer *message)
+{
+    uint8_t cookie[NOISE_COOKIE_MAC_LEN];
+    uint8_t mac[NOISE_COOKIE_MAC_LEN];
+    const uint8_t *mac1;
+    const uint8_t *mac2;
+    size_t len;
+    int ok;
+
+    /* Validate the parameters */
+    if (!checker || !source || !message || !(message->data))
+        return NOISE_ERROR_INVALID_PARAM;
+    if (message->size < NOISE_COOKIE_REPLY_LEN)
+        return NOISE_ERROR_INVALID_FORMAT;
+    len = message->size - NOISE_COOKIE_MACS_LEN;
+    mac1 = message->data + len;
+    mac2 = mac1 + NOISE_COOKIE_MAC_LEN;
+
+    /* Check "mac1", which proves that the sender knows our public key */
+    noise_cookie_mac(checker->hash, checker->mac1_key, 32,
+                     message->data, len, 0, 0, mac);
+    if (!noise_is_equal(mac, mac1, NOISE_COOKIE_MAC_LEN))
+        return NOISE_ERROR_MAC_FAILURE;
+    ++(checker->count);
+
+    /* Under load, check "mac2" against the cookies for the current and
+       previous secrets, which proves that the sender owns its address */
+    if (noise_cookiechecker_is_under_load(checker)) {
+        noise_cookie_mac(checker->hash, checker->secret, 32,
+                         source, source_len, 0, 0, cookie);
+        noise_cookie_mac(checker->hash, cookie, sizeof(cookie),
+                         message->data, len + NOISE_COOKIE_MAC_LEN, 0, 0, mac);
+        ok = noise_is_equal(mac, mac2, NOISE_COOKIE_MAC_LEN);
+        if (!ok) {
+            noise_cookie_mac(checker->hash, checker->previous_secret, 32,
+                             source, source_len, 0, 0, cookie);
+            noise_cookie_mac(checker->hash, cookie, sizeof(cookie),
+                             message->data, len + NOISE_COOKIE_MAC_LEN,
+                             0, 0, mac);
+            ok = noise_is_equal(mac, mac2, NOISE_COOKIE_MAC_LEN);
+        }
+        noise_clean(cookie, sizeof(cookie));
+        if (!ok)
+            return NOISE_ERROR_COOKIE_REQUIRED;
+    }
+
+    /* Strip the MAC's from the message */
+    message->size = len;
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Formats a cookie reply for a message.
+ *
+ * \param checker The CookieChecker object.
+ * \param source Points to the source address of the message.
+ * \param source_len The length of the source address in bytes.
+ * \param message The message that was rejected with
+ * NOISE_ERROR_COOKIE_REQUIRED by noise_cookiechecker_check().
+ * \param reply The buffer to write the cookie reply to.  The reply is
+ * written to the start of the buffer and its size is set to the length
+ * of the reply.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a checker, \a source,
+ * \a message, or \a reply is NULL.
+ * \return NOISE_ERROR_INVALID_FORMAT if \a message is shorter than a
+ * cookie reply.
+ * \return NOISE_ERROR_INVALID_LENGTH if the \a reply buffer is too small.
+ * NOISE_MAX_COOKIE_REPLY_LEN bytes is always sufficient.
+ *
+ * Anyone who knows the responder's public key can compute "mac1", so
+ * the message may come from a spoofed source address.  Messages that
+ * are shorter than a cookie reply are rejected so that the reply is
+ * never larger than the message and cannot amplify a flood.
+ *
+ * \sa noise_cookiechecker_check(), noise_cookiemaker_consume_reply()
+ */
+int noise_cookiechecker_make_reply
+    (NoiseCookieChecker *checker, const uint8_t *source, size_t source_len,
+     const NoiseBuffer *message, NoiseBuffer *reply)
+{
+    uint8_t ad[NOISE_COOKIE_HEADER_LEN + NOISE_COOKIE_MAC_LEN];
+    const uint8_t *mac1;
+    NoiseBuffer buffer;
+    uint8_t *data;
+    int err;
+
+    /* Validate the parameters */
+    if (!checker || !source || !message || !(message->data) ||
+            !reply || !(reply->data))
+        return NOISE_ERROR_INVALID_PARAM;
+    if (message->size < NOISE_COOKIE_REPLY_LEN)
+        return NOISE_ERROR_INVALID_FORMAT;
+    if (reply->max_size < NOISE_COOKIE_REPLY_LEN)
+        return NOISE_ERROR_INVALID_LENGTH;
+    mac1 = message->data + message->size - NOISE_COOKIE_MACS_LEN;
+
+    /* Format the header with a random salt */
+    data = reply->data;
+    data[0] = 'N';
+    data[1] = 'C';
+    data[2] = NOISE_COOKIE_VERSION;
+    data[3] = 0;
+    noise_rand_bytes(data + 4, NOISE_COOKIE_SALT_LEN);
+
+    /* Compute the cookie for the source address and encrypt it */
+    noise_cookie_mac(checker->hash, checker->secret, 32,
+                     source, source_len, 0, 0,
+                     data + NOISE_COOKIE_HEADER_LEN);
+    noise_cookie_reply_key(checker->hash, checker->cipher,
+                           checker->cookie_key, data, mac1, ad);
+    noise_buffer_set_inout
+        (buffer, data + NOISE_COOKIE_HEADER_LEN, NOISE_COOKIE_MAC_LEN,
+         NOISE_COOKIE_MAC_LEN * 2);
+    err = noise_cipherstate_encrypt_with_ad
+        (checker->cipher, ad, sizeof(ad), &buffer);
+    if (err != NOISE_ERROR_NONE) {
+        noise_clean(data, NOISE_COOKIE_REPLY_LEN);
+        return err;
+    }
+    reply->size = NOISE_COOKIE_REPLY_LEN;
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Creates a new CookieMaker object for an initiator.
+ *
+ * \param maker Points to the variable where to store the pointer to
+ * the new CookieMaker object.
+ * \param public_key The responder's static public key.
+ * \param public_key_len The length of \a public_key in bytes.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a maker or \a public_key is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if \a public_key_len is zero.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory to
+ * allocate the new CookieMaker object.
+ *
+ * \sa noise_cookiemaker_free(), noise_cookiechecker_new()
+ */
+int noise_cookiemaker_new
+    (NoiseCookieMaker **maker, const uint8_t *public_key,
+     size_t public_key_len)
+{
+    int err;
+
+    /* Validate the parameters */
+    if (!maker)
+        return NOISE_ERROR_INVALID_PARAM;
+    *maker = 0;
+    if (!public_key)
+        return NOISE_ERROR_INVALID_PARAM;
+    if (!public_key_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* Create the maker and derive the keys */
+    *maker = noise_new(NoiseCookieMaker);
+    if (!(*maker))
+        return NOISE_ERROR_NO_MEMORY;
+    err = noise_cookie_init
+        (&((*maker)->hash), &((*maker)->cipher), (*maker)->mac1_key,
+         (*maker)->cookie_key, public_key, public_key_len);
+    if (err != NOISE_ERROR_NONE) {
+        noise_cookiemaker_free(*maker);
+        *maker = 0;
+    }
+    return err;
+}
+
+/**
+ * \brief Frees a CookieMaker object after destroying all sensitive material.
+ *
+ * \param maker The CookieMaker object to free.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a maker is NULL.
+ *
+ * \sa noise_cookiemaker_new()
+ */
+int noise_cookiemaker_free(NoiseCookieMaker *maker)
+{
+    if (!maker)
+        return NOISE_ERROR_INVALID_PARAM;
+    if (maker->hash)
+        noise_hashstate_free(maker->hash);
+    if (maker->cipher)
+        noise_cipherstate_free(maker->cipher);
+    noise_free(maker, maker->size);
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Appends the MAC's to the first handshake message.
+ *
+ * \param maker The CookieMaker object.
+ * \param message The message from noise_handshakestate_write_message().
+ * There must be room for NOISE_COOKIE_MACS_LEN extra bytes at the end.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a maker or \a message is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if there is no room for the MAC's.
+ *
+ * If there is no cookie yet, then "mac2" is set to all-zeroes.
+ * A responder that is not under load ignores "mac2".
+ *
+ * \sa noise_cookiemaker_consume_reply(), noise_cookiechecker_check()
+ */
+int noise_cookiemaker_add_macs(NoiseCookieMaker *maker, NoiseBuffer *message)
+{
+    uint8_t *mac1;
+    uint8_t *mac2;
+    size_t len;
+
+    /* Validate the parameters */
+    if (!maker || !message || !(message->data))
+        return NOISE_ERROR_INVALID_PARAM;
+    if (message->size > message->max_size ||
+            (message->max_size - message->size) < NOISE_COOKIE_MACS_LEN)
+        return NOISE_ERROR_INVALID_LENGTH;
+    len = message->size;
+    mac1 = message->data + len;
+    mac2 = mac1 + NOISE_COOKIE_MAC_LEN;
+
+    /* Compute "mac1" and remember it for authenticating a cookie reply */
+    noise_cookie_mac(maker->hash, maker->mac1_key, 32,
+                     message->data, len, 0, 0, mac1);
+    memcpy(maker->last_mac1, mac1, NOISE_COOKIE_MAC_LEN);
+    maker->has_mac1 = 1;
+
+    /* Compute "mac2" if we have a cookie */
+    if (maker->has_cookie) {
+        noise_cookie_mac(maker->hash, maker->cookie, sizeof(maker->cookie),
+                         message->data, len + NOISE_COOKIE_MAC_LEN, 0, 0, mac2);
+    } else {
+        memset(mac2, 0, NOISE_COOKIE_MAC_LEN);
+    }
+    message->size = len + NOISE_COOKIE_MACS_LEN;
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Stores the cookie from a cookie reply.
+ *
+ * \param maker The CookieMaker object.
+ * \param reply The cookie reply that was received from the responder.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a maker or \a reply is NULL.
+ * \return NOISE_ERROR_INVALID_FORMAT if \a reply is not formatted correctly.
+ * \return NOISE_ERROR_INVALID_STATE if no message has been sent yet.
+ * \return NOISE_ERROR_MAC_FAILURE if \a reply is not for the most recent
+ * message that was passed to noise_cookiemaker_add_macs().
+ *
+ * The cookie is used for "mac2" in all later messages until it is
+ * replaced by another cookie reply.  The initiator then retries by
+ * writing the first handshake message with a new HandshakeState and
+ * passing it to noise_cookiemaker_add_macs().
+ *
+ * \sa noise_cookiemaker_add_macs(), noise_cookiechecker_make_reply()
+ */
+int noise_cookiemaker_consume_reply
+    (NoiseCookieMaker *maker, const NoiseBuffer *reply)
+{
+    uint8_t ad[NOISE_COOKIE_HEADER_LEN + NOISE_COOKIE_MAC_LEN];
+    uint8_t data[NOISE_COOKIE_REPLY_LEN];
+    NoiseBuffer buffer;
+    int err;
+
+    /* Validate the parameters and the reply header */
+    if (!maker || !reply || !(reply->data))
+        return NOISE_ERROR_INVALID_PARAM;
+    if (reply->size != NOISE_COOKIE_REPLY_LEN)
+        return NOISE_ERROR_INVALID_FORMAT;
+    memcpy(data, reply->data, NOISE_COOKIE_REPLY_LEN);
+    if (data[0] != 'N' || data[1] != 'C' ||
+            data[2] != NOISE_COOKIE_VERSION || data[3] != 0)
+        return NOISE_ERROR_INVALID_FORMAT;
+    if (!(maker->has_mac1))
+        return NOISE_ERROR_INVALID_STATE;
+
+    /* Decrypt the cookie */
+    noise_cookie_reply_key(maker->hash, maker->cipher, maker->cookie_key,
+                           data, maker->last_mac1, ad);
+    noise_buffer_set_input
+        (buffer, data + NOISE_COOKIE_HEADER_LEN, NOISE_COOKIE_MAC_LEN * 2);
+    err = noise_cipherstate_decrypt_with_ad
+        (maker->cipher, ad, sizeof(ad), &buffer);
+    if (err == NOISE_ERROR_NONE) {
+        memcpy(maker->cookie, data + NOISE_COOKIE_HEADER_LEN,
+               NOISE_COOKIE_MAC_LEN);
+        maker->has_cookie = 1;
+    }
+    noise_clean(data, sizeof(data));
+    return err;
+}
+
+/**@}*/
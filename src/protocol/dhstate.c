@@ -66,28 +66,19 @@
  */
 int noise_dhstate_new_by_id(NoiseDHState **state, int id)
 {
+    const NoiseBackend *backend;
+
     /* The "state" argument must be non-NULL */
     if (!state)
         return NOISE_ERROR_INVALID_PARAM;
 
-    /* Create the DHState object for the "id" */
+    /* Create the DHState object for the "id" using the implementation
+       that is currently selected in the backend registry */
     *state = 0;
-    switch (id) {
-    case NOISE_DH_CURVE25519:
-        *state = noise_curve25519_new();
-        break;
-
-    case NOISE_DH_CURVE448:
-        *state = noise_curve448_new();
-        break;
-
-    case NOISE_DH_NEWHOPE:
-        *state = noise_newhope_new();
-        break;
-
-    default:
+    backend = noise_backend_lookup(id);
+    if (!backend || !(backend->new_dh))
         return NOISE_ERROR_UNKNOWN_ID;
-    }
+    *state = (*(backend->new_dh))();
 
     /* Bail out if insufficient memory */
     if (!(*state))
@@ -295,7 +286,7 @@ int noise_dhstate_generate_keypair(NoiseDHState *state)
         return NOISE_ERROR_INVALID_PARAM;
 
     /* Generate the new keypair */
-    err = (*(state->generate_keypair))(state, 0);
+    err = noise_dh_generate_keypair(state, 0);
     if (err == NOISE_ERROR_NONE)
         state->key_type = NOISE_KEY_TYPE_KEYPAIR;
     return err;
@@ -340,7 +331,7 @@ int noise_dhstate_generate_dependent_keypair
         return NOISE_ERROR_INVALID_PARAM;
 
     /* Generate the new keypair */
-    err = (*(state->generate_keypair))(state, other);
+    err = noise_dh_generate_keypair(state, other);
     if (err == NOISE_ERROR_NONE)
         state->key_type = NOISE_KEY_TYPE_KEYPAIR;
     return err;
@@ -385,7 +376,7 @@ int noise_dhstate_set_keypair
         return NOISE_ERROR_INVALID_LENGTH;
 
     /* Set the keypair */
-    err = (*(state->set_keypair))(state, private_key, public_key);
+    err = noise_dh_set_keypair(state, private_key, public_key);
     if (err != NOISE_ERROR_NONE) {
         noise_dhstate_clear_key(state);
         return err;
@@ -431,7 +422,7 @@ int noise_dhstate_set_keypair_private
         return NOISE_ERROR_INVALID_LENGTH;
 
     /* Set the private key and derive the public key from the private key */
-    err = (*(state->set_keypair_private))(state, private_key);
+    err = noise_dh_set_keypair_private(state, private_key);
     if (err != NOISE_ERROR_NONE) {
         noise_dhstate_clear_key(state);
         return err;
@@ -521,7 +512,7 @@ int noise_dhstate_set_public_key
     /* Validate the public key with the back end and then ignore the
        result if the public key is the special null value */
     is_null = state->nulls_allowed & noise_is_zero(public_key, public_key_len);
-    err = (*(state->validate_public_key))(state, public_key);
+    err = noise_dh_validate_public_key(state, public_key);
     err &= (is_null - 1);
     if (err != NOISE_ERROR_NONE)
         return err;
@@ -706,7 +697,7 @@ int noise_dhstate_calculate
         (public_key_state->public_key, public_key_state->public_key_len);
 
     /* Perform the calculation */
-    err = (*(private_key_state->calculate))
+    err = noise_dh_calculate
         (private_key_state, public_key_state, shared_key);
 
     /* If the public key was null, then we need to set the shared key
@@ -740,7 +731,7 @@ int noise_dhstate_copy(NoiseDHState *state, const NoiseDHState *from)
         return NOISE_ERROR_NONE;
 
     /* Copy the key information across */
-    err = (*(state->copy))(state, from, 0);
+    err = noise_dh_copy(state, from, 0);
     if (err != NOISE_ERROR_NONE)
         return err;
     state->key_type = from->key_type;
@@ -61,6 +61,10 @@ static const char * const error_strings[] = {
     "Invalid public key",
     "Invalid format",
     "Invalid signature",
+    "Self-check failed",
+    "Key revoked",
+    "Ticket expired",
+    "Cookie required",
     "END"
 };
 #define num_error_strings (sizeof(error_strings) / sizeof(error_strings[0]) - 1)
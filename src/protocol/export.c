@@ -0,0 +1,306 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "internal.h"
+#include <string.h>
+
+/**
+ * \file export.c
+ * \brief Wrapping of exported CipherState, SymmetricState,
+ * and HandshakeState objects
+ *
+ * \note This file and its definitions are not part of the public API.
+ */
+
+/** @cond */
+
+/* Format of a wrapped blob:
+
+       header[4]    'N', 'S', version, type
+       salt[16]     Random salt for deriving the blob key
+       ciphertext   Encrypted body
+       mac[16]      ChaChaPoly MAC over header, salt, and ciphertext
+
+   The blob key is HKDF-BLAKE2s(wrap_key, header || salt) so that every
+   blob is encrypted under a fresh key and the nonce can always be zero.
+   ChaChaPoly and BLAKE2s are used because they are available in all
+   builds, including --enable-single-suite */
+#define NOISE_EXPORT_VERSION        1
+#define NOISE_EXPORT_HEADER_LEN     4
+#define NOISE_EXPORT_SALT_LEN       16
+#define NOISE_EXPORT_MAC_LEN        16
+#define NOISE_EXPORT_PREFIX_LEN     (NOISE_EXPORT_HEADER_LEN + NOISE_EXPORT_SALT_LEN)
+#define NOISE_EXPORT_OVERHEAD       (NOISE_EXPORT_PREFIX_LEN + NOISE_EXPORT_MAC_LEN)
+
+/** @endcond */
+
+/**
+ * \brief Creates a CipherState that is keyed for a wrapped blob.
+ *
+ * \param cipher Points to the variable where to store the CipherState.
+ * \param wrap_key Points to the wrapping key.
+ * \param prefix Points to the header and salt for the blob.
+ *
+ * \return NOISE_ERROR_NONE on success or an error code from creating
+ * the HashState or CipherState objects.
+ */
+static int noise_export_create_cipher
+    (NoiseCipherState **cipher, const uint8_t *wrap_key, const uint8_t *prefix)
+{
+    NoiseHashState *hash;
+    uint8_t temp_k1[NOISE_MAX_HASHLEN];
+    uint8_t temp_k2[NOISE_MAX_HASHLEN];
+    int err;
+
+    err = noise_hashstate_new_by_id(&hash, NOISE_HASH_BLAKE2s);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_cipherstate_new_by_id(cipher, NOISE_CIPHER_CHACHAPOLY);
+    if (err == NOISE_ERROR_NONE) {
+        noise_hashstate_hkdf
+            (hash, wrap_key, NOISE_EXPORT_KEY_LEN,
+             prefix, NOISE_EXPORT_PREFIX_LEN,
+             temp_k1, NOISE_EXPORT_KEY_LEN, temp_k2, NOISE_EXPORT_KEY_LEN);
+        noise_cipherstate_init_key(*cipher, temp_k1, NOISE_EXPORT_KEY_LEN);
+        noise_clean(temp_k1, sizeof(temp_k1));
+        noise_clean(temp_k2, sizeof(temp_k2));
+    }
+    noise_hashstate_free(hash);
+    return err;
+}
+
+/**
+ * \brief Encrypts and authenticates the body of an exported object.
+ *
+ * \param type The type of object; e.g. NOISE_EXPORT_CIPHERSTATE.
+ * \param wrap_key Points to the wrapping key.
+ * \param wrap_key_len The length of the wrapping key, which must be
+ * NOISE_EXPORT_KEY_LEN.
+ * \param body The serialized object.  If the size is larger than the
+ * maximum size, then the object did not fit in the body buffer.
+ * \param blob The buffer to write the wrapped blob to.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a wrap_key or \a blob is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if \a wrap_key_len is incorrect or
+ * the wrapped blob is too large for \a blob.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory.
+ *
+ * \note Not part of the public API.
+ */
+int noise_export_seal
+    (int type, const uint8_t *wrap_key, size_t wrap_key_len,
+     const NoiseBuffer *body, NoiseBuffer *blob)
+{
+    NoiseCipherState *cipher;
+    NoiseBuffer mbuf;
+    int err;
+
+    /* Validate the parameters */
+    if (!blob || !(blob->data))
+        return NOISE_ERROR_INVALID_PARAM;
+    blob->size = 0;
+    if (!wrap_key)
+        return NOISE_ERROR_INVALID_PARAM;
+    if (wrap_key_len != NOISE_EXPORT_KEY_LEN)
+        return NOISE_ERROR_INVALID_LENGTH;
+    if (body->size > body->max_size ||
+            body->size > (NOISE_MAX_EXPORT_LEN - NOISE_EXPORT_OVERHEAD) ||
+            blob->max_size < (body->size + NOISE_EXPORT_OVERHEAD))
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* Format the header and generate a random salt */
+    blob->data[0] = 'N';
+    blob->data[1] = 'S';
+    blob->data[2] = NOISE_EXPORT_VERSION;
+    blob->data[3] = (uint8_t)type;
+    noise_rand_bytes(blob->data + NOISE_EXPORT_HEADER_LEN, NOISE_EXPORT_SALT_LEN);
+
+    /* Encrypt the body with the header and salt as associated data */
+    err = noise_export_create_cipher(&cipher, wrap_key, blob->data);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    memcpy(blob->data + NOISE_EXPORT_PREFIX_LEN, body->data, body->size);
+    noise_buffer_set_inout
+        (mbuf, blob->data + NOISE_EXPORT_PREFIX_LEN, body->size,
+         blob->max_size - NOISE_EXPORT_PREFIX_LEN);
+    err = noise_cipherstate_encrypt_with_ad
+        (cipher, blob->data, NOISE_EXPORT_PREFIX_LEN, &mbuf);
+    noise_cipherstate_free(cipher);
+    if (err != NOISE_ERROR_NONE) {
+        noise_clean(blob->data, blob->max_size);
+        return err;
+    }
+    blob->size = NOISE_EXPORT_PREFIX_LEN + mbuf.size;
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Verifies and decrypts the body of an exported object.
+ *
+ * \param type The expected type of object; e.g. NOISE_EXPORT_CIPHERSTATE.
+ * \param wrap_key Points to the wrapping key.
+ * \param wrap_key_len The length of the wrapping key, which must be
+ * NOISE_EXPORT_KEY_LEN.
+ * \param blob The wrapped blob.
+ * \param body The buffer to decrypt the body into, which must be at
+ * least NOISE_MAX_EXPORT_LEN bytes in size.  On exit, the size is set
+ * to zero and the maximum size to the length of the body so that the
+ * body can be parsed with noise_export_get_bytes().
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a wrap_key or \a blob is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if \a wrap_key_len is incorrect.
+ * \return NOISE_ERROR_INVALID_FORMAT if \a blob is not a wrapped
+ * object of the expected \a type.
+ * \return NOISE_ERROR_MAC_FAILURE if \a blob was not wrapped with
+ * \a wrap_key or it has been modified.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory.
+ *
+ * \note Not part of the public API.
+ */
+int noise_export_open
+    (int type, const uint8_t *wrap_key, size_t wrap_key_len,
+     const NoiseBuffer *blob, NoiseBuffer *body)
+{
+    NoiseCipherState *cipher;
+    NoiseBuffer mbuf;
+    int err;
+
+    /* Validate the parameters */
+    if (!blob || !(blob->data) || !wrap_key)
+        return NOISE_ERROR_INVALID_PARAM;
+    if (wrap_key_len != NOISE_EXPORT_KEY_LEN)
+        return NOISE_ERROR_INVALID_LENGTH;
+    if (blob->size < NOISE_EXPORT_OVERHEAD ||
+            blob->size > NOISE_MAX_EXPORT_LEN ||
+            blob->size > body->max_size + NOISE_EXPORT_PREFIX_LEN)
+        return NOISE_ERROR_INVALID_FORMAT;
+    if (blob->data[0] != 'N' || blob->data[1] != 'S' ||
+            blob->data[2] != NOISE_EXPORT_VERSION ||
+            blob->data[3] != (uint8_t)type)
+        return NOISE_ERROR_INVALID_FORMAT;
+
+    /* Decrypt the body into the caller's buffer */
+    err = noise_export_create_cipher(&cipher, wrap_key, blob->data);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    memcpy(body->data, blob->data + NOISE_EXPORT_PREFIX_LEN,
+           blob->size - NOISE_EXPORT_PREFIX_LEN);
+    noise_buffer_set_input
+        (mbuf, body->data, blob->size - NOISE_EXPORT_PREFIX_LEN);
+    err = noise_cipherstate_decrypt_with_ad
+        (cipher, blob->data, NOISE_EXPORT_PREFIX_LEN, &mbuf);
+    noise_cipherstate_free(cipher);
+    if (err != NOISE_ERROR_NONE) {
+        noise_clean(body->data, body->max_size);
+        return err;
+    }
+    body->size = 0;
+    body->max_size = mbuf.size;
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Appends bytes to the body of an exported object.
+ *
+ * \param body The body buffer.
+ * \param data Points to the bytes to append.
+ * \param len The number of bytes to append.
+ *
+ * If the bytes do not fit, then the size is advanced past the maximum
+ * size anyway, which noise_export_seal() reports as an error.
+ *
+ * \note Not part of the public API.
+ */
+void noise_export_put_bytes(NoiseBuffer *body, const uint8_t *data, size_t len)
+{
+    if (body->size <= body->max_size && len <= (body->max_size - body->size))
+        memcpy(body->data + body->size, data, len);
+    body->size += len;
+}
+
+/**
+ * \brief Appends a big-endian integer to the body of an exported object.
+ *
+ * \param body The body buffer.
+ * \param value The value to append.
+ * \param len The number of bytes in the encoded value, between 1 and 8.
+ *
+ * \note Not part of the public API.
+ */
+void noise_export_put_uint(NoiseBuffer *body, uint64_t value, size_t len)
+{
+    uint8_t data[8];
+    size_t posn;
+    for (posn = len; posn > 0; --posn) {
+        data[posn - 1] = (uint8_t)value;
+        value >>= 8;
+    }
+    noise_export_put_bytes(body, data, len);
+}
+
+/**
+ * \brief Reads bytes from the body of an exported object.
+ *
+ * \param body The body buffer, with the size set to the current read
+ * position and the maximum size set to the length of the body.
+ * \param data Points to the buffer to read into.
+ * \param len The number of bytes to read.
+ *
+ * If there are insufficient bytes left in the body, then \a data is
+ * filled with zeroes and the read position is moved past the end of
+ * the body.  Callers check for this at the end of parsing.
+ *
+ * \note Not part of the public API.
+ */
+void noise_export_get_bytes(NoiseBuffer *body, uint8_t *data, size_t len)
+{
+    if (body->size <= body->max_size && len <= (body->max_size - body->size)) {
+        memcpy(data, body->data + body->size, len);
+        body->size += len;
+    } else {
+        memset(data, 0, len);
+        body->size = body->max_size + 1;
+    }
+}
+
+/**
+ * \brief Reads a big-endian integer from the body of an exported object.
+ *
+ * \param body The body buffer.
+ * \param len The number of bytes in the encoded value, between 1 and 8.
+ *
+ * \return The value, or zero if there were insufficient bytes left.
+ *
+ * \note Not part of the public API.
+ */
+uint64_t noise_export_get_uint(NoiseBuffer *body, size_t len)
+{
+    uint8_t data[8];
+    uint64_t value = 0;
+    size_t posn;
+    noise_export_get_bytes(body, data, len);
+    for (posn = 0; posn < len; ++posn)
+        value = (value << 8) | data[posn];
+    return value;
+}
@@ -47,6 +47,18 @@
  * \brief Opaque object that represents a HandshakeState.
  */
 
+/**
+ * \typedef NoiseRemoteStaticCheckFunc
+ * \brief Callback that checks a remote static public key as soon as it
+ * has been received during a handshake.
+ *
+ * The callback is passed the user data that was supplied to
+ * noise_handshakestate_set_remote_static_check() and the DHState object
+ * that contains the remote static key.  It returns NOISE_ERROR_NONE to
+ * accept the key, or an error code such as NOISE_ERROR_KEY_REVOKED to
+ * abort the handshake.
+ */
+
 /**
  * \brief Gets the initial requirements for a handshake pattern.
  *
@@ -104,6 +116,7 @@ static int noise_handshakestate_new
 {
     const uint8_t *pattern;
     int dh_id;
+    int hybrid_id;
     uint8_t flags;
     int extra_reqs = 0;
     int err;
@@ -157,6 +170,10 @@ static int noise_handshakestate_new
         (flags, symmetric->id.prefix_id, role, 0);
     (*state)->action = NOISE_ACTION_NONE;
     (*state)->tokens = pattern + 1;
+    (*state)->compiled = noise_pattern_compiled_lookup
+        (symmetric->id.pattern_id,
+         symmetric->id.prefix_id == NOISE_PREFIX_PSK);
+    (*state)->message_index = 0;
     (*state)->role = role;
     (*state)->symmetric = symmetric;
 
@@ -172,11 +189,36 @@ static int noise_handshakestate_new
     if ((flags & NOISE_PAT_FLAG_REMOTE_EPHEMERAL) != 0 && err == NOISE_ERROR_NONE)
         err = noise_dhstate_new_by_id(&((*state)->dh_remote_ephemeral), dh_id);
 
+    /* Hybrid protocols have a second pair of ephemeral keys.  They only
+       make sense when both sides send an ephemeral so that there is an
+       "ee" to mix the second secret into.  Fallback is not supported
+       because the hybrid key would need to carry over as well */
+    hybrid_id = symmetric->id.hybrid_id;
+    if (hybrid_id && err == NOISE_ERROR_NONE) {
+        if (!(*state)->dh_local_ephemeral || !(*state)->dh_remote_ephemeral ||
+                (flags & NOISE_PAT_FLAG_REMOTE_EPHEM_REQ) != 0) {
+            err = NOISE_ERROR_NOT_APPLICABLE;
+        } else {
+            err = noise_dhstate_new_by_id
+                (&((*state)->dh_local_hybrid), hybrid_id);
+            if (err == NOISE_ERROR_NONE) {
+                err = noise_dhstate_new_by_id
+                    (&((*state)->dh_remote_hybrid), hybrid_id);
+            }
+        }
+
+        /* The compiled patterns only know about the classical keys */
+        (*state)->compiled = 0;
+        (*state)->requirements &= ~NOISE_REQ_FALLBACK_POSSIBLE;
+    }
+
     /* Set the roles for the DHState objects */
     noise_dhstate_set_role((*state)->dh_local_ephemeral, local_dh_role);
     noise_dhstate_set_role((*state)->dh_local_static, local_dh_role);
     noise_dhstate_set_role((*state)->dh_remote_ephemeral, remote_dh_role);
     noise_dhstate_set_role((*state)->dh_remote_static, remote_dh_role);
+    noise_dhstate_set_role((*state)->dh_local_hybrid, local_dh_role);
+    noise_dhstate_set_role((*state)->dh_remote_hybrid, remote_dh_role);
 
     /* If the DH algorithm is ephemeral-only, then we need to apply some
      * extra checks on the pattern: essentially, only "NN" is possible */
@@ -196,6 +238,7 @@ static int noise_handshakestate_new
     /* Bail out if we had an error trying to create the DHState objects */
     if (err != NOISE_ERROR_NONE) {
         noise_handshakestate_free(*state);
+        *state = 0;
         return err;
     }
 
@@ -323,8 +366,14 @@ int noise_handshakestate_free(NoiseHandshakeState *state)
         noise_dhstate_free(state->dh_remote_static);
     if (state->dh_remote_ephemeral)
         noise_dhstate_free(state->dh_remote_ephemeral);
+    if (state->dh_local_hybrid)
+        noise_dhstate_free(state->dh_local_hybrid);
+    if (state->dh_remote_hybrid)
+        noise_dhstate_free(state->dh_remote_hybrid);
     if (state->dh_fixed_ephemeral)
         noise_dhstate_free(state->dh_fixed_ephemeral);
+    if (state->dh_fixed_hybrid)
+        noise_dhstate_free(state->dh_fixed_hybrid);
     noise_free(state->prologue, state->prologue_len);
 
     /* Clean and free the memory for "state" */
@@ -442,6 +491,42 @@ NoiseDHState *noise_handshakestate_get_fixed_ephemeral_dh
     return state->dh_fixed_ephemeral;
 }
 
+/**
+ * \brief Gets the DHState object that contains the local hybrid
+ * ephemeral keypair.
+ *
+ * \param state The HandshakeState object.
+ *
+ * \return Returns a pointer to the DHState object for the local hybrid
+ * ephemeral keypair, or NULL if the protocol is not hybrid, the system is
+ * out of memory, or \a state is NULL.
+ *
+ * \note This function is intended for testing only.  It can be used to
+ * establish a fixed hybrid ephemeral key for test vectors.  This function
+ * should not be used in real applications.
+ *
+ * \sa noise_handshakestate_get_fixed_ephemeral_dh()
+ */
+NoiseDHState *noise_handshakestate_get_fixed_hybrid_ephemeral_dh
+    (NoiseHandshakeState *state)
+{
+    if (!state || !state->dh_local_hybrid)
+        return 0;
+
+    if (!state->dh_fixed_hybrid) {
+        if (noise_dhstate_new_by_id
+                (&(state->dh_fixed_hybrid), state->symmetric->id.hybrid_id)
+              != NOISE_ERROR_NONE) {
+            return 0;
+        }
+        noise_dhstate_set_role
+            (state->dh_fixed_hybrid,
+             noise_dhstate_get_role(state->dh_local_hybrid));
+    }
+
+    return state->dh_fixed_hybrid;
+}
+
 /**
  * \brief Determine if a HandshakeState object requires a pre shared key.
  *
@@ -569,6 +654,39 @@ int noise_handshakestate_set_prologue
     return NOISE_ERROR_NONE;
 }
 
+/**
+ * \brief Sets a callback to check the remote static public key as soon
+ * as it is received during the handshake.
+ *
+ * \param state The HandshakeState object.
+ * \param check The callback function, or NULL to remove the callback.
+ * \param user_data User data to pass to \a check.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a state is NULL.
+ *
+ * The callback is invoked by noise_handshakestate_read_message() directly
+ * after the "s" token has been decrypted, before any further DH operations
+ * are performed with the key.  If the callback returns an error code,
+ * then the handshake fails with that error.  This allows a responder to
+ * reject unknown or revoked client keys without finishing the handshake.
+ *
+ * The callback is not invoked for remote static keys that the application
+ * supplies itself with noise_handshakestate_get_remote_public_key_dh().
+ *
+ * \sa noise_handshakestate_read_message(), noise_revocation_check_dhstate()
+ */
+int noise_handshakestate_set_remote_static_check
+    (NoiseHandshakeState *state, NoiseRemoteStaticCheckFunc check,
+     void *user_data)
+{
+    if (!state)
+        return NOISE_ERROR_INVALID_PARAM;
+    state->remote_static_check = check;
+    state->remote_static_check_data = check ? user_data : 0;
+    return NOISE_ERROR_NONE;
+}
+
 /**
  * \brief Determine if a HandshakeState still needs to be configured
  * with a local keypair.
@@ -952,6 +1070,9 @@ int noise_handshakestate_fallback_to(NoiseHandshakeState *state, int pattern_id)
 
     /* Start a new token pattern for the fallback */
     state->tokens = pattern + 1;
+    state->compiled = noise_pattern_compiled_lookup
+        (pattern_id, id.prefix_id == NOISE_PREFIX_PSK);
+    state->message_index = 0;
     state->action = NOISE_ACTION_NONE;
 
     /* Set up the key requirements for the fallback */
@@ -1020,6 +1141,66 @@ int noise_handshakestate_get_action(const NoiseHandshakeState *state)
     return state ? state->action : NOISE_ACTION_NONE;
 }
 
+/**
+ * \brief Generates a local ephemeral keypair.
+ *
+ * \param local The DHState object for the local ephemeral keypair.
+ * \param fixed The DHState object for the fixed test keypair, or NULL.
+ * \param remote The DHState object for the remote ephemeral key.
+ *
+ * \return NOISE_ERROR_NONE on success, or an error code from
+ * noise_dhstate_generate_dependent_keypair() otherwise.
+ */
+static int noise_handshakestate_new_keypair
+    (NoiseDHState *local, const NoiseDHState *fixed,
+     const NoiseDHState *remote)
+{
+    if (!fixed)
+        return noise_dhstate_generate_dependent_keypair(local, remote);
+
+    /* Use the fixed ephemeral key provided by the test harness.
+       To support New Hope we need to perform a dependent copy */
+    local->key_type = fixed->key_type;
+    return (*(local->copy))(local, fixed, remote);
+}
+
+/**
+ * \brief Generates the local ephemeral keypair for an "e" token.
+ *
+ * \param state The HandshakeState object.
+ *
+ * \return NOISE_ERROR_NONE on success, or an error code from
+ * noise_dhstate_generate_dependent_keypair() otherwise.
+ *
+ * If we are running fixed vector tests, then the ephemeral key may
+ * have already been provided and will be copied instead.
+ */
+int noise_handshakestate_new_ephemeral(NoiseHandshakeState *state)
+{
+    return noise_handshakestate_new_keypair
+        (state->dh_local_ephemeral, state->dh_fixed_ephemeral,
+         state->dh_remote_ephemeral);
+}
+
+/**
+ * \brief Passes a newly received remote static key to the application's
+ * check callback.
+ *
+ * \param state The HandshakeState object.
+ *
+ * \return NOISE_ERROR_NONE if there is no callback or the callback
+ * accepted the key, or the callback's error code otherwise.
+ *
+ * \sa noise_handshakestate_set_remote_static_check()
+ */
+int noise_handshakestate_check_remote_static(NoiseHandshakeState *state)
+{
+    if (!state->remote_static_check)
+        return NOISE_ERROR_NONE;
+    return (*(state->remote_static_check))
+        (state->remote_static_check_data, state->dh_remote_static);
+}
+
 /**
  * \brief Performs a Diffie-Hellman operation and mixes the result into
  * the chaining key.
@@ -1031,7 +1212,7 @@ int noise_handshakestate_get_action(const NoiseHandshakeState *state)
  * \return NOISE_ERROR_NONE on success, or an error code from
  * noise_dhstate_calculate() otherwise.
  */
-static int noise_handshake_mix_dh
+int noise_handshakestate_mix_dh
     (NoiseHandshakeState *state, const NoiseDHState *private_key,
      const NoiseDHState *public_key)
 {
@@ -1094,18 +1275,7 @@ static int noise_handshakestate_write
                then the ephemeral key may have already been provided. */
             if (!state->dh_local_ephemeral)
                 return NOISE_ERROR_INVALID_STATE;
-            if (!state->dh_fixed_ephemeral) {
-                err = noise_dhstate_generate_dependent_keypair
-                    (state->dh_local_ephemeral, state->dh_remote_ephemeral);
-            } else {
-                /* Use the fixed ephemeral key provided by the test harness.
-                   To support New Hope we need to perform a dependent copy */
-                state->dh_local_ephemeral->key_type =
-                    state->dh_fixed_ephemeral->key_type;
-                err = (*(state->dh_local_ephemeral->copy))
-                    (state->dh_local_ephemeral, state->dh_fixed_ephemeral,
-                     state->dh_remote_ephemeral);
-            }
+            err = noise_handshakestate_new_ephemeral(state);
             if (err != NOISE_ERROR_NONE)
                 break;
             len = state->dh_local_ephemeral->public_key_len;
@@ -1122,6 +1292,31 @@ static int noise_handshakestate_write
                     (state->symmetric,
                      state->dh_local_ephemeral->public_key, len);
             }
+            if (err != NOISE_ERROR_NONE || !state->dh_local_hybrid)
+                break;
+
+            /* Hybrid protocols follow the classical ephemeral key with
+               the public key for the hybrid algorithm, which is treated
+               in the same way.  The responder's key may depend upon the
+               initiator's; e.g. for New Hope */
+            err = noise_handshakestate_new_keypair
+                (state->dh_local_hybrid, state->dh_fixed_hybrid,
+                 state->dh_remote_hybrid);
+            if (err != NOISE_ERROR_NONE)
+                break;
+            len = state->dh_local_hybrid->public_key_len;
+            if ((rest.max_size - rest.size) < len)
+                return NOISE_ERROR_INVALID_LENGTH;
+            memcpy(rest.data + rest.size,
+                   state->dh_local_hybrid->public_key, len);
+            noise_symmetricstate_mix_hash
+                (state->symmetric, rest.data + rest.size, len);
+            rest.size += len;
+            if (state->symmetric->id.prefix_id == NOISE_PREFIX_PSK) {
+                err = noise_symmetricstate_mix_key
+                    (state->symmetric,
+                     state->dh_local_hybrid->public_key, len);
+            }
             break;
         case NOISE_TOKEN_S:
             /* Encrypt the local static public key and add it to the message */
@@ -1138,23 +1333,28 @@ static int noise_handshakestate_write
                 break;
             break;
         case NOISE_TOKEN_DHEE:
-            /* DH operation with local and remote ephemeral keys */
-            err = noise_handshake_mix_dh
+            /* DH operation with local and remote ephemeral keys, followed
+               by the hybrid ephemeral keys if there are any */
+            err = noise_handshakestate_mix_dh
                 (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+            if (err == NOISE_ERROR_NONE && state->dh_local_hybrid) {
+                err = noise_handshakestate_mix_dh
+                    (state, state->dh_local_hybrid, state->dh_remote_hybrid);
+            }
             break;
         case NOISE_TOKEN_DHES:
             /* DH operation with local ephemeral and remote static keys */
-            err = noise_handshake_mix_dh
+            err = noise_handshakestate_mix_dh
                 (state, state->dh_local_ephemeral, state->dh_remote_static);
             break;
         case NOISE_TOKEN_DHSE:
             /* DH operation with local static and remote ephemeral keys */
-            err = noise_handshake_mix_dh
+            err = noise_handshakestate_mix_dh
                 (state, state->dh_local_static, state->dh_remote_ephemeral);
             break;
         case NOISE_TOKEN_DHSS:
             /* DH operation with local and remote static keys */
-            err = noise_handshake_mix_dh
+            err = noise_handshakestate_mix_dh
                 (state, state->dh_local_static, state->dh_remote_static);
             break;
         default:
@@ -1246,12 +1446,20 @@ int noise_handshakestate_write_message
     if (state->action != NOISE_ACTION_WRITE_MESSAGE)
         return NOISE_ERROR_INVALID_STATE;
 
-    /* Perform the write */
-    err = noise_handshakestate_write(state, message, payload);
+    /* Perform the write, preferring the compiled form of the pattern */
+    if (state->compiled &&
+            state->message_index < state->compiled->num_messages) {
+        err = (*(state->compiled->messages[state->message_index].write))
+            (state, message, payload);
+    } else {
+        err = noise_handshakestate_write(state, message, payload);
+    }
     if (err != NOISE_ERROR_NONE) {
         /* Set the state to "failed" and empty the message buffer */
         state->action = NOISE_ACTION_FAILED;
         message->size = 0;
+    } else {
+        ++(state->message_index);
     }
     return err;
 }
@@ -1333,6 +1541,31 @@ static int noise_handshakestate_read
                     (state->symmetric,
                      state->dh_remote_ephemeral->public_key, len);
             }
+            if (err != NOISE_ERROR_NONE || !state->dh_remote_hybrid)
+                break;
+
+            /* Read the hybrid ephemeral key that follows */
+            len = state->dh_remote_hybrid->public_key_len;
+            if (msg.size < len)
+                return NOISE_ERROR_INVALID_LENGTH;
+            err = noise_symmetricstate_mix_hash
+                (state->symmetric, msg.data, len);
+            if (err != NOISE_ERROR_NONE)
+                break;
+            err = noise_dhstate_set_public_key
+                (state->dh_remote_hybrid, msg.data, len);
+            if (err != NOISE_ERROR_NONE)
+                break;
+            if (noise_dhstate_is_null_public_key(state->dh_remote_hybrid))
+                return NOISE_ERROR_INVALID_PUBLIC_KEY;
+            msg.data += len;
+            msg.size -= len;
+            msg.max_size -= len;
+            if (state->symmetric->id.prefix_id == NOISE_PREFIX_PSK) {
+                err = noise_symmetricstate_mix_key
+                    (state->symmetric,
+                     state->dh_remote_hybrid->public_key, len);
+            }
             break;
         case NOISE_TOKEN_S:
             /* Decrypt and read the remote static key */
@@ -1351,6 +1584,9 @@ static int noise_handshakestate_read
                 break;
             err = noise_dhstate_set_public_key
                 (state->dh_remote_static, msg2.data, msg2.size);
+            if (err != NOISE_ERROR_NONE)
+                break;
+            err = noise_handshakestate_check_remote_static(state);
             if (err != NOISE_ERROR_NONE)
                 break;
             msg.data += len;
@@ -1358,23 +1594,28 @@ static int noise_handshakestate_read
             msg.max_size -= len;
             break;
         case NOISE_TOKEN_DHEE:
-            /* DH operation with local and remote ephemeral keys */
-            err = noise_handshake_mix_dh
+            /* DH operation with local and remote ephemeral keys, followed
+               by the hybrid ephemeral keys if there are any */
+            err = noise_handshakestate_mix_dh
                 (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+            if (err == NOISE_ERROR_NONE && state->dh_local_hybrid) {
+                err = noise_handshakestate_mix_dh
+                    (state, state->dh_local_hybrid, state->dh_remote_hybrid);
+            }
             break;
         case NOISE_TOKEN_DHES:
             /* DH operation with remote ephemeral and local static keys */
-            err = noise_handshake_mix_dh
+            err = noise_handshakestate_mix_dh
                 (state, state->dh_local_static, state->dh_remote_ephemeral);
             break;
         case NOISE_TOKEN_DHSE:
             /* DH operation with remote static and local ephemeral keys */
-            err = noise_handshake_mix_dh
+            err = noise_handshakestate_mix_dh
                 (state, state->dh_local_ephemeral, state->dh_remote_static);
             break;
         case NOISE_TOKEN_DHSS:
             /* DH operation with local and remote static keys */
-            err = noise_handshake_mix_dh
+            err = noise_handshakestate_mix_dh
                 (state, state->dh_local_static, state->dh_remote_static);
             break;
         default:
@@ -1455,11 +1696,19 @@ int noise_handshakestate_read_message
     if (state->action != NOISE_ACTION_READ_MESSAGE)
         return NOISE_ERROR_INVALID_STATE;
 
-    /* Perform the read */
-    err = noise_handshakestate_read(state, message, payload);
+    /* Perform the read, preferring the compiled form of the pattern */
+    if (state->compiled &&
+            state->message_index < state->compiled->num_messages) {
+        err = (*(state->compiled->messages[state->message_index].read))
+            (state, message, payload);
+    } else {
+        err = noise_handshakestate_read(state, message, payload);
+    }
     noise_clean(message->data, message->size);
     if (err != NOISE_ERROR_NONE)
         state->action = NOISE_ACTION_FAILED;
+    else
+        ++(state->message_index);
     return err;
 }
 
@@ -1588,6 +1837,199 @@ int noise_handshakestate_split_with_key
     return err;
 }
 
+/**
+ * \brief Splits the transport encryption CipherState objects out of
+ * a batch of HandshakeState objects.
+ *
+ * \param states Points to an array of HandshakeState objects.
+ * \param send Points to an array that receives the CipherState object
+ * to use to send packets from local to remote for each handshake.
+ * This can be NULL if the application is using a one-way handshake pattern.
+ * \param receive Points to an array that receives the CipherState object
+ * to use to receive packets from remote to local for each handshake.
+ * This can be NULL if the application is using a one-way handshake pattern.
+ * \param count The number of HandshakeState objects in \a states.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a states or one of its elements
+ * is NULL, or both \a send and \a receive are NULL.
+ * \return NOISE_ERROR_INVALID_STATE if one of the \a states has already
+ * been split or its handshake protocol has not completed successfully yet.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory to create
+ * the new CipherState objects.
+ *
+ * The results are the same as calling noise_handshakestate_split() on
+ * each HandshakeState in turn.  This is intended for servers that complete
+ * many handshakes at once: the HKDF computations for consecutive handshakes
+ * that use the same hash algorithm are performed together with
+ * noise_hashstate_hkdf_multi(), which can hash up to 8 of them in
+ * parallel.  Secondary symmetric keys are not supported; use
+ * noise_handshakestate_split_with_key() for those handshakes.
+ *
+ * All of the \a states are validated before any of them are split.
+ * If NOISE_ERROR_NO_MEMORY is reported, then the handshakes before the
+ * one that failed have been split and their CipherState objects have
+ * been returned to the caller.
+ *
+ * \sa noise_handshakestate_split(), noise_hashstate_hkdf_multi()
+ */
+int noise_handshakestate_split_multi
+    (NoiseHandshakeState **states, NoiseCipherState **send,
+     NoiseCipherState **receive, size_t count)
+{
+    NoiseHashState *hashes[NOISE_MAX_HASH_LANES];
+    const uint8_t *keys[NOISE_MAX_HASH_LANES];
+    uint8_t temp_k1[NOISE_MAX_HASH_LANES][NOISE_MAX_HASHLEN];
+    uint8_t temp_k2[NOISE_MAX_HASH_LANES][NOISE_MAX_HASHLEN];
+    uint8_t *k1[NOISE_MAX_HASH_LANES];
+    uint8_t *k2[NOISE_MAX_HASH_LANES];
+    NoiseHandshakeState *state;
+    NoiseCipherState **c_send;
+    NoiseCipherState **c_receive;
+    size_t index, lanes, lane;
+    size_t hash_len, key_len;
+    int err = NOISE_ERROR_NONE;
+
+    /* Validate the parameters */
+    if (!states || (!send && !receive))
+        return NOISE_ERROR_INVALID_PARAM;
+    for (index = 0; index < count; ++index) {
+        if (!states[index])
+            return NOISE_ERROR_INVALID_PARAM;
+    }
+    for (index = 0; index < count; ++index) {
+        state = states[index];
+        if (state->action != NOISE_ACTION_SPLIT || !state->symmetric->cipher)
+            return NOISE_ERROR_INVALID_STATE;
+        if (send)
+            send[index] = 0;
+        if (receive)
+            receive[index] = 0;
+    }
+    for (lane = 0; lane < NOISE_MAX_HASH_LANES; ++lane) {
+        k1[lane] = temp_k1[lane];
+        k2[lane] = temp_k2[lane];
+    }
+
+    /* Process runs of handshakes that use the same algorithms */
+    index = 0;
+    while (index < count && err == NOISE_ERROR_NONE) {
+        state = states[index];
+        hash_len = noise_hashstate_get_hash_length(state->symmetric->hash);
+        key_len = noise_cipherstate_get_key_length(state->symmetric->cipher);
+        for (lanes = 0; lanes < NOISE_MAX_HASH_LANES && (index + lanes) < count;
+                ++lanes) {
+            NoiseSymmetricState *symmetric = states[index + lanes]->symmetric;
+            if (symmetric->hash->hash_id != state->symmetric->hash->hash_id ||
+                    noise_cipherstate_get_key_length(symmetric->cipher) != key_len)
+                break;
+            hashes[lanes] = symmetric->hash;
+            keys[lanes] = symmetric->ck;
+        }
+
+        /* Generate the encryption keys for the whole run with HKDF */
+        noise_hashstate_hkdf_multi
+            (hashes, keys, hash_len, keys, 0, k1, key_len, k2, key_len, lanes);
+
+        /* Split the CipherState objects out of each SymmetricState,
+           swapping the objects for the role as necessary */
+        for (lane = 0; lane < lanes; ++lane, ++index) {
+            state = states[index];
+            c_send = send ? &(send[index]) : 0;
+            c_receive = receive ? &(receive[index]) : 0;
+            if (state->role == NOISE_ROLE_RESPONDER) {
+                err = noise_symmetricstate_split_keys
+                    (state->symmetric, c_receive, c_send,
+                     temp_k1[lane], temp_k2[lane], key_len);
+            } else {
+                err = noise_symmetricstate_split_keys
+                    (state->symmetric, c_send, c_receive,
+                     temp_k1[lane], temp_k2[lane], key_len);
+            }
+            if (err != NOISE_ERROR_NONE)
+                break;
+            state->action = NOISE_ACTION_COMPLETE;
+        }
+    }
+
+    /* Clean up and exit */
+    noise_clean(temp_k1, sizeof(temp_k1));
+    noise_clean(temp_k2, sizeof(temp_k2));
+    return err;
+}
+
+/**
+ * \brief Splits a compact transport session out of this HandshakeState
+ * object.
+ *
+ * \param state The HandshakeState object.
+ * \param session Points to the variable where to place the pointer to
+ * the new CompactSession object.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a state or \a session is NULL.
+ * \return NOISE_ERROR_INVALID_STATE if the \a state has already been split
+ * or the handshake protocol has not completed successfully yet.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory to create
+ * the new CompactSession object.
+ *
+ * This derives the same keys as noise_handshakestate_split(), but stores
+ * them in a single CompactSession object instead of a pair of CipherState
+ * objects.  The working CipherState of the handshake is freed.  This is
+ * intended for servers that need to keep a large number of mostly idle
+ * sessions in memory.
+ *
+ * \sa noise_handshakestate_split(), noise_compactsession_encrypt()
+ */
+int noise_handshakestate_split_compact
+    (NoiseHandshakeState *state, NoiseCompactSession **session)
+{
+    uint8_t temp_k1[NOISE_MAX_HASHLEN];
+    uint8_t temp_k2[NOISE_MAX_HASHLEN];
+    NoiseSymmetricState *symmetric;
+    size_t hash_len;
+    size_t key_len;
+    int err;
+
+    /* Validate the parameters */
+    if (!session)
+        return NOISE_ERROR_INVALID_PARAM;
+    *session = 0;
+    if (!state)
+        return NOISE_ERROR_INVALID_PARAM;
+    if (state->action != NOISE_ACTION_SPLIT)
+        return NOISE_ERROR_INVALID_STATE;
+    symmetric = state->symmetric;
+    if (!symmetric->cipher)
+        return NOISE_ERROR_INVALID_STATE;
+
+    /* Generate the two encryption keys with HKDF */
+    hash_len = noise_hashstate_get_hash_length(symmetric->hash);
+    key_len = noise_cipherstate_get_key_length(symmetric->cipher);
+    noise_hashstate_hkdf
+        (symmetric->hash, symmetric->ck, hash_len, symmetric->ck, 0,
+         temp_k1, key_len, temp_k2, key_len);
+
+    /* The responder sends with the second key and receives with the first */
+    if (state->role == NOISE_ROLE_RESPONDER) {
+        err = noise_compactsession_new
+            (session, symmetric->cipher->cipher_id, temp_k2, temp_k1, key_len);
+    } else {
+        err = noise_compactsession_new
+            (session, symmetric->cipher->cipher_id, temp_k1, temp_k2, key_len);
+    }
+    noise_clean(temp_k1, sizeof(temp_k1));
+    noise_clean(temp_k2, sizeof(temp_k2));
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* The handshake's CipherState is no longer required */
+    noise_cipherstate_free(symmetric->cipher);
+    symmetric->cipher = 0;
+    state->action = NOISE_ACTION_COMPLETE;
+    return NOISE_ERROR_NONE;
+}
+
 /**
  * \brief Gets the handshake hash value once the handshake ends.
  *
@@ -1640,4 +2082,371 @@ int noise_handshakestate_get_handshake_hash
     return NOISE_ERROR_NONE;
 }
 
+/**
+ * \brief Gets the resumption secret for a completed handshake.
+ *
+ * \param state The HandshakeState object.
+ * \param secret The buffer to receive the resumption secret.
+ * \param secret_len The length of \a secret, which must be
+ * NOISE_RESUMPTION_SECRET_LEN.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a state or \a secret is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if \a secret_len is incorrect.
+ * \return NOISE_ERROR_INVALID_STATE if the handshake has not successfully
+ * completed yet.
+ *
+ * The resumption secret is HKDF(ck, "NoiseResumption" || h), where "ck"
+ * is the final chaining key and "h" is the handshake hash.  Both parties
+ * derive the same value, which is independent of the transport keys.
+ * The handshake hash on its own is not secret, which is why the chaining
+ * key is used as the HKDF key.
+ *
+ * The secret is intended to be used as the pre-shared key for a later
+ * "NoisePSK_NN" handshake between the same parties.  The responder
+ * normally wraps it in a ticket with noise_ticketissuer_issue() and the
+ * initiator keeps a copy of the secret along with the ticket.
+ *
+ * \sa noise_ticketissuer_issue(), noise_handshakestate_set_pre_shared_key()
+ */
+int noise_handshakestate_get_resumption_secret
+    (const NoiseHandshakeState *state, uint8_t *secret, size_t secret_len)
+{
+    static char const label[] = "NoiseResumption";
+    uint8_t data[sizeof(label) - 1 + NOISE_MAX_HASHLEN];
+    uint8_t temp[NOISE_MAX_HASHLEN];
+    size_t hash_len;
+
+    /* Validate the parameters */
+    if (!state || !secret)
+        return NOISE_ERROR_INVALID_PARAM;
+    if (secret_len != NOISE_RESUMPTION_SECRET_LEN)
+        return NOISE_ERROR_INVALID_LENGTH;
+    if (state->action != NOISE_ACTION_SPLIT &&
+            state->action != NOISE_ACTION_COMPLETE)
+        return NOISE_ERROR_INVALID_STATE;
+
+    /* Derive the secret from the chaining key and handshake hash */
+    hash_len = noise_hashstate_get_hash_length(state->symmetric->hash);
+    memcpy(data, label, sizeof(label) - 1);
+    memcpy(data + sizeof(label) - 1, state->symmetric->h, hash_len);
+    noise_hashstate_hkdf
+        (state->symmetric->hash, state->symmetric->ck, hash_len,
+         data, sizeof(label) - 1 + hash_len,
+         secret, secret_len, temp, secret_len);
+    noise_clean(temp, sizeof(temp));
+    return NOISE_ERROR_NONE;
+}
+
+/** @cond */
+
+/* Kinds of key that can be stored in a DHState slot of an export */
+#define NOISE_EXPORT_KEY_NONE       0
+#define NOISE_EXPORT_KEY_PUBLIC     1
+#define NOISE_EXPORT_KEY_PRIVATE    2
+#define NOISE_EXPORT_KEY_NULL       3
+
+/* Maximum size of a key for DH algorithms that can be exported */
+#define NOISE_EXPORT_MAX_DH_KEY_LEN 64
+
+/** @endcond */
+
+/**
+ * \brief Determine if a DHState can be written to an exported object.
+ *
+ * \param dh The DHState object, which may be NULL.
+ *
+ * \return Non-zero if the DHState can be exported.
+ *
+ * The post-quantum algorithms keep state between generating a keypair
+ * and calculating the shared secret that cannot be recreated from the
+ * keys alone, so they are not supported.
+ */
+static int noise_handshakestate_can_export_dh(const NoiseDHState *dh)
+{
+    if (!dh)
+        return 1;
+    return !dh->ephemeral_only &&
+           dh->private_key_len <= NOISE_EXPORT_MAX_DH_KEY_LEN &&
+           dh->public_key_len <= NOISE_EXPORT_MAX_DH_KEY_LEN;
+}
+
+/**
+ * \brief Writes the key in a DHState to the body of an exported object.
+ *
+ * \param dh The DHState object, which may be NULL.
+ * \param body The body buffer.
+ *
+ * Only the private key is written for keypairs because the public key
+ * can be derived from it on import.
+ */
+static void noise_handshakestate_write_dh
+    (const NoiseDHState *dh, NoiseBuffer *body)
+{
+    if (noise_dhstate_has_keypair(dh)) {
+        noise_export_put_uint(body, NOISE_EXPORT_KEY_PRIVATE, 1);
+        noise_export_put_bytes(body, dh->private_key, dh->private_key_len);
+    } else if (noise_dhstate_is_null_public_key(dh)) {
+        noise_export_put_uint(body, NOISE_EXPORT_KEY_NULL, 1);
+    } else if (noise_dhstate_has_public_key(dh)) {
+        noise_export_put_uint(body, NOISE_EXPORT_KEY_PUBLIC, 1);
+        noise_export_put_bytes(body, dh->public_key, dh->public_key_len);
+    } else {
+        noise_export_put_uint(body, NOISE_EXPORT_KEY_NONE, 1);
+    }
+}
+
+/**
+ * \brief Reads the key for a DHState from the body of an exported object.
+ *
+ * \param dh The DHState object, which may be NULL if the pattern does
+ * not use this key.
+ * \param body The body buffer.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_FORMAT if the body is malformed.
+ * \return NOISE_ERROR_INVALID_PRIVATE_KEY or
+ * NOISE_ERROR_INVALID_PUBLIC_KEY if the key is invalid.
+ */
+static int noise_handshakestate_read_dh(NoiseDHState *dh, NoiseBuffer *body)
+{
+    uint8_t key[NOISE_EXPORT_MAX_DH_KEY_LEN];
+    int kind = (int)noise_export_get_uint(body, 1);
+    int err = NOISE_ERROR_NONE;
+    if (kind == NOISE_EXPORT_KEY_NONE)
+        return NOISE_ERROR_NONE;
+    if (!dh || !noise_handshakestate_can_export_dh(dh))
+        return NOISE_ERROR_INVALID_FORMAT;
+    if (kind == NOISE_EXPORT_KEY_PRIVATE) {
+        noise_export_get_bytes(body, key, dh->private_key_len);
+        if (body->size <= body->max_size) {
+            err = noise_dhstate_set_keypair_private
+                (dh, key, dh->private_key_len);
+        }
+    } else if (kind == NOISE_EXPORT_KEY_PUBLIC) {
+        noise_export_get_bytes(body, key, dh->public_key_len);
+        if (body->size <= body->max_size) {
+            err = noise_dhstate_set_public_key
+                (dh, key, dh->public_key_len);
+        }
+    } else if (kind == NOISE_EXPORT_KEY_NULL) {
+        err = noise_dhstate_set_null_public_key(dh);
+    } else {
+        err = NOISE_ERROR_INVALID_FORMAT;
+    }
+    noise_clean(key, sizeof(key));
+    if (body->size > body->max_size)
+        return NOISE_ERROR_INVALID_FORMAT;
+    return err;
+}
+
+/**
+ * \brief Exports an in-progress HandshakeState in an encrypted and
+ * authenticated blob.
+ *
+ * \param state The HandshakeState object.
+ * \param wrap_key Points to the key to wrap the blob with.
+ * \param wrap_key_len The length of \a wrap_key, which must be
+ * NOISE_EXPORT_KEY_LEN.
+ * \param blob The buffer to write the blob to.  NOISE_MAX_EXPORT_LEN
+ * bytes are always sufficient.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a state, \a wrap_key, or
+ * \a blob is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if \a wrap_key_len is incorrect or
+ * \a blob is not large enough.
+ * \return NOISE_ERROR_INVALID_STATE if the handshake has not been
+ * started, has failed, or has already been split.
+ * \return NOISE_ERROR_NOT_APPLICABLE if the protocol uses a post-quantum
+ * or hybrid DH algorithm.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory.
+ *
+ * This takes a snapshot of a handshake between messages so that it can
+ * be resumed in another process with noise_handshakestate_import().
+ * The blob contains the SymmetricState, the local keypairs, the remote
+ * public keys, the pre-shared key, and the position in the pattern.
+ *
+ * The remote static key check callback and the fixed ephemeral key for
+ * testing are not exported.  The application must set the callback again
+ * on the imported HandshakeState if it is needed for later messages.
+ * Once a HandshakeState has been exported it should be freed without
+ * being used again.
+ *
+ * \sa noise_handshakestate_import(), noise_symmetricstate_export()
+ */
+int noise_handshakestate_export
+    (const NoiseHandshakeState *state, const uint8_t *wrap_key,
+     size_t wrap_key_len, NoiseBuffer *blob)
+{
+    uint8_t data[NOISE_MAX_EXPORT_LEN];
+    NoiseBuffer body;
+    int err;
+
+    /* Validate the parameters */
+    if (!state)
+        return NOISE_ERROR_INVALID_PARAM;
+    if (state->action != NOISE_ACTION_WRITE_MESSAGE &&
+            state->action != NOISE_ACTION_READ_MESSAGE &&
+            state->action != NOISE_ACTION_SPLIT)
+        return NOISE_ERROR_INVALID_STATE;
+    if (state->symmetric->id.hybrid_id ||
+            !noise_handshakestate_can_export_dh(state->dh_local_static) ||
+            !noise_handshakestate_can_export_dh(state->dh_local_ephemeral) ||
+            !noise_handshakestate_can_export_dh(state->dh_remote_static) ||
+            !noise_handshakestate_can_export_dh(state->dh_remote_ephemeral))
+        return NOISE_ERROR_NOT_APPLICABLE;
+
+    /* Serialize the handshake */
+    noise_buffer_set_output(body, data, sizeof(data));
+    noise_symmetricstate_write_export(state->symmetric, &body);
+    noise_export_put_uint(&body, (uint64_t)(state->role), 2);
+    noise_export_put_uint(&body, (uint64_t)(state->action), 2);
+    noise_export_put_uint(&body, (uint64_t)(state->requirements), 2);
+    noise_export_put_uint
+        (&body, (uint64_t)(state->tokens -
+                    noise_pattern_lookup(state->symmetric->id.pattern_id)), 1);
+    noise_export_put_uint(&body, state->message_index, 1);
+    noise_export_put_uint(&body, state->pre_shared_key_len, 1);
+    noise_export_put_bytes
+        (&body, state->pre_shared_key, state->pre_shared_key_len);
+    noise_handshakestate_write_dh(state->dh_local_static, &body);
+    noise_handshakestate_write_dh(state->dh_local_ephemeral, &body);
+    noise_handshakestate_write_dh(state->dh_remote_static, &body);
+    noise_handshakestate_write_dh(state->dh_remote_ephemeral, &body);
+
+    /* Wrap it up */
+    err = noise_export_seal
+        (NOISE_EXPORT_HANDSHAKESTATE, wrap_key, wrap_key_len, &body, blob);
+    noise_clean(data, sizeof(data));
+    return err;
+}
+
+/**
+ * \brief Parses a HandshakeState from the body of an exported object.
+ *
+ * \param state Points to the variable where to store the pointer to
+ * the new HandshakeState object.
+ * \param body The body buffer.
+ *
+ * \return NOISE_ERROR_NONE on success, or an error code otherwise.
+ */
+static int noise_handshakestate_read_export
+    (NoiseHandshakeState **state, NoiseBuffer *body)
+{
+    NoiseSymmetricState *symmetric;
+    const uint8_t *pattern;
+    int role, action, requirements;
+    size_t token_offset, posn;
+    int err;
+
+    /* Create the HandshakeState around the exported SymmetricState */
+    err = noise_symmetricstate_read_export(&symmetric, body);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    role = (int)noise_export_get_uint(body, 2);
+    action = (int)noise_export_get_uint(body, 2);
+    requirements = (int)noise_export_get_uint(body, 2);
+    token_offset = (size_t)noise_export_get_uint(body, 1);
+    if (role != NOISE_ROLE_INITIATOR && role != NOISE_ROLE_RESPONDER) {
+        noise_symmetricstate_free(symmetric);
+        return NOISE_ERROR_INVALID_FORMAT;
+    }
+    err = noise_handshakestate_new(state, symmetric, role);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* The token position must be within the pattern */
+    pattern = noise_pattern_lookup(symmetric->id.pattern_id);
+    for (posn = 1; posn < token_offset; ++posn) {
+        if (pattern[posn] == NOISE_TOKEN_END)
+            break;
+    }
+    if (token_offset < 1 || posn < token_offset || !symmetric->cipher ||
+            (action != NOISE_ACTION_WRITE_MESSAGE &&
+             action != NOISE_ACTION_READ_MESSAGE &&
+             action != NOISE_ACTION_SPLIT))
+        return NOISE_ERROR_INVALID_FORMAT;
+    (*state)->action = action;
+    (*state)->requirements = requirements;
+    (*state)->tokens = pattern + token_offset;
+    (*state)->message_index = (size_t)noise_export_get_uint(body, 1);
+
+    /* Restore the pre-shared key and the DH keys */
+    (*state)->pre_shared_key_len = (size_t)noise_export_get_uint(body, 1);
+    if ((*state)->pre_shared_key_len != 0 &&
+            (*state)->pre_shared_key_len != NOISE_PSK_LEN)
+        return NOISE_ERROR_INVALID_FORMAT;
+    noise_export_get_bytes
+        (body, (*state)->pre_shared_key, (*state)->pre_shared_key_len);
+    err = noise_handshakestate_read_dh((*state)->dh_local_static, body);
+    if (err == NOISE_ERROR_NONE)
+        err = noise_handshakestate_read_dh((*state)->dh_local_ephemeral, body);
+    if (err == NOISE_ERROR_NONE)
+        err = noise_handshakestate_read_dh((*state)->dh_remote_static, body);
+    if (err == NOISE_ERROR_NONE)
+        err = noise_handshakestate_read_dh((*state)->dh_remote_ephemeral, body);
+    if (err == NOISE_ERROR_NONE && body->size != body->max_size)
+        err = NOISE_ERROR_INVALID_FORMAT;
+    return err;
+}
+
+/**
+ * \brief Imports an in-progress HandshakeState from an encrypted and
+ * authenticated blob.
+ *
+ * \param state Points to the variable where to store the pointer to
+ * the new HandshakeState object.
+ * \param wrap_key Points to the key that the blob was wrapped with.
+ * \param wrap_key_len The length of \a wrap_key, which must be
+ * NOISE_EXPORT_KEY_LEN.
+ * \param blob The blob that was created by noise_handshakestate_export().
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a state, \a wrap_key, or
+ * \a blob is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if \a wrap_key_len is incorrect.
+ * \return NOISE_ERROR_INVALID_FORMAT if \a blob is not an exported
+ * HandshakeState.
+ * \return NOISE_ERROR_MAC_FAILURE if \a blob was not wrapped with
+ * \a wrap_key or it has been modified.
+ * \return NOISE_ERROR_UNKNOWN_ID if the protocol uses an algorithm that
+ * is not supported by this build.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory.
+ *
+ * The new HandshakeState continues from the point where the original
+ * was exported; i.e. noise_handshakestate_get_action() will return the
+ * same action.  Remote public keys are not checked again with the
+ * remote static key check callback.
+ *
+ * \sa noise_handshakestate_export()
+ */
+int noise_handshakestate_import
+    (NoiseHandshakeState **state, const uint8_t *wrap_key,
+     size_t wrap_key_len, const NoiseBuffer *blob)
+{
+    uint8_t data[NOISE_MAX_EXPORT_LEN];
+    NoiseBuffer body;
+    int err;
+
+    /* Validate the parameters */
+    if (!state)
+        return NOISE_ERROR_INVALID_PARAM;
+    *state = 0;
+
+    /* Unwrap the blob and parse the HandshakeState out of it */
+    noise_buffer_set_output(body, data, sizeof(data));
+    err = noise_export_open
+        (NOISE_EXPORT_HANDSHAKESTATE, wrap_key, wrap_key_len, blob, &body);
+    if (err == NOISE_ERROR_NONE) {
+        err = noise_handshakestate_read_export(state, &body);
+        if (err != NOISE_ERROR_NONE && *state) {
+            noise_handshakestate_free(*state);
+            *state = 0;
+        }
+    }
+    noise_clean(data, sizeof(data));
+    return err;
+}
+
 /**@}*/
@@ -72,32 +72,19 @@
  */
 int noise_hashstate_new_by_id(NoiseHashState **state, int id)
 {
+    const NoiseBackend *backend;
+
     /* The "state" argument must be non-NULL */
     if (!state)
         return NOISE_ERROR_INVALID_PARAM;
 
-    /* Create the HashState object for the "id" */
+    /* Create the HashState object for the "id" using the implementation
+       that is currently selected in the backend registry */
     *state = 0;
-    switch (id) {
-    case NOISE_HASH_BLAKE2s:
-        *state = noise_blake2s_new();
-        break;
-
-    case NOISE_HASH_BLAKE2b:
-        *state = noise_blake2b_new();
-        break;
-
-    case NOISE_HASH_SHA256:
-        *state = noise_sha256_new();
-        break;
-
-    case NOISE_HASH_SHA512:
-        *state = noise_sha512_new();
-        break;
-
-    default:
+    backend = noise_backend_lookup(id);
+    if (!backend || !(backend->new_hash))
         return NOISE_ERROR_UNKNOWN_ID;
-    }
+    *state = (*(backend->new_hash))();
 
     /* Bail out if insufficient memory */
     if (!(*state))
@@ -225,7 +212,7 @@ int noise_hashstate_reset(NoiseHashState *state)
         return NOISE_ERROR_INVALID_PARAM;
 
     /* Reset the hash state */
-    (*(state->reset))(state);
+    noise_hash_reset(state);
     return NOISE_ERROR_NONE;
 }
 
@@ -249,7 +236,7 @@ int noise_hashstate_update
         return NOISE_ERROR_INVALID_PARAM;
 
     /* Update the hash state */
-    (*(state->update))(state, data, data_len);
+    noise_hash_update(state, data, data_len);
     return NOISE_ERROR_NONE;
 }
 
@@ -278,7 +265,7 @@ int noise_hashstate_finalize
         return NOISE_ERROR_INVALID_LENGTH;
 
     /* Finalize the hash state */
-    (*(state->finalize))(state, hash);
+    noise_hash_finalize(state, hash);
     return NOISE_ERROR_NONE;
 }
 
@@ -316,9 +303,9 @@ int noise_hashstate_hash_one
         return NOISE_ERROR_INVALID_LENGTH;
 
     /* Hash the data */
-    (*(state->reset))(state);
-    (*(state->update))(state, data, data_len);
-    (*(state->finalize))(state, hash);
+    noise_hash_reset(state);
+    noise_hash_update(state, data, data_len);
+    noise_hash_finalize(state, hash);
     return NOISE_ERROR_NONE;
 }
 
@@ -359,10 +346,186 @@ int noise_hashstate_hash_two
         return NOISE_ERROR_INVALID_LENGTH;
 
     /* Hash the data */
-    (*(state->reset))(state);
-    (*(state->update))(state, data1, data1_len);
-    (*(state->update))(state, data2, data2_len);
-    (*(state->finalize))(state, hash);
+    noise_hash_reset(state);
+    noise_hash_update(state, data1, data1_len);
+    noise_hash_update(state, data2, data2_len);
+    noise_hash_finalize(state, hash);
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Determine if a group of HashState objects can be advanced in
+ * parallel by a multi-buffer back end.
+ *
+ * \param states Points to the HashState objects.
+ * \param count The number of objects, at most NOISE_MAX_HASH_LANES.
+ *
+ * \return Non-zero if all objects share the same multi-buffer back end.
+ */
+static int noise_hashstate_lanes_shared(NoiseHashState **states, size_t count)
+{
+    size_t lane;
+    if (!states[0]->update_multi || !states[0]->finalize_multi)
+        return 0;
+    for (lane = 1; lane < count; ++lane) {
+        if (states[lane]->update_multi != states[0]->update_multi ||
+                states[lane]->finalize_multi != states[0]->finalize_multi)
+            return 0;
+    }
+    return 1;
+}
+
+/**
+ * \brief Updates a group of HashState objects with equal-length data,
+ * in parallel if the back end supports it.
+ *
+ * \param states Points to the HashState objects.
+ * \param data Points to the data for each object.
+ * \param data_len The length of each data buffer in bytes.
+ * \param count The number of objects, which may be any size.
+ */
+static void noise_hashstate_update_lanes
+    (NoiseHashState **states, const uint8_t **data, size_t data_len,
+     size_t count)
+{
+    size_t lanes, lane;
+    while (count > 0) {
+        lanes = (count < NOISE_MAX_HASH_LANES) ? count : NOISE_MAX_HASH_LANES;
+        if (!noise_hashstate_lanes_shared(states, lanes) ||
+                !(*(states[0]->update_multi))(states, data, data_len, lanes)) {
+            for (lane = 0; lane < lanes; ++lane)
+                noise_hash_update(states[lane], data[lane], data_len);
+        }
+        states += lanes;
+        data += lanes;
+        count -= lanes;
+    }
+}
+
+/**
+ * \brief Finalizes a group of HashState objects, in parallel if the
+ * back end supports it.
+ *
+ * \param states Points to the HashState objects.
+ * \param hashes Points to the output buffers for each object.
+ * \param count The number of objects, which may be any size.
+ */
+static void noise_hashstate_finalize_lanes
+    (NoiseHashState **states, uint8_t **hashes, size_t count)
+{
+    size_t lanes, lane;
+    while (count > 0) {
+        lanes = (count < NOISE_MAX_HASH_LANES) ? count : NOISE_MAX_HASH_LANES;
+        if (!noise_hashstate_lanes_shared(states, lanes) ||
+                !(*(states[0]->finalize_multi))(states, hashes, lanes)) {
+            for (lane = 0; lane < lanes; ++lane)
+                noise_hash_finalize(states[lane], hashes[lane]);
+        }
+        states += lanes;
+        hashes += lanes;
+        count -= lanes;
+    }
+}
+
+/**
+ * \brief Validates a group of HashState objects for a multi-buffer
+ * operation.
+ *
+ * \param states Points to the HashState objects.
+ * \param count The number of objects.
+ *
+ * \return NOISE_ERROR_NONE if all objects are non-NULL and use the same
+ * hash algorithm, or NOISE_ERROR_INVALID_PARAM otherwise.
+ */
+static int noise_hashstate_check_lanes(NoiseHashState **states, size_t count)
+{
+    size_t lane;
+    if (!states)
+        return NOISE_ERROR_INVALID_PARAM;
+    for (lane = 0; lane < count; ++lane) {
+        if (!states[lane] || states[lane]->hash_id != states[0]->hash_id)
+            return NOISE_ERROR_INVALID_PARAM;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Updates several hash states in parallel with more data.
+ *
+ * \param states Points to an array of HashState objects, which must
+ * all use the same hash algorithm.
+ * \param data Points to an array of data pointers, one for each state.
+ * \param data_len The length of each of the \a data buffers in bytes.
+ * \param count The number of HashState objects in \a states.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a states or \a data is NULL,
+ * one of the elements is NULL, or the states use different hash algorithms.
+ *
+ * This is equivalent to calling noise_hashstate_update() on each state
+ * in turn.  If the back end has a multi-buffer implementation of the hash
+ * algorithm, then up to 8 states will be advanced at once in the lanes of
+ * SIMD registers.  This is most effective when the states have all been
+ * fed the same amount of data so far, such as when hashing a batch of
+ * handshakes in lock-step.
+ *
+ * \sa noise_hashstate_finalize_multi(), noise_hashstate_hkdf_multi()
+ */
+int noise_hashstate_update_multi
+    (NoiseHashState **states, const uint8_t **data, size_t data_len,
+     size_t count)
+{
+    size_t lane;
+
+    /* Validate the parameters */
+    if (noise_hashstate_check_lanes(states, count) != NOISE_ERROR_NONE || !data)
+        return NOISE_ERROR_INVALID_PARAM;
+    for (lane = 0; lane < count; ++lane) {
+        if (!data[lane])
+            return NOISE_ERROR_INVALID_PARAM;
+    }
+
+    /* Update the hash states */
+    noise_hashstate_update_lanes(states, data, data_len, count);
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Finalizes several hash states in parallel and returns the
+ * hash values.
+ *
+ * \param states Points to an array of HashState objects, which must
+ * all use the same hash algorithm.
+ * \param hashes Points to an array of return buffers, one for each state.
+ * \param hash_len The length of each of the \a hashes buffers in bytes.
+ * \param count The number of HashState objects in \a states.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a states or \a hashes is NULL,
+ * one of the elements is NULL, or the states use different hash algorithms.
+ * \return NOISE_ERROR_INVALID_LENGTH if \a hash_len is not the same
+ * as the hash length for the algorithm.
+ *
+ * \sa noise_hashstate_update_multi()
+ */
+int noise_hashstate_finalize_multi
+    (NoiseHashState **states, uint8_t **hashes, size_t hash_len, size_t count)
+{
+    size_t lane;
+
+    /* Validate the parameters */
+    if (noise_hashstate_check_lanes(states, count) != NOISE_ERROR_NONE ||
+            !hashes)
+        return NOISE_ERROR_INVALID_PARAM;
+    for (lane = 0; lane < count; ++lane) {
+        if (!hashes[lane])
+            return NOISE_ERROR_INVALID_PARAM;
+    }
+    if (count > 0 && hash_len != states[0]->hash_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* Finalize the hash states */
+    noise_hashstate_finalize_lanes(states, hashes, count);
     return NOISE_ERROR_NONE;
 }
 
@@ -402,8 +565,10 @@ static void noise_hashstate_xor_key(uint8_t *key, size_t key_len, uint8_t value)
  * must overlap with \a key.
  *
  * Reference: <a href="http://tools.ietf.org/html/rfc2104">RFC 2104</a>
+ *
+ * \note Not part of the public API.
  */
-static void noise_hashstate_hmac
+void noise_hashstate_hmac
     (NoiseHashState *state, const uint8_t *key, size_t key_len,
      const uint8_t *data1, size_t data1_len,
      const uint8_t *data2, size_t data2_len, uint8_t *hash)
@@ -420,34 +585,107 @@ static void noise_hashstate_hmac
         memcpy(key_block, key, key_len);
         memset(key_block + key_len, 0, block_len - key_len);
     } else {
-        (*(state->reset))(state);
-        (*(state->update))(state, key, key_len);
-        (*(state->finalize))(state, key_block);
+        noise_hash_reset(state);
+        noise_hash_update(state, key, key_len);
+        noise_hash_finalize(state, key_block);
         memset(key_block + hash_len, 0, block_len - hash_len);
     }
     noise_hashstate_xor_key(key_block, block_len, HMAC_IPAD);
 
     /* Calculate the inner hash */
-    (*(state->reset))(state);
-    (*(state->update))(state, key_block, block_len);
-    (*(state->update))(state, data1, data1_len);
+    noise_hash_reset(state);
+    noise_hash_update(state, key_block, block_len);
+    noise_hash_update(state, data1, data1_len);
     if (data2)
-        (*(state->update))(state, data2, data2_len);
-    (*(state->finalize))(state, hash);
+        noise_hash_update(state, data2, data2_len);
+    noise_hash_finalize(state, hash);
 
     /* Format the key for the outer hashing context */
     noise_hashstate_xor_key(key_block, block_len, HMAC_IPAD ^ HMAC_OPAD);
 
     /* Calculate the outer hash */
-    (*(state->reset))(state);
-    (*(state->update))(state, key_block, block_len);
-    (*(state->update))(state, hash, hash_len);
-    (*(state->finalize))(state, hash);
+    noise_hash_reset(state);
+    noise_hash_update(state, key_block, block_len);
+    noise_hash_update(state, hash, hash_len);
+    noise_hash_finalize(state, hash);
 
     /* Clean up and exit */
     noise_clean(key_block, state->block_len);
 }
 
+/**
+ * \brief Computes HMAC values for several keys and data blocks at once.
+ *
+ * \param states The HashState objects, one per lane.
+ * \param count The number of lanes, at most NOISE_MAX_HASH_LANES.
+ * \param keys Points to the key for each lane.
+ * \param key_len The length of each key in bytes.
+ * \param data1 Points to the first data block for each lane.
+ * \param data1_len The length of each first data block in bytes.
+ * \param data2 Points to the second data block for each lane
+ * (may be NULL).
+ * \param data2_len The length of each second data block in bytes.
+ * \param hashes The final output HMAC hash value for each lane.
+ *
+ * The lanes are processed in parallel if the back end supports it;
+ * otherwise this is equivalent to calling noise_hashstate_hmac()
+ * on each lane in turn.  The same overlap rules apply.
+ */
+static void noise_hashstate_hmac_multi
+    (NoiseHashState **states, size_t count, const uint8_t **keys,
+     size_t key_len, const uint8_t **data1, size_t data1_len,
+     const uint8_t **data2, size_t data2_len, uint8_t **hashes)
+{
+    size_t hash_len = states[0]->hash_len;
+    size_t block_len = states[0]->block_len;
+    uint8_t key_blocks[NOISE_MAX_HASH_LANES][128];
+    const uint8_t *blocks[NOISE_MAX_HASH_LANES];
+    size_t lane;
+
+    /* Format the keys for the inner hashing contexts */
+    for (lane = 0; lane < count; ++lane) {
+        uint8_t *key_block = key_blocks[lane];
+        if (key_len <= block_len) {
+            memcpy(key_block, keys[lane], key_len);
+            memset(key_block + key_len, 0, block_len - key_len);
+        } else {
+            noise_hash_reset(states[lane]);
+            noise_hash_update(states[lane], keys[lane], key_len);
+            noise_hash_finalize(states[lane], key_block);
+            memset(key_block + hash_len, 0, block_len - hash_len);
+        }
+        noise_hashstate_xor_key(key_block, block_len, HMAC_IPAD);
+        blocks[lane] = key_block;
+    }
+
+    /* Calculate the inner hashes */
+    for (lane = 0; lane < count; ++lane)
+        noise_hash_reset(states[lane]);
+    noise_hashstate_update_lanes(states, blocks, block_len, count);
+    noise_hashstate_update_lanes(states, data1, data1_len, count);
+    if (data2)
+        noise_hashstate_update_lanes(states, data2, data2_len, count);
+    noise_hashstate_finalize_lanes(states, hashes, count);
+
+    /* Format the keys for the outer hashing contexts */
+    for (lane = 0; lane < count; ++lane) {
+        noise_hashstate_xor_key
+            (key_blocks[lane], block_len, HMAC_IPAD ^ HMAC_OPAD);
+    }
+
+    /* Calculate the outer hashes */
+    for (lane = 0; lane < count; ++lane)
+        noise_hash_reset(states[lane]);
+    noise_hashstate_update_lanes(states, blocks, block_len, count);
+    noise_hashstate_update_lanes
+        (states, (const uint8_t **)hashes, hash_len, count);
+    noise_hashstate_finalize_lanes(states, hashes, count);
+
+    /* Clean up and exit */
+    for (lane = 0; lane < count; ++lane)
+        noise_clean(key_blocks[lane], block_len);
+}
+
 /**
  * \brief Hashes input data with a key to generate two output values.
  *
@@ -515,6 +753,153 @@ int noise_hashstate_hkdf
     return NOISE_ERROR_NONE;
 }
 
+/**
+ * \brief Hashes several inputs with their keys to generate two output
+ * values for each.
+ *
+ * \param states Points to an array of HashState objects, which must
+ * all use the same hash algorithm.
+ * \param keys Points to the key for each state.
+ * \param key_len The length of each of the \a keys in bytes.
+ * \param data Points to the data for each state.
+ * \param data_len The length of each of the \a data buffers in bytes.
+ * \param output1 Points to the first output buffer for each state.
+ * \param output1_len The length of each first output buffer, which may
+ * be shorter than the hash length of the HashState objects.
+ * \param output2 Points to the second output buffer for each state.
+ * \param output2_len The length of each second output buffer, which may
+ * be shorter than the hash length of the HashState objects.
+ * \param count The number of HashState objects in \a states.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if one of \a states, \a keys, \a data,
+ * \a output1, or \a output2 is NULL, one of their elements is NULL, or
+ * the states use different hash algorithms.
+ * \return NOISE_ERROR_INVALID_LENGTH if \a output1_len or \a output2_len is
+ * greater than the hash length for the HashState objects.
+ *
+ * The results are the same as calling noise_hashstate_hkdf() on each
+ * state in turn.  If the back end has a multi-buffer implementation of the
+ * hash algorithm, then up to 8 derivations are computed at once.
+ *
+ * \sa noise_hashstate_hkdf(), noise_hashstate_update_multi()
+ */
+int noise_hashstate_hkdf_multi
+    (NoiseHashState **states, const uint8_t **keys, size_t key_len,
+     const uint8_t **data, size_t data_len,
+     uint8_t **output1, size_t output1_len,
+     uint8_t **output2, size_t output2_len, size_t count)
+{
+    uint8_t temp_keys[NOISE_MAX_HASH_LANES][NOISE_MAX_HASHLEN];
+    uint8_t temp_hashes[NOISE_MAX_HASH_LANES][NOISE_MAX_HASHLEN + 1];
+    uint8_t *key_ptrs[NOISE_MAX_HASH_LANES];
+    uint8_t *hash_ptrs[NOISE_MAX_HASH_LANES];
+    size_t hash_len, lanes, lane, used;
+
+    /* Validate the parameters */
+    if (noise_hashstate_check_lanes(states, count) != NOISE_ERROR_NONE)
+        return NOISE_ERROR_INVALID_PARAM;
+    if (!keys || !data || !output1 || !output2)
+        return NOISE_ERROR_INVALID_PARAM;
+    for (lane = 0; lane < count; ++lane) {
+        if (!keys[lane] || !data[lane] || !output1[lane] || !output2[lane])
+            return NOISE_ERROR_INVALID_PARAM;
+    }
+    if (!count)
+        return NOISE_ERROR_NONE;
+    hash_len = states[0]->hash_len;
+    if (output1_len > hash_len || output2_len > hash_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+    for (lane = 0; lane < NOISE_MAX_HASH_LANES; ++lane) {
+        key_ptrs[lane] = temp_keys[lane];
+        hash_ptrs[lane] = temp_hashes[lane];
+    }
+    used = (count < NOISE_MAX_HASH_LANES) ? count : NOISE_MAX_HASH_LANES;
+
+    /* Process the states in groups of NOISE_MAX_HASH_LANES */
+    while (count > 0) {
+        lanes = (count < NOISE_MAX_HASH_LANES) ? count : NOISE_MAX_HASH_LANES;
+
+        /* Generate the temporary hashing keys */
+        noise_hashstate_hmac_multi
+            (states, lanes, keys, key_len, data, data_len, 0, 0, key_ptrs);
+
+        /* Generate the first outputs */
+        for (lane = 0; lane < lanes; ++lane)
+            temp_hashes[lane][0] = 0x01;
+        noise_hashstate_hmac_multi
+            (states, lanes, (const uint8_t **)key_ptrs, hash_len,
+             (const uint8_t **)hash_ptrs, 1, 0, 0, hash_ptrs);
+        for (lane = 0; lane < lanes; ++lane)
+            memcpy(output1[lane], temp_hashes[lane], output1_len);
+
+        /* Generate the second outputs */
+        for (lane = 0; lane < lanes; ++lane)
+            temp_hashes[lane][hash_len] = 0x02;
+        noise_hashstate_hmac_multi
+            (states, lanes, (const uint8_t **)key_ptrs, hash_len,
+             (const uint8_t **)hash_ptrs, hash_len + 1, 0, 0, hash_ptrs);
+        for (lane = 0; lane < lanes; ++lane)
+            memcpy(output2[lane], temp_hashes[lane], output2_len);
+
+        states += lanes;
+        keys += lanes;
+        data += lanes;
+        output1 += lanes;
+        output2 += lanes;
+        count -= lanes;
+    }
+
+    /* Clean up and exit */
+    for (lane = 0; lane < used; ++lane) {
+        noise_clean(temp_keys[lane], hash_len);
+        noise_clean(temp_hashes[lane], hash_len + 1);
+    }
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Initializes the inner and outer HMAC states for a key.
+ *
+ * \param inner The HashState to absorb the inner padded key.
+ * \param outer The HashState to absorb the outer padded key.
+ * \param key Points to the key.
+ * \param key_len The length of the key in bytes.
+ *
+ * After this, HMAC(key, data) is computed by copying \a inner into a
+ * working state, absorbing the data, and finalizing; and then copying
+ * \a outer into the working state and absorbing the inner hash.
+ * Caching the padded key states saves two block operations per HMAC.
+ */
+static void noise_hashstate_hmac_pads
+    (NoiseHashState *inner, NoiseHashState *outer,
+     const uint8_t *key, size_t key_len)
+{
+    size_t hash_len = inner->hash_len;
+    size_t block_len = inner->block_len;
+    uint8_t key_block[128];
+
+    /* Format the key */
+    if (key_len <= block_len) {
+        memcpy(key_block, key, key_len);
+        memset(key_block + key_len, 0, block_len - key_len);
+    } else {
+        noise_hash_reset(inner);
+        noise_hash_update(inner, key, key_len);
+        noise_hash_finalize(inner, key_block);
+        memset(key_block + hash_len, 0, block_len - hash_len);
+    }
+
+    /* Absorb the padded keys into the inner and outer states */
+    noise_hashstate_xor_key(key_block, block_len, HMAC_IPAD);
+    noise_hash_reset(inner);
+    noise_hash_update(inner, key_block, block_len);
+    noise_hashstate_xor_key(key_block, block_len, HMAC_IPAD ^ HMAC_OPAD);
+    noise_hash_reset(outer);
+    noise_hash_update(outer, key_block, block_len);
+    noise_clean(key_block, block_len);
+}
+
 /**
  * \brief Hashes a passphrase and salt using the PBKDF2 key derivation function.
  *
@@ -532,10 +917,18 @@ int noise_hashstate_hkdf
  * \a salt, or \a output is NULL.
  * \return NOISE_ERROR_INVALID_LENGTH if the \a output_len is too large
  * for valid PBKDF2 output.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory for
+ * the temporary hashing states.
  *
  * This function is intended as a utility for applications that need to hash a
  * passphrase to encrypt private keys and other sensitive information.
  *
+ * The HMAC states for the padded passphrase are computed once and then
+ * copied for each iteration rather than re-hashing the passphrase every
+ * time.  If the output is longer than the hash length, then the output
+ * blocks are independent of each other and are generated in parallel
+ * when the back end has a multi-buffer implementation of the hash.
+ *
  * Reference: <a href="https://www.ietf.org/rfc/rfc2898.txt">RFC 2898</a>
  */
 int noise_hashstate_pbkdf2
@@ -543,12 +936,21 @@ int noise_hashstate_pbkdf2
      const uint8_t *salt, size_t salt_len, size_t iterations,
      uint8_t *output, size_t output_len)
 {
-    size_t hash_len;
+    NoiseHashState *states[NOISE_MAX_HASH_LANES];
+    NoiseHashState *inner[NOISE_MAX_HASH_LANES];
+    NoiseHashState *outer[NOISE_MAX_HASH_LANES];
+    uint8_t T[NOISE_MAX_HASH_LANES][NOISE_MAX_HASHLEN];
+    uint8_t U[NOISE_MAX_HASH_LANES][NOISE_MAX_HASHLEN];
+    uint8_t ibuf[NOISE_MAX_HASH_LANES][4];
+    const uint8_t *salts[NOISE_MAX_HASH_LANES];
+    const uint8_t *ibufs[NOISE_MAX_HASH_LANES];
+    const uint8_t *inputs[NOISE_MAX_HASH_LANES];
+    uint8_t *outputs[NOISE_MAX_HASH_LANES];
+    uint8_t *copies;
+    size_t hash_len, state_size;
     uint64_t max_size;
-    uint8_t T[NOISE_MAX_HASHLEN];
-    uint8_t U[NOISE_MAX_HASHLEN];
-    uint8_t ibuf[4];
-    size_t i, index, index2;
+    size_t num_states, lanes, lane;
+    size_t i, index, index2, len;
 
     /* Validate the parameters */
     if (!state || !passphrase || !salt || !output)
@@ -558,40 +960,106 @@ int noise_hashstate_pbkdf2
     if (output_len > max_size)
         return NOISE_ERROR_INVALID_LENGTH;
 
+    /* The output blocks are independent of each other, so if the back end
+       can hash several states at once then we use one lane per block */
+    num_states = 1;
+    if (state->update_multi) {
+        num_states = (output_len + hash_len - 1) / hash_len;
+        if (num_states > NOISE_MAX_HASH_LANES)
+            num_states = NOISE_MAX_HASH_LANES;
+        else if (!num_states)
+            num_states = 1;
+    }
+
+    /* Each lane needs a working state plus the inner and outer HMAC
+       states for the passphrase.  These are byte copies of the caller's
+       state so that they use the same back end and can be copied over
+       each other.  The caller's state is only used as a template */
+    state_size = state->size;
+    copies = (uint8_t *)noise_new_object(state_size * num_states * 3);
+    if (!copies)
+        return NOISE_ERROR_NO_MEMORY;
+    for (lane = 0; lane < num_states; ++lane) {
+        states[lane] = (NoiseHashState *)(copies + state_size * lane * 3);
+        inner[lane] = (NoiseHashState *)
+            (copies + state_size * (lane * 3 + 1));
+        outer[lane] = (NoiseHashState *)
+            (copies + state_size * (lane * 3 + 2));
+        memcpy(states[lane], state, state_size);
+        memcpy(inner[lane], state, state_size);
+        memcpy(outer[lane], state, state_size);
+        salts[lane] = salt;
+        ibufs[lane] = ibuf[lane];
+        inputs[lane] = U[lane];
+        outputs[lane] = U[lane];
+    }
+
+    /* Compute the padded passphrase states once for all iterations */
+    noise_hashstate_hmac_pads(inner[0], outer[0], passphrase, passphrase_len);
+    for (lane = 1; lane < num_states; ++lane) {
+        memcpy(inner[lane], inner[0], state_size);
+        memcpy(outer[lane], outer[0], state_size);
+    }
+
+/* Restores the working states from the inner or outer HMAC states */
+#define pbkdf2_restore(from) \
+    do { \
+        for (lane = 0; lane < lanes; ++lane) \
+            memcpy(states[lane], (from)[lane], state_size); \
+    } while (0)
+
     /* Generate the required output blocks */
     i = 1;
     while (output_len > 0) {
-        /* Generate the next block of output */
-        ibuf[0] = (uint8_t)(i >> 24);
-        ibuf[1] = (uint8_t)(i >> 16);
-        ibuf[2] = (uint8_t)(i >> 8);
-        ibuf[3] = (uint8_t)i;
-        ++i;
-        noise_hashstate_hmac
-            (state, passphrase, passphrase_len, salt, salt_len,
-             ibuf, sizeof(ibuf), T);
-        memcpy(U, T, hash_len);
+        /* U1 = HMAC(passphrase, salt || i) for the next group of blocks */
+        lanes = (output_len + hash_len - 1) / hash_len;
+        if (lanes > num_states)
+            lanes = num_states;
+        for (lane = 0; lane < lanes; ++lane, ++i) {
+            ibuf[lane][0] = (uint8_t)(i >> 24);
+            ibuf[lane][1] = (uint8_t)(i >> 16);
+            ibuf[lane][2] = (uint8_t)(i >> 8);
+            ibuf[lane][3] = (uint8_t)i;
+        }
+        pbkdf2_restore(inner);
+        noise_hashstate_update_lanes(states, salts, salt_len, lanes);
+        noise_hashstate_update_lanes(states, ibufs, 4, lanes);
+        noise_hashstate_finalize_lanes(states, outputs, lanes);
+        pbkdf2_restore(outer);
+        noise_hashstate_update_lanes(states, inputs, hash_len, lanes);
+        noise_hashstate_finalize_lanes(states, outputs, lanes);
+        for (lane = 0; lane < lanes; ++lane)
+            memcpy(T[lane], U[lane], hash_len);
+
+        /* Un = HMAC(passphrase, Un-1) and T = U1 ^ U2 ^ ... ^ Un */
         for (index = 1; index < iterations; ++index) {
-            noise_hashstate_hmac
-                (state, passphrase, passphrase_len, U, hash_len, 0, 0, U);
-            for (index2 = 0; index2 < hash_len; ++index2)
-                T[index2] ^= U[index2];
+            pbkdf2_restore(inner);
+            noise_hashstate_update_lanes(states, inputs, hash_len, lanes);
+            noise_hashstate_finalize_lanes(states, outputs, lanes);
+            pbkdf2_restore(outer);
+            noise_hashstate_update_lanes(states, inputs, hash_len, lanes);
+            noise_hashstate_finalize_lanes(states, outputs, lanes);
+            for (lane = 0; lane < lanes; ++lane) {
+                for (index2 = 0; index2 < hash_len; ++index2)
+                    T[lane][index2] ^= U[lane][index2];
+            }
         }
 
         /* Copy the generated data into the output buffer */
-        if (output_len >= hash_len) {
-            memcpy(output, T, hash_len);
-            output += hash_len;
-            output_len -= hash_len;
-        } else {
-            memcpy(output, T, output_len);
-            output_len = 0;
+        for (lane = 0; lane < lanes; ++lane) {
+            len = (output_len >= hash_len) ? hash_len : output_len;
+            memcpy(output, T[lane], len);
+            output += len;
+            output_len -= len;
         }
     }
 
+#undef pbkdf2_restore
+
     /* Clean up and exit */
-    noise_clean(T, sizeof(T));
-    noise_clean(U, sizeof(U));
+    noise_free(copies, state_size * num_states * 3);
+    noise_clean(T, num_states * sizeof(T[0]));
+    noise_clean(U, num_states * sizeof(U[0]));
     return NOISE_ERROR_NONE;
 }
 
@@ -47,6 +47,17 @@ extern "C" {
  */
 #define NOISE_MAX_HASHLEN 64
 
+/**
+ * \brief Maximum number of HashState objects that a multi-buffer back end
+ * will advance in parallel.
+ */
+#define NOISE_MAX_HASH_LANES 8
+
+/**
+ * \brief Maximum length of an encryption key across all back ends.
+ */
+#define NOISE_MAX_KEY_LEN 32
+
 /**
  * \brief Standard length for pre-shared keys.
  */
@@ -80,6 +91,9 @@ struct NoiseCipherState_s
     /** \brief The nonce value for the next packet */
     uint64_t n;
 
+    /** \brief Copy of the raw key, for noise_cipherstate_export() */
+    uint8_t key[NOISE_MAX_KEY_LEN];
+
     /**
      * \brief Creates a new CipherState of the same type as this one.
      *
@@ -192,6 +206,44 @@ struct NoiseHashState_s
      */
     void (*finalize)(NoiseHashState *state, uint8_t *hash);
 
+    /**
+     * \brief Updates several HashStates in parallel with more input data.
+     *
+     * \param states Points to an array of HashStates that all use this
+     * implementation of the hash algorithm.
+     * \param data Points to an array of input data pointers, one per state.
+     * \param len The length of each input in bytes.
+     * \param count The number of states, between 1 and
+     * \ref NOISE_MAX_HASH_LANES.
+     *
+     * \return Non-zero if the states were updated, or zero if they cannot
+     * be updated in parallel and the caller must update them one at a time.
+     *
+     * This pointer can be NULL if the back end does not have a
+     * multi-buffer implementation.
+     */
+    int (*update_multi)(NoiseHashState **states, const uint8_t **data,
+                        size_t len, size_t count);
+
+    /**
+     * \brief Finalizes several HashStates in parallel.
+     *
+     * \param states Points to an array of HashStates that all use this
+     * implementation of the hash algorithm.
+     * \param hashes Points to an array of output buffers, one per state.
+     * \param count The number of states, between 1 and
+     * \ref NOISE_MAX_HASH_LANES.
+     *
+     * \return Non-zero if the states were finalized, or zero if they cannot
+     * be finalized in parallel and the caller must finalize them one at
+     * a time.
+     *
+     * This pointer can be NULL if the back end does not have a
+     * multi-buffer implementation.
+     */
+    int (*finalize_multi)(NoiseHashState **states, uint8_t **hashes,
+                          size_t count);
+
     /**
      * \brief Destroys this HashState prior to the memory being freed.
      *
@@ -484,6 +536,43 @@ struct NoiseSignState_s
         (const NoiseSignState *state, const uint8_t *message,
          size_t message_len, const uint8_t *signature);
 
+    /**
+     * \brief Verifies several digital signatures in a single batch.
+     *
+     * \param states Points to an array of SignStates that all use this
+     * implementation of the signature algorithm and contain public keys.
+     * \param messages Points to an array of messages, one per state.
+     * \param message_lens Points to an array of message lengths.
+     * \param signatures Points to an array of signatures, one per state.
+     * \param count The number of signatures to verify.
+     * \param valid Points to an array that is set to 1 for each valid
+     * signature and 0 for each invalid signature.
+     *
+     * \return NOISE_ERROR_NONE if all signatures are valid.
+     * \return NOISE_ERROR_INVALID_SIGNATURE if at least one signature
+     * is not valid.
+     *
+     * This pointer can be NULL if the back end does not have a
+     * batch verification implementation.
+     */
+    int (*verify_batch)
+        (const NoiseSignState **states, const uint8_t **messages,
+         const size_t *message_lens, const uint8_t **signatures,
+         size_t count, int *valid);
+
+    /**
+     * \brief Notifies the back end that the key in this SignState changed.
+     *
+     * \param state Points to the SignState.
+     *
+     * This is called after the front end has generated, set, copied, or
+     * cleared the key so that the back end can refresh or scrub any state
+     * that it derives from the private key, such as an expanded signing key.
+     *
+     * This pointer can be NULL if the back end does not cache anything.
+     */
+    void (*key_changed)(NoiseSignState *state);
+
     /**
      * \brief Destroys this SignState prior to the memory being freed.
      *
@@ -499,6 +588,146 @@ struct NoiseSignState_s
     void (*destroy)(NoiseSignState *state);
 };
 
+/**
+ * \brief Internal structure of the NoiseCompactSession type.
+ *
+ * This is deliberately just the keys and nonces so that it fits in
+ * 96 bytes on 64-bit platforms.  The cipher's working state is only
+ * created in a caller-supplied CipherState while a message is processed.
+ */
+struct NoiseCompactSession_s
+{
+    /** \brief Total size of the structure */
+    size_t size;
+
+    /** \brief Nonce for the next packet that is sent */
+    uint64_t send_n;
+
+    /** \brief Nonce for the next packet that is received */
+    uint64_t receive_n;
+
+    /** \brief Algorithm identifier for the cipher */
+    int cipher_id;
+
+    /** \brief Key for packets that are sent */
+    uint8_t send_key[32];
+
+    /** \brief Key for packets that are received */
+    uint8_t receive_key[32];
+};
+
+/**
+ * \brief Key for encrypting resumption tickets during one rotation period.
+ */
+typedef struct
+{
+    /** \brief Identifier for the key, which is included in tickets */
+    uint32_t key_id;
+
+    /** \brief ChaChaPoly cipher that is keyed with the ticket key */
+    NoiseCipherState *cipher;
+
+    /** \brief Number of tickets issued, which is the next nonce to use */
+    uint64_t issued;
+
+    /** \brief Bitmap of the nonces for tickets that have been redeemed,
+        allocated with malloc() because it does not contain secrets */
+    uint8_t *redeemed;
+
+    /** \brief Size of the redeemed bitmap in bytes */
+    size_t redeemed_size;
+
+} NoiseTicketKey;
+
+/**
+ * \brief Internal structure of the NoiseTicketIssuer type.
+ */
+struct NoiseTicketIssuer_s
+{
+    /** \brief Total size of the structure */
+    size_t size;
+
+    /** \brief Key for issuing new tickets */
+    NoiseTicketKey current;
+
+    /** \brief Key from the previous rotation period, which can still
+        be used to redeem tickets */
+    NoiseTicketKey previous;
+};
+
+/**
+ * \brief Internal structure of the NoiseCookieChecker type.
+ */
+struct NoiseCookieChecker_s
+{
+    /** \brief Total size of the structure */
+    size_t size;
+
+    /** \brief BLAKE2s object for computing MAC's */
+    NoiseHashState *hash;
+
+    /** \brief ChaChaPoly object for encrypting cookie replies */
+    NoiseCipherState *cipher;
+
+    /** \brief Key for "mac1", derived from the responder's static key */
+    uint8_t mac1_key[32];
+
+    /** \brief Key for cookie replies, derived from the responder's
+        static key */
+    uint8_t cookie_key[32];
+
+    /** \brief Random secret for generating cookies */
+    uint8_t secret[32];
+
+    /** \brief Secret from the previous rotation period */
+    uint8_t previous_secret[32];
+
+    /** \brief Number of messages per tick before cookies are required,
+        or zero to never require cookies */
+    size_t threshold;
+
+    /** \brief Number of messages with a valid "mac1" in this tick */
+    size_t count;
+
+    /** \brief Number of messages with a valid "mac1" in the previous tick */
+    size_t previous_count;
+};
+
+/**
+ * \brief Internal structure of the NoiseCookieMaker type.
+ */
+struct NoiseCookieMaker_s
+{
+    /** \brief Total size of the structure */
+    size_t size;
+
+    /** \brief BLAKE2s object for computing MAC's */
+    NoiseHashState *hash;
+
+    /** \brief ChaChaPoly object for decrypting cookie replies */
+    NoiseCipherState *cipher;
+
+    /** \brief Key for "mac1", derived from the responder's static key */
+    uint8_t mac1_key[32];
+
+    /** \brief Key for cookie replies, derived from the responder's
+        static key */
+    uint8_t cookie_key[32];
+
+    /** \brief Most recent cookie from the responder */
+    uint8_t cookie[16];
+
+    /** \brief "mac1" value of the most recent message, which
+        authenticates the cookie reply */
+    uint8_t last_mac1[16];
+
+    /** \brief Non-zero if \ref cookie is valid */
+    int has_cookie;
+
+    /** \brief Non-zero if \ref last_mac1 is valid */
+    int has_mac1;
+};
+
 /**
  * \brief Internal structure of the NoiseSymmetricState type.
  */
@@ -530,6 +759,46 @@ struct NoiseSymmetricState_s
     uint8_t h[NOISE_MAX_HASHLEN];
 };
 
+/**
+ * \brief Writes one handshake message using a compiled pattern.
+ */
+typedef int (*NoiseCompiledWriteFunc)
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload);
+
+/**
+ * \brief Reads one handshake message using a compiled pattern.
+ */
+typedef int (*NoiseCompiledReadFunc)
+    (NoiseHandshakeState *state, NoiseBuffer *message, NoiseBuffer *payload);
+
+/**
+ * \brief Compiled form of a single handshake message.
+ */
+typedef struct
+{
+    /** \brief Writes the message from the sender's side */
+    NoiseCompiledWriteFunc write;
+
+    /** \brief Reads the message on the recipient's side */
+    NoiseCompiledReadFunc read;
+
+} NoiseCompiledMessage;
+
+/**
+ * \brief Compiled form of a handshake pattern, as generated by
+ * noise-patternc from the token sequences in patterns.c.
+ */
+typedef struct
+{
+    /** \brief Number of messages in the pattern */
+    size_t num_messages;
+
+    /** \brief Points to the compiled messages */
+    const NoiseCompiledMessage *messages;
+
+} NoiseCompiledPattern;
+
 /**
  * \brief Internal structure of the NoiseHandshakeState type.
  */
@@ -550,6 +819,12 @@ struct NoiseHandshakeState_s
     /** \brief Points to the next message pattern tokens to be processed */
     const uint8_t *tokens;
 
+    /** \brief Compiled form of the pattern, or NULL to interpret tokens */
+    const NoiseCompiledPattern *compiled;
+
+    /** \brief Index of the next message in the compiled pattern */
+    size_t message_index;
+
     /** \brief Points to the SymmetricState object for this HandshakeState */
     NoiseSymmetricState *symmetric;
 
@@ -565,9 +840,20 @@ struct NoiseHandshakeState_s
     /** \brief Points to the DHState object for remote ephemeral key */
     NoiseDHState *dh_remote_ephemeral;
 
+    /** \brief Points to the DHState object for the local hybrid
+        ephemeral key, or NULL if the protocol is not hybrid */
+    NoiseDHState *dh_local_hybrid;
+
+    /** \brief Points to the DHState object for the remote hybrid
+        ephemeral key, or NULL if the protocol is not hybrid */
+    NoiseDHState *dh_remote_hybrid;
+
     /** \brief Points to the object for the fixed ephemeral test key */
     NoiseDHState *dh_fixed_ephemeral;
 
+    /** \brief Points to the object for the fixed hybrid ephemeral test key */
+    NoiseDHState *dh_fixed_hybrid;
+
     /** \brief Pre-shared key value */
     uint8_t pre_shared_key[NOISE_PSK_LEN];
 
@@ -579,6 +865,12 @@ struct NoiseHandshakeState_s
 
     /** \brief Length of the prologue value in bytes */
     size_t prologue_len;
+
+    /** \brief Callback to check the remote static key when it arrives */
+    NoiseRemoteStaticCheckFunc remote_static_check;
+
+    /** \brief User data for \a remote_static_check */
+    void *remote_static_check_data;
 };
 
 /* Handshake message pattern tokens (must be single-byte values) */
@@ -632,26 +924,228 @@ struct NoiseHandshakeState_s
 
 void noise_rand_bytes(void *bytes, size_t size);
 
+void *noise_secmem_alloc(size_t size);
+int noise_secmem_free(void *ptr, size_t size);
+
+/* Types of state that can be exported with noise_export_seal() */
+#define NOISE_EXPORT_CIPHERSTATE        1
+#define NOISE_EXPORT_SYMMETRICSTATE     2
+#define NOISE_EXPORT_HANDSHAKESTATE     3
+
+int noise_export_seal
+    (int type, const uint8_t *wrap_key, size_t wrap_key_len,
+     const NoiseBuffer *body, NoiseBuffer *blob);
+int noise_export_open
+    (int type, const uint8_t *wrap_key, size_t wrap_key_len,
+     const NoiseBuffer *blob, NoiseBuffer *body);
+void noise_export_put_bytes(NoiseBuffer *body, const uint8_t *data, size_t len);
+void noise_export_put_uint(NoiseBuffer *body, uint64_t value, size_t len);
+void noise_export_get_bytes(NoiseBuffer *body, uint8_t *data, size_t len);
+uint64_t noise_export_get_uint(NoiseBuffer *body, size_t len);
+
+/* Single-suite builds (configure --enable-single-suite) only support
+   25519, ChaChaPoly, and BLAKE2s.  Calls to the primitives go directly
+   to the reference backend functions rather than through the function
+   pointers in the state objects, which allows the compiler to inline
+   them into HMAC, HKDF, and the transport path when LTO is enabled.
+   The function pointers are still populated so that the objects look
+   the same as in a regular build. */
+#if defined(NOISE_SINGLE_SUITE)
+
+/** @cond */
+
+#define NOISE_BACKEND_FUNC
+
+void noise_blake2s_reset(NoiseHashState *state);
+void noise_blake2s_update
+    (NoiseHashState *state, const uint8_t *data, size_t len);
+void noise_blake2s_finalize(NoiseHashState *state, uint8_t *hash);
+
+void noise_chachapoly_init_key(NoiseCipherState *state, const uint8_t *key);
+int noise_chachapoly_encrypt
+    (NoiseCipherState *state, const uint8_t *ad, size_t ad_len,
+     uint8_t *data, size_t len);
+int noise_chachapoly_decrypt
+    (NoiseCipherState *state, const uint8_t *ad, size_t ad_len,
+     uint8_t *data, size_t len);
+
+int noise_curve25519_generate_keypair
+    (NoiseDHState *state, const NoiseDHState *other);
+int noise_curve25519_set_keypair
+    (NoiseDHState *state, const uint8_t *private_key,
+     const uint8_t *public_key);
+int noise_curve25519_set_keypair_private
+    (NoiseDHState *state, const uint8_t *private_key);
+int noise_curve25519_validate_public_key
+    (const NoiseDHState *state, const uint8_t *public_key);
+int noise_curve25519_copy
+    (NoiseDHState *state, const NoiseDHState *from, const NoiseDHState *other);
+int noise_curve25519_calculate
+    (const NoiseDHState *private_key_state,
+     const NoiseDHState *public_key_state, uint8_t *shared_key);
+
+#define noise_hash_reset(state) noise_blake2s_reset((state))
+#define noise_hash_update(state, data, len) \
+    noise_blake2s_update((state), (data), (len))
+#define noise_hash_finalize(state, hash) \
+    noise_blake2s_finalize((state), (hash))
+
+#define noise_cipher_create(state) noise_chachapoly_new()
+#define noise_cipher_init_key(state, key) \
+    noise_chachapoly_init_key((state), (key))
+#define noise_cipher_encrypt(state, ad, ad_len, data, len) \
+    noise_chachapoly_encrypt((state), (ad), (ad_len), (data), (len))
+#define noise_cipher_decrypt(state, ad, ad_len, data, len) \
+    noise_chachapoly_decrypt((state), (ad), (ad_len), (data), (len))
+
+#define noise_dh_generate_keypair(state, other) \
+    noise_curve25519_generate_keypair((state), (other))
+#define noise_dh_set_keypair(state, private_key, public_key) \
+    noise_curve25519_set_keypair((state), (private_key), (public_key))
+#define noise_dh_set_keypair_private(state, private_key) \
+    noise_curve25519_set_keypair_private((state), (private_key))
+#define noise_dh_validate_public_key(state, public_key) \
+    noise_curve25519_validate_public_key((state), (public_key))
+#define noise_dh_copy(state, from, other) \
+    noise_curve25519_copy((state), (from), (other))
+#define noise_dh_calculate(private_key_state, public_key_state, shared_key) \
+    noise_curve25519_calculate \
+        ((private_key_state), (public_key_state), (shared_key))
+
+/** @endcond */
+
+#else /* !NOISE_SINGLE_SUITE */
+
+/** @cond */
+
+#define NOISE_BACKEND_FUNC static
+
+#define noise_hash_reset(state) (*((state)->reset))((state))
+#define noise_hash_update(state, data, len) \
+    (*((state)->update))((state), (data), (len))
+#define noise_hash_finalize(state, hash) \
+    (*((state)->finalize))((state), (hash))
+
+#define noise_cipher_create(state) (*((state)->create))()
+#define noise_cipher_init_key(state, key) \
+    (*((state)->init_key))((state), (key))
+#define noise_cipher_encrypt(state, ad, ad_len, data, len) \
+    (*((state)->encrypt))((state), (ad), (ad_len), (data), (len))
+#define noise_cipher_decrypt(state, ad, ad_len, data, len) \
+    (*((state)->decrypt))((state), (ad), (ad_len), (data), (len))
+
+#define noise_dh_generate_keypair(state, other) \
+    (*((state)->generate_keypair))((state), (other))
+#define noise_dh_set_keypair(state, private_key, public_key) \
+    (*((state)->set_keypair))((state), (private_key), (public_key))
+#define noise_dh_set_keypair_private(state, private_key) \
+    (*((state)->set_keypair_private))((state), (private_key))
+#define noise_dh_validate_public_key(state, public_key) \
+    (*((state)->validate_public_key))((state), (public_key))
+#define noise_dh_copy(state, from, other) \
+    (*((state)->copy))((state), (from), (other))
+#define noise_dh_calculate(private_key_state, public_key_state, shared_key) \
+    (*((private_key_state)->calculate)) \
+        ((private_key_state), (public_key_state), (shared_key))
+
+/** @endcond */
+
+#endif /* !NOISE_SINGLE_SUITE */
+
 /** @cond */
 
 NoiseCipherState *noise_chachapoly_new(void);
 NoiseCipherState *noise_aesgcm_new(void);
+NoiseCipherState *noise_aesgcm_bitsliced_new(void);
 
 NoiseHashState *noise_blake2s_new(void);
 NoiseHashState *noise_blake2b_new(void);
 NoiseHashState *noise_sha256_new(void);
 NoiseHashState *noise_sha512_new(void);
 
+/* Alternative implementations that use x86 SIMD instructions.  They are
+   compiled with per-function target attributes, which needs GCC or clang,
+   and the backend registry only selects them when the CPU supports them */
+#if (defined(__GNUC__) || defined(__clang__)) && \
+        (defined(__x86_64__) || defined(__i386__)) && \
+        !defined(NOISE_SINGLE_SUITE)
+#define NOISE_HAVE_X86_BACKENDS 1
+NoiseHashState *noise_blake2s_avx2_new(void);
+NoiseHashState *noise_blake2b_avx2_new(void);
+NoiseHashState *noise_sha256_shani_new(void);
+NoiseHashState *noise_sha256_avx2_new(void);
+NoiseHashState *noise_sha512_avx2_new(void);
+NoiseDHState *noise_newhope_avx2_new(void);
+#endif
+
 NoiseDHState *noise_curve25519_new(void);
 NoiseDHState *noise_curve448_new(void);
 NoiseDHState *noise_newhope_new(void);
+NoiseDHState *noise_mlkem768_new(void);
 
 NoiseSignState *noise_ed25519_new(void);
 
 /** @endcond */
 
+/**
+ * \brief Registry entry for one implementation of an algorithm.
+ *
+ * Exactly one of the constructor pointers is non-NULL, depending upon
+ * the category of the algorithm identifier.
+ */
+typedef struct
+{
+    /** \brief Algorithm identifier; NOISE_CIPHER_CHACHAPOLY, etc */
+    int id;
+
+    /** \brief Name of the implementation; e.g. "ref", "avx2" */
+    const char *name;
+
+    /** \brief NOISE_CPU_* features that the implementation requires */
+    int cpu_features;
+
+    /** \brief Creates a new CipherState object */
+    NoiseCipherState *(*new_cipher)(void);
+
+    /** \brief Creates a new HashState object */
+    NoiseHashState *(*new_hash)(void);
+
+    /** \brief Creates a new DHState object */
+    NoiseDHState *(*new_dh)(void);
+
+    /** \brief Creates a new SignState object */
+    NoiseSignState *(*new_sign)(void);
+
+} NoiseBackend;
+
+const NoiseBackend *noise_backend_lookup(int id);
+
 const uint8_t *noise_pattern_lookup(int id);
 uint8_t noise_pattern_reverse_flags(uint8_t flags);
+const NoiseCompiledPattern *noise_pattern_compiled_lookup(int id, int is_psk);
+
+void noise_hashstate_hmac
+    (NoiseHashState *state, const uint8_t *key, size_t key_len,
+     const uint8_t *data1, size_t data1_len,
+     const uint8_t *data2, size_t data2_len, uint8_t *hash);
+
+int noise_symmetricstate_split_keys
+    (NoiseSymmetricState *state, NoiseCipherState **c1, NoiseCipherState **c2,
+     const uint8_t *k1, const uint8_t *k2, size_t key_len);
+
+void noise_cipherstate_write_export
+    (const NoiseCipherState *state, NoiseBuffer *body);
+int noise_cipherstate_read_export(NoiseCipherState *state, NoiseBuffer *body);
+void noise_symmetricstate_write_export
+    (const NoiseSymmetricState *state, NoiseBuffer *body);
+int noise_symmetricstate_read_export
+    (NoiseSymmetricState **state, NoiseBuffer *body);
+
+int noise_handshakestate_new_ephemeral(NoiseHandshakeState *state);
+int noise_handshakestate_check_remote_static(NoiseHandshakeState *state);
+int noise_handshakestate_mix_dh
+    (NoiseHandshakeState *state, const NoiseDHState *private_key,
+     const NoiseDHState *public_key);
 
 #ifdef __cplusplus
 };
@@ -68,6 +68,7 @@ static NoiseIdMapping const algorithm_names[] = {
     {NOISE_DH_CURVE25519,       "25519",         5},
     {NOISE_DH_CURVE448,         "448",           3},
     {NOISE_DH_NEWHOPE,          "NewHope",       7},
+    {NOISE_DH_MLKEM768,         "MLKEM768",      8},
 
     /* Handshake patterns */
     {NOISE_PATTERN_N,           "N",             1},
@@ -232,6 +233,59 @@ static int noise_protocol_parse_field
     return id;
 }
 
+/**
+ * \brief Parses the DH field from a protocol name string, which may
+ * name a hybrid pair of algorithms; e.g. "25519+NewHope".
+ *
+ * \param name Points to the start of the protocol name string.
+ * \param len The total length of the protocol name string.
+ * \param posn The current position in the string, updated once the
+ * field has been parsed.
+ * \param hybrid_id Returns the identifier after the '+', or zero if
+ * the field does not name a hybrid pair.
+ * \param ok Initialized to non-zero by the caller.  Will be set to zero
+ * if a parse error was encountered.
+ *
+ * \return The algorithm identifier before the '+', or zero if the
+ * field's contents are not recognized.
+ */
+static int noise_protocol_parse_dh_field
+    (const char *name, size_t len, size_t *posn, int *hybrid_id, int *ok)
+{
+    size_t start, end, plus;
+    int id;
+
+    /* If the parse already failed, then nothing further to do */
+    *hybrid_id = 0;
+    if (!(*ok))
+        return 0;
+
+    /* Find the start and end of the field, which cannot be the last */
+    start = *posn;
+    while (*posn < len && name[*posn] != '_')
+        ++(*posn);
+    if (*posn >= len) {
+        *ok = 0;
+        return 0;
+    }
+    end = (*posn)++;
+
+    /* Split the field at the '+' if there is one */
+    plus = start;
+    while (plus < end && name[plus] != '+')
+        ++plus;
+    id = noise_name_to_id(NOISE_DH_CATEGORY, name + start, plus - start);
+    if (plus < end) {
+        *hybrid_id = noise_name_to_id
+            (NOISE_DH_CATEGORY, name + plus + 1, end - plus - 1);
+        if (!(*hybrid_id))
+            *ok = 0;
+    }
+    if (!id)
+        *ok = 0;
+    return id;
+}
+
 /**
  * \brief Parses a protocol name into a set of identifiers for the
  * algorithms that are indicated by the name.
@@ -244,6 +298,11 @@ static int noise_protocol_parse_field
  * \return NOISE_ERROR_INVALID_PARAM if either \a id or \a name is NULL.
  * \return NOISE_ERROR_UNKNOWN_NAME if the protocol name could not be parsed.
  *
+ * The DH field may name two algorithms separated by '+'; for example
+ * "Noise_XX_25519+NewHope_ChaChaPoly_BLAKE2s".  The second algorithm is
+ * returned in the \a hybrid_id field and is used for an additional
+ * ephemeral key exchange alongside each "e" and "ee" token.
+ *
  * \sa noise_protocol_id_to_name()
  */
 int noise_protocol_name_to_id
@@ -263,13 +322,12 @@ int noise_protocol_name_to_id
         (NOISE_PREFIX_CATEGORY, name, name_len, &posn, 0, &ok);
     id->pattern_id = noise_protocol_parse_field
         (NOISE_PATTERN_CATEGORY, name, name_len, &posn, 0, &ok);
-    id->dh_id = noise_protocol_parse_field
-        (NOISE_DH_CATEGORY, name, name_len, &posn, 0, &ok);
+    id->dh_id = noise_protocol_parse_dh_field
+        (name, name_len, &posn, &(id->hybrid_id), &ok);
     id->cipher_id = noise_protocol_parse_field
         (NOISE_CIPHER_CATEGORY, name, name_len, &posn, 0, &ok);
     id->hash_id = noise_protocol_parse_field
         (NOISE_HASH_CATEGORY, name, name_len, &posn, 1, &ok);
-    id->reserved_id = 0;
 
     /* If there was a parse error, then clear everything */
     if (!ok) {
@@ -278,7 +336,7 @@ int noise_protocol_name_to_id
         id->dh_id = NOISE_DH_NONE;
         id->cipher_id = NOISE_CIPHER_NONE;
         id->hash_id = NOISE_HASH_NONE;
-        id->reserved_id = 0;
+        id->hybrid_id = NOISE_DH_NONE;
         return NOISE_ERROR_UNKNOWN_NAME;
     }
 
@@ -294,14 +352,14 @@ int noise_protocol_name_to_id
  * \param name The name buffer to format the field into.
  * \param len The length of the \a name buffer in bytes.
  * \param posn The current format position within the \a name buffer.
- * \param is_last Non-zero if this is the last field in the name,
- * or zero if this field is not the last.
+ * \param separator The character to write after the field: '_' between
+ * fields, '+' between hybrid DH algorithms, or NUL after the last field.
  * \param err Points to an error code.  Initialized to NOISE_ERROR_NONE
  * by the caller and updated by this function if there is an error.
  */
 static void noise_protocol_format_field
     (int category, int id, char *name, size_t len, size_t *posn,
-     int is_last, int *err)
+     char separator, int *err)
 {
     const char *alg_name;
     size_t alg_len;
@@ -327,10 +385,9 @@ static void noise_protocol_format_field
     *posn += alg_len;
 
     /* Add either a separator or a terminator */
-    if (!is_last)
-        name[(*posn)++] = '_';
-    else
-        name[*posn] = '\0';
+    name[*posn] = separator;
+    if (separator != '\0')
+        ++(*posn);
 }
 
 /**
@@ -377,20 +434,22 @@ int noise_protocol_id_to_name
     posn = 0;
     err = NOISE_ERROR_NONE;
     noise_protocol_format_field
-        (NOISE_PREFIX_CATEGORY, id->prefix_id, name, name_len, &posn, 0, &err);
+        (NOISE_PREFIX_CATEGORY, id->prefix_id, name, name_len, &posn, '_', &err);
     noise_protocol_format_field
-        (NOISE_PATTERN_CATEGORY, id->pattern_id, name, name_len, &posn, 0, &err);
-    noise_protocol_format_field
-        (NOISE_DH_CATEGORY, id->dh_id, name, name_len, &posn, 0, &err);
+        (NOISE_PATTERN_CATEGORY, id->pattern_id, name, name_len, &posn, '_', &err);
+    if (id->hybrid_id) {
+        noise_protocol_format_field
+            (NOISE_DH_CATEGORY, id->dh_id, name, name_len, &posn, '+', &err);
+        noise_protocol_format_field
+            (NOISE_DH_CATEGORY, id->hybrid_id, name, name_len, &posn, '_', &err);
+    } else {
+        noise_protocol_format_field
+            (NOISE_DH_CATEGORY, id->dh_id, name, name_len, &posn, '_', &err);
+    }
     noise_protocol_format_field
-        (NOISE_CIPHER_CATEGORY, id->cipher_id, name, name_len, &posn, 0, &err);
+        (NOISE_CIPHER_CATEGORY, id->cipher_id, name, name_len, &posn, '_', &err);
     noise_protocol_format_field
-        (NOISE_HASH_CATEGORY, id->hash_id, name, name_len, &posn, 1, &err);
-
-    /* The reserved identifier must be zero.  We don't know how to
-       format reserved identifiers other than zero */
-    if (id->reserved_id != 0 && err == NOISE_ERROR_NONE)
-        err = NOISE_ERROR_UNKNOWN_ID;
+        (NOISE_HASH_CATEGORY, id->hash_id, name, name_len, &posn, '\0', &err);
 
     /* If an error occurred, then clear the buffer just to be safe */
     if (err != NOISE_ERROR_NONE)
@@ -0,0 +1,11281 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* This file is generated by noise-patternc - do not edit */
+
+#include "internal.h"
+#include <string.h>
+
+/**
+ * \file patterns-compiled.c
+ * \brief Straight-line implementations of the handshake patterns.
+ */
+
+/* Noise_N:
+ *   -> e, dhes
+ */
+
+static int noise_compiled_N_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_N_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_N_messages[] = {
+    {noise_compiled_N_write_0, noise_compiled_N_read_0}
+};
+
+static NoiseCompiledPattern const noise_compiled_N = {
+    1, noise_compiled_N_messages
+};
+
+/* Noise_N (PSK):
+ *   -> e, dhes
+ */
+
+static int noise_compiled_N_psk_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_N_psk_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_N_psk_messages[] = {
+    {noise_compiled_N_psk_write_0, noise_compiled_N_psk_read_0}
+};
+
+static NoiseCompiledPattern const noise_compiled_N_psk = {
+    1, noise_compiled_N_psk_messages
+};
+
+/* Noise_X:
+ *   -> e, dhes, s, dhss
+ */
+
+static int noise_compiled_X_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhss */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 4;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_X_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhss */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 4;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_X_messages[] = {
+    {noise_compiled_X_write_0, noise_compiled_X_read_0}
+};
+
+static NoiseCompiledPattern const noise_compiled_X = {
+    1, noise_compiled_X_messages
+};
+
+/* Noise_X (PSK):
+ *   -> e, dhes, s, dhss
+ */
+
+static int noise_compiled_X_psk_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhss */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 4;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_X_psk_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhss */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 4;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_X_psk_messages[] = {
+    {noise_compiled_X_psk_write_0, noise_compiled_X_psk_read_0}
+};
+
+static NoiseCompiledPattern const noise_compiled_X_psk = {
+    1, noise_compiled_X_psk_messages
+};
+
+/* Noise_K:
+ *   -> e, dhes, dhss
+ */
+
+static int noise_compiled_K_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhss */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_K_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhss */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_K_messages[] = {
+    {noise_compiled_K_write_0, noise_compiled_K_read_0}
+};
+
+static NoiseCompiledPattern const noise_compiled_K = {
+    1, noise_compiled_K_messages
+};
+
+/* Noise_K (PSK):
+ *   -> e, dhes, dhss
+ */
+
+static int noise_compiled_K_psk_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhss */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_K_psk_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhss */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_K_psk_messages[] = {
+    {noise_compiled_K_psk_write_0, noise_compiled_K_psk_read_0}
+};
+
+static NoiseCompiledPattern const noise_compiled_K_psk = {
+    1, noise_compiled_K_psk_messages
+};
+
+/* Noise_NN:
+ *   -> e
+ *   <- e, dhee
+ */
+
+static int noise_compiled_NN_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_NN_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_NN_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_NN_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_NN_messages[] = {
+    {noise_compiled_NN_write_0, noise_compiled_NN_read_0},
+    {noise_compiled_NN_write_1, noise_compiled_NN_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_NN = {
+    2, noise_compiled_NN_messages
+};
+
+/* Noise_NN (PSK):
+ *   -> e
+ *   <- e, dhee
+ */
+
+static int noise_compiled_NN_psk_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_NN_psk_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_NN_psk_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_NN_psk_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_NN_psk_messages[] = {
+    {noise_compiled_NN_psk_write_0, noise_compiled_NN_psk_read_0},
+    {noise_compiled_NN_psk_write_1, noise_compiled_NN_psk_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_NN_psk = {
+    2, noise_compiled_NN_psk_messages
+};
+
+/* Noise_NK:
+ *   -> e, dhes
+ *   <- e, dhee
+ */
+
+static int noise_compiled_NK_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_NK_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_NK_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_NK_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_NK_messages[] = {
+    {noise_compiled_NK_write_0, noise_compiled_NK_read_0},
+    {noise_compiled_NK_write_1, noise_compiled_NK_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_NK = {
+    2, noise_compiled_NK_messages
+};
+
+/* Noise_NK (PSK):
+ *   -> e, dhes
+ *   <- e, dhee
+ */
+
+static int noise_compiled_NK_psk_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_NK_psk_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_NK_psk_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_NK_psk_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_NK_psk_messages[] = {
+    {noise_compiled_NK_psk_write_0, noise_compiled_NK_psk_read_0},
+    {noise_compiled_NK_psk_write_1, noise_compiled_NK_psk_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_NK_psk = {
+    2, noise_compiled_NK_psk_messages
+};
+
+/* Noise_NX:
+ *   -> e
+ *   <- e, dhee, s, dhse
+ */
+
+static int noise_compiled_NX_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_NX_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_NX_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 4;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_NX_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 4;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_NX_messages[] = {
+    {noise_compiled_NX_write_0, noise_compiled_NX_read_0},
+    {noise_compiled_NX_write_1, noise_compiled_NX_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_NX = {
+    2, noise_compiled_NX_messages
+};
+
+/* Noise_NX (PSK):
+ *   -> e
+ *   <- e, dhee, s, dhse
+ */
+
+static int noise_compiled_NX_psk_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_NX_psk_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_NX_psk_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 4;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_NX_psk_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 4;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_NX_psk_messages[] = {
+    {noise_compiled_NX_psk_write_0, noise_compiled_NX_psk_read_0},
+    {noise_compiled_NX_psk_write_1, noise_compiled_NX_psk_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_NX_psk = {
+    2, noise_compiled_NX_psk_messages
+};
+
+/* Noise_XN:
+ *   -> e
+ *   <- e, dhee
+ *   -> s, dhse
+ */
+
+static int noise_compiled_XN_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XN_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XN_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XN_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XN_write_2
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XN_read_2
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_XN_messages[] = {
+    {noise_compiled_XN_write_0, noise_compiled_XN_read_0},
+    {noise_compiled_XN_write_1, noise_compiled_XN_read_1},
+    {noise_compiled_XN_write_2, noise_compiled_XN_read_2}
+};
+
+static NoiseCompiledPattern const noise_compiled_XN = {
+    3, noise_compiled_XN_messages
+};
+
+/* Noise_XN (PSK):
+ *   -> e
+ *   <- e, dhee
+ *   -> s, dhse
+ */
+
+static int noise_compiled_XN_psk_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XN_psk_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XN_psk_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XN_psk_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XN_psk_write_2
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XN_psk_read_2
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_XN_psk_messages[] = {
+    {noise_compiled_XN_psk_write_0, noise_compiled_XN_psk_read_0},
+    {noise_compiled_XN_psk_write_1, noise_compiled_XN_psk_read_1},
+    {noise_compiled_XN_psk_write_2, noise_compiled_XN_psk_read_2}
+};
+
+static NoiseCompiledPattern const noise_compiled_XN_psk = {
+    3, noise_compiled_XN_psk_messages
+};
+
+/* Noise_XK:
+ *   -> e, dhes
+ *   <- e, dhee
+ *   -> s, dhse
+ */
+
+static int noise_compiled_XK_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XK_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XK_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XK_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XK_write_2
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XK_read_2
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_XK_messages[] = {
+    {noise_compiled_XK_write_0, noise_compiled_XK_read_0},
+    {noise_compiled_XK_write_1, noise_compiled_XK_read_1},
+    {noise_compiled_XK_write_2, noise_compiled_XK_read_2}
+};
+
+static NoiseCompiledPattern const noise_compiled_XK = {
+    3, noise_compiled_XK_messages
+};
+
+/* Noise_XK (PSK):
+ *   -> e, dhes
+ *   <- e, dhee
+ *   -> s, dhse
+ */
+
+static int noise_compiled_XK_psk_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XK_psk_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XK_psk_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XK_psk_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XK_psk_write_2
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XK_psk_read_2
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_XK_psk_messages[] = {
+    {noise_compiled_XK_psk_write_0, noise_compiled_XK_psk_read_0},
+    {noise_compiled_XK_psk_write_1, noise_compiled_XK_psk_read_1},
+    {noise_compiled_XK_psk_write_2, noise_compiled_XK_psk_read_2}
+};
+
+static NoiseCompiledPattern const noise_compiled_XK_psk = {
+    3, noise_compiled_XK_psk_messages
+};
+
+/* Noise_XX:
+ *   -> e
+ *   <- e, dhee, s, dhse
+ *   -> s, dhse
+ */
+
+static int noise_compiled_XX_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XX_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XX_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XX_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XX_write_2
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XX_read_2
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_XX_messages[] = {
+    {noise_compiled_XX_write_0, noise_compiled_XX_read_0},
+    {noise_compiled_XX_write_1, noise_compiled_XX_read_1},
+    {noise_compiled_XX_write_2, noise_compiled_XX_read_2}
+};
+
+static NoiseCompiledPattern const noise_compiled_XX = {
+    3, noise_compiled_XX_messages
+};
+
+/* Noise_XX (PSK):
+ *   -> e
+ *   <- e, dhee, s, dhse
+ *   -> s, dhse
+ */
+
+static int noise_compiled_XX_psk_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XX_psk_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XX_psk_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XX_psk_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XX_psk_write_2
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XX_psk_read_2
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_XX_psk_messages[] = {
+    {noise_compiled_XX_psk_write_0, noise_compiled_XX_psk_read_0},
+    {noise_compiled_XX_psk_write_1, noise_compiled_XX_psk_read_1},
+    {noise_compiled_XX_psk_write_2, noise_compiled_XX_psk_read_2}
+};
+
+static NoiseCompiledPattern const noise_compiled_XX_psk = {
+    3, noise_compiled_XX_psk_messages
+};
+
+/* Noise_KN:
+ *   -> e
+ *   <- e, dhee, dhes
+ */
+
+static int noise_compiled_KN_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_KN_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_KN_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_KN_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_KN_messages[] = {
+    {noise_compiled_KN_write_0, noise_compiled_KN_read_0},
+    {noise_compiled_KN_write_1, noise_compiled_KN_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_KN = {
+    2, noise_compiled_KN_messages
+};
+
+/* Noise_KN (PSK):
+ *   -> e
+ *   <- e, dhee, dhes
+ */
+
+static int noise_compiled_KN_psk_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_KN_psk_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_KN_psk_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_KN_psk_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_KN_psk_messages[] = {
+    {noise_compiled_KN_psk_write_0, noise_compiled_KN_psk_read_0},
+    {noise_compiled_KN_psk_write_1, noise_compiled_KN_psk_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_KN_psk = {
+    2, noise_compiled_KN_psk_messages
+};
+
+/* Noise_KK:
+ *   -> e, dhes, dhss
+ *   <- e, dhee, dhes
+ */
+
+static int noise_compiled_KK_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhss */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 4;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_KK_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhss */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 4;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_KK_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_KK_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_KK_messages[] = {
+    {noise_compiled_KK_write_0, noise_compiled_KK_read_0},
+    {noise_compiled_KK_write_1, noise_compiled_KK_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_KK = {
+    2, noise_compiled_KK_messages
+};
+
+/* Noise_KK (PSK):
+ *   -> e, dhes, dhss
+ *   <- e, dhee, dhes
+ */
+
+static int noise_compiled_KK_psk_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhss */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 4;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_KK_psk_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhss */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 4;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_KK_psk_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_KK_psk_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_KK_psk_messages[] = {
+    {noise_compiled_KK_psk_write_0, noise_compiled_KK_psk_read_0},
+    {noise_compiled_KK_psk_write_1, noise_compiled_KK_psk_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_KK_psk = {
+    2, noise_compiled_KK_psk_messages
+};
+
+/* Noise_KX:
+ *   -> e
+ *   <- e, dhee, dhes, s, dhse
+ */
+
+static int noise_compiled_KX_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_KX_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_KX_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_KX_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_KX_messages[] = {
+    {noise_compiled_KX_write_0, noise_compiled_KX_read_0},
+    {noise_compiled_KX_write_1, noise_compiled_KX_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_KX = {
+    2, noise_compiled_KX_messages
+};
+
+/* Noise_KX (PSK):
+ *   -> e
+ *   <- e, dhee, dhes, s, dhse
+ */
+
+static int noise_compiled_KX_psk_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_KX_psk_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_KX_psk_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_KX_psk_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_KX_psk_messages[] = {
+    {noise_compiled_KX_psk_write_0, noise_compiled_KX_psk_read_0},
+    {noise_compiled_KX_psk_write_1, noise_compiled_KX_psk_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_KX_psk = {
+    2, noise_compiled_KX_psk_messages
+};
+
+/* Noise_IN:
+ *   -> e, s
+ *   <- e, dhee, dhes
+ */
+
+static int noise_compiled_IN_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    noise_symmetricstate_mix_hash(symmetric, out, s_len);
+    out += s_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IN_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* s */
+    noise_symmetricstate_mix_hash(symmetric, in, s_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, in, s_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IN_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IN_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_IN_messages[] = {
+    {noise_compiled_IN_write_0, noise_compiled_IN_read_0},
+    {noise_compiled_IN_write_1, noise_compiled_IN_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_IN = {
+    2, noise_compiled_IN_messages
+};
+
+/* Noise_IN (PSK):
+ *   -> e, s
+ *   <- e, dhee, dhes
+ */
+
+static int noise_compiled_IN_psk_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IN_psk_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IN_psk_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IN_psk_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_IN_psk_messages[] = {
+    {noise_compiled_IN_psk_write_0, noise_compiled_IN_psk_read_0},
+    {noise_compiled_IN_psk_write_1, noise_compiled_IN_psk_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_IN_psk = {
+    2, noise_compiled_IN_psk_messages
+};
+
+/* Noise_IK:
+ *   -> e, dhes, s, dhss
+ *   <- e, dhee, dhes
+ */
+
+static int noise_compiled_IK_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhss */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IK_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhss */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IK_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IK_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_IK_messages[] = {
+    {noise_compiled_IK_write_0, noise_compiled_IK_read_0},
+    {noise_compiled_IK_write_1, noise_compiled_IK_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_IK = {
+    2, noise_compiled_IK_messages
+};
+
+/* Noise_IK (PSK):
+ *   -> e, dhes, s, dhss
+ *   <- e, dhee, dhes
+ */
+
+static int noise_compiled_IK_psk_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhss */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IK_psk_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhss */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IK_psk_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IK_psk_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_IK_psk_messages[] = {
+    {noise_compiled_IK_psk_write_0, noise_compiled_IK_psk_read_0},
+    {noise_compiled_IK_psk_write_1, noise_compiled_IK_psk_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_IK_psk = {
+    2, noise_compiled_IK_psk_messages
+};
+
+/* Noise_IX:
+ *   -> e, s
+ *   <- e, dhee, dhes, s, dhse
+ */
+
+static int noise_compiled_IX_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    noise_symmetricstate_mix_hash(symmetric, out, s_len);
+    out += s_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IX_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* s */
+    noise_symmetricstate_mix_hash(symmetric, in, s_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, in, s_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IX_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IX_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_IX_messages[] = {
+    {noise_compiled_IX_write_0, noise_compiled_IX_read_0},
+    {noise_compiled_IX_write_1, noise_compiled_IX_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_IX = {
+    2, noise_compiled_IX_messages
+};
+
+/* Noise_IX (PSK):
+ *   -> e, s
+ *   <- e, dhee, dhes, s, dhse
+ */
+
+static int noise_compiled_IX_psk_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IX_psk_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IX_psk_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IX_psk_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_IX_psk_messages[] = {
+    {noise_compiled_IX_psk_write_0, noise_compiled_IX_psk_read_0},
+    {noise_compiled_IX_psk_write_1, noise_compiled_IX_psk_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_IX_psk = {
+    2, noise_compiled_IX_psk_messages
+};
+
+/* Noise_XXfallback:
+ *   -> e, dhee, s, dhse
+ *   <- s, dhse
+ */
+
+static int noise_compiled_XXfallback_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XXfallback_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XXfallback_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XXfallback_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_XXfallback_messages[] = {
+    {noise_compiled_XXfallback_write_0, noise_compiled_XXfallback_read_0},
+    {noise_compiled_XXfallback_write_1, noise_compiled_XXfallback_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_XXfallback = {
+    2, noise_compiled_XXfallback_messages
+};
+
+/* Noise_XXfallback (PSK):
+ *   -> e, dhee, s, dhse
+ *   <- s, dhse
+ */
+
+static int noise_compiled_XXfallback_psk_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XXfallback_psk_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XXfallback_psk_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XXfallback_psk_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_XXfallback_psk_messages[] = {
+    {noise_compiled_XXfallback_psk_write_0, noise_compiled_XXfallback_psk_read_0},
+    {noise_compiled_XXfallback_psk_write_1, noise_compiled_XXfallback_psk_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_XXfallback_psk = {
+    2, noise_compiled_XXfallback_psk_messages
+};
+
+/* Noise_Xnoidh:
+ *   -> e, s, dhes, dhss
+ */
+
+static int noise_compiled_Xnoidh_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    noise_symmetricstate_mix_hash(symmetric, out, s_len);
+    out += s_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhss */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 4;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_Xnoidh_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* s */
+    noise_symmetricstate_mix_hash(symmetric, in, s_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, in, s_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhss */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 4;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_Xnoidh_messages[] = {
+    {noise_compiled_Xnoidh_write_0, noise_compiled_Xnoidh_read_0}
+};
+
+static NoiseCompiledPattern const noise_compiled_Xnoidh = {
+    1, noise_compiled_Xnoidh_messages
+};
+
+/* Noise_Xnoidh (PSK):
+ *   -> e, s, dhes, dhss
+ */
+
+static int noise_compiled_Xnoidh_psk_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhss */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 4;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_Xnoidh_psk_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhss */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 4;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_Xnoidh_psk_messages[] = {
+    {noise_compiled_Xnoidh_psk_write_0, noise_compiled_Xnoidh_psk_read_0}
+};
+
+static NoiseCompiledPattern const noise_compiled_Xnoidh_psk = {
+    1, noise_compiled_Xnoidh_psk_messages
+};
+
+/* Noise_NXnoidh:
+ *   -> e
+ *   <- e, s, dhee, dhse
+ */
+
+static int noise_compiled_NXnoidh_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_NXnoidh_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_NXnoidh_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    noise_symmetricstate_mix_hash(symmetric, out, s_len);
+    out += s_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 4;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_NXnoidh_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* s */
+    noise_symmetricstate_mix_hash(symmetric, in, s_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, in, s_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 4;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_NXnoidh_messages[] = {
+    {noise_compiled_NXnoidh_write_0, noise_compiled_NXnoidh_read_0},
+    {noise_compiled_NXnoidh_write_1, noise_compiled_NXnoidh_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_NXnoidh = {
+    2, noise_compiled_NXnoidh_messages
+};
+
+/* Noise_NXnoidh (PSK):
+ *   -> e
+ *   <- e, s, dhee, dhse
+ */
+
+static int noise_compiled_NXnoidh_psk_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_NXnoidh_psk_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_NXnoidh_psk_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 4;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_NXnoidh_psk_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 4;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_NXnoidh_psk_messages[] = {
+    {noise_compiled_NXnoidh_psk_write_0, noise_compiled_NXnoidh_psk_read_0},
+    {noise_compiled_NXnoidh_psk_write_1, noise_compiled_NXnoidh_psk_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_NXnoidh_psk = {
+    2, noise_compiled_NXnoidh_psk_messages
+};
+
+/* Noise_XXnoidh:
+ *   -> e
+ *   <- e, s, dhee, dhse
+ *   -> s, dhse
+ */
+
+static int noise_compiled_XXnoidh_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XXnoidh_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XXnoidh_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    noise_symmetricstate_mix_hash(symmetric, out, s_len);
+    out += s_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XXnoidh_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* s */
+    noise_symmetricstate_mix_hash(symmetric, in, s_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, in, s_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XXnoidh_write_2
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XXnoidh_read_2
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_XXnoidh_messages[] = {
+    {noise_compiled_XXnoidh_write_0, noise_compiled_XXnoidh_read_0},
+    {noise_compiled_XXnoidh_write_1, noise_compiled_XXnoidh_read_1},
+    {noise_compiled_XXnoidh_write_2, noise_compiled_XXnoidh_read_2}
+};
+
+static NoiseCompiledPattern const noise_compiled_XXnoidh = {
+    3, noise_compiled_XXnoidh_messages
+};
+
+/* Noise_XXnoidh (PSK):
+ *   -> e
+ *   <- e, s, dhee, dhse
+ *   -> s, dhse
+ */
+
+static int noise_compiled_XXnoidh_psk_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XXnoidh_psk_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XXnoidh_psk_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XXnoidh_psk_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XXnoidh_psk_write_2
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_XXnoidh_psk_read_2
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_XXnoidh_psk_messages[] = {
+    {noise_compiled_XXnoidh_psk_write_0, noise_compiled_XXnoidh_psk_read_0},
+    {noise_compiled_XXnoidh_psk_write_1, noise_compiled_XXnoidh_psk_read_1},
+    {noise_compiled_XXnoidh_psk_write_2, noise_compiled_XXnoidh_psk_read_2}
+};
+
+static NoiseCompiledPattern const noise_compiled_XXnoidh_psk = {
+    3, noise_compiled_XXnoidh_psk_messages
+};
+
+/* Noise_KXnoidh:
+ *   -> e
+ *   <- e, s, dhee, dhes, dhse
+ */
+
+static int noise_compiled_KXnoidh_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_KXnoidh_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_KXnoidh_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    noise_symmetricstate_mix_hash(symmetric, out, s_len);
+    out += s_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_KXnoidh_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* s */
+    noise_symmetricstate_mix_hash(symmetric, in, s_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, in, s_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_KXnoidh_messages[] = {
+    {noise_compiled_KXnoidh_write_0, noise_compiled_KXnoidh_read_0},
+    {noise_compiled_KXnoidh_write_1, noise_compiled_KXnoidh_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_KXnoidh = {
+    2, noise_compiled_KXnoidh_messages
+};
+
+/* Noise_KXnoidh (PSK):
+ *   -> e
+ *   <- e, s, dhee, dhes, dhse
+ */
+
+static int noise_compiled_KXnoidh_psk_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_KXnoidh_psk_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 2;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_KXnoidh_psk_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_KXnoidh_psk_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_KXnoidh_psk_messages[] = {
+    {noise_compiled_KXnoidh_psk_write_0, noise_compiled_KXnoidh_psk_read_0},
+    {noise_compiled_KXnoidh_psk_write_1, noise_compiled_KXnoidh_psk_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_KXnoidh_psk = {
+    2, noise_compiled_KXnoidh_psk_messages
+};
+
+/* Noise_IKnoidh:
+ *   -> e, s, dhes, dhss
+ *   <- e, dhee, dhes
+ */
+
+static int noise_compiled_IKnoidh_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    noise_symmetricstate_mix_hash(symmetric, out, s_len);
+    out += s_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhss */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IKnoidh_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* s */
+    noise_symmetricstate_mix_hash(symmetric, in, s_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, in, s_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhss */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IKnoidh_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IKnoidh_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_IKnoidh_messages[] = {
+    {noise_compiled_IKnoidh_write_0, noise_compiled_IKnoidh_read_0},
+    {noise_compiled_IKnoidh_write_1, noise_compiled_IKnoidh_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_IKnoidh = {
+    2, noise_compiled_IKnoidh_messages
+};
+
+/* Noise_IKnoidh (PSK):
+ *   -> e, s, dhes, dhss
+ *   <- e, dhee, dhes
+ */
+
+static int noise_compiled_IKnoidh_psk_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhss */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IKnoidh_psk_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhss */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IKnoidh_psk_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IKnoidh_psk_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    fixed_len = e_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_IKnoidh_psk_messages[] = {
+    {noise_compiled_IKnoidh_psk_write_0, noise_compiled_IKnoidh_psk_read_0},
+    {noise_compiled_IKnoidh_psk_write_1, noise_compiled_IKnoidh_psk_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_IKnoidh_psk = {
+    2, noise_compiled_IKnoidh_psk_messages
+};
+
+/* Noise_IXnoidh:
+ *   -> e, s
+ *   <- e, s, dhee, dhes, dhse
+ */
+
+static int noise_compiled_IXnoidh_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    noise_symmetricstate_mix_hash(symmetric, out, s_len);
+    out += s_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IXnoidh_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* s */
+    noise_symmetricstate_mix_hash(symmetric, in, s_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, in, s_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IXnoidh_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    out += e_len;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    noise_symmetricstate_mix_hash(symmetric, out, s_len);
+    out += s_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IXnoidh_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    in += e_len;
+
+    /* s */
+    noise_symmetricstate_mix_hash(symmetric, in, s_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, in, s_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_IXnoidh_messages[] = {
+    {noise_compiled_IXnoidh_write_0, noise_compiled_IXnoidh_read_0},
+    {noise_compiled_IXnoidh_write_1, noise_compiled_IXnoidh_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_IXnoidh = {
+    2, noise_compiled_IXnoidh_messages
+};
+
+/* Noise_IXnoidh (PSK):
+ *   -> e, s
+ *   <- e, s, dhee, dhes, dhse
+ */
+
+static int noise_compiled_IXnoidh_psk_write_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_READ_MESSAGE;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IXnoidh_psk_read_0
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 3;
+    state->action = NOISE_ACTION_WRITE_MESSAGE;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IXnoidh_psk_write_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     const NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t payload_len = payload ? payload->size : 0;
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *out = message->data;
+    NoiseBuffer rest;
+    int err;
+
+    err = noise_handshakestate_new_ephemeral(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    e_len = state->dh_local_ephemeral->public_key_len;
+    s_len = state->dh_local_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->max_size < fixed_len ||
+            (message->max_size - fixed_len) < payload_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    memcpy(out, state->dh_local_ephemeral->public_key, e_len);
+    noise_symmetricstate_mix_hash(symmetric, out, e_len);
+    err = noise_symmetricstate_mix_key(symmetric, out, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += e_len;
+
+    /* s */
+    memcpy(out, state->dh_local_static->public_key, s_len);
+    rest.data = out;
+    rest.size = s_len;
+    rest.max_size = s_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    out += rest.size;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    if (payload_len)
+        memcpy(out, payload->data, payload_len);
+    rest.data = out;
+    rest.size = payload_len;
+    rest.max_size = payload_len + mac_len;
+    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    message->size = (size_t)(out - message->data) + rest.size;
+    return NOISE_ERROR_NONE;
+}
+
+static int noise_compiled_IXnoidh_psk_read_1
+    (NoiseHandshakeState *state, NoiseBuffer *message,
+     NoiseBuffer *payload)
+{
+    NoiseSymmetricState *symmetric = state->symmetric;
+    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);
+    size_t e_len;
+    size_t s_len;
+    size_t fixed_len;
+    uint8_t *in = message->data;
+    NoiseBuffer msg;
+    int err;
+
+    e_len = state->dh_remote_ephemeral->public_key_len;
+    s_len = state->dh_remote_static->public_key_len;
+    fixed_len = e_len + s_len + mac_len + mac_len;
+    if (message->size < fixed_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+
+    /* e */
+    noise_symmetricstate_mix_hash(symmetric, in, e_len);
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_ephemeral, in, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))
+        return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    err = noise_symmetricstate_mix_key
+        (symmetric, state->dh_remote_ephemeral->public_key, e_len);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += e_len;
+
+    /* s */
+    msg.data = in;
+    msg.size = s_len + mac_len;
+    msg.max_size = s_len + mac_len;
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_dhstate_set_public_key
+        (state->dh_remote_static, msg.data, msg.size);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_check_remote_static(state);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    in += s_len + mac_len;
+
+    /* dhee */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhes */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_static, state->dh_remote_ephemeral);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* dhse */
+    err = noise_handshakestate_mix_dh
+        (state, state->dh_local_ephemeral, state->dh_remote_static);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Advance past the tokens for this message */
+    state->tokens += 5;
+    state->action = NOISE_ACTION_SPLIT;
+
+    /* payload */
+    msg.data = in;
+    msg.size = message->size - (size_t)(in - message->data);
+    msg.max_size = message->max_size - (size_t)(in - message->data);
+    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    if (payload) {
+        if (msg.size > payload->max_size)
+            return NOISE_ERROR_INVALID_LENGTH;
+        memcpy(payload->data, msg.data, msg.size);
+        payload->size = msg.size;
+    }
+    return NOISE_ERROR_NONE;
+}
+
+static NoiseCompiledMessage const noise_compiled_IXnoidh_psk_messages[] = {
+    {noise_compiled_IXnoidh_psk_write_0, noise_compiled_IXnoidh_psk_read_0},
+    {noise_compiled_IXnoidh_psk_write_1, noise_compiled_IXnoidh_psk_read_1}
+};
+
+static NoiseCompiledPattern const noise_compiled_IXnoidh_psk = {
+    2, noise_compiled_IXnoidh_psk_messages
+};
+
+/**
+ * \brief Looks up the compiled form of a handshake pattern.
+ *
+ * \param id The identifier for the handshake pattern.
+ * \param is_psk Non-zero for the PSK variant of the pattern.
+ *
+ * \return A pointer to the compiled pattern, or NULL if \a id
+ * does not have a compiled form.
+ */
+const NoiseCompiledPattern *noise_pattern_compiled_lookup(int id, int is_psk)
+{
+    switch (id) {
+    case NOISE_ID('P', 1):
+        return is_psk ? &noise_compiled_N_psk
+                      : &noise_compiled_N;
+    case NOISE_ID('P', 2):
+        return is_psk ? &noise_compiled_X_psk
+                      : &noise_compiled_X;
+    case NOISE_ID('P', 3):
+        return is_psk ? &noise_compiled_K_psk
+                      : &noise_compiled_K;
+    case NOISE_ID('P', 4):
+        return is_psk ? &noise_compiled_NN_psk
+                      : &noise_compiled_NN;
+    case NOISE_ID('P', 5):
+        return is_psk ? &noise_compiled_NK_psk
+                      : &noise_compiled_NK;
+    case NOISE_ID('P', 6):
+        return is_psk ? &noise_compiled_NX_psk
+                      : &noise_compiled_NX;
+    case NOISE_ID('P', 7):
+        return is_psk ? &noise_compiled_XN_psk
+                      : &noise_compiled_XN;
+    case NOISE_ID('P', 8):
+        return is_psk ? &noise_compiled_XK_psk
+                      : &noise_compiled_XK;
+    case NOISE_ID('P', 9):
+        return is_psk ? &noise_compiled_XX_psk
+                      : &noise_compiled_XX;
+    case NOISE_ID('P', 10):
+        return is_psk ? &noise_compiled_KN_psk
+                      : &noise_compiled_KN;
+    case NOISE_ID('P', 11):
+        return is_psk ? &noise_compiled_KK_psk
+                      : &noise_compiled_KK;
+    case NOISE_ID('P', 12):
+        return is_psk ? &noise_compiled_KX_psk
+                      : &noise_compiled_KX;
+    case NOISE_ID('P', 13):
+        return is_psk ? &noise_compiled_IN_psk
+                      : &noise_compiled_IN;
+    case NOISE_ID('P', 14):
+        return is_psk ? &noise_compiled_IK_psk
+                      : &noise_compiled_IK;
+    case NOISE_ID('P', 15):
+        return is_psk ? &noise_compiled_IX_psk
+                      : &noise_compiled_IX;
+    case NOISE_ID('P', 16):
+        return is_psk ? &noise_compiled_XXfallback_psk
+                      : &noise_compiled_XXfallback;
+    case NOISE_ID('P', 32):
+        return is_psk ? &noise_compiled_Xnoidh_psk
+                      : &noise_compiled_Xnoidh;
+    case NOISE_ID('P', 33):
+        return is_psk ? &noise_compiled_NXnoidh_psk
+                      : &noise_compiled_NXnoidh;
+    case NOISE_ID('P', 34):
+        return is_psk ? &noise_compiled_XXnoidh_psk
+                      : &noise_compiled_XXnoidh;
+    case NOISE_ID('P', 35):
+        return is_psk ? &noise_compiled_KXnoidh_psk
+                      : &noise_compiled_KXnoidh;
+    case NOISE_ID('P', 36):
+        return is_psk ? &noise_compiled_IKnoidh_psk
+                      : &noise_compiled_IKnoidh;
+    case NOISE_ID('P', 37):
+        return is_psk ? &noise_compiled_IXnoidh_psk
+                      : &noise_compiled_IXnoidh;
+    default: break;
+    }
+    return 0;
+}
@@ -0,0 +1,558 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "internal.h"
+#include <stdlib.h>
+#include <string.h>
+#if defined(__WIN32__) || defined(WIN32)
+#define NOISE_SECMEM_MMAP 0
+#else
+#define NOISE_SECMEM_MMAP 1
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
+#if NOISE_SECMEM_MMAP && defined(HAVE_LIBPTHREAD)
+#include <pthread.h>
+#define NOISE_SECMEM_THREADS 1
+#else
+#define NOISE_SECMEM_THREADS 0
+#endif
+#if NOISE_SECMEM_THREADS && (defined(__GNUC__) || defined(__clang__))
+#define NOISE_SECMEM_TLS 1
+#else
+#define NOISE_SECMEM_TLS 0
+#endif
+
+/**
+ * \file secmem.h
+ * \brief Secure memory allocator interface
+ */
+
+/**
+ * \file secmem.c
+ * \brief Secure memory allocator implementation
+ */
+
+/**
+ * \defgroup secmem Secure Memory API
+ *
+ * By default, Noise objects are allocated from the general heap with
+ * calloc() and are scrubbed before they are returned with free().
+ * The memory may be swapped out while the object is live, and the heap
+ * may hand out neighbouring memory to unrelated code.
+ *
+ * The secure allocator is an optional replacement for objects that
+ * are allocated with noise_new().  Calling noise_secmem_init() reserves
+ * an address range that is carved into slabs of fixed-size objects on
+ * demand.  Each slab is locked into RAM with mlock(), is excluded from
+ * core dumps, and is surrounded by inaccessible guard pages.  Freed
+ * objects are wiped and kept on per-thread free lists for reuse, so
+ * creating and destroying handshakes does not touch the heap at all.
+ *
+ * Objects that are too large for the biggest slab class, or that are
+ * allocated after the reserved range is exhausted, are allocated from
+ * the heap as before.
+ *
+ * The allocator can also be enabled by setting the <tt>NOISE_SECMEM</tt>
+ * environment variable to a non-empty value other than "0" before the
+ * first object is created.
+ */
+/**@{*/
+
+/** @cond */
+
+/* Size of the slabs that are carved from the reserved range */
+#define NOISE_SECMEM_SLAB_SIZE (64 * 1024)
+
+/* Default size of the reserved range */
+#define NOISE_SECMEM_DEFAULT_SIZE (16 * 1024 * 1024)
+
+/* Maximum number of free objects per class in a thread's cache */
+#define NOISE_SECMEM_CACHE_MAX 16
+
+/* Object size classes, which are multiples of 64 to keep objects aligned.
+   The classes are chosen to fit the DHState objects for the post-quantum
+   algorithms without wasting too much space */
+static size_t const noise_secmem_class_sizes[] = {
+    64, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096, 6144, 8192
+};
+#define NOISE_SECMEM_NUM_CLASSES \
+    (sizeof(noise_secmem_class_sizes) / sizeof(noise_secmem_class_sizes[0]))
+#define NOISE_SECMEM_MAX_OBJECT 8192
+
+/* Allocation state for one size class */
+typedef struct
+{
+    uint8_t *next;          /* Next unused object in the current slab */
+    uint8_t *end;           /* End of the objects in the current slab */
+    void *free_list;        /* Objects that have been freed */
+
+} NoiseSecMemClass;
+
+/* Global state for the allocator */
+static struct
+{
+    uint8_t *base;          /* Start of the reserved range */
+    size_t size;            /* Size of the reserved range */
+    size_t used;            /* Bytes of the range that are in use */
+    size_t page_size;       /* System page size */
+    size_t slab_size;       /* Size of each slab, a multiple of the page */
+    int enabled;            /* Non-zero if new objects come from slabs */
+    int env_checked;        /* Non-zero once NOISE_SECMEM has been checked */
+    NoiseSecMemClass classes[NOISE_SECMEM_NUM_CLASSES];
+    NoiseSecMemStats stats;
+
+} noise_secmem;
+
+#if NOISE_SECMEM_THREADS
+static pthread_mutex_t noise_secmem_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define noise_secmem_lock() pthread_mutex_lock(&noise_secmem_mutex)
+#define noise_secmem_unlock() pthread_mutex_unlock(&noise_secmem_mutex)
+#else
+#define noise_secmem_lock() do { ; } while (0)
+#define noise_secmem_unlock() do { ; } while (0)
+#endif
+
+#if NOISE_SECMEM_TLS
+
+/* Per-thread cache of free objects for each size class */
+typedef struct
+{
+    void *head[NOISE_SECMEM_NUM_CLASSES];
+    unsigned count[NOISE_SECMEM_NUM_CLASSES];
+    int registered;
+
+} NoiseSecMemCache;
+
+static __thread NoiseSecMemCache noise_secmem_cache;
+static pthread_key_t noise_secmem_key;
+static int noise_secmem_key_created = 0;
+
+#endif
+
+/* The fast paths read "enabled", "env_checked", and "base" without taking
+   the lock.  They are written with release stores and read with acquire
+   loads.  The "size" is set before "base" is published and never changes
+   afterwards, so it is safe to read once "base" has been seen */
+#if defined(__ATOMIC_ACQUIRE) && defined(__ATOMIC_RELEASE)
+#define noise_secmem_load(ptr)  __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define noise_secmem_store(ptr, value) \
+    __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+#else
+#define noise_secmem_load(ptr)  (*(ptr))
+#define noise_secmem_store(ptr, value) (*(ptr) = (value))
+#endif
+
+/* Gets or sets the "next" link in a free object */
+#define noise_secmem_link(obj) (*((void **)(obj)))
+
+/** @endcond */
+
+/**
+ * \brief Finds the size class for an object size.
+ *
+ * \param size The size of the object in bytes, between 1 and
+ * NOISE_SECMEM_MAX_OBJECT.
+ *
+ * \return The index of the smallest class that can hold \a size bytes.
+ */
+static size_t noise_secmem_class(size_t size)
+{
+    size_t cls = 0;
+    while (noise_secmem_class_sizes[cls] < size)
+        ++cls;
+    return cls;
+}
+
+/**
+ * \brief Maps a new slab for a size class.
+ *
+ * \param cls Points to the size class.
+ * \param object_size The size of the objects in the class.
+ *
+ * \return Non-zero if the slab was mapped, or zero if the reserved
+ * range is full or the pages could not be made accessible.
+ *
+ * Must be called with the allocator lock held.  Slabs are separated by
+ * a guard page if NOISE_SECMEM_GUARD was specified, and the range starts
+ * with a guard page, so that running off either end of a slab faults.
+ */
+static int noise_secmem_new_slab(NoiseSecMemClass *cls, size_t object_size)
+{
+#if NOISE_SECMEM_MMAP
+    size_t guard = (noise_secmem.stats.flags & NOISE_SECMEM_GUARD)
+                        ? noise_secmem.page_size : 0;
+    uint8_t *slab;
+    if ((noise_secmem.size - noise_secmem.used) <
+            (noise_secmem.slab_size + guard))
+        return 0;
+    slab = noise_secmem.base + noise_secmem.used;
+    if (mprotect(slab, noise_secmem.slab_size, PROT_READ | PROT_WRITE) != 0)
+        return 0;
+    noise_secmem.used += noise_secmem.slab_size + guard;
+    noise_secmem.stats.slab_bytes += noise_secmem.slab_size;
+
+    /* Keep the slab out of swap and core dumps.  Failing to lock is not
+       fatal because the limit on locked memory is often quite low */
+    if (noise_secmem.stats.flags & NOISE_SECMEM_LOCK) {
+        if (mlock(slab, noise_secmem.slab_size) == 0)
+            noise_secmem.stats.locked_bytes += noise_secmem.slab_size;
+        else
+            ++(noise_secmem.stats.lock_failures);
+    }
+#if defined(MADV_DONTDUMP)
+    if (noise_secmem.stats.flags & NOISE_SECMEM_NO_DUMP)
+        madvise(slab, noise_secmem.slab_size, MADV_DONTDUMP);
+#endif
+
+    /* Fresh pages are already zero, so objects can be handed out as-is */
+    cls->next = slab;
+    cls->end = slab + (noise_secmem.slab_size / object_size) * object_size;
+    return 1;
+#else
+    (void)cls;
+    (void)object_size;
+    return 0;
+#endif
+}
+
+#if NOISE_SECMEM_TLS
+
+/**
+ * \brief Returns a list of free objects to the global free list.
+ *
+ * \param cls The index of the size class.
+ * \param head The first object in the list.
+ *
+ * Must be called without the allocator lock held.
+ */
+static void noise_secmem_release_list(size_t cls, void *head)
+{
+    void *tail = head;
+    if (!head)
+        return;
+    while (noise_secmem_link(tail))
+        tail = noise_secmem_link(tail);
+    noise_secmem_lock();
+    noise_secmem_link(tail) = noise_secmem.classes[cls].free_list;
+    noise_secmem.classes[cls].free_list = head;
+    noise_secmem_unlock();
+}
+
+/**
+ * \brief Flushes a thread's cache of free objects when it exits.
+ *
+ * \param arg Points to the thread's cache.
+ */
+static void noise_secmem_thread_exit(void *arg)
+{
+    NoiseSecMemCache *cache = (NoiseSecMemCache *)arg;
+    size_t cls;
+    for (cls = 0; cls < NOISE_SECMEM_NUM_CLASSES; ++cls) {
+        noise_secmem_release_list(cls, cache->head[cls]);
+        cache->head[cls] = 0;
+        cache->count[cls] = 0;
+    }
+}
+
+#endif
+
+/**
+ * \brief Reserves the address range for the secure memory allocator
+ * and starts allocating new objects from it.
+ *
+ * \param max_size The maximum amount of address space to reserve for
+ * slabs, or zero for the default of 16 megabytes.
+ * \param flags Flags that control how slabs are protected; e.g.
+ * NOISE_SECMEM_DEFAULT.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_NOT_APPLICABLE if the platform does not support
+ * the secure memory allocator.
+ * \return NOISE_ERROR_NO_MEMORY if the address range could not be reserved.
+ *
+ * The \a flags are a combination of NOISE_SECMEM_LOCK to lock slabs into
+ * RAM, NOISE_SECMEM_GUARD to put guard pages between slabs, and
+ * NOISE_SECMEM_NO_DUMP to exclude slabs from core dumps.  Failing to
+ * lock a slab is not an error; the failure is counted in the statistics
+ * that are reported by noise_secmem_get_stats().
+ *
+ * The address range is reserved without being committed, so a large
+ * \a max_size only costs address space until slabs are carved from it.
+ * The range is never released because objects may still live in it.
+ * If the allocator has already been initialized, then this function
+ * enables it again with the original parameters.
+ *
+ * Objects that were allocated from the heap before this function was
+ * called can still be freed normally afterwards.
+ *
+ * \sa noise_secmem_disable(), noise_secmem_get_stats()
+ */
+int noise_secmem_init(size_t max_size, int flags)
+{
+#if NOISE_SECMEM_MMAP
+    void *base;
+    long page_size;
+    int err = NOISE_ERROR_NONE;
+
+    noise_secmem_lock();
+    noise_secmem_store(&(noise_secmem.env_checked), 1);
+    if (noise_secmem.base) {
+        noise_secmem_store(&(noise_secmem.enabled), 1);
+        noise_secmem_unlock();
+        return NOISE_ERROR_NONE;
+    }
+
+    /* Round the slab and range sizes to multiples of the page size */
+    page_size = sysconf(_SC_PAGESIZE);
+    if (page_size <= 0)
+        page_size = 4096;
+    noise_secmem.page_size = (size_t)page_size;
+    noise_secmem.slab_size =
+        ((NOISE_SECMEM_SLAB_SIZE + noise_secmem.page_size - 1) /
+            noise_secmem.page_size) * noise_secmem.page_size;
+    if (!max_size)
+        max_size = NOISE_SECMEM_DEFAULT_SIZE;
+    max_size = ((max_size + noise_secmem.page_size - 1) /
+                    noise_secmem.page_size) * noise_secmem.page_size;
+    if (max_size < noise_secmem.slab_size + 2 * noise_secmem.page_size)
+        max_size = noise_secmem.slab_size + 2 * noise_secmem.page_size;
+
+    /* Reserve the range with no access.  Slabs are made accessible when
+       they are carved out, and everything else acts as a guard */
+#if defined(MAP_NORESERVE)
+    base = mmap(0, max_size, PROT_NONE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+#else
+    base = mmap(0, max_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#endif
+    if (base == MAP_FAILED) {
+        err = NOISE_ERROR_NO_MEMORY;
+    } else {
+#if NOISE_SECMEM_TLS
+        if (!noise_secmem_key_created) {
+            if (pthread_key_create
+                    (&noise_secmem_key, noise_secmem_thread_exit) == 0)
+                noise_secmem_key_created = 1;
+        }
+#endif
+        noise_secmem.size = max_size;
+        noise_secmem.used = (flags & NOISE_SECMEM_GUARD)
+                                ? noise_secmem.page_size : 0;
+        noise_secmem.stats.reserved_bytes = max_size;
+        noise_secmem.stats.flags = flags;
+        noise_secmem_store(&(noise_secmem.base), (uint8_t *)base);
+        noise_secmem_store(&(noise_secmem.enabled), 1);
+    }
+    noise_secmem_unlock();
+    return err;
+#else
+    (void)max_size;
+    (void)flags;
+    return NOISE_ERROR_NOT_APPLICABLE;
+#endif
+}
+
+/**
+ * \brief Stops allocating new objects from the secure memory allocator.
+ *
+ * Objects that were already allocated from slabs remain valid and are
+ * returned to their slabs when they are freed.  New objects are
+ * allocated from the heap until noise_secmem_init() is called again.
+ *
+ * This function is not safe to call while other threads are allocating
+ * Noise objects.  An allocation that is already in progress may still
+ * return an object from a slab after this function returns.
+ *
+ * \sa noise_secmem_init(), noise_secmem_is_enabled()
+ */
+void noise_secmem_disable(void)
+{
+    noise_secmem_lock();
+    noise_secmem_store(&(noise_secmem.env_checked), 1);
+    noise_secmem_store(&(noise_secmem.enabled), 0);
+    noise_secmem_unlock();
+}
+
+/**
+ * \brief Determine if new objects are allocated from the secure memory
+ * allocator.
+ *
+ * \return Returns 1 if the secure memory allocator is enabled, 0 if not.
+ *
+ * \sa noise_secmem_init(), noise_secmem_disable()
+ */
+int noise_secmem_is_enabled(void)
+{
+    int enabled;
+    noise_secmem_lock();
+    enabled = noise_secmem.enabled;
+    noise_secmem_unlock();
+    return enabled;
+}
+
+/**
+ * \brief Gets statistics about the secure memory allocator.
+ *
+ * \param stats Points to the structure to fill with the statistics.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a stats is NULL.
+ *
+ * All statistics are zero if the allocator has never been initialized.
+ *
+ * \sa noise_secmem_init()
+ */
+int noise_secmem_get_stats(NoiseSecMemStats *stats)
+{
+    if (!stats)
+        return NOISE_ERROR_INVALID_PARAM;
+    noise_secmem_lock();
+    *stats = noise_secmem.stats;
+    noise_secmem_unlock();
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Allocates a zeroed object from the secure memory allocator.
+ *
+ * \param size The size of the object in bytes.
+ *
+ * \return A pointer to the object, or NULL if the allocator is not enabled,
+ * \a size is too large for a slab, or the reserved range is full.  The
+ * caller should fall back to the heap when NULL is returned.
+ *
+ * \note Not part of the public API.
+ */
+void *noise_secmem_alloc(size_t size)
+{
+    NoiseSecMemClass *cls;
+    size_t index;
+    void *obj;
+    const char *env;
+
+    /* Check the environment the first time through */
+    if (!noise_secmem_load(&(noise_secmem.env_checked))) {
+        env = getenv("NOISE_SECMEM");
+        if (env && env[0] != '\0' && strcmp(env, "0") != 0)
+            noise_secmem_init(0, NOISE_SECMEM_DEFAULT);
+        noise_secmem_store(&(noise_secmem.env_checked), 1);
+    }
+    if (!noise_secmem_load(&(noise_secmem.enabled)) ||
+            !size || size > NOISE_SECMEM_MAX_OBJECT)
+        return 0;
+    index = noise_secmem_class(size);
+
+#if NOISE_SECMEM_TLS
+    /* Try the thread's own cache first, which needs no locking */
+    obj = noise_secmem_cache.head[index];
+    if (obj) {
+        noise_secmem_cache.head[index] = noise_secmem_link(obj);
+        --(noise_secmem_cache.count[index]);
+        noise_secmem_link(obj) = 0;
+        return obj;
+    }
+#endif
+
+    /* Take an object from the global free list or carve a new one */
+    noise_secmem_lock();
+    cls = &(noise_secmem.classes[index]);
+    obj = cls->free_list;
+    if (obj) {
+        cls->free_list = noise_secmem_link(obj);
+    } else if (cls->next < cls->end ||
+               noise_secmem_new_slab(cls, noise_secmem_class_sizes[index])) {
+        obj = cls->next;
+        cls->next += noise_secmem_class_sizes[index];
+    } else {
+        ++(noise_secmem.stats.fallbacks);
+    }
+    noise_secmem_unlock();
+
+    /* Freed objects were wiped except for the free list link */
+    if (obj)
+        noise_secmem_link(obj) = 0;
+    return obj;
+}
+
+/**
+ * \brief Wipes and frees an object if it belongs to the secure memory
+ * allocator.
+ *
+ * \param ptr Points to the object.
+ * \param size The size of the object that was passed to
+ * noise_secmem_alloc().
+ *
+ * \return Non-zero if the object was freed, or zero if \a ptr was not
+ * allocated from a slab and should be freed to the heap.
+ *
+ * \note Not part of the public API.
+ */
+int noise_secmem_free(void *ptr, size_t size)
+{
+    uint8_t *base;
+    size_t index;
+
+    /* The reserved range is never released, so checking the range
+       is enough to tell slab objects apart from heap objects */
+    base = noise_secmem_load(&(noise_secmem.base));
+    if (!base || (uint8_t *)ptr < base ||
+            (uint8_t *)ptr >= (base + noise_secmem.size))
+        return 0;
+    index = noise_secmem_class(size);
+
+    /* Only the bytes that the object could have used need to be wiped.
+       Everything past "size" is still zero from the last time around */
+    noise_clean(ptr, size);
+
+#if NOISE_SECMEM_TLS
+    /* Keep the object in this thread's cache if there is room */
+    if (!noise_secmem_cache.registered && noise_secmem_key_created) {
+        pthread_setspecific(noise_secmem_key, &noise_secmem_cache);
+        noise_secmem_cache.registered = 1;
+    }
+    if (noise_secmem_cache.count[index] < NOISE_SECMEM_CACHE_MAX) {
+        noise_secmem_link(ptr) = noise_secmem_cache.head[index];
+        noise_secmem_cache.head[index] = ptr;
+        ++(noise_secmem_cache.count[index]);
+        return 1;
+    }
+
+    /* The cache is full, so give it back and start again */
+    noise_secmem_release_list(index, noise_secmem_cache.head[index]);
+    noise_secmem_link(ptr) = 0;
+    noise_secmem_cache.head[index] = ptr;
+    noise_secmem_cache.count[index] = 1;
+#else
+    noise_secmem_lock();
+    noise_secmem_link(ptr) = noise_secmem.classes[index].free_list;
+    noise_secmem.classes[index].free_list = ptr;
+    noise_secmem_unlock();
+#endif
+    return 1;
+}
+
+/**@}*/
@@ -22,6 +22,7 @@
 
 #include "internal.h"
 #include <string.h>
+#include <stdlib.h>
 
 /**
  * \file signstate.h
@@ -66,20 +67,19 @@
  */
 int noise_signstate_new_by_id(NoiseSignState **state, int id)
 {
+    const NoiseBackend *backend;
+
     /* The "state" argument must be non-NULL */
     if (!state)
         return NOISE_ERROR_INVALID_PARAM;
 
-    /* Create the SignState object for the "id" */
+    /* Create the SignState object for the "id" using the implementation
+       that is currently selected in the backend registry */
     *state = 0;
-    switch (id) {
-    case NOISE_SIGN_ED25519:
-        *state = noise_ed25519_new();
-        break;
-
-    default:
+    backend = noise_backend_lookup(id);
+    if (!backend || !(backend->new_sign))
         return NOISE_ERROR_UNKNOWN_ID;
-    }
+    *state = (*(backend->new_sign))();
 
     /* Bail out if insufficient memory */
     if (!(*state))
@@ -247,6 +247,17 @@ int noise_signstate_has_public_key(const NoiseSignState *state)
         return 0;
 }
 
+/**
+ * \brief Tells the back end that the key in a SignState has changed.
+ *
+ * \param state The SignState object.
+ */
+static void noise_signstate_key_changed(NoiseSignState *state)
+{
+    if (state->key_changed)
+        (*(state->key_changed))(state);
+}
+
 /**
  * \brief Generates a new key pair within a SignState object.
  *
@@ -270,6 +281,7 @@ int noise_signstate_generate_keypair(NoiseSignState *state)
     /* Generate the new keypair */
     (*(state->generate_keypair))(state);
     state->key_type = NOISE_KEY_TYPE_KEYPAIR;
+    noise_signstate_key_changed(state);
     return NOISE_ERROR_NONE;
 }
 
@@ -320,6 +332,7 @@ int noise_signstate_set_keypair
     memcpy(state->private_key, private_key, state->private_key_len);
     memcpy(state->public_key, public_key, state->public_key_len);
     state->key_type = NOISE_KEY_TYPE_KEYPAIR;
+    noise_signstate_key_changed(state);
     return NOISE_ERROR_NONE;
 }
 
@@ -370,6 +383,7 @@ int noise_signstate_set_keypair_private
     /* Copy the private key into place */
     memcpy(state->private_key, private_key, state->private_key_len);
     state->key_type = NOISE_KEY_TYPE_KEYPAIR;
+    noise_signstate_key_changed(state);
     return NOISE_ERROR_NONE;
 }
 
@@ -459,6 +473,7 @@ int noise_signstate_set_public_key
     memcpy(state->public_key, public_key, public_key_len);
     memset(state->private_key, 0, state->private_key_len);
     state->key_type = NOISE_KEY_TYPE_PUBLIC;
+    noise_signstate_key_changed(state);
     return NOISE_ERROR_NONE;
 }
 
@@ -516,6 +531,7 @@ int noise_signstate_clear_key(NoiseSignState *state)
 
     /* There is no key in the object now */
     state->key_type = NOISE_KEY_TYPE_NO_KEY;
+    noise_signstate_key_changed(state);
     return NOISE_ERROR_NONE;
 }
 
@@ -595,6 +611,99 @@ int noise_signstate_verify
     return (*(state->verify))(state, message, message_len, signature);
 }
 
+/**
+ * \brief Verifies several digital signatures in a single batch.
+ *
+ * \param states Points to an array of SignState objects containing the
+ * public keys to verify with, which must all use the same algorithm.
+ * \param messages Points to an array of messages, one for each state.
+ * \param message_lens Points to an array of message lengths in bytes.
+ * \param signatures Points to an array of signatures, one for each state.
+ * \param signature_len The length of each signature in bytes.
+ * \param count The number of signatures to verify.
+ * \param valid Points to an array that will be set to 1 for each
+ * signature that is valid and 0 for each signature that is not.
+ * This parameter can be NULL if the caller only needs to know if
+ * all signatures were valid.
+ *
+ * \return NOISE_ERROR_NONE if all of the signatures are valid.
+ * \return NOISE_ERROR_INVALID_PARAM if \a states, \a messages,
+ * \a message_lens, or \a signatures is NULL, one of the elements is NULL,
+ * or the states use different signature algorithms.
+ * \return NOISE_ERROR_INVALID_LENGTH if \a signature_len is not correct
+ * for the signature algorithm.
+ * \return NOISE_ERROR_INVALID_PUBLIC_KEY if one of the states does not
+ * contain a public key.
+ * \return NOISE_ERROR_INVALID_SIGNATURE if at least one signature is
+ * not valid for its message.
+ * \return NOISE_ERROR_NO_MEMORY if \a valid is NULL and there is
+ * insufficient memory to allocate a temporary result array.
+ *
+ * This is equivalent to calling noise_signstate_verify() on each state in
+ * turn.  If the back end has a batch implementation of the signature
+ * algorithm, then the signatures will be checked together, which is
+ * considerably faster than checking them one at a time when most of
+ * the signatures are expected to be valid.
+ *
+ * \sa noise_signstate_verify()
+ */
+int noise_signstate_verify_batch
+    (const NoiseSignState **states, const uint8_t **messages,
+     const size_t *message_lens, const uint8_t **signatures,
+     size_t signature_len, size_t count, int *valid)
+{
+    int *results = valid;
+    size_t index;
+    int err;
+
+    /* Validate the parameters */
+    if (!states || !messages || !message_lens || !signatures)
+        return NOISE_ERROR_INVALID_PARAM;
+    for (index = 0; index < count; ++index) {
+        if (!states[index] || !messages[index] || !signatures[index] ||
+                states[index]->sign_id != states[0]->sign_id)
+            return NOISE_ERROR_INVALID_PARAM;
+    }
+    if (!count)
+        return NOISE_ERROR_NONE;
+    if (signature_len != states[0]->signature_len)
+        return NOISE_ERROR_INVALID_LENGTH;
+    for (index = 0; index < count; ++index) {
+        if (states[index]->key_type == NOISE_KEY_TYPE_NO_KEY)
+            return NOISE_ERROR_INVALID_PUBLIC_KEY;
+    }
+
+    /* Verify the signatures one at a time if there is no batch support */
+    if (!(states[0]->verify_batch)) {
+        err = NOISE_ERROR_NONE;
+        for (index = 0; index < count; ++index) {
+            if ((*(states[index]->verify))
+                    (states[index], messages[index], message_lens[index],
+                     signatures[index]) == NOISE_ERROR_NONE) {
+                if (valid)
+                    valid[index] = 1;
+            } else {
+                if (valid)
+                    valid[index] = 0;
+                err = NOISE_ERROR_INVALID_SIGNATURE;
+            }
+        }
+        return err;
+    }
+
+    /* Verify the signatures as a batch */
+    if (!results) {
+        results = (int *)malloc(count * sizeof(int));
+        if (!results)
+            return NOISE_ERROR_NO_MEMORY;
+    }
+    err = (*(states[0]->verify_batch))
+        (states, messages, message_lens, signatures, count, results);
+    if (results != valid)
+        free(results);
+    return err;
+}
+
 /**
  * \brief Copies the keys from one SignState object to another.
  *
@@ -619,6 +728,7 @@ int noise_signstate_copy(NoiseSignState *state, const NoiseSignState *from)
         state->key_type = from->key_type;
         memcpy(state->private_key, from->private_key, from->private_key_len);
         memcpy(state->public_key, from->public_key, from->public_key_len);
+        noise_signstate_key_changed(state);
     }
     return NOISE_ERROR_NONE;
 }
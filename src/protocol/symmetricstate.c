@@ -528,6 +528,7 @@ int noise_symmetricstate_split
     uint8_t temp_k2[NOISE_MAX_HASHLEN];
     size_t hash_len;
     size_t key_len;
+    int err;
 
     /* Validate the parameters */
     if (!state)
@@ -560,36 +561,239 @@ int noise_symmetricstate_split
              temp_k1, key_len, temp_k2, key_len);
     }
 
+    /* Install the keys into the new CipherState objects */
+    err = noise_symmetricstate_split_keys
+        (state, c1, c2, temp_k1, temp_k2, key_len);
+    noise_clean(temp_k1, sizeof(temp_k1));
+    noise_clean(temp_k2, sizeof(temp_k2));
+    return err;
+}
+
+/**
+ * \brief Splits the transport CipherState objects out of a SymmetricState
+ * once the cipher keys have been derived.
+ *
+ * \param state The SymmetricState object.
+ * \param c1 Points to the variable where to place the pointer to the
+ * first CipherState object.  This can be NULL.
+ * \param c2 Points to the variable where to place the pointer to the
+ * second CipherState object.  This can be NULL.
+ * \param k1 The key for \a c1.
+ * \param k2 The key for \a c2.
+ * \param key_len The length of the keys in bytes.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory to create
+ * the new CipherState objects.
+ *
+ * This is the second half of noise_symmetricstate_split(), after HKDF.
+ * It is separate so that batches of handshakes can derive their keys
+ * with noise_hashstate_hkdf_multi().  The caller is responsible for
+ * validating the parameters and for cleaning up \a k1 and \a k2.
+ */
+int noise_symmetricstate_split_keys
+    (NoiseSymmetricState *state, NoiseCipherState **c1, NoiseCipherState **c2,
+     const uint8_t *k1, const uint8_t *k2, size_t key_len)
+{
     /* If we only need c2, then re-initialize the key in the internal
        cipher and copy it to c2 */
     if (!c1 && c2) {
-        noise_cipherstate_init_key(state->cipher, temp_k2, key_len);
+        noise_cipherstate_init_key(state->cipher, k2, key_len);
         *c2 = state->cipher;
         state->cipher = 0;
-        noise_clean(temp_k1, sizeof(temp_k1));
-        noise_clean(temp_k2, sizeof(temp_k2));
         return NOISE_ERROR_NONE;
     }
 
     /* Split a copy out of the cipher and give it the second key.
        We don't need to do this if the second CipherSuite is not required */
     if (c2) {
-        *c2 = (*(state->cipher->create))();
-        if (!(*c2)) {
-            noise_clean(temp_k1, sizeof(temp_k1));
-            noise_clean(temp_k2, sizeof(temp_k2));
+        *c2 = noise_cipher_create(state->cipher);
+        if (!(*c2))
             return NOISE_ERROR_NO_MEMORY;
-        }
-        noise_cipherstate_init_key(*c2, temp_k2, key_len);
+        noise_cipherstate_init_key(*c2, k2, key_len);
     }
 
     /* Re-initialize the key in the internal cipher and copy it to c1 */
-    noise_cipherstate_init_key(state->cipher, temp_k1, key_len);
+    noise_cipherstate_init_key(state->cipher, k1, key_len);
     *c1 = state->cipher;
     state->cipher = 0;
-    noise_clean(temp_k1, sizeof(temp_k1));
-    noise_clean(temp_k2, sizeof(temp_k2));
     return NOISE_ERROR_NONE;
 }
 
+/**
+ * \brief Writes the protocol, chaining key, handshake hash, and cipher
+ * of a SymmetricState to the body of an exported object.
+ *
+ * \param state The SymmetricState object.
+ * \param body The body buffer.
+ *
+ * \note Not part of the public API.
+ */
+void noise_symmetricstate_write_export
+    (const NoiseSymmetricState *state, NoiseBuffer *body)
+{
+    size_t hash_len = noise_hashstate_get_hash_length(state->hash);
+    noise_export_put_uint(body, (uint64_t)(state->id.prefix_id), 2);
+    noise_export_put_uint(body, (uint64_t)(state->id.pattern_id), 2);
+    noise_export_put_uint(body, (uint64_t)(state->id.dh_id), 2);
+    noise_export_put_uint(body, (uint64_t)(state->id.hybrid_id), 2);
+    noise_export_put_uint(body, (uint64_t)(state->id.cipher_id), 2);
+    noise_export_put_uint(body, (uint64_t)(state->id.hash_id), 2);
+    noise_export_put_bytes(body, state->ck, hash_len);
+    noise_export_put_bytes(body, state->h, hash_len);
+    noise_export_put_uint(body, state->cipher != 0, 1);
+    if (state->cipher)
+        noise_cipherstate_write_export(state->cipher, body);
+}
+
+/**
+ * \brief Reads a SymmetricState from the body of an exported object.
+ *
+ * \param state Points to the variable where to store the pointer to
+ * the new SymmetricState object.
+ * \param body The body buffer.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_FORMAT if the body is malformed.
+ * \return NOISE_ERROR_UNKNOWN_ID if the protocol uses an algorithm that
+ * is not supported by this build.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory.
+ *
+ * \note Not part of the public API.
+ */
+int noise_symmetricstate_read_export
+    (NoiseSymmetricState **state, NoiseBuffer *body)
+{
+    NoiseProtocolId id;
+    size_t hash_len;
+    int has_cipher;
+    int err;
+
+    /* Create a SymmetricState for the exported protocol */
+    id.prefix_id = (int)noise_export_get_uint(body, 2);
+    id.pattern_id = (int)noise_export_get_uint(body, 2);
+    id.dh_id = (int)noise_export_get_uint(body, 2);
+    id.hybrid_id = (int)noise_export_get_uint(body, 2);
+    id.cipher_id = (int)noise_export_get_uint(body, 2);
+    id.hash_id = (int)noise_export_get_uint(body, 2);
+    if (body->size > body->max_size)
+        return NOISE_ERROR_INVALID_FORMAT;
+    err = noise_symmetricstate_new_by_id(state, &id);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+
+    /* Restore the chaining key, handshake hash, and cipher */
+    hash_len = noise_hashstate_get_hash_length((*state)->hash);
+    noise_export_get_bytes(body, (*state)->ck, hash_len);
+    noise_export_get_bytes(body, (*state)->h, hash_len);
+    has_cipher = (int)noise_export_get_uint(body, 1);
+    if (body->size > body->max_size || has_cipher > 1) {
+        err = NOISE_ERROR_INVALID_FORMAT;
+    } else if (has_cipher) {
+        err = noise_cipherstate_read_export((*state)->cipher, body);
+    } else {
+        /* The exported state had already been split */
+        noise_cipherstate_free((*state)->cipher);
+        (*state)->cipher = 0;
+    }
+    if (err != NOISE_ERROR_NONE) {
+        noise_symmetricstate_free(*state);
+        *state = 0;
+    }
+    return err;
+}
+
+/**
+ * \brief Exports a SymmetricState in an encrypted and authenticated blob.
+ *
+ * \param state The SymmetricState object.
+ * \param wrap_key Points to the key to wrap the blob with.
+ * \param wrap_key_len The length of \a wrap_key, which must be
+ * NOISE_EXPORT_KEY_LEN.
+ * \param blob The buffer to write the blob to.  NOISE_MAX_EXPORT_LEN
+ * bytes are always sufficient.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a state, \a wrap_key, or
+ * \a blob is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if \a wrap_key_len is incorrect or
+ * \a blob is not large enough.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory.
+ *
+ * The blob contains the protocol identifier, the chaining key, the
+ * handshake hash, and the key and nonce of the internal CipherState.
+ *
+ * \sa noise_symmetricstate_import(), noise_cipherstate_export()
+ */
+int noise_symmetricstate_export
+    (const NoiseSymmetricState *state, const uint8_t *wrap_key,
+     size_t wrap_key_len, NoiseBuffer *blob)
+{
+    uint8_t data[NOISE_MAX_EXPORT_LEN];
+    NoiseBuffer body;
+    int err;
+
+    if (!state)
+        return NOISE_ERROR_INVALID_PARAM;
+    noise_buffer_set_output(body, data, sizeof(data));
+    noise_symmetricstate_write_export(state, &body);
+    err = noise_export_seal
+        (NOISE_EXPORT_SYMMETRICSTATE, wrap_key, wrap_key_len, &body, blob);
+    noise_clean(data, sizeof(data));
+    return err;
+}
+
+/**
+ * \brief Imports a SymmetricState from an encrypted and authenticated blob.
+ *
+ * \param state Points to the variable where to store the pointer to
+ * the new SymmetricState object.
+ * \param wrap_key Points to the key that the blob was wrapped with.
+ * \param wrap_key_len The length of \a wrap_key, which must be
+ * NOISE_EXPORT_KEY_LEN.
+ * \param blob The blob that was created by noise_symmetricstate_export().
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a state, \a wrap_key, or
+ * \a blob is NULL.
+ * \return NOISE_ERROR_INVALID_LENGTH if \a wrap_key_len is incorrect.
+ * \return NOISE_ERROR_INVALID_FORMAT if \a blob is not an exported
+ * SymmetricState.
+ * \return NOISE_ERROR_MAC_FAILURE if \a blob was not wrapped with
+ * \a wrap_key or it has been modified.
+ * \return NOISE_ERROR_UNKNOWN_ID if the protocol uses an algorithm that
+ * is not supported by this build.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory.
+ *
+ * \sa noise_symmetricstate_export(), noise_cipherstate_import()
+ */
+int noise_symmetricstate_import
+    (NoiseSymmetricState **state, const uint8_t *wrap_key,
+     size_t wrap_key_len, const NoiseBuffer *blob)
+{
+    uint8_t data[NOISE_MAX_EXPORT_LEN];
+    NoiseBuffer body;
+    int err;
+
+    /* Validate the parameters */
+    if (!state)
+        return NOISE_ERROR_INVALID_PARAM;
+    *state = 0;
+
+    /* Unwrap the blob and parse the SymmetricState out of it */
+    noise_buffer_set_output(body, data, sizeof(data));
+    err = noise_export_open
+        (NOISE_EXPORT_SYMMETRICSTATE, wrap_key, wrap_key_len, blob, &body);
+    if (err == NOISE_ERROR_NONE) {
+        err = noise_symmetricstate_read_export(state, &body);
+        if (err == NOISE_ERROR_NONE && body.size != body.max_size) {
+            noise_symmetricstate_free(*state);
+            *state = 0;
+            err = NOISE_ERROR_INVALID_FORMAT;
+        }
+    }
+    noise_clean(data, sizeof(data));
+    return err;
+}
+
 /**@}*/
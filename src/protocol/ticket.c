@@ -0,0 +1,452 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * \file ticket.h
+ * \brief Resumption ticket interface
+ */
+
+/**
+ * \file ticket.c
+ * \brief Resumption ticket implementation
+ */
+
+/**
+ * \defgroup ticket Resumption Ticket API
+ *
+ * A full handshake with static keys costs several DH operations per side.
+ * When a client reconnects to a server that it recently talked to, the
+ * parties can instead run a "NoisePSK_NN" handshake that is keyed with a
+ * secret from the earlier session.  That skips the static DH operations;
+ * the ephemeral DH is still performed so that the resumed session keeps
+ * forward secrecy.
+ *
+ * At the end of the full handshake, both parties call
+ * noise_handshakestate_get_resumption_secret().  The responder passes
+ * its HandshakeState to noise_ticketissuer_issue() to wrap the secret in
+ * a ticket that only the issuer can open, and sends the ticket to the
+ * initiator over the new session.  The responder does not need to keep
+ * any per-client state.
+ *
+ * To resume, the initiator sends the ticket to the responder in the clear
+ * before the first handshake message, using the application's framing,
+ * and sets its copy of the secret as the pre-shared key of a new
+ * "NoisePSK_NN" handshake.  The responder passes the ticket to
+ * noise_ticketissuer_redeem(), which unwraps the secret and sets it as
+ * the pre-shared key of the responder's HandshakeState.  If the ticket
+ * is rejected, the responder should close the connection and the
+ * initiator should fall back to a full handshake.
+ *
+ * The issuer encrypts tickets with a random ChaChaPoly key that is
+ * replaced by noise_ticketissuer_rotate().  Tickets from the current and
+ * previous keys are accepted, so a ticket lives for between one and two
+ * rotation periods.  Each ticket can only be redeemed once, which
+ * prevents an attacker from replaying a captured ticket and first
+ * handshake message.  Tickets do not survive a restart of the server.
+ *
+ * Resumption does not authenticate the parties beyond proving that they
+ * share a secret from the earlier session.  Applications that need the
+ * identities should store them alongside the secret.
+ */
+/**@{*/
+
+/**
+ * \typedef NoiseTicketIssuer
+ * \brief Opaque object that issues and redeems resumption tickets.
+ */
+
+/** @cond */
+
+/* Format of a ticket:
+ *
+ *      'N' 'T' version 0
+ *      key_id (4 bytes, big-endian)
+ *      nonce (8 bytes, big-endian)
+ *      encrypted secret (32 bytes)
+ *      MAC (16 bytes)
+ *
+ * The first 16 bytes are the associated data for the encryption.
+ */
+#define NOISE_TICKET_VERSION        1
+#define NOISE_TICKET_HEADER_LEN     16
+#define NOISE_TICKET_MAC_LEN        16
+#define NOISE_TICKET_LEN \
+    (NOISE_TICKET_HEADER_LEN + NOISE_RESUMPTION_SECRET_LEN + \
+     NOISE_TICKET_MAC_LEN)
+
+/* Initial size of the bitmap of redeemed tickets, in bytes */
+#define NOISE_TICKET_INITIAL_BITMAP 256
+
+/** @endcond */
+
+/**
+ * \brief Writes a big-endian integer into a ticket.
+ *
+ * \param data Points to the position in the ticket to write to.
+ * \param value The value to write.
+ * \param len The number of bytes to write.
+ */
+static void noise_ticket_put_uint(uint8_t *data, uint64_t value, size_t len)
+{
+    while (len > 0) {
+        --len;
+        data[len] = (uint8_t)value;
+        value >>= 8;
+    }
+}
+
+/**
+ * \brief Reads a big-endian integer from a ticket.
+ *
+ * \param data Points to the position in the ticket to read from.
+ * \param len The number of bytes to read.
+ *
+ * \return The value that was read.
+ */
+static uint64_t noise_ticket_get_uint(const uint8_t *data, size_t len)
+{
+    uint64_t value = 0;
+    while (len > 0) {
+        value = (value << 8) | *data++;
+        --len;
+    }
+    return value;
+}
+
+/**
+ * \brief Creates a new ticket key with a random ChaChaPoly key.
+ *
+ * \param key The ticket key to initialize.
+ * \param key_id The identifier for the key.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory.
+ */
+static int noise_ticketkey_init(NoiseTicketKey *key, uint32_t key_id)
+{
+    uint8_t k[32];
+    int err;
+    key->key_id = key_id;
+    key->issued = 0;
+    key->redeemed = 0;
+    key->redeemed_size = 0;
+    err = noise_cipherstate_new_by_id(&(key->cipher), NOISE_CIPHER_CHACHAPOLY);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    noise_rand_bytes(k, sizeof(k));
+    err = noise_cipherstate_init_key(key->cipher, k, sizeof(k));
+    noise_clean(k, sizeof(k));
+    return err;
+}
+
+/**
+ * \brief Destroys a ticket key.
+ *
+ * \param key The ticket key to destroy, which may be empty.
+ */
+static void noise_ticketkey_destroy(NoiseTicketKey *key)
+{
+    if (key->cipher)
+        noise_cipherstate_free(key->cipher);
+    free(key->redeemed);
+    memset(key, 0, sizeof(NoiseTicketKey));
+}
+
+/**
+ * \brief Creates a new TicketIssuer object with a random ticket key.
+ *
+ * \param issuer Points to the variable where to store the pointer to
+ * the new TicketIssuer object.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a issuer is NULL.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory to
+ * allocate the new TicketIssuer object.
+ *
+ * \sa noise_ticketissuer_free(), noise_ticketissuer_rotate()
+ */
+int noise_ticketissuer_new(NoiseTicketIssuer **issuer)
+{
+    uint32_t key_id;
+    int err;
+
+    /* Validate the parameter */
+    if (!issuer)
+        return NOISE_ERROR_INVALID_PARAM;
+
+    /* Create the issuer and its first key.  The key identifiers start at
+       a random point so that tickets from an earlier run of the server
+       are unlikely to match a key that is in use now */
+    *issuer = noise_new(NoiseTicketIssuer);
+    if (!(*issuer))
+        return NOISE_ERROR_NO_MEMORY;
+    noise_rand_bytes(&key_id, sizeof(key_id));
+    err = noise_ticketkey_init(&((*issuer)->current), key_id);
+    if (err != NOISE_ERROR_NONE) {
+        noise_ticketissuer_free(*issuer);
+        *issuer = 0;
+    }
+    return err;
+}
+
+/**
+ * \brief Frees a TicketIssuer object after destroying all sensitive material.
+ *
+ * \param issuer The TicketIssuer object to free.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a issuer is NULL.
+ *
+ * All tickets that were issued by \a issuer become unusable.
+ *
+ * \sa noise_ticketissuer_new()
+ */
+int noise_ticketissuer_free(NoiseTicketIssuer *issuer)
+{
+    if (!issuer)
+        return NOISE_ERROR_INVALID_PARAM;
+    noise_ticketkey_destroy(&(issuer->current));
+    noise_ticketkey_destroy(&(issuer->previous));
+    noise_free(issuer, issuer->size);
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Replaces the key that is used to issue new tickets.
+ *
+ * \param issuer The TicketIssuer object.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a issuer is NULL.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory to
+ * create the new key.  The issuer is unchanged in this case.
+ *
+ * The current key becomes the previous key, which can still redeem the
+ * tickets that it issued.  Tickets from the old previous key expire.
+ * Applications normally call this on a timer; e.g. once an hour for
+ * tickets that are valid for one to two hours.
+ *
+ * Rotation also bounds the memory that is used to remember which tickets
+ * have been redeemed, which is one bit for each ticket issued.
+ */
+int noise_ticketissuer_rotate(NoiseTicketIssuer *issuer)
+{
+    NoiseTicketKey key;
+    int err;
+    if (!issuer)
+        return NOISE_ERROR_INVALID_PARAM;
+    err = noise_ticketkey_init(&key, issuer->current.key_id + 1);
+    if (err != NOISE_ERROR_NONE) {
+        noise_ticketkey_destroy(&key);
+        return err;
+    }
+    noise_ticketkey_destroy(&(issuer->previous));
+    issuer->previous = issuer->current;
+    issuer->current = key;
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Issues a resumption ticket for a completed handshake.
+ *
+ * \param issuer The TicketIssuer object.
+ * \param state The HandshakeState for the completed handshake.
+ * \param ticket The buffer to write the ticket to.  The ticket is
+ * written to the start of the buffer and its size is set to the
+ * length of the ticket.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a issuer, \a state, or
+ * \a ticket is NULL.
+ * \return NOISE_ERROR_INVALID_STATE if the handshake has not
+ * successfully completed yet.
+ * \return NOISE_ERROR_INVALID_LENGTH if the \a ticket buffer is too
+ * small.  NOISE_MAX_TICKET_LEN bytes is always sufficient.
+ * \return NOISE_ERROR_INVALID_NONCE if the current key has issued the
+ * maximum number of tickets.  Call noise_ticketissuer_rotate() in
+ * this case.
+ * \return NOISE_ERROR_NO_MEMORY if there is insufficient memory to
+ * track the new ticket.
+ *
+ * The ticket contains the secret from
+ * noise_handshakestate_get_resumption_secret(), encrypted under the
+ * issuer's current key.  The ticket does not need to be kept secret.
+ *
+ * \sa noise_ticketissuer_redeem()
+ */
+int noise_ticketissuer_issue
+    (NoiseTicketIssuer *issuer, const NoiseHandshakeState *state,
+     NoiseBuffer *ticket)
+{
+    NoiseTicketKey *key;
+    NoiseBuffer buffer;
+    uint8_t *data;
+    int err;
+
+    /* Validate the parameters */
+    if (!issuer || !state || !ticket || !(ticket->data))
+        return NOISE_ERROR_INVALID_PARAM;
+    if (ticket->max_size < NOISE_TICKET_LEN)
+        return NOISE_ERROR_INVALID_LENGTH;
+    key = &(issuer->current);
+    if (key->issued >= 0xFFFFFFFFFFFFFFFEULL)
+        return NOISE_ERROR_INVALID_NONCE;
+
+    /* Make sure that there is room in the bitmap for the new ticket */
+    if ((key->issued / 8) >= key->redeemed_size) {
+        size_t size = key->redeemed_size ? key->redeemed_size * 2
+                                         : NOISE_TICKET_INITIAL_BITMAP;
+        uint8_t *redeemed = (uint8_t *)realloc(key->redeemed, size);
+        if (!redeemed)
+            return NOISE_ERROR_NO_MEMORY;
+        memset(redeemed + key->redeemed_size, 0, size - key->redeemed_size);
+        key->redeemed = redeemed;
+        key->redeemed_size = size;
+    }
+
+    /* Format the header */
+    data = ticket->data;
+    data[0] = 'N';
+    data[1] = 'T';
+    data[2] = NOISE_TICKET_VERSION;
+    data[3] = 0;
+    noise_ticket_put_uint(data + 4, key->key_id, 4);
+    noise_ticket_put_uint(data + 8, key->issued, 8);
+
+    /* Derive the secret and encrypt it, using the ticket number as
+       the nonce so that it is never reused with this key */
+    err = noise_handshakestate_get_resumption_secret
+        (state, data + NOISE_TICKET_HEADER_LEN, NOISE_RESUMPTION_SECRET_LEN);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    noise_buffer_set_inout
+        (buffer, data + NOISE_TICKET_HEADER_LEN, NOISE_RESUMPTION_SECRET_LEN,
+         NOISE_RESUMPTION_SECRET_LEN + NOISE_TICKET_MAC_LEN);
+    key->cipher->n = key->issued;
+    err = noise_cipherstate_encrypt_with_ad
+        (key->cipher, data, NOISE_TICKET_HEADER_LEN, &buffer);
+    if (err != NOISE_ERROR_NONE) {
+        noise_clean(data, NOISE_TICKET_LEN);
+        return err;
+    }
+    ++(key->issued);
+    ticket->size = NOISE_TICKET_LEN;
+    return NOISE_ERROR_NONE;
+}
+
+/**
+ * \brief Redeems a resumption ticket and sets the pre-shared key for a
+ * resumed handshake.
+ *
+ * \param issuer The TicketIssuer object that issued the ticket.
+ * \param ticket The ticket that was received from the initiator.
+ * \param state The responder's HandshakeState for the resumed handshake,
+ * which must be for a protocol that uses a pre-shared key and must not
+ * have been started yet.
+ *
+ * \return NOISE_ERROR_NONE on success.
+ * \return NOISE_ERROR_INVALID_PARAM if \a issuer, \a ticket, or \a state
+ * is NULL.
+ * \return NOISE_ERROR_INVALID_FORMAT if \a ticket is not formatted
+ * correctly.
+ * \return NOISE_ERROR_TICKET_EXPIRED if the key that issued the ticket
+ * has been rotated out.
+ * \return NOISE_ERROR_MAC_FAILURE if the ticket has been tampered with.
+ * \return NOISE_ERROR_INVALID_NONCE if the ticket has already been redeemed.
+ * \return NOISE_ERROR_NOT_APPLICABLE if the protocol for \a state does
+ * not use a pre-shared key.
+ * \return NOISE_ERROR_INVALID_STATE if the handshake has already started.
+ *
+ * The ticket is only marked as redeemed if the pre-shared key was set
+ * successfully.  The rejection checks are ordered so that an attacker
+ * without a valid ticket cannot cause a real ticket to be marked.
+ *
+ * \sa noise_ticketissuer_issue()
+ */
+int noise_ticketissuer_redeem
+    (NoiseTicketIssuer *issuer, const NoiseBuffer *ticket,
+     NoiseHandshakeState *state)
+{
+    uint8_t data[NOISE_TICKET_LEN];
+    NoiseTicketKey *key;
+    NoiseBuffer buffer;
+    uint32_t key_id;
+    uint64_t nonce;
+    int err;
+
+    /* Validate the parameters and the ticket header */
+    if (!issuer || !ticket || !(ticket->data) || !state)
+        return NOISE_ERROR_INVALID_PARAM;
+    if (ticket->size != NOISE_TICKET_LEN)
+        return NOISE_ERROR_INVALID_FORMAT;
+    memcpy(data, ticket->data, NOISE_TICKET_LEN);
+    if (data[0] != 'N' || data[1] != 'T' ||
+            data[2] != NOISE_TICKET_VERSION || data[3] != 0)
+        return NOISE_ERROR_INVALID_FORMAT;
+
+    /* Find the key that issued the ticket */
+    key_id = (uint32_t)noise_ticket_get_uint(data + 4, 4);
+    if (key_id == issuer->current.key_id)
+        key = &(issuer->current);
+    else if (issuer->previous.cipher && key_id == issuer->previous.key_id)
+        key = &(issuer->previous);
+    else
+        return NOISE_ERROR_TICKET_EXPIRED;
+
+    /* A nonce that was never issued cannot decrypt correctly, but
+       checking it first avoids a needless decryption */
+    nonce = noise_ticket_get_uint(data + 8, 8);
+    if (nonce >= key->issued)
+        return NOISE_ERROR_MAC_FAILURE;
+
+    /* Decrypt the secret, which also authenticates the header */
+    noise_buffer_set_input
+        (buffer, data + NOISE_TICKET_HEADER_LEN,
+         NOISE_RESUMPTION_SECRET_LEN + NOISE_TICKET_MAC_LEN);
+    key->cipher->n = nonce;
+    err = noise_cipherstate_decrypt_with_ad
+        (key->cipher, data, NOISE_TICKET_HEADER_LEN, &buffer);
+    if (err != NOISE_ERROR_NONE) {
+        noise_clean(data, sizeof(data));
+        return err;
+    }
+
+    /* Reject the ticket if it has already been redeemed */
+    if (key->redeemed[nonce / 8] & (1 << (nonce % 8))) {
+        noise_clean(data, sizeof(data));
+        return NOISE_ERROR_INVALID_NONCE;
+    }
+
+    /* Set the pre-shared key and then mark the ticket as redeemed */
+    err = noise_handshakestate_set_pre_shared_key
+        (state, data + NOISE_TICKET_HEADER_LEN, NOISE_RESUMPTION_SECRET_LEN);
+    if (err == NOISE_ERROR_NONE)
+        key->redeemed[nonce / 8] |= (uint8_t)(1 << (nonce % 8));
+    noise_clean(data, sizeof(data));
+    return err;
+}
+
+/**@}*/
@@ -23,6 +23,7 @@
 #include "internal.h"
 #include "crypto/sha2/sha256.h"
 #include <stdlib.h>
+#include <string.h>
 
 /**
  * \file util.h
@@ -84,7 +85,9 @@
  */
 void *noise_new_object(size_t size)
 {
-    void *ptr = calloc(1, size);
+    void *ptr = noise_secmem_alloc(size);
+    if (!ptr)
+        ptr = calloc(1, size);
     if (!ptr || size < sizeof(size_t))
         return ptr;
     *((size_t *)ptr) = size;
@@ -101,7 +104,7 @@ void *noise_new_object(size_t size)
  */
 void noise_free(void *ptr, size_t size)
 {
-    if (ptr) {
+    if (ptr && !noise_secmem_free(ptr, size)) {
         noise_clean(ptr, size);
         free(ptr);
     }
@@ -116,14 +119,24 @@ void noise_free(void *ptr, size_t size)
  * This function tries to perform the operation in a way that should
  * work around compilers and linkers that optimize away memset() calls
  * for memory that the compiler thinks is no longer live.
+ *
+ * With GCC and clang, the memory is cleared with memset() followed by
+ * a compiler barrier that claims to read the memory, which lets the
+ * compiler use word and vector-sized stores.  Other compilers fall back
+ * to storing bytes through a volatile pointer.
  */
 void noise_clean(void *data, size_t size)
 {
+#if defined(__GNUC__) || defined(__clang__)
+    memset(data, 0, size);
+    __asm__ __volatile__ ("" : : "r"(data) : "memory");
+#else
     volatile uint8_t *d = (volatile uint8_t *)data;
     while (size > 0) {
         *d++ = 0;
         --size;
     }
+#endif
 }
 
 /**
@@ -27,12 +27,46 @@
 
     This allows different implementations of the same algorithms to be
     compared to determine if they are faster or slower than others.
+
+    The handshake tests run complete in-memory handshakes between an
+    initiator and a responder for every supported protocol name and
+    report handshakes per second and the average time per message.
+    The time is also broken down into DH, hashing, and allocation costs.
+    The breakdown is an estimate that multiplies the operation counts
+    for the handshake pattern by the cost of each primitive as measured
+    in the same run.  Whatever is left over is reported as "other".
+
+    The message size sweep encrypts transport messages from 16 bytes up
+    to the maximum Noise payload size and reports cycles/byte from the
+    CPU's time stamp counter where one is available.  The scaling tests
+    run the handshake and transport benchmarks on 1..N threads at once
+    and report the combined operations per second using wall clock time.
+
+    The session tests allocate a large number of idle transport sessions,
+    either as a pair of CipherState objects or as a CompactSession, and
+    report the memory that each session holds and the time to encrypt a
+    message on a session chosen at random.
+
+    The protobuf tests serialize and parse a typical certificate and an
+    encrypted private key, comparing the two-pass reverse writer with the
+    single-pass forward encoder.  They also time lookups in key stores and
+    revocation sets with 100,000 entries.
 */
 
 #include <noise/protocol.h>
+#include <noise/keys.h>
+#include "internal.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <getopt.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#if defined(HAVE_LIBPTHREAD)
+#include <pthread.h>
+#endif
 #include "md5.h"
 #if defined(__WIN32__) || defined(WIN32)
 #include <windows.h>
@@ -43,11 +77,51 @@
 #define MB_COUNT        200
 #define DH_COUNT        1000
 #define PQ_DH_COUNT     2000
+#define PROTOBUF_COUNT  100000
+#define MAX_MESSAGE_LEN 4096
+#define MAX_MAC_LEN     16
+#define MIN_SWEEP_LEN   16
+#define MAX_SWEEP_LEN   65536
+#define SWEEP_BATCH     16
+#define MAX_THREADS     256
+#define SCALING_MESSAGE_LEN 256
+#define SCALING_PROTOCOL "Noise_XX_25519_ChaChaPoly_BLAKE2s"
+#define SESSION_MESSAGE_LEN 64
 
 typedef uint64_t timestamp_t;
 
 static double units;
 
+/* Command-line options */
+static int run_primitives = 1;
+static int run_handshakes = 1;
+static int run_sweep = 0;
+static int run_protobufs = 0;
+static int max_threads = 0;
+static long session_count = 0;
+static int json_output = 0;
+static const char *filter = 0;
+static double min_time = 0.05;
+
+#define short_options "phsPT:S:jf:t:m"
+
+static struct option const long_options[] = {
+    {"primitives",              no_argument,            NULL,       'p'},
+    {"handshakes",              no_argument,            NULL,       'h'},
+    {"sweep",                   no_argument,            NULL,       's'},
+    {"protobufs",               no_argument,            NULL,       'P'},
+    {"threads",                 required_argument,      NULL,       'T'},
+    {"sessions",                required_argument,      NULL,       'S'},
+    {"json",                    no_argument,            NULL,       'j'},
+    {"filter",                  required_argument,      NULL,       'f'},
+    {"time",                    required_argument,      NULL,       't'},
+    {"secure-memory",           no_argument,            NULL,       'm'},
+    {NULL,                      0,                      NULL,        0 }
+};
+
+/* Number of JSON objects that have been output so far */
+static int json_count = 0;
+
 #if defined(__WIN32__) || defined(WIN32)
 
 static timestamp_t current_timestamp(void)
@@ -60,6 +134,8 @@ static double elapsed_to_seconds(timestamp_t start, timestamp_t end)
     return (end - start) / 1000.0;
 }
 
+#define current_wall_timestamp() current_timestamp()
+
 #else
 
 static timestamp_t current_timestamp(void)
@@ -69,6 +145,15 @@ static timestamp_t current_timestamp(void)
     return ((uint64_t)(ts.tv_sec)) * 1000000000ULL + ts.tv_nsec;
 }
 
+/* Wall clock time, for multi-threaded tests where the process CPU time
+   would add up the time spent in all threads */
+static timestamp_t current_wall_timestamp(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)(ts.tv_sec)) * 1000000000ULL + ts.tv_nsec;
+}
+
 static double elapsed_to_seconds(timestamp_t start, timestamp_t end)
 {
     return (end - start) / 1000000000.0;
@@ -76,6 +161,26 @@ static double elapsed_to_seconds(timestamp_t start, timestamp_t end)
 
 #endif
 
+/* Reads the CPU's time stamp counter in the same way as the NewHope
+   reference code in src/crypto/newhope/cpucycles.c.  On modern CPUs the
+   counter ticks at a constant reference rate rather than the core clock,
+   so cycles/byte figures are only comparable on the same machine */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_CPUCYCLES 1
+static uint64_t cpucycles(void)
+{
+    uint32_t lo, hi;
+    __asm__ __volatile__ ("rdtsc" : "=a"(lo), "=d"(hi));
+    return (((uint64_t)hi) << 32) | lo;
+}
+#else
+#define HAVE_CPUCYCLES 0
+static uint64_t cpucycles(void)
+{
+    return 0;
+}
+#endif
+
 /* Calibrates the performance measurements to determine the "MD5 unit" */
 static void calibrate_md5(void)
 {
@@ -92,6 +197,36 @@ static void calibrate_md5(void)
     units = elapsed_to_seconds(start, end) / (double)MB_COUNT;
 }
 
+/* Starts a new JSON object in the output, separating it from the last one */
+static void json_start_object(void)
+{
+    printf(json_count ? ",\n  {" : "[\n  {");
+    ++json_count;
+}
+
+/* Prints a section header in plain text mode */
+static void print_header(const char *header)
+{
+    if (!json_output)
+        printf("%s\n", header);
+}
+
+/* Reports the performance of a primitive.  The "elapsed" time is for one
+   unit of work: 1Mb of data for hashes and ciphers or one operation for
+   public key algorithms */
+static void report_primitive(const char *name, double elapsed)
+{
+    if (json_output) {
+        json_start_object();
+        printf("\"type\": \"primitive\", \"name\": \"%s\", "
+               "\"per_sec\": %.2f, \"md5_units\": %.2f}",
+               name, 1.0 / elapsed, units / elapsed);
+    } else {
+        printf("%-20s%8.2f          %8.2f\n",
+               name, 1.0 / elapsed, units / elapsed);
+    }
+}
+
 /* Measure the performance of a hashing primitive */
 static void perf_hash(int id)
 {
@@ -112,9 +247,7 @@ static void perf_hash(int id)
     end = current_timestamp();
 
     elapsed = elapsed_to_seconds(start, end) / (double)MB_COUNT;
-    printf("%-20s%8.2f          %8.2f\n",
-           noise_id_to_name(NOISE_HASH_CATEGORY, id),
-           1.0 / elapsed, units / elapsed);
+    report_primitive(noise_id_to_name(NOISE_HASH_CATEGORY, id), elapsed);
 
     noise_hashstate_free(hash);
 }
@@ -154,9 +287,7 @@ static void perf_cipher(int id)
     end = current_timestamp();
 
     elapsed = elapsed_to_seconds(start, end) / (double)MB_COUNT;
-    printf("%-20s%8.2f          %8.2f\n",
-           noise_id_to_name(NOISE_CIPHER_CATEGORY, id),
-           1.0 / elapsed, units / elapsed);
+    report_primitive(noise_id_to_name(NOISE_CIPHER_CATEGORY, id), elapsed);
 
     noise_cipherstate_free(cipher);
 }
@@ -185,7 +316,7 @@ static void perf_dh_derive(int id)
     elapsed = elapsed_to_seconds(start, end) / (double)DH_COUNT;
     snprintf(name, sizeof(name), "%s derive key",
              noise_id_to_name(NOISE_DH_CATEGORY, id));
-    printf("%-20s%8.2f          %8.2f\n", name, 1.0 / elapsed, units / elapsed);
+    report_primitive(name, elapsed);
 
     noise_dhstate_free(dh);
 }
@@ -222,7 +353,7 @@ static void perf_dh_calculate(int id)
     elapsed = elapsed_to_seconds(start, end) / (double)DH_COUNT;
     snprintf(name, sizeof(name), "%s calculate",
              noise_id_to_name(NOISE_DH_CATEGORY, id));
-    printf("%-20s%8.2f          %8.2f\n", name, 1.0 / elapsed, units / elapsed);
+    report_primitive(name, elapsed);
 
     noise_dhstate_free(dh1);
     noise_dhstate_free(dh2);
@@ -254,7 +385,7 @@ static void perf_dh_ephemeral_only(int id)
     elapsed = elapsed_to_seconds(start, end) / (double)PQ_DH_COUNT;
     snprintf(name, sizeof(name), "%s generate",
              noise_id_to_name(NOISE_DH_CATEGORY, id));
-    printf("%-20s%8.2f          %8.2f\n", name, 1.0 / elapsed, units / elapsed);
+    report_primitive(name, elapsed);
 
     start = current_timestamp();
     for (count = 0; count < PQ_DH_COUNT; ++count)
@@ -264,7 +395,7 @@ static void perf_dh_ephemeral_only(int id)
     elapsed = elapsed_to_seconds(start, end) / (double)PQ_DH_COUNT;
     snprintf(name, sizeof(name), "%s sharedb",
              noise_id_to_name(NOISE_DH_CATEGORY, id));
-    printf("%-20s%8.2f          %8.2f\n", name, 1.0 / elapsed, units / elapsed);
+    report_primitive(name, elapsed);
 
     start = current_timestamp();
     for (count = 0; count < PQ_DH_COUNT; ++count)
@@ -274,7 +405,7 @@ static void perf_dh_ephemeral_only(int id)
     elapsed = elapsed_to_seconds(start, end) / (double)PQ_DH_COUNT;
     snprintf(name, sizeof(name), "%s shareda",
              noise_id_to_name(NOISE_DH_CATEGORY, id));
-    printf("%-20s%8.2f          %8.2f\n", name, 1.0 / elapsed, units / elapsed);
+    report_primitive(name, elapsed);
 
     noise_dhstate_free(dh1);
     noise_dhstate_free(dh2);
@@ -304,7 +435,7 @@ static void perf_sign_derive(int id)
     elapsed = elapsed_to_seconds(start, end) / (double)DH_COUNT;
     snprintf(name, sizeof(name), "%s derive key",
              noise_id_to_name(NOISE_SIGN_CATEGORY, id));
-    printf("%-20s%8.2f          %8.2f\n", name, 1.0 / elapsed, units / elapsed);
+    report_primitive(name, elapsed);
 
     noise_signstate_free(sign);
 }
@@ -339,9 +470,55 @@ static void perf_sign_sign(int id)
     elapsed = elapsed_to_seconds(start, end) / (double)DH_COUNT;
     snprintf(name, sizeof(name), "%s sign",
              noise_id_to_name(NOISE_SIGN_CATEGORY, id));
-    printf("%-20s%8.2f          %8.2f\n", name, 1.0 / elapsed, units / elapsed);
+    report_primitive(name, elapsed);
+
+    noise_signstate_free(sign);
+}
+
+/* Measure the performance of a signing primitive when the private key is
+   expanded again for every message, which is what signing cost before the
+   expanded key was cached.  Copying the key into the SignState triggers
+   the expansion without the cost of deriving the public key */
+static void perf_sign_sign_expand(int id)
+{
+    char name[64];
+    NoiseSignState *sign;
+    NoiseSignState *key;
+    uint8_t private_key[56];
+    uint8_t message[32];
+    uint8_t sig[56 * 2];
+    size_t key_len;
+    size_t sig_len;
+    timestamp_t start, end;
+    int count;
+    double elapsed;
+
+    if (noise_signstate_new_by_id(&sign, id) != NOISE_ERROR_NONE)
+        return;
+    if (noise_signstate_new_by_id(&key, id) != NOISE_ERROR_NONE) {
+        noise_signstate_free(sign);
+        return;
+    }
+    key_len = noise_signstate_get_private_key_length(key);
+    sig_len = noise_signstate_get_signature_length(sign);
+    memset(private_key, 0xAA, sizeof(private_key));
+    noise_signstate_set_keypair_private(key, private_key, key_len);
+    memset(message, 0x66, sizeof(message));
+
+    start = current_timestamp();
+    for (count = 0; count < DH_COUNT; ++count) {
+        noise_signstate_copy(sign, key);
+        noise_signstate_sign(sign, message, sizeof(message), sig, sig_len);
+    }
+    end = current_timestamp();
+
+    elapsed = elapsed_to_seconds(start, end) / (double)DH_COUNT;
+    snprintf(name, sizeof(name), "%s sign+expand",
+             noise_id_to_name(NOISE_SIGN_CATEGORY, id));
+    report_primitive(name, elapsed);
 
     noise_signstate_free(sign);
+    noise_signstate_free(key);
 }
 
 /* Measure the performance of a signing primitive when verifying messages */
@@ -375,43 +552,1659 @@ static void perf_sign_verify(int id)
     elapsed = elapsed_to_seconds(start, end) / (double)DH_COUNT;
     snprintf(name, sizeof(name), "%s verify",
              noise_id_to_name(NOISE_SIGN_CATEGORY, id));
-    printf("%-20s%8.2f          %8.2f\n", name, 1.0 / elapsed, units / elapsed);
+    report_primitive(name, elapsed);
 
     noise_signstate_free(sign);
 }
 
+/** Number of signatures to verify in each batch */
+#define SIGN_BATCH_SIZE 64
+
+/* Measure the performance of a signing primitive when verifying
+   messages in batches, reporting the cost of each signature */
+static void perf_sign_verify_batch(int id)
+{
+    char name[64];
+    NoiseSignState *sign[SIGN_BATCH_SIZE];
+    const NoiseSignState *states[SIGN_BATCH_SIZE];
+    uint8_t message[SIGN_BATCH_SIZE][32];
+    uint8_t sig[SIGN_BATCH_SIZE][56 * 2];
+    const uint8_t *messages[SIGN_BATCH_SIZE];
+    const uint8_t *sigs[SIGN_BATCH_SIZE];
+    size_t message_lens[SIGN_BATCH_SIZE];
+    size_t sig_len = 0;
+    timestamp_t start, end;
+    int count, index;
+    double elapsed;
+
+    for (index = 0; index < SIGN_BATCH_SIZE; ++index) {
+        if (noise_signstate_new_by_id(&(sign[index]), id) != NOISE_ERROR_NONE) {
+            while (index > 0)
+                noise_signstate_free(sign[--index]);
+            return;
+        }
+        sig_len = noise_signstate_get_signature_length(sign[index]);
+        noise_signstate_generate_keypair(sign[index]);
+        memset(message[index], index, sizeof(message[index]));
+        noise_signstate_sign(sign[index], message[index],
+                             sizeof(message[index]), sig[index], sig_len);
+        states[index] = sign[index];
+        messages[index] = message[index];
+        message_lens[index] = sizeof(message[index]);
+        sigs[index] = sig[index];
+    }
+
+    start = current_timestamp();
+    for (count = 0; count < DH_COUNT; count += SIGN_BATCH_SIZE) {
+        noise_signstate_verify_batch(states, messages, message_lens, sigs,
+                                     sig_len, SIGN_BATCH_SIZE, 0);
+    }
+    end = current_timestamp();
+
+    elapsed = elapsed_to_seconds(start, end) / (double)count;
+    snprintf(name, sizeof(name), "%s verify x%d",
+             noise_id_to_name(NOISE_SIGN_CATEGORY, id), SIGN_BATCH_SIZE);
+    report_primitive(name, elapsed);
+
+    for (index = 0; index < SIGN_BATCH_SIZE; ++index)
+        noise_signstate_free(sign[index]);
+}
+
+/* Maximum size of a DH public key, which is large enough for NewHope */
+#define MAX_DH_KEY_LEN  2048
+
+/* Maximum size of a hash output */
+#define MAX_HASH_LEN    64
+
+/* Protocol and keys for a handshake performance test */
+typedef struct
+{
+    NoiseProtocolId id;
+    char name[NOISE_MAX_PROTOCOL_NAME];
+    NoiseDHState *init_static;
+    NoiseDHState *resp_static;
+    uint8_t init_public[MAX_DH_KEY_LEN];
+    uint8_t resp_public[MAX_DH_KEY_LEN];
+    size_t public_key_len;
+
+} HandshakeSuite;
+
+/* Counts of the expensive operations in a complete handshake,
+   summed across both parties */
+typedef struct
+{
+    int messages;       /* Number of handshake messages */
+    int dh_generate;    /* Number of ephemeral keypairs generated */
+    int dh_dependent;   /* Number of dependent ephemeral keypairs */
+    int dh_tokens;      /* Number of DH tokens in the pattern */
+    int mix_hash;       /* Number of MixHash() operations */
+    int mix_key;        /* Number of HKDF() operations */
+
+} HandshakeOps;
+
+/* Measured cost in seconds of the primitive operations for a DH algorithm */
+typedef struct
+{
+    int valid;
+    double generate;
+    double dependent;
+    double calculate;   /* Both sides of a single DH token */
+
+} DHCosts;
+
+/* Measured cost in seconds of the primitive operations for a hash */
+typedef struct
+{
+    int valid;
+    double mix_hash;
+    double mix_key;
+
+} HashCosts;
+
+/* Static keys and primitive costs, indexed by the low byte of the id */
+static NoiseDHState *static_keys[2][256];
+static DHCosts dh_costs[256];
+static HashCosts hash_costs[256];
+
+/* Fixed pre-shared key for the PSK protocols */
+static uint8_t const psk[32] = {
+    0x50, 0x53, 0x4b, 0x50, 0x53, 0x4b, 0x50, 0x53,
+    0x4b, 0x50, 0x53, 0x4b, 0x50, 0x53, 0x4b, 0x50,
+    0x53, 0x4b, 0x50, 0x53, 0x4b, 0x50, 0x53, 0x4b,
+    0x50, 0x53, 0x4b, 0x50, 0x53, 0x4b, 0x50, 0x53
+};
+
+/* Gets the static keypair for one side of a handshake, generating it
+   the first time that it is requested for a DH algorithm */
+static NoiseDHState *get_static_key(int dh_id, int side)
+{
+    NoiseDHState **key = &(static_keys[side][dh_id & 0xFF]);
+    if (!(*key)) {
+        if (noise_dhstate_new_by_id(key, dh_id) != NOISE_ERROR_NONE)
+            return 0;
+        if (noise_dhstate_generate_keypair(*key) != NOISE_ERROR_NONE) {
+            noise_dhstate_free(*key);
+            *key = 0;
+        }
+    }
+    return *key;
+}
+
+/* Frees all of the static keypairs */
+static void free_static_keys(void)
+{
+    int side, index;
+    for (side = 0; side < 2; ++side) {
+        for (index = 0; index < 256; ++index) {
+            if (static_keys[side][index]) {
+                noise_dhstate_free(static_keys[side][index]);
+                static_keys[side][index] = 0;
+            }
+        }
+    }
+}
+
+/* Sets up the protocol name and static keys for a handshake suite.
+   Returns zero if the suite cannot be set up */
+static int setup_suite(HandshakeSuite *suite, const NoiseProtocolId *id)
+{
+    memset(suite, 0, sizeof(HandshakeSuite));
+    suite->id = *id;
+    if (noise_protocol_id_to_name(suite->name, sizeof(suite->name), id)
+            != NOISE_ERROR_NONE)
+        return 0;
+    suite->init_static = get_static_key(id->dh_id, 0);
+    suite->resp_static = get_static_key(id->dh_id, 1);
+    if (!suite->init_static || !suite->resp_static)
+        return 0;
+    suite->public_key_len =
+        noise_dhstate_get_public_key_length(suite->init_static);
+    if (suite->public_key_len > MAX_DH_KEY_LEN)
+        return 0;
+    noise_dhstate_get_public_key
+        (suite->init_static, suite->init_public, suite->public_key_len);
+    noise_dhstate_get_public_key
+        (suite->resp_static, suite->resp_public, suite->public_key_len);
+    return 1;
+}
+
+/* Sets up the keys for one side of a handshake and starts it */
+static int start_party(NoiseHandshakeState *state, const NoiseDHState *local,
+                       const uint8_t *remote_public, size_t remote_public_len)
+{
+    int err = NOISE_ERROR_NONE;
+    if (noise_handshakestate_needs_pre_shared_key(state)) {
+        err = noise_handshakestate_set_pre_shared_key(state, psk, sizeof(psk));
+    }
+    if (err == NOISE_ERROR_NONE &&
+            noise_handshakestate_needs_local_keypair(state)) {
+        err = noise_dhstate_copy
+            (noise_handshakestate_get_local_keypair_dh(state), local);
+    }
+    if (err == NOISE_ERROR_NONE &&
+            noise_handshakestate_needs_remote_public_key(state)) {
+        err = noise_dhstate_set_public_key
+            (noise_handshakestate_get_remote_public_key_dh(state),
+             remote_public, remote_public_len);
+    }
+    if (err == NOISE_ERROR_NONE)
+        err = noise_handshakestate_start(state);
+    return err;
+}
+
+/* Runs a complete in-memory handshake between an initiator and a responder.
+   If "check" is non-zero, then the handshake hashes on both sides are
+   compared to verify that the handshake actually worked */
+static int run_handshake(const HandshakeSuite *suite, int check)
+{
+    NoiseHandshakeState *initiator;
+    NoiseHandshakeState *responder;
+    NoiseHandshakeState *send;
+    NoiseHandshakeState *recv;
+    NoiseCipherState *send_cipher;
+    NoiseCipherState *recv_cipher;
+    uint8_t message[MAX_MESSAGE_LEN];
+    uint8_t init_hash[MAX_HASH_LEN];
+    uint8_t resp_hash[MAX_HASH_LEN];
+    NoiseBuffer mbuf;
+    int action;
+    int err;
+
+    /* Create and start the two sides of the handshake.  The handshake
+       pointer is not reliable if the object could not be created */
+    err = noise_handshakestate_new_by_id
+        (&initiator, &(suite->id), NOISE_ROLE_INITIATOR);
+    if (err != NOISE_ERROR_NONE)
+        return err;
+    err = noise_handshakestate_new_by_id
+        (&responder, &(suite->id), NOISE_ROLE_RESPONDER);
+    if (err != NOISE_ERROR_NONE) {
+        noise_handshakestate_free(initiator);
+        return err;
+    }
+    if (err == NOISE_ERROR_NONE) {
+        err = start_party(initiator, suite->init_static,
+                          suite->resp_public, suite->public_key_len);
+    }
+    if (err == NOISE_ERROR_NONE) {
+        err = start_party(responder, suite->resp_static,
+                          suite->init_public, suite->public_key_len);
+    }
+
+    /* Pass messages back and forth until the handshake finishes */
+    while (err == NOISE_ERROR_NONE) {
+        action = noise_handshakestate_get_action(initiator);
+        if (action == NOISE_ACTION_WRITE_MESSAGE) {
+            send = initiator;
+            recv = responder;
+        } else if (action == NOISE_ACTION_READ_MESSAGE) {
+            send = responder;
+            recv = initiator;
+        } else {
+            break;
+        }
+        noise_buffer_set_output(mbuf, message, sizeof(message));
+        err = noise_handshakestate_write_message(send, &mbuf, NULL);
+        if (err == NOISE_ERROR_NONE)
+            err = noise_handshakestate_read_message(recv, &mbuf, NULL);
+    }
+
+    /* Check the handshake hashes if requested */
+    if (err == NOISE_ERROR_NONE && check) {
+        if (noise_handshakestate_get_action(initiator) != NOISE_ACTION_SPLIT ||
+                noise_handshakestate_get_action(responder) != NOISE_ACTION_SPLIT) {
+            err = NOISE_ERROR_INVALID_STATE;
+        } else {
+            noise_handshakestate_get_handshake_hash
+                (initiator, init_hash, sizeof(init_hash));
+            noise_handshakestate_get_handshake_hash
+                (responder, resp_hash, sizeof(resp_hash));
+            if (memcmp(init_hash, resp_hash, sizeof(init_hash)) != 0)
+                err = NOISE_ERROR_MAC_FAILURE;
+        }
+    }
+
+    /* Split out the transport ciphers for both sides and clean up */
+    if (err == NOISE_ERROR_NONE) {
+        err = noise_handshakestate_split(initiator, &send_cipher, &recv_cipher);
+        if (err == NOISE_ERROR_NONE) {
+            noise_cipherstate_free(send_cipher);
+            noise_cipherstate_free(recv_cipher);
+            err = noise_handshakestate_split
+                (responder, &send_cipher, &recv_cipher);
+        }
+        if (err == NOISE_ERROR_NONE) {
+            noise_cipherstate_free(send_cipher);
+            noise_cipherstate_free(recv_cipher);
+        }
+    }
+    noise_handshakestate_free(initiator);
+    noise_handshakestate_free(responder);
+    return err;
+}
+
+/* Counts the expensive operations in a handshake by walking the tokens
+   of its pattern in the same way as the handshake interpreter */
+static void count_handshake_ops(const NoiseProtocolId *id, HandshakeOps *ops)
+{
+    const uint8_t *pattern = noise_pattern_lookup(id->pattern_id);
+    int is_psk = (id->prefix_id == NOISE_PREFIX_PSK);
+    int have_ephemeral = 0;
+    uint8_t flags;
+
+    memset(ops, 0, sizeof(HandshakeOps));
+    if (!pattern)
+        return;
+    flags = *pattern++;
+
+    /* Prologue, pre-shared key, and pre-message public keys */
+    ops->mix_hash += 2;
+    if (is_psk) {
+        ops->mix_key += 2;
+        ops->mix_hash += 2;
+    }
+    if (flags & NOISE_PAT_FLAG_LOCAL_REQUIRED)
+        ops->mix_hash += 2;
+    if (flags & NOISE_PAT_FLAG_REMOTE_REQUIRED)
+        ops->mix_hash += 2;
+
+    /* Handshake message tokens */
+    ops->messages = 1;
+    for (; *pattern != NOISE_TOKEN_END; ++pattern) {
+        switch (*pattern) {
+        case NOISE_TOKEN_E:
+            if (have_ephemeral)
+                ++(ops->dh_dependent);
+            else
+                ++(ops->dh_generate);
+            have_ephemeral = 1;
+            ops->mix_hash += 2;
+            if (is_psk)
+                ops->mix_key += 2;
+            if (id->hybrid_id) {
+                /* The hybrid public key is hashed in the same way */
+                ops->mix_hash += 2;
+                if (is_psk)
+                    ops->mix_key += 2;
+            }
+            break;
+        case NOISE_TOKEN_S:
+            ops->mix_hash += 2;
+            break;
+        case NOISE_TOKEN_DHEE:
+            if (id->hybrid_id)
+                ops->mix_key += 2;
+            ++(ops->dh_tokens);
+            ops->mix_key += 2;
+            break;
+        case NOISE_TOKEN_DHES:
+        case NOISE_TOKEN_DHSE:
+        case NOISE_TOKEN_DHSS:
+            ++(ops->dh_tokens);
+            ops->mix_key += 2;
+            break;
+        case NOISE_TOKEN_FLIP_DIR:
+            ++(ops->messages);
+            break;
+        }
+    }
+
+    /* Payloads and the final split */
+    ops->mix_hash += 2 * ops->messages;
+    ops->mix_key += 2;
+}
+
+/* Runs an operation repeatedly until "min_time" has elapsed and then
+   returns the average time in seconds for one operation */
+#define time_operation(op, result) \
+    do { \
+        timestamp_t _start, _end; \
+        long _count = 0; \
+        _start = current_timestamp(); \
+        do { \
+            op; \
+            ++_count; \
+            _end = current_timestamp(); \
+        } while (elapsed_to_seconds(_start, _end) < min_time); \
+        (result) = elapsed_to_seconds(_start, _end) / (double)_count; \
+    } while (0)
+
+/* Gets the measured costs for a DH algorithm, measuring them if necessary */
+static const DHCosts *get_dh_costs(int id)
+{
+    DHCosts *costs = &(dh_costs[id & 0xFF]);
+    NoiseDHState *dh1;
+    NoiseDHState *dh2;
+    uint8_t shared_key[128];
+    size_t shared_key_len;
+    double calc1, calc2;
+    if (costs->valid)
+        return costs;
+    costs->valid = 1;
+    if (noise_dhstate_new_by_id(&dh1, id) != NOISE_ERROR_NONE)
+        return costs;
+    if (noise_dhstate_new_by_id(&dh2, id) != NOISE_ERROR_NONE) {
+        noise_dhstate_free(dh1);
+        return costs;
+    }
+    noise_dhstate_set_role(dh1, NOISE_ROLE_INITIATOR);
+    noise_dhstate_set_role(dh2, NOISE_ROLE_RESPONDER);
+    shared_key_len = noise_dhstate_get_shared_key_length(dh1);
+    time_operation(noise_dhstate_generate_keypair(dh1), costs->generate);
+    time_operation(noise_dhstate_generate_dependent_keypair(dh2, dh1),
+                   costs->dependent);
+    time_operation(noise_dhstate_calculate
+                        (dh1, dh2, shared_key, shared_key_len), calc1);
+    time_operation(noise_dhstate_calculate
+                        (dh2, dh1, shared_key, shared_key_len), calc2);
+    costs->calculate = calc1 + calc2;
+    noise_dhstate_free(dh1);
+    noise_dhstate_free(dh2);
+    return costs;
+}
+
+/* Gets the measured costs for a hash algorithm, measuring them if necessary */
+static const HashCosts *get_hash_costs(int id)
+{
+    HashCosts *costs = &(hash_costs[id & 0xFF]);
+    NoiseHashState *hash;
+    uint8_t h[MAX_HASH_LEN];
+    uint8_t data[32];
+    size_t hash_len;
+    if (costs->valid)
+        return costs;
+    costs->valid = 1;
+    if (noise_hashstate_new_by_id(&hash, id) != NOISE_ERROR_NONE)
+        return costs;
+    hash_len = noise_hashstate_get_hash_length(hash);
+    memset(h, 0xAA, sizeof(h));
+    memset(data, 0x55, sizeof(data));
+    time_operation(noise_hashstate_hash_two
+                        (hash, h, hash_len, data, sizeof(data), h, hash_len),
+                   costs->mix_hash);
+    time_operation(noise_hashstate_hkdf
+                        (hash, h, hash_len, data, sizeof(data),
+                         h, hash_len, h, hash_len),
+                   costs->mix_key);
+    noise_hashstate_free(hash);
+    return costs;
+}
+
+/* Allocates and frees both sides of a handshake */
+static void alloc_handshake(const NoiseProtocolId *id)
+{
+    NoiseHandshakeState *state;
+    if (noise_handshakestate_new_by_id
+            (&state, id, NOISE_ROLE_INITIATOR) == NOISE_ERROR_NONE)
+        noise_handshakestate_free(state);
+    if (noise_handshakestate_new_by_id
+            (&state, id, NOISE_ROLE_RESPONDER) == NOISE_ERROR_NONE)
+        noise_handshakestate_free(state);
+}
+
+/* Measures the cost of allocating and freeing both sides of a handshake */
+static double get_alloc_cost(const NoiseProtocolId *id)
+{
+    double elapsed;
+    time_operation(alloc_handshake(id), elapsed);
+    return elapsed;
+}
+
+/* Measure the cost of allocating and freeing both sides of a handshake,
+   first from the heap and then from the secure memory allocator */
+static void perf_alloc(const char *protocol, const char *label)
+{
+    char name[64];
+    NoiseProtocolId id;
+    double elapsed;
+    int was_enabled = noise_secmem_is_enabled();
+
+    if (noise_protocol_name_to_id(&id, protocol, strlen(protocol))
+            != NOISE_ERROR_NONE)
+        return;
+
+    noise_secmem_disable();
+    time_operation(alloc_handshake(&id), elapsed);
+    snprintf(name, sizeof(name), "Alloc %s heap", label);
+    report_primitive(name, elapsed);
+
+    if (noise_secmem_init(0, NOISE_SECMEM_DEFAULT) == NOISE_ERROR_NONE) {
+        time_operation(alloc_handshake(&id), elapsed);
+        snprintf(name, sizeof(name), "Alloc %s slab", label);
+        report_primitive(name, elapsed);
+    }
+    if (!was_enabled)
+        noise_secmem_disable();
+}
+
+/* Imports a CipherState blob and frees the imported object */
+static void import_cipherstate(const uint8_t *wrap_key, const NoiseBuffer *blob)
+{
+    NoiseCipherState *state;
+    if (noise_cipherstate_import
+            (&state, wrap_key, NOISE_EXPORT_KEY_LEN, blob) == NOISE_ERROR_NONE)
+        noise_cipherstate_free(state);
+}
+
+/* Imports a HandshakeState blob and frees the imported object */
+static void import_handshakestate(const uint8_t *wrap_key, const NoiseBuffer *blob)
+{
+    NoiseHandshakeState *state;
+    if (noise_handshakestate_import
+            (&state, wrap_key, NOISE_EXPORT_KEY_LEN, blob) == NOISE_ERROR_NONE)
+        noise_handshakestate_free(state);
+}
+
+/* Issues a resumption ticket and then redeems it straight away */
+static void issue_and_redeem
+    (NoiseTicketIssuer *issuer, const NoiseHandshakeState *state,
+     NoiseBuffer *ticket, NoiseHandshakeState *resume)
+{
+    if (noise_ticketissuer_issue(issuer, state, ticket) == NOISE_ERROR_NONE)
+        noise_ticketissuer_redeem(issuer, ticket, resume);
+}
+
+/* Measure the cost of migrating a transport session or an in-progress
+   handshake to another process with export and import.  The handshake
+   is exported by the responder of XX after the first message.  Then the
+   handshake is finished and resumption tickets are issued for it */
+static void perf_export(void)
+{
+    static uint8_t const wrap_key[NOISE_EXPORT_KEY_LEN] = {
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+        0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10,
+        0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18,
+        0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20
+    };
+    NoiseCipherState *cipher;
+    NoiseHandshakeState *initiator;
+    NoiseHandshakeState *responder;
+    uint8_t blob_data[NOISE_MAX_EXPORT_LEN];
+    uint8_t message[MAX_MESSAGE_LEN];
+    NoiseBuffer blob;
+    NoiseTicketIssuer *issuer;
+    NoiseHandshakeState *resume;
+    NoiseBuffer mbuf;
+    double elapsed, elapsed2;
+
+    /* Transport session */
+    if (noise_cipherstate_new_by_id(&cipher, NOISE_CIPHER_CHACHAPOLY)
+            != NOISE_ERROR_NONE)
+        return;
+    noise_cipherstate_init_key(cipher, wrap_key, sizeof(wrap_key));
+    noise_buffer_set_output(blob, blob_data, sizeof(blob_data));
+    time_operation(noise_cipherstate_export
+                        (cipher, wrap_key, sizeof(wrap_key), &blob),
+                   elapsed);
+    report_primitive("CipherState export", elapsed);
+    time_operation(import_cipherstate(wrap_key, &blob), elapsed);
+    report_primitive("CipherState import", elapsed);
+    noise_cipherstate_free(cipher);
+
+    /* In-progress handshake */
+    if (noise_handshakestate_new_by_name
+            (&initiator, "Noise_XX_25519_ChaChaPoly_BLAKE2s",
+             NOISE_ROLE_INITIATOR) != NOISE_ERROR_NONE)
+        return;
+    if (noise_handshakestate_new_by_name
+            (&responder, "Noise_XX_25519_ChaChaPoly_BLAKE2s",
+             NOISE_ROLE_RESPONDER) != NOISE_ERROR_NONE) {
+        noise_handshakestate_free(initiator);
+        return;
+    }
+    noise_dhstate_copy(noise_handshakestate_get_local_keypair_dh(initiator),
+                       get_static_key(NOISE_DH_CURVE25519, 0));
+    noise_dhstate_copy(noise_handshakestate_get_local_keypair_dh(responder),
+                       get_static_key(NOISE_DH_CURVE25519, 1));
+    noise_handshakestate_start(initiator);
+    noise_handshakestate_start(responder);
+    noise_buffer_set_output(mbuf, message, sizeof(message));
+    noise_handshakestate_write_message(initiator, &mbuf, 0);
+    noise_handshakestate_read_message(responder, &mbuf, 0);
+    time_operation(noise_handshakestate_export
+                        (responder, wrap_key, sizeof(wrap_key), &blob),
+                   elapsed);
+    report_primitive("XX 25519 export", elapsed);
+    time_operation(import_handshakestate(wrap_key, &blob), elapsed);
+    report_primitive("XX 25519 import", elapsed);
+
+    /* Resumption tickets for the finished handshake */
+    noise_buffer_set_output(mbuf, message, sizeof(message));
+    noise_handshakestate_write_message(responder, &mbuf, 0);
+    noise_handshakestate_read_message(initiator, &mbuf, 0);
+    noise_buffer_set_output(mbuf, message, sizeof(message));
+    noise_handshakestate_write_message(initiator, &mbuf, 0);
+    noise_handshakestate_read_message(responder, &mbuf, 0);
+    if (noise_ticketissuer_new(&issuer) == NOISE_ERROR_NONE) {
+        if (noise_handshakestate_new_by_name
+                (&resume, "NoisePSK_NN_25519_ChaChaPoly_BLAKE2s",
+                 NOISE_ROLE_RESPONDER) == NOISE_ERROR_NONE) {
+            noise_buffer_set_output(blob, blob_data, sizeof(blob_data));
+            time_operation(noise_ticketissuer_issue
+                                (issuer, responder, &blob),
+                           elapsed);
+            report_primitive("Ticket issue", elapsed);
+            time_operation(issue_and_redeem
+                                (issuer, responder, &blob, resume),
+                           elapsed2);
+            report_primitive("Ticket redeem", elapsed2 - elapsed);
+            noise_handshakestate_free(resume);
+        }
+        noise_ticketissuer_free(issuer);
+    }
+    noise_handshakestate_free(initiator);
+    noise_handshakestate_free(responder);
+    free_static_keys();
+}
+
+/* Checks the MAC's on a message, restoring the size of the message first */
+static void check_cookie
+    (NoiseCookieChecker *checker, NoiseBuffer *mbuf, size_t size)
+{
+    static uint8_t const source[6] = {192, 168, 1, 2, 0x12, 0x34};
+    mbuf->size = size;
+    noise_cookiechecker_check(checker, source, sizeof(source), mbuf);
+}
+
+/* Measure the cost of checking cookies on the first message of IK
+   with and without load, which should be small compared to a DH */
+static void perf_cookie(void)
+{
+    static uint8_t const source[6] = {192, 168, 1, 2, 0x12, 0x34};
+    NoiseCookieChecker *checker;
+    NoiseCookieMaker *maker;
+    uint8_t public_key[32];
+    uint8_t message[96 + NOISE_COOKIE_MACS_LEN];
+    uint8_t reply_data[NOISE_MAX_COOKIE_REPLY_LEN];
+    NoiseBuffer mbuf;
+    NoiseBuffer reply;
+    double elapsed;
+
+    /* The first IK message with 25519 and no payload is 96 bytes */
+    memset(public_key, 0xAA, sizeof(public_key));
+    memset(message, 0x55, sizeof(message));
+    if (noise_cookiechecker_new(&checker, public_key, sizeof(public_key))
+            != NOISE_ERROR_NONE)
+        return;
+    if (noise_cookiemaker_new(&maker, public_key, sizeof(public_key))
+            != NOISE_ERROR_NONE) {
+        noise_cookiechecker_free(checker);
+        return;
+    }
+    noise_buffer_set_inout(mbuf, message, 96, sizeof(message));
+    time_operation((mbuf.size = 96, noise_cookiemaker_add_macs(maker, &mbuf)),
+                   elapsed);
+    report_primitive("Cookie add MAC's", elapsed);
+    time_operation(check_cookie(checker, &mbuf, sizeof(message)), elapsed);
+    report_primitive("Cookie check mac1", elapsed);
+
+    /* Put the checker under load and get a cookie */
+    noise_cookiechecker_set_threshold(checker, 1);
+    check_cookie(checker, &mbuf, sizeof(message));
+    noise_buffer_set_output(reply, reply_data, sizeof(reply_data));
+    time_operation(noise_cookiechecker_make_reply
+                        (checker, source, sizeof(source), &mbuf, &reply),
+                   elapsed);
+    report_primitive("Cookie reply", elapsed);
+    noise_cookiemaker_consume_reply(maker, &reply);
+    mbuf.size = 96;
+    noise_cookiemaker_add_macs(maker, &mbuf);
+    time_operation(check_cookie(checker, &mbuf, sizeof(message)), elapsed);
+    report_primitive("Cookie check mac2", elapsed);
+
+    noise_cookiechecker_free(checker);
+    noise_cookiemaker_free(maker);
+}
+
+/* Clamps a breakdown component so that rounding never makes it negative */
+static double clamp_cost(double cost)
+{
+    return cost < 0.0 ? 0.0 : cost;
+}
+
+/* Reports the performance of a handshake */
+static void report_handshake
+    (const HandshakeSuite *suite, const HandshakeOps *ops, double elapsed,
+     double dh, double hash, double alloc)
+{
+    double other = clamp_cost(elapsed - dh - hash - alloc);
+    if (json_output) {
+        json_start_object();
+        printf("\"type\": \"handshake\", \"protocol\": \"%s\", "
+               "\"messages\": %d, \"handshakes_per_sec\": %.2f, "
+               "\"ns_per_message\": %.0f, \"breakdown_ns\": {"
+               "\"dh\": %.0f, \"hash\": %.0f, \"alloc\": %.0f, "
+               "\"other\": %.0f}}",
+               suite->name, ops->messages, 1.0 / elapsed,
+               elapsed * 1e9 / ops->messages,
+               dh * 1e9, hash * 1e9, alloc * 1e9, other * 1e9);
+    } else {
+        printf("%-44s%9.1f%10.0f%7.1f%7.1f%7.1f%7.1f\n",
+               suite->name, 1.0 / elapsed, elapsed * 1e9 / ops->messages,
+               100.0 * dh / elapsed, 100.0 * hash / elapsed,
+               100.0 * alloc / elapsed, 100.0 * other / elapsed);
+    }
+}
+
+/* Measure the performance of complete handshakes for a protocol */
+static void perf_handshake(const NoiseProtocolId *id)
+{
+    HandshakeSuite suite;
+    HandshakeOps ops;
+    const DHCosts *dh_cost;
+    const HashCosts *hash_cost;
+    double elapsed, dh, hash, alloc;
+    int err;
+
+    /* Format the protocol name, apply the filter, and set up the keys */
+    if (!setup_suite(&suite, id))
+        return;
+    if (filter && !strstr(suite.name, filter))
+        return;
+
+    /* Run the handshake once to check that it works.  Some combinations
+       are not applicable; e.g. fallback patterns or NewHope with static
+       keys, or algorithms that are left out of single-suite builds.
+       Skip them silently */
+    err = run_handshake(&suite, 1);
+    if (err == NOISE_ERROR_NOT_APPLICABLE || err == NOISE_ERROR_UNKNOWN_ID)
+        return;
+    if (err != NOISE_ERROR_NONE) {
+        noise_perror(suite.name, err);
+        return;
+    }
+
+    /* Time the full handshake */
+    time_operation(run_handshake(&suite, 0), elapsed);
+
+    /* Estimate the cost breakdown from the operation counts */
+    count_handshake_ops(id, &ops);
+    dh_cost = get_dh_costs(id->dh_id);
+    hash_cost = get_hash_costs(id->hash_id);
+    dh = ops.dh_generate * dh_cost->generate +
+         ops.dh_dependent * dh_cost->dependent +
+         ops.dh_tokens * dh_cost->calculate;
+    if (id->hybrid_id) {
+        /* One hybrid keypair from each party, combined by the "ee" */
+        dh_cost = get_dh_costs(id->hybrid_id);
+        dh += dh_cost->generate + dh_cost->dependent + dh_cost->calculate;
+    }
+    hash = ops.mix_hash * hash_cost->mix_hash +
+           ops.mix_key * hash_cost->mix_key;
+    alloc = get_alloc_cost(id);
+    report_handshake(&suite, &ops, elapsed, clamp_cost(dh),
+                     clamp_cost(hash), clamp_cost(alloc));
+}
+
+/* Measure the performance of a selection of hybrid handshakes, which
+   carry a classical and a post-quantum ephemeral key in the same state */
+static void perf_hybrid_handshakes(void)
+{
+    static const char * const names[] = {
+        "Noise_NN_25519+NewHope_ChaChaPoly_BLAKE2s",
+        "Noise_XX_25519+NewHope_ChaChaPoly_BLAKE2s",
+        "Noise_IK_25519+NewHope_ChaChaPoly_BLAKE2s",
+        "Noise_NN_25519+MLKEM768_ChaChaPoly_BLAKE2s",
+        "Noise_XX_25519+MLKEM768_ChaChaPoly_BLAKE2s",
+        "Noise_IK_25519+MLKEM768_ChaChaPoly_BLAKE2s",
+        "Noise_XX_448+MLKEM768_AESGCM_SHA512",
+        "NoisePSK_XX_25519+MLKEM768_AESGCM_SHA256"
+    };
+    NoiseProtocolId id;
+    size_t index;
+    for (index = 0; index < sizeof(names) / sizeof(names[0]); ++index) {
+        if (noise_protocol_name_to_id
+                (&id, names[index], strlen(names[index])) != NOISE_ERROR_NONE)
+            continue;
+        perf_handshake(&id);
+    }
+}
+
+/* Measure the performance of handshakes for all supported protocols */
+static void perf_handshakes(void)
+{
+    static int const prefixes[] = {NOISE_PREFIX_STANDARD, NOISE_PREFIX_PSK};
+    NoiseProtocolId id;
+    int prefix, pattern, dh, cipher, hash;
+
+    print_header("\nHandshake protocol                             "
+                 "hs/sec    ns/msg    DH%  hash% alloc% other%");
+    memset(&id, 0, sizeof(id));
+    for (prefix = 0; prefix < 2; ++prefix) {
+        id.prefix_id = prefixes[prefix];
+        for (pattern = 1; pattern < 64; ++pattern) {
+            id.pattern_id = NOISE_ID('P', pattern);
+            if (!noise_id_to_name(NOISE_PATTERN_CATEGORY, id.pattern_id))
+                continue;
+            for (dh = 1; dh < 16; ++dh) {
+                id.dh_id = NOISE_ID('D', dh);
+                if (!noise_id_to_name(NOISE_DH_CATEGORY, id.dh_id))
+                    continue;
+                for (cipher = 1; cipher < 16; ++cipher) {
+                    id.cipher_id = NOISE_ID('C', cipher);
+                    if (!noise_id_to_name(NOISE_CIPHER_CATEGORY, id.cipher_id))
+                        continue;
+                    for (hash = 1; hash < 16; ++hash) {
+                        id.hash_id = NOISE_ID('H', hash);
+                        if (!noise_id_to_name(NOISE_HASH_CATEGORY, id.hash_id))
+                            continue;
+                        perf_handshake(&id);
+                    }
+                }
+            }
+        }
+    }
+    perf_hybrid_handshakes();
+    free_static_keys();
+}
+
+/* Function types for the generated protobuf functions */
+typedef int (*PerfWriteFunc)(NoiseProtobuf *pbuf, int tag, const void *obj);
+typedef size_t (*PerfMeasureFunc)(int tag, const void *obj);
+typedef int (*PerfReadFunc)(NoiseProtobuf *pbuf, int tag, void **obj);
+typedef int (*PerfFreeFunc)(void *obj);
+
+/* Measure serializing and parsing a protobuf object three ways: measuring
+   and then writing in reverse, measuring and then encoding forwards in
+   a single pass with the cached sizes, and reading it back again */
+static void perf_protobuf(const char *type_name, const void *obj,
+                          PerfWriteFunc write, PerfMeasureFunc measure,
+                          PerfWriteFunc encode, PerfReadFunc read,
+                          PerfFreeFunc free_obj)
+{
+    char name[64];
+    uint8_t buffer[MAX_MESSAGE_LEN];
+    NoiseProtobuf pbuf;
+    uint8_t *data;
+    size_t size;
+    void *copy;
+    timestamp_t start, end;
+    int count;
+
+    start = current_timestamp();
+    for (count = 0; count < PROTOBUF_COUNT; ++count) {
+        noise_protobuf_prepare_measure(&pbuf, sizeof(buffer));
+        (*write)(&pbuf, 0, obj);
+        noise_protobuf_finish_measure(&pbuf, &size);
+        noise_protobuf_prepare_output(&pbuf, buffer, size);
+        (*write)(&pbuf, 0, obj);
+        noise_protobuf_finish_output(&pbuf, &data, &size);
+    }
+    end = current_timestamp();
+    snprintf(name, sizeof(name), "%s write", type_name);
+    report_primitive(name, elapsed_to_seconds(start, end) /
+                           (double)PROTOBUF_COUNT);
+
+    start = current_timestamp();
+    for (count = 0; count < PROTOBUF_COUNT; ++count) {
+        size = (*measure)(0, obj);
+        noise_protobuf_prepare_encode(&pbuf, buffer, size);
+        (*encode)(&pbuf, 0, obj);
+        noise_protobuf_finish_encode(&pbuf, &size);
+    }
+    end = current_timestamp();
+    snprintf(name, sizeof(name), "%s encode", type_name);
+    report_primitive(name, elapsed_to_seconds(start, end) /
+                           (double)PROTOBUF_COUNT);
+
+    start = current_timestamp();
+    for (count = 0; count < PROTOBUF_COUNT; ++count) {
+        noise_protobuf_prepare_input(&pbuf, buffer, size);
+        if ((*read)(&pbuf, 0, &copy) == NOISE_ERROR_NONE)
+            (*free_obj)(copy);
+    }
+    end = current_timestamp();
+    snprintf(name, sizeof(name), "%s read", type_name);
+    report_primitive(name, elapsed_to_seconds(start, end) /
+                           (double)PROTOBUF_COUNT);
+}
+
+/* Measure the serialization of certificates and encrypted private keys */
+static void perf_protobufs(void)
+{
+    static uint8_t const key_data[32] = {1, 2, 3, 4, 5, 6, 7, 8};
+    static uint8_t const sig_data[64] = {8, 7, 6, 5, 4, 3, 2, 1};
+    Noise_Certificate *cert = 0;
+    Noise_SubjectInfo *subject = 0;
+    Noise_PublicKeyInfo *key = 0;
+    Noise_MetaInfo *meta = 0;
+    Noise_Signature *sig = 0;
+    Noise_EncryptedPrivateKey *enc_key = 0;
+    uint8_t encrypted[160];
+    int index;
+
+    /* Construct a typical certificate with one signature */
+    Noise_Certificate_new(&cert);
+    Noise_Certificate_set_version(cert, 1);
+    Noise_Certificate_get_new_subject(cert, &subject);
+    Noise_SubjectInfo_set_id(subject, "jane.smith@example.com", 22);
+    Noise_SubjectInfo_set_name(subject, "Jane Smith", 10);
+    Noise_SubjectInfo_set_role(subject, "client", 6);
+    for (index = 0; index < 2; ++index) {
+        Noise_SubjectInfo_add_keys(subject, &key);
+        Noise_PublicKeyInfo_set_algorithm(key, index ? "448" : "25519",
+                                          index ? 3 : 5);
+        Noise_PublicKeyInfo_set_key(key, key_data, sizeof(key_data));
+    }
+    for (index = 0; index < 3; ++index) {
+        Noise_SubjectInfo_add_meta(subject, &meta);
+        Noise_MetaInfo_set_name(meta, "Department", 10);
+        Noise_MetaInfo_set_value(meta, "Engineering", 11);
+    }
+    Noise_Certificate_add_signatures(cert, &sig);
+    Noise_Signature_set_id(sig, "ca@example.com", 14);
+    Noise_Signature_get_new_signing_key(sig, &key);
+    Noise_PublicKeyInfo_set_algorithm(key, "Ed25519", 7);
+    Noise_PublicKeyInfo_set_key(key, key_data, sizeof(key_data));
+    Noise_Signature_set_hash_algorithm(sig, "BLAKE2b", 7);
+    Noise_Signature_set_signature(sig, sig_data, sizeof(sig_data));
+
+    /* Construct an encrypted private key */
+    memset(encrypted, 0xAA, sizeof(encrypted));
+    Noise_EncryptedPrivateKey_new(&enc_key);
+    Noise_EncryptedPrivateKey_set_version(enc_key, 1);
+    Noise_EncryptedPrivateKey_set_algorithm
+        (enc_key, "ChaChaPoly_BLAKE2b_PBKDF2", 25);
+    Noise_EncryptedPrivateKey_set_salt(enc_key, key_data, 16);
+    Noise_EncryptedPrivateKey_set_iterations(enc_key, 20000);
+    Noise_EncryptedPrivateKey_set_encrypted_data
+        (enc_key, encrypted, sizeof(encrypted));
+
+    perf_protobuf("Cert", cert,
+                  (PerfWriteFunc)Noise_Certificate_write,
+                  (PerfMeasureFunc)Noise_Certificate_measure,
+                  (PerfWriteFunc)Noise_Certificate_encode,
+                  (PerfReadFunc)Noise_Certificate_read,
+                  (PerfFreeFunc)Noise_Certificate_free);
+    perf_protobuf("EncPrivKey", enc_key,
+                  (PerfWriteFunc)Noise_EncryptedPrivateKey_write,
+                  (PerfMeasureFunc)Noise_EncryptedPrivateKey_measure,
+                  (PerfWriteFunc)Noise_EncryptedPrivateKey_encode,
+                  (PerfReadFunc)Noise_EncryptedPrivateKey_read,
+                  (PerfFreeFunc)Noise_EncryptedPrivateKey_free);
+
+    Noise_Certificate_free(cert);
+    Noise_EncryptedPrivateKey_free(enc_key);
+}
+
+/* Creates a certificate for a new Ed25519 signing key, signed by "issuer"
+   or self-signed if "issuer" is NULL */
+static Noise_Certificate *perf_create_cert
+    (const char *id, NoiseSignState *sign, const NoiseSignState *issuer)
+{
+    Noise_Certificate *cert = 0;
+    Noise_SubjectInfo *subject = 0;
+    Noise_PublicKeyInfo *key = 0;
+    Noise_Signature *sig = 0;
+    uint8_t key_data[32];
+    uint8_t hash[64];
+    uint8_t sig_data[64];
+    size_t hash_len;
+
+    Noise_Certificate_new(&cert);
+    Noise_Certificate_set_version(cert, 1);
+    Noise_Certificate_get_new_subject(cert, &subject);
+    Noise_SubjectInfo_set_id(subject, id, strlen(id));
+    Noise_SubjectInfo_add_keys(subject, &key);
+    noise_signstate_get_public_key(sign, key_data, sizeof(key_data));
+    Noise_PublicKeyInfo_set_algorithm(key, "Ed25519", 7);
+    Noise_PublicKeyInfo_set_key(key, key_data, sizeof(key_data));
+    if (!issuer)
+        return cert;
+
+    Noise_Certificate_add_signatures(cert, &sig);
+    Noise_Signature_get_new_signing_key(sig, &key);
+    noise_signstate_get_public_key(issuer, key_data, sizeof(key_data));
+    Noise_PublicKeyInfo_set_algorithm(key, "Ed25519", 7);
+    Noise_PublicKeyInfo_set_key(key, key_data, sizeof(key_data));
+    Noise_Signature_set_hash_algorithm(sig, "BLAKE2b", 7);
+    noise_certificate_compute_signed_hash
+        (cert, sig, hash, sizeof(hash), &hash_len);
+    noise_signstate_sign(issuer, hash, hash_len, sig_data, sizeof(sig_data));
+    Noise_Signature_set_signature(sig, sig_data, sizeof(sig_data));
+    return cert;
+}
+
+/* Measure the verification of a three-level certificate chain with and
+   without the verified signature cache */
+static void perf_cert_chain(void)
+{
+    NoiseSignState *keys[3];
+    Noise_Certificate *root;
+    Noise_CertificateChain *chain = 0;
+    NoiseCertVerifier *verifier;
+    timestamp_t start, end;
+    int count, index, cached;
+
+    for (index = 0; index < 3; ++index) {
+        noise_signstate_new_by_id(&(keys[index]), NOISE_SIGN_ED25519);
+        noise_signstate_generate_keypair(keys[index]);
+    }
+    root = perf_create_cert("root@example.com", keys[0], 0);
+    Noise_CertificateChain_new(&chain);
+    Noise_CertificateChain_insert_certs
+        (chain, 0, perf_create_cert("ca@example.com", keys[1], keys[0]));
+    Noise_CertificateChain_insert_certs
+        (chain, 0, perf_create_cert("jane@example.com", keys[2], keys[1]));
+
+    for (cached = 0; cached < 2; ++cached) {
+        noise_cert_verifier_new(&verifier, cached ? 1024 : 0);
+        noise_cert_verifier_add_trusted_certificate(verifier, root);
+        noise_cert_verifier_verify_chain(verifier, chain);
+        start = current_timestamp();
+        for (count = 0; count < DH_COUNT; ++count)
+            noise_cert_verifier_verify_chain(verifier, chain);
+        end = current_timestamp();
+        report_primitive(cached ? "Chain verify cached" : "Chain verify",
+                         elapsed_to_seconds(start, end) / (double)DH_COUNT);
+        noise_cert_verifier_free(verifier);
+    }
+
+    Noise_CertificateChain_free(chain);
+    Noise_Certificate_free(root);
+    for (index = 0; index < 3; ++index)
+        noise_signstate_free(keys[index]);
+}
+
+/* Measure key store lookups and revocation checks against large sets */
+#define PERF_DIRECTORY_SIZE 100000
+static void perf_key_directories(void)
+{
+    static const char store_file[] = "perf-keystore.tmp";
+    static const char revoke_file[] = "perf-revocation.tmp";
+    NoiseKeyStoreBuilder *store_builder = 0;
+    NoiseRevocationBuilder *revoke_builder = 0;
+    NoiseKeyStore *store = 0;
+    NoiseRevocationSet *set = 0;
+    uint8_t keys[2][32];
+    uint8_t key[32];
+    timestamp_t start, end;
+    int count, index;
+
+    /* Build a key store and a revocation set with the same keys */
+    noise_keystore_builder_new(&store_builder, sizeof(key), 32);
+    noise_revocation_builder_new(&revoke_builder);
+    for (count = 0; count < PERF_DIRECTORY_SIZE; ++count) {
+        noise_randstate_generate_simple(key, sizeof(key));
+        noise_keystore_builder_add
+            (store_builder, key, sizeof(key), key, sizeof(key), "id", 2);
+        noise_revocation_builder_add_key(revoke_builder, key, sizeof(key));
+    }
+    memcpy(keys[0], key, sizeof(key));
+    noise_randstate_generate_simple(keys[1], sizeof(keys[1]));
+    noise_keystore_builder_save(store_builder, store_file);
+    noise_revocation_builder_save(revoke_builder, revoke_file);
+    noise_keystore_builder_free(store_builder);
+    noise_revocation_builder_free(revoke_builder);
+    if (noise_keystore_open(&store, store_file) != NOISE_ERROR_NONE ||
+            noise_revocation_open(&set, revoke_file) != NOISE_ERROR_NONE) {
+        noise_keystore_close(store);
+        remove(store_file);
+        remove(revoke_file);
+        return;
+    }
+
+    /* Time lookups for keys that are present and keys that are absent */
+    for (index = 0; index < 2; ++index) {
+        start = current_timestamp();
+        for (count = 0; count < PROTOBUF_COUNT; ++count)
+            noise_keystore_lookup(store, keys[index], sizeof(key), 0);
+        end = current_timestamp();
+        report_primitive(index ? "Key store miss" : "Key store hit",
+                         elapsed_to_seconds(start, end) / (double)PROTOBUF_COUNT);
+    }
+    for (index = 0; index < 2; ++index) {
+        start = current_timestamp();
+        for (count = 0; count < PROTOBUF_COUNT; ++count)
+            noise_revocation_check_key(set, keys[index], sizeof(key));
+        end = current_timestamp();
+        report_primitive(index ? "Revocation check" : "Revocation revoked",
+                         elapsed_to_seconds(start, end) / (double)PROTOBUF_COUNT);
+    }
+
+    noise_keystore_close(store);
+    noise_revocation_close(set);
+    remove(store_file);
+    remove(revoke_file);
+}
+
+/* Measure the cost of encrypting a single transport message of a given
+   size, returning the time in seconds and the cycle count per message */
+static void perf_cipher_size(NoiseCipherState *cipher, uint8_t *data,
+                             size_t size, double *elapsed, double *cycles)
+{
+    static uint8_t const ad[32] = {0};
+    NoiseBuffer mbuf;
+    timestamp_t start, end;
+    uint64_t start_cycles, end_cycles;
+    long count = 0;
+    int batch;
+    start_cycles = cpucycles();
+    start = current_timestamp();
+    do {
+        /* Read the clock once per batch so that the cost of reading it
+           does not swamp the cost of encrypting small messages */
+        for (batch = 0; batch < SWEEP_BATCH; ++batch) {
+            noise_buffer_set_inout(mbuf, data, size, size + MAX_MAC_LEN);
+            noise_cipherstate_encrypt_with_ad(cipher, ad, sizeof(ad), &mbuf);
+        }
+        count += SWEEP_BATCH;
+        end = current_timestamp();
+    } while (elapsed_to_seconds(start, end) < min_time);
+    end_cycles = cpucycles();
+    *elapsed = elapsed_to_seconds(start, end) / (double)count;
+    *cycles = (double)(end_cycles - start_cycles) / (double)count;
+}
+
+/* Sweep the transport message size for all ciphers from 16 bytes up to
+   the largest payload that fits in a Noise message with its MAC */
+static void perf_cipher_sweep(void)
+{
+    static uint8_t const key[32] = {
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+        0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10,
+        0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18,
+        0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20
+    };
+    static uint8_t data[NOISE_MAX_PAYLOAD_LEN];
+    NoiseCipherState *cipher;
+    const char *name;
+    size_t size, max_size;
+    double elapsed, cycles;
+    int id;
+
+    print_header("\nCipher            Size       MB/sec   cycles/byte");
+    memset(data, 0xAA, sizeof(data));
+    for (id = NOISE_ID('C', 1); id < NOISE_ID('C', 16); ++id) {
+        name = noise_id_to_name(NOISE_CIPHER_CATEGORY, id);
+        if (!name)
+            continue;
+        if (noise_cipherstate_new_by_id(&cipher, id) != NOISE_ERROR_NONE)
+            continue;
+        noise_cipherstate_init_key(cipher, key, sizeof(key));
+        max_size = NOISE_MAX_PAYLOAD_LEN - noise_cipherstate_get_mac_length(cipher);
+        for (size = MIN_SWEEP_LEN; size <= MAX_SWEEP_LEN; size *= 2) {
+            if (size > max_size)
+                size = max_size;
+            perf_cipher_size(cipher, data, size, &elapsed, &cycles);
+            if (json_output) {
+                json_start_object();
+                printf("\"type\": \"sweep\", \"cipher\": \"%s\", "
+                       "\"size\": %lu, \"mb_per_sec\": %.2f, ",
+                       name, (unsigned long)size,
+                       size / (elapsed * 1048576.0));
+                if (HAVE_CPUCYCLES)
+                    printf("\"cycles_per_byte\": %.2f}", cycles / size);
+                else
+                    printf("\"cycles_per_byte\": null}");
+            } else {
+                printf("%-14s%8lu%13.2f", name, (unsigned long)size,
+                       size / (elapsed * 1048576.0));
+                if (HAVE_CPUCYCLES)
+                    printf("%14.2f\n", cycles / size);
+                else
+                    printf("%14s\n", "-");
+            }
+            if (size == max_size)
+                break;
+        }
+        noise_cipherstate_free(cipher);
+    }
+}
+
+#if defined(HAVE_LIBPTHREAD)
+
+/* State for one thread of a scaling test */
+typedef struct
+{
+    pthread_t thread;
+    const HandshakeSuite *suite;    /* Handshake to run, or NULL */
+    int cipher_id;                  /* Cipher for transport messages */
+    long count;                     /* Number of operations performed */
+    double elapsed;                 /* Wall clock time for the operations */
+
+} ScalingWorker;
+
+/* Thread entry point for a scaling test.  Each thread runs its own
+   handshakes or encrypts with its own cipher until "min_time" has elapsed */
+static void *scaling_thread(void *arg)
+{
+    static uint8_t const key[32] = {0x55};
+    ScalingWorker *worker = (ScalingWorker *)arg;
+    NoiseCipherState *cipher = 0;
+    uint8_t data[SCALING_MESSAGE_LEN + MAX_MAC_LEN];
+    NoiseBuffer mbuf;
+    timestamp_t start, end;
+
+    if (!worker->suite) {
+        if (noise_cipherstate_new_by_id(&cipher, worker->cipher_id)
+                != NOISE_ERROR_NONE)
+            return 0;
+        noise_cipherstate_init_key(cipher, key, sizeof(key));
+        memset(data, 0xAA, sizeof(data));
+    }
+    start = current_wall_timestamp();
+    do {
+        if (cipher) {
+            noise_buffer_set_inout(mbuf, data, SCALING_MESSAGE_LEN,
+                                   sizeof(data));
+            noise_cipherstate_encrypt_with_ad(cipher, NULL, 0, &mbuf);
+        } else {
+            run_handshake(worker->suite, 0);
+        }
+        ++(worker->count);
+        end = current_wall_timestamp();
+    } while (elapsed_to_seconds(start, end) < min_time);
+    worker->elapsed = elapsed_to_seconds(start, end);
+    if (cipher)
+        noise_cipherstate_free(cipher);
+    return 0;
+}
+
+/* Run a scaling test on 1..max_threads threads and report the total
+   number of operations per second across all threads */
+static void perf_scaling_run(const char *name, const HandshakeSuite *suite,
+                             int cipher_id)
+{
+    ScalingWorker workers[MAX_THREADS];
+    double rate, base_rate = 0.0;
+    int num_threads, index, started;
+
+    for (num_threads = 1; num_threads <= max_threads; ++num_threads) {
+        memset(workers, 0, sizeof(workers));
+        for (started = 0; started < num_threads; ++started) {
+            workers[started].suite = suite;
+            workers[started].cipher_id = cipher_id;
+            if (pthread_create(&(workers[started].thread), NULL,
+                               scaling_thread, &(workers[started])) != 0)
+                break;
+        }
+        rate = 0.0;
+        for (index = 0; index < started; ++index) {
+            pthread_join(workers[index].thread, NULL);
+            if (workers[index].elapsed > 0.0)
+                rate += workers[index].count / workers[index].elapsed;
+        }
+        if (started < num_threads) {
+            fprintf(stderr, "%s: could not create %d threads\n",
+                    name, num_threads);
+            break;
+        }
+        if (num_threads == 1)
+            base_rate = rate;
+        if (json_output) {
+            json_start_object();
+            printf("\"type\": \"scaling\", \"name\": \"%s\", "
+                   "\"threads\": %d, \"ops_per_sec\": %.2f, "
+                   "\"speedup\": %.2f}", name, num_threads, rate,
+                   base_rate > 0.0 ? rate / base_rate : 0.0);
+        } else {
+            printf("%-44s%8d%12.1f%9.2f\n", name, num_threads, rate,
+                   base_rate > 0.0 ? rate / base_rate : 0.0);
+        }
+    }
+}
+
+/* Measure how the handshake and transport benchmarks scale with threads */
+static void perf_scaling(void)
+{
+    HandshakeSuite suite;
+    NoiseProtocolId id;
+    char name[64];
+    const char *protocol = SCALING_PROTOCOL;
+    int cipher_id;
+
+    print_header("\nScaling test                                 "
+                 "threads     ops/sec  speedup");
+
+    /* Handshakes for the default protocol or the one named by --filter */
+    if (filter && noise_protocol_name_to_id(&id, filter, strlen(filter))
+                        == NOISE_ERROR_NONE)
+        protocol = filter;
+    if (noise_protocol_name_to_id(&id, protocol, strlen(protocol))
+                == NOISE_ERROR_NONE && setup_suite(&suite, &id) &&
+            run_handshake(&suite, 1) == NOISE_ERROR_NONE) {
+        perf_scaling_run(suite.name, &suite, 0);
+    }
+
+    /* Transport messages of a typical RPC size for all ciphers */
+    for (cipher_id = NOISE_ID('C', 1); cipher_id < NOISE_ID('C', 16);
+            ++cipher_id) {
+        if (!noise_id_to_name(NOISE_CIPHER_CATEGORY, cipher_id))
+            continue;
+        snprintf(name, sizeof(name), "%s %d byte messages",
+                 noise_id_to_name(NOISE_CIPHER_CATEGORY, cipher_id),
+                 SCALING_MESSAGE_LEN);
+        perf_scaling_run(name, 0, cipher_id);
+    }
+    free_static_keys();
+}
+
+#endif /* HAVE_LIBPTHREAD */
+
+/* Returns the number of bytes currently allocated from the heap and the
+   secure memory slabs, or zero if this cannot be determined */
+static size_t memory_in_use(void)
+{
+    NoiseSecMemStats stats;
+    size_t size = 0;
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+    size = info.uordblks + info.hblkhd;
+#endif
+    if (noise_secmem_get_stats(&stats) == NOISE_ERROR_NONE)
+        size += stats.slab_bytes;
+    return size;
+}
+
+/* Reports the memory and message cost of one session layout */
+static void report_sessions(const char *cipher, const char *layout,
+                            size_t object_bytes, size_t memory_bytes,
+                            double elapsed)
+{
+    double per_session = (double)object_bytes / session_count;
+    double heap_per_session = (double)memory_bytes / session_count;
+    if (json_output) {
+        json_start_object();
+        printf("\"type\": \"sessions\", \"cipher\": \"%s\", "
+               "\"layout\": \"%s\", \"sessions\": %ld, "
+               "\"bytes_per_session\": %.1f, ",
+               cipher, layout, session_count, per_session);
+        if (memory_bytes)
+            printf("\"heap_bytes_per_session\": %.1f, ", heap_per_session);
+        else
+            printf("\"heap_bytes_per_session\": null, ");
+        printf("\"ns_per_message\": %.1f}", elapsed * 1e9);
+    } else {
+        printf("%-11s%-9s%12.1f", cipher, layout, per_session);
+        if (memory_bytes)
+            printf("%14.1f", heap_per_session);
+        else
+            printf("%14s", "-");
+        printf("%13.1f\n", elapsed * 1e9);
+    }
+}
+
+/* Measure the memory held by a large number of idle transport sessions,
+   as a pair of full CipherState objects or as one CompactSession each,
+   and the cost of encrypting a message on a session chosen at random */
+static void perf_sessions_for_cipher(int cipher_id)
+{
+    static uint8_t const key1[32] = {
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+        0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10,
+        0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18,
+        0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20
+    };
+    static uint8_t const key2[32] = {
+        0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8,
+        0xA9, 0xAA, 0xAB, 0xAC, 0xAD, 0xAE, 0xAF, 0xB0,
+        0xB1, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8,
+        0xB9, 0xBA, 0xBB, 0xBC, 0xBD, 0xBE, 0xBF, 0xC0
+    };
+    const char *name = noise_id_to_name(NOISE_CIPHER_CATEGORY, cipher_id);
+    NoiseCipherState **full;
+    NoiseCompactSession **compact;
+    NoiseCipherState *work;
+    uint8_t data[SESSION_MESSAGE_LEN + MAX_MAC_LEN];
+    NoiseBuffer mbuf;
+    timestamp_t start, end;
+    size_t before, full_memory, compact_memory;
+    size_t full_bytes = 0;
+    double full_elapsed, compact_elapsed;
+    uint32_t posn;
+    long count;
+    long index;
+
+    if (!name)
+        return;
+    full = (NoiseCipherState **)calloc(session_count * 2, sizeof(*full));
+    compact = (NoiseCompactSession **)calloc(session_count, sizeof(*compact));
+    if (!full || !compact) {
+        free(full);
+        free(compact);
+        return;
+    }
+    memset(data, 0xAA, sizeof(data));
+
+    /* Both layouts are allocated before either is freed so that the
+       memory measurement does not reuse blocks from the other layout */
+    before = memory_in_use();
+    for (index = 0; index < session_count * 2; ++index) {
+        if (noise_cipherstate_new_by_id(&(full[index]), cipher_id)
+                != NOISE_ERROR_NONE)
+            goto cleanup;
+        noise_cipherstate_init_key
+            (full[index], (index & 1) ? key2 : key1, sizeof(key1));
+        full_bytes += full[index]->size;
+    }
+    full_memory = memory_in_use();
+    full_memory = (before && full_memory > before) ? full_memory - before : 0;
+    before = memory_in_use();
+    for (index = 0; index < session_count; ++index) {
+        if (noise_compactsession_new(&(compact[index]), cipher_id,
+                                     key1, key2, sizeof(key1))
+                != NOISE_ERROR_NONE)
+            goto cleanup;
+    }
+    compact_memory = memory_in_use();
+    compact_memory = (before && compact_memory > before)
+                   ? compact_memory - before : 0;
+
+    /* Encrypt messages on sessions chosen by a simple LCG so that the
+       session state is usually not in the CPU cache, as for a server */
+    posn = 1;
+    count = 0;
+    start = current_timestamp();
+    do {
+        for (index = 0; index < 1000; ++index) {
+            posn = posn * 1103515245 + 12345;
+            noise_buffer_set_inout(mbuf, data, SESSION_MESSAGE_LEN, sizeof(data));
+            noise_cipherstate_encrypt
+                (full[((posn >> 8) % session_count) * 2], &mbuf);
+        }
+        count += 1000;
+        end = current_timestamp();
+    } while (elapsed_to_seconds(start, end) < min_time);
+    full_elapsed = elapsed_to_seconds(start, end) / (double)count;
+
+    noise_cipherstate_new_by_id(&work, cipher_id);
+    posn = 1;
+    count = 0;
+    start = current_timestamp();
+    do {
+        for (index = 0; index < 1000; ++index) {
+            posn = posn * 1103515245 + 12345;
+            noise_buffer_set_inout(mbuf, data, SESSION_MESSAGE_LEN, sizeof(data));
+            noise_compactsession_encrypt
+                (compact[(posn >> 8) % session_count], work, &mbuf);
+        }
+        count += 1000;
+        end = current_timestamp();
+    } while (elapsed_to_seconds(start, end) < min_time);
+    compact_elapsed = elapsed_to_seconds(start, end) / (double)count;
+    noise_cipherstate_free(work);
+
+    report_sessions(name, "full", full_bytes, full_memory, full_elapsed);
+    report_sessions(name, "compact",
+                    noise_compactsession_get_size() * session_count,
+                    compact_memory, compact_elapsed);
+
+cleanup:
+    for (index = 0; index < session_count * 2; ++index) {
+        if (full[index])
+            noise_cipherstate_free(full[index]);
+    }
+    for (index = 0; index < session_count; ++index) {
+        if (compact[index])
+            noise_compactsession_free(compact[index]);
+    }
+    free(full);
+    free(compact);
+}
+
+/* Measure the per-session cost of idle transport sessions for all ciphers */
+static void perf_sessions(void)
+{
+    int cipher_id;
+    if (!json_output) {
+        printf("\n%ld sessions, %d byte messages\n",
+               session_count, SESSION_MESSAGE_LEN);
+        printf("Cipher     Layout    bytes/session  heap/session   ns/message\n");
+    }
+    for (cipher_id = NOISE_ID('C', 1); cipher_id < NOISE_ID('C', 16);
+            ++cipher_id) {
+        perf_sessions_for_cipher(cipher_id);
+    }
+}
+
+/* Print usage information */
+static void usage(const char *progname)
+{
+    fprintf(stderr, "Usage: %s [options]\n\n", progname);
+    fprintf(stderr, "Options:\n\n");
+    fprintf(stderr, "    --primitives, -p\n");
+    fprintf(stderr, "        Only measure the cryptographic primitives.\n\n");
+    fprintf(stderr, "    --handshakes, -h\n");
+    fprintf(stderr, "        Only measure complete handshakes.\n\n");
+    fprintf(stderr, "    --sweep, -s\n");
+    fprintf(stderr, "        Measure cycles/byte for transport messages from %d to %d bytes.\n\n", MIN_SWEEP_LEN, MAX_SWEEP_LEN);
+    fprintf(stderr, "    --protobufs, -P\n");
+    fprintf(stderr, "        Measure serializing and parsing certificates and private keys,\n");
+    fprintf(stderr, "        verifying certificate chains, and looking up keys in key\n");
+    fprintf(stderr, "        stores and revocation sets.\n\n");
+    fprintf(stderr, "    --threads=N, -T N\n");
+    fprintf(stderr, "        Measure handshake and transport scaling on 1..N threads.\n\n");
+    fprintf(stderr, "    --sessions=N, -S N\n");
+    fprintf(stderr, "        Measure the memory per session and the cost per message for\n");
+    fprintf(stderr, "        N idle transport sessions, as full CipherState objects and\n");
+    fprintf(stderr, "        as compact sessions.\n\n");
+    fprintf(stderr, "    --json, -j\n");
+    fprintf(stderr, "        Output the results as a JSON array.\n\n");
+    fprintf(stderr, "    --filter=substring, -f substring\n");
+    fprintf(stderr, "        Only run handshakes whose protocol name contains substring.\n");
+    fprintf(stderr, "        For --threads, a full protocol name selects the handshake.\n\n");
+    fprintf(stderr, "    --time=seconds, -t seconds\n");
+    fprintf(stderr, "        Minimum time to run each timed test, default 0.05.\n\n");
+    fprintf(stderr, "    --secure-memory, -m\n");
+    fprintf(stderr, "        Allocate objects from the secure memory allocator.\n\n");
+}
+
+/* Parse the command-line options */
+static int parse_options(int argc, char *argv[])
+{
+    const char *progname = argv[0];
+    int only_primitives = 0;
+    int only_handshakes = 0;
+    int only_sweep = 0;
+    int only_protobufs = 0;
+    int index = 0;
+    int ch;
+    while ((ch = getopt_long(argc, argv, short_options,
+                             long_options, &index)) != -1) {
+        switch (ch) {
+        case 'p':   only_primitives = 1; break;
+        case 'h':   only_handshakes = 1; break;
+        case 's':   only_sweep = 1; break;
+        case 'P':   only_protobufs = 1; break;
+        case 'T':
+            max_threads = atoi(optarg);
+            if (max_threads < 1 || max_threads > MAX_THREADS) {
+                usage(progname);
+                return 0;
+            }
+#if !defined(HAVE_LIBPTHREAD)
+            fprintf(stderr, "%s: threads are not supported on this platform\n",
+                    progname);
+            return 0;
+#endif
+            break;
+        case 'S':
+            session_count = atol(optarg);
+            if (session_count < 1) {
+                usage(progname);
+                return 0;
+            }
+            break;
+        case 'j':   json_output = 1; break;
+        case 'f':   filter = optarg; break;
+        case 'm':
+            if (noise_secmem_init(0, NOISE_SECMEM_DEFAULT) != NOISE_ERROR_NONE) {
+                fprintf(stderr, "%s: secure memory is not supported on this platform\n",
+                        progname);
+                return 0;
+            }
+            break;
+        case 't':
+            min_time = atof(optarg);
+            if (min_time <= 0.0) {
+                usage(progname);
+                return 0;
+            }
+            break;
+        default:
+            usage(progname);
+            return 0;
+        }
+    }
+    if (optind < argc) {
+        usage(progname);
+        return 0;
+    }
+    if (only_primitives || only_handshakes || only_sweep ||
+            only_protobufs || max_threads || session_count) {
+        run_primitives = only_primitives;
+        run_handshakes = only_handshakes;
+        run_sweep = only_sweep;
+        run_protobufs = only_protobufs;
+    }
+    return 1;
+}
+
 int main(int argc, char *argv[])
 {
-    /* Print the header */
-    printf("Algorithm             MB/sec         MD5 units\n");
+    /* Parse the command-line options */
+    if (!parse_options(argc, argv))
+        return 1;
 
     /* Calibrate the performance measurements */
     calibrate_md5();
-    printf("%-20s%8.2f          %8.2f\n", "MD5 calibration", 1.0 / units, 1.0);
-
-    /* Measure the performance of the hashing primitives */
-    perf_hash(NOISE_HASH_BLAKE2s);
-    perf_hash(NOISE_HASH_BLAKE2b);
-    perf_hash(NOISE_HASH_SHA256);
-    perf_hash(NOISE_HASH_SHA512);
-
-    /* Measure the performance of the AEAD primitives */
-    perf_cipher(NOISE_CIPHER_CHACHAPOLY);
-    perf_cipher(NOISE_CIPHER_AESGCM);
-
-    /* Measure the performance of the DH primitives */
-    printf("\n");
-    printf("Pubkey algorithm     ops/sec         MD5 units\n");
-    perf_dh_derive(NOISE_DH_CURVE25519);
-    perf_dh_derive(NOISE_DH_CURVE448);
-    perf_dh_calculate(NOISE_DH_CURVE25519);
-    perf_dh_calculate(NOISE_DH_CURVE448);
-    perf_dh_ephemeral_only(NOISE_DH_NEWHOPE);
-
-    /* Measure the performance of the signing primitives */
-    perf_sign_derive(NOISE_SIGN_ED25519);
-    perf_sign_sign(NOISE_SIGN_ED25519);
-    perf_sign_verify(NOISE_SIGN_ED25519);
+
+    if (run_primitives) {
+        /* Print the header */
+        print_header("Algorithm             MB/sec         MD5 units");
+        report_primitive("MD5 calibration", units);
+
+        /* Measure the performance of the hashing primitives */
+        perf_hash(NOISE_HASH_BLAKE2s);
+        perf_hash(NOISE_HASH_BLAKE2b);
+        perf_hash(NOISE_HASH_SHA256);
+        perf_hash(NOISE_HASH_SHA512);
+
+        /* Measure the performance of the AEAD primitives */
+        perf_cipher(NOISE_CIPHER_CHACHAPOLY);
+        perf_cipher(NOISE_CIPHER_AESGCM);
+
+        /* Measure the performance of the DH primitives */
+        print_header("\nPubkey algorithm     ops/sec         MD5 units");
+        perf_dh_derive(NOISE_DH_CURVE25519);
+        perf_dh_derive(NOISE_DH_CURVE448);
+        perf_dh_calculate(NOISE_DH_CURVE25519);
+        perf_dh_calculate(NOISE_DH_CURVE448);
+        perf_dh_ephemeral_only(NOISE_DH_NEWHOPE);
+        perf_dh_ephemeral_only(NOISE_DH_MLKEM768);
+
+        /* Measure the performance of the signing primitives */
+        perf_sign_derive(NOISE_SIGN_ED25519);
+        perf_sign_sign(NOISE_SIGN_ED25519);
+        perf_sign_sign_expand(NOISE_SIGN_ED25519);
+        perf_sign_verify(NOISE_SIGN_ED25519);
+        perf_sign_verify_batch(NOISE_SIGN_ED25519);
+
+        /* Measure the cost of creating and destroying handshake objects */
+        print_header("\nAllocation           ops/sec         MD5 units");
+        perf_alloc("Noise_XX_25519_ChaChaPoly_BLAKE2s", "25519");
+        perf_alloc("Noise_NN_NewHope_AESGCM_SHA256", "NewHope");
+
+        /* Measure the cost of migrating sessions between processes
+           and of issuing and redeeming resumption tickets */
+        print_header("\nMigration            ops/sec         MD5 units");
+        perf_export();
+
+        /* Measure the cost of checking cookies during handshake floods */
+        print_header("\nCookies              ops/sec         MD5 units");
+        perf_cookie();
+    }
+
+    /* Measure the performance of complete handshakes */
+    if (run_handshakes)
+        perf_handshakes();
+
+    /* Sweep the transport message sizes */
+    if (run_sweep)
+        perf_cipher_sweep();
+
+    /* Measure the serialization of certificates and keys */
+    if (run_protobufs) {
+        print_header("\nProtobuf              ops/sec         MD5 units");
+        perf_protobufs();
+        perf_cert_chain();
+        perf_key_directories();
+    }
+
+    /* Measure the scaling across multiple threads */
+#if defined(HAVE_LIBPTHREAD)
+    if (max_threads)
+        perf_scaling();
+#endif
+
+    /* Measure the memory held by idle transport sessions */
+    if (session_count)
+        perf_sessions();
+
+    /* Terminate the JSON array */
+    if (json_output)
+        printf(json_count ? "\n]\n" : "[]\n");
 
     /* Done */
     return 0;
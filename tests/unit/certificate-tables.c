@@ -0,0 +1,1572 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "certificate.h"
+
+struct _Noise_Certificate {
+    uint32_t version;
+    Noise_SubjectInfo *subject;
+    Noise_Signature **signatures;
+    size_t signatures_count_;
+    size_t signatures_max_;
+    size_t size_cache_;
+};
+
+struct _Noise_CertificateChain {
+    Noise_Certificate **certs;
+    size_t certs_count_;
+    size_t certs_max_;
+    size_t size_cache_;
+};
+
+struct _Noise_SubjectInfo {
+    char *id;
+    size_t id_size_;
+    char *name;
+    size_t name_size_;
+    char *role;
+    size_t role_size_;
+    Noise_PublicKeyInfo **keys;
+    size_t keys_count_;
+    size_t keys_max_;
+    Noise_MetaInfo **meta;
+    size_t meta_count_;
+    size_t meta_max_;
+    size_t size_cache_;
+};
+
+struct _Noise_PublicKeyInfo {
+    char *algorithm;
+    size_t algorithm_size_;
+    void *key;
+    size_t key_size_;
+    size_t size_cache_;
+};
+
+struct _Noise_MetaInfo {
+    char *name;
+    size_t name_size_;
+    char *value;
+    size_t value_size_;
+    size_t size_cache_;
+};
+
+struct _Noise_Signature {
+    char *id;
+    size_t id_size_;
+    char *name;
+    size_t name_size_;
+    Noise_PublicKeyInfo *signing_key;
+    char *hash_algorithm;
+    size_t hash_algorithm_size_;
+    Noise_ExtraSignedInfo *extra_signed_info;
+    void *signature;
+    size_t signature_size_;
+    size_t size_cache_;
+};
+
+struct _Noise_ExtraSignedInfo {
+    void *nonce;
+    size_t nonce_size_;
+    char *valid_from;
+    size_t valid_from_size_;
+    char *valid_to;
+    size_t valid_to_size_;
+    Noise_MetaInfo **meta;
+    size_t meta_count_;
+    size_t meta_max_;
+    size_t size_cache_;
+};
+
+struct _Noise_EncryptedPrivateKey {
+    uint32_t version;
+    char *algorithm;
+    size_t algorithm_size_;
+    void *salt;
+    size_t salt_size_;
+    uint32_t iterations;
+    void *encrypted_data;
+    size_t encrypted_data_size_;
+    size_t size_cache_;
+};
+
+struct _Noise_PrivateKey {
+    char *id;
+    size_t id_size_;
+    char *name;
+    size_t name_size_;
+    char *role;
+    size_t role_size_;
+    Noise_PrivateKeyInfo **keys;
+    size_t keys_count_;
+    size_t keys_max_;
+    Noise_MetaInfo **meta;
+    size_t meta_count_;
+    size_t meta_max_;
+    size_t size_cache_;
+};
+
+struct _Noise_PrivateKeyInfo {
+    char *algorithm;
+    size_t algorithm_size_;
+    void *key;
+    size_t key_size_;
+    size_t size_cache_;
+};
+
+static const NoiseProtobufMessageDesc Noise_Certificate_desc;
+static const NoiseProtobufMessageDesc Noise_CertificateChain_desc;
+static const NoiseProtobufMessageDesc Noise_SubjectInfo_desc;
+static const NoiseProtobufMessageDesc Noise_PublicKeyInfo_desc;
+static const NoiseProtobufMessageDesc Noise_MetaInfo_desc;
+static const NoiseProtobufMessageDesc Noise_Signature_desc;
+static const NoiseProtobufMessageDesc Noise_ExtraSignedInfo_desc;
+static const NoiseProtobufMessageDesc Noise_EncryptedPrivateKey_desc;
+static const NoiseProtobufMessageDesc Noise_PrivateKey_desc;
+static const NoiseProtobufMessageDesc Noise_PrivateKeyInfo_desc;
+
+static const NoiseProtobufFieldDesc Noise_Certificate_fields[] = {
+    {1, NOISE_PROTOBUF_TYPE_UINT32, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_Certificate, version),
+     0, 0, 0, 0},
+    {2, NOISE_PROTOBUF_TYPE_MESSAGE, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_Certificate, subject),
+     0, 0, 0,
+     &Noise_SubjectInfo_desc},
+    {3, NOISE_PROTOBUF_TYPE_MESSAGE, NOISE_PROTOBUF_QUAL_REPEATED,
+     offsetof(Noise_Certificate, signatures),
+     0,
+     offsetof(Noise_Certificate, signatures_count_),
+     offsetof(Noise_Certificate, signatures_max_),
+     &Noise_Signature_desc},
+};
+static const NoiseProtobufMessageDesc Noise_Certificate_desc = {
+    sizeof(Noise_Certificate), offsetof(Noise_Certificate, size_cache_),
+    3, Noise_Certificate_fields
+};
+
+static const NoiseProtobufFieldDesc Noise_CertificateChain_fields[] = {
+    {8, NOISE_PROTOBUF_TYPE_MESSAGE, NOISE_PROTOBUF_QUAL_REPEATED,
+     offsetof(Noise_CertificateChain, certs),
+     0,
+     offsetof(Noise_CertificateChain, certs_count_),
+     offsetof(Noise_CertificateChain, certs_max_),
+     &Noise_Certificate_desc},
+};
+static const NoiseProtobufMessageDesc Noise_CertificateChain_desc = {
+    sizeof(Noise_CertificateChain), offsetof(Noise_CertificateChain, size_cache_),
+    1, Noise_CertificateChain_fields
+};
+
+static const NoiseProtobufFieldDesc Noise_SubjectInfo_fields[] = {
+    {1, NOISE_PROTOBUF_TYPE_STRING, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_SubjectInfo, id),
+     offsetof(Noise_SubjectInfo, id_size_), 0, 0, 0},
+    {2, NOISE_PROTOBUF_TYPE_STRING, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_SubjectInfo, name),
+     offsetof(Noise_SubjectInfo, name_size_), 0, 0, 0},
+    {3, NOISE_PROTOBUF_TYPE_STRING, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_SubjectInfo, role),
+     offsetof(Noise_SubjectInfo, role_size_), 0, 0, 0},
+    {4, NOISE_PROTOBUF_TYPE_MESSAGE, NOISE_PROTOBUF_QUAL_REPEATED,
+     offsetof(Noise_SubjectInfo, keys),
+     0,
+     offsetof(Noise_SubjectInfo, keys_count_),
+     offsetof(Noise_SubjectInfo, keys_max_),
+     &Noise_PublicKeyInfo_desc},
+    {5, NOISE_PROTOBUF_TYPE_MESSAGE, NOISE_PROTOBUF_QUAL_REPEATED,
+     offsetof(Noise_SubjectInfo, meta),
+     0,
+     offsetof(Noise_SubjectInfo, meta_count_),
+     offsetof(Noise_SubjectInfo, meta_max_),
+     &Noise_MetaInfo_desc},
+};
+static const NoiseProtobufMessageDesc Noise_SubjectInfo_desc = {
+    sizeof(Noise_SubjectInfo), offsetof(Noise_SubjectInfo, size_cache_),
+    5, Noise_SubjectInfo_fields
+};
+
+static const NoiseProtobufFieldDesc Noise_PublicKeyInfo_fields[] = {
+    {1, NOISE_PROTOBUF_TYPE_STRING, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_PublicKeyInfo, algorithm),
+     offsetof(Noise_PublicKeyInfo, algorithm_size_), 0, 0, 0},
+    {2, NOISE_PROTOBUF_TYPE_BYTES, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_PublicKeyInfo, key),
+     offsetof(Noise_PublicKeyInfo, key_size_), 0, 0, 0},
+};
+static const NoiseProtobufMessageDesc Noise_PublicKeyInfo_desc = {
+    sizeof(Noise_PublicKeyInfo), offsetof(Noise_PublicKeyInfo, size_cache_),
+    2, Noise_PublicKeyInfo_fields
+};
+
+static const NoiseProtobufFieldDesc Noise_MetaInfo_fields[] = {
+    {1, NOISE_PROTOBUF_TYPE_STRING, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_MetaInfo, name),
+     offsetof(Noise_MetaInfo, name_size_), 0, 0, 0},
+    {2, NOISE_PROTOBUF_TYPE_STRING, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_MetaInfo, value),
+     offsetof(Noise_MetaInfo, value_size_), 0, 0, 0},
+};
+static const NoiseProtobufMessageDesc Noise_MetaInfo_desc = {
+    sizeof(Noise_MetaInfo), offsetof(Noise_MetaInfo, size_cache_),
+    2, Noise_MetaInfo_fields
+};
+
+static const NoiseProtobufFieldDesc Noise_Signature_fields[] = {
+    {1, NOISE_PROTOBUF_TYPE_STRING, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_Signature, id),
+     offsetof(Noise_Signature, id_size_), 0, 0, 0},
+    {2, NOISE_PROTOBUF_TYPE_STRING, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_Signature, name),
+     offsetof(Noise_Signature, name_size_), 0, 0, 0},
+    {3, NOISE_PROTOBUF_TYPE_MESSAGE, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_Signature, signing_key),
+     0, 0, 0,
+     &Noise_PublicKeyInfo_desc},
+    {4, NOISE_PROTOBUF_TYPE_STRING, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_Signature, hash_algorithm),
+     offsetof(Noise_Signature, hash_algorithm_size_), 0, 0, 0},
+    {5, NOISE_PROTOBUF_TYPE_MESSAGE, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_Signature, extra_signed_info),
+     0, 0, 0,
+     &Noise_ExtraSignedInfo_desc},
+    {15, NOISE_PROTOBUF_TYPE_BYTES, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_Signature, signature),
+     offsetof(Noise_Signature, signature_size_), 0, 0, 0},
+};
+static const NoiseProtobufMessageDesc Noise_Signature_desc = {
+    sizeof(Noise_Signature), offsetof(Noise_Signature, size_cache_),
+    6, Noise_Signature_fields
+};
+
+static const NoiseProtobufFieldDesc Noise_ExtraSignedInfo_fields[] = {
+    {1, NOISE_PROTOBUF_TYPE_BYTES, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_ExtraSignedInfo, nonce),
+     offsetof(Noise_ExtraSignedInfo, nonce_size_), 0, 0, 0},
+    {2, NOISE_PROTOBUF_TYPE_STRING, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_ExtraSignedInfo, valid_from),
+     offsetof(Noise_ExtraSignedInfo, valid_from_size_), 0, 0, 0},
+    {3, NOISE_PROTOBUF_TYPE_STRING, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_ExtraSignedInfo, valid_to),
+     offsetof(Noise_ExtraSignedInfo, valid_to_size_), 0, 0, 0},
+    {4, NOISE_PROTOBUF_TYPE_MESSAGE, NOISE_PROTOBUF_QUAL_REPEATED,
+     offsetof(Noise_ExtraSignedInfo, meta),
+     0,
+     offsetof(Noise_ExtraSignedInfo, meta_count_),
+     offsetof(Noise_ExtraSignedInfo, meta_max_),
+     &Noise_MetaInfo_desc},
+};
+static const NoiseProtobufMessageDesc Noise_ExtraSignedInfo_desc = {
+    sizeof(Noise_ExtraSignedInfo), offsetof(Noise_ExtraSignedInfo, size_cache_),
+    4, Noise_ExtraSignedInfo_fields
+};
+
+static const NoiseProtobufFieldDesc Noise_EncryptedPrivateKey_fields[] = {
+    {10, NOISE_PROTOBUF_TYPE_UINT32, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_EncryptedPrivateKey, version),
+     0, 0, 0, 0},
+    {11, NOISE_PROTOBUF_TYPE_STRING, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_EncryptedPrivateKey, algorithm),
+     offsetof(Noise_EncryptedPrivateKey, algorithm_size_), 0, 0, 0},
+    {12, NOISE_PROTOBUF_TYPE_BYTES, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_EncryptedPrivateKey, salt),
+     offsetof(Noise_EncryptedPrivateKey, salt_size_), 0, 0, 0},
+    {13, NOISE_PROTOBUF_TYPE_UINT32, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_EncryptedPrivateKey, iterations),
+     0, 0, 0, 0},
+    {15, NOISE_PROTOBUF_TYPE_BYTES, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_EncryptedPrivateKey, encrypted_data),
+     offsetof(Noise_EncryptedPrivateKey, encrypted_data_size_), 0, 0, 0},
+};
+static const NoiseProtobufMessageDesc Noise_EncryptedPrivateKey_desc = {
+    sizeof(Noise_EncryptedPrivateKey), offsetof(Noise_EncryptedPrivateKey, size_cache_),
+    5, Noise_EncryptedPrivateKey_fields
+};
+
+static const NoiseProtobufFieldDesc Noise_PrivateKey_fields[] = {
+    {1, NOISE_PROTOBUF_TYPE_STRING, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_PrivateKey, id),
+     offsetof(Noise_PrivateKey, id_size_), 0, 0, 0},
+    {2, NOISE_PROTOBUF_TYPE_STRING, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_PrivateKey, name),
+     offsetof(Noise_PrivateKey, name_size_), 0, 0, 0},
+    {3, NOISE_PROTOBUF_TYPE_STRING, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_PrivateKey, role),
+     offsetof(Noise_PrivateKey, role_size_), 0, 0, 0},
+    {4, NOISE_PROTOBUF_TYPE_MESSAGE, NOISE_PROTOBUF_QUAL_REPEATED,
+     offsetof(Noise_PrivateKey, keys),
+     0,
+     offsetof(Noise_PrivateKey, keys_count_),
+     offsetof(Noise_PrivateKey, keys_max_),
+     &Noise_PrivateKeyInfo_desc},
+    {5, NOISE_PROTOBUF_TYPE_MESSAGE, NOISE_PROTOBUF_QUAL_REPEATED,
+     offsetof(Noise_PrivateKey, meta),
+     0,
+     offsetof(Noise_PrivateKey, meta_count_),
+     offsetof(Noise_PrivateKey, meta_max_),
+     &Noise_MetaInfo_desc},
+};
+static const NoiseProtobufMessageDesc Noise_PrivateKey_desc = {
+    sizeof(Noise_PrivateKey), offsetof(Noise_PrivateKey, size_cache_),
+    5, Noise_PrivateKey_fields
+};
+
+static const NoiseProtobufFieldDesc Noise_PrivateKeyInfo_fields[] = {
+    {1, NOISE_PROTOBUF_TYPE_STRING, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_PrivateKeyInfo, algorithm),
+     offsetof(Noise_PrivateKeyInfo, algorithm_size_), 0, 0, 0},
+    {2, NOISE_PROTOBUF_TYPE_BYTES, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(Noise_PrivateKeyInfo, key),
+     offsetof(Noise_PrivateKeyInfo, key_size_), 0, 0, 0},
+};
+static const NoiseProtobufMessageDesc Noise_PrivateKeyInfo_desc = {
+    sizeof(Noise_PrivateKeyInfo), offsetof(Noise_PrivateKeyInfo, size_cache_),
+    2, Noise_PrivateKeyInfo_fields
+};
+
+int Noise_Certificate_new(Noise_Certificate **obj)
+{
+    return noise_protobuf_table_new(&Noise_Certificate_desc, (void **)obj);
+}
+
+int Noise_Certificate_free(Noise_Certificate *obj)
+{
+    return noise_protobuf_table_free(&Noise_Certificate_desc, obj);
+}
+
+int Noise_Certificate_write(NoiseProtobuf *pbuf, int tag, const Noise_Certificate *obj)
+{
+    return noise_protobuf_table_write(pbuf, tag, &Noise_Certificate_desc, obj);
+}
+
+int Noise_Certificate_read(NoiseProtobuf *pbuf, int tag, Noise_Certificate **obj)
+{
+    return noise_protobuf_table_read(pbuf, tag, &Noise_Certificate_desc, (void **)obj);
+}
+
+size_t Noise_Certificate_measure(int tag, const Noise_Certificate *obj)
+{
+    return noise_protobuf_table_measure(tag, &Noise_Certificate_desc, obj);
+}
+
+int Noise_Certificate_encode(NoiseProtobuf *pbuf, int tag, const Noise_Certificate *obj)
+{
+    return noise_protobuf_table_encode(pbuf, tag, &Noise_Certificate_desc, obj);
+}
+
+int Noise_Certificate_clear_version(Noise_Certificate *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_Certificate_fields[0], obj);
+}
+
+int Noise_Certificate_has_version(const Noise_Certificate *obj)
+{
+    return obj ? (obj->version != 0) : 0;
+}
+
+uint32_t Noise_Certificate_get_version(const Noise_Certificate *obj)
+{
+    return obj ? obj->version : 0;
+}
+
+int Noise_Certificate_set_version(Noise_Certificate *obj, uint32_t value)
+{
+    if (obj) {
+        obj->version = value;
+        return NOISE_ERROR_NONE;
+    }
+    return NOISE_ERROR_INVALID_PARAM;
+}
+
+int Noise_Certificate_clear_subject(Noise_Certificate *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_Certificate_fields[1], obj);
+}
+
+int Noise_Certificate_has_subject(const Noise_Certificate *obj)
+{
+    return obj ? (obj->subject != 0) : 0;
+}
+
+Noise_SubjectInfo *Noise_Certificate_get_subject(const Noise_Certificate *obj)
+{
+    return obj ? obj->subject : 0;
+}
+
+int Noise_Certificate_get_new_subject(Noise_Certificate *obj, Noise_SubjectInfo **value)
+{
+    return noise_protobuf_table_get_new_field(&Noise_Certificate_fields[1], obj, (void **)value);
+}
+
+int Noise_Certificate_clear_signatures(Noise_Certificate *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_Certificate_fields[2], obj);
+}
+
+int Noise_Certificate_has_signatures(const Noise_Certificate *obj)
+{
+    return obj ? (obj->signatures_count_ != 0) : 0;
+}
+
+size_t Noise_Certificate_count_signatures(const Noise_Certificate *obj)
+{
+    return obj ? obj->signatures_count_ : 0;
+}
+
+Noise_Signature *Noise_Certificate_get_at_signatures(const Noise_Certificate *obj, size_t index)
+{
+    if (obj && index < obj->signatures_count_)
+        return obj->signatures[index];
+    else
+        return 0;
+}
+
+int Noise_Certificate_add_signatures(Noise_Certificate *obj, Noise_Signature **value)
+{
+    return noise_protobuf_table_add_field(&Noise_Certificate_fields[2], obj, (void **)value);
+}
+
+int Noise_Certificate_insert_signatures(Noise_Certificate *obj, size_t index, Noise_Signature *value)
+{
+    if (!obj || !value)
+        return NOISE_ERROR_INVALID_PARAM;
+    return noise_protobuf_insert_into_array((void **)&(obj->signatures), &(obj->signatures_count_), &(obj->signatures_max_), index, &value, sizeof(value));
+}
+
+int Noise_CertificateChain_new(Noise_CertificateChain **obj)
+{
+    return noise_protobuf_table_new(&Noise_CertificateChain_desc, (void **)obj);
+}
+
+int Noise_CertificateChain_free(Noise_CertificateChain *obj)
+{
+    return noise_protobuf_table_free(&Noise_CertificateChain_desc, obj);
+}
+
+int Noise_CertificateChain_write(NoiseProtobuf *pbuf, int tag, const Noise_CertificateChain *obj)
+{
+    return noise_protobuf_table_write(pbuf, tag, &Noise_CertificateChain_desc, obj);
+}
+
+int Noise_CertificateChain_read(NoiseProtobuf *pbuf, int tag, Noise_CertificateChain **obj)
+{
+    return noise_protobuf_table_read(pbuf, tag, &Noise_CertificateChain_desc, (void **)obj);
+}
+
+size_t Noise_CertificateChain_measure(int tag, const Noise_CertificateChain *obj)
+{
+    return noise_protobuf_table_measure(tag, &Noise_CertificateChain_desc, obj);
+}
+
+int Noise_CertificateChain_encode(NoiseProtobuf *pbuf, int tag, const Noise_CertificateChain *obj)
+{
+    return noise_protobuf_table_encode(pbuf, tag, &Noise_CertificateChain_desc, obj);
+}
+
+int Noise_CertificateChain_clear_certs(Noise_CertificateChain *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_CertificateChain_fields[0], obj);
+}
+
+int Noise_CertificateChain_has_certs(const Noise_CertificateChain *obj)
+{
+    return obj ? (obj->certs_count_ != 0) : 0;
+}
+
+size_t Noise_CertificateChain_count_certs(const Noise_CertificateChain *obj)
+{
+    return obj ? obj->certs_count_ : 0;
+}
+
+Noise_Certificate *Noise_CertificateChain_get_at_certs(const Noise_CertificateChain *obj, size_t index)
+{
+    if (obj && index < obj->certs_count_)
+        return obj->certs[index];
+    else
+        return 0;
+}
+
+int Noise_CertificateChain_add_certs(Noise_CertificateChain *obj, Noise_Certificate **value)
+{
+    return noise_protobuf_table_add_field(&Noise_CertificateChain_fields[0], obj, (void **)value);
+}
+
+int Noise_CertificateChain_insert_certs(Noise_CertificateChain *obj, size_t index, Noise_Certificate *value)
+{
+    if (!obj || !value)
+        return NOISE_ERROR_INVALID_PARAM;
+    return noise_protobuf_insert_into_array((void **)&(obj->certs), &(obj->certs_count_), &(obj->certs_max_), index, &value, sizeof(value));
+}
+
+int Noise_SubjectInfo_new(Noise_SubjectInfo **obj)
+{
+    return noise_protobuf_table_new(&Noise_SubjectInfo_desc, (void **)obj);
+}
+
+int Noise_SubjectInfo_free(Noise_SubjectInfo *obj)
+{
+    return noise_protobuf_table_free(&Noise_SubjectInfo_desc, obj);
+}
+
+int Noise_SubjectInfo_write(NoiseProtobuf *pbuf, int tag, const Noise_SubjectInfo *obj)
+{
+    return noise_protobuf_table_write(pbuf, tag, &Noise_SubjectInfo_desc, obj);
+}
+
+int Noise_SubjectInfo_read(NoiseProtobuf *pbuf, int tag, Noise_SubjectInfo **obj)
+{
+    return noise_protobuf_table_read(pbuf, tag, &Noise_SubjectInfo_desc, (void **)obj);
+}
+
+size_t Noise_SubjectInfo_measure(int tag, const Noise_SubjectInfo *obj)
+{
+    return noise_protobuf_table_measure(tag, &Noise_SubjectInfo_desc, obj);
+}
+
+int Noise_SubjectInfo_encode(NoiseProtobuf *pbuf, int tag, const Noise_SubjectInfo *obj)
+{
+    return noise_protobuf_table_encode(pbuf, tag, &Noise_SubjectInfo_desc, obj);
+}
+
+int Noise_SubjectInfo_clear_id(Noise_SubjectInfo *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_SubjectInfo_fields[0], obj);
+}
+
+int Noise_SubjectInfo_has_id(const Noise_SubjectInfo *obj)
+{
+    return obj ? (obj->id != 0) : 0;
+}
+
+const char *Noise_SubjectInfo_get_id(const Noise_SubjectInfo *obj)
+{
+    return obj ? obj->id : 0;
+}
+
+size_t Noise_SubjectInfo_get_size_id(const Noise_SubjectInfo *obj)
+{
+    return obj ? obj->id_size_ : 0;
+}
+
+int Noise_SubjectInfo_set_id(Noise_SubjectInfo *obj, const char *value, size_t size)
+{
+    return noise_protobuf_table_set_field(&Noise_SubjectInfo_fields[0], obj, value, size);
+}
+
+int Noise_SubjectInfo_clear_name(Noise_SubjectInfo *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_SubjectInfo_fields[1], obj);
+}
+
+int Noise_SubjectInfo_has_name(const Noise_SubjectInfo *obj)
+{
+    return obj ? (obj->name != 0) : 0;
+}
+
+const char *Noise_SubjectInfo_get_name(const Noise_SubjectInfo *obj)
+{
+    return obj ? obj->name : 0;
+}
+
+size_t Noise_SubjectInfo_get_size_name(const Noise_SubjectInfo *obj)
+{
+    return obj ? obj->name_size_ : 0;
+}
+
+int Noise_SubjectInfo_set_name(Noise_SubjectInfo *obj, const char *value, size_t size)
+{
+    return noise_protobuf_table_set_field(&Noise_SubjectInfo_fields[1], obj, value, size);
+}
+
+int Noise_SubjectInfo_clear_role(Noise_SubjectInfo *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_SubjectInfo_fields[2], obj);
+}
+
+int Noise_SubjectInfo_has_role(const Noise_SubjectInfo *obj)
+{
+    return obj ? (obj->role != 0) : 0;
+}
+
+const char *Noise_SubjectInfo_get_role(const Noise_SubjectInfo *obj)
+{
+    return obj ? obj->role : 0;
+}
+
+size_t Noise_SubjectInfo_get_size_role(const Noise_SubjectInfo *obj)
+{
+    return obj ? obj->role_size_ : 0;
+}
+
+int Noise_SubjectInfo_set_role(Noise_SubjectInfo *obj, const char *value, size_t size)
+{
+    return noise_protobuf_table_set_field(&Noise_SubjectInfo_fields[2], obj, value, size);
+}
+
+int Noise_SubjectInfo_clear_keys(Noise_SubjectInfo *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_SubjectInfo_fields[3], obj);
+}
+
+int Noise_SubjectInfo_has_keys(const Noise_SubjectInfo *obj)
+{
+    return obj ? (obj->keys_count_ != 0) : 0;
+}
+
+size_t Noise_SubjectInfo_count_keys(const Noise_SubjectInfo *obj)
+{
+    return obj ? obj->keys_count_ : 0;
+}
+
+Noise_PublicKeyInfo *Noise_SubjectInfo_get_at_keys(const Noise_SubjectInfo *obj, size_t index)
+{
+    if (obj && index < obj->keys_count_)
+        return obj->keys[index];
+    else
+        return 0;
+}
+
+int Noise_SubjectInfo_add_keys(Noise_SubjectInfo *obj, Noise_PublicKeyInfo **value)
+{
+    return noise_protobuf_table_add_field(&Noise_SubjectInfo_fields[3], obj, (void **)value);
+}
+
+int Noise_SubjectInfo_insert_keys(Noise_SubjectInfo *obj, size_t index, Noise_PublicKeyInfo *value)
+{
+    if (!obj || !value)
+        return NOISE_ERROR_INVALID_PARAM;
+    return noise_protobuf_insert_into_array((void **)&(obj->keys), &(obj->keys_count_), &(obj->keys_max_), index, &value, sizeof(value));
+}
+
+int Noise_SubjectInfo_clear_meta(Noise_SubjectInfo *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_SubjectInfo_fields[4], obj);
+}
+
+int Noise_SubjectInfo_has_meta(const Noise_SubjectInfo *obj)
+{
+    return obj ? (obj->meta_count_ != 0) : 0;
+}
+
+size_t Noise_SubjectInfo_count_meta(const Noise_SubjectInfo *obj)
+{
+    return obj ? obj->meta_count_ : 0;
+}
+
+Noise_MetaInfo *Noise_SubjectInfo_get_at_meta(const Noise_SubjectInfo *obj, size_t index)
+{
+    if (obj && index < obj->meta_count_)
+        return obj->meta[index];
+    else
+        return 0;
+}
+
+int Noise_SubjectInfo_add_meta(Noise_SubjectInfo *obj, Noise_MetaInfo **value)
+{
+    return noise_protobuf_table_add_field(&Noise_SubjectInfo_fields[4], obj, (void **)value);
+}
+
+int Noise_SubjectInfo_insert_meta(Noise_SubjectInfo *obj, size_t index, Noise_MetaInfo *value)
+{
+    if (!obj || !value)
+        return NOISE_ERROR_INVALID_PARAM;
+    return noise_protobuf_insert_into_array((void **)&(obj->meta), &(obj->meta_count_), &(obj->meta_max_), index, &value, sizeof(value));
+}
+
+int Noise_PublicKeyInfo_new(Noise_PublicKeyInfo **obj)
+{
+    return noise_protobuf_table_new(&Noise_PublicKeyInfo_desc, (void **)obj);
+}
+
+int Noise_PublicKeyInfo_free(Noise_PublicKeyInfo *obj)
+{
+    return noise_protobuf_table_free(&Noise_PublicKeyInfo_desc, obj);
+}
+
+int Noise_PublicKeyInfo_write(NoiseProtobuf *pbuf, int tag, const Noise_PublicKeyInfo *obj)
+{
+    return noise_protobuf_table_write(pbuf, tag, &Noise_PublicKeyInfo_desc, obj);
+}
+
+int Noise_PublicKeyInfo_read(NoiseProtobuf *pbuf, int tag, Noise_PublicKeyInfo **obj)
+{
+    return noise_protobuf_table_read(pbuf, tag, &Noise_PublicKeyInfo_desc, (void **)obj);
+}
+
+size_t Noise_PublicKeyInfo_measure(int tag, const Noise_PublicKeyInfo *obj)
+{
+    return noise_protobuf_table_measure(tag, &Noise_PublicKeyInfo_desc, obj);
+}
+
+int Noise_PublicKeyInfo_encode(NoiseProtobuf *pbuf, int tag, const Noise_PublicKeyInfo *obj)
+{
+    return noise_protobuf_table_encode(pbuf, tag, &Noise_PublicKeyInfo_desc, obj);
+}
+
+int Noise_PublicKeyInfo_clear_algorithm(Noise_PublicKeyInfo *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_PublicKeyInfo_fields[0], obj);
+}
+
+int Noise_PublicKeyInfo_has_algorithm(const Noise_PublicKeyInfo *obj)
+{
+    return obj ? (obj->algorithm != 0) : 0;
+}
+
+const char *Noise_PublicKeyInfo_get_algorithm(const Noise_PublicKeyInfo *obj)
+{
+    return obj ? obj->algorithm : 0;
+}
+
+size_t Noise_PublicKeyInfo_get_size_algorithm(const Noise_PublicKeyInfo *obj)
+{
+    return obj ? obj->algorithm_size_ : 0;
+}
+
+int Noise_PublicKeyInfo_set_algorithm(Noise_PublicKeyInfo *obj, const char *value, size_t size)
+{
+    return noise_protobuf_table_set_field(&Noise_PublicKeyInfo_fields[0], obj, value, size);
+}
+
+int Noise_PublicKeyInfo_clear_key(Noise_PublicKeyInfo *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_PublicKeyInfo_fields[1], obj);
+}
+
+int Noise_PublicKeyInfo_has_key(const Noise_PublicKeyInfo *obj)
+{
+    return obj ? (obj->key != 0) : 0;
+}
+
+const void *Noise_PublicKeyInfo_get_key(const Noise_PublicKeyInfo *obj)
+{
+    return obj ? obj->key : 0;
+}
+
+size_t Noise_PublicKeyInfo_get_size_key(const Noise_PublicKeyInfo *obj)
+{
+    return obj ? obj->key_size_ : 0;
+}
+
+int Noise_PublicKeyInfo_set_key(Noise_PublicKeyInfo *obj, const void *value, size_t size)
+{
+    return noise_protobuf_table_set_field(&Noise_PublicKeyInfo_fields[1], obj, value, size);
+}
+
+int Noise_MetaInfo_new(Noise_MetaInfo **obj)
+{
+    return noise_protobuf_table_new(&Noise_MetaInfo_desc, (void **)obj);
+}
+
+int Noise_MetaInfo_free(Noise_MetaInfo *obj)
+{
+    return noise_protobuf_table_free(&Noise_MetaInfo_desc, obj);
+}
+
+int Noise_MetaInfo_write(NoiseProtobuf *pbuf, int tag, const Noise_MetaInfo *obj)
+{
+    return noise_protobuf_table_write(pbuf, tag, &Noise_MetaInfo_desc, obj);
+}
+
+int Noise_MetaInfo_read(NoiseProtobuf *pbuf, int tag, Noise_MetaInfo **obj)
+{
+    return noise_protobuf_table_read(pbuf, tag, &Noise_MetaInfo_desc, (void **)obj);
+}
+
+size_t Noise_MetaInfo_measure(int tag, const Noise_MetaInfo *obj)
+{
+    return noise_protobuf_table_measure(tag, &Noise_MetaInfo_desc, obj);
+}
+
+int Noise_MetaInfo_encode(NoiseProtobuf *pbuf, int tag, const Noise_MetaInfo *obj)
+{
+    return noise_protobuf_table_encode(pbuf, tag, &Noise_MetaInfo_desc, obj);
+}
+
+int Noise_MetaInfo_clear_name(Noise_MetaInfo *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_MetaInfo_fields[0], obj);
+}
+
+int Noise_MetaInfo_has_name(const Noise_MetaInfo *obj)
+{
+    return obj ? (obj->name != 0) : 0;
+}
+
+const char *Noise_MetaInfo_get_name(const Noise_MetaInfo *obj)
+{
+    return obj ? obj->name : 0;
+}
+
+size_t Noise_MetaInfo_get_size_name(const Noise_MetaInfo *obj)
+{
+    return obj ? obj->name_size_ : 0;
+}
+
+int Noise_MetaInfo_set_name(Noise_MetaInfo *obj, const char *value, size_t size)
+{
+    return noise_protobuf_table_set_field(&Noise_MetaInfo_fields[0], obj, value, size);
+}
+
+int Noise_MetaInfo_clear_value(Noise_MetaInfo *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_MetaInfo_fields[1], obj);
+}
+
+int Noise_MetaInfo_has_value(const Noise_MetaInfo *obj)
+{
+    return obj ? (obj->value != 0) : 0;
+}
+
+const char *Noise_MetaInfo_get_value(const Noise_MetaInfo *obj)
+{
+    return obj ? obj->value : 0;
+}
+
+size_t Noise_MetaInfo_get_size_value(const Noise_MetaInfo *obj)
+{
+    return obj ? obj->value_size_ : 0;
+}
+
+int Noise_MetaInfo_set_value(Noise_MetaInfo *obj, const char *value, size_t size)
+{
+    return noise_protobuf_table_set_field(&Noise_MetaInfo_fields[1], obj, value, size);
+}
+
+int Noise_Signature_new(Noise_Signature **obj)
+{
+    return noise_protobuf_table_new(&Noise_Signature_desc, (void **)obj);
+}
+
+int Noise_Signature_free(Noise_Signature *obj)
+{
+    return noise_protobuf_table_free(&Noise_Signature_desc, obj);
+}
+
+int Noise_Signature_write(NoiseProtobuf *pbuf, int tag, const Noise_Signature *obj)
+{
+    return noise_protobuf_table_write(pbuf, tag, &Noise_Signature_desc, obj);
+}
+
+int Noise_Signature_read(NoiseProtobuf *pbuf, int tag, Noise_Signature **obj)
+{
+    return noise_protobuf_table_read(pbuf, tag, &Noise_Signature_desc, (void **)obj);
+}
+
+size_t Noise_Signature_measure(int tag, const Noise_Signature *obj)
+{
+    return noise_protobuf_table_measure(tag, &Noise_Signature_desc, obj);
+}
+
+int Noise_Signature_encode(NoiseProtobuf *pbuf, int tag, const Noise_Signature *obj)
+{
+    return noise_protobuf_table_encode(pbuf, tag, &Noise_Signature_desc, obj);
+}
+
+int Noise_Signature_clear_id(Noise_Signature *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_Signature_fields[0], obj);
+}
+
+int Noise_Signature_has_id(const Noise_Signature *obj)
+{
+    return obj ? (obj->id != 0) : 0;
+}
+
+const char *Noise_Signature_get_id(const Noise_Signature *obj)
+{
+    return obj ? obj->id : 0;
+}
+
+size_t Noise_Signature_get_size_id(const Noise_Signature *obj)
+{
+    return obj ? obj->id_size_ : 0;
+}
+
+int Noise_Signature_set_id(Noise_Signature *obj, const char *value, size_t size)
+{
+    return noise_protobuf_table_set_field(&Noise_Signature_fields[0], obj, value, size);
+}
+
+int Noise_Signature_clear_name(Noise_Signature *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_Signature_fields[1], obj);
+}
+
+int Noise_Signature_has_name(const Noise_Signature *obj)
+{
+    return obj ? (obj->name != 0) : 0;
+}
+
+const char *Noise_Signature_get_name(const Noise_Signature *obj)
+{
+    return obj ? obj->name : 0;
+}
+
+size_t Noise_Signature_get_size_name(const Noise_Signature *obj)
+{
+    return obj ? obj->name_size_ : 0;
+}
+
+int Noise_Signature_set_name(Noise_Signature *obj, const char *value, size_t size)
+{
+    return noise_protobuf_table_set_field(&Noise_Signature_fields[1], obj, value, size);
+}
+
+int Noise_Signature_clear_signing_key(Noise_Signature *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_Signature_fields[2], obj);
+}
+
+int Noise_Signature_has_signing_key(const Noise_Signature *obj)
+{
+    return obj ? (obj->signing_key != 0) : 0;
+}
+
+Noise_PublicKeyInfo *Noise_Signature_get_signing_key(const Noise_Signature *obj)
+{
+    return obj ? obj->signing_key : 0;
+}
+
+int Noise_Signature_get_new_signing_key(Noise_Signature *obj, Noise_PublicKeyInfo **value)
+{
+    return noise_protobuf_table_get_new_field(&Noise_Signature_fields[2], obj, (void **)value);
+}
+
+int Noise_Signature_clear_hash_algorithm(Noise_Signature *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_Signature_fields[3], obj);
+}
+
+int Noise_Signature_has_hash_algorithm(const Noise_Signature *obj)
+{
+    return obj ? (obj->hash_algorithm != 0) : 0;
+}
+
+const char *Noise_Signature_get_hash_algorithm(const Noise_Signature *obj)
+{
+    return obj ? obj->hash_algorithm : 0;
+}
+
+size_t Noise_Signature_get_size_hash_algorithm(const Noise_Signature *obj)
+{
+    return obj ? obj->hash_algorithm_size_ : 0;
+}
+
+int Noise_Signature_set_hash_algorithm(Noise_Signature *obj, const char *value, size_t size)
+{
+    return noise_protobuf_table_set_field(&Noise_Signature_fields[3], obj, value, size);
+}
+
+int Noise_Signature_clear_extra_signed_info(Noise_Signature *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_Signature_fields[4], obj);
+}
+
+int Noise_Signature_has_extra_signed_info(const Noise_Signature *obj)
+{
+    return obj ? (obj->extra_signed_info != 0) : 0;
+}
+
+Noise_ExtraSignedInfo *Noise_Signature_get_extra_signed_info(const Noise_Signature *obj)
+{
+    return obj ? obj->extra_signed_info : 0;
+}
+
+int Noise_Signature_get_new_extra_signed_info(Noise_Signature *obj, Noise_ExtraSignedInfo **value)
+{
+    return noise_protobuf_table_get_new_field(&Noise_Signature_fields[4], obj, (void **)value);
+}
+
+int Noise_Signature_clear_signature(Noise_Signature *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_Signature_fields[5], obj);
+}
+
+int Noise_Signature_has_signature(const Noise_Signature *obj)
+{
+    return obj ? (obj->signature != 0) : 0;
+}
+
+const void *Noise_Signature_get_signature(const Noise_Signature *obj)
+{
+    return obj ? obj->signature : 0;
+}
+
+size_t Noise_Signature_get_size_signature(const Noise_Signature *obj)
+{
+    return obj ? obj->signature_size_ : 0;
+}
+
+int Noise_Signature_set_signature(Noise_Signature *obj, const void *value, size_t size)
+{
+    return noise_protobuf_table_set_field(&Noise_Signature_fields[5], obj, value, size);
+}
+
+int Noise_ExtraSignedInfo_new(Noise_ExtraSignedInfo **obj)
+{
+    return noise_protobuf_table_new(&Noise_ExtraSignedInfo_desc, (void **)obj);
+}
+
+int Noise_ExtraSignedInfo_free(Noise_ExtraSignedInfo *obj)
+{
+    return noise_protobuf_table_free(&Noise_ExtraSignedInfo_desc, obj);
+}
+
+int Noise_ExtraSignedInfo_write(NoiseProtobuf *pbuf, int tag, const Noise_ExtraSignedInfo *obj)
+{
+    return noise_protobuf_table_write(pbuf, tag, &Noise_ExtraSignedInfo_desc, obj);
+}
+
+int Noise_ExtraSignedInfo_read(NoiseProtobuf *pbuf, int tag, Noise_ExtraSignedInfo **obj)
+{
+    return noise_protobuf_table_read(pbuf, tag, &Noise_ExtraSignedInfo_desc, (void **)obj);
+}
+
+size_t Noise_ExtraSignedInfo_measure(int tag, const Noise_ExtraSignedInfo *obj)
+{
+    return noise_protobuf_table_measure(tag, &Noise_ExtraSignedInfo_desc, obj);
+}
+
+int Noise_ExtraSignedInfo_encode(NoiseProtobuf *pbuf, int tag, const Noise_ExtraSignedInfo *obj)
+{
+    return noise_protobuf_table_encode(pbuf, tag, &Noise_ExtraSignedInfo_desc, obj);
+}
+
+int Noise_ExtraSignedInfo_clear_nonce(Noise_ExtraSignedInfo *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_ExtraSignedInfo_fields[0], obj);
+}
+
+int Noise_ExtraSignedInfo_has_nonce(const Noise_ExtraSignedInfo *obj)
+{
+    return obj ? (obj->nonce != 0) : 0;
+}
+
+const void *Noise_ExtraSignedInfo_get_nonce(const Noise_ExtraSignedInfo *obj)
+{
+    return obj ? obj->nonce : 0;
+}
+
+size_t Noise_ExtraSignedInfo_get_size_nonce(const Noise_ExtraSignedInfo *obj)
+{
+    return obj ? obj->nonce_size_ : 0;
+}
+
+int Noise_ExtraSignedInfo_set_nonce(Noise_ExtraSignedInfo *obj, const void *value, size_t size)
+{
+    return noise_protobuf_table_set_field(&Noise_ExtraSignedInfo_fields[0], obj, value, size);
+}
+
+int Noise_ExtraSignedInfo_clear_valid_from(Noise_ExtraSignedInfo *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_ExtraSignedInfo_fields[1], obj);
+}
+
+int Noise_ExtraSignedInfo_has_valid_from(const Noise_ExtraSignedInfo *obj)
+{
+    return obj ? (obj->valid_from != 0) : 0;
+}
+
+const char *Noise_ExtraSignedInfo_get_valid_from(const Noise_ExtraSignedInfo *obj)
+{
+    return obj ? obj->valid_from : 0;
+}
+
+size_t Noise_ExtraSignedInfo_get_size_valid_from(const Noise_ExtraSignedInfo *obj)
+{
+    return obj ? obj->valid_from_size_ : 0;
+}
+
+int Noise_ExtraSignedInfo_set_valid_from(Noise_ExtraSignedInfo *obj, const char *value, size_t size)
+{
+    return noise_protobuf_table_set_field(&Noise_ExtraSignedInfo_fields[1], obj, value, size);
+}
+
+int Noise_ExtraSignedInfo_clear_valid_to(Noise_ExtraSignedInfo *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_ExtraSignedInfo_fields[2], obj);
+}
+
+int Noise_ExtraSignedInfo_has_valid_to(const Noise_ExtraSignedInfo *obj)
+{
+    return obj ? (obj->valid_to != 0) : 0;
+}
+
+const char *Noise_ExtraSignedInfo_get_valid_to(const Noise_ExtraSignedInfo *obj)
+{
+    return obj ? obj->valid_to : 0;
+}
+
+size_t Noise_ExtraSignedInfo_get_size_valid_to(const Noise_ExtraSignedInfo *obj)
+{
+    return obj ? obj->valid_to_size_ : 0;
+}
+
+int Noise_ExtraSignedInfo_set_valid_to(Noise_ExtraSignedInfo *obj, const char *value, size_t size)
+{
+    return noise_protobuf_table_set_field(&Noise_ExtraSignedInfo_fields[2], obj, value, size);
+}
+
+int Noise_ExtraSignedInfo_clear_meta(Noise_ExtraSignedInfo *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_ExtraSignedInfo_fields[3], obj);
+}
+
+int Noise_ExtraSignedInfo_has_meta(const Noise_ExtraSignedInfo *obj)
+{
+    return obj ? (obj->meta_count_ != 0) : 0;
+}
+
+size_t Noise_ExtraSignedInfo_count_meta(const Noise_ExtraSignedInfo *obj)
+{
+    return obj ? obj->meta_count_ : 0;
+}
+
+Noise_MetaInfo *Noise_ExtraSignedInfo_get_at_meta(const Noise_ExtraSignedInfo *obj, size_t index)
+{
+    if (obj && index < obj->meta_count_)
+        return obj->meta[index];
+    else
+        return 0;
+}
+
+int Noise_ExtraSignedInfo_add_meta(Noise_ExtraSignedInfo *obj, Noise_MetaInfo **value)
+{
+    return noise_protobuf_table_add_field(&Noise_ExtraSignedInfo_fields[3], obj, (void **)value);
+}
+
+int Noise_ExtraSignedInfo_insert_meta(Noise_ExtraSignedInfo *obj, size_t index, Noise_MetaInfo *value)
+{
+    if (!obj || !value)
+        return NOISE_ERROR_INVALID_PARAM;
+    return noise_protobuf_insert_into_array((void **)&(obj->meta), &(obj->meta_count_), &(obj->meta_max_), index, &value, sizeof(value));
+}
+
+int Noise_EncryptedPrivateKey_new(Noise_EncryptedPrivateKey **obj)
+{
+    return noise_protobuf_table_new(&Noise_EncryptedPrivateKey_desc, (void **)obj);
+}
+
+int Noise_EncryptedPrivateKey_free(Noise_EncryptedPrivateKey *obj)
+{
+    return noise_protobuf_table_free(&Noise_EncryptedPrivateKey_desc, obj);
+}
+
+int Noise_EncryptedPrivateKey_write(NoiseProtobuf *pbuf, int tag, const Noise_EncryptedPrivateKey *obj)
+{
+    return noise_protobuf_table_write(pbuf, tag, &Noise_EncryptedPrivateKey_desc, obj);
+}
+
+int Noise_EncryptedPrivateKey_read(NoiseProtobuf *pbuf, int tag, Noise_EncryptedPrivateKey **obj)
+{
+    return noise_protobuf_table_read(pbuf, tag, &Noise_EncryptedPrivateKey_desc, (void **)obj);
+}
+
+size_t Noise_EncryptedPrivateKey_measure(int tag, const Noise_EncryptedPrivateKey *obj)
+{
+    return noise_protobuf_table_measure(tag, &Noise_EncryptedPrivateKey_desc, obj);
+}
+
+int Noise_EncryptedPrivateKey_encode(NoiseProtobuf *pbuf, int tag, const Noise_EncryptedPrivateKey *obj)
+{
+    return noise_protobuf_table_encode(pbuf, tag, &Noise_EncryptedPrivateKey_desc, obj);
+}
+
+int Noise_EncryptedPrivateKey_clear_version(Noise_EncryptedPrivateKey *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_EncryptedPrivateKey_fields[0], obj);
+}
+
+int Noise_EncryptedPrivateKey_has_version(const Noise_EncryptedPrivateKey *obj)
+{
+    return obj ? (obj->version != 0) : 0;
+}
+
+uint32_t Noise_EncryptedPrivateKey_get_version(const Noise_EncryptedPrivateKey *obj)
+{
+    return obj ? obj->version : 0;
+}
+
+int Noise_EncryptedPrivateKey_set_version(Noise_EncryptedPrivateKey *obj, uint32_t value)
+{
+    if (obj) {
+        obj->version = value;
+        return NOISE_ERROR_NONE;
+    }
+    return NOISE_ERROR_INVALID_PARAM;
+}
+
+int Noise_EncryptedPrivateKey_clear_algorithm(Noise_EncryptedPrivateKey *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_EncryptedPrivateKey_fields[1], obj);
+}
+
+int Noise_EncryptedPrivateKey_has_algorithm(const Noise_EncryptedPrivateKey *obj)
+{
+    return obj ? (obj->algorithm != 0) : 0;
+}
+
+const char *Noise_EncryptedPrivateKey_get_algorithm(const Noise_EncryptedPrivateKey *obj)
+{
+    return obj ? obj->algorithm : 0;
+}
+
+size_t Noise_EncryptedPrivateKey_get_size_algorithm(const Noise_EncryptedPrivateKey *obj)
+{
+    return obj ? obj->algorithm_size_ : 0;
+}
+
+int Noise_EncryptedPrivateKey_set_algorithm(Noise_EncryptedPrivateKey *obj, const char *value, size_t size)
+{
+    return noise_protobuf_table_set_field(&Noise_EncryptedPrivateKey_fields[1], obj, value, size);
+}
+
+int Noise_EncryptedPrivateKey_clear_salt(Noise_EncryptedPrivateKey *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_EncryptedPrivateKey_fields[2], obj);
+}
+
+int Noise_EncryptedPrivateKey_has_salt(const Noise_EncryptedPrivateKey *obj)
+{
+    return obj ? (obj->salt != 0) : 0;
+}
+
+const void *Noise_EncryptedPrivateKey_get_salt(const Noise_EncryptedPrivateKey *obj)
+{
+    return obj ? obj->salt : 0;
+}
+
+size_t Noise_EncryptedPrivateKey_get_size_salt(const Noise_EncryptedPrivateKey *obj)
+{
+    return obj ? obj->salt_size_ : 0;
+}
+
+int Noise_EncryptedPrivateKey_set_salt(Noise_EncryptedPrivateKey *obj, const void *value, size_t size)
+{
+    return noise_protobuf_table_set_field(&Noise_EncryptedPrivateKey_fields[2], obj, value, size);
+}
+
+int Noise_EncryptedPrivateKey_clear_iterations(Noise_EncryptedPrivateKey *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_EncryptedPrivateKey_fields[3], obj);
+}
+
+int Noise_EncryptedPrivateKey_has_iterations(const Noise_EncryptedPrivateKey *obj)
+{
+    return obj ? (obj->iterations != 0) : 0;
+}
+
+uint32_t Noise_EncryptedPrivateKey_get_iterations(const Noise_EncryptedPrivateKey *obj)
+{
+    return obj ? obj->iterations : 0;
+}
+
+int Noise_EncryptedPrivateKey_set_iterations(Noise_EncryptedPrivateKey *obj, uint32_t value)
+{
+    if (obj) {
+        obj->iterations = value;
+        return NOISE_ERROR_NONE;
+    }
+    return NOISE_ERROR_INVALID_PARAM;
+}
+
+int Noise_EncryptedPrivateKey_clear_encrypted_data(Noise_EncryptedPrivateKey *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_EncryptedPrivateKey_fields[4], obj);
+}
+
+int Noise_EncryptedPrivateKey_has_encrypted_data(const Noise_EncryptedPrivateKey *obj)
+{
+    return obj ? (obj->encrypted_data != 0) : 0;
+}
+
+const void *Noise_EncryptedPrivateKey_get_encrypted_data(const Noise_EncryptedPrivateKey *obj)
+{
+    return obj ? obj->encrypted_data : 0;
+}
+
+size_t Noise_EncryptedPrivateKey_get_size_encrypted_data(const Noise_EncryptedPrivateKey *obj)
+{
+    return obj ? obj->encrypted_data_size_ : 0;
+}
+
+int Noise_EncryptedPrivateKey_set_encrypted_data(Noise_EncryptedPrivateKey *obj, const void *value, size_t size)
+{
+    return noise_protobuf_table_set_field(&Noise_EncryptedPrivateKey_fields[4], obj, value, size);
+}
+
+int Noise_PrivateKey_new(Noise_PrivateKey **obj)
+{
+    return noise_protobuf_table_new(&Noise_PrivateKey_desc, (void **)obj);
+}
+
+int Noise_PrivateKey_free(Noise_PrivateKey *obj)
+{
+    return noise_protobuf_table_free(&Noise_PrivateKey_desc, obj);
+}
+
+int Noise_PrivateKey_write(NoiseProtobuf *pbuf, int tag, const Noise_PrivateKey *obj)
+{
+    return noise_protobuf_table_write(pbuf, tag, &Noise_PrivateKey_desc, obj);
+}
+
+int Noise_PrivateKey_read(NoiseProtobuf *pbuf, int tag, Noise_PrivateKey **obj)
+{
+    return noise_protobuf_table_read(pbuf, tag, &Noise_PrivateKey_desc, (void **)obj);
+}
+
+size_t Noise_PrivateKey_measure(int tag, const Noise_PrivateKey *obj)
+{
+    return noise_protobuf_table_measure(tag, &Noise_PrivateKey_desc, obj);
+}
+
+int Noise_PrivateKey_encode(NoiseProtobuf *pbuf, int tag, const Noise_PrivateKey *obj)
+{
+    return noise_protobuf_table_encode(pbuf, tag, &Noise_PrivateKey_desc, obj);
+}
+
+int Noise_PrivateKey_clear_id(Noise_PrivateKey *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_PrivateKey_fields[0], obj);
+}
+
+int Noise_PrivateKey_has_id(const Noise_PrivateKey *obj)
+{
+    return obj ? (obj->id != 0) : 0;
+}
+
+const char *Noise_PrivateKey_get_id(const Noise_PrivateKey *obj)
+{
+    return obj ? obj->id : 0;
+}
+
+size_t Noise_PrivateKey_get_size_id(const Noise_PrivateKey *obj)
+{
+    return obj ? obj->id_size_ : 0;
+}
+
+int Noise_PrivateKey_set_id(Noise_PrivateKey *obj, const char *value, size_t size)
+{
+    return noise_protobuf_table_set_field(&Noise_PrivateKey_fields[0], obj, value, size);
+}
+
+int Noise_PrivateKey_clear_name(Noise_PrivateKey *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_PrivateKey_fields[1], obj);
+}
+
+int Noise_PrivateKey_has_name(const Noise_PrivateKey *obj)
+{
+    return obj ? (obj->name != 0) : 0;
+}
+
+const char *Noise_PrivateKey_get_name(const Noise_PrivateKey *obj)
+{
+    return obj ? obj->name : 0;
+}
+
+size_t Noise_PrivateKey_get_size_name(const Noise_PrivateKey *obj)
+{
+    return obj ? obj->name_size_ : 0;
+}
+
+int Noise_PrivateKey_set_name(Noise_PrivateKey *obj, const char *value, size_t size)
+{
+    return noise_protobuf_table_set_field(&Noise_PrivateKey_fields[1], obj, value, size);
+}
+
+int Noise_PrivateKey_clear_role(Noise_PrivateKey *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_PrivateKey_fields[2], obj);
+}
+
+int Noise_PrivateKey_has_role(const Noise_PrivateKey *obj)
+{
+    return obj ? (obj->role != 0) : 0;
+}
+
+const char *Noise_PrivateKey_get_role(const Noise_PrivateKey *obj)
+{
+    return obj ? obj->role : 0;
+}
+
+size_t Noise_PrivateKey_get_size_role(const Noise_PrivateKey *obj)
+{
+    return obj ? obj->role_size_ : 0;
+}
+
+int Noise_PrivateKey_set_role(Noise_PrivateKey *obj, const char *value, size_t size)
+{
+    return noise_protobuf_table_set_field(&Noise_PrivateKey_fields[2], obj, value, size);
+}
+
+int Noise_PrivateKey_clear_keys(Noise_PrivateKey *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_PrivateKey_fields[3], obj);
+}
+
+int Noise_PrivateKey_has_keys(const Noise_PrivateKey *obj)
+{
+    return obj ? (obj->keys_count_ != 0) : 0;
+}
+
+size_t Noise_PrivateKey_count_keys(const Noise_PrivateKey *obj)
+{
+    return obj ? obj->keys_count_ : 0;
+}
+
+Noise_PrivateKeyInfo *Noise_PrivateKey_get_at_keys(const Noise_PrivateKey *obj, size_t index)
+{
+    if (obj && index < obj->keys_count_)
+        return obj->keys[index];
+    else
+        return 0;
+}
+
+int Noise_PrivateKey_add_keys(Noise_PrivateKey *obj, Noise_PrivateKeyInfo **value)
+{
+    return noise_protobuf_table_add_field(&Noise_PrivateKey_fields[3], obj, (void **)value);
+}
+
+int Noise_PrivateKey_insert_keys(Noise_PrivateKey *obj, size_t index, Noise_PrivateKeyInfo *value)
+{
+    if (!obj || !value)
+        return NOISE_ERROR_INVALID_PARAM;
+    return noise_protobuf_insert_into_array((void **)&(obj->keys), &(obj->keys_count_), &(obj->keys_max_), index, &value, sizeof(value));
+}
+
+int Noise_PrivateKey_clear_meta(Noise_PrivateKey *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_PrivateKey_fields[4], obj);
+}
+
+int Noise_PrivateKey_has_meta(const Noise_PrivateKey *obj)
+{
+    return obj ? (obj->meta_count_ != 0) : 0;
+}
+
+size_t Noise_PrivateKey_count_meta(const Noise_PrivateKey *obj)
+{
+    return obj ? obj->meta_count_ : 0;
+}
+
+Noise_MetaInfo *Noise_PrivateKey_get_at_meta(const Noise_PrivateKey *obj, size_t index)
+{
+    if (obj && index < obj->meta_count_)
+        return obj->meta[index];
+    else
+        return 0;
+}
+
+int Noise_PrivateKey_add_meta(Noise_PrivateKey *obj, Noise_MetaInfo **value)
+{
+    return noise_protobuf_table_add_field(&Noise_PrivateKey_fields[4], obj, (void **)value);
+}
+
+int Noise_PrivateKey_insert_meta(Noise_PrivateKey *obj, size_t index, Noise_MetaInfo *value)
+{
+    if (!obj || !value)
+        return NOISE_ERROR_INVALID_PARAM;
+    return noise_protobuf_insert_into_array((void **)&(obj->meta), &(obj->meta_count_), &(obj->meta_max_), index, &value, sizeof(value));
+}
+
+int Noise_PrivateKeyInfo_new(Noise_PrivateKeyInfo **obj)
+{
+    return noise_protobuf_table_new(&Noise_PrivateKeyInfo_desc, (void **)obj);
+}
+
+int Noise_PrivateKeyInfo_free(Noise_PrivateKeyInfo *obj)
+{
+    return noise_protobuf_table_free(&Noise_PrivateKeyInfo_desc, obj);
+}
+
+int Noise_PrivateKeyInfo_write(NoiseProtobuf *pbuf, int tag, const Noise_PrivateKeyInfo *obj)
+{
+    return noise_protobuf_table_write(pbuf, tag, &Noise_PrivateKeyInfo_desc, obj);
+}
+
+int Noise_PrivateKeyInfo_read(NoiseProtobuf *pbuf, int tag, Noise_PrivateKeyInfo **obj)
+{
+    return noise_protobuf_table_read(pbuf, tag, &Noise_PrivateKeyInfo_desc, (void **)obj);
+}
+
+size_t Noise_PrivateKeyInfo_measure(int tag, const Noise_PrivateKeyInfo *obj)
+{
+    return noise_protobuf_table_measure(tag, &Noise_PrivateKeyInfo_desc, obj);
+}
+
+int Noise_PrivateKeyInfo_encode(NoiseProtobuf *pbuf, int tag, const Noise_PrivateKeyInfo *obj)
+{
+    return noise_protobuf_table_encode(pbuf, tag, &Noise_PrivateKeyInfo_desc, obj);
+}
+
+int Noise_PrivateKeyInfo_clear_algorithm(Noise_PrivateKeyInfo *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_PrivateKeyInfo_fields[0], obj);
+}
+
+int Noise_PrivateKeyInfo_has_algorithm(const Noise_PrivateKeyInfo *obj)
+{
+    return obj ? (obj->algorithm != 0) : 0;
+}
+
+const char *Noise_PrivateKeyInfo_get_algorithm(const Noise_PrivateKeyInfo *obj)
+{
+    return obj ? obj->algorithm : 0;
+}
+
+size_t Noise_PrivateKeyInfo_get_size_algorithm(const Noise_PrivateKeyInfo *obj)
+{
+    return obj ? obj->algorithm_size_ : 0;
+}
+
+int Noise_PrivateKeyInfo_set_algorithm(Noise_PrivateKeyInfo *obj, const char *value, size_t size)
+{
+    return noise_protobuf_table_set_field(&Noise_PrivateKeyInfo_fields[0], obj, value, size);
+}
+
+int Noise_PrivateKeyInfo_clear_key(Noise_PrivateKeyInfo *obj)
+{
+    return noise_protobuf_table_clear_field(&Noise_PrivateKeyInfo_fields[1], obj);
+}
+
+int Noise_PrivateKeyInfo_has_key(const Noise_PrivateKeyInfo *obj)
+{
+    return obj ? (obj->key != 0) : 0;
+}
+
+const void *Noise_PrivateKeyInfo_get_key(const Noise_PrivateKeyInfo *obj)
+{
+    return obj ? obj->key : 0;
+}
+
+size_t Noise_PrivateKeyInfo_get_size_key(const Noise_PrivateKeyInfo *obj)
+{
+    return obj ? obj->key_size_ : 0;
+}
+
+int Noise_PrivateKeyInfo_set_key(Noise_PrivateKeyInfo *obj, const void *value, size_t size)
+{
+    return noise_protobuf_table_set_field(&Noise_PrivateKeyInfo_fields[1], obj, value, size);
+}
+
@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test-helpers.h"
+#if defined(HAVE_LIBPTHREAD)
+#include <pthread.h>
+#endif
+
+/* All algorithms that should have at least a reference implementation */
+static int const algorithms[] = {
+    NOISE_CIPHER_CHACHAPOLY,
+    NOISE_CIPHER_AESGCM,
+    NOISE_HASH_BLAKE2s,
+    NOISE_HASH_BLAKE2b,
+    NOISE_HASH_SHA256,
+    NOISE_HASH_SHA512,
+    NOISE_DH_CURVE25519,
+    NOISE_DH_CURVE448,
+    NOISE_DH_NEWHOPE,
+    NOISE_DH_MLKEM768,
+    NOISE_SIGN_ED25519,
+    0
+};
+
+/* Creates an object for an algorithm to check that the registry works */
+static int create_object(int id)
+{
+    NoiseCipherState *cipher;
+    NoiseHashState *hash;
+    NoiseDHState *dh;
+    NoiseSignState *sign;
+    int err;
+    switch (id & NOISE_ID(0xFF, 0)) {
+    case NOISE_CIPHER_CATEGORY:
+        err = noise_cipherstate_new_by_id(&cipher, id);
+        if (err == NOISE_ERROR_NONE)
+            noise_cipherstate_free(cipher);
+        break;
+    case NOISE_HASH_CATEGORY:
+        err = noise_hashstate_new_by_id(&hash, id);
+        if (err == NOISE_ERROR_NONE)
+            noise_hashstate_free(hash);
+        break;
+    case NOISE_DH_CATEGORY:
+        err = noise_dhstate_new_by_id(&dh, id);
+        if (err == NOISE_ERROR_NONE)
+            noise_dhstate_free(dh);
+        break;
+    default:
+        err = noise_signstate_new_by_id(&sign, id);
+        if (err == NOISE_ERROR_NONE)
+            noise_signstate_free(sign);
+        break;
+    }
+    return err;
+}
+
+#if defined(HAVE_LIBPTHREAD)
+
+#define BACKEND_THREADS 8
+
+/* Flag that releases all of the threads at once */
+static volatile int backend_threads_go;
+
+/* Creates an object for every algorithm, as soon as all threads are ready */
+static void *backend_thread(void *arg)
+{
+    int *failed = (int *)arg;
+    int round, index;
+    while (!__atomic_load_n(&backend_threads_go, __ATOMIC_ACQUIRE))
+        ;   /* Spin until all threads have been created */
+    for (round = 0; round < 4; ++round) {
+        for (index = 0; algorithms[index] != 0; ++index) {
+            if (create_object(algorithms[index]) != NOISE_ERROR_NONE)
+                *failed = 1;
+        }
+    }
+    return 0;
+}
+
+/* Creates objects from several threads at once, which must all succeed */
+static void check_threads(void)
+{
+    pthread_t threads[BACKEND_THREADS];
+    int failed[BACKEND_THREADS];
+    int index;
+    backend_threads_go = 0;
+    for (index = 0; index < BACKEND_THREADS; ++index) {
+        failed[index] = 0;
+        compare(pthread_create(&(threads[index]), 0, backend_thread,
+                               &(failed[index])), 0);
+    }
+    __atomic_store_n(&backend_threads_go, 1, __ATOMIC_RELEASE);
+    for (index = 0; index < BACKEND_THREADS; ++index) {
+        compare(pthread_join(threads[index], 0), 0);
+        compare(failed[index], 0);
+    }
+}
+
+#else
+
+static void check_threads(void)
+{
+}
+
+#endif
+
+/* Check the information that is reported for each algorithm */
+static void check_algorithm(int id)
+{
+    const char *active;
+    int count, index, found_ref;
+
+    data_name = noise_id_to_name(0, id);
+
+    /* The active implementation must be one of the supported ones */
+    count = noise_backend_get_count(id);
+    verify(count >= 1);
+    active = noise_backend_get_active(id);
+    verify(active != 0);
+    found_ref = 0;
+    for (index = 0; index < count; ++index) {
+        verify(noise_backend_get_name(id, index) != 0);
+        if (!strcmp(noise_backend_get_name(id, index), "ref")) {
+            verify(noise_backend_is_supported(id, index));
+            compare(index, count - 1);
+            found_ref = 1;
+        }
+    }
+    verify(found_ref);
+    verify(noise_backend_get_name(id, count) == 0);
+    verify(noise_backend_get_name(id, -1) == 0);
+    verify(!noise_backend_is_supported(id, count));
+
+    /* Check every supported implementation against the reference */
+    for (index = 0; index < count; ++index) {
+        if (!noise_backend_is_supported(id, index))
+            continue;
+        compare(noise_backend_select(id, noise_backend_get_name(id, index)),
+                NOISE_ERROR_NONE);
+        compare(strcmp(noise_backend_get_active(id),
+                       noise_backend_get_name(id, index)), 0);
+        compare(noise_backend_self_check(id), NOISE_ERROR_NONE);
+        compare(create_object(id), NOISE_ERROR_NONE);
+    }
+
+    /* Unknown implementations cannot be selected */
+    compare(noise_backend_select(id, "no-such-backend"),
+            NOISE_ERROR_UNKNOWN_NAME);
+
+    /* Go back to automatic selection */
+    compare(noise_backend_select(id, NULL), NOISE_ERROR_NONE);
+    verify(noise_backend_get_active(id) != 0);
+    compare(create_object(id), NOISE_ERROR_NONE);
+}
+
+void test_backend(void)
+{
+    int index;
+
+    /* Initialize the registry from several threads at once.  This must
+       come first because nothing else in the test program has used the
+       registry yet */
+    check_threads();
+
+    /* Check all of the known algorithms */
+    for (index = 0; algorithms[index] != 0; ++index)
+        check_algorithm(algorithms[index]);
+    data_name = 0;
+
+    /* Enabling self-checks must not change which objects can be created,
+       even when several threads run the first check at once */
+    noise_backend_set_self_check(1);
+    check_threads();
+    for (index = 0; algorithms[index] != 0; ++index)
+        compare(create_object(algorithms[index]), NOISE_ERROR_NONE);
+    noise_backend_set_self_check(0);
+
+    /* Unknown algorithms and non-algorithm identifiers */
+    compare(noise_backend_get_count(0), 0);
+    compare(noise_backend_get_count(NOISE_PATTERN_XX), 0);
+    verify(noise_backend_get_name(NOISE_PATTERN_XX, 0) == 0);
+    verify(noise_backend_get_active(NOISE_PATTERN_XX) == 0);
+    compare(noise_backend_select(NOISE_PATTERN_XX, "ref"),
+            NOISE_ERROR_UNKNOWN_ID);
+    compare(noise_backend_select(NOISE_ID('C', 200), NULL),
+            NOISE_ERROR_UNKNOWN_ID);
+    compare(noise_backend_self_check(NOISE_ID('H', 200)),
+            NOISE_ERROR_UNKNOWN_ID);
+
+    /* The CPU features are stable between calls */
+    compare(noise_backend_get_cpu_features(),
+            noise_backend_get_cpu_features());
+}
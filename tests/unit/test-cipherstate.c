@@ -310,8 +310,129 @@ static void cipherstate_check_errors(void)
     verify(state == NULL);
 }
 
+/* Key for wrapping exported CipherState objects */
+static uint8_t const wrap_key[NOISE_EXPORT_KEY_LEN] = {
+    0x5A, 0x4B, 0x3C, 0x2D, 0x1E, 0x0F, 0xF0, 0xE1,
+    0xD2, 0xC3, 0xB4, 0xA5, 0x96, 0x87, 0x78, 0x69,
+    0x01, 0x12, 0x23, 0x34, 0x45, 0x56, 0x67, 0x78,
+    0x89, 0x9A, 0xAB, 0xBC, 0xCD, 0xDE, 0xEF, 0xF0
+};
+
+/* Check exporting and importing a CipherState in the middle of a session */
+static void check_export(int id)
+{
+    static uint8_t const key[32] = {
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+        0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10,
+        0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18,
+        0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20
+    };
+    NoiseCipherState *sender;
+    NoiseCipherState *receiver;
+    NoiseCipherState *imported;
+    uint8_t blob_data[NOISE_MAX_EXPORT_LEN];
+    uint8_t other_key[NOISE_EXPORT_KEY_LEN];
+    uint8_t packet[64];
+    NoiseBuffer blob;
+    NoiseBuffer mbuf;
+    int index;
+
+    compare(noise_cipherstate_new_by_id(&sender, id), NOISE_ERROR_NONE);
+    compare(noise_cipherstate_new_by_id(&receiver, id), NOISE_ERROR_NONE);
+    compare(noise_cipherstate_init_key(sender, key, 32), NOISE_ERROR_NONE);
+    compare(noise_cipherstate_init_key(receiver, key, 32), NOISE_ERROR_NONE);
+    for (index = 0; index < 3; ++index) {
+        noise_buffer_set_inout(mbuf, packet, 16, sizeof(packet));
+        compare(noise_cipherstate_encrypt(sender, &mbuf), NOISE_ERROR_NONE);
+        compare(noise_cipherstate_decrypt(receiver, &mbuf), NOISE_ERROR_NONE);
+    }
+
+    /* Export the sender and continue the session with the imported copy */
+    noise_buffer_set_output(blob, blob_data, sizeof(blob_data));
+    compare(noise_cipherstate_export(sender, wrap_key, sizeof(wrap_key), &blob),
+            NOISE_ERROR_NONE);
+    verify(blob.size > 32 && blob.size < 128);
+    compare(noise_cipherstate_free(sender), NOISE_ERROR_NONE);
+    compare(noise_cipherstate_import
+                (&imported, wrap_key, sizeof(wrap_key), &blob),
+            NOISE_ERROR_NONE);
+    compare(noise_cipherstate_get_cipher_id(imported), id);
+    compare(noise_cipherstate_has_key(imported), 1);
+    for (index = 0; index < 3; ++index) {
+        memset(packet, 0x60 + index, 16);
+        noise_buffer_set_inout(mbuf, packet, 16, sizeof(packet));
+        compare(noise_cipherstate_encrypt(imported, &mbuf), NOISE_ERROR_NONE);
+        compare(noise_cipherstate_decrypt(receiver, &mbuf), NOISE_ERROR_NONE);
+        compare(packet[0], 0x60 + index);
+    }
+
+    /* The blob is bound to the wrapping key and the type of object */
+    memcpy(other_key, wrap_key, sizeof(other_key));
+    other_key[7] ^= 0x80;
+    sender = (NoiseCipherState *)8;
+    compare(noise_cipherstate_import
+                (&sender, other_key, sizeof(other_key), &blob),
+            NOISE_ERROR_MAC_FAILURE);
+    verify(sender == NULL);
+    blob_data[blob.size - 20] ^= 0x01;
+    compare(noise_cipherstate_import
+                (&sender, wrap_key, sizeof(wrap_key), &blob),
+            NOISE_ERROR_MAC_FAILURE);
+    blob_data[blob.size - 20] ^= 0x01;
+    blob_data[3] = 2;
+    compare(noise_cipherstate_import
+                (&sender, wrap_key, sizeof(wrap_key), &blob),
+            NOISE_ERROR_INVALID_FORMAT);
+    blob_data[3] = 1;
+    --(blob.size);
+    compare(noise_cipherstate_import
+                (&sender, wrap_key, sizeof(wrap_key), &blob),
+            NOISE_ERROR_MAC_FAILURE);
+
+    /* Output buffer too small and bad parameters */
+    noise_buffer_set_output(blob, blob_data, 40);
+    compare(noise_cipherstate_export
+                (imported, wrap_key, sizeof(wrap_key), &blob),
+            NOISE_ERROR_INVALID_LENGTH);
+    compare(blob.size, 0);
+    compare(noise_cipherstate_export(imported, wrap_key, 16, &blob),
+            NOISE_ERROR_INVALID_LENGTH);
+    compare(noise_cipherstate_export(0, wrap_key, sizeof(wrap_key), &blob),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_cipherstate_export(imported, 0, sizeof(wrap_key), &blob),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_cipherstate_export(imported, wrap_key, sizeof(wrap_key), 0),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_cipherstate_import(0, wrap_key, sizeof(wrap_key), &blob),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_cipherstate_import(&sender, wrap_key, sizeof(wrap_key), 0),
+            NOISE_ERROR_INVALID_PARAM);
+
+    /* A CipherState without a key can be exported as well */
+    compare(noise_cipherstate_new_by_id(&sender, id), NOISE_ERROR_NONE);
+    noise_buffer_set_output(blob, blob_data, sizeof(blob_data));
+    compare(noise_cipherstate_export(sender, wrap_key, sizeof(wrap_key), &blob),
+            NOISE_ERROR_NONE);
+    compare(noise_cipherstate_free(sender), NOISE_ERROR_NONE);
+    compare(noise_cipherstate_import
+                (&sender, wrap_key, sizeof(wrap_key), &blob),
+            NOISE_ERROR_NONE);
+    compare(noise_cipherstate_has_key(sender), 0);
+
+    compare(noise_cipherstate_free(sender), NOISE_ERROR_NONE);
+    compare(noise_cipherstate_free(receiver), NOISE_ERROR_NONE);
+    compare(noise_cipherstate_free(imported), NOISE_ERROR_NONE);
+}
+
+static void cipherstate_check_export(void)
+{
+    check_export(NOISE_CIPHER_CHACHAPOLY);
+    check_export(NOISE_CIPHER_AESGCM);
+}
+
 void test_cipherstate(void)
 {
     cipherstate_check_test_vectors();
     cipherstate_check_errors();
+    cipherstate_check_export();
 }
@@ -0,0 +1,321 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test-helpers.h"
+
+/* Run a simple two-party handshake to the "split" stage */
+static void run_handshake_to_split
+    (NoiseHandshakeState *initiator, NoiseHandshakeState *responder)
+{
+    NoiseHandshakeState *send;
+    NoiseHandshakeState *recv;
+    uint8_t message[4096];
+    NoiseBuffer mbuf;
+    int action;
+
+    compare(noise_handshakestate_start(initiator), NOISE_ERROR_NONE);
+    compare(noise_handshakestate_start(responder), NOISE_ERROR_NONE);
+    for (;;) {
+        action = noise_handshakestate_get_action(initiator);
+        if (action == NOISE_ACTION_WRITE_MESSAGE) {
+            send = initiator;
+            recv = responder;
+        } else if (action == NOISE_ACTION_READ_MESSAGE) {
+            send = responder;
+            recv = initiator;
+        } else {
+            break;
+        }
+        noise_buffer_set_output(mbuf, message, sizeof(message));
+        compare(noise_handshakestate_write_message(send, &mbuf, 0),
+                NOISE_ERROR_NONE);
+        compare(noise_handshakestate_read_message(recv, &mbuf, 0),
+                NOISE_ERROR_NONE);
+    }
+    compare(noise_handshakestate_get_action(initiator), NOISE_ACTION_SPLIT);
+    compare(noise_handshakestate_get_action(responder), NOISE_ACTION_SPLIT);
+}
+
+/* Checks that a working CipherState no longer holds a session's key */
+static void check_no_key(NoiseCipherState *work)
+{
+    uint8_t packet[32];
+    NoiseBuffer mbuf;
+    compare(noise_cipherstate_has_key(work), 0);
+    memset(packet, 0x3C, 16);
+    noise_buffer_set_inout(mbuf, packet, 16, sizeof(packet));
+    compare(noise_cipherstate_encrypt(work, &mbuf), NOISE_ERROR_NONE);
+    compare(mbuf.size, 16);
+    compare(packet[0], 0x3C);
+    compare(packet[15], 0x3C);
+}
+
+/* Sends a packet from a CompactSession to a full CipherState */
+static void check_compact_to_full
+    (NoiseCompactSession *session, NoiseCipherState *work,
+     NoiseCipherState *receive, uint8_t fill)
+{
+    static uint8_t const ad[5] = {1, 2, 3, 4, 5};
+    uint8_t packet[64];
+    NoiseBuffer mbuf;
+
+    memset(packet, fill, 32);
+    noise_buffer_set_inout(mbuf, packet, 32, sizeof(packet));
+    compare(noise_compactsession_encrypt_with_ad
+                (session, work, ad, sizeof(ad), &mbuf),
+            NOISE_ERROR_NONE);
+    compare(mbuf.size, 32 + noise_cipherstate_get_mac_length(work));
+    check_no_key(work);
+    compare(noise_cipherstate_decrypt_with_ad
+                (receive, ad, sizeof(ad), &mbuf),
+            NOISE_ERROR_NONE);
+    compare(mbuf.size, 32);
+    compare(packet[0], fill);
+    compare(packet[31], fill);
+}
+
+/* Sends a packet from a full CipherState to a CompactSession */
+static void check_full_to_compact
+    (NoiseCipherState *send, NoiseCompactSession *session,
+     NoiseCipherState *work, uint8_t fill)
+{
+    uint8_t packet[64];
+    NoiseBuffer mbuf;
+
+    memset(packet, fill, 16);
+    noise_buffer_set_inout(mbuf, packet, 16, sizeof(packet));
+    compare(noise_cipherstate_encrypt(send, &mbuf), NOISE_ERROR_NONE);
+    compare(noise_compactsession_decrypt(session, work, &mbuf),
+            NOISE_ERROR_NONE);
+    check_no_key(work);
+    compare(mbuf.size, 16);
+    compare(packet[0], fill);
+    compare(packet[15], fill);
+}
+
+/* Check a compact session against full CipherStates for a protocol */
+static void check_compact_protocol(const char *name)
+{
+    NoiseHandshakeState *initiator;
+    NoiseHandshakeState *responder;
+    NoiseCompactSession *session;
+    NoiseCompactSession *session2;
+    NoiseCipherState *send;
+    NoiseCipherState *receive;
+    NoiseCipherState *work;
+    NoiseCipherState *other;
+    uint8_t packet[64];
+    NoiseBuffer mbuf;
+    int cipher_id;
+    int index;
+
+    data_name = name;
+    compare(noise_handshakestate_new_by_name
+                (&initiator, name, NOISE_ROLE_INITIATOR),
+            NOISE_ERROR_NONE);
+    compare(noise_handshakestate_new_by_name
+                (&responder, name, NOISE_ROLE_RESPONDER),
+            NOISE_ERROR_NONE);
+    run_handshake_to_split(initiator, responder);
+
+    /* The initiator uses a compact session and the responder full ones */
+    compare(noise_handshakestate_split_compact(initiator, &session),
+            NOISE_ERROR_NONE);
+    verify(session != 0);
+    compare(noise_handshakestate_get_action(initiator), NOISE_ACTION_COMPLETE);
+    compare(noise_handshakestate_split_compact(initiator, &session2),
+            NOISE_ERROR_INVALID_STATE);
+    verify(session2 == 0);
+    compare(noise_handshakestate_split(responder, &send, &receive),
+            NOISE_ERROR_NONE);
+    cipher_id = noise_cipherstate_get_cipher_id(send);
+    compare(noise_compactsession_get_cipher_id(session), cipher_id);
+    compare(noise_cipherstate_new_by_id(&work, cipher_id), NOISE_ERROR_NONE);
+
+    /* Interleave the directions so that the working CipherState is
+       constantly switching keys and the nonces advance independently */
+    for (index = 0; index < 4; ++index) {
+        check_compact_to_full(session, work, receive, (uint8_t)(0x40 + index));
+        check_full_to_compact(send, session, work, (uint8_t)(0x80 + index));
+        check_full_to_compact(send, session, work, (uint8_t)(0xC0 + index));
+    }
+
+    /* A tampered packet is rejected but still consumes a nonce, just like
+       with a full CipherState, so the next packet fails as well */
+    memset(packet, 0x11, 16);
+    noise_buffer_set_inout(mbuf, packet, 16, sizeof(packet));
+    compare(noise_cipherstate_encrypt(send, &mbuf), NOISE_ERROR_NONE);
+    packet[3] ^= 0x01;
+    compare(noise_compactsession_decrypt(session, work, &mbuf),
+            NOISE_ERROR_MAC_FAILURE);
+    check_no_key(work);
+    check_compact_to_full(session, work, receive, 0x22);
+
+    /* Working CipherState for the wrong algorithm */
+    compare(noise_cipherstate_new_by_id
+                (&other, cipher_id == NOISE_CIPHER_CHACHAPOLY
+                            ? NOISE_CIPHER_AESGCM : NOISE_CIPHER_CHACHAPOLY),
+            NOISE_ERROR_NONE);
+    noise_buffer_set_inout(mbuf, packet, 16, sizeof(packet));
+    compare(noise_compactsession_encrypt(session, other, &mbuf),
+            NOISE_ERROR_NOT_APPLICABLE);
+    compare(noise_compactsession_decrypt(session, other, &mbuf),
+            NOISE_ERROR_NOT_APPLICABLE);
+    check_compact_to_full(session, work, receive, 0x33);
+
+    compare(noise_compactsession_free(session), NOISE_ERROR_NONE);
+    compare(noise_cipherstate_free(send), NOISE_ERROR_NONE);
+    compare(noise_cipherstate_free(receive), NOISE_ERROR_NONE);
+
+    /* Now the other way around: the responder uses a compact session */
+    compare(noise_handshakestate_free(initiator), NOISE_ERROR_NONE);
+    compare(noise_handshakestate_free(responder), NOISE_ERROR_NONE);
+    compare(noise_handshakestate_new_by_name
+                (&initiator, name, NOISE_ROLE_INITIATOR),
+            NOISE_ERROR_NONE);
+    compare(noise_handshakestate_new_by_name
+                (&responder, name, NOISE_ROLE_RESPONDER),
+            NOISE_ERROR_NONE);
+    run_handshake_to_split(initiator, responder);
+    compare(noise_handshakestate_split(initiator, &send, &receive),
+            NOISE_ERROR_NONE);
+    compare(noise_handshakestate_split_compact(responder, &session),
+            NOISE_ERROR_NONE);
+    check_full_to_compact(send, session, work, 0x44);
+    check_compact_to_full(session, work, receive, 0x55);
+    check_compact_to_full(session, work, receive, 0x66);
+
+    compare(noise_compactsession_free(session), NOISE_ERROR_NONE);
+    compare(noise_cipherstate_free(send), NOISE_ERROR_NONE);
+    compare(noise_cipherstate_free(receive), NOISE_ERROR_NONE);
+    compare(noise_cipherstate_free(work), NOISE_ERROR_NONE);
+    compare(noise_cipherstate_free(other), NOISE_ERROR_NONE);
+    compare(noise_handshakestate_free(initiator), NOISE_ERROR_NONE);
+    compare(noise_handshakestate_free(responder), NOISE_ERROR_NONE);
+}
+
+/* Check compact sessions for a variety of protocols */
+static void compactsession_check_protocols(void)
+{
+    check_compact_protocol("Noise_NN_25519_ChaChaPoly_BLAKE2s");
+    check_compact_protocol("Noise_NN_25519_AESGCM_SHA256");
+    check_compact_protocol("Noise_NN_448_ChaChaPoly_SHA512");
+    check_compact_protocol("Noise_NN_448_AESGCM_BLAKE2b");
+    check_compact_protocol("Noise_NN_25519_AESGCM_BLAKE2s");
+}
+
+/* Check the key, nonce, and error handling of compact sessions */
+static void compactsession_check_keys(void)
+{
+    static uint8_t const key1[32] = {
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+        0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10,
+        0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18,
+        0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20
+    };
+    static uint8_t const key2[32] = {
+        0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8,
+        0xA9, 0xAA, 0xAB, 0xAC, 0xAD, 0xAE, 0xAF, 0xB0,
+        0xB1, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8,
+        0xB9, 0xBA, 0xBB, 0xBC, 0xBD, 0xBE, 0xBF, 0xC0
+    };
+    NoiseCompactSession *session;
+    NoiseCompactSession *peer;
+    NoiseCipherState *work;
+    NoiseCipherState *full;
+    uint8_t packet1[48];
+    uint8_t packet2[48];
+    NoiseBuffer mbuf1;
+    NoiseBuffer mbuf2;
+    int index;
+
+    /* The whole point is to be small */
+    verify(noise_compactsession_get_size() <= 96);
+
+    /* Bad parameters */
+    session = (NoiseCompactSession *)8;
+    compare(noise_compactsession_new
+                (&session, NOISE_CIPHER_AESGCM, 0, key2, 32),
+            NOISE_ERROR_INVALID_PARAM);
+    verify(session == 0);
+    compare(noise_compactsession_new
+                (&session, NOISE_CIPHER_AESGCM, key1, key2, 16),
+            NOISE_ERROR_INVALID_LENGTH);
+    compare(noise_compactsession_new
+                (&session, NOISE_HASH_SHA256, key1, key2, 32),
+            NOISE_ERROR_UNKNOWN_ID);
+    compare(noise_compactsession_new(0, NOISE_CIPHER_AESGCM, key1, key2, 32),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_compactsession_free(0), NOISE_ERROR_INVALID_PARAM);
+    compare(noise_compactsession_get_cipher_id(0), NOISE_CIPHER_NONE);
+
+    /* Two sessions with swapped keys talk to each other and produce the
+       same ciphertext as a full CipherState with the same key */
+    compare(noise_compactsession_new
+                (&session, NOISE_CIPHER_AESGCM, key1, key2, 32),
+            NOISE_ERROR_NONE);
+    compare(noise_compactsession_new
+                (&peer, NOISE_CIPHER_AESGCM, key2, key1, 32),
+            NOISE_ERROR_NONE);
+    compare(noise_cipherstate_new_by_id(&work, NOISE_CIPHER_AESGCM),
+            NOISE_ERROR_NONE);
+    compare(noise_cipherstate_new_by_id(&full, NOISE_CIPHER_AESGCM),
+            NOISE_ERROR_NONE);
+    compare(noise_cipherstate_init_key(full, key1, 32), NOISE_ERROR_NONE);
+    compare(noise_compactsession_encrypt(0, work, &mbuf1),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_compactsession_encrypt(session, 0, &mbuf1),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_compactsession_decrypt(session, work, 0),
+            NOISE_ERROR_INVALID_PARAM);
+    for (index = 0; index < 3; ++index) {
+        memset(packet1, 0x70 + index, 32);
+        memset(packet2, 0x70 + index, 32);
+        noise_buffer_set_inout(mbuf1, packet1, 32, sizeof(packet1));
+        noise_buffer_set_inout(mbuf2, packet2, 32, sizeof(packet2));
+        compare(noise_compactsession_encrypt(session, work, &mbuf1),
+                NOISE_ERROR_NONE);
+        compare(noise_cipherstate_encrypt(full, &mbuf2), NOISE_ERROR_NONE);
+        compare_blocks(mbuf1.data, mbuf1.size,
+                       mbuf2.data, mbuf2.size);
+        compare(noise_compactsession_decrypt(peer, work, &mbuf1),
+                NOISE_ERROR_NONE);
+        compare(mbuf1.size, 32);
+        compare(packet1[0], 0x70 + index);
+    }
+
+    /* Replaying the last packet fails because the nonce has moved on */
+    noise_buffer_set_inout(mbuf2, packet2, mbuf2.size, sizeof(packet2));
+    compare(noise_compactsession_decrypt(peer, work, &mbuf2),
+            NOISE_ERROR_MAC_FAILURE);
+
+    compare(noise_compactsession_free(session), NOISE_ERROR_NONE);
+    compare(noise_compactsession_free(peer), NOISE_ERROR_NONE);
+    compare(noise_cipherstate_free(work), NOISE_ERROR_NONE);
+    compare(noise_cipherstate_free(full), NOISE_ERROR_NONE);
+}
+
+void test_compactsession(void)
+{
+    compactsession_check_keys();
+    compactsession_check_protocols();
+}
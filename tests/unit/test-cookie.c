@@ -0,0 +1,346 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test-helpers.h"
+
+static uint8_t const source1[6] = {192, 168, 1, 2, 0x12, 0x34};
+static uint8_t const source2[6] = {192, 168, 1, 3, 0x12, 0x34};
+
+/* Writes the first IK handshake message with MAC's and has the responder
+   check it.  Returns the result of the check, after reading the message
+   with the responder if the check was successful */
+static int send_first_message
+    (NoiseCookieMaker *maker, NoiseCookieChecker *checker,
+     const uint8_t *source, const NoiseDHState *responder_key,
+     NoiseBuffer *mbuf)
+{
+    NoiseHandshakeState *initiator;
+    NoiseHandshakeState *responder;
+    size_t size;
+    int err;
+
+    compare(noise_handshakestate_new_by_name
+                (&initiator, "Noise_IK_25519_ChaChaPoly_BLAKE2s",
+                 NOISE_ROLE_INITIATOR),
+            NOISE_ERROR_NONE);
+    compare(noise_handshakestate_new_by_name
+                (&responder, "Noise_IK_25519_ChaChaPoly_BLAKE2s",
+                 NOISE_ROLE_RESPONDER),
+            NOISE_ERROR_NONE);
+    compare(noise_dhstate_generate_keypair
+                (noise_handshakestate_get_local_keypair_dh(initiator)),
+            NOISE_ERROR_NONE);
+    compare(noise_dhstate_copy
+                (noise_handshakestate_get_remote_public_key_dh(initiator),
+                 responder_key),
+            NOISE_ERROR_NONE);
+    compare(noise_dhstate_copy
+                (noise_handshakestate_get_local_keypair_dh(responder),
+                 responder_key),
+            NOISE_ERROR_NONE);
+    compare(noise_handshakestate_start(initiator), NOISE_ERROR_NONE);
+    compare(noise_handshakestate_start(responder), NOISE_ERROR_NONE);
+
+    compare(noise_handshakestate_write_message(initiator, mbuf, 0),
+            NOISE_ERROR_NONE);
+    compare(noise_cookiemaker_add_macs(maker, mbuf), NOISE_ERROR_NONE);
+    size = mbuf->size;
+    err = noise_cookiechecker_check(checker, source, 6, mbuf);
+    if (err == NOISE_ERROR_NONE) {
+        compare(mbuf->size, size - NOISE_COOKIE_MACS_LEN);
+        compare(noise_handshakestate_read_message(responder, mbuf, 0),
+                NOISE_ERROR_NONE);
+        compare(noise_handshakestate_get_action(responder),
+                NOISE_ACTION_WRITE_MESSAGE);
+    } else {
+        compare(mbuf->size, size);
+    }
+
+    compare(noise_handshakestate_free(initiator), NOISE_ERROR_NONE);
+    compare(noise_handshakestate_free(responder), NOISE_ERROR_NONE);
+    return err;
+}
+
+/* Checks that the smallest message that gets a cookie reply is the size
+   of the reply, so that a spoofed message cannot be amplified */
+static void check_minimum_size
+    (NoiseCookieChecker *checker, const uint8_t *public_key, size_t reply_len)
+{
+    NoiseCookieMaker *maker;
+    uint8_t message[NOISE_MAX_COOKIE_REPLY_LEN];
+    uint8_t reply_data[NOISE_MAX_COOKIE_REPLY_LEN];
+    NoiseBuffer mbuf;
+    NoiseBuffer reply;
+
+    /* A message of exactly the reply's size gets a reply */
+    compare(noise_cookiemaker_new(&maker, public_key, 32), NOISE_ERROR_NONE);
+    memset(message, 0x33, sizeof(message));
+    noise_buffer_set_inout
+        (mbuf, message, reply_len - NOISE_COOKIE_MACS_LEN, sizeof(message));
+    compare(noise_cookiemaker_add_macs(maker, &mbuf), NOISE_ERROR_NONE);
+    compare(mbuf.size, reply_len);
+    compare(noise_cookiechecker_check(checker, source1, 6, &mbuf),
+            NOISE_ERROR_COOKIE_REQUIRED);
+    noise_buffer_set_output(reply, reply_data, sizeof(reply_data));
+    compare(noise_cookiechecker_make_reply
+                (checker, source1, 6, &mbuf, &reply),
+            NOISE_ERROR_NONE);
+    compare(reply.size, reply_len);
+
+    /* One byte less is rejected, even though "mac1" is valid */
+    noise_buffer_set_inout
+        (mbuf, message, reply_len - NOISE_COOKIE_MACS_LEN - 1,
+         sizeof(message));
+    compare(noise_cookiemaker_add_macs(maker, &mbuf), NOISE_ERROR_NONE);
+    compare(noise_cookiechecker_check(checker, source1, 6, &mbuf),
+            NOISE_ERROR_INVALID_FORMAT);
+    noise_buffer_set_output(reply, reply_data, sizeof(reply_data));
+    compare(noise_cookiechecker_make_reply
+                (checker, source1, 6, &mbuf, &reply),
+            NOISE_ERROR_INVALID_FORMAT);
+    compare(reply.size, 0);
+    compare(noise_cookiemaker_free(maker), NOISE_ERROR_NONE);
+}
+
+/* Check the handshake flow with and without load */
+static void cookie_check_flow(void)
+{
+    NoiseDHState *responder_key;
+    NoiseCookieChecker *checker;
+    NoiseCookieMaker *maker;
+    NoiseCookieMaker *other;
+    uint8_t public_key[32];
+    uint8_t message[256];
+    uint8_t reply_data[NOISE_MAX_COOKIE_REPLY_LEN];
+    uint8_t old_reply_data[NOISE_MAX_COOKIE_REPLY_LEN];
+    NoiseBuffer mbuf;
+    NoiseBuffer reply;
+    NoiseBuffer old_reply;
+
+    compare(noise_dhstate_new_by_id(&responder_key, NOISE_DH_CURVE25519),
+            NOISE_ERROR_NONE);
+    compare(noise_dhstate_generate_keypair(responder_key), NOISE_ERROR_NONE);
+    compare(noise_dhstate_get_public_key
+                (responder_key, public_key, sizeof(public_key)),
+            NOISE_ERROR_NONE);
+    compare(noise_cookiechecker_new(&checker, public_key, sizeof(public_key)),
+            NOISE_ERROR_NONE);
+    compare(noise_cookiemaker_new(&maker, public_key, sizeof(public_key)),
+            NOISE_ERROR_NONE);
+
+    /* Without load, only "mac1" matters */
+    compare(noise_cookiechecker_is_under_load(checker), 0);
+    noise_buffer_set_output(mbuf, message, sizeof(message));
+    compare(send_first_message
+                (maker, checker, source1, responder_key, &mbuf),
+            NOISE_ERROR_NONE);
+
+    /* A tampered message or one meant for another responder fails "mac1" */
+    noise_buffer_set_output(mbuf, message, sizeof(message));
+    mbuf.size = 100;
+    memset(message, 0x5A, mbuf.size);
+    compare(noise_cookiemaker_add_macs(maker, &mbuf), NOISE_ERROR_NONE);
+    message[7] ^= 0x01;
+    compare(noise_cookiechecker_check(checker, source1, 6, &mbuf),
+            NOISE_ERROR_MAC_FAILURE);
+    message[7] ^= 0x01;
+    compare(noise_cookiechecker_check(checker, source1, 6, &mbuf),
+            NOISE_ERROR_NONE);
+    public_key[0] ^= 0x01;
+    compare(noise_cookiemaker_new(&other, public_key, sizeof(public_key)),
+            NOISE_ERROR_NONE);
+    public_key[0] ^= 0x01;
+    compare(noise_cookiemaker_add_macs(other, &mbuf), NOISE_ERROR_NONE);
+    compare(noise_cookiechecker_check(checker, source1, 6, &mbuf),
+            NOISE_ERROR_MAC_FAILURE);
+    compare(noise_cookiemaker_free(other), NOISE_ERROR_NONE);
+
+    /* Go over the threshold.  The third message with a valid "mac1" in
+       this tick puts the checker under load */
+    compare(noise_cookiechecker_tick(checker), NOISE_ERROR_NONE);
+    compare(noise_cookiechecker_tick(checker), NOISE_ERROR_NONE);
+    compare(noise_cookiechecker_set_threshold(checker, 2), NOISE_ERROR_NONE);
+    noise_buffer_set_output(mbuf, message, sizeof(message));
+    compare(send_first_message
+                (maker, checker, source1, responder_key, &mbuf),
+            NOISE_ERROR_NONE);
+    noise_buffer_set_output(mbuf, message, sizeof(message));
+    compare(send_first_message
+                (maker, checker, source1, responder_key, &mbuf),
+            NOISE_ERROR_NONE);
+    compare(noise_cookiechecker_is_under_load(checker), 0);
+    noise_buffer_set_output(mbuf, message, sizeof(message));
+    compare(send_first_message
+                (maker, checker, source1, responder_key, &mbuf),
+            NOISE_ERROR_COOKIE_REQUIRED);
+    compare(noise_cookiechecker_is_under_load(checker), 1);
+
+    /* Send a cookie reply and try again with the cookie */
+    noise_buffer_set_output(reply, reply_data, sizeof(reply_data));
+    compare(noise_cookiechecker_make_reply
+                (checker, source1, 6, &mbuf, &reply),
+            NOISE_ERROR_NONE);
+    verify(reply.size <= NOISE_MAX_COOKIE_REPLY_LEN);
+    verify(reply.size < mbuf.size);
+    check_minimum_size(checker, public_key, reply.size);
+    memcpy(old_reply_data, reply_data, reply.size);
+    noise_buffer_set_input(old_reply, old_reply_data, reply.size);
+    reply_data[30] ^= 0x01;
+    compare(noise_cookiemaker_consume_reply(maker, &reply),
+            NOISE_ERROR_MAC_FAILURE);
+    reply_data[30] ^= 0x01;
+    reply_data[1] = 'X';
+    compare(noise_cookiemaker_consume_reply(maker, &reply),
+            NOISE_ERROR_INVALID_FORMAT);
+    reply_data[1] = 'C';
+    compare(noise_cookiemaker_consume_reply(maker, &reply),
+            NOISE_ERROR_NONE);
+    noise_buffer_set_output(mbuf, message, sizeof(message));
+    compare(send_first_message
+                (maker, checker, source1, responder_key, &mbuf),
+            NOISE_ERROR_NONE);
+
+    /* The cookie is bound to the source address */
+    noise_buffer_set_output(mbuf, message, sizeof(message));
+    compare(send_first_message
+                (maker, checker, source2, responder_key, &mbuf),
+            NOISE_ERROR_COOKIE_REQUIRED);
+
+    /* A cookie reply is bound to the message that it answers */
+    compare(noise_cookiemaker_consume_reply(maker, &old_reply),
+            NOISE_ERROR_MAC_FAILURE);
+
+    /* Cookies survive one rotation of the secret but not two */
+    compare(noise_cookiechecker_rotate(checker), NOISE_ERROR_NONE);
+    noise_buffer_set_output(mbuf, message, sizeof(message));
+    compare(send_first_message
+                (maker, checker, source1, responder_key, &mbuf),
+            NOISE_ERROR_NONE);
+    compare(noise_cookiechecker_rotate(checker), NOISE_ERROR_NONE);
+    noise_buffer_set_output(mbuf, message, sizeof(message));
+    compare(send_first_message
+                (maker, checker, source1, responder_key, &mbuf),
+            NOISE_ERROR_COOKIE_REQUIRED);
+
+    /* The load persists for one more tick and then goes away */
+    compare(noise_cookiechecker_tick(checker), NOISE_ERROR_NONE);
+    compare(noise_cookiechecker_is_under_load(checker), 1);
+    compare(noise_cookiechecker_tick(checker), NOISE_ERROR_NONE);
+    compare(noise_cookiechecker_is_under_load(checker), 0);
+    noise_buffer_set_output(mbuf, message, sizeof(message));
+    compare(send_first_message
+                (maker, checker, source2, responder_key, &mbuf),
+            NOISE_ERROR_NONE);
+
+    /* A threshold of zero turns load shedding off */
+    compare(noise_cookiechecker_set_threshold(checker, 0), NOISE_ERROR_NONE);
+    compare(noise_cookiechecker_is_under_load(checker), 0);
+
+    compare(noise_cookiechecker_free(checker), NOISE_ERROR_NONE);
+    compare(noise_cookiemaker_free(maker), NOISE_ERROR_NONE);
+    compare(noise_dhstate_free(responder_key), NOISE_ERROR_NONE);
+}
+
+/* Check the handling of bad parameters */
+static void cookie_check_parameters(void)
+{
+    static uint8_t const public_key[32] = {1, 2, 3, 4};
+    NoiseCookieChecker *checker;
+    NoiseCookieMaker *maker;
+    uint8_t message[64];
+    uint8_t reply_data[NOISE_MAX_COOKIE_REPLY_LEN];
+    NoiseBuffer mbuf;
+    NoiseBuffer reply;
+
+    checker = (NoiseCookieChecker *)8;
+    compare(noise_cookiechecker_new(&checker, 0, 32),
+            NOISE_ERROR_INVALID_PARAM);
+    verify(checker == 0);
+    compare(noise_cookiechecker_new(&checker, public_key, 0),
+            NOISE_ERROR_INVALID_LENGTH);
+    compare(noise_cookiechecker_new(0, public_key, 32),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_cookiechecker_free(0), NOISE_ERROR_INVALID_PARAM);
+    compare(noise_cookiechecker_set_threshold(0, 1),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_cookiechecker_tick(0), NOISE_ERROR_INVALID_PARAM);
+    compare(noise_cookiechecker_rotate(0), NOISE_ERROR_INVALID_PARAM);
+    compare(noise_cookiechecker_is_under_load(0), 0);
+    maker = (NoiseCookieMaker *)8;
+    compare(noise_cookiemaker_new(&maker, 0, 32), NOISE_ERROR_INVALID_PARAM);
+    verify(maker == 0);
+    compare(noise_cookiemaker_new(&maker, public_key, 0),
+            NOISE_ERROR_INVALID_LENGTH);
+    compare(noise_cookiemaker_new(0, public_key, 32),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_cookiemaker_free(0), NOISE_ERROR_INVALID_PARAM);
+
+    compare(noise_cookiechecker_new(&checker, public_key, 32),
+            NOISE_ERROR_NONE);
+    compare(noise_cookiemaker_new(&maker, public_key, 32), NOISE_ERROR_NONE);
+
+    /* No room for the MAC's, or a message that is too short for them */
+    noise_buffer_set_inout(mbuf, message, 40, sizeof(message));
+    compare(noise_cookiemaker_add_macs(maker, &mbuf),
+            NOISE_ERROR_INVALID_LENGTH);
+    compare(noise_cookiemaker_add_macs(0, &mbuf), NOISE_ERROR_INVALID_PARAM);
+    compare(noise_cookiemaker_add_macs(maker, 0), NOISE_ERROR_INVALID_PARAM);
+    noise_buffer_set_input(mbuf, message, NOISE_COOKIE_MACS_LEN - 1);
+    compare(noise_cookiechecker_check(checker, source1, 6, &mbuf),
+            NOISE_ERROR_INVALID_FORMAT);
+    compare(noise_cookiechecker_check(0, source1, 6, &mbuf),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_cookiechecker_check(checker, 0, 6, &mbuf),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_cookiechecker_check(checker, source1, 6, 0),
+            NOISE_ERROR_INVALID_PARAM);
+
+    /* Cookie replies */
+    noise_buffer_set_output(reply, reply_data, 16);
+    noise_buffer_set_input(mbuf, message, sizeof(message));
+    compare(noise_cookiechecker_make_reply
+                (checker, source1, 6, &mbuf, &reply),
+            NOISE_ERROR_INVALID_LENGTH);
+    compare(noise_cookiechecker_make_reply
+                (checker, source1, 6, &mbuf, 0),
+            NOISE_ERROR_INVALID_PARAM);
+    noise_buffer_set_output(reply, reply_data, sizeof(reply_data));
+    compare(noise_cookiechecker_make_reply
+                (checker, source1, 6, &mbuf, &reply),
+            NOISE_ERROR_NONE);
+    compare(noise_cookiemaker_consume_reply(maker, &reply),
+            NOISE_ERROR_INVALID_STATE);
+    compare(noise_cookiemaker_consume_reply(maker, 0),
+            NOISE_ERROR_INVALID_PARAM);
+    reply.size = 10;
+    compare(noise_cookiemaker_consume_reply(maker, &reply),
+            NOISE_ERROR_INVALID_FORMAT);
+
+    compare(noise_cookiechecker_free(checker), NOISE_ERROR_NONE);
+    compare(noise_cookiemaker_free(maker), NOISE_ERROR_NONE);
+}
+
+void test_cookie(void)
+{
+    cookie_check_parameters();
+    cookie_check_flow();
+}
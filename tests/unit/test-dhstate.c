@@ -638,6 +638,170 @@ static void dhstate_check_test_vectors(void)
            "349a9e8c91d116780ff9c7db6089ed4c06b34edaa848bbffd98542827e5331be",
          /* Shared secret */
          "0x78d62ad989a3bd740f87b2cf6f914dfe8cb1ea52c4c9ad82ddac9a45ba8e59cb");
+
+    /* ML-KEM-768 - Test vectors computed with an independent model of
+       FIPS 203, using the same seeds as the NewHope vectors above */
+    check_dh
+        (NOISE_DH_MLKEM768, 64, 1184, 1088, 32, "MLKEM768",
+         0, NOISE_ROLE_INITIATOR,
+         /* Alice's private key (d || z) */
+         "0x934d60b35624d740b30a7f227af2ae7c678e4e04e13c5f509eade2b79aea77e2"
+           "3e2a2ea6c9c476fc4937b013c993a793d6c0ab9960695ba838f649da539ca3d0",
+         /* Alice's public key */
+         "0x693b4b7f22698cc91e65a11198e9448697308f39a1f77cbe0df53245626f3235"
+           "7806c68e4ab8b2182958d0c49339d0b8c15347655b756256935b43ccef66ba7a"
+           "78953e5ca7acb350ccc89a87c86366c77bf0c01f8f472f22a85a9470a82ee054"
+           "ed9563c40b62d9bbc4e41076bbe5b3f1b60c2ba1652fa7aac44c6c26a0608e15"
+           "9a6a104923a64cff90435e1b2383633227675521427678c46352e05ee8b70ac5"
+           "474597c7338b23a577f7517c16c484fa23ed9548b81c35aca6a93600b7666b64"
+           "1436352d07b8d9c73dac463f94abb2e5989668192f01b89aa8568523656b5607"
+           "343a0772d28c47eb436ae01b2b8d08c3a1f03228a966a0f0634733779d46b135"
+           "fc75f5f1b53b54aca38362da71c4246cbdeb08b8c72c2b3ac10eeb40794bb1a1"
+           "0ee4a66ab09b1a41042e1983dd76114c94616d042ea193af472ba68da9a2d661"
+           "3aac92bcf2babadf7cc715764eb999ad04ba7bb2458ddce422530373d027b779"
+           "ccc2d555c16bd76fdec8b281fb75c94833aeb46ea81a0ce8e1c6846a5fb2f77f"
+           "1555826ee36bcd092a6de77f97b925c2c2bd2e0ba907e168d971b8e196496864"
+           "17e205bb55a07a35d6b7359157048b89ec85154537bf5749638595cfb6690c04"
+           "825d1776af5a4957c070b97c3905a3bc65cd7b19eb61950b2852808354ad7abd"
+           "8d4b01d9a0a67e6389de4058b2137c7bf009482b1a2574854f3679cab92d6d10"
+           "06b8803fc2e61e364a505767932c7bbad3c7b16831158f2241e9c103e2e2a795"
+           "74258397b88916149789b4b5b59d94c603b24a2a112280140a6691b3c990f740"
+           "55b9a46a12c0e9c3aedd4a3f21a7a6474b0a0eb735bd455d776cafc0723f44c4"
+           "3bbac39488699b8a9c38fb65a833490a6dc3b4a6fc82223cbd55a28959979f99"
+           "79c07d37a40e62217d4b56f263bb731a8bc2031088266cb86999978a052ca033"
+           "19f96b07622346a829e628746eb4a377fa5ed3a0a4f8d9b0b33643b0d7bfc944"
+           "8b7e93b0786243b09ab984451d36a25a565c3bbb825698c56ff535b7b7130be2"
+           "67599a0b5a762c18572b6689ca704cd79794e524e9a20b38b64d3ba3b22dd594"
+           "c875ab75630927674412c155c826bde12c73a0b48f26c96a45c908e10bba2722"
+           "5414c21224781309d7a264290193815d646a3d99aa8fdca735c94c9c07412714"
+           "d650062232a2ab9aa766ada47aafba0083f613a383c68ad7c6505e052e9ed4c5"
+           "c07a2f6d267d35b700735c4a99b7bc4825938f5584be87404054164fab9f1eeb"
+           "c8a3e0b5a3a8cb34966ba84c320638c5a5c04f33bc45fc3a624b68a67160cd8e"
+           "f2a3d2b41fc4c9131532809521838d521be9681b81dc2c11475c60162cc7c07c"
+           "4439825d32820432205778904ef20795c56e6711406a885b8c9032e2725bf642"
+           "1dc0a9107c8a2c9b490ffb0ab28579a81996c92b645c47111c57b2100628764c"
+           "860b9a125894e52ade70c464a4902dc1675b64aea01a7b3064b099f46153fa20"
+           "6da58498b20f8b17178b7a20f06800b9f0cf3f59c912f5085cf345053b8895f4"
+           "b2db898a42b058c5c62eb0c541ada459aef6bd9948b8ff509537ab15503034d0"
+           "a410edaa03f4d490f1421c0bec48388325e402a59614626875cc8d2c481dd904"
+           "8a177e9b906fc450387061085ba73e2f1b49e58bca05bda09173f856df8bc38c",
+         /* Bob's public key (ciphertext) */
+         "0x36e7a4b7c91ac490a1d3d6aa2ac6d5e4adb45fca0ee6c62b8547bb3aee161fc3"
+           "42126259191d5251540e98774988c6968ab8653e7abb5091e3500dbb4e878279"
+           "26239ce564676647743a052fc860d43608fc0ea6d3b1d546cf493bf78d0c0db9"
+           "0082e6f27f801d7684697154b5f6a72942f3afb2d7a5871871f90a2579849ef4"
+           "a68b40f4da97694e1820d7a4d9db24a42a73ba358392cf70211ed7a7f032370b"
+           "ff37ac4ae6bf3fd0faa4c653bbe69c5a1a1deee73f6feb5af0c816803401be54"
+           "49b2c57088ef7c3f675fa74d55e4d7e7cf3b55c616980337bbac573e9d38b390"
+           "579a057248b579cfa0e1be4b0b1b5354fadf3c8539f3da31b626b2bb0686ffec"
+           "bca3f58aafbcea252d7f8f1f72b07c15ab00751343a749599193a5f2837d2e5d"
+           "8ae81f3e10cfdd3c17db6b6e74b7e2f58be3022b773f72f3a77b6b5a1f8ddf9d"
+           "50e1bb16b42babd305826419cd85bb114ea64d3201f9921618065fe8d67a3856"
+           "7591cd497cd7c27c19314cbfb8ab9a62370c16b98efaee8cd57d5c07538d8361"
+           "78261a1baf5f70c4818284a9e881793e89140961fe1794d9d0767ad87e069650"
+           "8300043c1103447872e9888548ad0c9fa45143db7863c2572e16e5d9a8c247be"
+           "26bb1040e114a553126a78b0c4da6b7c54d093b918288af75bcadd8f99bcb501"
+           "dc670d0602e5760f752ae1822c2f204997231885a5d0bc032ca70349b9250bca"
+           "6257fd18e7f79ad99dc6eac782e4f8c9efbb4e26f531b001b131ea95aab588a1"
+           "5a14f372876b9b53559d7da70067066a5a4c53efac21639aae022d5655fad79f"
+           "3aecb7e5dc705bed493140ed96d95ca880c497a2bab75ceae91ffb91e2f84077"
+           "709bffd6923aed5496717a5c6dc23213b6a2035bccc1808d88dfae954cb9e8d0"
+           "cb09c0989c03ea5c272e9547195ddc0387fa27c7a40ac8248defcc7a8c9486ed"
+           "ac809218bfdb679e5979c76624ac5f37c8dd8edaa78faf10ddec41993cae9376"
+           "dcc5584866afeb35b287e6f22cae8baf99b602e977f326c2477aed5155ba0441"
+           "67e2c6b45f60dcbd6ed2882fcf69f2260550404aa3318b907fbac172881bea54"
+           "3b040f733ff99caf72bf692de05cb56690d1f3c646e58b1efa27994855d2a1b2"
+           "9481c8cd890730f3ecd6db82db1b06fb6a5a2b8cf56288e512a91571ac6b3e5d"
+           "bd09f29b8b155011092ad5fae69d9ada75cd98136770dc96ed888092cf3904c1"
+           "8350eff7080e4af28430d997f6740ed970b035e5e45a50932484eaa978eae811"
+           "a94c334a3f39353da71db5d02375ce325fb863a751adcc5de539e46f58193d07"
+           "f5ef7c3e5550a55619f2cb9991533a1923e1d6347fd7a9124ea2258e3185552e"
+           "83b7ee930690b673c58f8a331d064f3d24d27d961ae2c1b3e3f1bcf2be1ea030"
+           "6e484547401d7c19df8f06619a5ecda626e7d8bc069ff0cb3079262d25ab674a"
+           "a02e0423715b858c949d73a217117a89078e033e962e9f51be1e5ba673cf9fd9"
+           "1eca9c0d1964baef1bf9838f38fbc1092b83712442e9feef7a15471c4cc05737",
+         /* Shared secret */
+         "0xe91377840e6b6694eaa9f01c97ff68874e8b0c520b00c2cde37c4fc239626e70");
+    check_dh
+        (NOISE_DH_MLKEM768, 32, 1088, 1184, 32, "MLKEM768",
+         0, NOISE_ROLE_RESPONDER,
+         /* Bob's private key (m) */
+         "0xbac5ba881dd35c59719670004692d675b83c98db6a0e55800bafeb7e70491bf4",
+         /* Bob's public key (ciphertext) */
+         "0x36e7a4b7c91ac490a1d3d6aa2ac6d5e4adb45fca0ee6c62b8547bb3aee161fc3"
+           "42126259191d5251540e98774988c6968ab8653e7abb5091e3500dbb4e878279"
+           "26239ce564676647743a052fc860d43608fc0ea6d3b1d546cf493bf78d0c0db9"
+           "0082e6f27f801d7684697154b5f6a72942f3afb2d7a5871871f90a2579849ef4"
+           "a68b40f4da97694e1820d7a4d9db24a42a73ba358392cf70211ed7a7f032370b"
+           "ff37ac4ae6bf3fd0faa4c653bbe69c5a1a1deee73f6feb5af0c816803401be54"
+           "49b2c57088ef7c3f675fa74d55e4d7e7cf3b55c616980337bbac573e9d38b390"
+           "579a057248b579cfa0e1be4b0b1b5354fadf3c8539f3da31b626b2bb0686ffec"
+           "bca3f58aafbcea252d7f8f1f72b07c15ab00751343a749599193a5f2837d2e5d"
+           "8ae81f3e10cfdd3c17db6b6e74b7e2f58be3022b773f72f3a77b6b5a1f8ddf9d"
+           "50e1bb16b42babd305826419cd85bb114ea64d3201f9921618065fe8d67a3856"
+           "7591cd497cd7c27c19314cbfb8ab9a62370c16b98efaee8cd57d5c07538d8361"
+           "78261a1baf5f70c4818284a9e881793e89140961fe1794d9d0767ad87e069650"
+           "8300043c1103447872e9888548ad0c9fa45143db7863c2572e16e5d9a8c247be"
+           "26bb1040e114a553126a78b0c4da6b7c54d093b918288af75bcadd8f99bcb501"
+           "dc670d0602e5760f752ae1822c2f204997231885a5d0bc032ca70349b9250bca"
+           "6257fd18e7f79ad99dc6eac782e4f8c9efbb4e26f531b001b131ea95aab588a1"
+           "5a14f372876b9b53559d7da70067066a5a4c53efac21639aae022d5655fad79f"
+           "3aecb7e5dc705bed493140ed96d95ca880c497a2bab75ceae91ffb91e2f84077"
+           "709bffd6923aed5496717a5c6dc23213b6a2035bccc1808d88dfae954cb9e8d0"
+           "cb09c0989c03ea5c272e9547195ddc0387fa27c7a40ac8248defcc7a8c9486ed"
+           "ac809218bfdb679e5979c76624ac5f37c8dd8edaa78faf10ddec41993cae9376"
+           "dcc5584866afeb35b287e6f22cae8baf99b602e977f326c2477aed5155ba0441"
+           "67e2c6b45f60dcbd6ed2882fcf69f2260550404aa3318b907fbac172881bea54"
+           "3b040f733ff99caf72bf692de05cb56690d1f3c646e58b1efa27994855d2a1b2"
+           "9481c8cd890730f3ecd6db82db1b06fb6a5a2b8cf56288e512a91571ac6b3e5d"
+           "bd09f29b8b155011092ad5fae69d9ada75cd98136770dc96ed888092cf3904c1"
+           "8350eff7080e4af28430d997f6740ed970b035e5e45a50932484eaa978eae811"
+           "a94c334a3f39353da71db5d02375ce325fb863a751adcc5de539e46f58193d07"
+           "f5ef7c3e5550a55619f2cb9991533a1923e1d6347fd7a9124ea2258e3185552e"
+           "83b7ee930690b673c58f8a331d064f3d24d27d961ae2c1b3e3f1bcf2be1ea030"
+           "6e484547401d7c19df8f06619a5ecda626e7d8bc069ff0cb3079262d25ab674a"
+           "a02e0423715b858c949d73a217117a89078e033e962e9f51be1e5ba673cf9fd9"
+           "1eca9c0d1964baef1bf9838f38fbc1092b83712442e9feef7a15471c4cc05737",
+         /* Alice's public key */
+         "0x693b4b7f22698cc91e65a11198e9448697308f39a1f77cbe0df53245626f3235"
+           "7806c68e4ab8b2182958d0c49339d0b8c15347655b756256935b43ccef66ba7a"
+           "78953e5ca7acb350ccc89a87c86366c77bf0c01f8f472f22a85a9470a82ee054"
+           "ed9563c40b62d9bbc4e41076bbe5b3f1b60c2ba1652fa7aac44c6c26a0608e15"
+           "9a6a104923a64cff90435e1b2383633227675521427678c46352e05ee8b70ac5"
+           "474597c7338b23a577f7517c16c484fa23ed9548b81c35aca6a93600b7666b64"
+           "1436352d07b8d9c73dac463f94abb2e5989668192f01b89aa8568523656b5607"
+           "343a0772d28c47eb436ae01b2b8d08c3a1f03228a966a0f0634733779d46b135"
+           "fc75f5f1b53b54aca38362da71c4246cbdeb08b8c72c2b3ac10eeb40794bb1a1"
+           "0ee4a66ab09b1a41042e1983dd76114c94616d042ea193af472ba68da9a2d661"
+           "3aac92bcf2babadf7cc715764eb999ad04ba7bb2458ddce422530373d027b779"
+           "ccc2d555c16bd76fdec8b281fb75c94833aeb46ea81a0ce8e1c6846a5fb2f77f"
+           "1555826ee36bcd092a6de77f97b925c2c2bd2e0ba907e168d971b8e196496864"
+           "17e205bb55a07a35d6b7359157048b89ec85154537bf5749638595cfb6690c04"
+           "825d1776af5a4957c070b97c3905a3bc65cd7b19eb61950b2852808354ad7abd"
+           "8d4b01d9a0a67e6389de4058b2137c7bf009482b1a2574854f3679cab92d6d10"
+           "06b8803fc2e61e364a505767932c7bbad3c7b16831158f2241e9c103e2e2a795"
+           "74258397b88916149789b4b5b59d94c603b24a2a112280140a6691b3c990f740"
+           "55b9a46a12c0e9c3aedd4a3f21a7a6474b0a0eb735bd455d776cafc0723f44c4"
+           "3bbac39488699b8a9c38fb65a833490a6dc3b4a6fc82223cbd55a28959979f99"
+           "79c07d37a40e62217d4b56f263bb731a8bc2031088266cb86999978a052ca033"
+           "19f96b07622346a829e628746eb4a377fa5ed3a0a4f8d9b0b33643b0d7bfc944"
+           "8b7e93b0786243b09ab984451d36a25a565c3bbb825698c56ff535b7b7130be2"
+           "67599a0b5a762c18572b6689ca704cd79794e524e9a20b38b64d3ba3b22dd594"
+           "c875ab75630927674412c155c826bde12c73a0b48f26c96a45c908e10bba2722"
+           "5414c21224781309d7a264290193815d646a3d99aa8fdca735c94c9c07412714"
+           "d650062232a2ab9aa766ada47aafba0083f613a383c68ad7c6505e052e9ed4c5"
+           "c07a2f6d267d35b700735c4a99b7bc4825938f5584be87404054164fab9f1eeb"
+           "c8a3e0b5a3a8cb34966ba84c320638c5a5c04f33bc45fc3a624b68a67160cd8e"
+           "f2a3d2b41fc4c9131532809521838d521be9681b81dc2c11475c60162cc7c07c"
+           "4439825d32820432205778904ef20795c56e6711406a885b8c9032e2725bf642"
+           "1dc0a9107c8a2c9b490ffb0ab28579a81996c92b645c47111c57b2100628764c"
+           "860b9a125894e52ade70c464a4902dc1675b64aea01a7b3064b099f46153fa20"
+           "6da58498b20f8b17178b7a20f06800b9f0cf3f59c912f5085cf345053b8895f4"
+           "b2db898a42b058c5c62eb0c541ada459aef6bd9948b8ff509537ab15503034d0"
+           "a410edaa03f4d490f1421c0bec48388325e402a59614626875cc8d2c481dd904"
+           "8a177e9b906fc450387061085ba73e2f1b49e58bca05bda09173f856df8bc38c",
+         /* Shared secret */
+         "0xe91377840e6b6694eaa9f01c97ff68874e8b0c520b00c2cde37c4fc239626e70");
 }
 
 /* Check the generation and use of new key pairs */
@@ -665,11 +829,7 @@ static void check_dh_generate(int id)
 
     /* Generate keypairs for Alice and Bob */
     compare(noise_dhstate_generate_keypair(state1), NOISE_ERROR_NONE);
-    if (id != NOISE_DH_NEWHOPE) {
-        verify(!noise_dhstate_is_ephemeral_only(state1));
-        verify(!noise_dhstate_is_ephemeral_only(state2));
-        compare(noise_dhstate_generate_keypair(state2), NOISE_ERROR_NONE);
-    } else {
+    if (id == NOISE_DH_NEWHOPE) {
         /* Check the NewHope parameters */
         verify(noise_dhstate_is_ephemeral_only(state1));
         verify(noise_dhstate_is_ephemeral_only(state2));
@@ -683,6 +843,22 @@ static void check_dh_generate(int id)
          * parameters in Alice's public key. */
         compare(noise_dhstate_generate_dependent_keypair(state2, state1),
                 NOISE_ERROR_NONE);
+    } else if (id == NOISE_DH_MLKEM768) {
+        /* Check the ML-KEM parameters */
+        verify(noise_dhstate_is_ephemeral_only(state1));
+        verify(noise_dhstate_is_ephemeral_only(state2));
+        compare(noise_dhstate_get_private_key_length(state1), 64);
+        compare(noise_dhstate_get_public_key_length(state1), 1184);
+        compare(noise_dhstate_get_private_key_length(state2), 32);
+        compare(noise_dhstate_get_public_key_length(state2), 1088);
+
+        /* Bob's "keypair" is an encapsulation against Alice's public key */
+        compare(noise_dhstate_generate_dependent_keypair(state2, state1),
+                NOISE_ERROR_NONE);
+    } else {
+        verify(!noise_dhstate_is_ephemeral_only(state1));
+        verify(!noise_dhstate_is_ephemeral_only(state2));
+        compare(noise_dhstate_generate_keypair(state2), NOISE_ERROR_NONE);
     }
 
     /* Calculate the shared key on both ends and compare */
@@ -708,12 +884,14 @@ static void dhstate_check_generate_keypair(void)
     check_dh_generate(NOISE_DH_CURVE25519);
     check_dh_generate(NOISE_DH_CURVE448);
     check_dh_generate(NOISE_DH_NEWHOPE);
+    check_dh_generate(NOISE_DH_MLKEM768);
 }
 
 /* Check other error conditions that can be reported by the functions */
 static void dhstate_check_errors(void)
 {
     NoiseDHState *state;
+    uint8_t public_key[1184];
 
     /* NULL parameters in various positions */
     compare(noise_dhstate_free(0), NOISE_ERROR_INVALID_PARAM);
@@ -743,6 +921,19 @@ static void dhstate_check_errors(void)
     compare(noise_dhstate_new_by_name(&state, "Curve25519"), /* Should be "25519" */
             NOISE_ERROR_UNKNOWN_NAME);
     verify(state == NULL);
+
+    /* ML-KEM encapsulation keys must have all coefficients less than q */
+    compare(noise_dhstate_new_by_id(&state, NOISE_DH_MLKEM768),
+            NOISE_ERROR_NONE);
+    memset(public_key, 0, sizeof(public_key));
+    public_key[0] = 0x00;
+    public_key[1] = 0x0D;   /* 3328 */
+    compare(noise_dhstate_set_public_key(state, public_key, sizeof(public_key)),
+            NOISE_ERROR_NONE);
+    public_key[0] = 0x01;   /* 3329 */
+    compare(noise_dhstate_set_public_key(state, public_key, sizeof(public_key)),
+            NOISE_ERROR_INVALID_PUBLIC_KEY);
+    compare(noise_dhstate_free(state), NOISE_ERROR_NONE);
 }
 
 void test_dhstate(void)
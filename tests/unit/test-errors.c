@@ -23,7 +23,7 @@
 #include "test-helpers.h"
 
 #define NOISE_MIN_ERROR     NOISE_ID('E', 1)
-#define NOISE_MAX_ERROR     NOISE_ID('E', 17)
+#define NOISE_MAX_ERROR     NOISE_ID('E', 21)
 
 void test_errors(void)
 {
@@ -94,5 +94,9 @@ void test_errors(void)
         dump_error(NOISE_ERROR_INVALID_PUBLIC_KEY);
         dump_error(NOISE_ERROR_INVALID_FORMAT);
         dump_error(NOISE_ERROR_INVALID_SIGNATURE);
+        dump_error(NOISE_ERROR_SELF_CHECK_FAILED);
+        dump_error(NOISE_ERROR_KEY_REVOKED);
+        dump_error(NOISE_ERROR_TICKET_EXPIRED);
+        dump_error(NOISE_ERROR_COOKIE_REQUIRED);
     }
 }
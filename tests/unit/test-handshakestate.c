@@ -473,6 +473,124 @@ static void handshakestate_check_protocols(void)
     check_handshake_protocol("NoisePSK_IX_448_AESGCM_SHA512");
 }
 
+/* Run a simple two-party handshake to the "split" stage */
+static void run_handshake_to_split
+    (NoiseHandshakeState *initiator, NoiseHandshakeState *responder)
+{
+    NoiseHandshakeState *send;
+    NoiseHandshakeState *recv;
+    uint8_t message[4096];
+    NoiseBuffer mbuf;
+    int action;
+
+    compare(noise_handshakestate_start(initiator), NOISE_ERROR_NONE);
+    compare(noise_handshakestate_start(responder), NOISE_ERROR_NONE);
+    for (;;) {
+        action = noise_handshakestate_get_action(initiator);
+        if (action == NOISE_ACTION_WRITE_MESSAGE) {
+            send = initiator;
+            recv = responder;
+        } else if (action == NOISE_ACTION_READ_MESSAGE) {
+            send = responder;
+            recv = initiator;
+        } else {
+            break;
+        }
+        noise_buffer_set_output(mbuf, message, sizeof(message));
+        compare(noise_handshakestate_write_message(send, &mbuf, 0),
+                NOISE_ERROR_NONE);
+        compare(noise_handshakestate_read_message(recv, &mbuf, 0),
+                NOISE_ERROR_NONE);
+    }
+    compare(noise_handshakestate_get_action(initiator), NOISE_ACTION_SPLIT);
+    compare(noise_handshakestate_get_action(responder), NOISE_ACTION_SPLIT);
+}
+
+/* Check that a packet encrypted by one CipherState decrypts with another */
+static void check_cipher_pair(NoiseCipherState *c1, NoiseCipherState *c2)
+{
+    uint8_t packet[64];
+    NoiseBuffer mbuf;
+
+    verify(c1 != 0);
+    verify(c2 != 0);
+    memset(packet, 0x5A, 16);
+    noise_buffer_set_inout(mbuf, packet, 16, sizeof(packet));
+    compare(noise_cipherstate_encrypt(c1, &mbuf), NOISE_ERROR_NONE);
+    compare(noise_cipherstate_decrypt(c2, &mbuf), NOISE_ERROR_NONE);
+    compare(mbuf.size, 16);
+    compare(packet[0], 0x5A);
+    compare(packet[15], 0x5A);
+}
+
+/* Check splitting a batch of handshakes with mixed algorithms */
+static void handshakestate_check_split_multi(void)
+{
+    static const char * const names[] = {
+        "Noise_NN_25519_ChaChaPoly_BLAKE2s",
+        "Noise_NN_25519_ChaChaPoly_SHA256",
+        "Noise_NN_25519_AESGCM_BLAKE2b"
+    };
+    #define NUM_SPLIT_MULTI 22
+    NoiseHandshakeState *initiators[NUM_SPLIT_MULTI];
+    NoiseHandshakeState *responders[NUM_SPLIT_MULTI];
+    NoiseCipherState *send[NUM_SPLIT_MULTI];
+    NoiseCipherState *receive[NUM_SPLIT_MULTI];
+    NoiseCipherState *rsend;
+    NoiseCipherState *rreceive;
+    size_t index;
+
+    /* Runs of 9, 10, and 3 handshakes with the same algorithms, which
+       exercise both full and partial groups of lanes */
+    for (index = 0; index < NUM_SPLIT_MULTI; ++index) {
+        const char *name = names[index < 9 ? 0 : (index < 19 ? 1 : 2)];
+        data_name = name;
+        compare(noise_handshakestate_new_by_name
+                    (&(initiators[index]), name, NOISE_ROLE_INITIATOR),
+                NOISE_ERROR_NONE);
+        compare(noise_handshakestate_new_by_name
+                    (&(responders[index]), name, NOISE_ROLE_RESPONDER),
+                NOISE_ERROR_NONE);
+        run_handshake_to_split(initiators[index], responders[index]);
+    }
+    data_name = "split_multi";
+
+    /* Cannot split if one of the handshakes is not ready */
+    compare(noise_handshakestate_split_multi(0, send, receive, 1),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_handshakestate_split_multi(initiators, 0, 0, 1),
+            NOISE_ERROR_INVALID_PARAM);
+
+    /* Split the initiators as a batch and the responders one at a time */
+    compare(noise_handshakestate_split_multi
+                (initiators, send, receive, NUM_SPLIT_MULTI),
+            NOISE_ERROR_NONE);
+    for (index = 0; index < NUM_SPLIT_MULTI; ++index) {
+        compare(noise_handshakestate_get_action(initiators[index]),
+                NOISE_ACTION_COMPLETE);
+        compare(noise_handshakestate_split
+                    (responders[index], &rsend, &rreceive),
+                NOISE_ERROR_NONE);
+        check_cipher_pair(send[index], rreceive);
+        check_cipher_pair(rsend, receive[index]);
+        noise_cipherstate_free(send[index]);
+        noise_cipherstate_free(receive[index]);
+        noise_cipherstate_free(rsend);
+        noise_cipherstate_free(rreceive);
+    }
+
+    /* Cannot split the batch a second time */
+    compare(noise_handshakestate_split_multi
+                (initiators, send, receive, NUM_SPLIT_MULTI),
+            NOISE_ERROR_INVALID_STATE);
+
+    /* Clean up */
+    for (index = 0; index < NUM_SPLIT_MULTI; ++index) {
+        noise_handshakestate_free(initiators[index]);
+        noise_handshakestate_free(responders[index]);
+    }
+}
+
 /* Check that "IK" correctly falls back to "XXfallback" */
 static void check_fallback_protocol
     (const char *name, int fallback_anyway, int trial_initiator_decrypt)
@@ -666,6 +784,415 @@ static void handshakestate_check_fallback(void)
     check_fallback_protocol("Noise_IK_448_ChaChaPoly_BLAKE2b", 0, 1);
 }
 
+/* Run a hybrid handshake and check the shape of the first message */
+static void check_hybrid_protocol(const char *name)
+{
+    NoiseHandshakeState *initiator;
+    NoiseHandshakeState *responder;
+    NoiseCipherState *isend, *ireceive;
+    NoiseCipherState *rsend, *rreceive;
+    NoiseProtocolId id;
+    NoiseDHState *dh;
+    NoiseDHState *hybrid;
+    uint8_t ihash[64];
+    uint8_t rhash[64];
+    uint8_t message[4096];
+    NoiseBuffer mbuf;
+    size_t expected;
+    int role;
+
+    /* Set the name of this test for error reporting */
+    data_name = name;
+    compare(noise_protocol_name_to_id(&id, name, strlen(name)),
+            NOISE_ERROR_NONE);
+    verify(id.hybrid_id != 0);
+
+    /* Create the two objects and give them static keys and a PSK */
+    compare(noise_handshakestate_new_by_name
+                (&initiator, name, NOISE_ROLE_INITIATOR),
+            NOISE_ERROR_NONE);
+    compare(noise_handshakestate_new_by_id
+                (&responder, &id, NOISE_ROLE_RESPONDER),
+            NOISE_ERROR_NONE);
+    if (noise_handshakestate_needs_local_keypair(responder) ||
+            noise_handshakestate_needs_remote_public_key(initiator)) {
+        compare(noise_dhstate_generate_keypair
+                    (noise_handshakestate_get_local_keypair_dh(responder)),
+                NOISE_ERROR_NONE);
+    }
+    if (noise_handshakestate_needs_remote_public_key(initiator)) {
+        dh = noise_handshakestate_get_local_keypair_dh(responder);
+        compare(noise_dhstate_get_public_key
+                    (dh, message, noise_dhstate_get_public_key_length(dh)),
+                NOISE_ERROR_NONE);
+        compare(noise_dhstate_set_public_key
+                    (noise_handshakestate_get_remote_public_key_dh(initiator),
+                     message, noise_dhstate_get_public_key_length(dh)),
+                NOISE_ERROR_NONE);
+    }
+    if (noise_handshakestate_needs_local_keypair(initiator)) {
+        compare(noise_dhstate_generate_keypair
+                    (noise_handshakestate_get_local_keypair_dh(initiator)),
+                NOISE_ERROR_NONE);
+    }
+    if (noise_handshakestate_needs_pre_shared_key(initiator)) {
+        compare(noise_handshakestate_set_pre_shared_key
+                    (initiator, psk, sizeof(psk)),
+                NOISE_ERROR_NONE);
+        compare(noise_handshakestate_set_pre_shared_key
+                    (responder, psk, sizeof(psk)),
+                NOISE_ERROR_NONE);
+    }
+
+    /* The first message carries both ephemeral public keys back to back,
+       followed by the initiator's static key and the empty payload */
+    compare(noise_handshakestate_start(initiator), NOISE_ERROR_NONE);
+    compare(noise_handshakestate_start(responder), NOISE_ERROR_NONE);
+    noise_buffer_set_output(mbuf, message, sizeof(message));
+    compare(noise_handshakestate_write_message(initiator, &mbuf, 0),
+            NOISE_ERROR_NONE);
+    compare(noise_dhstate_new_by_id(&dh, id.dh_id), NOISE_ERROR_NONE);
+    compare(noise_dhstate_new_by_id(&hybrid, id.hybrid_id), NOISE_ERROR_NONE);
+    expected = noise_dhstate_get_public_key_length(dh) +
+               noise_dhstate_get_public_key_length(hybrid);
+    if (id.pattern_id == NOISE_PATTERN_IK ||
+            id.pattern_id == NOISE_PATTERN_IX) {
+        expected += noise_dhstate_get_public_key_length(dh) + 16;
+    }
+    if (id.pattern_id == NOISE_PATTERN_IK ||
+            id.prefix_id == NOISE_PREFIX_PSK) {
+        expected += 16;
+    }
+    compare(mbuf.size, expected);
+    noise_dhstate_free(dh);
+    noise_dhstate_free(hybrid);
+
+    /* Finish the handshake and check that both sides agree */
+    compare(noise_handshakestate_read_message(responder, &mbuf, 0),
+            NOISE_ERROR_NONE);
+    for (;;) {
+        role = noise_handshakestate_get_action(responder);
+        if (role == NOISE_ACTION_WRITE_MESSAGE) {
+            noise_buffer_set_output(mbuf, message, sizeof(message));
+            compare(noise_handshakestate_write_message(responder, &mbuf, 0),
+                    NOISE_ERROR_NONE);
+            compare(noise_handshakestate_read_message(initiator, &mbuf, 0),
+                    NOISE_ERROR_NONE);
+        } else if (role == NOISE_ACTION_READ_MESSAGE) {
+            noise_buffer_set_output(mbuf, message, sizeof(message));
+            compare(noise_handshakestate_write_message(initiator, &mbuf, 0),
+                    NOISE_ERROR_NONE);
+            compare(noise_handshakestate_read_message(responder, &mbuf, 0),
+                    NOISE_ERROR_NONE);
+        } else {
+            break;
+        }
+    }
+    compare(noise_handshakestate_get_action(initiator), NOISE_ACTION_SPLIT);
+    compare(noise_handshakestate_get_action(responder), NOISE_ACTION_SPLIT);
+    compare(noise_handshakestate_get_handshake_hash
+                (initiator, ihash, sizeof(ihash)),
+            NOISE_ERROR_NONE);
+    compare(noise_handshakestate_get_handshake_hash
+                (responder, rhash, sizeof(rhash)),
+            NOISE_ERROR_NONE);
+    verify(!memcmp(ihash, rhash, sizeof(ihash)));
+    compare(noise_handshakestate_split(initiator, &isend, &ireceive),
+            NOISE_ERROR_NONE);
+    compare(noise_handshakestate_split(responder, &rsend, &rreceive),
+            NOISE_ERROR_NONE);
+    check_cipher_pair(isend, rreceive);
+    check_cipher_pair(rsend, ireceive);
+    noise_cipherstate_free(isend);
+    noise_cipherstate_free(ireceive);
+    noise_cipherstate_free(rsend);
+    noise_cipherstate_free(rreceive);
+    noise_handshakestate_free(initiator);
+    noise_handshakestate_free(responder);
+}
+
+/* Check that tampering with the hybrid key in "NN" is detected */
+static void check_hybrid_tamper(const char *name)
+{
+    NoiseHandshakeState *initiator;
+    NoiseHandshakeState *responder;
+    uint8_t message[4096];
+    NoiseBuffer mbuf;
+    size_t offset;
+
+    data_name = name;
+    compare(noise_handshakestate_new_by_name
+                (&initiator, name, NOISE_ROLE_INITIATOR),
+            NOISE_ERROR_NONE);
+    compare(noise_handshakestate_new_by_name
+                (&responder, name, NOISE_ROLE_RESPONDER),
+            NOISE_ERROR_NONE);
+    compare(noise_handshakestate_start(initiator), NOISE_ERROR_NONE);
+    compare(noise_handshakestate_start(responder), NOISE_ERROR_NONE);
+
+    /* The responder's "e, ee" message is authenticated by its payload MAC,
+       which covers the hybrid key and the hybrid shared secret */
+    noise_buffer_set_output(mbuf, message, sizeof(message));
+    compare(noise_handshakestate_write_message(initiator, &mbuf, 0),
+            NOISE_ERROR_NONE);
+    compare(noise_handshakestate_read_message(responder, &mbuf, 0),
+            NOISE_ERROR_NONE);
+    noise_buffer_set_output(mbuf, message, sizeof(message));
+    compare(noise_handshakestate_write_message(responder, &mbuf, 0),
+            NOISE_ERROR_NONE);
+    offset = noise_dhstate_get_public_key_length
+        (noise_handshakestate_get_local_keypair_dh(initiator)) + 5;
+    message[offset] ^= 0x01;
+    compare(noise_handshakestate_read_message(initiator, &mbuf, 0),
+            NOISE_ERROR_MAC_FAILURE);
+    compare(noise_handshakestate_get_action(initiator), NOISE_ACTION_FAILED);
+    noise_handshakestate_free(initiator);
+    noise_handshakestate_free(responder);
+}
+
+static void handshakestate_check_hybrid(void)
+{
+    NoiseHandshakeState *state;
+    NoiseDHState *dh;
+
+    check_hybrid_protocol("Noise_NN_25519+NewHope_ChaChaPoly_BLAKE2s");
+    check_hybrid_protocol("NoisePSK_NN_25519+NewHope_AESGCM_SHA256");
+    check_hybrid_protocol("Noise_XX_25519+NewHope_ChaChaPoly_BLAKE2b");
+    check_hybrid_protocol("Noise_IK_25519+MLKEM768_AESGCM_SHA512");
+    check_hybrid_protocol("NoisePSK_IX_448+MLKEM768_ChaChaPoly_BLAKE2s");
+    check_hybrid_tamper("Noise_NN_25519+NewHope_ChaChaPoly_BLAKE2s");
+    check_hybrid_tamper("Noise_NN_448+MLKEM768_AESGCM_SHA256");
+
+    /* Patterns without an "ee" and fallback patterns cannot be hybrid */
+    data_name = "hybrid_errors";
+    state = (NoiseHandshakeState *)8;
+    compare(noise_handshakestate_new_by_name
+                (&state, "Noise_N_25519+NewHope_ChaChaPoly_BLAKE2s",
+                 NOISE_ROLE_INITIATOR),
+            NOISE_ERROR_NOT_APPLICABLE);
+    verify(state == NULL);
+    compare(noise_handshakestate_new_by_name
+                (&state, "Noise_X_25519+MLKEM768_ChaChaPoly_BLAKE2s",
+                 NOISE_ROLE_RESPONDER),
+            NOISE_ERROR_NOT_APPLICABLE);
+    compare(noise_handshakestate_new_by_name
+                (&state, "Noise_XXfallback_25519+NewHope_ChaChaPoly_BLAKE2s",
+                 NOISE_ROLE_INITIATOR),
+            NOISE_ERROR_NOT_APPLICABLE);
+
+    /* A hybrid "IK" handshake cannot fall back to "XXfallback" */
+    compare(noise_handshakestate_new_by_name
+                (&state, "Noise_IK_25519+NewHope_ChaChaPoly_BLAKE2s",
+                 NOISE_ROLE_RESPONDER),
+            NOISE_ERROR_NONE);
+    compare(noise_handshakestate_fallback(state), NOISE_ERROR_NOT_APPLICABLE);
+
+    /* Only hybrid protocols have a fixed hybrid ephemeral key for tests */
+    dh = noise_handshakestate_get_fixed_hybrid_ephemeral_dh(state);
+    verify(dh != 0);
+    compare(noise_dhstate_get_dh_id(dh), NOISE_DH_NEWHOPE);
+    compare(noise_dhstate_get_role(dh), NOISE_ROLE_RESPONDER);
+    verify(noise_handshakestate_get_fixed_hybrid_ephemeral_dh(state) == dh);
+    noise_handshakestate_free(state);
+    compare(noise_handshakestate_new_by_name
+                (&state, "Noise_IK_25519_ChaChaPoly_BLAKE2s",
+                 NOISE_ROLE_RESPONDER),
+            NOISE_ERROR_NONE);
+    verify(noise_handshakestate_get_fixed_hybrid_ephemeral_dh(state) == 0);
+    noise_handshakestate_free(state);
+}
+
+/* Sets the static keys and pre-shared key that a party needs */
+static void set_party_keys(NoiseHandshakeState *state)
+{
+    int is_initiator =
+        (noise_handshakestate_get_role(state) == NOISE_ROLE_INITIATOR);
+    NoiseDHState *dh;
+    if (noise_handshakestate_needs_local_keypair(state)) {
+        dh = noise_handshakestate_get_local_keypair_dh(state);
+        if (noise_dhstate_get_dh_id(dh) == NOISE_DH_CURVE25519) {
+            compare(noise_dhstate_set_keypair_private
+                        (dh, is_initiator ? init_private_25519
+                                          : resp_private_25519, 32),
+                    NOISE_ERROR_NONE);
+        } else {
+            compare(noise_dhstate_set_keypair_private
+                        (dh, is_initiator ? init_private_448
+                                          : resp_private_448, 56),
+                    NOISE_ERROR_NONE);
+        }
+    }
+    if (noise_handshakestate_needs_remote_public_key(state)) {
+        dh = noise_handshakestate_get_remote_public_key_dh(state);
+        if (noise_dhstate_get_dh_id(dh) == NOISE_DH_CURVE25519) {
+            compare(noise_dhstate_set_public_key
+                        (dh, is_initiator ? resp_public_25519
+                                          : init_public_25519, 32),
+                    NOISE_ERROR_NONE);
+        } else {
+            compare(noise_dhstate_set_public_key
+                        (dh, is_initiator ? resp_public_448
+                                          : init_public_448, 56),
+                    NOISE_ERROR_NONE);
+        }
+    }
+    if (noise_handshakestate_needs_pre_shared_key(state)) {
+        compare(noise_handshakestate_set_pre_shared_key(state, psk, sizeof(psk)),
+                NOISE_ERROR_NONE);
+    }
+}
+
+/* Exports a HandshakeState and replaces it with the imported copy */
+static void migrate_handshake(NoiseHandshakeState **state)
+{
+    static uint8_t const wrap_key[NOISE_EXPORT_KEY_LEN] = {
+        0x96, 0x87, 0x78, 0x69, 0x5A, 0x4B, 0x3C, 0x2D,
+        0x1E, 0x0F, 0xF0, 0xE1, 0xD2, 0xC3, 0xB4, 0xA5,
+        0x89, 0x9A, 0xAB, 0xBC, 0xCD, 0xDE, 0xEF, 0xF0,
+        0x01, 0x12, 0x23, 0x34, 0x45, 0x56, 0x67, 0x78
+    };
+    uint8_t blob_data[NOISE_MAX_EXPORT_LEN];
+    NoiseHandshakeState *imported;
+    NoiseBuffer blob;
+    int action = noise_handshakestate_get_action(*state);
+    int role = noise_handshakestate_get_role(*state);
+
+    noise_buffer_set_output(blob, blob_data, sizeof(blob_data));
+    compare(noise_handshakestate_export
+                (*state, wrap_key, sizeof(wrap_key), &blob),
+            NOISE_ERROR_NONE);
+    compare(noise_handshakestate_free(*state), NOISE_ERROR_NONE);
+    *state = 0;
+
+    /* A modified blob must be rejected */
+    blob_data[blob.size / 2] ^= 0x10;
+    imported = (NoiseHandshakeState *)8;
+    compare(noise_handshakestate_import
+                (&imported, wrap_key, sizeof(wrap_key), &blob),
+            NOISE_ERROR_MAC_FAILURE);
+    verify(imported == NULL);
+    blob_data[blob.size / 2] ^= 0x10;
+
+    compare(noise_handshakestate_import
+                (&imported, wrap_key, sizeof(wrap_key), &blob),
+            NOISE_ERROR_NONE);
+    compare(noise_handshakestate_get_action(imported), action);
+    compare(noise_handshakestate_get_role(imported), role);
+    *state = imported;
+}
+
+/* Check a handshake where both parties migrate before every message */
+static void check_export_protocol(const char *name)
+{
+    NoiseHandshakeState *initiator;
+    NoiseHandshakeState *responder;
+    NoiseHandshakeState *send;
+    NoiseHandshakeState *recv;
+    NoiseCipherState *c1init;
+    NoiseCipherState *c2init;
+    NoiseCipherState *c1resp;
+    NoiseCipherState *c2resp;
+    uint8_t message[4096];
+    uint8_t payload[23];
+    NoiseBuffer mbuf;
+    NoiseBuffer pbuf;
+    int action;
+
+    data_name = name;
+    compare(noise_handshakestate_new_by_name
+                (&initiator, name, NOISE_ROLE_INITIATOR),
+            NOISE_ERROR_NONE);
+    compare(noise_handshakestate_new_by_name
+                (&responder, name, NOISE_ROLE_RESPONDER),
+            NOISE_ERROR_NONE);
+    set_party_keys(initiator);
+    set_party_keys(responder);
+
+    /* Cannot export before the handshake starts */
+    noise_buffer_set_output(mbuf, message, sizeof(message));
+    compare(noise_handshakestate_export(initiator, psk, sizeof(psk), &mbuf),
+            NOISE_ERROR_INVALID_STATE);
+    compare(noise_handshakestate_start(initiator), NOISE_ERROR_NONE);
+    compare(noise_handshakestate_start(responder), NOISE_ERROR_NONE);
+
+    for (;;) {
+        migrate_handshake(&initiator);
+        migrate_handshake(&responder);
+        action = noise_handshakestate_get_action(initiator);
+        if (action == NOISE_ACTION_WRITE_MESSAGE) {
+            send = initiator;
+            recv = responder;
+        } else if (action == NOISE_ACTION_READ_MESSAGE) {
+            send = responder;
+            recv = initiator;
+        } else {
+            break;
+        }
+        memset(payload, 0xA5, sizeof(payload));
+        noise_buffer_set_output(mbuf, message, sizeof(message));
+        noise_buffer_set_input(pbuf, payload, sizeof(payload));
+        compare(noise_handshakestate_write_message(send, &mbuf, &pbuf),
+                NOISE_ERROR_NONE);
+        memset(payload, 0, sizeof(payload));
+        noise_buffer_set_output(pbuf, payload, sizeof(payload));
+        compare(noise_handshakestate_read_message(recv, &mbuf, &pbuf),
+                NOISE_ERROR_NONE);
+        compare(pbuf.size, sizeof(payload));
+        compare(payload[0], 0xA5);
+        compare(payload[22], 0xA5);
+    }
+    compare(noise_handshakestate_get_action(initiator), NOISE_ACTION_SPLIT);
+    compare(noise_handshakestate_get_action(responder), NOISE_ACTION_SPLIT);
+
+    /* The transport keys must match on both sides */
+    compare(noise_handshakestate_split(initiator, &c1init, &c2init),
+            NOISE_ERROR_NONE);
+    compare(noise_handshakestate_split(responder, &c2resp, &c1resp),
+            NOISE_ERROR_NONE);
+    check_cipher_pair(c1init, c1resp);
+    check_cipher_pair(c2resp, c2init);
+    noise_buffer_set_output(mbuf, message, sizeof(message));
+    compare(noise_handshakestate_export(initiator, psk, sizeof(psk), &mbuf),
+            NOISE_ERROR_INVALID_STATE);
+
+    noise_cipherstate_free(c1init);
+    noise_cipherstate_free(c2init);
+    noise_cipherstate_free(c1resp);
+    noise_cipherstate_free(c2resp);
+    noise_handshakestate_free(initiator);
+    noise_handshakestate_free(responder);
+}
+
+/* Check migrating handshakes between processes with export and import */
+static void handshakestate_check_export(void)
+{
+    NoiseHandshakeState *state;
+    uint8_t message[256];
+    NoiseBuffer mbuf;
+
+    check_export_protocol("Noise_NN_25519_ChaChaPoly_BLAKE2s");
+    check_export_protocol("Noise_XX_25519_AESGCM_SHA256");
+    check_export_protocol("Noise_IK_448_ChaChaPoly_BLAKE2b");
+    check_export_protocol("Noise_KK_25519_AESGCM_SHA512");
+    check_export_protocol("Noise_X_448_AESGCM_BLAKE2s");
+    check_export_protocol("NoisePSK_XK_25519_ChaChaPoly_SHA256");
+
+    /* Post-quantum key exchanges cannot be exported */
+    compare(noise_handshakestate_new_by_name
+                (&state, "Noise_NN_NewHope_ChaChaPoly_BLAKE2s",
+                 NOISE_ROLE_INITIATOR),
+            NOISE_ERROR_NONE);
+    compare(noise_handshakestate_start(state), NOISE_ERROR_NONE);
+    noise_buffer_set_output(mbuf, message, sizeof(message));
+    compare(noise_handshakestate_export(state, psk, sizeof(psk), &mbuf),
+            NOISE_ERROR_NOT_APPLICABLE);
+    compare(noise_handshakestate_export(0, psk, sizeof(psk), &mbuf),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_handshakestate_import(0, psk, sizeof(psk), &mbuf),
+            NOISE_ERROR_INVALID_PARAM);
+    noise_handshakestate_free(state);
+}
+
 static void handshakestate_check_errors(void)
 {
     NoiseHandshakeState *state;
@@ -718,5 +1245,8 @@ void test_handshakestate(void)
     handshakestate_derive_keys();
     handshakestate_check_protocols();
     handshakestate_check_fallback();
+    handshakestate_check_split_multi();
+    handshakestate_check_hybrid();
+    handshakestate_check_export();
     handshakestate_check_errors();
 }
@@ -404,9 +404,78 @@ static void check_pbkdf2(const char *name, const char *passphrase,
     noise_hashstate_free(state);
 }
 
+/* Simple implementation of PBKDF2 for cross-checking the library */
+static void pbkdf2(NoiseHashState *state, uint8_t *output, size_t output_len,
+                   const uint8_t *passphrase, size_t passphrase_len,
+                   const uint8_t *salt, size_t salt_len, size_t iterations)
+{
+    size_t hash_len = noise_hashstate_get_hash_length(state);
+    uint8_t input[MAX_HASH_INPUT + 4];
+    uint8_t T[MAX_HASH_OUTPUT];
+    uint8_t U[MAX_HASH_OUTPUT];
+    size_t block, index, posn, len;
+    for (block = 1; output_len > 0; ++block) {
+        memcpy(input, salt, salt_len);
+        input[salt_len] = (uint8_t)(block >> 24);
+        input[salt_len + 1] = (uint8_t)(block >> 16);
+        input[salt_len + 2] = (uint8_t)(block >> 8);
+        input[salt_len + 3] = (uint8_t)block;
+        hmac(state, U, passphrase, passphrase_len, input, salt_len + 4);
+        memcpy(T, U, hash_len);
+        for (index = 1; index < iterations; ++index) {
+            hmac(state, U, passphrase, passphrase_len, U, hash_len);
+            for (posn = 0; posn < hash_len; ++posn)
+                T[posn] ^= U[posn];
+        }
+        len = (output_len < hash_len) ? output_len : hash_len;
+        memcpy(output, T, len);
+        output += len;
+        output_len -= len;
+    }
+}
+
+/* Check PBKDF2 for an algorithm against the simple implementation, with
+   short and long passphrases and outputs that span several blocks */
+static void hashstate_check_pbkdf2_algorithm(int id)
+{
+    static size_t const passphrase_sizes[] = {0, 13, 64, 128, 129, 200};
+    NoiseHashState *state;
+    uint8_t passphrase[200];
+    uint8_t salt[16];
+    uint8_t expected[MAX_HASH_OUTPUT * 3];
+    uint8_t output[MAX_HASH_OUTPUT * 3];
+    size_t hash_len, output_len, index;
+
+    compare(noise_hashstate_new_by_id(&state, id), NOISE_ERROR_NONE);
+    hash_len = noise_hashstate_get_hash_length(state);
+    memset(passphrase, 0x3C, sizeof(passphrase));
+    memset(salt, 0xC3, sizeof(salt));
+    for (index = 0; index < sizeof(passphrase_sizes) / sizeof(size_t); ++index) {
+        for (output_len = 1; output_len <= hash_len * 3;
+                output_len += hash_len - 1) {
+            pbkdf2(state, expected, output_len, passphrase,
+                   passphrase_sizes[index], salt, sizeof(salt), 5);
+            memset(output, 0xAA, sizeof(output));
+            compare(noise_hashstate_pbkdf2
+                        (state, passphrase, passphrase_sizes[index],
+                         salt, sizeof(salt), 5, output, output_len),
+                    NOISE_ERROR_NONE);
+            verify(!memcmp(output, expected, output_len));
+            if (output_len < sizeof(output))
+                compare(output[output_len], 0xAA);
+        }
+    }
+    noise_hashstate_free(state);
+}
+
 /* Check the behaviour of the noise_hashstate_pbkdf2() function */
 static void hashstate_check_pbkdf2(void)
 {
+    hashstate_check_pbkdf2_algorithm(NOISE_HASH_BLAKE2s);
+    hashstate_check_pbkdf2_algorithm(NOISE_HASH_BLAKE2b);
+    hashstate_check_pbkdf2_algorithm(NOISE_HASH_SHA256);
+    hashstate_check_pbkdf2_algorithm(NOISE_HASH_SHA512);
+
     /* Test vectors for PBKDF2-HMAC-SHA-256 from section 11 of
        https://tools.ietf.org/html/draft-josefsson-scrypt-kdf-05 */
     check_pbkdf2("PBKDF2 #1", "passwd", "salt", 1,
@@ -421,6 +490,190 @@ static void hashstate_check_pbkdf2(void)
                    "6a272bdebba1d078478f62b397f33c8d");
 }
 
+/* Fill a buffer with data that depends upon a lane and length */
+static void fill_lane_data(uint8_t *data, size_t len, size_t lane)
+{
+    size_t index;
+    for (index = 0; index < len; ++index)
+        data[index] = (uint8_t)(index * 7 + lane * 31 + len);
+}
+
+#define MULTI_LANES 11
+
+/* Check the multi-buffer functions against the single-buffer ones
+   for the currently selected backend of an algorithm */
+static void check_multi_backend(int id)
+{
+    static size_t const counts[] = {1, 2, 3, 8, MULTI_LANES};
+    static size_t const sizes[] = {0, 1, 55, 56, 63, 64, 65, 130};
+    NoiseHashState *states[MULTI_LANES];
+    NoiseHashState *single;
+    uint8_t data[MULTI_LANES][256];
+    uint8_t hashes[MULTI_LANES][MAX_HASH_OUTPUT];
+    uint8_t out1[MULTI_LANES][MAX_HASH_OUTPUT];
+    uint8_t out2[MULTI_LANES][MAX_HASH_OUTPUT];
+    uint8_t expected1[MAX_HASH_OUTPUT];
+    uint8_t expected2[MAX_HASH_OUTPUT];
+    const uint8_t *data_ptrs[MULTI_LANES];
+    uint8_t *hash_ptrs[MULTI_LANES];
+    uint8_t *out1_ptrs[MULTI_LANES];
+    uint8_t *out2_ptrs[MULTI_LANES];
+    uint8_t pbkdf2_expected[MAX_HASH_OUTPUT * 10];
+    uint8_t pbkdf2_output[MAX_HASH_OUTPUT * 10];
+    size_t hash_len, pbkdf2_len;
+    size_t count, size, lane, skew;
+
+    compare(noise_hashstate_new_by_id(&single, id), NOISE_ERROR_NONE);
+    hash_len = noise_hashstate_get_hash_length(single);
+    for (lane = 0; lane < MULTI_LANES; ++lane) {
+        compare(noise_hashstate_new_by_id(&(states[lane]), id),
+                NOISE_ERROR_NONE);
+        data_ptrs[lane] = data[lane];
+        hash_ptrs[lane] = hashes[lane];
+        out1_ptrs[lane] = out1[lane];
+        out2_ptrs[lane] = out2[lane];
+    }
+
+    /* Hash equal-length inputs on top of prefixes that are either the
+       same length for every lane or skewed so that the lanes are not in
+       sync with each other */
+    for (skew = 0; skew < 2; ++skew) {
+        for (count = 0; count < sizeof(counts) / sizeof(counts[0]); ++count) {
+            for (size = 0; size < sizeof(sizes) / sizeof(sizes[0]); ++size) {
+                for (lane = 0; lane < counts[count]; ++lane) {
+                    fill_lane_data(data[lane], 256, lane);
+                    compare(noise_hashstate_reset(states[lane]),
+                            NOISE_ERROR_NONE);
+                    compare(noise_hashstate_update
+                                (states[lane], data[lane], 70 + skew * lane),
+                            NOISE_ERROR_NONE);
+                }
+                compare(noise_hashstate_update_multi
+                            (states, data_ptrs, sizes[size], counts[count]),
+                        NOISE_ERROR_NONE);
+                compare(noise_hashstate_update_multi
+                            (states, data_ptrs, sizes[size], counts[count]),
+                        NOISE_ERROR_NONE);
+                compare(noise_hashstate_finalize_multi
+                            (states, hash_ptrs, hash_len, counts[count]),
+                        NOISE_ERROR_NONE);
+                for (lane = 0; lane < counts[count]; ++lane) {
+                    noise_hashstate_reset(single);
+                    noise_hashstate_update
+                        (single, data[lane], 70 + skew * lane);
+                    noise_hashstate_update(single, data[lane], sizes[size]);
+                    noise_hashstate_update(single, data[lane], sizes[size]);
+                    noise_hashstate_finalize(single, expected1, hash_len);
+                    verify(!memcmp(hashes[lane], expected1, hash_len));
+                }
+            }
+        }
+    }
+
+    /* HKDF on all lanes at once */
+    for (lane = 0; lane < MULTI_LANES; ++lane)
+        fill_lane_data(data[lane], 256, lane + 100);
+    compare(noise_hashstate_hkdf_multi
+                (states, data_ptrs, hash_len, data_ptrs, 33,
+                 out1_ptrs, hash_len, out2_ptrs, hash_len / 2, MULTI_LANES),
+            NOISE_ERROR_NONE);
+    for (lane = 0; lane < MULTI_LANES; ++lane) {
+        compare(noise_hashstate_hkdf
+                    (single, data[lane], hash_len, data[lane], 33,
+                     expected1, hash_len, expected2, hash_len / 2),
+                NOISE_ERROR_NONE);
+        verify(!memcmp(out1[lane], expected1, hash_len));
+        verify(!memcmp(out2[lane], expected2, hash_len / 2));
+    }
+
+    /* PBKDF2 with several output blocks, which may be generated in
+       parallel, compared against the reference implementation */
+    pbkdf2_len = hash_len * 9 + 5;
+    compare(noise_hashstate_pbkdf2
+                (states[0], data[0], 20, data[1], 16, 3,
+                 pbkdf2_output, pbkdf2_len),
+            NOISE_ERROR_NONE);
+    compare(noise_backend_select(id, "ref"), NOISE_ERROR_NONE);
+    noise_hashstate_free(single);
+    compare(noise_hashstate_new_by_id(&single, id), NOISE_ERROR_NONE);
+    compare(noise_hashstate_pbkdf2
+                (single, data[0], 20, data[1], 16, 3,
+                 pbkdf2_expected, pbkdf2_len),
+            NOISE_ERROR_NONE);
+    verify(!memcmp(pbkdf2_output, pbkdf2_expected, pbkdf2_len));
+
+    /* Clean up */
+    noise_hashstate_free(single);
+    for (lane = 0; lane < MULTI_LANES; ++lane)
+        noise_hashstate_free(states[lane]);
+}
+
+/* Check the multi-buffer functions for every supported backend */
+static void hashstate_check_multi_algorithm(int id)
+{
+    NoiseHashState *states[2];
+    const uint8_t *data_ptrs[2];
+    uint8_t *hash_ptrs[2];
+    uint8_t data[MAX_HASH_OUTPUT];
+    int index;
+
+    for (index = 0; index < noise_backend_get_count(id); ++index) {
+        if (!noise_backend_is_supported(id, index))
+            continue;
+        compare(noise_backend_select(id, noise_backend_get_name(id, index)),
+                NOISE_ERROR_NONE);
+        check_multi_backend(id);
+    }
+    compare(noise_backend_select(id, NULL), NOISE_ERROR_NONE);
+
+    /* Parameter errors */
+    compare(noise_hashstate_new_by_id(&(states[0]), id), NOISE_ERROR_NONE);
+    compare(noise_hashstate_new_by_id
+                (&(states[1]), id == NOISE_HASH_SHA256 ? NOISE_HASH_SHA512
+                                                       : NOISE_HASH_SHA256),
+            NOISE_ERROR_NONE);
+    data_ptrs[0] = data;
+    data_ptrs[1] = 0;
+    hash_ptrs[0] = data;
+    hash_ptrs[1] = data;
+    compare(noise_hashstate_update_multi(0, data_ptrs, 1, 1),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_hashstate_update_multi(states, 0, 1, 1),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_hashstate_update_multi(states, data_ptrs, 1, 2),
+            NOISE_ERROR_INVALID_PARAM);
+    data_ptrs[1] = data;
+    compare(noise_hashstate_update_multi(states, data_ptrs, 1, 2),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_hashstate_update_multi(states, data_ptrs, 1, 1),
+            NOISE_ERROR_NONE);
+    compare(noise_hashstate_finalize_multi
+                (states, hash_ptrs, noise_hashstate_get_hash_length(states[0]) + 1, 1),
+            NOISE_ERROR_INVALID_LENGTH);
+    compare(noise_hashstate_finalize_multi
+                (states, hash_ptrs, noise_hashstate_get_hash_length(states[0]), 2),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_hashstate_hkdf_multi
+                (states, data_ptrs, 1, data_ptrs, 1, hash_ptrs, 1,
+                 hash_ptrs, 1, 2),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_hashstate_hkdf_multi
+                (states, data_ptrs, 1, data_ptrs, 1, hash_ptrs, 65,
+                 hash_ptrs, 1, 1),
+            NOISE_ERROR_INVALID_LENGTH);
+    noise_hashstate_free(states[0]);
+    noise_hashstate_free(states[1]);
+}
+
+/* Check the behaviour of the multi-buffer hashing functions */
+static void hashstate_check_multi(void)
+{
+    hashstate_check_multi_algorithm(NOISE_HASH_BLAKE2s);
+    hashstate_check_multi_algorithm(NOISE_HASH_BLAKE2b);
+    hashstate_check_multi_algorithm(NOISE_HASH_SHA256);
+    hashstate_check_multi_algorithm(NOISE_HASH_SHA512);
+}
+
 /* Check other error conditions that can be reported by the functions */
 static void hashstate_check_errors(void)
 {
@@ -456,5 +709,6 @@ void test_hashstate(void)
     hashstate_check_test_vectors();
     hashstate_check_hkdf();
     hashstate_check_pbkdf2();
+    hashstate_check_multi();
     hashstate_check_errors();
 }
@@ -0,0 +1,314 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test-helpers.h"
+#include <noise/keys.h>
+
+#define STORE_FILE  "test-keystore.tmp"
+#define NUM_KEYS    1000
+
+/* Generates a deterministic public key for record number "n" */
+static void make_key(uint8_t *key, size_t key_len, uint32_t n)
+{
+    size_t index;
+    for (index = 0; index < key_len; ++index)
+        key[index] = (uint8_t)((n * 131 + index * 17) ^ (n >> (index % 24)));
+    key[0] = (uint8_t)n;
+    key[1] = (uint8_t)(n >> 8);
+    key[2] = (uint8_t)(n >> 16);
+}
+
+/* Builds a key store file with NUM_KEYS records */
+static void build_store(const char *filename)
+{
+    NoiseKeyStoreBuilder *builder = 0;
+    uint8_t key[32];
+    uint8_t psk[32];
+    char meta[32];
+    size_t psk_len, meta_len;
+    uint32_t n;
+    compare(noise_keystore_builder_new(&builder, 32, 32), NOISE_ERROR_NONE);
+    for (n = 0; n < NUM_KEYS; ++n) {
+        make_key(key, sizeof(key), n);
+        memset(psk, (int)(n & 0xFF), sizeof(psk));
+        sprintf(meta, "id-%lu", (unsigned long)n);
+        psk_len = (n % 3) ? sizeof(psk) : 0;
+        meta_len = (n % 5) ? strlen(meta) : 0;
+        compare(noise_keystore_builder_add
+                    (builder, key, sizeof(key), psk_len ? psk : 0, psk_len,
+                     meta, meta_len),
+                NOISE_ERROR_NONE);
+    }
+    compare(noise_keystore_builder_save(builder, filename), NOISE_ERROR_NONE);
+    compare(noise_keystore_builder_free(builder), NOISE_ERROR_NONE);
+}
+
+/* Check building and looking up records in a key store */
+static void keystore_check_lookup(void)
+{
+    NoiseKeyStore *store = 0;
+    NoiseKeyStoreEntry entry;
+    uint8_t key[32];
+    uint8_t psk[32];
+    char meta[32];
+    uint32_t n;
+
+    build_store(STORE_FILE);
+    compare(noise_keystore_open(&store, STORE_FILE), NOISE_ERROR_NONE);
+    verify(store != 0);
+    compare(noise_keystore_get_count(store), NUM_KEYS);
+    compare(noise_keystore_get_key_length(store), 32);
+
+    /* Every key that was added should be found with its details */
+    for (n = 0; n < NUM_KEYS; ++n) {
+        make_key(key, sizeof(key), n);
+        memset(psk, (int)(n & 0xFF), sizeof(psk));
+        sprintf(meta, "id-%lu", (unsigned long)n);
+        compare(noise_keystore_lookup(store, key, sizeof(key), &entry),
+                NOISE_ERROR_NONE);
+        if (n % 3) {
+            compare_blocks(entry.psk, entry.psk_len, psk, sizeof(psk));
+        } else {
+            verify(entry.psk == 0);
+            compare(entry.psk_len, 0);
+        }
+        if (n % 5) {
+            compare_blocks(entry.metadata, entry.metadata_len,
+                           (const uint8_t *)meta, strlen(meta));
+        } else {
+            compare(entry.metadata_len, 0);
+        }
+        compare(noise_keystore_lookup(store, key, sizeof(key), 0),
+                NOISE_ERROR_NONE);
+    }
+
+    /* Keys that were not added, including near-misses, are not found */
+    for (n = NUM_KEYS; n < NUM_KEYS * 2; ++n) {
+        make_key(key, sizeof(key), n);
+        compare(noise_keystore_lookup(store, key, sizeof(key), &entry),
+                NOISE_ERROR_INVALID_PUBLIC_KEY);
+        verify(entry.psk == 0);
+        verify(entry.metadata == 0);
+    }
+    make_key(key, sizeof(key), 7);
+    key[31] ^= 0x01;
+    compare(noise_keystore_lookup(store, key, sizeof(key), &entry),
+            NOISE_ERROR_INVALID_PUBLIC_KEY);
+
+    /* Error cases */
+    compare(noise_keystore_lookup(0, key, sizeof(key), &entry),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_keystore_lookup(store, 0, sizeof(key), &entry),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_keystore_lookup(store, key, 31, &entry),
+            NOISE_ERROR_INVALID_LENGTH);
+
+    compare(noise_keystore_close(store), NOISE_ERROR_NONE);
+    remove(STORE_FILE);
+}
+
+/* Check looking up the public key from a DHState */
+static void keystore_check_dhstate(void)
+{
+    NoiseKeyStoreBuilder *builder = 0;
+    NoiseKeyStore *store = 0;
+    NoiseDHState *dh = 0;
+    NoiseDHState *other = 0;
+    NoiseKeyStoreEntry entry;
+    uint8_t key[32];
+
+    compare(noise_dhstate_new_by_id(&dh, NOISE_DH_CURVE25519),
+            NOISE_ERROR_NONE);
+    compare(noise_dhstate_new_by_id(&other, NOISE_DH_CURVE25519),
+            NOISE_ERROR_NONE);
+    compare(noise_keystore_lookup_dhstate(0, dh, &entry),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_dhstate_generate_keypair(dh), NOISE_ERROR_NONE);
+    compare(noise_dhstate_generate_keypair(other), NOISE_ERROR_NONE);
+    compare(noise_dhstate_get_public_key(dh, key, sizeof(key)),
+            NOISE_ERROR_NONE);
+
+    compare(noise_keystore_builder_new(&builder, 32, 0), NOISE_ERROR_NONE);
+    compare(noise_keystore_builder_add
+                (builder, key, sizeof(key), 0, 0, "alice", 5),
+            NOISE_ERROR_NONE);
+    compare(noise_keystore_builder_save(builder, STORE_FILE),
+            NOISE_ERROR_NONE);
+    compare(noise_keystore_builder_free(builder), NOISE_ERROR_NONE);
+
+    compare(noise_keystore_open(&store, STORE_FILE), NOISE_ERROR_NONE);
+    compare(noise_keystore_lookup_dhstate(store, dh, &entry),
+            NOISE_ERROR_NONE);
+    compare_blocks(entry.metadata, entry.metadata_len,
+                   (const uint8_t *)"alice", 5);
+    verify(entry.psk == 0);
+    compare(noise_keystore_lookup_dhstate(store, other, &entry),
+            NOISE_ERROR_INVALID_PUBLIC_KEY);
+    compare(noise_keystore_lookup_dhstate(store, 0, &entry),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_keystore_close(store), NOISE_ERROR_NONE);
+
+    noise_dhstate_free(dh);
+    noise_dhstate_free(other);
+    remove(STORE_FILE);
+}
+
+/* Check replacing the key store in a slot */
+static void keystore_check_slot(void)
+{
+    NoiseKeyStoreBuilder *builder = 0;
+    NoiseKeyStoreSlot *slot = 0;
+    NoiseKeyStore *store = 0;
+    NoiseKeyStore *old_store = 0;
+    NoiseKeyStoreEntry entry;
+    uint8_t key1[32];
+    uint8_t key2[32];
+
+    make_key(key1, sizeof(key1), 1);
+    make_key(key2, sizeof(key2), 2);
+    compare(noise_keystore_slot_new(&slot), NOISE_ERROR_NONE);
+    verify(noise_keystore_slot_acquire(slot) == 0);
+
+    /* Load the first version of the key store into the slot */
+    compare(noise_keystore_builder_new(&builder, 32, 0), NOISE_ERROR_NONE);
+    compare(noise_keystore_builder_add
+                (builder, key1, sizeof(key1), 0, 0, "v1", 2),
+            NOISE_ERROR_NONE);
+    compare(noise_keystore_builder_save(builder, STORE_FILE),
+            NOISE_ERROR_NONE);
+    compare(noise_keystore_builder_free(builder), NOISE_ERROR_NONE);
+    compare(noise_keystore_open(&store, STORE_FILE), NOISE_ERROR_NONE);
+    compare(noise_keystore_slot_set(slot, store), NOISE_ERROR_NONE);
+    old_store = noise_keystore_slot_acquire(slot);
+    verify(old_store == store);
+
+    /* Replace the file and the slot contents */
+    compare(noise_keystore_builder_new(&builder, 32, 0), NOISE_ERROR_NONE);
+    compare(noise_keystore_builder_add
+                (builder, key2, sizeof(key2), 0, 0, "v2", 2),
+            NOISE_ERROR_NONE);
+    compare(noise_keystore_builder_save(builder, STORE_FILE),
+            NOISE_ERROR_NONE);
+    compare(noise_keystore_builder_free(builder), NOISE_ERROR_NONE);
+    compare(noise_keystore_open(&store, STORE_FILE), NOISE_ERROR_NONE);
+    compare(noise_keystore_slot_set(slot, store), NOISE_ERROR_NONE);
+
+    /* The old reference still sees the old contents */
+    compare(noise_keystore_lookup(old_store, key1, sizeof(key1), &entry),
+            NOISE_ERROR_NONE);
+    compare_blocks(entry.metadata, entry.metadata_len,
+                   (const uint8_t *)"v1", 2);
+    compare(noise_keystore_lookup(old_store, key2, sizeof(key2), &entry),
+            NOISE_ERROR_INVALID_PUBLIC_KEY);
+    compare(noise_keystore_close(old_store), NOISE_ERROR_NONE);
+
+    /* New acquisitions see the new contents */
+    store = noise_keystore_slot_acquire(slot);
+    verify(store != 0);
+    compare(noise_keystore_lookup(store, key2, sizeof(key2), &entry),
+            NOISE_ERROR_NONE);
+    compare_blocks(entry.metadata, entry.metadata_len,
+                   (const uint8_t *)"v2", 2);
+    compare(noise_keystore_lookup(store, key1, sizeof(key1), &entry),
+            NOISE_ERROR_INVALID_PUBLIC_KEY);
+    compare(noise_keystore_close(store), NOISE_ERROR_NONE);
+
+    compare(noise_keystore_slot_set(slot, 0), NOISE_ERROR_NONE);
+    verify(noise_keystore_slot_acquire(slot) == 0);
+    compare(noise_keystore_slot_free(slot), NOISE_ERROR_NONE);
+    remove(STORE_FILE);
+}
+
+/* Check error handling in the builder and when opening files */
+static void keystore_check_errors(void)
+{
+    NoiseKeyStoreBuilder *builder = 0;
+    NoiseKeyStore *store = 0;
+    uint8_t key[32];
+    uint8_t psk[32];
+    FILE *file;
+
+    make_key(key, sizeof(key), 42);
+    memset(psk, 0xAA, sizeof(psk));
+
+    /* Builder parameter errors */
+    compare(noise_keystore_builder_new(0, 32, 0), NOISE_ERROR_INVALID_PARAM);
+    compare(noise_keystore_builder_new(&builder, 0, 0),
+            NOISE_ERROR_INVALID_LENGTH);
+    verify(builder == 0);
+    compare(noise_keystore_builder_new(&builder, 32, 0), NOISE_ERROR_NONE);
+    compare(noise_keystore_builder_add(builder, key, 31, 0, 0, 0, 0),
+            NOISE_ERROR_INVALID_LENGTH);
+    compare(noise_keystore_builder_add
+                (builder, key, sizeof(key), psk, sizeof(psk), 0, 0),
+            NOISE_ERROR_INVALID_LENGTH);
+    compare(noise_keystore_builder_add(builder, 0, sizeof(key), 0, 0, 0, 0),
+            NOISE_ERROR_INVALID_PARAM);
+
+    /* Duplicate keys are rejected when saving */
+    compare(noise_keystore_builder_add(builder, key, sizeof(key), 0, 0, 0, 0),
+            NOISE_ERROR_NONE);
+    compare(noise_keystore_builder_add(builder, key, sizeof(key), 0, 0, 0, 0),
+            NOISE_ERROR_NONE);
+    compare(noise_keystore_builder_save(builder, STORE_FILE),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_keystore_builder_free(builder), NOISE_ERROR_NONE);
+
+    /* An empty key store can be saved and opened */
+    compare(noise_keystore_builder_new(&builder, 32, 0), NOISE_ERROR_NONE);
+    compare(noise_keystore_builder_save(builder, STORE_FILE),
+            NOISE_ERROR_NONE);
+    compare(noise_keystore_builder_free(builder), NOISE_ERROR_NONE);
+    compare(noise_keystore_open(&store, STORE_FILE), NOISE_ERROR_NONE);
+    compare(noise_keystore_get_count(store), 0);
+    compare(noise_keystore_lookup(store, key, sizeof(key), 0),
+            NOISE_ERROR_INVALID_PUBLIC_KEY);
+    compare(noise_keystore_close(store), NOISE_ERROR_NONE);
+
+    /* Truncated and corrupt files are rejected */
+    file = fopen(STORE_FILE, "r+b");
+    verify(file != 0);
+    fseek(file, 0L, SEEK_SET);
+    fputc('X', file);
+    fclose(file);
+    compare(noise_keystore_open(&store, STORE_FILE),
+            NOISE_ERROR_INVALID_FORMAT);
+    verify(store == 0);
+    file = fopen(STORE_FILE, "wb");
+    verify(file != 0);
+    fputs("NoiseKS1", file);
+    fclose(file);
+    compare(noise_keystore_open(&store, STORE_FILE),
+            NOISE_ERROR_INVALID_FORMAT);
+    remove(STORE_FILE);
+    compare(noise_keystore_open(&store, STORE_FILE), NOISE_ERROR_SYSTEM);
+    compare(noise_keystore_open(0, STORE_FILE), NOISE_ERROR_INVALID_PARAM);
+    compare(noise_keystore_open(&store, 0), NOISE_ERROR_INVALID_PARAM);
+}
+
+void test_keystore(void)
+{
+    keystore_check_lookup();
+    keystore_check_dhstate();
+    keystore_check_slot();
+    keystore_check_errors();
+}
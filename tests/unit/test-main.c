@@ -34,18 +34,32 @@ int main(int argc, char *argv[])
     if (argc > 1 && !strcmp(argv[1], "--verbose"))
         verbose = 1;
 
+#if defined(TEST_TABLES)
+    /* Only the protobuf tests are linked against the certificate code
+       that was generated in table mode */
+    test(protobufs);
+#else
     /* Run all tests */
+    test(backend);
     test(cipherstate);
+    test(compactsession);
+    test(cookie);
     test(dhstate);
     test(errors);
     test(handshakestate);
     test(hashstate);
+    test(keystore);
     test(names);
     test(patterns);
     test(protobufs);
     test(randstate);
+    test(revocation);
+    test(secmem);
     test(signstate);
     test(symmetricstate);
+    test(ticket);
+    test(verifier);
+#endif
 
     /* Report the results */
     if (!test_failures) {
@@ -65,6 +65,7 @@ static void test_id_mappings(void)
     check_id("25519", NOISE_DH_CURVE25519);
     check_id("448", NOISE_DH_CURVE448);
     check_id("NewHope", NOISE_DH_NEWHOPE);
+    check_id("MLKEM768", NOISE_DH_MLKEM768);
 
     check_id("N", NOISE_PATTERN_N);
     check_id("X", NOISE_PATTERN_X);
@@ -127,7 +128,7 @@ static void check_protocol_name
     compare(actual_id.dh_id, expected_id.dh_id);
     compare(actual_id.cipher_id, expected_id.cipher_id);
     compare(actual_id.hash_id, expected_id.hash_id);
-    compare(actual_id.reserved_id, 0);
+    compare(actual_id.hybrid_id, 0);
     verify(!memcmp(&actual_id, &expected_id, sizeof(actual_id)));
 
     /* Format the name from the identifiers */
@@ -150,7 +151,7 @@ static void check_protocol_name
     compare(actual_id.dh_id, 0);
     compare(actual_id.cipher_id, 0);
     compare(actual_id.hash_id, 0);
-    compare(actual_id.reserved_id, 0);
+    compare(actual_id.hybrid_id, 0);
     memset(buffer, 0xAA, sizeof(buffer));
     compare(noise_protocol_id_to_name(buffer, sizeof(buffer), 0),
             NOISE_ERROR_INVALID_PARAM);
@@ -170,8 +171,8 @@ static void check_protocol_name
             NOISE_ERROR_INVALID_LENGTH);
     compare(buffer[0], '\0');
 
-    /* Reserved identifiers cannot be formatted */
-    expected_id.reserved_id = NOISE_PREFIX_PSK;
+    /* Hybrid identifiers must be DH algorithms */
+    expected_id.hybrid_id = NOISE_PREFIX_PSK;
     memset(buffer, 0x66, sizeof(buffer));
     compare(noise_protocol_id_to_name(buffer, sizeof(buffer), &expected_id),
             NOISE_ERROR_UNKNOWN_ID);
@@ -179,7 +180,7 @@ static void check_protocol_name
 
     /* Identifiers in the wrong fields */
     expected_id.cipher_id = hash_id;
-    expected_id.reserved_id = 0;
+    expected_id.hybrid_id = 0;
     memset(buffer, 0x66, sizeof(buffer));
     compare(noise_protocol_id_to_name(buffer, sizeof(buffer), &expected_id),
             NOISE_ERROR_UNKNOWN_ID);
@@ -233,10 +234,61 @@ static void test_protocol_names(void)
          NOISE_PREFIX_STANDARD, NOISE_PATTERN_NN,
          NOISE_DH_NEWHOPE, NOISE_CIPHER_AESGCM,
          NOISE_HASH_SHA256);
+    check_protocol_name
+        ("Noise_NN_MLKEM768_ChaChaPoly_SHA256",
+         NOISE_PREFIX_STANDARD, NOISE_PATTERN_NN,
+         NOISE_DH_MLKEM768, NOISE_CIPHER_CHACHAPOLY,
+         NOISE_HASH_SHA256);
+}
+
+/* Check that a name with a hybrid DH field is rejected */
+static void check_bad_hybrid_name(const char *name)
+{
+    NoiseProtocolId id;
+    memset(&id, 0x66, sizeof(id));
+    compare(noise_protocol_name_to_id(&id, name, strlen(name)),
+            NOISE_ERROR_UNKNOWN_NAME);
+    compare(id.dh_id, 0);
+    compare(id.hybrid_id, 0);
+}
+
+static void test_hybrid_protocol_names(void)
+{
+    static char const name[] = "Noise_XX_25519+NewHope_ChaChaPoly_BLAKE2s";
+    NoiseProtocolId id;
+    char buffer[NOISE_MAX_PROTOCOL_NAME];
+
+    /* Parse a hybrid name and format it again */
+    memset(&id, 0x66, sizeof(id));
+    compare(noise_protocol_name_to_id(&id, name, strlen(name)),
+            NOISE_ERROR_NONE);
+    compare(id.prefix_id, NOISE_PREFIX_STANDARD);
+    compare(id.pattern_id, NOISE_PATTERN_XX);
+    compare(id.dh_id, NOISE_DH_CURVE25519);
+    compare(id.hybrid_id, NOISE_DH_NEWHOPE);
+    compare(id.cipher_id, NOISE_CIPHER_CHACHAPOLY);
+    compare(id.hash_id, NOISE_HASH_BLAKE2s);
+    memset(buffer, 0xAA, sizeof(buffer));
+    compare(noise_protocol_id_to_name(buffer, sizeof(buffer), &id),
+            NOISE_ERROR_NONE);
+    verify(!strcmp(buffer, name));
+
+    /* The buffer must have room for both halves of the DH field */
+    compare(noise_protocol_id_to_name(buffer, 18, &id),
+            NOISE_ERROR_INVALID_LENGTH);
+    compare(buffer[0], '\0');
+
+    /* Malformed hybrid fields */
+    check_bad_hybrid_name("Noise_XX_25519+_ChaChaPoly_BLAKE2s");
+    check_bad_hybrid_name("Noise_XX_+NewHope_ChaChaPoly_BLAKE2s");
+    check_bad_hybrid_name("Noise_XX_25519+AESGCM_ChaChaPoly_BLAKE2s");
+    check_bad_hybrid_name("Noise_XX_25519+NewHope+448_ChaChaPoly_BLAKE2s");
+    check_bad_hybrid_name("Noise_XX_25519+NewHope");
 }
 
 void test_names(void)
 {
     test_id_mappings();
     test_protocol_names();
+    test_hybrid_protocol_names();
 }
@@ -22,6 +22,7 @@
 
 #include "test-helpers.h"
 #include <noise/protobufs.h>
+#include <noise/keys.h>
 
 /* Tests for the "prepare" functions */
 static void test_protobufs_prepare(void)
@@ -1031,7 +1032,7 @@ static void check_tagged_string(const char *str, int is_valid_utf8, int tag)
             NOISE_ERROR_NONE);
     compare(olen, len);
     verify(!memcmp(bvalue, input, len));
-    free(value);
+    free(bvalue);
 
     /* Truncated input data, shorter than the encoded byte array length */
     if (len > 0) {
@@ -1201,6 +1202,809 @@ static void test_protobufs_element(void)
     check_tagged_element(15);
 }
 
+/* Test allocating memory from an arena */
+static void test_protobufs_arena_alloc(void)
+{
+    uint64_t memory[16];
+    NoiseProtobufArena arena;
+    uint8_t *ptr1;
+    uint8_t *ptr2;
+
+    data_name = 0;
+
+    memset(memory, 0xAA, sizeof(memory));
+    compare(noise_protobuf_arena_init(&arena, memory, sizeof(memory)),
+            NOISE_ERROR_NONE);
+    compare(arena.posn, 0);
+    compare(noise_protobuf_arena_init(0, memory, sizeof(memory)),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_protobuf_arena_init(&arena, 0, sizeof(memory)),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_protobuf_arena_init(&arena, memory, sizeof(memory)),
+            NOISE_ERROR_NONE);
+
+    /* Blocks are zeroed and aligned */
+    ptr1 = (uint8_t *)noise_protobuf_arena_alloc(&arena, 3);
+    verify(ptr1 == (uint8_t *)memory);
+    verify(ptr1[0] == 0 && ptr1[1] == 0 && ptr1[2] == 0);
+    compare(ptr1[3], 0xAA);
+    ptr2 = (uint8_t *)noise_protobuf_arena_alloc(&arena, 5);
+    verify(ptr2 != 0);
+    verify((((uintptr_t)ptr2) & (sizeof(void *) - 1)) == 0);
+    verify(ptr2 >= (ptr1 + 3));
+
+    /* Exhausting the arena */
+    verify(noise_protobuf_arena_alloc(&arena, sizeof(memory)) == 0);
+    verify(noise_protobuf_arena_alloc(&arena, 8) != 0);
+
+    /* Reset and allocate the whole arena */
+    noise_protobuf_arena_reset(&arena);
+    compare(arena.posn, 0);
+    verify(noise_protobuf_arena_alloc(&arena, sizeof(memory)) ==
+                (void *)memory);
+    compare(arena.posn, sizeof(memory));
+    verify(noise_protobuf_arena_alloc(&arena, 1) == 0);
+    verify(noise_protobuf_arena_alloc(0, 1) == 0);
+}
+
+/* Test reading string and byte fields into an arena */
+static void test_protobufs_arena_fields(void)
+{
+    uint64_t memory[8];
+    uint8_t output[64];
+    NoiseProtobufArena arena;
+    NoiseProtobuf pbuf;
+    NoiseProtobuf pbuf2;
+    uint8_t *out;
+    size_t out_len;
+    size_t olen;
+    char *str;
+    void *bytes;
+
+    data_name = 0;
+
+    compare(noise_protobuf_prepare_output(&pbuf, output, sizeof(output)),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_write_bytes(&pbuf, 2, "\x01\x02\x03", 3),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_write_string(&pbuf, 1, "Hello", 5),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_finish_output(&pbuf, &out, &out_len),
+            NOISE_ERROR_NONE);
+    verify(pbuf.arena == 0);
+
+    /* Strings are copied into the arena, bytes refer to the input */
+    compare(noise_protobuf_arena_init(&arena, memory, sizeof(memory)),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_prepare_input_arena(&pbuf2, out, out_len, &arena),
+            NOISE_ERROR_NONE);
+    verify(pbuf2.arena == &arena);
+    compare(noise_protobuf_read_alloc_string(&pbuf2, 1, &str, 0, &olen),
+            NOISE_ERROR_NONE);
+    compare(olen, 5);
+    verify(!strcmp(str, "Hello"));
+    verify(str == (char *)memory);
+    compare(noise_protobuf_read_alloc_bytes(&pbuf2, 2, &bytes, 0, &olen),
+            NOISE_ERROR_NONE);
+    compare(olen, 3);
+    verify(bytes == (void *)(out + 9));
+    compare(arena.posn, 6);
+    compare(noise_protobuf_finish_input(&pbuf2), NOISE_ERROR_NONE);
+
+    /* Strings that do not fit in the arena */
+    compare(noise_protobuf_arena_init(&arena, memory, 5),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_prepare_input_arena(&pbuf2, out, out_len, &arena),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_read_alloc_string(&pbuf2, 1, &str, 0, &olen),
+            NOISE_ERROR_NO_MEMORY);
+    verify(str == 0);
+}
+
+/* Creates a certificate with a subject, key, and signature for testing */
+static Noise_Certificate *create_certificate(const char *id, int num_meta)
+{
+    static uint8_t const key_data[32] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+    static uint8_t const sig_data[64] = {9, 8, 7, 6, 5, 4, 3, 2, 1};
+    Noise_Certificate *cert = 0;
+    Noise_SubjectInfo *subject = 0;
+    Noise_PublicKeyInfo *key = 0;
+    Noise_MetaInfo *meta = 0;
+    Noise_Signature *sig = 0;
+    int index;
+    compare(Noise_Certificate_new(&cert), NOISE_ERROR_NONE);
+    compare(Noise_Certificate_set_version(cert, 1), NOISE_ERROR_NONE);
+    compare(Noise_Certificate_get_new_subject(cert, &subject),
+            NOISE_ERROR_NONE);
+    compare(Noise_SubjectInfo_set_id(subject, id, strlen(id)),
+            NOISE_ERROR_NONE);
+    compare(Noise_SubjectInfo_set_name(subject, "Jane Smith", 10),
+            NOISE_ERROR_NONE);
+    compare(Noise_SubjectInfo_add_keys(subject, &key), NOISE_ERROR_NONE);
+    compare(Noise_PublicKeyInfo_set_algorithm(key, "25519", 5),
+            NOISE_ERROR_NONE);
+    compare(Noise_PublicKeyInfo_set_key(key, key_data, sizeof(key_data)),
+            NOISE_ERROR_NONE);
+    for (index = 0; index < num_meta; ++index) {
+        compare(Noise_SubjectInfo_add_meta(subject, &meta), NOISE_ERROR_NONE);
+        compare(Noise_MetaInfo_set_name(meta, "Meta", 4), NOISE_ERROR_NONE);
+        compare(Noise_MetaInfo_set_value(meta, "Value", 5), NOISE_ERROR_NONE);
+    }
+    compare(Noise_Certificate_add_signatures(cert, &sig), NOISE_ERROR_NONE);
+    compare(Noise_Signature_set_id(sig, "ca@example.com", 14),
+            NOISE_ERROR_NONE);
+    compare(Noise_Signature_get_new_signing_key(sig, &key), NOISE_ERROR_NONE);
+    compare(Noise_PublicKeyInfo_set_algorithm(key, "Ed25519", 7),
+            NOISE_ERROR_NONE);
+    compare(Noise_PublicKeyInfo_set_key(key, key_data, sizeof(key_data)),
+            NOISE_ERROR_NONE);
+    compare(Noise_Signature_set_hash_algorithm(sig, "BLAKE2b", 7),
+            NOISE_ERROR_NONE);
+    compare(Noise_Signature_set_signature(sig, sig_data, sizeof(sig_data)),
+            NOISE_ERROR_NONE);
+    return cert;
+}
+
+/* Compares two certificates for equality */
+static void compare_certificates
+    (const Noise_Certificate *cert1, const Noise_Certificate *cert2)
+{
+    const Noise_SubjectInfo *subject1 = Noise_Certificate_get_subject(cert1);
+    const Noise_SubjectInfo *subject2 = Noise_Certificate_get_subject(cert2);
+    const Noise_PublicKeyInfo *key1;
+    const Noise_PublicKeyInfo *key2;
+    const Noise_Signature *sig1;
+    const Noise_Signature *sig2;
+    size_t index;
+    compare(Noise_Certificate_get_version(cert1),
+            Noise_Certificate_get_version(cert2));
+    verify(subject1 != 0 && subject2 != 0);
+    verify(!strcmp(Noise_SubjectInfo_get_id(subject1),
+                   Noise_SubjectInfo_get_id(subject2)));
+    verify(!strcmp(Noise_SubjectInfo_get_name(subject1),
+                   Noise_SubjectInfo_get_name(subject2)));
+    verify(!Noise_SubjectInfo_has_role(subject2));
+    compare(Noise_SubjectInfo_count_keys(subject1),
+            Noise_SubjectInfo_count_keys(subject2));
+    key1 = Noise_SubjectInfo_get_at_keys(subject1, 0);
+    key2 = Noise_SubjectInfo_get_at_keys(subject2, 0);
+    verify(!strcmp(Noise_PublicKeyInfo_get_algorithm(key1),
+                   Noise_PublicKeyInfo_get_algorithm(key2)));
+    compare(Noise_PublicKeyInfo_get_size_key(key1),
+            Noise_PublicKeyInfo_get_size_key(key2));
+    verify(!memcmp(Noise_PublicKeyInfo_get_key(key1),
+                   Noise_PublicKeyInfo_get_key(key2),
+                   Noise_PublicKeyInfo_get_size_key(key1)));
+    compare(Noise_SubjectInfo_count_meta(subject1),
+            Noise_SubjectInfo_count_meta(subject2));
+    for (index = 0; index < Noise_SubjectInfo_count_meta(subject1); ++index) {
+        verify(!strcmp(Noise_MetaInfo_get_value
+                            (Noise_SubjectInfo_get_at_meta(subject1, index)),
+                       Noise_MetaInfo_get_value
+                            (Noise_SubjectInfo_get_at_meta(subject2, index))));
+    }
+    compare(Noise_Certificate_count_signatures(cert2), 1);
+    sig1 = Noise_Certificate_get_at_signatures(cert1, 0);
+    sig2 = Noise_Certificate_get_at_signatures(cert2, 0);
+    verify(!strcmp(Noise_Signature_get_id(sig1), Noise_Signature_get_id(sig2)));
+    key2 = Noise_Signature_get_signing_key(sig2);
+    verify(key2 != 0);
+    verify(!strcmp(Noise_PublicKeyInfo_get_algorithm(key2), "Ed25519"));
+    compare(Noise_Signature_get_size_signature(sig1),
+            Noise_Signature_get_size_signature(sig2));
+    verify(!memcmp(Noise_Signature_get_signature(sig1),
+                   Noise_Signature_get_signature(sig2),
+                   Noise_Signature_get_size_signature(sig1)));
+}
+
+/* Test decoding certificates and certificate chains into an arena */
+static void test_protobufs_arena_certificates(void)
+{
+    static uint64_t memory[512];
+    uint8_t buffer[2048];
+    Noise_CertificateChain *chain;
+    Noise_CertificateChain *chain2;
+    Noise_Certificate *cert;
+    Noise_Certificate *cert2;
+    NoiseProtobufArena arena;
+    NoiseProtobuf pbuf;
+    uint8_t *data;
+    size_t size, index, used;
+
+    data_name = 0;
+
+    /* Build a chain with enough metadata to grow the arrays */
+    compare(Noise_CertificateChain_new(&chain), NOISE_ERROR_NONE);
+    for (index = 0; index < 3; ++index) {
+        cert = create_certificate(index ? "ca@example.com" : "jane@example.com",
+                                  (int)(index * 5));
+        compare(Noise_CertificateChain_insert_certs(chain, index, cert),
+                NOISE_ERROR_NONE);
+    }
+    compare(noise_protobuf_prepare_output(&pbuf, buffer, sizeof(buffer)),
+            NOISE_ERROR_NONE);
+    compare(Noise_CertificateChain_write(&pbuf, 0, chain), NOISE_ERROR_NONE);
+    compare(noise_protobuf_finish_output(&pbuf, &data, &size),
+            NOISE_ERROR_NONE);
+
+    /* Decode the chain into the arena and compare */
+    compare(noise_protobuf_arena_init(&arena, memory, sizeof(memory)),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_prepare_input_arena(&pbuf, data, size, &arena),
+            NOISE_ERROR_NONE);
+    compare(noise_load_certificate_chain_from_buffer(&chain2, &pbuf),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_finish_input(&pbuf), NOISE_ERROR_NONE);
+    verify((uint8_t *)chain2 >= (uint8_t *)memory &&
+           (uint8_t *)chain2 < ((uint8_t *)memory) + sizeof(memory));
+    compare(Noise_CertificateChain_count_certs(chain2), 3);
+    for (index = 0; index < 3; ++index) {
+        compare_certificates(Noise_CertificateChain_get_at_certs(chain, index),
+                             Noise_CertificateChain_get_at_certs(chain2, index));
+    }
+    used = arena.posn;
+    verify(used > 0);
+
+    /* Byte fields refer directly to the input buffer */
+    cert2 = Noise_CertificateChain_get_at_certs(chain2, 0);
+    verify((const uint8_t *)Noise_Signature_get_signature
+                (Noise_Certificate_get_at_signatures(cert2, 0)) > data &&
+           (const uint8_t *)Noise_Signature_get_signature
+                (Noise_Certificate_get_at_signatures(cert2, 0)) < data + size);
+
+    /* Loading the first certificate only */
+    noise_protobuf_arena_reset(&arena);
+    compare(noise_protobuf_prepare_input_arena(&pbuf, data, size, &arena),
+            NOISE_ERROR_NONE);
+    compare(noise_load_certificate_from_buffer(&cert2, &pbuf),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_finish_input(&pbuf), NOISE_ERROR_NONE);
+    compare_certificates(Noise_CertificateChain_get_at_certs(chain, 0), cert2);
+
+    /* Every arena size that is too small fails cleanly */
+    for (index = 0; index < used; index += 8) {
+        compare(noise_protobuf_arena_init(&arena, memory, index),
+                NOISE_ERROR_NONE);
+        compare(noise_protobuf_prepare_input_arena(&pbuf, data, size, &arena),
+                NOISE_ERROR_NONE);
+        compare(noise_load_certificate_chain_from_buffer(&chain2, &pbuf),
+                NOISE_ERROR_NO_MEMORY);
+        verify(chain2 == 0);
+    }
+
+    /* Load a singleton certificate as a chain */
+    cert = Noise_CertificateChain_get_at_certs(chain, 1);
+    compare(noise_protobuf_prepare_output(&pbuf, buffer, sizeof(buffer)),
+            NOISE_ERROR_NONE);
+    compare(Noise_Certificate_write(&pbuf, 0, cert), NOISE_ERROR_NONE);
+    compare(noise_protobuf_finish_output(&pbuf, &data, &size),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_arena_init(&arena, memory, sizeof(memory)),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_prepare_input_arena(&pbuf, data, size, &arena),
+            NOISE_ERROR_NONE);
+    compare(noise_load_certificate_chain_from_buffer(&chain2, &pbuf),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_finish_input(&pbuf), NOISE_ERROR_NONE);
+    compare(Noise_CertificateChain_count_certs(chain2), 1);
+    compare_certificates(cert, Noise_CertificateChain_get_at_certs(chain2, 0));
+
+    /* The heap version still works and produces the same result */
+    compare(noise_protobuf_prepare_input(&pbuf, data, size), NOISE_ERROR_NONE);
+    compare(noise_load_certificate_chain_from_buffer(&chain2, &pbuf),
+            NOISE_ERROR_NONE);
+    compare(Noise_CertificateChain_count_certs(chain2), 1);
+    compare_certificates(cert, Noise_CertificateChain_get_at_certs(chain2, 0));
+    Noise_CertificateChain_free(chain2);
+
+    Noise_CertificateChain_free(chain);
+}
+
+/* Check that a value is encoded identically by the reverse writer and the
+   forward encoder, and that it decodes at the end of a buffer and with
+   trailing data after it */
+static void check_encode_uint64(int tag, uint64_t value)
+{
+    uint8_t output[64];
+    uint8_t encoded[64];
+    NoiseProtobuf pbuf;
+    uint8_t *out;
+    size_t olen, elen, size;
+    uint64_t val64;
+
+    size = noise_protobuf_size_uint64(tag, value);
+    compare(noise_protobuf_prepare_output(&pbuf, output, sizeof(output)),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_write_uint64(&pbuf, tag, value), NOISE_ERROR_NONE);
+    compare(noise_protobuf_finish_output(&pbuf, &out, &olen),
+            NOISE_ERROR_NONE);
+    compare(olen, size);
+
+    memset(encoded, 0xAA, sizeof(encoded));
+    compare(noise_protobuf_prepare_encode(&pbuf, encoded, sizeof(encoded)),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_encode_uint64(&pbuf, tag, value), NOISE_ERROR_NONE);
+    compare(noise_protobuf_finish_encode(&pbuf, &elen), NOISE_ERROR_NONE);
+    compare_blocks(encoded, elen, out, olen);
+
+    /* Encoding into a buffer that is one byte short fails */
+    compare(noise_protobuf_prepare_encode(&pbuf, encoded, size - 1),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_encode_uint64(&pbuf, tag, value),
+            NOISE_ERROR_INVALID_LENGTH);
+    compare(noise_protobuf_finish_encode(&pbuf, &elen),
+            NOISE_ERROR_INVALID_LENGTH);
+    compare(elen, 0);
+
+    /* Decode with nothing after the value */
+    compare(noise_protobuf_prepare_input(&pbuf, out, olen), NOISE_ERROR_NONE);
+    if (tag)
+        compare(noise_protobuf_peek_tag(&pbuf), tag);
+    compare(noise_protobuf_read_uint64(&pbuf, tag, &val64), NOISE_ERROR_NONE);
+    verify(val64 == value);
+    compare(noise_protobuf_finish_input(&pbuf), NOISE_ERROR_NONE);
+
+    /* Decode with continuation bytes after the value */
+    memcpy(encoded, out, olen);
+    memset(encoded + olen, 0xFF, 16);
+    compare(noise_protobuf_prepare_input(&pbuf, encoded, olen + 16),
+            NOISE_ERROR_NONE);
+    if (tag)
+        compare(noise_protobuf_peek_tag(&pbuf), tag);
+    compare(noise_protobuf_read_uint64(&pbuf, tag, &val64), NOISE_ERROR_NONE);
+    verify(val64 == value);
+    compare(pbuf.posn, olen);
+}
+
+/* Tests for the single-pass encoder and the varint codec */
+static void test_protobufs_encode(void)
+{
+    static int const tags[] = {0, 1, 15, 16, 2047, 2048, 536870911};
+    uint8_t payload[200];
+    uint8_t buffer[300];
+    uint8_t encoded[300];
+    NoiseProtobuf pbuf;
+    uint8_t *out;
+    size_t olen, elen, end;
+    uint64_t value;
+    unsigned bit;
+    size_t index;
+
+    data_name = 0;
+
+    /* Every bit length, plus the values on either side of it */
+    for (index = 0; index < (sizeof(tags) / sizeof(tags[0])); ++index) {
+        check_encode_uint64(tags[index], 0);
+        for (bit = 0; bit < 64; ++bit) {
+            value = ((uint64_t)1) << bit;
+            check_encode_uint64(tags[index], value - 1);
+            check_encode_uint64(tags[index], value);
+            check_encode_uint64(tags[index], value + 1);
+            check_encode_uint64(tags[index], value | (value - 1));
+        }
+        check_encode_uint64(tags[index], ~((uint64_t)0));
+    }
+
+    /* Sizes of the other types must agree with the writers */
+    compare(noise_protobuf_size_int32(1, -1), 11);
+    compare(noise_protobuf_size_sint32(1, -1), 2);
+    compare(noise_protobuf_size_sint64(0, -64), 1);
+    compare(noise_protobuf_size_sint64(0, -65), 2);
+    compare(noise_protobuf_size_fixed32(16, 0), 6);
+    compare(noise_protobuf_size_sfixed64(1, 0), 9);
+    compare(noise_protobuf_size_double(1, 0), 9);
+    compare(noise_protobuf_size_bool(1, 1), 2);
+    compare(noise_protobuf_size_string(1, 200), 203);
+    compare(noise_protobuf_size_bytes(0, 200), 202);
+    compare(noise_protobuf_size_element(0, 200), 200);
+    compare(noise_protobuf_size_element(3, 200), 203);
+
+    /* Mixed fields, with a nested element whose size is known up-front */
+    memset(payload, 0x5A, sizeof(payload));
+    memset(encoded, 0, sizeof(encoded));
+    compare(noise_protobuf_prepare_encode(&pbuf, encoded, sizeof(encoded)),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_encode_int32(&pbuf, 1, -5), NOISE_ERROR_NONE);
+    compare(noise_protobuf_encode_sint64(&pbuf, 2, -5), NOISE_ERROR_NONE);
+    compare(noise_protobuf_encode_start_element(&pbuf, 3, 203),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_encode_bytes(&pbuf, 4, payload, 200),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_encode_fixed32(&pbuf, 5, 0x12345678),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_encode_float(&pbuf, 6, 1.5f), NOISE_ERROR_NONE);
+    compare(noise_protobuf_encode_double(&pbuf, 7, -2.25), NOISE_ERROR_NONE);
+    compare(noise_protobuf_encode_string(&pbuf, 8, "hello", 5),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_encode_bool(&pbuf, 9, 42), NOISE_ERROR_NONE);
+    compare(noise_protobuf_finish_encode(&pbuf, &elen), NOISE_ERROR_NONE);
+
+    memset(buffer, 0, sizeof(buffer));
+    compare(noise_protobuf_prepare_output(&pbuf, buffer, sizeof(buffer)),
+            NOISE_ERROR_NONE);
+    noise_protobuf_write_bool(&pbuf, 9, 42);
+    noise_protobuf_write_string(&pbuf, 8, "hello", 5);
+    noise_protobuf_write_double(&pbuf, 7, -2.25);
+    noise_protobuf_write_float(&pbuf, 6, 1.5f);
+    noise_protobuf_write_fixed32(&pbuf, 5, 0x12345678);
+    noise_protobuf_write_end_element(&pbuf, &end);
+    noise_protobuf_write_bytes(&pbuf, 4, payload, 200);
+    noise_protobuf_write_start_element(&pbuf, 3, end);
+    noise_protobuf_write_sint64(&pbuf, 2, -5);
+    noise_protobuf_write_int32(&pbuf, 1, -5);
+    compare(noise_protobuf_finish_output(&pbuf, &out, &olen),
+            NOISE_ERROR_NONE);
+    compare_blocks(encoded, elen, out, olen);
+
+    /* Peeking at the size of a long field */
+    compare(noise_protobuf_prepare_input(&pbuf, encoded, elen),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_read_skip(&pbuf), NOISE_ERROR_NONE);
+    compare(noise_protobuf_read_skip(&pbuf), NOISE_ERROR_NONE);
+    compare(noise_protobuf_peek_tag(&pbuf), 3);
+    compare(noise_protobuf_peek_size(&pbuf), 203);
+
+    /* Nested elements must fit in the buffer, and strings must be UTF-8 */
+    compare(noise_protobuf_prepare_encode(&pbuf, encoded, 100),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_encode_start_element(&pbuf, 0, 101),
+            NOISE_ERROR_INVALID_LENGTH);
+    compare(noise_protobuf_prepare_encode(&pbuf, encoded, 100),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_encode_string(&pbuf, 1, "\xC0\x80", 2),
+            NOISE_ERROR_INVALID_FORMAT);
+    compare(noise_protobuf_finish_encode(&pbuf, &elen),
+            NOISE_ERROR_INVALID_FORMAT);
+    compare(noise_protobuf_prepare_encode(0, encoded, 100),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_protobuf_prepare_encode(&pbuf, 0, 100),
+            NOISE_ERROR_INVALID_PARAM);
+}
+
+/* Test the generated measure and encode functions against "write" */
+static void test_protobufs_encode_certificates(void)
+{
+    uint8_t buffer[2048];
+    uint8_t encoded[2048];
+    Noise_CertificateChain *chain;
+    Noise_CertificateChain *chain2;
+    Noise_Certificate *cert;
+    Noise_EncryptedPrivateKey *key;
+    Noise_EncryptedPrivateKey *key2;
+    NoiseProtobuf pbuf;
+    uint8_t *data;
+    size_t size, esize, index;
+
+    data_name = 0;
+
+    /* Certificate chain, including a required object that is missing */
+    compare(Noise_CertificateChain_new(&chain), NOISE_ERROR_NONE);
+    for (index = 0; index < 3; ++index) {
+        cert = create_certificate(index ? "ca@example.com" : "jane@example.com",
+                                  (int)(index * 10));
+        compare(Noise_CertificateChain_insert_certs(chain, index, cert),
+                NOISE_ERROR_NONE);
+    }
+    compare(Noise_Signature_clear_signing_key
+                (Noise_Certificate_get_at_signatures(cert, 0)),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_prepare_output(&pbuf, buffer, sizeof(buffer)),
+            NOISE_ERROR_NONE);
+    compare(Noise_CertificateChain_write(&pbuf, 0, chain), NOISE_ERROR_NONE);
+    compare(noise_protobuf_finish_output(&pbuf, &data, &size),
+            NOISE_ERROR_NONE);
+    verify(size > 512);
+    compare(Noise_CertificateChain_measure(0, chain), size);
+    compare(Noise_CertificateChain_measure(8, chain), size + 3);
+    compare(noise_protobuf_prepare_encode(&pbuf, encoded, sizeof(encoded)),
+            NOISE_ERROR_NONE);
+    compare(Noise_CertificateChain_encode(&pbuf, 0, chain), NOISE_ERROR_NONE);
+    compare(noise_protobuf_finish_encode(&pbuf, &esize), NOISE_ERROR_NONE);
+    compare_blocks(encoded, esize, data, size);
+    compare(noise_protobuf_prepare_input(&pbuf, encoded, esize),
+            NOISE_ERROR_NONE);
+    compare(Noise_CertificateChain_read(&pbuf, 0, &chain2), NOISE_ERROR_NONE);
+    compare(noise_protobuf_finish_input(&pbuf), NOISE_ERROR_NONE);
+    compare(Noise_CertificateChain_count_certs(chain2), 3);
+    compare_certificates(Noise_CertificateChain_get_at_certs(chain, 1),
+                         Noise_CertificateChain_get_at_certs(chain2, 1));
+    Noise_CertificateChain_free(chain2);
+
+    /* Every buffer size that is too small fails cleanly */
+    for (index = 0; index < size; index += 7) {
+        compare(noise_protobuf_prepare_encode(&pbuf, encoded, index),
+                NOISE_ERROR_NONE);
+        compare(Noise_CertificateChain_encode(&pbuf, 0, chain),
+                NOISE_ERROR_INVALID_LENGTH);
+        compare(noise_protobuf_finish_encode(&pbuf, &esize),
+                NOISE_ERROR_INVALID_LENGTH);
+    }
+    Noise_CertificateChain_free(chain);
+
+    /* Encrypted private key */
+    compare(Noise_EncryptedPrivateKey_new(&key), NOISE_ERROR_NONE);
+    compare(Noise_EncryptedPrivateKey_set_version(key, 1), NOISE_ERROR_NONE);
+    compare(Noise_EncryptedPrivateKey_set_algorithm
+                (key, "ChaChaPoly_BLAKE2b_PBKDF2", 25),
+            NOISE_ERROR_NONE);
+    compare(Noise_EncryptedPrivateKey_set_salt(key, buffer, 16),
+            NOISE_ERROR_NONE);
+    compare(Noise_EncryptedPrivateKey_set_iterations(key, 20000),
+            NOISE_ERROR_NONE);
+    compare(Noise_EncryptedPrivateKey_set_encrypted_data(key, buffer, 150),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_prepare_output(&pbuf, buffer, sizeof(buffer)),
+            NOISE_ERROR_NONE);
+    compare(Noise_EncryptedPrivateKey_write(&pbuf, 0, key), NOISE_ERROR_NONE);
+    compare(noise_protobuf_finish_output(&pbuf, &data, &size),
+            NOISE_ERROR_NONE);
+    compare(Noise_EncryptedPrivateKey_measure(0, key), size);
+    compare(noise_protobuf_prepare_encode(&pbuf, encoded, size),
+            NOISE_ERROR_NONE);
+    compare(Noise_EncryptedPrivateKey_encode(&pbuf, 0, key), NOISE_ERROR_NONE);
+    compare(noise_protobuf_finish_encode(&pbuf, &esize), NOISE_ERROR_NONE);
+    compare_blocks(encoded, esize, data, size);
+    compare(noise_protobuf_prepare_input(&pbuf, encoded, esize),
+            NOISE_ERROR_NONE);
+    compare(Noise_EncryptedPrivateKey_read(&pbuf, 0, &key2), NOISE_ERROR_NONE);
+    compare(noise_protobuf_finish_input(&pbuf), NOISE_ERROR_NONE);
+    compare(Noise_EncryptedPrivateKey_get_iterations(key2), 20000);
+    compare(Noise_EncryptedPrivateKey_get_size_encrypted_data(key2), 150);
+    Noise_EncryptedPrivateKey_free(key2);
+    Noise_EncryptedPrivateKey_free(key);
+}
+
+/* Message type with a hand-written descriptor that covers the field
+   kinds that do not appear in certificates */
+typedef struct _TestTableMessage TestTableMessage;
+struct _TestTableMessage {
+    int32_t *packed;
+    size_t packed_count_;
+    size_t packed_max_;
+    uint64_t *numbers;
+    size_t numbers_count_;
+    size_t numbers_max_;
+    int flag;
+    double ratio;
+    char *name;
+    size_t name_size_;
+    void **blobs;
+    size_t *blobs_size_;
+    size_t blobs_count_;
+    size_t blobs_max_;
+    TestTableMessage *child;
+    TestTableMessage **children;
+    size_t children_count_;
+    size_t children_max_;
+    size_t size_cache_;
+};
+static const NoiseProtobufMessageDesc TestTableMessage_desc;
+static const NoiseProtobufFieldDesc TestTableMessage_fields[] = {
+    {1, NOISE_PROTOBUF_TYPE_SINT32, NOISE_PROTOBUF_QUAL_PACKED,
+     offsetof(TestTableMessage, packed), 0,
+     offsetof(TestTableMessage, packed_count_),
+     offsetof(TestTableMessage, packed_max_), 0},
+    {2, NOISE_PROTOBUF_TYPE_UINT64, NOISE_PROTOBUF_QUAL_REPEATED,
+     offsetof(TestTableMessage, numbers), 0,
+     offsetof(TestTableMessage, numbers_count_),
+     offsetof(TestTableMessage, numbers_max_), 0},
+    {3, NOISE_PROTOBUF_TYPE_BOOL, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(TestTableMessage, flag), 0, 0, 0, 0},
+    {4, NOISE_PROTOBUF_TYPE_DOUBLE, NOISE_PROTOBUF_QUAL_OPTIONAL,
+     offsetof(TestTableMessage, ratio), 0, 0, 0, 0},
+    {5, NOISE_PROTOBUF_TYPE_STRING, NOISE_PROTOBUF_QUAL_REQUIRED,
+     offsetof(TestTableMessage, name),
+     offsetof(TestTableMessage, name_size_), 0, 0, 0},
+    {6, NOISE_PROTOBUF_TYPE_BYTES, NOISE_PROTOBUF_QUAL_REPEATED,
+     offsetof(TestTableMessage, blobs),
+     offsetof(TestTableMessage, blobs_size_),
+     offsetof(TestTableMessage, blobs_count_),
+     offsetof(TestTableMessage, blobs_max_), 0},
+    {7, NOISE_PROTOBUF_TYPE_MESSAGE, NOISE_PROTOBUF_QUAL_REQUIRED,
+     offsetof(TestTableMessage, child), 0, 0, 0, &TestTableMessage_desc},
+    {8, NOISE_PROTOBUF_TYPE_MESSAGE, NOISE_PROTOBUF_QUAL_REPEATED,
+     offsetof(TestTableMessage, children), 0,
+     offsetof(TestTableMessage, children_count_),
+     offsetof(TestTableMessage, children_max_), &TestTableMessage_desc}
+};
+static const NoiseProtobufMessageDesc TestTableMessage_desc = {
+    sizeof(TestTableMessage), offsetof(TestTableMessage, size_cache_),
+    8, TestTableMessage_fields
+};
+
+/* Writes the expected encoding of an empty TestTableMessage */
+static void write_table_default(NoiseProtobuf *pbuf, int tag)
+{
+    size_t end, end2;
+    noise_protobuf_write_end_element(pbuf, &end);
+    noise_protobuf_write_end_element(pbuf, &end2);
+    noise_protobuf_write_start_element(pbuf, 7, end2);
+    noise_protobuf_write_string(pbuf, 5, "", 0);
+    noise_protobuf_write_double(pbuf, 4, 0.0);
+    noise_protobuf_write_end_element(pbuf, &end2);
+    noise_protobuf_write_start_element(pbuf, 1, end2);
+    noise_protobuf_write_start_element(pbuf, tag, end);
+}
+
+static void test_protobufs_tables(void)
+{
+    static int32_t const packed[3] = {-1, 2, -300};
+    static uint64_t const numbers[3] = {1, 300, 0x10000000000ULL};
+    uint8_t expected[256];
+    uint8_t buffer[256];
+    TestTableMessage *obj = 0;
+    TestTableMessage *obj2 = 0;
+    void *child = 0;
+    void *child2 = 0;
+    NoiseProtobuf pbuf;
+    uint8_t *data;
+    uint8_t *edata;
+    size_t size, esize, end, end2, index;
+
+    data_name = 0;
+
+    /* Populate an object using the shared field helpers */
+    compare(noise_protobuf_table_new(&TestTableMessage_desc, (void **)&obj),
+            NOISE_ERROR_NONE);
+    for (index = 0; index < 3; ++index) {
+        compare(noise_protobuf_add_to_array
+                    ((void **)&(obj->packed), &(obj->packed_count_),
+                     &(obj->packed_max_), &(packed[index]), sizeof(int32_t)),
+                NOISE_ERROR_NONE);
+        compare(noise_protobuf_add_to_array
+                    ((void **)&(obj->numbers), &(obj->numbers_count_),
+                     &(obj->numbers_max_), &(numbers[index]),
+                     sizeof(uint64_t)),
+                NOISE_ERROR_NONE);
+    }
+    obj->flag = 1;
+    obj->ratio = 0.5;
+    compare(noise_protobuf_table_set_field
+                (&TestTableMessage_fields[4], obj, "table", 5),
+            NOISE_ERROR_NONE);
+    compare(obj->name_size_, 5);
+    verify(!strcmp(obj->name, "table"));
+    compare(noise_protobuf_add_to_bytes_array
+                (&(obj->blobs), &(obj->blobs_size_), &(obj->blobs_count_),
+                 &(obj->blobs_max_), "\x01\x02", 2),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_add_to_bytes_array
+                (&(obj->blobs), &(obj->blobs_size_), &(obj->blobs_count_),
+                 &(obj->blobs_max_), "", 0),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_table_add_field
+                (&TestTableMessage_fields[7], obj, &child),
+            NOISE_ERROR_NONE);
+    verify(child != 0);
+    compare(obj->children_count_, 1);
+    verify(obj->children[0] == child);
+
+    /* Write the same fields with the low-level API in reverse order */
+    compare(noise_protobuf_prepare_output(&pbuf, expected, sizeof(expected)),
+            NOISE_ERROR_NONE);
+    noise_protobuf_write_end_element(&pbuf, &end);
+    write_table_default(&pbuf, 8);
+    noise_protobuf_write_end_element(&pbuf, &end2);
+    noise_protobuf_write_start_element(&pbuf, 7, end2);
+    noise_protobuf_write_bytes(&pbuf, 6, "", 0);
+    noise_protobuf_write_bytes(&pbuf, 6, "\x01\x02", 2);
+    noise_protobuf_write_string(&pbuf, 5, "table", 5);
+    noise_protobuf_write_double(&pbuf, 4, 0.5);
+    noise_protobuf_write_bool(&pbuf, 3, 1);
+    for (index = 3; index > 0; --index)
+        noise_protobuf_write_uint64(&pbuf, 2, numbers[index - 1]);
+    noise_protobuf_write_end_element(&pbuf, &end2);
+    for (index = 3; index > 0; --index)
+        noise_protobuf_write_sint32(&pbuf, 0, packed[index - 1]);
+    noise_protobuf_write_start_element(&pbuf, 1, end2);
+    noise_protobuf_write_start_element(&pbuf, 0, end);
+    compare(noise_protobuf_finish_output(&pbuf, &edata, &esize),
+            NOISE_ERROR_NONE);
+
+    /* Table-driven write, measure, and encode all produce the same bytes */
+    compare(noise_protobuf_prepare_output(&pbuf, buffer, sizeof(buffer)),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_table_write(&pbuf, 0, &TestTableMessage_desc, obj),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_finish_output(&pbuf, &data, &size),
+            NOISE_ERROR_NONE);
+    compare_blocks(data, size, edata, esize);
+    compare(noise_protobuf_table_measure(0, &TestTableMessage_desc, obj),
+            esize);
+    compare(noise_protobuf_prepare_encode(&pbuf, buffer, sizeof(buffer)),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_table_encode(&pbuf, 0, &TestTableMessage_desc, obj),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_finish_encode(&pbuf, &size), NOISE_ERROR_NONE);
+    compare_blocks(buffer, size, edata, esize);
+
+    /* Read the object back again */
+    compare(noise_protobuf_prepare_input(&pbuf, edata, esize),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_table_read
+                (&pbuf, 0, &TestTableMessage_desc, (void **)&obj2),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_finish_input(&pbuf), NOISE_ERROR_NONE);
+    compare_blocks((const uint8_t *)(obj2->packed),
+                   obj2->packed_count_ * sizeof(int32_t),
+                   (const uint8_t *)packed, sizeof(packed));
+    compare_blocks((const uint8_t *)(obj2->numbers),
+                   obj2->numbers_count_ * sizeof(uint64_t),
+                   (const uint8_t *)numbers, sizeof(numbers));
+    compare(obj2->flag, 1);
+    verify(obj2->ratio == 0.5);
+    compare(obj2->name_size_, 5);
+    verify(!strcmp(obj2->name, "table"));
+    compare(obj2->blobs_count_, 2);
+    compare_blocks((const uint8_t *)(obj2->blobs[0]), obj2->blobs_size_[0],
+                   (const uint8_t *)"\x01\x02", 2);
+    compare(obj2->blobs_size_[1], 0);
+    verify(obj2->child != 0);
+    compare(obj2->child->name_size_, 0);
+    compare(obj2->children_count_, 1);
+    verify(obj2->children[0]->child != 0);
+
+    /* Clearing and replacing fields */
+    compare(noise_protobuf_table_clear_field(&TestTableMessage_fields[5], obj2),
+            NOISE_ERROR_NONE);
+    verify(obj2->blobs == 0);
+    compare(obj2->blobs_count_, 0);
+    compare(noise_protobuf_table_clear_field(&TestTableMessage_fields[3], obj2),
+            NOISE_ERROR_NONE);
+    verify(obj2->ratio == 0.0);
+    compare(noise_protobuf_table_get_new_field
+                (&TestTableMessage_fields[6], obj2, &child2),
+            NOISE_ERROR_NONE);
+    verify(obj2->child == child2);
+    compare(obj2->child->children_count_, 0);
+    compare(noise_protobuf_table_clear_field(0, obj2),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_protobuf_table_get_new_field
+                (&TestTableMessage_fields[6], 0, &child2),
+            NOISE_ERROR_INVALID_PARAM);
+    verify(child2 == 0);
+    compare(noise_protobuf_table_free(&TestTableMessage_desc, obj2),
+            NOISE_ERROR_NONE);
+
+    /* Fields in an unexpected order and unknown fields */
+    compare(noise_protobuf_prepare_output(&pbuf, expected, sizeof(expected)),
+            NOISE_ERROR_NONE);
+    noise_protobuf_write_end_element(&pbuf, &end);
+    noise_protobuf_write_uint64(&pbuf, 2, 5);
+    noise_protobuf_write_uint64(&pbuf, 9, 77);
+    noise_protobuf_write_bool(&pbuf, 3, 1);
+    noise_protobuf_write_uint64(&pbuf, 2, 4);
+    noise_protobuf_write_start_element(&pbuf, 0, end);
+    compare(noise_protobuf_finish_output(&pbuf, &edata, &esize),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_prepare_input(&pbuf, edata, esize),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_table_read
+                (&pbuf, 0, &TestTableMessage_desc, (void **)&obj2),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_finish_input(&pbuf), NOISE_ERROR_NONE);
+    compare(obj2->numbers_count_, 2);
+    compare(obj2->numbers[0], 4);
+    compare(obj2->numbers[1], 5);
+    compare(obj2->flag, 1);
+    verify(obj2->name == 0);
+    verify(obj2->child == 0);
+    noise_protobuf_table_free(&TestTableMessage_desc, obj2);
+
+    /* Truncated input fails and does not return an object */
+    compare(noise_protobuf_prepare_input(&pbuf, edata, esize - 1),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_table_read
+                (&pbuf, 0, &TestTableMessage_desc, (void **)&obj2),
+            NOISE_ERROR_INVALID_FORMAT);
+    verify(obj2 == 0);
+
+    compare(noise_protobuf_table_free(&TestTableMessage_desc, obj),
+            NOISE_ERROR_NONE);
+    compare(noise_protobuf_table_free(&TestTableMessage_desc, 0),
+            NOISE_ERROR_INVALID_PARAM);
+}
+
 void test_protobufs(void)
 {
     test_protobufs_prepare();
@@ -1208,4 +2012,10 @@ void test_protobufs(void)
     test_protobufs_floating_point();
     test_protobufs_string();
     test_protobufs_element();
+    test_protobufs_arena_alloc();
+    test_protobufs_arena_fields();
+    test_protobufs_arena_certificates();
+    test_protobufs_encode();
+    test_protobufs_encode_certificates();
+    test_protobufs_tables();
 }
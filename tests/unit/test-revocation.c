@@ -0,0 +1,371 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test-helpers.h"
+#include <noise/keys.h>
+
+#define REVOKE_FILE "test-revocation.tmp"
+#define NUM_KEYS    5000
+
+/* Generates a deterministic public key for key number "n" */
+static void make_key(uint8_t *key, size_t key_len, uint32_t n)
+{
+    size_t index;
+    for (index = 0; index < key_len; ++index)
+        key[index] = (uint8_t)(n * 7 + index);
+    key[0] = (uint8_t)n;
+    key[1] = (uint8_t)(n >> 8);
+    key[2] = (uint8_t)(n >> 16);
+}
+
+/* Computes the full fingerprint of a public key */
+static void make_fingerprint(uint8_t *fp, const uint8_t *key, size_t key_len)
+{
+    NoiseHashState *hash = 0;
+    compare(noise_hashstate_new_by_id(&hash, NOISE_HASH_SHA256),
+            NOISE_ERROR_NONE);
+    compare(noise_hashstate_hash_one
+                (hash, key, key_len, fp, NOISE_REVOCATION_FINGERPRINT_LEN),
+            NOISE_ERROR_NONE);
+    noise_hashstate_free(hash);
+}
+
+/* Check building a revocation set and checking keys against it */
+static void revocation_check_keys(void)
+{
+    NoiseRevocationBuilder *builder = 0;
+    NoiseRevocationSet *set = 0;
+    uint8_t key[32];
+    uint8_t fp[NOISE_REVOCATION_FINGERPRINT_LEN];
+    uint32_t n;
+    int expected;
+
+    /* Revoke the even-numbered keys, half by key and half by fingerprint */
+    compare(noise_revocation_builder_new(&builder), NOISE_ERROR_NONE);
+    for (n = 0; n < NUM_KEYS; n += 2) {
+        make_key(key, sizeof(key), n);
+        if (n % 4) {
+            compare(noise_revocation_builder_add_key
+                        (builder, key, sizeof(key)),
+                    NOISE_ERROR_NONE);
+        } else {
+            make_fingerprint(fp, key, sizeof(key));
+            compare(noise_revocation_builder_add_fingerprint
+                        (builder, fp, sizeof(fp)),
+                    NOISE_ERROR_NONE);
+        }
+    }
+
+    /* Duplicates are removed when the set is saved */
+    make_key(key, sizeof(key), 2);
+    compare(noise_revocation_builder_add_key(builder, key, sizeof(key)),
+            NOISE_ERROR_NONE);
+    compare(noise_revocation_builder_save(builder, REVOKE_FILE),
+            NOISE_ERROR_NONE);
+    compare(noise_revocation_builder_free(builder), NOISE_ERROR_NONE);
+
+    /* Open the set and check every key */
+    compare(noise_revocation_open(&set, REVOKE_FILE), NOISE_ERROR_NONE);
+    compare(noise_revocation_get_count(set), NUM_KEYS / 2);
+    for (n = 0; n < NUM_KEYS; ++n) {
+        expected = (n & 1) ? NOISE_ERROR_NONE : NOISE_ERROR_KEY_REVOKED;
+        make_key(key, sizeof(key), n);
+        compare(noise_revocation_check_key(set, key, sizeof(key)), expected);
+        make_fingerprint(fp, key, sizeof(key));
+        compare(noise_revocation_check_fingerprint(set, fp, sizeof(fp)),
+                expected);
+    }
+
+    /* Keys of other lengths are not revoked */
+    make_key(key, sizeof(key), 0);
+    compare(noise_revocation_check_key(set, key, 31), NOISE_ERROR_NONE);
+
+    /* Error cases */
+    compare(noise_revocation_check_key(0, key, sizeof(key)),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_revocation_check_key(set, 0, sizeof(key)),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_revocation_check_fingerprint(set, fp, 16),
+            NOISE_ERROR_INVALID_LENGTH);
+    compare(noise_revocation_ref(set), NOISE_ERROR_NONE);
+    compare(noise_revocation_close(set), NOISE_ERROR_NONE);
+    compare(noise_revocation_close(set), NOISE_ERROR_NONE);
+    remove(REVOKE_FILE);
+}
+
+/* Check revocation of the keys that appear in certificates */
+static void revocation_check_certificates(void)
+{
+    static uint8_t const subject_key[32] = {1, 2, 3, 4, 5, 6, 7, 8};
+    static uint8_t const signing_key[32] = {8, 7, 6, 5, 4, 3, 2, 1};
+    static uint8_t const other_key[32] = {9, 9, 9, 9};
+    NoiseRevocationBuilder *builder = 0;
+    NoiseRevocationSet *set = 0;
+    Noise_Certificate *cert = 0;
+    Noise_CertificateChain *chain = 0;
+    Noise_SubjectInfo *subject = 0;
+    Noise_PublicKeyInfo *key = 0;
+    Noise_Signature *sig = 0;
+
+    /* Create a certificate with a subject key and a signing key */
+    compare(Noise_CertificateChain_new(&chain), NOISE_ERROR_NONE);
+    compare(Noise_CertificateChain_add_certs(chain, &cert), NOISE_ERROR_NONE);
+    compare(Noise_Certificate_get_new_subject(cert, &subject),
+            NOISE_ERROR_NONE);
+    compare(Noise_SubjectInfo_add_keys(subject, &key), NOISE_ERROR_NONE);
+    compare(Noise_PublicKeyInfo_set_algorithm(key, "25519", 5),
+            NOISE_ERROR_NONE);
+    compare(Noise_PublicKeyInfo_set_key(key, subject_key, sizeof(subject_key)),
+            NOISE_ERROR_NONE);
+    compare(Noise_Certificate_add_signatures(cert, &sig), NOISE_ERROR_NONE);
+    compare(Noise_Signature_get_new_signing_key(sig, &key), NOISE_ERROR_NONE);
+    compare(Noise_PublicKeyInfo_set_algorithm(key, "Ed25519", 7),
+            NOISE_ERROR_NONE);
+    compare(Noise_PublicKeyInfo_set_key(key, signing_key, sizeof(signing_key)),
+            NOISE_ERROR_NONE);
+
+    /* Not revoked */
+    compare(noise_revocation_builder_new(&builder), NOISE_ERROR_NONE);
+    compare(noise_revocation_builder_add_key
+                (builder, other_key, sizeof(other_key)),
+            NOISE_ERROR_NONE);
+    compare(noise_revocation_builder_save(builder, REVOKE_FILE),
+            NOISE_ERROR_NONE);
+    compare(noise_revocation_open(&set, REVOKE_FILE), NOISE_ERROR_NONE);
+    compare(noise_revocation_check_certificate(set, cert), NOISE_ERROR_NONE);
+    compare(noise_revocation_check_chain(set, chain), NOISE_ERROR_NONE);
+    compare(noise_revocation_close(set), NOISE_ERROR_NONE);
+
+    /* Revoking the signing key revokes the certificate */
+    compare(noise_revocation_builder_add_key
+                (builder, signing_key, sizeof(signing_key)),
+            NOISE_ERROR_NONE);
+    compare(noise_revocation_builder_save(builder, REVOKE_FILE),
+            NOISE_ERROR_NONE);
+    compare(noise_revocation_open(&set, REVOKE_FILE), NOISE_ERROR_NONE);
+    compare(noise_revocation_check_certificate(set, cert),
+            NOISE_ERROR_KEY_REVOKED);
+    compare(noise_revocation_check_chain(set, chain),
+            NOISE_ERROR_KEY_REVOKED);
+    compare(noise_revocation_close(set), NOISE_ERROR_NONE);
+    compare(noise_revocation_builder_free(builder), NOISE_ERROR_NONE);
+
+    /* Revoking the subject key revokes the certificate */
+    compare(noise_revocation_builder_new(&builder), NOISE_ERROR_NONE);
+    compare(noise_revocation_builder_add_key
+                (builder, subject_key, sizeof(subject_key)),
+            NOISE_ERROR_NONE);
+    compare(noise_revocation_builder_save(builder, REVOKE_FILE),
+            NOISE_ERROR_NONE);
+    compare(noise_revocation_builder_free(builder), NOISE_ERROR_NONE);
+    compare(noise_revocation_open(&set, REVOKE_FILE), NOISE_ERROR_NONE);
+    compare(noise_revocation_check_certificate(set, cert),
+            NOISE_ERROR_KEY_REVOKED);
+    compare(noise_revocation_close(set), NOISE_ERROR_NONE);
+
+    Noise_CertificateChain_free(chain);
+    remove(REVOKE_FILE);
+}
+
+/* Runs a handshake with a revocation set attached to the responder */
+static int run_handshake(const char *protocol, NoiseRevocationSet *set,
+                         NoiseDHState *init_key)
+{
+    NoiseHandshakeState *initiator = 0;
+    NoiseHandshakeState *responder = 0;
+    NoiseHandshakeState *send;
+    NoiseHandshakeState *recv;
+    uint8_t message[4096];
+    uint8_t public_key[32];
+    NoiseBuffer mbuf;
+    NoiseDHState *dh;
+    int action;
+    int err = NOISE_ERROR_NONE;
+
+    compare(noise_handshakestate_new_by_name
+                (&initiator, protocol, NOISE_ROLE_INITIATOR),
+            NOISE_ERROR_NONE);
+    compare(noise_handshakestate_new_by_name
+                (&responder, protocol, NOISE_ROLE_RESPONDER),
+            NOISE_ERROR_NONE);
+    compare(noise_revocation_attach(set, responder), NOISE_ERROR_NONE);
+
+    /* Set up the keys */
+    if (noise_handshakestate_needs_pre_shared_key(initiator)) {
+        memset(public_key, 0x42, sizeof(public_key));
+        compare(noise_handshakestate_set_pre_shared_key
+                    (initiator, public_key, sizeof(public_key)),
+                NOISE_ERROR_NONE);
+        compare(noise_handshakestate_set_pre_shared_key
+                    (responder, public_key, sizeof(public_key)),
+                NOISE_ERROR_NONE);
+    }
+    dh = noise_handshakestate_get_local_keypair_dh(initiator);
+    compare(noise_dhstate_copy(dh, init_key), NOISE_ERROR_NONE);
+    dh = noise_handshakestate_get_local_keypair_dh(responder);
+    compare(noise_dhstate_generate_keypair(dh), NOISE_ERROR_NONE);
+    if (noise_handshakestate_needs_remote_public_key(initiator)) {
+        compare(noise_dhstate_get_public_key
+                    (dh, public_key, sizeof(public_key)),
+                NOISE_ERROR_NONE);
+        compare(noise_dhstate_set_public_key
+                    (noise_handshakestate_get_remote_public_key_dh(initiator),
+                     public_key, sizeof(public_key)),
+                NOISE_ERROR_NONE);
+    }
+
+    /* Run the handshake until it finishes or fails */
+    compare(noise_handshakestate_start(initiator), NOISE_ERROR_NONE);
+    compare(noise_handshakestate_start(responder), NOISE_ERROR_NONE);
+    for (;;) {
+        action = noise_handshakestate_get_action(initiator);
+        if (action == NOISE_ACTION_WRITE_MESSAGE) {
+            send = initiator;
+            recv = responder;
+        } else if (action == NOISE_ACTION_READ_MESSAGE) {
+            send = responder;
+            recv = initiator;
+        } else {
+            break;
+        }
+        noise_buffer_set_output(mbuf, message, sizeof(message));
+        compare(noise_handshakestate_write_message(send, &mbuf, 0),
+                NOISE_ERROR_NONE);
+        err = noise_handshakestate_read_message(recv, &mbuf, 0);
+        if (err != NOISE_ERROR_NONE) {
+            compare(noise_handshakestate_get_action(recv),
+                    NOISE_ACTION_FAILED);
+            break;
+        }
+    }
+
+    noise_handshakestate_free(initiator);
+    noise_handshakestate_free(responder);
+    return err;
+}
+
+/* Check that revoked keys are rejected during the handshake */
+static void revocation_check_handshake(void)
+{
+    static const char * const protocols[] = {
+        "Noise_X_25519_ChaChaPoly_BLAKE2s",
+        "Noise_IK_25519_AESGCM_SHA256",
+        "Noise_XX_25519_ChaChaPoly_SHA512",
+        "NoisePSK_XX_25519_ChaChaPoly_BLAKE2s",
+        0
+    };
+    NoiseRevocationBuilder *builder = 0;
+    NoiseRevocationSet *set = 0;
+    NoiseDHState *good_key = 0;
+    NoiseDHState *bad_key = 0;
+    uint8_t public_key[32];
+    int index;
+
+    /* Revoke one of two client keys */
+    compare(noise_dhstate_new_by_id(&good_key, NOISE_DH_CURVE25519),
+            NOISE_ERROR_NONE);
+    compare(noise_dhstate_new_by_id(&bad_key, NOISE_DH_CURVE25519),
+            NOISE_ERROR_NONE);
+    compare(noise_dhstate_generate_keypair(good_key), NOISE_ERROR_NONE);
+    compare(noise_dhstate_generate_keypair(bad_key), NOISE_ERROR_NONE);
+    compare(noise_dhstate_get_public_key
+                (bad_key, public_key, sizeof(public_key)),
+            NOISE_ERROR_NONE);
+    compare(noise_revocation_builder_new(&builder), NOISE_ERROR_NONE);
+    compare(noise_revocation_builder_add_key
+                (builder, public_key, sizeof(public_key)),
+            NOISE_ERROR_NONE);
+    compare(noise_revocation_builder_save(builder, REVOKE_FILE),
+            NOISE_ERROR_NONE);
+    compare(noise_revocation_builder_free(builder), NOISE_ERROR_NONE);
+    compare(noise_revocation_open(&set, REVOKE_FILE), NOISE_ERROR_NONE);
+    compare(noise_revocation_check_dhstate(set, bad_key),
+            NOISE_ERROR_KEY_REVOKED);
+    compare(noise_revocation_check_dhstate(set, good_key), NOISE_ERROR_NONE);
+
+    /* Run handshakes with both keys */
+    for (index = 0; protocols[index]; ++index) {
+        data_name = protocols[index];
+        compare(run_handshake(protocols[index], set, good_key),
+                NOISE_ERROR_NONE);
+        compare(run_handshake(protocols[index], set, bad_key),
+                NOISE_ERROR_KEY_REVOKED);
+        compare(run_handshake(protocols[index], 0, bad_key),
+                NOISE_ERROR_NONE);
+    }
+    data_name = 0;
+
+    compare(noise_revocation_attach(set, 0), NOISE_ERROR_INVALID_PARAM);
+    compare(noise_revocation_close(set), NOISE_ERROR_NONE);
+    noise_dhstate_free(good_key);
+    noise_dhstate_free(bad_key);
+    remove(REVOKE_FILE);
+}
+
+/* Check error handling when opening revocation sets */
+static void revocation_check_errors(void)
+{
+    NoiseRevocationBuilder *builder = 0;
+    NoiseRevocationSet *set = 0;
+    uint8_t key[32];
+    FILE *file;
+
+    /* An empty revocation set revokes nothing */
+    compare(noise_revocation_builder_new(&builder), NOISE_ERROR_NONE);
+    compare(noise_revocation_builder_save(builder, REVOKE_FILE),
+            NOISE_ERROR_NONE);
+    compare(noise_revocation_builder_free(builder), NOISE_ERROR_NONE);
+    compare(noise_revocation_open(&set, REVOKE_FILE), NOISE_ERROR_NONE);
+    compare(noise_revocation_get_count(set), 0);
+    make_key(key, sizeof(key), 1);
+    compare(noise_revocation_check_key(set, key, sizeof(key)),
+            NOISE_ERROR_NONE);
+    compare(noise_revocation_close(set), NOISE_ERROR_NONE);
+
+    /* Corrupt and truncated files are rejected */
+    file = fopen(REVOKE_FILE, "r+b");
+    verify(file != 0);
+    fputc('X', file);
+    fclose(file);
+    compare(noise_revocation_open(&set, REVOKE_FILE),
+            NOISE_ERROR_INVALID_FORMAT);
+    verify(set == 0);
+    file = fopen(REVOKE_FILE, "wb");
+    verify(file != 0);
+    fputs("NoiseRV1", file);
+    fclose(file);
+    compare(noise_revocation_open(&set, REVOKE_FILE),
+            NOISE_ERROR_INVALID_FORMAT);
+    remove(REVOKE_FILE);
+    compare(noise_revocation_open(&set, REVOKE_FILE), NOISE_ERROR_SYSTEM);
+    compare(noise_revocation_open(0, REVOKE_FILE), NOISE_ERROR_INVALID_PARAM);
+    compare(noise_revocation_open(&set, 0), NOISE_ERROR_INVALID_PARAM);
+    compare(noise_revocation_builder_new(0), NOISE_ERROR_INVALID_PARAM);
+}
+
+void test_revocation(void)
+{
+    revocation_check_keys();
+    revocation_check_certificates();
+    revocation_check_handshake();
+    revocation_check_errors();
+}
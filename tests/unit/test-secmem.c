@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test-helpers.h"
+#if defined(HAVE_LIBPTHREAD)
+#include <pthread.h>
+#endif
+
+/* Object sizes to allocate, covering every slab class and the heap */
+static size_t const object_sizes[] = {
+    4, 8, 64, 65, 200, 384, 1000, 2048, 3760, 4320, 8192, 8193, 20000
+};
+#define NUM_OBJECT_SIZES (sizeof(object_sizes) / sizeof(object_sizes[0]))
+
+/* Checks that a newly allocated object is zero apart from its size field */
+static void check_new_object(uint8_t *obj, size_t size)
+{
+    size_t posn = 0;
+    verify(obj != 0);
+    if (size >= sizeof(size_t)) {
+        compare(*((size_t *)obj), size);
+        posn = sizeof(size_t);
+    }
+    for (; posn < size; ++posn)
+        compare(obj[posn], 0);
+}
+
+/* Allocates and frees objects of every size, checking that memory which
+   is recycled from the free lists has been wiped */
+static void secmem_check_alloc(void)
+{
+    uint8_t *objs[NUM_OBJECT_SIZES];
+    NoiseSecMemStats stats;
+    size_t index;
+    int round;
+
+    for (round = 0; round < 3; ++round) {
+        for (index = 0; index < NUM_OBJECT_SIZES; ++index) {
+            objs[index] = (uint8_t *)noise_new_object(object_sizes[index]);
+            check_new_object(objs[index], object_sizes[index]);
+            memset(objs[index], 0xAA, object_sizes[index]);
+        }
+        for (index = 0; index < NUM_OBJECT_SIZES; ++index)
+            noise_free(objs[index], object_sizes[index]);
+    }
+
+    /* Objects in the same class are recycled, even with a smaller size */
+    objs[0] = (uint8_t *)noise_new_object(3000);
+    memset(objs[0], 0x55, 3000);
+    noise_free(objs[0], 3000);
+    objs[1] = (uint8_t *)noise_new_object(2100);
+    verify(objs[1] == objs[0]);
+    check_new_object(objs[1], 2100);
+    objs[2] = (uint8_t *)noise_new_object(2100);
+    verify(objs[2] != objs[1]);
+    check_new_object(objs[2], 2100);
+    noise_free(objs[1], 2100);
+    noise_free(objs[2], 2100);
+
+    /* Each of the classes that were used needs at least one slab */
+    compare(noise_secmem_get_stats(&stats), NOISE_ERROR_NONE);
+    verify(stats.reserved_bytes >= stats.slab_bytes);
+    verify(stats.slab_bytes >= 9 * 64 * 1024);
+    verify(stats.locked_bytes <= stats.slab_bytes);
+    compare(stats.flags, NOISE_SECMEM_DEFAULT);
+}
+
+/* Runs a complete handshake with objects allocated from slabs */
+static void secmem_check_handshake(void)
+{
+    static const char * const names[] = {
+        "Noise_NN_25519_ChaChaPoly_BLAKE2s",
+        "Noise_NN_448_AESGCM_SHA512",
+        "Noise_NN_NewHope_AESGCM_BLAKE2b",
+        "Noise_NN_MLKEM768_ChaChaPoly_SHA256"
+    };
+    NoiseHandshakeState *initiator;
+    NoiseHandshakeState *responder;
+    NoiseHandshakeState *send;
+    NoiseHandshakeState *recv;
+    NoiseCipherState *c1, *c2, *c3, *c4;
+    uint8_t message[4096];
+    NoiseBuffer mbuf;
+    size_t index;
+    int action;
+
+    for (index = 0; index < sizeof(names) / sizeof(names[0]); ++index) {
+        data_name = names[index];
+        compare(noise_handshakestate_new_by_name
+                    (&initiator, names[index], NOISE_ROLE_INITIATOR),
+                NOISE_ERROR_NONE);
+        compare(noise_handshakestate_new_by_name
+                    (&responder, names[index], NOISE_ROLE_RESPONDER),
+                NOISE_ERROR_NONE);
+        compare(noise_handshakestate_start(initiator), NOISE_ERROR_NONE);
+        compare(noise_handshakestate_start(responder), NOISE_ERROR_NONE);
+        for (;;) {
+            action = noise_handshakestate_get_action(initiator);
+            if (action == NOISE_ACTION_WRITE_MESSAGE) {
+                send = initiator;
+                recv = responder;
+            } else if (action == NOISE_ACTION_READ_MESSAGE) {
+                send = responder;
+                recv = initiator;
+            } else {
+                break;
+            }
+            noise_buffer_set_output(mbuf, message, sizeof(message));
+            compare(noise_handshakestate_write_message(send, &mbuf, 0),
+                    NOISE_ERROR_NONE);
+            compare(noise_handshakestate_read_message(recv, &mbuf, 0),
+                    NOISE_ERROR_NONE);
+        }
+        compare(noise_handshakestate_split(initiator, &c1, &c2),
+                NOISE_ERROR_NONE);
+        compare(noise_handshakestate_split(responder, &c3, &c4),
+                NOISE_ERROR_NONE);
+        memset(message, 0x42, 32);
+        noise_buffer_set_inout(mbuf, message, 32, sizeof(message));
+        compare(noise_cipherstate_encrypt(c1, &mbuf), NOISE_ERROR_NONE);
+        compare(noise_cipherstate_decrypt(c4, &mbuf), NOISE_ERROR_NONE);
+        compare(mbuf.size, 32);
+        compare(message[31], 0x42);
+        noise_cipherstate_free(c1);
+        noise_cipherstate_free(c2);
+        noise_cipherstate_free(c3);
+        noise_cipherstate_free(c4);
+        noise_handshakestate_free(initiator);
+        noise_handshakestate_free(responder);
+    }
+    data_name = 0;
+}
+
+#if defined(HAVE_LIBPTHREAD)
+
+#define SECMEM_THREADS 4
+#define SECMEM_THREAD_OBJECTS 40
+
+/* Allocates and frees objects from several threads at once.  Objects are
+   freed in a different order so that they move between the thread caches
+   and the global free lists */
+static void *secmem_thread(void *arg)
+{
+    int *failed = (int *)arg;
+    uint8_t *objs[SECMEM_THREAD_OBJECTS];
+    size_t size, posn;
+    int round, index;
+    for (round = 0; round < 50; ++round) {
+        for (index = 0; index < SECMEM_THREAD_OBJECTS; ++index) {
+            size = object_sizes[(round + index) % NUM_OBJECT_SIZES];
+            objs[index] = (uint8_t *)noise_new_object(size);
+            if (!objs[index]) {
+                *failed = 1;
+                return 0;
+            }
+            for (posn = sizeof(size_t); posn < size; ++posn) {
+                if (objs[index][posn] != 0)
+                    *failed = 1;
+            }
+            memset(objs[index], index + 1, size);
+        }
+        for (index = SECMEM_THREAD_OBJECTS - 1; index >= 0; --index) {
+            size = object_sizes[(round + index) % NUM_OBJECT_SIZES];
+            for (posn = 0; posn < size; ++posn) {
+                if (objs[index][posn] != (uint8_t)(index + 1))
+                    *failed = 1;
+            }
+            noise_free(objs[index], size);
+        }
+    }
+    return 0;
+}
+
+static void secmem_check_threads(void)
+{
+    pthread_t threads[SECMEM_THREADS];
+    int failed[SECMEM_THREADS];
+    int index;
+    for (index = 0; index < SECMEM_THREADS; ++index) {
+        failed[index] = 0;
+        compare(pthread_create(&(threads[index]), 0, secmem_thread,
+                               &(failed[index])), 0);
+    }
+    for (index = 0; index < SECMEM_THREADS; ++index) {
+        compare(pthread_join(threads[index], 0), 0);
+        compare(failed[index], 0);
+    }
+}
+
+#else
+
+static void secmem_check_threads(void)
+{
+}
+
+#endif
+
+void test_secmem(void)
+{
+    NoiseSecMemStats stats;
+    NoiseHashState *heap_obj;
+    int was_enabled = noise_secmem_is_enabled();
+
+    compare(noise_secmem_get_stats(0), NOISE_ERROR_INVALID_PARAM);
+
+    /* Objects allocated before the slabs exist must free normally */
+    noise_secmem_disable();
+    compare(noise_secmem_is_enabled(), 0);
+    compare(noise_hashstate_new_by_id(&heap_obj, NOISE_HASH_SHA256),
+            NOISE_ERROR_NONE);
+
+    /* Start the secure allocator */
+    compare(noise_secmem_init(0, NOISE_SECMEM_DEFAULT), NOISE_ERROR_NONE);
+    compare(noise_secmem_is_enabled(), 1);
+    compare(noise_secmem_init(0, 0), NOISE_ERROR_NONE);
+    compare(noise_secmem_get_stats(&stats), NOISE_ERROR_NONE);
+    compare(stats.flags, NOISE_SECMEM_DEFAULT);
+    verify(stats.reserved_bytes >= 16 * 1024 * 1024);
+    compare(noise_hashstate_free(heap_obj), NOISE_ERROR_NONE);
+
+    secmem_check_alloc();
+    secmem_check_handshake();
+    secmem_check_threads();
+
+    /* Slab objects can still be freed after the allocator is disabled */
+    heap_obj = 0;
+    compare(noise_hashstate_new_by_id(&heap_obj, NOISE_HASH_BLAKE2s),
+            NOISE_ERROR_NONE);
+    noise_secmem_disable();
+    compare(noise_secmem_is_enabled(), 0);
+    compare(noise_hashstate_free(heap_obj), NOISE_ERROR_NONE);
+    secmem_check_handshake();
+
+    /* Leave the allocator in the state that we found it */
+    if (was_enabled)
+        compare(noise_secmem_init(0, 0), NOISE_ERROR_NONE);
+}
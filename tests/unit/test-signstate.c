@@ -249,6 +249,23 @@ static void check_sign(int id, size_t private_key_len, size_t public_key_len,
                 (state1, priv_key, private_key_len, pub_key, public_key_len),
             NOISE_ERROR_NONE);
 
+    /* Signing must use the current key after it has been cleared, replaced,
+       or copied between objects, even if the back end caches derived state */
+    memset(temp, 0xAA, sizeof(temp));
+    compare(noise_signstate_sign(state1, msg, msg_len, temp, signature_len),
+            NOISE_ERROR_NONE);
+    verify(!memcmp(temp, sig, signature_len));
+    compare(noise_signstate_copy(state2, state1), NOISE_ERROR_NONE);
+    compare(noise_signstate_clear_key(state1), NOISE_ERROR_NONE);
+    memset(temp, 0xAA, sizeof(temp));
+    compare(noise_signstate_sign(state2, msg, msg_len, temp, signature_len),
+            NOISE_ERROR_NONE);
+    verify(!memcmp(temp, sig, signature_len));
+    compare(noise_signstate_set_public_key(state2, pub_key, public_key_len),
+            NOISE_ERROR_NONE);
+    compare(noise_signstate_sign(state2, msg, msg_len, temp, signature_len),
+            NOISE_ERROR_INVALID_PRIVATE_KEY);
+
     /* Clean up */
     compare(noise_signstate_free(state1), NOISE_ERROR_NONE);
     compare(noise_signstate_free(state2), NOISE_ERROR_NONE);
@@ -376,6 +393,118 @@ static void signstate_check_generate_keypair(void)
     check_dh_generate(NOISE_SIGN_ED25519);
 }
 
+/* Number of signatures to check in the batch verification test; large
+   enough to cover a full internal batch of 64 plus a partial batch */
+#define BATCH_COUNT 70
+
+/* Check batch verification of several signatures at once */
+static void check_verify_batch(int id)
+{
+    NoiseSignState *keys[BATCH_COUNT];
+    const NoiseSignState *states[BATCH_COUNT];
+    uint8_t msg_data[BATCH_COUNT][16];
+    uint8_t sig_data[BATCH_COUNT][MAX_SIGNATURE_LEN];
+    const uint8_t *messages[BATCH_COUNT];
+    const uint8_t *signatures[BATCH_COUNT];
+    size_t message_lens[BATCH_COUNT];
+    int valid[BATCH_COUNT];
+    size_t signature_len;
+    size_t index;
+
+    /* Sign a different message with a different key in each slot */
+    for (index = 0; index < BATCH_COUNT; ++index) {
+        compare(noise_signstate_new_by_id(&(keys[index]), id),
+                NOISE_ERROR_NONE);
+        compare(noise_signstate_generate_keypair(keys[index]),
+                NOISE_ERROR_NONE);
+        signature_len = noise_signstate_get_signature_length(keys[index]);
+        memset(msg_data[index], (int)index, sizeof(msg_data[index]));
+        message_lens[index] = index % sizeof(msg_data[index]);
+        compare(noise_signstate_sign(keys[index], msg_data[index],
+                                     message_lens[index], sig_data[index],
+                                     signature_len),
+                NOISE_ERROR_NONE);
+        states[index] = keys[index];
+        messages[index] = msg_data[index];
+        signatures[index] = sig_data[index];
+    }
+
+    /* All signatures should verify, in full batches and in small ones */
+    memset(valid, 0x55, sizeof(valid));
+    compare(noise_signstate_verify_batch(states, messages, message_lens,
+                                         signatures, signature_len,
+                                         BATCH_COUNT, valid),
+            NOISE_ERROR_NONE);
+    for (index = 0; index < BATCH_COUNT; ++index)
+        compare(valid[index], 1);
+    compare(noise_signstate_verify_batch(states, messages, message_lens,
+                                         signatures, signature_len, 2, 0),
+            NOISE_ERROR_NONE);
+    compare(noise_signstate_verify_batch(states, messages, message_lens,
+                                         signatures, signature_len, 0, 0),
+            NOISE_ERROR_NONE);
+
+    /* Corrupt a signature in each batch and check that only those fail */
+    sig_data[5][3] ^= 0x01;
+    message_lens[66] += 1;
+    compare(noise_signstate_verify_batch(states, messages, message_lens,
+                                         signatures, signature_len,
+                                         BATCH_COUNT, valid),
+            NOISE_ERROR_INVALID_SIGNATURE);
+    for (index = 0; index < BATCH_COUNT; ++index)
+        compare(valid[index], index != 5 && index != 66);
+    compare(noise_signstate_verify_batch(states, messages, message_lens,
+                                         signatures, signature_len,
+                                         BATCH_COUNT, 0),
+            NOISE_ERROR_INVALID_SIGNATURE);
+
+    /* Non-canonical S values must be rejected as by single verification */
+    sig_data[5][3] ^= 0x01;
+    sig_data[7][signature_len - 1] |= 0xE0;
+    compare(noise_signstate_verify(states[7], messages[7], message_lens[7],
+                                   signatures[7], signature_len),
+            NOISE_ERROR_INVALID_SIGNATURE);
+    compare(noise_signstate_verify_batch(states, messages, message_lens,
+                                         signatures, signature_len,
+                                         BATCH_COUNT, valid),
+            NOISE_ERROR_INVALID_SIGNATURE);
+    for (index = 0; index < BATCH_COUNT; ++index)
+        compare(valid[index], index != 7 && index != 66);
+
+    /* Parameter errors */
+    compare(noise_signstate_verify_batch(0, messages, message_lens,
+                                         signatures, signature_len, 1, valid),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_signstate_verify_batch(states, 0, message_lens,
+                                         signatures, signature_len, 1, valid),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_signstate_verify_batch(states, messages, 0,
+                                         signatures, signature_len, 1, valid),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_signstate_verify_batch(states, messages, message_lens,
+                                         0, signature_len, 1, valid),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_signstate_verify_batch(states, messages, message_lens,
+                                         signatures, signature_len - 1,
+                                         1, valid),
+            NOISE_ERROR_INVALID_LENGTH);
+    compare(noise_signstate_clear_key(keys[1]), NOISE_ERROR_NONE);
+    compare(noise_signstate_verify_batch(states, messages, message_lens,
+                                         signatures, signature_len,
+                                         2, valid),
+            NOISE_ERROR_INVALID_PUBLIC_KEY);
+
+    /* Clean up */
+    for (index = 0; index < BATCH_COUNT; ++index)
+        compare(noise_signstate_free(keys[index]), NOISE_ERROR_NONE);
+}
+
+/* Check batch verification for all signature algorithms */
+static void signstate_check_verify_batch(void)
+{
+    check_verify_batch(NOISE_SIGN_ED25519);
+}
+
 /* Check other error conditions that can be reported by the functions */
 static void signstate_check_errors(void)
 {
@@ -414,5 +543,6 @@ void test_signstate(void)
 {
     signstate_check_test_vectors();
     signstate_check_generate_keypair();
+    signstate_check_verify_batch();
     signstate_check_errors();
 }
@@ -605,8 +605,99 @@ static void symmetricstate_check_errors(void)
     verify(state == NULL);
 }
 
+/* Check exporting and importing a SymmetricState part way through */
+static void check_export(const char *name)
+{
+    static uint8_t const wrap_key[NOISE_EXPORT_KEY_LEN] = {
+        0xA5, 0x96, 0x87, 0x78, 0x69, 0x5A, 0x4B, 0x3C,
+        0x2D, 0x1E, 0x0F, 0xF0, 0xE1, 0xD2, 0xC3, 0xB4,
+        0x01, 0x12, 0x23, 0x34, 0x45, 0x56, 0x67, 0x78,
+        0x89, 0x9A, 0xAB, 0xBC, 0xCD, 0xDE, 0xEF, 0xF0
+    };
+    NoiseSymmetricState *state1;
+    NoiseSymmetricState *state2;
+    NoiseCipherState *c1;
+    NoiseCipherState *c2;
+    uint8_t blob_data[NOISE_MAX_EXPORT_LEN];
+    uint8_t packet1[64];
+    uint8_t packet2[64];
+    NoiseBuffer blob;
+    NoiseBuffer mbuf1;
+    NoiseBuffer mbuf2;
+    size_t hash_len;
+
+    data_name = name;
+    compare(noise_symmetricstate_new_by_name(&state1, name), NOISE_ERROR_NONE);
+    compare(noise_symmetricstate_mix_hash(state1, (const uint8_t *)"abc", 3),
+            NOISE_ERROR_NONE);
+    compare(noise_symmetricstate_mix_key(state1, (const uint8_t *)"def", 3),
+            NOISE_ERROR_NONE);
+    memset(packet1, 0x42, 16);
+    noise_buffer_set_inout(mbuf1, packet1, 16, sizeof(packet1));
+    compare(noise_symmetricstate_encrypt_and_hash(state1, &mbuf1),
+            NOISE_ERROR_NONE);
+
+    /* Export and import, and check that the states are identical */
+    noise_buffer_set_output(blob, blob_data, sizeof(blob_data));
+    compare(noise_symmetricstate_export
+                (state1, wrap_key, sizeof(wrap_key), &blob),
+            NOISE_ERROR_NONE);
+    compare(noise_symmetricstate_import
+                (&state2, wrap_key, sizeof(wrap_key), &blob),
+            NOISE_ERROR_NONE);
+    hash_len = noise_hashstate_get_hash_length(state1->hash);
+    verify(!memcmp(state1->ck, state2->ck, hash_len));
+    verify(!memcmp(state1->h, state2->h, hash_len));
+    verify(!memcmp(&(state1->id), &(state2->id), sizeof(NoiseProtocolId)));
+
+    /* Both states must produce the same ciphertext and split keys */
+    memset(packet1, 0x24, 16);
+    memset(packet2, 0x24, 16);
+    noise_buffer_set_inout(mbuf1, packet1, 16, sizeof(packet1));
+    noise_buffer_set_inout(mbuf2, packet2, 16, sizeof(packet2));
+    compare(noise_symmetricstate_encrypt_and_hash(state1, &mbuf1),
+            NOISE_ERROR_NONE);
+    compare(noise_symmetricstate_encrypt_and_hash(state2, &mbuf2),
+            NOISE_ERROR_NONE);
+    compare_blocks(mbuf2.data, mbuf2.size, mbuf1.data, mbuf1.size);
+    compare(noise_symmetricstate_split(state1, &c1, 0, 0, 0), NOISE_ERROR_NONE);
+    compare(noise_symmetricstate_split(state2, &c2, 0, 0, 0), NOISE_ERROR_NONE);
+    verify(!memcmp(c1->key, c2->key, c1->key_len));
+    compare(noise_cipherstate_free(c1), NOISE_ERROR_NONE);
+    compare(noise_cipherstate_free(c2), NOISE_ERROR_NONE);
+
+    /* A split state can be exported, and it stays split when imported */
+    compare(noise_symmetricstate_free(state2), NOISE_ERROR_NONE);
+    compare(noise_symmetricstate_export
+                (state1, wrap_key, sizeof(wrap_key), &blob),
+            NOISE_ERROR_NONE);
+    compare(noise_symmetricstate_import
+                (&state2, wrap_key, sizeof(wrap_key), &blob),
+            NOISE_ERROR_NONE);
+    verify(state2->cipher == 0);
+    compare(noise_symmetricstate_split(state2, &c1, 0, 0, 0),
+            NOISE_ERROR_INVALID_STATE);
+
+    /* A SymmetricState blob is not a CipherState blob */
+    c1 = (NoiseCipherState *)8;
+    compare(noise_cipherstate_import(&c1, wrap_key, sizeof(wrap_key), &blob),
+            NOISE_ERROR_INVALID_FORMAT);
+    verify(c1 == NULL);
+
+    compare(noise_symmetricstate_free(state1), NOISE_ERROR_NONE);
+    compare(noise_symmetricstate_free(state2), NOISE_ERROR_NONE);
+}
+
+static void symmetricstate_check_export(void)
+{
+    check_export("Noise_XX_25519_ChaChaPoly_BLAKE2s");
+    check_export("Noise_IK_448_AESGCM_SHA512");
+    check_export("NoisePSK_NN_25519_AESGCM_BLAKE2b");
+}
+
 void test_symmetricstate(void)
 {
     symmetricstate_check_protocols();
     symmetricstate_check_errors();
+    symmetricstate_check_export();
 }
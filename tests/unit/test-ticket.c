@@ -0,0 +1,290 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test-helpers.h"
+
+/* Run a two-party handshake to the "split" stage */
+static void run_handshake
+    (NoiseHandshakeState *initiator, NoiseHandshakeState *responder)
+{
+    NoiseHandshakeState *send;
+    NoiseHandshakeState *recv;
+    uint8_t message[4096];
+    NoiseBuffer mbuf;
+    int action;
+
+    compare(noise_handshakestate_start(initiator), NOISE_ERROR_NONE);
+    compare(noise_handshakestate_start(responder), NOISE_ERROR_NONE);
+    for (;;) {
+        action = noise_handshakestate_get_action(initiator);
+        if (action == NOISE_ACTION_WRITE_MESSAGE) {
+            send = initiator;
+            recv = responder;
+        } else if (action == NOISE_ACTION_READ_MESSAGE) {
+            send = responder;
+            recv = initiator;
+        } else {
+            break;
+        }
+        noise_buffer_set_output(mbuf, message, sizeof(message));
+        compare(noise_handshakestate_write_message(send, &mbuf, 0),
+                NOISE_ERROR_NONE);
+        compare(noise_handshakestate_read_message(recv, &mbuf, 0),
+                NOISE_ERROR_NONE);
+    }
+    compare(noise_handshakestate_get_action(initiator), NOISE_ACTION_SPLIT);
+    compare(noise_handshakestate_get_action(responder), NOISE_ACTION_SPLIT);
+}
+
+/* Run a full XX handshake and issue a ticket for it */
+static void full_handshake
+    (NoiseTicketIssuer *issuer, uint8_t *secret, NoiseBuffer *ticket)
+{
+    NoiseHandshakeState *initiator;
+    NoiseHandshakeState *responder;
+    uint8_t responder_secret[NOISE_RESUMPTION_SECRET_LEN];
+
+    compare(noise_handshakestate_new_by_name
+                (&initiator, "Noise_XX_25519_ChaChaPoly_BLAKE2s",
+                 NOISE_ROLE_INITIATOR),
+            NOISE_ERROR_NONE);
+    compare(noise_handshakestate_new_by_name
+                (&responder, "Noise_XX_25519_ChaChaPoly_BLAKE2s",
+                 NOISE_ROLE_RESPONDER),
+            NOISE_ERROR_NONE);
+    compare(noise_dhstate_generate_keypair
+                (noise_handshakestate_get_local_keypair_dh(initiator)),
+            NOISE_ERROR_NONE);
+    compare(noise_dhstate_generate_keypair
+                (noise_handshakestate_get_local_keypair_dh(responder)),
+            NOISE_ERROR_NONE);
+
+    /* No secret or ticket until the handshake has finished */
+    compare(noise_handshakestate_get_resumption_secret
+                (initiator, secret, NOISE_RESUMPTION_SECRET_LEN),
+            NOISE_ERROR_INVALID_STATE);
+    compare(noise_ticketissuer_issue(issuer, responder, ticket),
+            NOISE_ERROR_INVALID_STATE);
+    run_handshake(initiator, responder);
+
+    /* Both parties derive the same secret */
+    compare(noise_handshakestate_get_resumption_secret
+                (initiator, secret, 16),
+            NOISE_ERROR_INVALID_LENGTH);
+    compare(noise_handshakestate_get_resumption_secret
+                (initiator, secret, NOISE_RESUMPTION_SECRET_LEN),
+            NOISE_ERROR_NONE);
+    compare(noise_handshakestate_get_resumption_secret
+                (responder, responder_secret, NOISE_RESUMPTION_SECRET_LEN),
+            NOISE_ERROR_NONE);
+    compare_blocks(secret, NOISE_RESUMPTION_SECRET_LEN,
+                   responder_secret, NOISE_RESUMPTION_SECRET_LEN);
+
+    /* Issue the ticket from the responder's side */
+    ticket->size = 0;
+    compare(noise_ticketissuer_issue(issuer, responder, ticket),
+            NOISE_ERROR_NONE);
+    verify(ticket->size > 0 && ticket->size <= NOISE_MAX_TICKET_LEN);
+
+    compare(noise_handshakestate_free(initiator), NOISE_ERROR_NONE);
+    compare(noise_handshakestate_free(responder), NOISE_ERROR_NONE);
+}
+
+/* Resume a session with a ticket.  Returns the result of redeeming
+   the ticket, after running the handshake if it was successful */
+static int resume_handshake
+    (NoiseTicketIssuer *issuer, const uint8_t *secret,
+     const NoiseBuffer *ticket)
+{
+    NoiseHandshakeState *initiator;
+    NoiseHandshakeState *responder;
+    NoiseCipherState *c1init;
+    NoiseCipherState *c2init;
+    NoiseCipherState *c1resp;
+    NoiseCipherState *c2resp;
+    uint8_t message[64];
+    NoiseBuffer mbuf;
+    int err;
+
+    compare(noise_handshakestate_new_by_name
+                (&initiator, "NoisePSK_NN_25519_ChaChaPoly_BLAKE2s",
+                 NOISE_ROLE_INITIATOR),
+            NOISE_ERROR_NONE);
+    compare(noise_handshakestate_new_by_name
+                (&responder, "NoisePSK_NN_25519_ChaChaPoly_BLAKE2s",
+                 NOISE_ROLE_RESPONDER),
+            NOISE_ERROR_NONE);
+    compare(noise_handshakestate_set_pre_shared_key
+                (initiator, secret, NOISE_RESUMPTION_SECRET_LEN),
+            NOISE_ERROR_NONE);
+    err = noise_ticketissuer_redeem(issuer, ticket, responder);
+    if (err == NOISE_ERROR_NONE) {
+        compare(noise_handshakestate_has_pre_shared_key(responder), 1);
+        run_handshake(initiator, responder);
+
+        /* Check that the transport keys match */
+        compare(noise_handshakestate_split(initiator, &c1init, &c2init),
+                NOISE_ERROR_NONE);
+        compare(noise_handshakestate_split(responder, &c2resp, &c1resp),
+                NOISE_ERROR_NONE);
+        memset(message, 0xAA, 16);
+        noise_buffer_set_inout(mbuf, message, 16, sizeof(message));
+        compare(noise_cipherstate_encrypt(c1init, &mbuf), NOISE_ERROR_NONE);
+        compare(noise_cipherstate_decrypt(c1resp, &mbuf), NOISE_ERROR_NONE);
+        compare(mbuf.size, 16);
+        noise_cipherstate_free(c1init);
+        noise_cipherstate_free(c2init);
+        noise_cipherstate_free(c1resp);
+        noise_cipherstate_free(c2resp);
+    } else {
+        compare(noise_handshakestate_has_pre_shared_key(responder), 0);
+    }
+    compare(noise_handshakestate_free(initiator), NOISE_ERROR_NONE);
+    compare(noise_handshakestate_free(responder), NOISE_ERROR_NONE);
+    return err;
+}
+
+/* Check issuing and redeeming tickets */
+static void ticket_check_resume(void)
+{
+    NoiseTicketIssuer *issuer;
+    NoiseHandshakeState *state;
+    uint8_t secret1[NOISE_RESUMPTION_SECRET_LEN];
+    uint8_t secret2[NOISE_RESUMPTION_SECRET_LEN];
+    uint8_t secret3[NOISE_RESUMPTION_SECRET_LEN];
+    uint8_t data1[NOISE_MAX_TICKET_LEN];
+    uint8_t data2[NOISE_MAX_TICKET_LEN];
+    uint8_t data3[NOISE_MAX_TICKET_LEN];
+    uint8_t data4[NOISE_MAX_TICKET_LEN];
+    NoiseBuffer ticket1;
+    NoiseBuffer ticket2;
+    NoiseBuffer ticket3;
+    NoiseBuffer ticket4;
+
+    compare(noise_ticketissuer_new(&issuer), NOISE_ERROR_NONE);
+    noise_buffer_set_output(ticket1, data1, sizeof(data1));
+    noise_buffer_set_output(ticket2, data2, sizeof(data2));
+    noise_buffer_set_output(ticket3, data3, sizeof(data3));
+    full_handshake(issuer, secret1, &ticket1);
+    full_handshake(issuer, secret2, &ticket2);
+
+    /* Resume the first session, and then try to replay the ticket */
+    compare(resume_handshake(issuer, secret1, &ticket1), NOISE_ERROR_NONE);
+    compare(resume_handshake(issuer, secret1, &ticket1),
+            NOISE_ERROR_INVALID_NONCE);
+
+    /* A tampered ticket is rejected and does not use up the real one */
+    memcpy(data4, data2, ticket2.size);
+    noise_buffer_set_input(ticket4, data4, ticket2.size);
+    data4[ticket4.size - 20] ^= 0x01;
+    compare(resume_handshake(issuer, secret2, &ticket4),
+            NOISE_ERROR_MAC_FAILURE);
+    data4[ticket4.size - 20] ^= 0x01;
+    data4[11] ^= 0x01;
+    compare(resume_handshake(issuer, secret2, &ticket4),
+            NOISE_ERROR_MAC_FAILURE);
+    data4[11] ^= 0x01;
+    data4[0] = 'X';
+    compare(resume_handshake(issuer, secret2, &ticket4),
+            NOISE_ERROR_INVALID_FORMAT);
+    data4[0] = 'N';
+    ticket4.size = ticket2.size - 1;
+    compare(resume_handshake(issuer, secret2, &ticket4),
+            NOISE_ERROR_INVALID_FORMAT);
+
+    /* Tickets survive one rotation but not two */
+    compare(noise_ticketissuer_rotate(issuer), NOISE_ERROR_NONE);
+    full_handshake(issuer, secret3, &ticket3);
+    compare(resume_handshake(issuer, secret2, &ticket2), NOISE_ERROR_NONE);
+    compare(resume_handshake(issuer, secret2, &ticket2),
+            NOISE_ERROR_INVALID_NONCE);
+    compare(noise_ticketissuer_rotate(issuer), NOISE_ERROR_NONE);
+    compare(noise_ticketissuer_rotate(issuer), NOISE_ERROR_NONE);
+    compare(resume_handshake(issuer, secret3, &ticket3),
+            NOISE_ERROR_TICKET_EXPIRED);
+
+    /* A ticket from one issuer cannot be redeemed by another */
+    full_handshake(issuer, secret3, &ticket3);
+    compare(noise_ticketissuer_free(issuer), NOISE_ERROR_NONE);
+    compare(noise_ticketissuer_new(&issuer), NOISE_ERROR_NONE);
+    verify(resume_handshake(issuer, secret3, &ticket3) != NOISE_ERROR_NONE);
+
+    /* The secret only suits a handshake that uses a pre-shared key */
+    full_handshake(issuer, secret3, &ticket3);
+    compare(noise_handshakestate_new_by_name
+                (&state, "Noise_NN_25519_ChaChaPoly_BLAKE2s",
+                 NOISE_ROLE_RESPONDER),
+            NOISE_ERROR_NONE);
+    compare(noise_ticketissuer_redeem(issuer, &ticket3, state),
+            NOISE_ERROR_NOT_APPLICABLE);
+    compare(noise_handshakestate_free(state), NOISE_ERROR_NONE);
+    compare(resume_handshake(issuer, secret3, &ticket3), NOISE_ERROR_NONE);
+
+    compare(noise_ticketissuer_free(issuer), NOISE_ERROR_NONE);
+}
+
+/* Check the handling of bad parameters */
+static void ticket_check_parameters(void)
+{
+    NoiseTicketIssuer *issuer;
+    NoiseHandshakeState *state;
+    uint8_t secret[NOISE_RESUMPTION_SECRET_LEN];
+    uint8_t data[NOISE_MAX_TICKET_LEN];
+    NoiseBuffer ticket;
+
+    compare(noise_ticketissuer_new(0), NOISE_ERROR_INVALID_PARAM);
+    compare(noise_ticketissuer_free(0), NOISE_ERROR_INVALID_PARAM);
+    compare(noise_ticketissuer_rotate(0), NOISE_ERROR_INVALID_PARAM);
+    compare(noise_handshakestate_get_resumption_secret
+                (0, secret, sizeof(secret)),
+            NOISE_ERROR_INVALID_PARAM);
+
+    compare(noise_ticketissuer_new(&issuer), NOISE_ERROR_NONE);
+    compare(noise_handshakestate_new_by_name
+                (&state, "NoisePSK_NN_25519_ChaChaPoly_BLAKE2s",
+                 NOISE_ROLE_RESPONDER),
+            NOISE_ERROR_NONE);
+    noise_buffer_set_output(ticket, data, sizeof(data));
+    compare(noise_ticketissuer_issue(0, state, &ticket),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_ticketissuer_issue(issuer, 0, &ticket),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_ticketissuer_issue(issuer, state, 0),
+            NOISE_ERROR_INVALID_PARAM);
+    noise_buffer_set_output(ticket, data, 16);
+    compare(noise_ticketissuer_issue(issuer, state, &ticket),
+            NOISE_ERROR_INVALID_LENGTH);
+    compare(noise_ticketissuer_redeem(0, &ticket, state),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_ticketissuer_redeem(issuer, 0, state),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_ticketissuer_redeem(issuer, &ticket, 0),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_handshakestate_free(state), NOISE_ERROR_NONE);
+    compare(noise_ticketissuer_free(issuer), NOISE_ERROR_NONE);
+}
+
+void test_ticket(void)
+{
+    ticket_check_parameters();
+    ticket_check_resume();
+}
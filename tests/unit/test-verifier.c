@@ -0,0 +1,466 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test-helpers.h"
+#include <noise/keys.h>
+#if defined(HAVE_LIBPTHREAD)
+#include <pthread.h>
+#endif
+
+/* Creates a certificate for a subject with an Ed25519 signing key */
+static Noise_Certificate *create_subject
+    (const char *id, const NoiseSignState *signing_key)
+{
+    static uint8_t const dh_key_data[32] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+    uint8_t key_data[32];
+    Noise_Certificate *cert = 0;
+    Noise_SubjectInfo *subject = 0;
+    Noise_PublicKeyInfo *key = 0;
+    compare(noise_signstate_get_public_key
+                (signing_key, key_data, sizeof(key_data)),
+            NOISE_ERROR_NONE);
+    compare(Noise_Certificate_new(&cert), NOISE_ERROR_NONE);
+    compare(Noise_Certificate_set_version(cert, 1), NOISE_ERROR_NONE);
+    compare(Noise_Certificate_get_new_subject(cert, &subject),
+            NOISE_ERROR_NONE);
+    compare(Noise_SubjectInfo_set_id(subject, id, strlen(id)),
+            NOISE_ERROR_NONE);
+    compare(Noise_SubjectInfo_add_keys(subject, &key), NOISE_ERROR_NONE);
+    compare(Noise_PublicKeyInfo_set_algorithm(key, "25519", 5),
+            NOISE_ERROR_NONE);
+    compare(Noise_PublicKeyInfo_set_key(key, dh_key_data, sizeof(dh_key_data)),
+            NOISE_ERROR_NONE);
+    compare(Noise_SubjectInfo_add_keys(subject, &key), NOISE_ERROR_NONE);
+    compare(Noise_PublicKeyInfo_set_algorithm(key, "Ed25519", 7),
+            NOISE_ERROR_NONE);
+    compare(Noise_PublicKeyInfo_set_key(key, key_data, sizeof(key_data)),
+            NOISE_ERROR_NONE);
+    return cert;
+}
+
+/* Fills in a PublicKeyInfo block from a SignState */
+static void set_public_key_info
+    (Noise_PublicKeyInfo *key, const NoiseSignState *signing_key)
+{
+    uint8_t key_data[32];
+    compare(noise_signstate_get_public_key
+                (signing_key, key_data, sizeof(key_data)),
+            NOISE_ERROR_NONE);
+    compare(Noise_PublicKeyInfo_set_algorithm(key, "Ed25519", 7),
+            NOISE_ERROR_NONE);
+    compare(Noise_PublicKeyInfo_set_key(key, key_data, sizeof(key_data)),
+            NOISE_ERROR_NONE);
+}
+
+/* Adds a signature to a certificate */
+static void sign_certificate
+    (Noise_Certificate *cert, const char *signer_id,
+     const NoiseSignState *signing_key, const char *hash_algorithm)
+{
+    Noise_Signature *sig = 0;
+    Noise_PublicKeyInfo *key = 0;
+    Noise_ExtraSignedInfo *extra = 0;
+    uint8_t nonce[16];
+    uint8_t hash[64];
+    uint8_t sig_data[64];
+    size_t hash_len;
+    compare(Noise_Signature_new(&sig), NOISE_ERROR_NONE);
+    compare(Noise_Signature_set_id(sig, signer_id, strlen(signer_id)),
+            NOISE_ERROR_NONE);
+    compare(Noise_Signature_get_new_signing_key(sig, &key), NOISE_ERROR_NONE);
+    set_public_key_info(key, signing_key);
+    compare(Noise_Signature_set_hash_algorithm
+                (sig, hash_algorithm, strlen(hash_algorithm)),
+            NOISE_ERROR_NONE);
+    compare(Noise_Signature_get_new_extra_signed_info(sig, &extra),
+            NOISE_ERROR_NONE);
+    memset(nonce, 0xA5, sizeof(nonce));
+    compare(Noise_ExtraSignedInfo_set_nonce(extra, nonce, sizeof(nonce)),
+            NOISE_ERROR_NONE);
+    compare(Noise_ExtraSignedInfo_set_valid_from
+                (extra, "2016-01-01T00:00:00Z", 20),
+            NOISE_ERROR_NONE);
+    compare(noise_certificate_compute_signed_hash
+                (cert, sig, hash, sizeof(hash), &hash_len),
+            NOISE_ERROR_NONE);
+    compare(noise_signstate_sign(signing_key, hash, hash_len,
+                                 sig_data, sizeof(sig_data)),
+            NOISE_ERROR_NONE);
+    compare(Noise_Signature_set_signature(sig, sig_data, sizeof(sig_data)),
+            NOISE_ERROR_NONE);
+    compare(Noise_Certificate_insert_signatures
+                (cert, Noise_Certificate_count_signatures(cert), sig),
+            NOISE_ERROR_NONE);
+}
+
+/* Creates a new Ed25519 signing key from a fixed seed.  Ed25519 signatures
+   are deterministic, so the same seeds always produce the same cache tags */
+static NoiseSignState *create_signing_key(uint8_t seed)
+{
+    NoiseSignState *state = 0;
+    uint8_t private_key[32];
+    memset(private_key, seed, sizeof(private_key));
+    compare(noise_signstate_new_by_id(&state, NOISE_SIGN_ED25519),
+            NOISE_ERROR_NONE);
+    compare(noise_signstate_set_keypair_private
+                (state, private_key, sizeof(private_key)),
+            NOISE_ERROR_NONE);
+    return state;
+}
+
+/* Creates a chain from a list of certificates, which the chain takes
+   ownership of */
+static Noise_CertificateChain *create_chain
+    (Noise_Certificate **certs, size_t count)
+{
+    Noise_CertificateChain *chain = 0;
+    size_t index;
+    compare(Noise_CertificateChain_new(&chain), NOISE_ERROR_NONE);
+    for (index = 0; index < count; ++index) {
+        compare(Noise_CertificateChain_insert_certs(chain, index, certs[index]),
+                NOISE_ERROR_NONE);
+    }
+    return chain;
+}
+
+/* Checks the cache statistics for a verifier */
+#define check_stats(verifier, expected_hits, expected_misses) \
+    do { \
+        size_t _hits = 99; \
+        size_t _misses = 99; \
+        compare(noise_cert_verifier_get_cache_stats \
+                    ((verifier), &_hits, &_misses), NOISE_ERROR_NONE); \
+        compare(_hits, (expected_hits)); \
+        compare(_misses, (expected_misses)); \
+    } while (0)
+
+/* Check the computation of the signed hash for a certificate */
+static void verifier_check_signed_hash(void)
+{
+    NoiseSignState *key = create_signing_key(0x11);
+    Noise_Certificate *cert = create_subject("jane@example.com", key);
+    Noise_Signature *sig = 0;
+    Noise_ExtraSignedInfo *extra = 0;
+    uint8_t hash1[64];
+    uint8_t hash2[64];
+    size_t hash_len = 99;
+
+    /* The hash of the bare subject is the same as hashing its encoding */
+    compare(Noise_Signature_new(&sig), NOISE_ERROR_NONE);
+    compare(Noise_Signature_set_hash_algorithm(sig, "SHA256", 6),
+            NOISE_ERROR_NONE);
+    compare(noise_certificate_compute_signed_hash
+                (cert, sig, hash1, sizeof(hash1), &hash_len),
+            NOISE_ERROR_NONE);
+    compare(hash_len, 32);
+    {
+        NoiseProtobuf pbuf;
+        NoiseHashState *hash = 0;
+        uint8_t buffer[256];
+        uint8_t *data = 0;
+        size_t size = 0;
+        const Noise_SubjectInfo *subject = Noise_Certificate_get_subject(cert);
+        compare(noise_protobuf_prepare_output(&pbuf, buffer, sizeof(buffer)),
+                NOISE_ERROR_NONE);
+        compare(Noise_SubjectInfo_write(&pbuf, 0, subject), NOISE_ERROR_NONE);
+        compare(noise_protobuf_finish_output(&pbuf, &data, &size),
+                NOISE_ERROR_NONE);
+        compare(noise_hashstate_new_by_name(&hash, "SHA256"),
+                NOISE_ERROR_NONE);
+        compare(noise_hashstate_hash_one(hash, data, size, hash2, 32),
+                NOISE_ERROR_NONE);
+        compare_blocks(hash1, 32, hash2, 32);
+        noise_hashstate_free(hash);
+    }
+
+    /* Other signatures on the certificate do not affect the hash */
+    sign_certificate(cert, "ca@example.com", key, "BLAKE2s");
+    compare(noise_certificate_compute_signed_hash
+                (cert, sig, hash2, sizeof(hash2), &hash_len),
+            NOISE_ERROR_NONE);
+    compare_blocks(hash1, 32, hash2, hash_len);
+
+    /* The extra signed information does affect the hash */
+    compare(Noise_Signature_get_new_extra_signed_info(sig, &extra),
+            NOISE_ERROR_NONE);
+    compare(Noise_ExtraSignedInfo_set_valid_to
+                (extra, "2017-01-01T00:00:00Z", 20),
+            NOISE_ERROR_NONE);
+    compare(noise_certificate_compute_signed_hash
+                (cert, sig, hash2, sizeof(hash2), &hash_len),
+            NOISE_ERROR_NONE);
+    compare(hash_len, 32);
+    verify(memcmp(hash1, hash2, 32) != 0);
+
+    /* Error cases */
+    compare(noise_certificate_compute_signed_hash
+                (cert, sig, hash2, 31, &hash_len),
+            NOISE_ERROR_INVALID_LENGTH);
+    compare(hash_len, 0);
+    compare(noise_certificate_compute_signed_hash
+                (0, sig, hash2, sizeof(hash2), &hash_len),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_certificate_compute_signed_hash
+                (cert, 0, hash2, sizeof(hash2), &hash_len),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_certificate_compute_signed_hash
+                (cert, sig, 0, sizeof(hash2), &hash_len),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_certificate_compute_signed_hash
+                (cert, sig, hash2, sizeof(hash2), 0),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(Noise_Signature_set_hash_algorithm(sig, "MD5", 3),
+            NOISE_ERROR_NONE);
+    compare(noise_certificate_compute_signed_hash
+                (cert, sig, hash2, sizeof(hash2), &hash_len),
+            NOISE_ERROR_UNKNOWN_NAME);
+    compare(Noise_Signature_clear_hash_algorithm(sig), NOISE_ERROR_NONE);
+    compare(noise_certificate_compute_signed_hash
+                (cert, sig, hash2, sizeof(hash2), &hash_len),
+            NOISE_ERROR_INVALID_FORMAT);
+
+    /* Clean up */
+    Noise_Signature_free(sig);
+    Noise_Certificate_free(cert);
+    noise_signstate_free(key);
+}
+
+/* Check the verification of certificates and chains */
+static void check_verify_chain(size_t cache_size)
+{
+    NoiseCertVerifier *verifier = 0;
+    NoiseSignState *root_key = create_signing_key(0x21);
+    NoiseSignState *ca_key = create_signing_key(0x22);
+    NoiseSignState *leaf_key = create_signing_key(0x23);
+    NoiseSignState *other_key = create_signing_key(0x24);
+    Noise_Certificate *root = create_subject("root@example.com", root_key);
+    Noise_Certificate *ca = create_subject("ca@example.com", ca_key);
+    Noise_Certificate *leaf = create_subject("jane@example.com", leaf_key);
+    Noise_Certificate *other = create_subject("bob@example.com", other_key);
+    Noise_Certificate *certs[3];
+    Noise_CertificateChain *chain;
+    Noise_CertificateChain *chain2;
+    Noise_SubjectInfo *subject;
+    size_t c = cache_size ? 1 : 0;
+
+    /* The root signs the CA, which signs the leaf */
+    sign_certificate(ca, "root@example.com", root_key, "BLAKE2b");
+    sign_certificate(leaf, "bob@example.com", other_key, "SHA512");
+    sign_certificate(leaf, "ca@example.com", ca_key, "SHA256");
+    compare(noise_cert_verifier_new(&verifier, cache_size), NOISE_ERROR_NONE);
+    compare(noise_cert_verifier_add_trusted_certificate(verifier, root),
+            NOISE_ERROR_NONE);
+    compare(noise_cert_verifier_add_trusted_certificate(verifier, root),
+            NOISE_ERROR_NONE);
+    certs[0] = leaf;
+    certs[1] = other;
+    certs[2] = ca;
+    chain = create_chain(certs, 3);
+
+    /* Verify the chain twice to check that the cache is used.  The
+       unrelated certificate's signature on the leaf is also checked */
+    check_stats(verifier, 0, 0);
+    compare(noise_cert_verifier_verify_chain(verifier, chain),
+            NOISE_ERROR_NONE);
+    check_stats(verifier, 0, 3);
+    compare(noise_cert_verifier_verify_chain(verifier, chain),
+            NOISE_ERROR_NONE);
+    check_stats(verifier, 3 * c, 3 + 3 * (1 - c));
+
+    /* The root cannot vouch for the leaf directly, but it can for the CA.
+       The signature on the CA is then found in the cache */
+    compare(noise_cert_verifier_verify_certificate(verifier, leaf),
+            NOISE_ERROR_INVALID_SIGNATURE);
+    compare(noise_cert_verifier_verify_certificate(verifier, ca),
+            NOISE_ERROR_NONE);
+    check_stats(verifier, 4 * c, 3 + 4 * (1 - c));
+
+    /* Clearing the cache forces all signatures to be checked again */
+    compare(noise_cert_verifier_clear_cache(verifier), NOISE_ERROR_NONE);
+    check_stats(verifier, 0, 0);
+    compare(noise_cert_verifier_verify_chain(verifier, chain),
+            NOISE_ERROR_NONE);
+    check_stats(verifier, 0, 3);
+
+    /* Changing the subject of the leaf invalidates its signatures, which
+       must not be cached, but the signature on the CA is still valid */
+    subject = Noise_Certificate_get_subject(leaf);
+    compare(Noise_SubjectInfo_set_name(subject, "Jane Smith", 10),
+            NOISE_ERROR_NONE);
+    compare(noise_cert_verifier_verify_chain(verifier, chain),
+            NOISE_ERROR_INVALID_SIGNATURE);
+    check_stats(verifier, c, 3 + 2 + (1 - c));
+    compare(noise_cert_verifier_verify_chain(verifier, chain),
+            NOISE_ERROR_INVALID_SIGNATURE);
+    check_stats(verifier, 2 * c, 3 + 4 + 2 * (1 - c));
+    compare(Noise_SubjectInfo_clear_name(subject), NOISE_ERROR_NONE);
+    compare(noise_cert_verifier_verify_chain(verifier, chain),
+            NOISE_ERROR_NONE);
+
+    /* A chain without the CA has no path back to the root */
+    compare(Noise_CertificateChain_new(&chain2), NOISE_ERROR_NONE);
+    compare(noise_cert_verifier_verify_chain(verifier, chain2),
+            NOISE_ERROR_INVALID_PARAM);
+    Noise_CertificateChain_free(chain2);
+    compare(Noise_Certificate_new(&certs[0]), NOISE_ERROR_NONE);
+    chain2 = create_chain(certs, 1);
+    compare(noise_cert_verifier_verify_chain(verifier, chain2),
+            NOISE_ERROR_INVALID_SIGNATURE);
+    Noise_CertificateChain_free(chain2);
+
+    /* Trusting the CA's key directly makes the leaf verifiable alone */
+    compare(noise_cert_verifier_add_trust_anchor
+                (verifier, Noise_SubjectInfo_get_at_keys
+                    (Noise_Certificate_get_subject(ca), 1)),
+            NOISE_ERROR_NONE);
+    compare(noise_cert_verifier_verify_certificate(verifier, leaf),
+            NOISE_ERROR_NONE);
+
+    /* Error cases */
+    compare(noise_cert_verifier_new(0, cache_size), NOISE_ERROR_INVALID_PARAM);
+    compare(noise_cert_verifier_free(0), NOISE_ERROR_INVALID_PARAM);
+    compare(noise_cert_verifier_verify_chain(0, chain),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_cert_verifier_verify_chain(verifier, 0),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_cert_verifier_verify_certificate(0, leaf),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_cert_verifier_verify_certificate(verifier, 0),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_cert_verifier_add_trust_anchor(verifier, 0),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_cert_verifier_add_trust_anchor
+                (verifier, Noise_SubjectInfo_get_at_keys
+                    (Noise_Certificate_get_subject(ca), 0)),
+            NOISE_ERROR_UNKNOWN_NAME);
+    compare(noise_cert_verifier_add_trusted_certificate(verifier, 0),
+            NOISE_ERROR_INVALID_PARAM);
+    compare(noise_cert_verifier_clear_cache(0), NOISE_ERROR_INVALID_PARAM);
+    compare(noise_cert_verifier_get_cache_stats(verifier, 0, 0),
+            NOISE_ERROR_INVALID_PARAM);
+
+    /* Clean up */
+    compare(noise_cert_verifier_free(verifier), NOISE_ERROR_NONE);
+    Noise_CertificateChain_free(chain);
+    Noise_Certificate_free(root);
+    noise_signstate_free(root_key);
+    noise_signstate_free(ca_key);
+    noise_signstate_free(leaf_key);
+    noise_signstate_free(other_key);
+}
+
+#if defined(HAVE_LIBPTHREAD)
+
+#define VERIFIER_THREADS 4
+
+/* State that is shared between the verification threads */
+typedef struct
+{
+    NoiseCertVerifier *verifier;
+    const Noise_CertificateChain *chain;
+    int failed;
+
+} VerifierThreadState;
+
+/* Flag that releases all of the threads at once */
+static volatile int verifier_threads_go;
+
+/* Verifies the shared chain several times */
+static void *verifier_thread(void *arg)
+{
+    VerifierThreadState *state = (VerifierThreadState *)arg;
+    int round;
+    while (!__atomic_load_n(&verifier_threads_go, __ATOMIC_ACQUIRE))
+        ;   /* Spin until all threads have been created */
+    for (round = 0; round < 8; ++round) {
+        if (noise_cert_verifier_verify_chain(state->verifier, state->chain)
+                != NOISE_ERROR_NONE)
+            state->failed = 1;
+    }
+    return 0;
+}
+
+/* Verifies the same chain from several threads at once.  The cache is
+   disabled so that every thread serializes the signed information in
+   the shared certificates */
+static void verifier_check_threads(void)
+{
+    NoiseCertVerifier *verifier = 0;
+    NoiseSignState *root_key = create_signing_key(0x31);
+    NoiseSignState *leaf_key = create_signing_key(0x32);
+    Noise_Certificate *root = create_subject("root@example.com", root_key);
+    Noise_Certificate *leaf = create_subject("jane@example.com", leaf_key);
+    Noise_CertificateChain *chain;
+    VerifierThreadState state[VERIFIER_THREADS];
+    pthread_t threads[VERIFIER_THREADS];
+    int index;
+
+    sign_certificate(leaf, "root@example.com", root_key, "SHA256");
+    compare(noise_cert_verifier_new(&verifier, 0), NOISE_ERROR_NONE);
+    compare(noise_cert_verifier_add_trusted_certificate(verifier, root),
+            NOISE_ERROR_NONE);
+    chain = create_chain(&leaf, 1);
+
+    verifier_threads_go = 0;
+    for (index = 0; index < VERIFIER_THREADS; ++index) {
+        state[index].verifier = verifier;
+        state[index].chain = chain;
+        state[index].failed = 0;
+        compare(pthread_create(&(threads[index]), 0, verifier_thread,
+                               &(state[index])), 0);
+    }
+    __atomic_store_n(&verifier_threads_go, 1, __ATOMIC_RELEASE);
+    for (index = 0; index < VERIFIER_THREADS; ++index) {
+        compare(pthread_join(threads[index], 0), 0);
+        compare(state[index].failed, 0);
+    }
+
+    compare(noise_cert_verifier_free(verifier), NOISE_ERROR_NONE);
+    Noise_CertificateChain_free(chain);
+    Noise_Certificate_free(root);
+    noise_signstate_free(root_key);
+    noise_signstate_free(leaf_key);
+}
+
+#else
+
+static void verifier_check_threads(void)
+{
+}
+
+#endif
+
+/* Check certificate chain verification with and without the cache.
+   The keys and nonces are fixed, so the cache tags are the same on every
+   run and the hit counts do not depend on chance */
+static void verifier_check_chains(void)
+{
+    check_verify_chain(64);
+    check_verify_chain(0);
+}
+
+void test_verifier(void)
+{
+    verifier_check_signed_hash();
+    verifier_check_chains();
+    verifier_check_threads();
+}
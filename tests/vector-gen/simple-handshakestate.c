@@ -37,6 +37,8 @@ void HandshakeState_free(HandshakeState *handshake)
     SymmetricState_free(&(handshake->symmetric));
     noise_dhstate_free(handshake->dh_private);
     noise_dhstate_free(handshake->dh_public);
+    noise_dhstate_free(handshake->dh_hybrid_private);
+    noise_dhstate_free(handshake->dh_hybrid_public);
 }
 
 void Initialize(HandshakeState *handshake, const char *protocol_name,
@@ -168,6 +170,78 @@ void Initialize(HandshakeState *handshake, const char *protocol_name,
     }
 }
 
+void InitializeHybrid(HandshakeState *handshake, int hybrid_id,
+                      const uint8_t *eh, size_t eh_len)
+{
+    int err;
+    err = noise_dhstate_new_by_id(&(handshake->dh_hybrid_private), hybrid_id);
+    if (err != NOISE_ERROR_NONE) {
+        noise_perror("Initialize Hybrid Private", err);
+        exit(1);
+    }
+    err = noise_dhstate_new_by_id(&(handshake->dh_hybrid_public), hybrid_id);
+    if (err != NOISE_ERROR_NONE) {
+        noise_perror("Initialize Hybrid Public", err);
+        exit(1);
+    }
+    noise_dhstate_set_role(handshake->dh_hybrid_private,
+                           noise_dhstate_get_role(handshake->dh_private));
+    noise_dhstate_set_role(handshake->dh_hybrid_public,
+                           noise_dhstate_get_role(handshake->dh_public));
+    if (eh_len > noise_dhstate_get_private_key_length(handshake->dh_hybrid_private)) {
+        fprintf(stderr, "Out of range key sizes\n");
+        exit(1);
+    }
+    memcpy(handshake->eh, eh, eh_len);
+    handshake->eh_len = eh_len;
+    noise_dhstate_set_keypair_private
+        (handshake->dh_hybrid_private, handshake->eh, handshake->eh_len);
+    handshake->eh_public_len =
+        noise_dhstate_get_public_key_length(handshake->dh_hybrid_private);
+    noise_dhstate_get_public_key
+        (handshake->dh_hybrid_private, handshake->eh_public,
+         handshake->eh_public_len);
+}
+
+static size_t WriteEphemeral
+    (NoiseDHState *dh_private, NoiseDHState *dh_public,
+     const uint8_t *e, size_t e_len,
+     const uint8_t *e_public, size_t e_public_len,
+     const uint8_t *re, size_t re_len, uint8_t *out)
+{
+    size_t len;
+    if ((noise_dhstate_get_dh_id(dh_private) == NOISE_DH_NEWHOPE ||
+         noise_dhstate_get_dh_id(dh_private) == NOISE_DH_MLKEM768) &&
+            noise_dhstate_get_role(dh_private) == NOISE_ROLE_RESPONDER) {
+        /* New Hope and ML-KEM need special support for dependent
+           fixed keygen.  The public key for Bob isn't generated
+           until calculate() */
+        len = noise_dhstate_get_public_key_length(dh_private);
+        noise_dhstate_set_keypair_private(dh_private, e, e_len);
+        noise_dhstate_set_public_key(dh_public, re, re_len);
+        noise_dhstate_calculate(dh_private, dh_public, out, 32);
+        noise_dhstate_get_public_key(dh_private, out, len);
+    } else {
+        len = e_public_len;
+        memcpy(out, e_public, len);
+    }
+    return len;
+}
+
+static void MixDH(HandshakeState *handshake,
+                  NoiseDHState *dh_private, NoiseDHState *dh_public,
+                  const uint8_t *priv, size_t priv_len,
+                  const uint8_t *pub, size_t pub_len)
+{
+    uint8_t shared[MAX_DH_KEY_LEN];
+    size_t len;
+    noise_dhstate_set_keypair_private(dh_private, priv, priv_len);
+    noise_dhstate_set_public_key(dh_public, pub, pub_len);
+    len = noise_dhstate_get_shared_key_length(dh_private);
+    noise_dhstate_calculate(dh_private, dh_public, shared, len);
+    MixKey(&(handshake->symmetric), shared, len);
+}
+
 int WriteMessage(HandshakeState *handshake, const Buffer payload, Buffer *message)
 {
     size_t index = 0;
@@ -181,26 +255,25 @@ int WriteMessage(HandshakeState *handshake, const Buffer payload, Buffer *messag
                 *(handshake->pattern) != NOISE_TOKEN_FLIP_DIR) {
         switch (*(handshake->pattern)++) {
         case NOISE_TOKEN_E:
-            if (noise_dhstate_get_dh_id(handshake->dh_private)
-                        == NOISE_DH_NEWHOPE &&
-                    noise_dhstate_get_role(handshake->dh_private)
-                        == NOISE_ROLE_RESPONDER) {
-                /* New Hope needs special support for dependent fixed keygen.
-                   The public key for Bob isn't generated until calculate() */
-                len = noise_dhstate_get_public_key_length(handshake->dh_private);
-                noise_dhstate_set_keypair_private
-                    (handshake->dh_private, handshake->e, handshake->e_len);
-                noise_dhstate_set_public_key
-                    (handshake->dh_public, handshake->re, handshake->re_len);
-                noise_dhstate_calculate
-                    (handshake->dh_private, handshake->dh_public,
-                     message->data + index, 32);
-                noise_dhstate_get_public_key
-                    (handshake->dh_private, message->data + index, len);
-            } else {
-                len = handshake->e_public_len;
-                memcpy(message->data + index, handshake->e_public, len);
+            len = WriteEphemeral
+                (handshake->dh_private, handshake->dh_public,
+                 handshake->e, handshake->e_len,
+                 handshake->e_public, handshake->e_public_len,
+                 handshake->re, handshake->re_len, message->data + index);
+            MixHash(&(handshake->symmetric), message->data + index, len);
+            if (handshake->psk_len) {
+                MixKey(&(handshake->symmetric), message->data + index, len);
             }
+            index += len;
+            if (!handshake->dh_hybrid_private)
+                break;
+
+            /* The hybrid ephemeral key follows the classical one */
+            len = WriteEphemeral
+                (handshake->dh_hybrid_private, handshake->dh_hybrid_public,
+                 handshake->eh, handshake->eh_len,
+                 handshake->eh_public, handshake->eh_public_len,
+                 handshake->reh, handshake->reh_len, message->data + index);
             MixHash(&(handshake->symmetric), message->data + index, len);
             if (handshake->psk_len) {
                 MixKey(&(handshake->symmetric), message->data + index, len);
@@ -225,6 +298,12 @@ int WriteMessage(HandshakeState *handshake, const Buffer payload, Buffer *messag
             noise_dhstate_calculate
                 (handshake->dh_private, handshake->dh_public, data.data, len);
             MixKey(&(handshake->symmetric), data.data, len);
+            if (handshake->dh_hybrid_private) {
+                MixDH(handshake, handshake->dh_hybrid_private,
+                      handshake->dh_hybrid_public,
+                      handshake->eh, handshake->eh_len,
+                      handshake->reh, handshake->reh_len);
+            }
             break;
 
         case NOISE_TOKEN_DHES:
@@ -297,6 +376,18 @@ int ReadMessage(HandshakeState *handshake, const Buffer message, Buffer *payload
                 MixKey(&(handshake->symmetric), handshake->re,
                        handshake->re_len);
             }
+            if (!handshake->dh_hybrid_public)
+                break;
+            handshake->reh_len = noise_dhstate_get_public_key_length
+                (handshake->dh_hybrid_public);
+            memcpy(handshake->reh, message.data + index, handshake->reh_len);
+            index += handshake->reh_len;
+            MixHash(&(handshake->symmetric), handshake->reh,
+                    handshake->reh_len);
+            if (handshake->psk_len) {
+                MixKey(&(handshake->symmetric), handshake->reh,
+                       handshake->reh_len);
+            }
             break;
 
         case NOISE_TOKEN_S:
@@ -323,6 +414,12 @@ int ReadMessage(HandshakeState *handshake, const Buffer message, Buffer *payload
             noise_dhstate_calculate
                 (handshake->dh_private, handshake->dh_public, data.data, len);
             MixKey(&(handshake->symmetric), data.data, len);
+            if (handshake->dh_hybrid_private) {
+                MixDH(handshake, handshake->dh_hybrid_private,
+                      handshake->dh_hybrid_public,
+                      handshake->eh, handshake->eh_len,
+                      handshake->reh, handshake->reh_len);
+            }
             break;
 
         case NOISE_TOKEN_DHES:
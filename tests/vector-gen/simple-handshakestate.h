@@ -51,6 +51,14 @@ typedef struct
     size_t rs_len;
     uint8_t re[MAX_DH_KEY_LEN];
     size_t re_len;
+    NoiseDHState *dh_hybrid_private;
+    NoiseDHState *dh_hybrid_public;
+    uint8_t eh[MAX_DH_KEY_LEN];
+    size_t eh_len;
+    uint8_t eh_public[MAX_DH_KEY_LEN];
+    size_t eh_public_len;
+    uint8_t reh[MAX_DH_KEY_LEN];
+    size_t reh_len;
     uint8_t psk[MAX_PSK_LEN];
     size_t psk_len;
     int action;
@@ -67,6 +75,8 @@ void Initialize(HandshakeState *handshake, const char *protocol_name,
                 const uint8_t *rs, size_t rs_len,
                 const uint8_t *re, size_t re_len,
                 const uint8_t *psk, size_t psk_len);
+void InitializeHybrid(HandshakeState *handshake, int hybrid_id,
+                      const uint8_t *eh, size_t eh_len);
 int WriteMessage(HandshakeState *handshake, const Buffer payload, Buffer *message);
 int ReadMessage(HandshakeState *handshake, const Buffer message, Buffer *payload);
 
@@ -631,11 +631,17 @@ static void print_hex_no_comma(const char *field, const uint8_t *data, size_t le
     printf("\"\n");
 }
 
+/* New Hope and ML-KEM both use the "knewhope" fields for their seed data */
+static int is_kem(const NoiseProtocolId *id)
+{
+    return id->dh_id == NOISE_DH_NEWHOPE || id->dh_id == NOISE_DH_MLKEM768;
+}
+
 static void print_key(const char *field, const Key *key, const NoiseProtocolId *id)
 {
     if (id->dh_id == NOISE_DH_CURVE25519)
         print_hex(field, key->k25519_private, sizeof(key->k25519_private));
-    else if (id->dh_id == NOISE_DH_NEWHOPE)
+    else if (is_kem(id))
         print_hex(field, key->knewhope_private, key->knewhope_private_len);
     else
         print_hex(field, key->k448_private, sizeof(key->k448_private));
@@ -656,7 +662,7 @@ static void get_key(const uint8_t **k, size_t *klen, const Key *key, const Noise
     if (id->dh_id == NOISE_DH_CURVE25519) {
         *k = key->k25519_private;
         *klen = sizeof(key->k25519_private);
-    } else if (id->dh_id == NOISE_DH_NEWHOPE) {
+    } else if (is_kem(id)) {
         *k = key->knewhope_private;
         *klen = key->knewhope_private_len;
     } else {
@@ -801,6 +807,7 @@ static void initialize_protocol_fallback
 static void generate_vector(const NoiseProtocolId *id, int first, int with_ssk, int with_fallback)
 {
     NoiseProtocolId id2;
+    NoiseProtocolId hybrid;
     char protocol_name[NOISE_MAX_PROTOCOL_NAME];
     char alt_protocol_name[NOISE_MAX_PROTOCOL_NAME];
     const uint8_t *pattern = noise_pattern_lookup(id->pattern_id);
@@ -841,6 +848,8 @@ static void generate_vector(const NoiseProtocolId *id, int first, int with_ssk,
     }
     printf("\"pattern\": \"%s\",\n", noise_id_to_name(0, id->pattern_id));
     printf("\"dh\": \"%s\",\n", noise_id_to_name(0, id->dh_id));
+    if (id->hybrid_id)
+        printf("\"hybrid\": \"%s\",\n", noise_id_to_name(0, id->hybrid_id));
     printf("\"cipher\": \"%s\",\n", noise_id_to_name(0, id->cipher_id));
     printf("\"hash\": \"%s\",\n", noise_id_to_name(0, id->hash_id));
     if (with_fallback) {
@@ -859,8 +868,14 @@ static void generate_vector(const NoiseProtocolId *id, int first, int with_ssk,
         print_hex("init_ssk", ssk, sizeof(ssk));
     if (flags & NOISE_PAT_FLAG_LOCAL_STATIC)
         print_key("init_static", &init_static, id);
+    /* Keys for the hybrid algorithm are looked up as though it was
+       the regular DH algorithm */
+    hybrid = *id;
+    hybrid.dh_id = id->hybrid_id;
     if (flags & NOISE_PAT_FLAG_LOCAL_EPHEMERAL)
         print_key("init_ephemeral", &init_ephemeral, id);
+    if (id->hybrid_id)
+        print_key("init_hybrid_ephemeral", &init_ephemeral, &hybrid);
     if (flags & NOISE_PAT_FLAG_REMOTE_REQUIRED) {
         /* If we are going to fall back, then give the initiator the
            wrong static key for the responder */
@@ -878,11 +893,21 @@ static void generate_vector(const NoiseProtocolId *id, int first, int with_ssk,
         print_key("resp_static", &resp_static, id);
     if (flags & NOISE_PAT_FLAG_REMOTE_EPHEMERAL)
         print_key("resp_ephemeral", &resp_ephemeral, id);
+    if (id->hybrid_id)
+        print_key("resp_hybrid_ephemeral", &resp_ephemeral, &hybrid);
     if (flags & NOISE_PAT_FLAG_LOCAL_REQUIRED)
         print_public_key("resp_remote_static", &init_static, id);
 
     /* Initialize both ends of the communication */
     initialize_protocol(&init, &resp, flags, protocol_name, id, with_fallback);
+    if (id->hybrid_id) {
+        const uint8_t *eh;
+        size_t eh_len;
+        get_key(&eh, &eh_len, &init_ephemeral, &hybrid);
+        InitializeHybrid(&init, id->hybrid_id, eh, eh_len);
+        get_key(&eh, &eh_len, &resp_ephemeral, &hybrid);
+        InitializeHybrid(&resp, id->hybrid_id, eh, eh_len);
+    }
 
     /* Run the handshake */
     printf("\"messages\": [\n");
@@ -1030,8 +1055,8 @@ static void fallback_patterns(int with_ssk)
     }
 }
 
-/* Output all of the New Hope patterns */
-static void newhope_patterns(int with_ssk)
+/* Output all of the patterns for a post-quantum KEM like New Hope */
+static void kem_patterns(int dh_id, int with_ssk)
 {
     NoiseProtocolId id;
     int first = 1;
@@ -1040,7 +1065,7 @@ static void newhope_patterns(int with_ssk)
         for (id.prefix_id = NOISE_PREFIX_STANDARD; id.prefix_id <= NOISE_PREFIX_PSK; ++id.prefix_id) {
             for (id.cipher_id = NOISE_CIPHER_CHACHAPOLY; id.cipher_id <= NOISE_CIPHER_AESGCM; ++id.cipher_id) {
                 if (id.pattern_id == NOISE_PATTERN_NN) {
-                    id.dh_id = NOISE_DH_NEWHOPE;
+                    id.dh_id = dh_id;
                     for (id.hash_id = NOISE_HASH_BLAKE2s; id.hash_id <= NOISE_HASH_SHA512; ++id.hash_id) {
                         generate_vector(&id, first, 0, 0);
                         first = 0;
@@ -1063,11 +1088,33 @@ static void newhope_patterns(int with_ssk)
     }
 }
 
+/* Output the two-way patterns for a hybrid such as 25519+NewHope */
+static void hybrid_patterns(int dh_id, int hybrid_id, int with_ssk)
+{
+    NoiseProtocolId id;
+    int first = 1;
+    memset(&id, 0, sizeof(id));
+    id.dh_id = dh_id;
+    id.hybrid_id = hybrid_id;
+    id.cipher_id = NOISE_CIPHER_CHACHAPOLY;
+    id.hash_id = NOISE_HASH_BLAKE2s;
+    for (id.pattern_id = NOISE_PATTERN_NN; id.pattern_id <= NOISE_PATTERN_IX; ++id.pattern_id) {
+        for (id.prefix_id = NOISE_PREFIX_STANDARD; id.prefix_id <= NOISE_PREFIX_PSK; ++id.prefix_id) {
+            generate_vector(&id, first, 0, 0);
+            first = 0;
+            if (with_ssk)
+                generate_vector(&id, first, 1, 0);
+        }
+    }
+}
+
 int main(int argc, char *argv[])
 {
     int with_ssk = 0;
     int with_fallback = 0;
     int with_newhope = 0;
+    int with_mlkem = 0;
+    int with_hybrid = 0;
 
     while (argc > 1) {
         if (!strcmp(argv[1], "--with-ssk"))
@@ -1076,6 +1123,10 @@ int main(int argc, char *argv[])
             with_fallback = 1;
         if (!strcmp(argv[1], "--with-newhope"))
             with_newhope = 1;
+        if (!strcmp(argv[1], "--with-mlkem"))
+            with_mlkem = 1;
+        if (!strcmp(argv[1], "--with-hybrid"))
+            with_hybrid = 1;
         ++argv;
         --argc;
     }
@@ -1084,7 +1135,11 @@ int main(int argc, char *argv[])
     printf("\"vectors\": [\n");
 
     if (with_newhope) {
-        newhope_patterns(with_ssk);
+        kem_patterns(NOISE_DH_NEWHOPE, with_ssk);
+    } else if (with_mlkem) {
+        kem_patterns(NOISE_DH_MLKEM768, with_ssk);
+    } else if (with_hybrid) {
+        hybrid_patterns(NOISE_DH_CURVE25519, NOISE_DH_NEWHOPE, with_ssk);
     } else if (with_fallback) {
         fallback_patterns(with_ssk);
     } else {
@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "keytool.h"
+#include <time.h>
+
+#define short_options "H:i:c:p:"
+
+static struct option const long_options[] = {
+    {"hash",                    required_argument,      NULL,       'H'},
+    {"iterations",              required_argument,      NULL,       'i'},
+    {"count",                   required_argument,      NULL,       'c'},
+    {"passphrase",              required_argument,      NULL,       'p'},
+    {NULL,                      0,                      NULL,        0 }
+};
+
+/* Salt and key material sizes used by the private key loader */
+#define BENCH_SALT_LEN      16
+#define BENCH_KEY_LEN       40
+
+/* Maximum number of iteration counts that can be benchmarked */
+#define MAX_ITERATION_COUNTS 32
+
+static const char *hash_name = "BLAKE2b";
+static const char *iterations_list = "1000,5000,20000,100000";
+static size_t iteration_counts[MAX_ITERATION_COUNTS];
+static size_t num_iteration_counts = 0;
+static long repeat_count = 3;
+static char *passphrase = NULL;
+static int first_file_index = 0;
+
+/* Print usage/help information */
+void help_bench(const char *progname)
+{
+    fprintf(stdout, "Usage: %s bench [options] [file ...]\n\n", progname);
+    fprintf(stdout, "Measures how long it takes to unlock a private key for various\n");
+    fprintf(stdout, "PBKDF2 iteration counts.  If private key files are supplied,\n");
+    fprintf(stdout, "then the time to load and decrypt each file is also reported.\n\n");
+    fprintf(stdout, "Options:\n\n");
+    fprintf(stdout, "    --hash=NAME, -H NAME\n");
+    fprintf(stdout, "        Hash algorithm to use for PBKDF2 (default is BLAKE2b).\n\n");
+    fprintf(stdout, "    --iterations=LIST, -i LIST\n");
+    fprintf(stdout, "        Comma-separated list of iteration counts to measure\n");
+    fprintf(stdout, "        (default is 1000,5000,20000,100000).\n\n");
+    fprintf(stdout, "    --count=N, -c N\n");
+    fprintf(stdout, "        Number of times to repeat each measurement (default is 3).\n\n");
+    fprintf(stdout, "    --passphrase=PASSPHRASE, -p PASSPHRASE\n");
+    fprintf(stdout, "        Specifies the passphrase to unlock the private key files.\n");
+    fprintf(stdout, "        Prompt the user if not specified on the command-line.\n\n");
+}
+
+/* Parse the list of iteration counts */
+static int parse_iterations(const char *list)
+{
+    char *end;
+    unsigned long value;
+    num_iteration_counts = 0;
+    while (*list != '\0') {
+        value = strtoul(list, &end, 10);
+        if (end == list || value == 0 || (*end != ',' && *end != '\0')) {
+            fprintf(stderr, "Invalid iteration count list '%s'\n",
+                    iterations_list);
+            return 0;
+        }
+        if (num_iteration_counts >= MAX_ITERATION_COUNTS) {
+            fprintf(stderr, "Too many iteration counts\n");
+            return 0;
+        }
+        iteration_counts[num_iteration_counts++] = (size_t)value;
+        list = (*end == ',') ? end + 1 : end;
+    }
+    if (!num_iteration_counts) {
+        fprintf(stderr, "No iteration counts specified\n");
+        return 0;
+    }
+    return 1;
+}
+
+/* Parse the command-line options */
+static int parse_options_bench(const char *progname, int argc, char *argv[])
+{
+    int index = 0;
+    int ch;
+    while ((ch = getopt_long(argc, argv, short_options, long_options, &index)) != -1) {
+        switch (ch) {
+        case 'H':   hash_name = optarg; break;
+        case 'i':   iterations_list = optarg; break;
+        case 'c':
+            repeat_count = atol(optarg);
+            if (repeat_count <= 0) {
+                help_bench(progname);
+                return 0;
+            }
+            break;
+        case 'p':   passphrase = optarg; break;
+        default:
+            help_bench(progname);
+            return 0;
+        }
+    }
+    if (!parse_iterations(iterations_list))
+        return 0;
+    first_file_index = optind;
+    return 1;
+}
+
+/* Get the current time in seconds */
+static double current_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+/* Measures PBKDF2 for each of the requested iteration counts */
+static int bench_pbkdf2(void)
+{
+    static const char bench_passphrase[] = "correct horse battery staple";
+    NoiseHashState *hash;
+    uint8_t salt[BENCH_SALT_LEN];
+    uint8_t key[BENCH_KEY_LEN];
+    double start, elapsed, best;
+    size_t index;
+    long count;
+    int err;
+
+    /* Create the hash object */
+    err = noise_hashstate_new_by_name(&hash, hash_name);
+    if (err != NOISE_ERROR_NONE) {
+        noise_perror(hash_name, err);
+        return 0;
+    }
+    memset(salt, 0xA5, sizeof(salt));
+
+    /* Report the fastest of the repeated runs for each count so that
+       the figures are not skewed by scheduling noise */
+    printf("PBKDF2-%s, %d byte salt, %d byte output:\n",
+           hash_name, BENCH_SALT_LEN, BENCH_KEY_LEN);
+    printf("%12s %12s %14s\n", "iterations", "unlock (ms)", "us/iteration");
+    for (index = 0; index < num_iteration_counts; ++index) {
+        best = 0;
+        for (count = 0; count < repeat_count; ++count) {
+            start = current_time();
+            err = noise_hashstate_pbkdf2
+                (hash, (const uint8_t *)bench_passphrase,
+                 strlen(bench_passphrase), salt, sizeof(salt),
+                 iteration_counts[index], key, sizeof(key));
+            elapsed = current_time() - start;
+            if (err != NOISE_ERROR_NONE) {
+                noise_perror("PBKDF2", err);
+                noise_hashstate_free(hash);
+                return 0;
+            }
+            if (count == 0 || elapsed < best)
+                best = elapsed;
+        }
+        printf("%12lu %12.3f %14.4f\n",
+               (unsigned long)(iteration_counts[index]), best * 1000.0,
+               best * 1000000.0 / iteration_counts[index]);
+    }
+
+    /* Clean up and exit */
+    noise_clean(key, sizeof(key));
+    noise_hashstate_free(hash);
+    return 1;
+}
+
+/* Measures the time to load and unlock a private key file */
+static int bench_private_key(const char *filename, const char *pp)
+{
+    Noise_PrivateKey *priv_key;
+    double start, elapsed, best = 0;
+    long count;
+    int err;
+    for (count = 0; count < repeat_count; ++count) {
+        start = current_time();
+        err = noise_load_private_key_from_file
+            (&priv_key, filename, pp, strlen(pp));
+        elapsed = current_time() - start;
+        if (err == NOISE_ERROR_MAC_FAILURE) {
+            fprintf(stderr, "%s: Incorrect passphrase\n", filename);
+            return 0;
+        } else if (err != NOISE_ERROR_NONE) {
+            noise_perror(filename, err);
+            return 0;
+        }
+        Noise_PrivateKey_free(priv_key);
+        if (count == 0 || elapsed < best)
+            best = elapsed;
+    }
+    printf("%s: unlocked in %.3f ms\n", filename, best * 1000.0);
+    return 1;
+}
+
+int main_bench(const char *progname, int argc, char *argv[])
+{
+    const char *pp;
+    int retval = 0;
+
+    /* Parse the command-line options */
+    if (!parse_options_bench(progname, argc, argv))
+        return 1;
+
+    /* Measure the raw key derivation cost */
+    if (!bench_pbkdf2())
+        return 1;
+
+    /* Measure the cost of unlocking each of the supplied files */
+    if (first_file_index >= argc)
+        return 0;
+    if (passphrase) {
+        pp = passphrase;
+    } else {
+        pp = ask_for_passphrase(0);
+        if (!pp)
+            return 1;
+    }
+    printf("\n");
+    for (; first_file_index < argc; ++first_file_index) {
+        if (!bench_private_key(argv[first_file_index], pp))
+            retval = 1;
+    }
+    return retval;
+}
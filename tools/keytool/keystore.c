@@ -0,0 +1,357 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "keytool.h"
+#include <ctype.h>
+
+#define short_options "a:c:"
+
+static struct option const long_options[] = {
+    {"algorithm",               required_argument,      NULL,       'a'},
+    {"certificate",             required_argument,      NULL,       'c'},
+    {NULL,                      0,                      NULL,        0 }
+};
+
+#define MAX_CERTIFICATES    64
+#define MAX_LINE            4096
+#define KEYSTORE_PSK_LEN    32
+#define MAX_PUBLIC_KEY_LEN  1024
+
+static const char *algorithm = "25519";
+static const char *certificates[MAX_CERTIFICATES];
+static int num_certificates = 0;
+static const char *output_file = NULL;
+
+/* Print usage/help information */
+void help_keystore(const char *progname)
+{
+    fprintf(stdout, "Usage: %s keystore [options] output-file [input-file ...]\n\n", progname);
+    fprintf(stdout, "Builds a static key store for a responder from text files and\n");
+    fprintf(stdout, "certificates.  Each line of an input file has the form:\n\n");
+    fprintf(stdout, "    hex-public-key [hex-psk|-] [metadata ...]\n\n");
+    fprintf(stdout, "Pre-shared keys must be %d bytes in length.  Blank lines and lines\n", KEYSTORE_PSK_LEN);
+    fprintf(stdout, "starting with '#' are ignored.  An input file of \"-\" reads from\n");
+    fprintf(stdout, "standard input.\n\n");
+    fprintf(stdout, "Options:\n\n");
+    fprintf(stdout, "    --algorithm=ALG, -a ALG\n");
+    fprintf(stdout, "        Specifies the DH algorithm of the keys: 25519 or 448.\n");
+    fprintf(stdout, "        Default is 25519.\n\n");
+    fprintf(stdout, "    --certificate=FILE, -c FILE\n");
+    fprintf(stdout, "        Adds the keys for ALG from the subject of a certificate or\n");
+    fprintf(stdout, "        certificate chain, with the subject's id as the metadata.\n");
+    fprintf(stdout, "        May be specified multiple times.\n\n");
+}
+
+/* Print usage/help information for the "lookup" command */
+void help_lookup(const char *progname)
+{
+    fprintf(stdout, "Usage: %s lookup store-file hex-public-key\n\n", progname);
+    fprintf(stdout, "Looks up a public key in a key store that was created with\n");
+    fprintf(stdout, "the \"keystore\" command.\n\n");
+}
+
+/* Parse the command-line options */
+static int parse_options_keystore(const char *progname, int argc, char *argv[])
+{
+    int index = 0;
+    int ch;
+    while ((ch = getopt_long(argc, argv, short_options, long_options, &index)) != -1) {
+        switch (ch) {
+        case 'a':   algorithm = optarg; break;
+        case 'c':
+            if (num_certificates >= MAX_CERTIFICATES) {
+                fprintf(stderr, "Too many certificates\n");
+                return 0;
+            }
+            certificates[num_certificates++] = optarg;
+            break;
+        default:
+            help_keystore(progname);
+            return 0;
+        }
+    }
+    if (optind >= argc) {
+        help_keystore(progname);
+        return 0;
+    }
+    output_file = argv[optind++];
+    return 1;
+}
+
+/* Gets the public key length for a DH algorithm name, or 0 if unknown */
+static size_t key_length_for_algorithm(const char *name)
+{
+    if (!strcmp(name, "25519"))
+        return 32;
+    else if (!strcmp(name, "448"))
+        return 56;
+    return 0;
+}
+
+/* Adds the keys from the subject of a certificate to the key store */
+static int add_certificate
+    (NoiseKeyStoreBuilder *builder, size_t key_len, const char *filename)
+{
+    Noise_Certificate *cert = 0;
+    const Noise_SubjectInfo *subject;
+    const char *id = 0;
+    size_t id_len = 0;
+    size_t count, index;
+    int added = 0;
+    int err;
+
+    /* Load the certificate */
+    err = noise_load_certificate_from_file(&cert, filename);
+    if (err != NOISE_ERROR_NONE) {
+        noise_perror(filename, err);
+        return 0;
+    }
+
+    /* Add every key for the selected algorithm from the subject */
+    subject = Noise_Certificate_get_subject(cert);
+    if (subject) {
+        id = Noise_SubjectInfo_get_id(subject);
+        id_len = Noise_SubjectInfo_get_size_id(subject);
+        count = Noise_SubjectInfo_count_keys(subject);
+        for (index = 0; index < count; ++index) {
+            const Noise_PublicKeyInfo *key =
+                Noise_SubjectInfo_get_at_keys(subject, index);
+            const char *key_alg = Noise_PublicKeyInfo_get_algorithm(key);
+            if (!key_alg || strcmp(key_alg, algorithm) != 0)
+                continue;
+            if (Noise_PublicKeyInfo_get_size_key(key) != key_len) {
+                fprintf(stderr, "%s: public key has the wrong length\n",
+                        filename);
+                Noise_Certificate_free(cert);
+                return 0;
+            }
+            err = noise_keystore_builder_add
+                (builder, (const uint8_t *)Noise_PublicKeyInfo_get_key(key),
+                 key_len, NULL, 0, id, id_len);
+            if (err != NOISE_ERROR_NONE) {
+                noise_perror(filename, err);
+                Noise_Certificate_free(cert);
+                return 0;
+            }
+            ++added;
+        }
+    }
+    if (!added)
+        fprintf(stderr, "%s: no %s keys in certificate\n", filename, algorithm);
+
+    /* Clean up and exit */
+    Noise_Certificate_free(cert);
+    return 1;
+}
+
+/* Adds the keys from a text file to the key store */
+static int add_text_file
+    (NoiseKeyStoreBuilder *builder, size_t key_len, const char *filename)
+{
+    static char line[MAX_LINE];
+    uint8_t key[MAX_PUBLIC_KEY_LEN];
+    uint8_t psk[KEYSTORE_PSK_LEN];
+    FILE *file;
+    char *posn;
+    char *field;
+    size_t field_len;
+    long line_number = 0;
+    int has_psk;
+    int ok = 1;
+    int err;
+
+    /* Open the input file */
+    if (!strcmp(filename, "-")) {
+        file = stdin;
+    } else {
+        file = fopen(filename, "r");
+        if (!file) {
+            perror(filename);
+            return 0;
+        }
+    }
+
+    /* Process the lines in the file */
+    while (ok && fgets(line, sizeof(line), file)) {
+        ++line_number;
+        posn = line;
+        while (isspace((unsigned char)*posn))
+            ++posn;
+        if (*posn == '\0' || *posn == '#')
+            continue;
+
+        /* Parse the public key */
+        field = posn;
+        while (*posn != '\0' && !isspace((unsigned char)*posn))
+            ++posn;
+        field_len = (size_t)(posn - field);
+        if (parse_hex(field, field_len, key, sizeof(key)) != (int)key_len) {
+            fprintf(stderr, "%s:%ld: invalid public key\n",
+                    filename, line_number);
+            ok = 0;
+            break;
+        }
+
+        /* Parse the optional pre-shared key */
+        while (isspace((unsigned char)*posn))
+            ++posn;
+        field = posn;
+        while (*posn != '\0' && !isspace((unsigned char)*posn))
+            ++posn;
+        field_len = (size_t)(posn - field);
+        has_psk = 0;
+        if (field_len == 1 && *field == '-') {
+            /* Explicitly no pre-shared key */
+        } else if (field_len != 0) {
+            if (parse_hex(field, field_len, psk, sizeof(psk)) !=
+                    KEYSTORE_PSK_LEN) {
+                fprintf(stderr, "%s:%ld: invalid pre-shared key\n",
+                        filename, line_number);
+                ok = 0;
+                break;
+            }
+            has_psk = 1;
+        }
+
+        /* The rest of the line is the metadata */
+        while (isspace((unsigned char)*posn))
+            ++posn;
+        field = posn;
+        field_len = strlen(field);
+        while (field_len > 0 && isspace((unsigned char)field[field_len - 1]))
+            --field_len;
+
+        /* Add the record */
+        err = noise_keystore_builder_add
+            (builder, key, key_len, has_psk ? psk : NULL,
+             has_psk ? KEYSTORE_PSK_LEN : 0, field, field_len);
+        if (err != NOISE_ERROR_NONE) {
+            fprintf(stderr, "%s:%ld: ", filename, line_number);
+            noise_perror("", err);
+            ok = 0;
+        }
+    }
+
+    /* Clean up and exit */
+    noise_clean(psk, sizeof(psk));
+    noise_clean(line, sizeof(line));
+    if (file != stdin)
+        fclose(file);
+    return ok;
+}
+
+/* Main entry point for the "keystore" subcommand */
+int main_keystore(const char *progname, int argc, char *argv[])
+{
+    NoiseKeyStoreBuilder *builder = 0;
+    size_t key_len;
+    int retval = 0;
+    int index;
+    int err;
+
+    /* Parse the command-line options */
+    if (!parse_options_keystore(progname, argc, argv))
+        return 1;
+    key_len = key_length_for_algorithm(algorithm);
+    if (!key_len) {
+        fprintf(stderr, "Unknown DH algorithm '%s'\n", algorithm);
+        return 1;
+    }
+
+    /* Collect up the records from all inputs */
+    CHECK_ERROR(noise_keystore_builder_new
+        (&builder, key_len, KEYSTORE_PSK_LEN));
+    for (index = 0; index < num_certificates; ++index) {
+        if (!add_certificate(builder, key_len, certificates[index])) {
+            retval = 1;
+            goto cleanup;
+        }
+    }
+    for (index = optind; index < argc; ++index) {
+        if (!add_text_file(builder, key_len, argv[index])) {
+            retval = 1;
+            goto cleanup;
+        }
+    }
+
+    /* Write the key store */
+    err = noise_keystore_builder_save(builder, output_file);
+    if (err == NOISE_ERROR_INVALID_PARAM) {
+        fprintf(stderr, "%s: duplicate public keys in the input\n",
+                output_file);
+        retval = 1;
+    } else if (err == NOISE_ERROR_SYSTEM) {
+        perror(output_file);
+        retval = 1;
+    } else {
+        CHECK_ERROR(err);
+    }
+
+cleanup:
+    noise_keystore_builder_free(builder);
+    return retval;
+}
+
+/* Main entry point for the "lookup" subcommand */
+int main_lookup(const char *progname, int argc, char *argv[])
+{
+    NoiseKeyStore *store = 0;
+    NoiseKeyStoreEntry entry;
+    uint8_t key[MAX_PUBLIC_KEY_LEN];
+    int key_len;
+    int err;
+
+    /* Parse the command-line options */
+    if (argc != 3) {
+        help_lookup(progname);
+        return 1;
+    }
+    key_len = parse_hex(argv[2], strlen(argv[2]), key, sizeof(key));
+    if (key_len <= 0) {
+        fprintf(stderr, "Invalid public key '%s'\n", argv[2]);
+        return 1;
+    }
+
+    /* Open the key store and look up the key */
+    err = noise_keystore_open(&store, argv[1]);
+    if (err != NOISE_ERROR_NONE) {
+        if (err == NOISE_ERROR_SYSTEM)
+            perror(argv[1]);
+        else
+            noise_perror(argv[1], err);
+        return 1;
+    }
+    printf("Entries: %lu\n", (unsigned long)noise_keystore_get_count(store));
+    err = noise_keystore_lookup(store, key, (size_t)key_len, &entry);
+    if (err == NOISE_ERROR_NONE) {
+        printf("Found: yes\n");
+        printf("PSK: %s\n", entry.psk ? "yes" : "no");
+        printf("Metadata: %.*s\n", (int)(entry.metadata_len),
+               (const char *)(entry.metadata));
+    } else if (err == NOISE_ERROR_INVALID_PUBLIC_KEY) {
+        printf("Found: no\n");
+    } else {
+        noise_perror(argv[1], err);
+    }
+    noise_keystore_close(store);
+    return err == NOISE_ERROR_NONE ? 0 : 1;
+}
@@ -31,7 +31,12 @@ static void usage(const char *progname)
 {
     fprintf(stdout, "Usage: %s command [options] ...\n\n", progname);
     fprintf(stdout, "Commands:\n\n");
+    fprintf(stdout, "    bench      Measure the time taken to unlock private keys.\n");
     fprintf(stdout, "    generate   Generate a private key and certificate.\n");
+    fprintf(stdout, "    keystore   Build a static key store for a responder.\n");
+    fprintf(stdout, "    lookup     Look up a public key in a static key store.\n");
+    fprintf(stdout, "    revoke     Build a key revocation set.\n");
+    fprintf(stdout, "    revoked    Check if a key is in a key revocation set.\n");
     fprintf(stdout, "    show       Show information about a key or certificate.\n");
     fprintf(stdout, "    sign       Sign a certificate.\n");
     fprintf(stdout, "    help       Show command-specific help.\n");
@@ -56,15 +61,35 @@ int main(int argc, char *argv[])
     }
 
     /* Determine which subcommand to run */
-    if (!strcmp(argv[1], "generate")) {
+    if (!strcmp(argv[1], "bench")) {
+        retval = main_bench(progname, argc - 1, argv + 1);
+    } else if (!strcmp(argv[1], "generate")) {
         retval = main_generate(progname, argc - 1, argv + 1);
+    } else if (!strcmp(argv[1], "keystore")) {
+        retval = main_keystore(progname, argc - 1, argv + 1);
+    } else if (!strcmp(argv[1], "lookup")) {
+        retval = main_lookup(progname, argc - 1, argv + 1);
+    } else if (!strcmp(argv[1], "revoke")) {
+        retval = main_revoke(progname, argc - 1, argv + 1);
+    } else if (!strcmp(argv[1], "revoked")) {
+        retval = main_revoked(progname, argc - 1, argv + 1);
     } else if (!strcmp(argv[1], "show")) {
         retval = main_show(progname, argc - 1, argv + 1);
     } else if (!strcmp(argv[1], "sign")) {
         retval = main_sign(progname, argc - 1, argv + 1);
     } else if (!strcmp(argv[1], "help") && argc > 2) {
-        if (!strcmp(argv[2], "generate")) {
+        if (!strcmp(argv[2], "bench")) {
+            help_bench(progname);
+        } else if (!strcmp(argv[2], "generate")) {
             help_generate(progname);
+        } else if (!strcmp(argv[2], "keystore")) {
+            help_keystore(progname);
+        } else if (!strcmp(argv[2], "lookup")) {
+            help_lookup(progname);
+        } else if (!strcmp(argv[2], "revoke")) {
+            help_revoke(progname);
+        } else if (!strcmp(argv[2], "revoked")) {
+            help_revoked(progname);
         } else if (!strcmp(argv[2], "show")) {
             help_show(progname);
         } else if (!strcmp(argv[2], "sign")) {
@@ -121,3 +146,28 @@ char *ask_for_passphrase(int confirm)
     return passphrase;
 #endif
 }
+
+/* Converts a hex string into binary, returning the length or -1 */
+int parse_hex(const char *str, size_t len, uint8_t *data, size_t max_len)
+{
+    size_t posn;
+    int digit, value;
+    if ((len % 2) != 0 || (len / 2) > max_len)
+        return -1;
+    for (posn = 0; posn < len; ++posn) {
+        digit = (unsigned char)(str[posn]);
+        if (digit >= '0' && digit <= '9')
+            value = digit - '0';
+        else if (digit >= 'a' && digit <= 'f')
+            value = digit - 'a' + 10;
+        else if (digit >= 'A' && digit <= 'F')
+            value = digit - 'A' + 10;
+        else
+            return -1;
+        if ((posn % 2) == 0)
+            data[posn / 2] = (uint8_t)(value << 4);
+        else
+            data[posn / 2] |= (uint8_t)value;
+    }
+    return (int)(len / 2);
+}
@@ -31,11 +31,21 @@
 #include <unistd.h>
 #include <getopt.h>
 
+void help_bench(const char *progname);
 void help_generate(const char *progname);
+void help_keystore(const char *progname);
+void help_lookup(const char *progname);
+void help_revoke(const char *progname);
+void help_revoked(const char *progname);
 void help_show(const char *progname);
 void help_sign(const char *progname);
 
+int main_bench(const char *progname, int argc, char *argv[]);
 int main_generate(const char *progname, int argc, char *argv[]);
+int main_keystore(const char *progname, int argc, char *argv[]);
+int main_lookup(const char *progname, int argc, char *argv[]);
+int main_revoke(const char *progname, int argc, char *argv[]);
+int main_revoked(const char *progname, int argc, char *argv[]);
 int main_show(const char *progname, int argc, char *argv[]);
 int main_sign(const char *progname, int argc, char *argv[]);
 
@@ -43,6 +53,8 @@ void report_error(const char *file, long line, int err);
 
 char *ask_for_passphrase(int confirm);
 
+int parse_hex(const char *str, size_t len, uint8_t *data, size_t max_len);
+
 #define CHECK_ERROR(code)   \
     do { \
         int err = (code); \
@@ -0,0 +1,317 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "keytool.h"
+#include <ctype.h>
+
+#define short_options "c:"
+
+static struct option const long_options[] = {
+    {"certificate",             required_argument,      NULL,       'c'},
+    {NULL,                      0,                      NULL,        0 }
+};
+
+#define MAX_CERTIFICATES    64
+#define MAX_LINE            8192
+#define MAX_PUBLIC_KEY_LEN  4096
+
+static const char *certificates[MAX_CERTIFICATES];
+static int num_certificates = 0;
+static const char *output_file = NULL;
+
+/* Print usage/help information */
+void help_revoke(const char *progname)
+{
+    fprintf(stdout, "Usage: %s revoke [options] output-file [input-file ...]\n\n", progname);
+    fprintf(stdout, "Builds a key revocation set from text files and certificates.\n");
+    fprintf(stdout, "Each line of an input file contains either a public key in\n");
+    fprintf(stdout, "hexadecimal, or a full key fingerprint in the colon-separated\n");
+    fprintf(stdout, "form that is reported by \"show --full-fingerprint\".  Blank lines\n");
+    fprintf(stdout, "and lines starting with '#' are ignored.  An input file of \"-\"\n");
+    fprintf(stdout, "reads from standard input.\n\n");
+    fprintf(stdout, "Options:\n\n");
+    fprintf(stdout, "    --certificate=FILE, -c FILE\n");
+    fprintf(stdout, "        Revokes all of the subject's keys from a certificate or\n");
+    fprintf(stdout, "        certificate chain.  May be specified multiple times.\n\n");
+}
+
+/* Print usage/help information for the "revoked" command */
+void help_revoked(const char *progname)
+{
+    fprintf(stdout, "Usage: %s revoked revocation-file hex-public-key|fingerprint\n\n", progname);
+    fprintf(stdout, "Checks if a public key or fingerprint is in a revocation set\n");
+    fprintf(stdout, "that was created with the \"revoke\" command.\n\n");
+}
+
+/* Parse the command-line options */
+static int parse_options_revoke(const char *progname, int argc, char *argv[])
+{
+    int index = 0;
+    int ch;
+    while ((ch = getopt_long(argc, argv, short_options, long_options, &index)) != -1) {
+        switch (ch) {
+        case 'c':
+            if (num_certificates >= MAX_CERTIFICATES) {
+                fprintf(stderr, "Too many certificates\n");
+                return 0;
+            }
+            certificates[num_certificates++] = optarg;
+            break;
+        default:
+            help_revoke(progname);
+            return 0;
+        }
+    }
+    if (optind >= argc) {
+        help_revoke(progname);
+        return 0;
+    }
+    output_file = argv[optind++];
+    return 1;
+}
+
+/* Parses a colon-separated fingerprint, returning non-zero if valid */
+static int parse_fingerprint(const char *str, size_t len, uint8_t *fingerprint)
+{
+    char hex[NOISE_REVOCATION_FINGERPRINT_LEN * 2];
+    size_t posn, out = 0;
+    if (len != (NOISE_REVOCATION_FINGERPRINT_LEN * 3 - 1))
+        return 0;
+    for (posn = 0; posn < len; ++posn) {
+        if ((posn % 3) == 2) {
+            if (str[posn] != ':')
+                return 0;
+        } else {
+            hex[out++] = str[posn];
+        }
+    }
+    return parse_hex(hex, sizeof(hex), fingerprint,
+                     NOISE_REVOCATION_FINGERPRINT_LEN) ==
+                NOISE_REVOCATION_FINGERPRINT_LEN;
+}
+
+/* Parses a public key or fingerprint and adds it to the revocation set */
+static int add_key_or_fingerprint
+    (NoiseRevocationBuilder *builder, const char *str, size_t len)
+{
+    static uint8_t key[MAX_PUBLIC_KEY_LEN];
+    int key_len;
+    if (memchr(str, ':', len)) {
+        if (!parse_fingerprint(str, len, key))
+            return NOISE_ERROR_INVALID_FORMAT;
+        return noise_revocation_builder_add_fingerprint
+            (builder, key, NOISE_REVOCATION_FINGERPRINT_LEN);
+    }
+    key_len = parse_hex(str, len, key, sizeof(key));
+    if (key_len <= 0)
+        return NOISE_ERROR_INVALID_FORMAT;
+    return noise_revocation_builder_add_key(builder, key, (size_t)key_len);
+}
+
+/* Adds the subject keys from a certificate to the revocation set */
+static int add_certificate
+    (NoiseRevocationBuilder *builder, const char *filename)
+{
+    Noise_Certificate *cert = 0;
+    const Noise_SubjectInfo *subject;
+    size_t count = 0;
+    size_t index;
+    int err;
+
+    /* Load the certificate */
+    err = noise_load_certificate_from_file(&cert, filename);
+    if (err != NOISE_ERROR_NONE) {
+        noise_perror(filename, err);
+        return 0;
+    }
+
+    /* Revoke every key in the subject */
+    subject = Noise_Certificate_get_subject(cert);
+    if (subject)
+        count = Noise_SubjectInfo_count_keys(subject);
+    for (index = 0; index < count; ++index) {
+        const Noise_PublicKeyInfo *key =
+            Noise_SubjectInfo_get_at_keys(subject, index);
+        if (!Noise_PublicKeyInfo_has_key(key))
+            continue;
+        err = noise_revocation_builder_add_key
+            (builder, (const uint8_t *)Noise_PublicKeyInfo_get_key(key),
+             Noise_PublicKeyInfo_get_size_key(key));
+        if (err != NOISE_ERROR_NONE) {
+            noise_perror(filename, err);
+            Noise_Certificate_free(cert);
+            return 0;
+        }
+    }
+    if (!count)
+        fprintf(stderr, "%s: no keys in certificate\n", filename);
+
+    /* Clean up and exit */
+    Noise_Certificate_free(cert);
+    return 1;
+}
+
+/* Adds the keys and fingerprints from a text file to the revocation set */
+static int add_text_file(NoiseRevocationBuilder *builder, const char *filename)
+{
+    static char line[MAX_LINE];
+    FILE *file;
+    char *posn;
+    char *field;
+    size_t field_len;
+    long line_number = 0;
+    int ok = 1;
+    int err;
+
+    /* Open the input file */
+    if (!strcmp(filename, "-")) {
+        file = stdin;
+    } else {
+        file = fopen(filename, "r");
+        if (!file) {
+            perror(filename);
+            return 0;
+        }
+    }
+
+    /* Process the lines in the file */
+    while (ok && fgets(line, sizeof(line), file)) {
+        ++line_number;
+        posn = line;
+        while (isspace((unsigned char)*posn))
+            ++posn;
+        if (*posn == '\0' || *posn == '#')
+            continue;
+        field = posn;
+        while (*posn != '\0' && !isspace((unsigned char)*posn))
+            ++posn;
+        field_len = (size_t)(posn - field);
+        err = add_key_or_fingerprint(builder, field, field_len);
+        if (err == NOISE_ERROR_INVALID_FORMAT) {
+            fprintf(stderr, "%s:%ld: invalid public key or fingerprint\n",
+                    filename, line_number);
+            ok = 0;
+        } else if (err != NOISE_ERROR_NONE) {
+            fprintf(stderr, "%s:%ld: ", filename, line_number);
+            noise_perror("", err);
+            ok = 0;
+        }
+    }
+
+    /* Clean up and exit */
+    if (file != stdin)
+        fclose(file);
+    return ok;
+}
+
+/* Main entry point for the "revoke" subcommand */
+int main_revoke(const char *progname, int argc, char *argv[])
+{
+    NoiseRevocationBuilder *builder = 0;
+    int retval = 0;
+    int index;
+    int err;
+
+    /* Parse the command-line options */
+    if (!parse_options_revoke(progname, argc, argv))
+        return 1;
+
+    /* Collect up the keys from all inputs */
+    CHECK_ERROR(noise_revocation_builder_new(&builder));
+    for (index = 0; index < num_certificates; ++index) {
+        if (!add_certificate(builder, certificates[index])) {
+            retval = 1;
+            goto cleanup;
+        }
+    }
+    for (index = optind; index < argc; ++index) {
+        if (!add_text_file(builder, argv[index])) {
+            retval = 1;
+            goto cleanup;
+        }
+    }
+
+    /* Write the revocation set */
+    err = noise_revocation_builder_save(builder, output_file);
+    if (err == NOISE_ERROR_SYSTEM) {
+        perror(output_file);
+        retval = 1;
+    } else {
+        CHECK_ERROR(err);
+    }
+
+cleanup:
+    noise_revocation_builder_free(builder);
+    return retval;
+}
+
+/* Main entry point for the "revoked" subcommand */
+int main_revoked(const char *progname, int argc, char *argv[])
+{
+    NoiseRevocationSet *set = 0;
+    uint8_t fingerprint[NOISE_REVOCATION_FINGERPRINT_LEN];
+    static uint8_t key[MAX_PUBLIC_KEY_LEN];
+    size_t len;
+    int key_len;
+    int err;
+
+    /* Parse the command-line options */
+    if (argc != 3) {
+        help_revoked(progname);
+        return 1;
+    }
+
+    /* Open the revocation set */
+    err = noise_revocation_open(&set, argv[1]);
+    if (err != NOISE_ERROR_NONE) {
+        if (err == NOISE_ERROR_SYSTEM)
+            perror(argv[1]);
+        else
+            noise_perror(argv[1], err);
+        return 1;
+    }
+    printf("Entries: %lu\n", (unsigned long)noise_revocation_get_count(set));
+
+    /* Check the key or fingerprint */
+    len = strlen(argv[2]);
+    if (parse_fingerprint(argv[2], len, fingerprint)) {
+        err = noise_revocation_check_fingerprint
+            (set, fingerprint, sizeof(fingerprint));
+    } else {
+        key_len = parse_hex(argv[2], len, key, sizeof(key));
+        if (key_len <= 0) {
+            fprintf(stderr, "Invalid public key or fingerprint '%s'\n",
+                    argv[2]);
+            noise_revocation_close(set);
+            return 1;
+        }
+        err = noise_revocation_check_key(set, key, (size_t)key_len);
+    }
+    if (err == NOISE_ERROR_KEY_REVOKED)
+        printf("Revoked: yes\n");
+    else if (err == NOISE_ERROR_NONE)
+        printf("Revoked: no\n");
+    else
+        noise_perror(argv[2], err);
+    noise_revocation_close(set);
+    return err == NOISE_ERROR_KEY_REVOKED ? 0 : 1;
+}
@@ -0,0 +1,656 @@
+/*
+ * Copyright (C) 2016 Southern Storm Software, Pty Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+
+/*
+ * This program turns the token sequences in src/protocol/patterns.c
+ * into straight-line C functions, one write and one read function per
+ * handshake message.  All decisions that the generic token interpreter
+ * in handshakestate.c makes at runtime are resolved here instead:
+ * which token comes next, which DHState objects take part in each DH
+ * operation, whether the symmetric state is keyed yet, and whether
+ * the PSK variant of the protocol needs to mix ephemeral keys into
+ * the chaining key.
+ *
+ * The generic interpreter remains in place for any pattern that does
+ * not have a compiled form.
+ */
+
+#define short_options "o:l:"
+
+static struct option const long_options[] = {
+    {"output",                  required_argument,      NULL,       'o'},
+    {"license",                 required_argument,      NULL,       'l'},
+    {NULL,                      0,                      NULL,        0 }
+};
+
+static char *output_file = "patterns-compiled.c";
+static char *license_file = NULL;
+
+/** Maximum number of patterns that can be compiled */
+#define MAX_PATTERNS    64
+
+/** Pattern identifiers and names that were compiled */
+static int pattern_ids[MAX_PATTERNS];
+static const char *pattern_names[MAX_PATTERNS];
+static int num_patterns = 0;
+
+/* Print usage information */
+static void usage(const char *progname)
+{
+    fprintf(stderr, "Usage: %s [options]\n\n", progname);
+    fprintf(stderr, "Options:\n\n");
+    fprintf(stderr, "    --output=filename, -o filename\n");
+    fprintf(stderr, "        Name of the file for the output C source code.\n");
+    fprintf(stderr, "        Defaults to patterns-compiled.c in the current directory.\n\n");
+    fprintf(stderr, "    --license=filename, -l filename\n");
+    fprintf(stderr, "        File containing Copyright license details to add to the output.\n");
+}
+
+/* Parse the command-line options */
+static int parse_options(int argc, char *argv[])
+{
+    const char *progname = argv[0];
+    int index = 0;
+    int ch;
+    while ((ch = getopt_long(argc, argv, short_options, long_options, &index)) != -1) {
+        switch (ch) {
+        case 'o':   output_file = optarg; break;
+        case 'l':   license_file = optarg; break;
+        default:
+            usage(progname);
+            return 0;
+        }
+    }
+    if (optind != argc) {
+        usage(progname);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * \brief Generates the license block at the top of the source file.
+ */
+static void generate_license(FILE *output)
+{
+    FILE *lfile;
+    char buffer[BUFSIZ];
+    if (!license_file)
+        return;
+    lfile = fopen(license_file, "r");
+    if (!lfile) {
+        perror(license_file);
+        return;
+    }
+    fprintf(output, "/*\n");
+    while (fgets(buffer, sizeof(buffer), lfile)) {
+        fprintf(output, " * ");
+        fputs(buffer, output);
+    }
+    fprintf(output, " */\n\n");
+    fclose(lfile);
+}
+
+/**
+ * \brief Gets the source form of a token for use in comments.
+ */
+static const char *token_name(uint8_t token)
+{
+    switch (token) {
+    case NOISE_TOKEN_S:     return "s";
+    case NOISE_TOKEN_E:     return "e";
+    case NOISE_TOKEN_DHEE:  return "dhee";
+    case NOISE_TOKEN_DHES:  return "dhes";
+    case NOISE_TOKEN_DHSE:  return "dhse";
+    case NOISE_TOKEN_DHSS:  return "dhss";
+    default:                break;
+    }
+    return "?";
+}
+
+/**
+ * \brief Information about a single message within a pattern.
+ */
+typedef struct
+{
+    const uint8_t *tokens;  /**< Tokens for the message */
+    size_t num_tokens;      /**< Number of tokens before FLIP_DIR/END */
+    int is_last;            /**< Non-zero if the message ends the pattern */
+    int keyed;              /**< Non-zero if the cipher is keyed on entry */
+
+} MessageInfo;
+
+/**
+ * \brief Determine if a message contains a specific token.
+ */
+static int has_token(const MessageInfo *info, uint8_t token)
+{
+    size_t index;
+    for (index = 0; index < info->num_tokens; ++index) {
+        if (info->tokens[index] == token)
+            return 1;
+    }
+    return 0;
+}
+
+/**
+ * \brief Determine if a token causes the cipher to become keyed.
+ */
+static int token_sets_key(uint8_t token, int is_psk)
+{
+    if (token == NOISE_TOKEN_E)
+        return is_psk;
+    return token >= NOISE_TOKEN_DHEE && token <= NOISE_TOKEN_DHSS;
+}
+
+/**
+ * \brief Generates the function name for a compiled message.
+ */
+static void generate_name
+    (FILE *output, const char *name, int is_psk, const char *dir, size_t msg)
+{
+    fprintf(output, "noise_compiled_%s%s_%s_%u",
+            name, is_psk ? "_psk" : "", dir, (unsigned)msg);
+}
+
+/**
+ * \brief Generates the length of the fixed part of a message,
+ * not counting the payload itself.
+ */
+static void generate_fixed_length
+    (FILE *output, const MessageInfo *info, int is_psk)
+{
+    int keyed = info->keyed;
+    int first = 1;
+    size_t index;
+    fprintf(output, "    fixed_len = ");
+    for (index = 0; index < info->num_tokens; ++index) {
+        uint8_t token = info->tokens[index];
+        if (token == NOISE_TOKEN_E) {
+            fprintf(output, "%se_len", first ? "" : " + ");
+            first = 0;
+        } else if (token == NOISE_TOKEN_S) {
+            fprintf(output, "%ss_len", first ? "" : " + ");
+            if (keyed)
+                fprintf(output, " + mac_len");
+            first = 0;
+        }
+        if (token_sets_key(token, is_psk))
+            keyed = 1;
+    }
+    if (keyed) {
+        fprintf(output, "%smac_len", first ? "" : " + ");
+        first = 0;
+    }
+    if (first)
+        fprintf(output, "0");
+    fprintf(output, ";\n");
+}
+
+/**
+ * \brief Generates a DH operation for a "dhxy" token.
+ */
+static void generate_dh(FILE *output, uint8_t token, int is_write)
+{
+    const char *priv;
+    const char *pub;
+    switch (token) {
+    case NOISE_TOKEN_DHEE:
+        priv = "ephemeral";
+        pub = "ephemeral";
+        break;
+    case NOISE_TOKEN_DHES:
+        priv = is_write ? "ephemeral" : "static";
+        pub = is_write ? "static" : "ephemeral";
+        break;
+    case NOISE_TOKEN_DHSE:
+        priv = is_write ? "static" : "ephemeral";
+        pub = is_write ? "ephemeral" : "static";
+        break;
+    default:
+        priv = "static";
+        pub = "static";
+        break;
+    }
+    fprintf(output, "    err = noise_handshakestate_mix_dh\n");
+    fprintf(output, "        (state, state->dh_local_%s, state->dh_remote_%s);\n",
+            priv, pub);
+    fprintf(output, "    if (err != NOISE_ERROR_NONE)\n");
+    fprintf(output, "        return err;\n");
+}
+
+/**
+ * \brief Generates the prologue of a compiled message function that
+ * fetches the key and MAC lengths.
+ */
+static void generate_locals
+    (FILE *output, const MessageInfo *info, int is_psk, int is_write)
+{
+    int uses_mac;
+    int keyed = info->keyed;
+    size_t index;
+
+    /* Does the message ever need the MAC length? */
+    uses_mac = keyed;
+    for (index = 0; index < info->num_tokens; ++index) {
+        if (token_sets_key(info->tokens[index], is_psk))
+            uses_mac = 1;
+    }
+
+    fprintf(output, "    NoiseSymmetricState *symmetric = state->symmetric;\n");
+    if (uses_mac)
+        fprintf(output, "    size_t mac_len = noise_cipherstate_get_mac_length(symmetric->cipher);\n");
+    if (is_write)
+        fprintf(output, "    size_t payload_len = payload ? payload->size : 0;\n");
+    if (has_token(info, NOISE_TOKEN_E))
+        fprintf(output, "    size_t e_len;\n");
+    if (has_token(info, NOISE_TOKEN_S))
+        fprintf(output, "    size_t s_len;\n");
+    fprintf(output, "    size_t fixed_len;\n");
+    if (is_write) {
+        fprintf(output, "    uint8_t *out = message->data;\n");
+        fprintf(output, "    NoiseBuffer rest;\n");
+    } else {
+        fprintf(output, "    uint8_t *in = message->data;\n");
+        fprintf(output, "    NoiseBuffer msg;\n");
+    }
+    fprintf(output, "    int err;\n\n");
+}
+
+/**
+ * \brief Generates the code that finishes off the token sequence.
+ */
+static void generate_advance
+    (FILE *output, const MessageInfo *info, int is_write)
+{
+    fprintf(output, "    /* Advance past the tokens for this message */\n");
+    if (info->is_last) {
+        if (info->num_tokens)
+            fprintf(output, "    state->tokens += %u;\n", (unsigned)(info->num_tokens));
+        fprintf(output, "    state->action = NOISE_ACTION_SPLIT;\n\n");
+    } else {
+        fprintf(output, "    state->tokens += %u;\n", (unsigned)(info->num_tokens + 1));
+        fprintf(output, "    state->action = %s;\n\n",
+                is_write ? "NOISE_ACTION_READ_MESSAGE"
+                         : "NOISE_ACTION_WRITE_MESSAGE");
+    }
+}
+
+/**
+ * \brief Generates the write function for a message.
+ */
+static void generate_write
+    (FILE *output, const char *name, int is_psk, size_t msg,
+     const MessageInfo *info)
+{
+    int keyed = info->keyed;
+    size_t index;
+    uint8_t token;
+
+    fprintf(output, "static int ");
+    generate_name(output, name, is_psk, "write", msg);
+    fprintf(output, "\n    (NoiseHandshakeState *state, NoiseBuffer *message,\n");
+    fprintf(output, "     const NoiseBuffer *payload)\n{\n");
+    generate_locals(output, info, is_psk, 1);
+
+    /* Generate the local ephemeral up front so that we know its length */
+    if (has_token(info, NOISE_TOKEN_E)) {
+        fprintf(output, "    err = noise_handshakestate_new_ephemeral(state);\n");
+        fprintf(output, "    if (err != NOISE_ERROR_NONE)\n");
+        fprintf(output, "        return err;\n");
+        fprintf(output, "    e_len = state->dh_local_ephemeral->public_key_len;\n");
+    }
+    if (has_token(info, NOISE_TOKEN_S))
+        fprintf(output, "    s_len = state->dh_local_static->public_key_len;\n");
+    generate_fixed_length(output, info, is_psk);
+    fprintf(output, "    if (message->max_size < fixed_len ||\n");
+    fprintf(output, "            (message->max_size - fixed_len) < payload_len)\n");
+    fprintf(output, "        return NOISE_ERROR_INVALID_LENGTH;\n\n");
+
+    for (index = 0; index < info->num_tokens; ++index) {
+        token = info->tokens[index];
+        fprintf(output, "    /* %s */\n", token_name(token));
+        switch (token) {
+        case NOISE_TOKEN_E:
+            fprintf(output, "    memcpy(out, state->dh_local_ephemeral->public_key, e_len);\n");
+            fprintf(output, "    noise_symmetricstate_mix_hash(symmetric, out, e_len);\n");
+            if (is_psk) {
+                fprintf(output, "    err = noise_symmetricstate_mix_key(symmetric, out, e_len);\n");
+                fprintf(output, "    if (err != NOISE_ERROR_NONE)\n");
+                fprintf(output, "        return err;\n");
+            }
+            fprintf(output, "    out += e_len;\n");
+            break;
+        case NOISE_TOKEN_S:
+            fprintf(output, "    memcpy(out, state->dh_local_static->public_key, s_len);\n");
+            if (keyed) {
+                fprintf(output, "    rest.data = out;\n");
+                fprintf(output, "    rest.size = s_len;\n");
+                fprintf(output, "    rest.max_size = s_len + mac_len;\n");
+                fprintf(output, "    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);\n");
+                fprintf(output, "    if (err != NOISE_ERROR_NONE)\n");
+                fprintf(output, "        return err;\n");
+                fprintf(output, "    out += rest.size;\n");
+            } else {
+                fprintf(output, "    noise_symmetricstate_mix_hash(symmetric, out, s_len);\n");
+                fprintf(output, "    out += s_len;\n");
+            }
+            break;
+        default:
+            generate_dh(output, token, 1);
+            break;
+        }
+        fprintf(output, "\n");
+        if (token_sets_key(token, is_psk))
+            keyed = 1;
+    }
+
+    generate_advance(output, info, 1);
+
+    fprintf(output, "    /* payload */\n");
+    fprintf(output, "    if (payload_len)\n");
+    fprintf(output, "        memcpy(out, payload->data, payload_len);\n");
+    fprintf(output, "    rest.data = out;\n");
+    fprintf(output, "    rest.size = payload_len;\n");
+    fprintf(output, "    rest.max_size = payload_len%s;\n", keyed ? " + mac_len" : "");
+    fprintf(output, "    err = noise_symmetricstate_encrypt_and_hash(symmetric, &rest);\n");
+    fprintf(output, "    if (err != NOISE_ERROR_NONE)\n");
+    fprintf(output, "        return err;\n");
+    fprintf(output, "    message->size = (size_t)(out - message->data) + rest.size;\n");
+    fprintf(output, "    return NOISE_ERROR_NONE;\n");
+    fprintf(output, "}\n\n");
+}
+
+/**
+ * \brief Generates the read function for a message.
+ */
+static void generate_read
+    (FILE *output, const char *name, int is_psk, size_t msg,
+     const MessageInfo *info)
+{
+    int keyed = info->keyed;
+    size_t index;
+    uint8_t token;
+
+    fprintf(output, "static int ");
+    generate_name(output, name, is_psk, "read", msg);
+    fprintf(output, "\n    (NoiseHandshakeState *state, NoiseBuffer *message,\n");
+    fprintf(output, "     NoiseBuffer *payload)\n{\n");
+    generate_locals(output, info, is_psk, 0);
+
+    if (has_token(info, NOISE_TOKEN_E))
+        fprintf(output, "    e_len = state->dh_remote_ephemeral->public_key_len;\n");
+    if (has_token(info, NOISE_TOKEN_S))
+        fprintf(output, "    s_len = state->dh_remote_static->public_key_len;\n");
+    generate_fixed_length(output, info, is_psk);
+    fprintf(output, "    if (message->size < fixed_len)\n");
+    fprintf(output, "        return NOISE_ERROR_INVALID_LENGTH;\n\n");
+
+    for (index = 0; index < info->num_tokens; ++index) {
+        token = info->tokens[index];
+        fprintf(output, "    /* %s */\n", token_name(token));
+        switch (token) {
+        case NOISE_TOKEN_E:
+            fprintf(output, "    noise_symmetricstate_mix_hash(symmetric, in, e_len);\n");
+            fprintf(output, "    err = noise_dhstate_set_public_key\n");
+            fprintf(output, "        (state->dh_remote_ephemeral, in, e_len);\n");
+            fprintf(output, "    if (err != NOISE_ERROR_NONE)\n");
+            fprintf(output, "        return err;\n");
+            fprintf(output, "    if (noise_dhstate_is_null_public_key(state->dh_remote_ephemeral))\n");
+            fprintf(output, "        return NOISE_ERROR_INVALID_PUBLIC_KEY;\n");
+            if (is_psk) {
+                fprintf(output, "    err = noise_symmetricstate_mix_key\n");
+                fprintf(output, "        (symmetric, state->dh_remote_ephemeral->public_key, e_len);\n");
+                fprintf(output, "    if (err != NOISE_ERROR_NONE)\n");
+                fprintf(output, "        return err;\n");
+            }
+            fprintf(output, "    in += e_len;\n");
+            break;
+        case NOISE_TOKEN_S:
+            if (keyed) {
+                fprintf(output, "    msg.data = in;\n");
+                fprintf(output, "    msg.size = s_len + mac_len;\n");
+                fprintf(output, "    msg.max_size = s_len + mac_len;\n");
+                fprintf(output, "    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);\n");
+                fprintf(output, "    if (err != NOISE_ERROR_NONE)\n");
+                fprintf(output, "        return err;\n");
+                fprintf(output, "    err = noise_dhstate_set_public_key\n");
+                fprintf(output, "        (state->dh_remote_static, msg.data, msg.size);\n");
+                fprintf(output, "    if (err != NOISE_ERROR_NONE)\n");
+                fprintf(output, "        return err;\n");
+                fprintf(output, "    err = noise_handshakestate_check_remote_static(state);\n");
+                fprintf(output, "    if (err != NOISE_ERROR_NONE)\n");
+                fprintf(output, "        return err;\n");
+                fprintf(output, "    in += s_len + mac_len;\n");
+            } else {
+                fprintf(output, "    noise_symmetricstate_mix_hash(symmetric, in, s_len);\n");
+                fprintf(output, "    err = noise_dhstate_set_public_key\n");
+                fprintf(output, "        (state->dh_remote_static, in, s_len);\n");
+                fprintf(output, "    if (err != NOISE_ERROR_NONE)\n");
+                fprintf(output, "        return err;\n");
+                fprintf(output, "    err = noise_handshakestate_check_remote_static(state);\n");
+                fprintf(output, "    if (err != NOISE_ERROR_NONE)\n");
+                fprintf(output, "        return err;\n");
+                fprintf(output, "    in += s_len;\n");
+            }
+            break;
+        default:
+            generate_dh(output, token, 0);
+            break;
+        }
+        fprintf(output, "\n");
+        if (token_sets_key(token, is_psk))
+            keyed = 1;
+    }
+
+    generate_advance(output, info, 0);
+
+    fprintf(output, "    /* payload */\n");
+    fprintf(output, "    msg.data = in;\n");
+    fprintf(output, "    msg.size = message->size - (size_t)(in - message->data);\n");
+    fprintf(output, "    msg.max_size = message->max_size - (size_t)(in - message->data);\n");
+    fprintf(output, "    err = noise_symmetricstate_decrypt_and_hash(symmetric, &msg);\n");
+    fprintf(output, "    if (err != NOISE_ERROR_NONE)\n");
+    fprintf(output, "        return err;\n");
+    fprintf(output, "    if (payload) {\n");
+    fprintf(output, "        if (msg.size > payload->max_size)\n");
+    fprintf(output, "            return NOISE_ERROR_INVALID_LENGTH;\n");
+    fprintf(output, "        memcpy(payload->data, msg.data, msg.size);\n");
+    fprintf(output, "        payload->size = msg.size;\n");
+    fprintf(output, "    }\n");
+    fprintf(output, "    return NOISE_ERROR_NONE;\n");
+    fprintf(output, "}\n\n");
+}
+
+/**
+ * \brief Generates the compiled functions for one variant of a pattern.
+ */
+static void generate_pattern
+    (FILE *output, const char *name, const uint8_t *pattern, int is_psk)
+{
+    MessageInfo messages[16];
+    size_t num_messages = 0;
+    const uint8_t *tokens = pattern + 1;
+    int keyed;
+    size_t index;
+    size_t msg;
+
+    /* In the PSK variant of a fallback pattern, the pre-message
+       ephemeral key is mixed into the chaining key before the
+       first message, which keys the cipher. */
+    keyed = is_psk && (pattern[0] & NOISE_PAT_FLAG_REMOTE_EPHEM_REQ) != 0;
+
+    /* Split the token sequence into messages */
+    for (;;) {
+        MessageInfo *info = &(messages[num_messages++]);
+        info->tokens = tokens;
+        info->num_tokens = 0;
+        info->keyed = keyed;
+        while (tokens[info->num_tokens] != NOISE_TOKEN_END &&
+               tokens[info->num_tokens] != NOISE_TOKEN_FLIP_DIR) {
+            if (token_sets_key(tokens[info->num_tokens], is_psk))
+                keyed = 1;
+            ++(info->num_tokens);
+        }
+        info->is_last = (tokens[info->num_tokens] == NOISE_TOKEN_END);
+        tokens += info->num_tokens + 1;
+        if (info->is_last || num_messages >= 16)
+            break;
+    }
+
+    /* Output a comment describing the pattern */
+    fprintf(output, "/* Noise_%s%s:\n", name, is_psk ? " (PSK)" : "");
+    for (msg = 0; msg < num_messages; ++msg) {
+        fprintf(output, " *   %s ", (msg % 2) == 0 ? "->" : "<-");
+        for (index = 0; index < messages[msg].num_tokens; ++index) {
+            fprintf(output, "%s%s", index ? ", " : "",
+                    token_name(messages[msg].tokens[index]));
+        }
+        fprintf(output, "\n");
+    }
+    fprintf(output, " */\n\n");
+
+    /* Output the read and write functions for all messages */
+    for (msg = 0; msg < num_messages; ++msg) {
+        generate_write(output, name, is_psk, msg, &(messages[msg]));
+        generate_read(output, name, is_psk, msg, &(messages[msg]));
+    }
+
+    /* Output the message table and the pattern descriptor */
+    fprintf(output, "static NoiseCompiledMessage const noise_compiled_%s%s_messages[] = {\n",
+            name, is_psk ? "_psk" : "");
+    for (msg = 0; msg < num_messages; ++msg) {
+        fprintf(output, "    {");
+        generate_name(output, name, is_psk, "write", msg);
+        fprintf(output, ", ");
+        generate_name(output, name, is_psk, "read", msg);
+        fprintf(output, "}%s\n", (msg + 1) < num_messages ? "," : "");
+    }
+    fprintf(output, "};\n\n");
+    fprintf(output, "static NoiseCompiledPattern const noise_compiled_%s%s = {\n",
+            name, is_psk ? "_psk" : "");
+    fprintf(output, "    %u, noise_compiled_%s%s_messages\n",
+            (unsigned)num_messages, name, is_psk ? "_psk" : "");
+    fprintf(output, "};\n\n");
+}
+
+/**
+ * \brief Generates the lookup function for the compiled patterns.
+ */
+static void generate_lookup(FILE *output)
+{
+    int index;
+    fprintf(output, "/**\n");
+    fprintf(output, " * \\brief Looks up the compiled form of a handshake pattern.\n");
+    fprintf(output, " *\n");
+    fprintf(output, " * \\param id The identifier for the handshake pattern.\n");
+    fprintf(output, " * \\param is_psk Non-zero for the PSK variant of the pattern.\n");
+    fprintf(output, " *\n");
+    fprintf(output, " * \\return A pointer to the compiled pattern, or NULL if \\a id\n");
+    fprintf(output, " * does not have a compiled form.\n");
+    fprintf(output, " */\n");
+    fprintf(output, "const NoiseCompiledPattern *noise_pattern_compiled_lookup(int id, int is_psk)\n");
+    fprintf(output, "{\n");
+    fprintf(output, "    switch (id) {\n");
+    for (index = 0; index < num_patterns; ++index) {
+        fprintf(output, "    case NOISE_ID('P', %d):\n", pattern_ids[index] & 0xFF);
+        fprintf(output, "        return is_psk ? &noise_compiled_%s_psk\n",
+                pattern_names[index]);
+        fprintf(output, "                      : &noise_compiled_%s;\n",
+                pattern_names[index]);
+    }
+    fprintf(output, "    default: break;\n");
+    fprintf(output, "    }\n");
+    fprintf(output, "    return 0;\n");
+    fprintf(output, "}\n");
+}
+
+/**
+ * \brief Generates the compiled form of all known handshake patterns.
+ */
+static void generate_c(FILE *output)
+{
+    const uint8_t *pattern;
+    const char *name;
+    int number;
+    int id;
+
+    generate_license(output);
+    fprintf(output, "/* This file is generated by noise-patternc - do not edit */\n\n");
+    fprintf(output, "#include \"internal.h\"\n");
+    fprintf(output, "#include <string.h>\n\n");
+    fprintf(output, "/**\n");
+    fprintf(output, " * \\file patterns-compiled.c\n");
+    fprintf(output, " * \\brief Straight-line implementations of the handshake patterns.\n");
+    fprintf(output, " */\n\n");
+
+    for (number = 1; number < 256 && num_patterns < MAX_PATTERNS; ++number) {
+        id = NOISE_ID('P', number);
+        pattern = noise_pattern_lookup(id);
+        if (!pattern)
+            continue;
+        name = noise_id_to_name(NOISE_PATTERN_CATEGORY, id);
+        if (!name)
+            continue;
+        generate_pattern(output, name, pattern, 0);
+        generate_pattern(output, name, pattern, 1);
+        pattern_ids[num_patterns] = id;
+        pattern_names[num_patterns] = name;
+        ++num_patterns;
+    }
+
+    generate_lookup(output);
+}
+
+int main(int argc, char *argv[])
+{
+    FILE *output;
+
+    /* Parse the command-line options */
+    if (!parse_options(argc, argv))
+        return 1;
+
+    /* Open the output file */
+    output = fopen(output_file, "w");
+    if (!output) {
+        perror(output_file);
+        return 1;
+    }
+
+    /* Generate the output */
+    generate_c(output);
+
+    /* Clean up and exit */
+    if (fclose(output) != 0) {
+        perror(output_file);
+        unlink(output_file);
+        return 1;
+    }
+    return 0;
+}
@@ -26,12 +26,13 @@
 #include <getopt.h>
 #include "proto3-ast.h"
 
-#define short_options "c:h:l:"
+#define short_options "c:h:l:t"
 
 static struct option const long_options[] = {
     {"output-c",                required_argument,      NULL,       'c'},
     {"output-h",                required_argument,      NULL,       'h'},
     {"license",                 required_argument,      NULL,       'l'},
+    {"tables",                  no_argument,            NULL,       't'},
     {NULL,                      0,                      NULL,        0 }
 };
 
@@ -43,6 +44,7 @@ static char *output_c_file = "proto_defs.c";
 static char *output_h_file = "proto_defs.h";
 static char *input_file = NULL;
 char *license_file = NULL;
+int table_mode = 0;
 
 /* Print usage information */
 static void usage(const char *progname)
@@ -56,7 +58,10 @@ static void usage(const char *progname)
     fprintf(stderr, "        Name of the file for the output C header definitions.\n");
     fprintf(stderr, "        Defaults to proto_defs.h in the current directory.\n\n");
     fprintf(stderr, "    --license=filename, -l filename\n");
-    fprintf(stderr, "        File containing Copyright license details to add to all outputs.\n");
+    fprintf(stderr, "        File containing Copyright license details to add to all outputs.\n\n");
+    fprintf(stderr, "    --tables, -t\n");
+    fprintf(stderr, "        Generate compact descriptor tables that are processed by the\n");
+    fprintf(stderr, "        shared table-driven serializer instead of per-field code.\n");
 }
 
 /* Parse the command-line options */
@@ -70,6 +75,7 @@ static int parse_options(int argc, char *argv[])
         case 'c':   output_c_file = optarg; break;
         case 'h':   output_h_file = optarg; break;
         case 'l':   license_file = optarg; break;
+        case 't':   table_mode = 1; break;
         default:
             usage(progname);
             return 0;
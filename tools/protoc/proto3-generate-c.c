@@ -26,6 +26,7 @@
 #include <string.h>
 
 extern char *license_file;
+extern int table_mode;
 
 static FILE *output = NULL;
 static int indent_level = 0;
@@ -35,11 +36,14 @@ struct _Proto3TypeOps
 {
     const char *proto_name;
     const char *c_name;
+    const char *table_name;
     void (*declare_field)(const Proto3TypeOps *type, Proto3Field *field);
     void (*free_field)(const Proto3TypeOps *type, Proto3Field *field);
     void (*clear_field)(const Proto3TypeOps *type, Proto3Field *field);
     void (*write_field)(const Proto3TypeOps *type, int tag, Proto3Field *field);
     void (*read_field)(const Proto3TypeOps *type, int tag, Proto3Message *message, Proto3Field *field);
+    void (*measure_field)(const Proto3TypeOps *type, int tag, Proto3Field *field);
+    void (*encode_field)(const Proto3TypeOps *type, int tag, Proto3Field *field);
     void (*declare_field_ops)(const Proto3TypeOps *type, Proto3Message *message, Proto3Field *field, int header_only);
 };
 
@@ -66,6 +70,37 @@ static void generate_name(FILE *output, const char *name)
     }
 }
 
+/**
+ * \brief Generates a reference to the descriptor for a field in table mode.
+ */
+static void generate_field_desc(Proto3Message *message, Proto3Field *field)
+{
+    const Proto3Field *current = message->fields;
+    int index = 0;
+    while (current != 0 && current != field) {
+        ++index;
+        current = current->next;
+    }
+    fprintf(output, "&");
+    generate_name(output, message->name.name);
+    fprintf(output, "_fields[%d]", index);
+}
+
+/**
+ * \brief Generates the body of a field operation that calls a shared
+ * table-driven helper.
+ */
+static void generate_table_field_call
+    (Proto3Message *message, Proto3Field *field,
+     const char *func, const char *args)
+{
+    fprintf(output, "\n{\n");
+    fprintf(output, "    return %s(", func);
+    generate_field_desc(message, field);
+    fprintf(output, ", %s);\n", args);
+    fprintf(output, "}\n\n");
+}
+
 /**
  * \brief Declares a numeric field in a struct.
  */
@@ -174,8 +209,11 @@ static void type_numeric_read_field
         fprintf(output, "noise_protobuf_read_%s(pbuf, %d, &value);\n",
                 type->proto_name, tag);
         print_indent();
-        generate_name(output, message->name.name);
-        fprintf(output, "_add_%s(*obj, value);\n", field->name.name);
+        fprintf(output, "noise_protobuf_read_add_to_array(pbuf, ");
+        fprintf(output, "(void **)&((*obj)->%s), &((*obj)->%s_count_), ",
+                field->name.name, field->name.name);
+        fprintf(output, "&((*obj)->%s_max_), &value, sizeof(value));\n",
+                field->name.name);
     } else if (field->qualifier == PROTO3_QUAL_PACKED) {
         print_indent();
         fprintf(output, "size_t end_packed = 0;\n");
@@ -190,8 +228,11 @@ static void type_numeric_read_field
         fprintf(output, "noise_protobuf_read_%s(pbuf, 0, &value);\n",
                 type->proto_name);
         print_indent();
-        generate_name(output, message->name.name);
-        fprintf(output, "_add_%s(*obj, value);\n", field->name.name);
+        fprintf(output, "noise_protobuf_read_add_to_array(pbuf, ");
+        fprintf(output, "(void **)&((*obj)->%s), &((*obj)->%s_count_), ",
+                field->name.name, field->name.name);
+        fprintf(output, "&((*obj)->%s_max_), &value, sizeof(value));\n",
+                field->name.name);
         --indent_level;
         print_indent();
         fprintf(output, "}\n");
@@ -204,6 +245,99 @@ static void type_numeric_read_field
     }
 }
 
+/**
+ * \brief Measures a numeric field.
+ */
+static void type_numeric_measure_field
+    (const Proto3TypeOps *type, int tag, Proto3Field *field)
+{
+    if (field->qualifier == PROTO3_QUAL_REPEATED) {
+        print_indent();
+        fprintf(output, "for (index = 0; index < obj->%s_count_; ++index)\n", field->name.name);
+        ++indent_level;
+        print_indent();
+        fprintf(output, "size += noise_protobuf_size_%s(%d, obj->%s[index]);\n",
+                type->proto_name, tag, field->name.name);
+        --indent_level;
+    } else if (field->qualifier == PROTO3_QUAL_PACKED) {
+        print_indent();
+        fprintf(output, "packed = 0;\n");
+        print_indent();
+        fprintf(output, "for (index = 0; index < obj->%s_count_; ++index)\n", field->name.name);
+        ++indent_level;
+        print_indent();
+        fprintf(output, "packed += noise_protobuf_size_%s(0, obj->%s[index]);\n",
+                type->proto_name, field->name.name);
+        --indent_level;
+        print_indent();
+        fprintf(output, "size += noise_protobuf_size_element(%d, packed);\n", tag);
+    } else if (field->qualifier == PROTO3_QUAL_OPTIONAL &&
+                    (field->type.id != PROTO3_TYPE_FLOAT &&
+                     field->type.id != PROTO3_TYPE_DOUBLE)) {
+        print_indent();
+        fprintf(output, "if (obj->%s)\n", field->name.name);
+        ++indent_level;
+        print_indent();
+        fprintf(output, "size += noise_protobuf_size_%s(%d, obj->%s);\n",
+                type->proto_name, tag, field->name.name);
+        --indent_level;
+    } else {
+        print_indent();
+        fprintf(output, "size += noise_protobuf_size_%s(%d, obj->%s);\n",
+                type->proto_name, tag, field->name.name);
+    }
+}
+
+/**
+ * \brief Encodes a numeric field.
+ */
+static void type_numeric_encode_field
+    (const Proto3TypeOps *type, int tag, Proto3Field *field)
+{
+    if (field->qualifier == PROTO3_QUAL_REPEATED) {
+        print_indent();
+        fprintf(output, "for (index = 0; index < obj->%s_count_; ++index)\n", field->name.name);
+        ++indent_level;
+        print_indent();
+        fprintf(output, "noise_protobuf_encode_%s(pbuf, %d, obj->%s[index]);\n",
+                type->proto_name, tag, field->name.name);
+        --indent_level;
+    } else if (field->qualifier == PROTO3_QUAL_PACKED) {
+        print_indent();
+        fprintf(output, "packed = 0;\n");
+        print_indent();
+        fprintf(output, "for (index = 0; index < obj->%s_count_; ++index)\n", field->name.name);
+        ++indent_level;
+        print_indent();
+        fprintf(output, "packed += noise_protobuf_size_%s(0, obj->%s[index]);\n",
+                type->proto_name, field->name.name);
+        --indent_level;
+        print_indent();
+        fprintf(output, "noise_protobuf_encode_start_element(pbuf, %d, packed);\n", tag);
+        print_indent();
+        fprintf(output, "for (index = 0; index < obj->%s_count_; ++index)\n", field->name.name);
+        ++indent_level;
+        print_indent();
+        fprintf(output, "noise_protobuf_encode_%s(pbuf, 0, obj->%s[index]);\n",
+                type->proto_name, field->name.name);
+        --indent_level;
+    } else if (field->qualifier == PROTO3_QUAL_OPTIONAL &&
+                    (field->type.id != PROTO3_TYPE_FLOAT &&
+                     field->type.id != PROTO3_TYPE_DOUBLE)) {
+        print_indent();
+        fprintf(output, "if (obj->%s)\n", field->name.name);
+        ++indent_level;
+        print_indent();
+        fprintf(output, "noise_protobuf_encode_%s(pbuf, %d, obj->%s);\n",
+                type->proto_name, tag, field->name.name);
+        --indent_level;
+    } else {
+        print_indent();
+        fprintf(output, "noise_protobuf_encode_%s(pbuf, %d, obj->%s);\n",
+                type->proto_name, tag, field->name.name);
+    }
+}
+
 /**
  * \brief Declare the field operations for a numeric field.
  */
@@ -218,6 +352,9 @@ static void type_numeric_declare_field_ops
     fprintf(output, " *obj)");
     if (header_only) {
         fprintf(output, ";\n");
+    } else if (table_mode) {
+        generate_table_field_call
+            (message, field, "noise_protobuf_table_clear_field", "obj");
     } else {
         fprintf(output, "\n{\n");
         fprintf(output, "    if (obj) {\n");
@@ -409,6 +546,8 @@ static void type_string_clear_field
     if (field->qualifier == PROTO3_QUAL_REPEATED ||
             field->qualifier == PROTO3_QUAL_PACKED) {
         print_indent();
+        fprintf(output, "obj->%s_size_ = 0;\n", field->name.name);
+        print_indent();
         fprintf(output, "obj->%s_count_ = 0;\n", field->name.name);
         print_indent();
         fprintf(output, "obj->%s_max_ = 0;\n", field->name.name);
@@ -460,18 +599,26 @@ static void type_string_read_field
         fprintf(output, "%svalue = 0;\n", type->c_name);
         print_indent();
         fprintf(output, "size_t len = 0;\n");
+        print_indent();
         if (field->type.id == PROTO3_TYPE_STRING) {
             fprintf(output, "noise_protobuf_read_alloc_string(pbuf, %d, &value, 0, &len);\n", tag);
         } else {
             fprintf(output, "noise_protobuf_read_alloc_bytes(pbuf, %d, &value, 0, &len);\n", tag);
         }
         print_indent();
-        generate_name(output, message->name.name);
-        fprintf(output, "_add_%s(*obj, value, len);\n", field->name.name);
+        fprintf(output, "noise_protobuf_read_add_to_block_array(pbuf, ");
+        fprintf(output, "(void ***)&((*obj)->%s), &((*obj)->%s_size_), ",
+                field->name.name, field->name.name);
+        fprintf(output, "&((*obj)->%s_count_), &((*obj)->%s_max_), value, len);\n",
+                field->name.name, field->name.name);
     } else {
+        print_indent();
+        fprintf(output, "if (!pbuf->arena)\n");
+        ++indent_level;
         print_indent();
         fprintf(output, "noise_protobuf_free_memory((*obj)->%s, (*obj)->%s_size_);\n",
                 field->name.name, field->name.name);
+        --indent_level;
         print_indent();
         fprintf(output, "(*obj)->%s = 0;\n", field->name.name);
         print_indent();
@@ -487,6 +634,66 @@ static void type_string_read_field
     }
 }
 
+/**
+ * \brief Measures a string field.
+ */
+static void type_string_measure_field
+    (const Proto3TypeOps *type, int tag, Proto3Field *field)
+{
+    if (field->qualifier == PROTO3_QUAL_REPEATED ||
+            field->qualifier == PROTO3_QUAL_PACKED) {
+        print_indent();
+        fprintf(output, "for (index = 0; index < obj->%s_count_; ++index)\n", field->name.name);
+        ++indent_level;
+        print_indent();
+        fprintf(output, "size += noise_protobuf_size_%s(%d, obj->%s_size_[index]);\n",
+                type->proto_name, tag, field->name.name);
+        --indent_level;
+    } else if (field->qualifier == PROTO3_QUAL_OPTIONAL) {
+        print_indent();
+        fprintf(output, "if (obj->%s)\n", field->name.name);
+        ++indent_level;
+        print_indent();
+        fprintf(output, "size += noise_protobuf_size_%s(%d, obj->%s_size_);\n",
+                type->proto_name, tag, field->name.name);
+        --indent_level;
+    } else {
+        print_indent();
+        fprintf(output, "size += noise_protobuf_size_%s(%d, obj->%s_size_);\n",
+                type->proto_name, tag, field->name.name);
+    }
+}
+
+/**
+ * \brief Encodes a string field.
+ */
+static void type_string_encode_field
+    (const Proto3TypeOps *type, int tag, Proto3Field *field)
+{
+    if (field->qualifier == PROTO3_QUAL_REPEATED ||
+            field->qualifier == PROTO3_QUAL_PACKED) {
+        print_indent();
+        fprintf(output, "for (index = 0; index < obj->%s_count_; ++index)\n", field->name.name);
+        ++indent_level;
+        print_indent();
+        fprintf(output, "noise_protobuf_encode_%s(pbuf, %d, obj->%s[index], obj->%s_size_[index]);\n",
+                type->proto_name, tag, field->name.name, field->name.name);
+        --indent_level;
+    } else if (field->qualifier == PROTO3_QUAL_OPTIONAL) {
+        print_indent();
+        fprintf(output, "if (obj->%s)\n", field->name.name);
+        ++indent_level;
+        print_indent();
+        fprintf(output, "noise_protobuf_encode_%s(pbuf, %d, obj->%s, obj->%s_size_);\n",
+                type->proto_name, tag, field->name.name, field->name.name);
+        --indent_level;
+    } else {
+        print_indent();
+        fprintf(output, "noise_protobuf_encode_%s(pbuf, %d, obj->%s, obj->%s_size_);\n",
+                type->proto_name, tag, field->name.name, field->name.name);
+    }
+}
+
 /**
  * \brief Declare the field operations for a string field.
  */
@@ -501,6 +708,9 @@ static void type_string_declare_field_ops
     fprintf(output, " *obj)");
     if (header_only) {
         fprintf(output, ";\n");
+    } else if (table_mode) {
+        generate_table_field_call
+            (message, field, "noise_protobuf_table_clear_field", "obj");
     } else {
         fprintf(output, "\n{\n");
         if (field->qualifier == PROTO3_QUAL_REPEATED ||
@@ -660,6 +870,9 @@ static void type_string_declare_field_ops
         fprintf(output, " *obj, const %svalue, size_t size)", type->c_name);
         if (header_only) {
             fprintf(output, ";\n");
+        } else if (table_mode) {
+            generate_table_field_call
+                (message, field, "noise_protobuf_table_set_field", "obj, value, size");
         } else {
             fprintf(output, "\n{\n");
             fprintf(output, "    if (obj) {\n");
@@ -826,24 +1039,22 @@ static void type_named_read_field
         generate_name(output, field->type.name.name);
         fprintf(output, " *value = 0;\n");
         print_indent();
-        fprintf(output, "int err;\n");
-        print_indent();
         generate_name(output, field->type.name.name);
         fprintf(output, "_read(pbuf, %d, &value);\n", tag);
         print_indent();
-        fprintf(output, "err = noise_protobuf_add_to_array(");
+        fprintf(output, "noise_protobuf_read_add_to_array(pbuf, ");
         fprintf(output, "(void **)&((*obj)->%s), &((*obj)->%s_count_), ",
                 field->name.name, field->name.name);
         fprintf(output, "&((*obj)->%s_max_), &value, sizeof(value));\n",
                 field->name.name);
-        print_indent();
-        fprintf(output, "if (err != NOISE_ERROR_NONE && pbuf->error != NOISE_ERROR_NONE)\n");
-        print_indent();
-        fprintf(output, "   pbuf->error = err;\n");
     } else {
+        print_indent();
+        fprintf(output, "if (!pbuf->arena)\n");
+        ++indent_level;
         print_indent();
         generate_name(output, field->type.name.name);
         fprintf(output, "_free((*obj)->%s);\n", field->name.name);
+        --indent_level;
         print_indent();
         fprintf(output, "(*obj)->%s = 0;\n", field->name.name);
         print_indent();
@@ -853,6 +1064,92 @@ static void type_named_read_field
     }
 }
 
+/**
+ * \brief Measures a named object field.
+ */
+static void type_named_measure_field
+    (const Proto3TypeOps *type, int tag, Proto3Field *field)
+{
+    if (field->qualifier == PROTO3_QUAL_REPEATED ||
+            field->qualifier == PROTO3_QUAL_PACKED) {
+        print_indent();
+        fprintf(output, "for (index = 0; index < obj->%s_count_; ++index)\n", field->name.name);
+        ++indent_level;
+        print_indent();
+        fprintf(output, "size += ");
+        generate_name(output, field->type.name.name);
+        fprintf(output, "_measure(%d, obj->%s[index]);\n",
+                tag, field->name.name);
+        --indent_level;
+    } else if (field->qualifier == PROTO3_QUAL_REQUIRED) {
+        /* A NULL required object is written as an empty object */
+        print_indent();
+        fprintf(output, "if (obj->%s)\n", field->name.name);
+        ++indent_level;
+        print_indent();
+        fprintf(output, "size += ");
+        generate_name(output, field->type.name.name);
+        fprintf(output, "_measure(%d, obj->%s);\n", tag, field->name.name);
+        --indent_level;
+        print_indent();
+        fprintf(output, "else\n");
+        ++indent_level;
+        print_indent();
+        fprintf(output, "size += noise_protobuf_size_element(%d, 0);\n", tag);
+        --indent_level;
+    } else {
+        print_indent();
+        fprintf(output, "if (obj->%s)\n", field->name.name);
+        ++indent_level;
+        print_indent();
+        fprintf(output, "size += ");
+        generate_name(output, field->type.name.name);
+        fprintf(output, "_measure(%d, obj->%s);\n", tag, field->name.name);
+        --indent_level;
+    }
+}
+
+/**
+ * \brief Encodes a named object field.
+ */
+static void type_named_encode_field
+    (const Proto3TypeOps *type, int tag, Proto3Field *field)
+{
+    if (field->qualifier == PROTO3_QUAL_REPEATED ||
+            field->qualifier == PROTO3_QUAL_PACKED) {
+        print_indent();
+        fprintf(output, "for (index = 0; index < obj->%s_count_; ++index)\n", field->name.name);
+        ++indent_level;
+        print_indent();
+        generate_name(output, field->type.name.name);
+        fprintf(output, "_encode(pbuf, %d, obj->%s[index]);\n",
+                tag, field->name.name);
+        --indent_level;
+    } else if (field->qualifier == PROTO3_QUAL_REQUIRED) {
+        print_indent();
+        fprintf(output, "if (obj->%s)\n", field->name.name);
+        ++indent_level;
+        print_indent();
+        generate_name(output, field->type.name.name);
+        fprintf(output, "_encode(pbuf, %d, obj->%s);\n", tag, field->name.name);
+        --indent_level;
+        print_indent();
+        fprintf(output, "else\n");
+        ++indent_level;
+        print_indent();
+        fprintf(output, "noise_protobuf_encode_start_element(pbuf, %d, 0);\n", tag);
+        --indent_level;
+    } else {
+        print_indent();
+        fprintf(output, "if (obj->%s)\n", field->name.name);
+        ++indent_level;
+        print_indent();
+        generate_name(output, field->type.name.name);
+        fprintf(output, "_encode(pbuf, %d, obj->%s);\n", tag, field->name.name);
+        --indent_level;
+    }
+}
+
 /**
  * \brief Declare the field operations for a named object field.
  */
@@ -867,6 +1164,9 @@ static void type_named_declare_field_ops
     fprintf(output, " *obj)");
     if (header_only) {
         fprintf(output, ";\n");
+    } else if (table_mode) {
+        generate_table_field_call
+            (message, field, "noise_protobuf_table_clear_field", "obj");
     } else {
         fprintf(output, "\n{\n");
         if (field->qualifier == PROTO3_QUAL_REPEATED ||
@@ -952,6 +1252,9 @@ static void type_named_declare_field_ops
         fprintf(output, " **value)");
         if (header_only) {
             fprintf(output, ";\n");
+        } else if (table_mode) {
+            generate_table_field_call
+                (message, field, "noise_protobuf_table_add_field", "obj, (void **)value");
         } else {
             fprintf(output, "\n{\n");
             fprintf(output, "    int err;\n");
@@ -1029,6 +1332,9 @@ static void type_named_declare_field_ops
         fprintf(output, " **value)");
         if (header_only) {
             fprintf(output, ";\n");
+        } else if (table_mode) {
+            generate_table_field_call
+                (message, field, "noise_protobuf_table_get_new_field", "obj, (void **)value");
         } else {
             fprintf(output, "\n{\n");
             fprintf(output, "    int err;\n");
@@ -1056,161 +1362,209 @@ static void type_named_declare_field_ops
 static Proto3TypeOps const type_int32 = {
     .proto_name = "int32",
     .c_name = "int32_t",
+    .table_name = "NOISE_PROTOBUF_TYPE_INT32",
     .declare_field = type_numeric_declare_field,
     .free_field = type_numeric_free_field,
     .clear_field = type_numeric_clear_field,
     .write_field = type_numeric_write_field,
     .read_field = type_numeric_read_field,
+    .measure_field = type_numeric_measure_field,
+    .encode_field = type_numeric_encode_field,
     .declare_field_ops = type_numeric_declare_field_ops
 };
 static Proto3TypeOps const type_uint32 = {
     .proto_name = "uint32",
     .c_name = "uint32_t",
+    .table_name = "NOISE_PROTOBUF_TYPE_UINT32",
     .declare_field = type_numeric_declare_field,
     .free_field = type_numeric_free_field,
     .clear_field = type_numeric_clear_field,
     .write_field = type_numeric_write_field,
     .read_field = type_numeric_read_field,
+    .measure_field = type_numeric_measure_field,
+    .encode_field = type_numeric_encode_field,
     .declare_field_ops = type_numeric_declare_field_ops
 };
 static Proto3TypeOps const type_int64 = {
     .proto_name = "int64",
     .c_name = "int64_t",
+    .table_name = "NOISE_PROTOBUF_TYPE_INT64",
     .declare_field = type_numeric_declare_field,
     .free_field = type_numeric_free_field,
     .clear_field = type_numeric_clear_field,
     .write_field = type_numeric_write_field,
     .read_field = type_numeric_read_field,
+    .measure_field = type_numeric_measure_field,
+    .encode_field = type_numeric_encode_field,
     .declare_field_ops = type_numeric_declare_field_ops
 };
 static Proto3TypeOps const type_uint64 = {
     .proto_name = "uint64",
     .c_name = "uint64_t",
+    .table_name = "NOISE_PROTOBUF_TYPE_UINT64",
     .declare_field = type_numeric_declare_field,
     .free_field = type_numeric_free_field,
     .clear_field = type_numeric_clear_field,
     .write_field = type_numeric_write_field,
     .read_field = type_numeric_read_field,
+    .measure_field = type_numeric_measure_field,
+    .encode_field = type_numeric_encode_field,
     .declare_field_ops = type_numeric_declare_field_ops
 };
 static Proto3TypeOps const type_sint32 = {
     .proto_name = "sint32",
     .c_name = "int32_t",
+    .table_name = "NOISE_PROTOBUF_TYPE_SINT32",
     .declare_field = type_numeric_declare_field,
     .free_field = type_numeric_free_field,
     .clear_field = type_numeric_clear_field,
     .write_field = type_numeric_write_field,
     .read_field = type_numeric_read_field,
+    .measure_field = type_numeric_measure_field,
+    .encode_field = type_numeric_encode_field,
     .declare_field_ops = type_numeric_declare_field_ops
 };
 static Proto3TypeOps const type_sint64 = {
     .proto_name = "sint64",
     .c_name = "int64_t",
+    .table_name = "NOISE_PROTOBUF_TYPE_SINT64",
     .declare_field = type_numeric_declare_field,
     .free_field = type_numeric_free_field,
     .clear_field = type_numeric_clear_field,
     .write_field = type_numeric_write_field,
     .read_field = type_numeric_read_field,
+    .measure_field = type_numeric_measure_field,
+    .encode_field = type_numeric_encode_field,
     .declare_field_ops = type_numeric_declare_field_ops
 };
 static Proto3TypeOps const type_fixed32 = {
     .proto_name = "fixed32",
     .c_name = "uint32_t",
+    .table_name = "NOISE_PROTOBUF_TYPE_FIXED32",
     .declare_field = type_numeric_declare_field,
     .free_field = type_numeric_free_field,
     .clear_field = type_numeric_clear_field,
     .write_field = type_numeric_write_field,
     .read_field = type_numeric_read_field,
+    .measure_field = type_numeric_measure_field,
+    .encode_field = type_numeric_encode_field,
     .declare_field_ops = type_numeric_declare_field_ops
 };
 static Proto3TypeOps const type_sfixed32 = {
     .proto_name = "sfixed32",
     .c_name = "int32_t",
+    .table_name = "NOISE_PROTOBUF_TYPE_SFIXED32",
     .declare_field = type_numeric_declare_field,
     .free_field = type_numeric_free_field,
     .clear_field = type_numeric_clear_field,
     .write_field = type_numeric_write_field,
     .read_field = type_numeric_read_field,
+    .measure_field = type_numeric_measure_field,
+    .encode_field = type_numeric_encode_field,
     .declare_field_ops = type_numeric_declare_field_ops
 };
 static Proto3TypeOps const type_fixed64 = {
     .proto_name = "fixed64",
     .c_name = "uint64_t",
+    .table_name = "NOISE_PROTOBUF_TYPE_FIXED64",
     .declare_field = type_numeric_declare_field,
     .free_field = type_numeric_free_field,
     .clear_field = type_numeric_clear_field,
     .write_field = type_numeric_write_field,
     .read_field = type_numeric_read_field,
+    .measure_field = type_numeric_measure_field,
+    .encode_field = type_numeric_encode_field,
     .declare_field_ops = type_numeric_declare_field_ops
 };
 static Proto3TypeOps const type_sfixed64 = {
     .proto_name = "sfixed64",
     .c_name = "int64_t",
+    .table_name = "NOISE_PROTOBUF_TYPE_SFIXED64",
     .declare_field = type_numeric_declare_field,
     .free_field = type_numeric_free_field,
     .clear_field = type_numeric_clear_field,
     .write_field = type_numeric_write_field,
     .read_field = type_numeric_read_field,
+    .measure_field = type_numeric_measure_field,
+    .encode_field = type_numeric_encode_field,
     .declare_field_ops = type_numeric_declare_field_ops
 };
 static Proto3TypeOps const type_float = {
     .proto_name = "float",
     .c_name = "float",
+    .table_name = "NOISE_PROTOBUF_TYPE_FLOAT",
     .declare_field = type_numeric_declare_field,
     .free_field = type_numeric_free_field,
     .clear_field = type_numeric_clear_field,
     .write_field = type_numeric_write_field,
     .read_field = type_numeric_read_field,
+    .measure_field = type_numeric_measure_field,
+    .encode_field = type_numeric_encode_field,
     .declare_field_ops = type_numeric_declare_field_ops
 };
 static Proto3TypeOps const type_double = {
     .proto_name = "double",
     .c_name = "double",
+    .table_name = "NOISE_PROTOBUF_TYPE_DOUBLE",
     .declare_field = type_numeric_declare_field,
     .free_field = type_numeric_free_field,
     .clear_field = type_numeric_clear_field,
     .write_field = type_numeric_write_field,
     .read_field = type_numeric_read_field,
+    .measure_field = type_numeric_measure_field,
+    .encode_field = type_numeric_encode_field,
     .declare_field_ops = type_numeric_declare_field_ops
 };
 static Proto3TypeOps const type_bool = {
     .proto_name = "bool",
     .c_name = "int",
+    .table_name = "NOISE_PROTOBUF_TYPE_BOOL",
     .declare_field = type_numeric_declare_field,
     .free_field = type_numeric_free_field,
     .clear_field = type_numeric_clear_field,
     .write_field = type_numeric_write_field,
     .read_field = type_numeric_read_field,
+    .measure_field = type_numeric_measure_field,
+    .encode_field = type_numeric_encode_field,
     .declare_field_ops = type_numeric_declare_field_ops
 };
 static Proto3TypeOps const type_string = {
     .proto_name = "string",
     .c_name = "char *",
+    .table_name = "NOISE_PROTOBUF_TYPE_STRING",
     .declare_field = type_string_declare_field,
     .free_field = type_string_free_field,
     .clear_field = type_string_clear_field,
     .write_field = type_string_write_field,
     .read_field = type_string_read_field,
+    .measure_field = type_string_measure_field,
+    .encode_field = type_string_encode_field,
     .declare_field_ops = type_string_declare_field_ops
 };
 static Proto3TypeOps const type_bytes = {
     .proto_name = "bytes",
     .c_name = "void *",
+    .table_name = "NOISE_PROTOBUF_TYPE_BYTES",
     .declare_field = type_string_declare_field,
     .free_field = type_string_free_field,
     .clear_field = type_string_clear_field,
     .write_field = type_string_write_field,
     .read_field = type_string_read_field,
+    .measure_field = type_string_measure_field,
+    .encode_field = type_string_encode_field,
     .declare_field_ops = type_string_declare_field_ops
 };
 static Proto3TypeOps const type_named = {
     .proto_name = "named",
     .c_name = "void *",
+    .table_name = "NOISE_PROTOBUF_TYPE_MESSAGE",
     .declare_field = type_named_declare_field,
     .free_field = type_named_free_field,
     .clear_field = type_named_clear_field,
     .write_field = type_named_write_field,
     .read_field = type_named_read_field,
+    .measure_field = type_named_measure_field,
+    .encode_field = type_named_encode_field,
     .declare_field_ops = type_named_declare_field_ops
 };
 
@@ -1394,6 +1748,38 @@ static void generate_declare_read
     fprintf(output, "\n");
 }
 
+/**
+ * \brief Generates the measure function declaration for a message type.
+ */
+static void generate_declare_measure
+    (FILE *output, Proto3Message *message, int is_h)
+{
+    fprintf(output, "size_t ");
+    generate_name(output, message->name.name);
+    fprintf(output, "_measure(int tag, const ");
+    generate_name(output, message->name.name);
+    fprintf(output, " *obj)");
+    if (is_h)
+        putc(';', output);
+    fprintf(output, "\n");
+}
+
+/**
+ * \brief Generates the encode function declaration for a message type.
+ */
+static void generate_declare_encode
+    (FILE *output, Proto3Message *message, int is_h)
+{
+    fprintf(output, "int ");
+    generate_name(output, message->name.name);
+    fprintf(output, "_encode(NoiseProtobuf *pbuf, int tag, const ");
+    generate_name(output, message->name.name);
+    fprintf(output, " *obj)");
+    if (is_h)
+        putc(';', output);
+    fprintf(output, "\n");
+}
+
 /**
  * \brief Generates the header file for the protobuf definition.
  */
@@ -1462,6 +1848,8 @@ static void generate_c_header(const char *output_h_name, FILE *output_h)
         generate_declare_dtor(output, message, 1);
         generate_declare_write(output, message, 1);
         generate_declare_read(output, message, 1);
+        generate_declare_measure(output, message, 1);
+        generate_declare_encode(output, message, 1);
         field = message->fields;
         while (field != 0) {
             ops = type_ops(field->type);
@@ -1583,11 +1971,13 @@ static void generate_implement_read(FILE *output, Proto3Message *message)
     fprintf(output, "    *obj = 0;\n");
     fprintf(output, "    if (!pbuf)\n");
     fprintf(output, "        return NOISE_ERROR_INVALID_PARAM;\n");
-    fprintf(output, "    err = ");
+    fprintf(output, "    *obj = (");
+    generate_name(output, message->name.name);
+    fprintf(output, " *)noise_protobuf_new_object(pbuf, sizeof(");
     generate_name(output, message->name.name);
-    fprintf(output, "_new(obj);\n");
-    fprintf(output, "    if (err != NOISE_ERROR_NONE)\n");
-    fprintf(output, "        return err;\n");
+    fprintf(output, "));\n");
+    fprintf(output, "    if (!(*obj))\n");
+    fprintf(output, "        return NOISE_ERROR_NO_MEMORY;\n");
     fprintf(output, "    noise_protobuf_read_start_element(pbuf, tag, &end_posn);\n");
     fprintf(output, "    while (!noise_protobuf_read_at_end_element(pbuf, end_posn)) {\n");
     fprintf(output, "        switch (noise_protobuf_peek_tag(pbuf)) {\n");
@@ -1612,7 +2002,8 @@ static void generate_implement_read(FILE *output, Proto3Message *message)
     fprintf(output, "    }\n");
     fprintf(output, "    err = noise_protobuf_read_end_element(pbuf, end_posn);\n");
     fprintf(output, "    if (err != NOISE_ERROR_NONE) {\n");
-    fprintf(output, "        ");
+    fprintf(output, "        if (!pbuf->arena)\n");
+    fprintf(output, "            ");
     generate_name(output, message->name.name);
     fprintf(output, "_free(*obj);\n");
     fprintf(output, "        *obj = 0;\n");
@@ -1621,6 +2012,213 @@ static void generate_implement_read(FILE *output, Proto3Message *message)
     fprintf(output, "}\n\n");
 }
 
+/**
+ * \brief Generates the measure function implementation for a message type.
+ *
+ * The size of the message body is cached in the object so that the
+ * encode function can write the length prefix before the fields.
+ */
+static void generate_implement_measure(Proto3Message *message)
+{
+    const Proto3TypeOps *ops;
+    Proto3Field *field;
+    generate_declare_measure(output, message, 0);
+    fprintf(output, "{\n");
+    fprintf(output, "    size_t size = 0;\n");
+    if (has_packed(message)) {
+        fprintf(output, "    size_t packed;\n");
+        fprintf(output, "    size_t index;\n");
+    } else if (has_repeated(message)) {
+        fprintf(output, "    size_t index;\n");
+    }
+    fprintf(output, "    if (!obj)\n");
+    fprintf(output, "        return 0;\n");
+    indent_level = 1;
+    field = message->fields;
+    while (field != 0) {
+        ops = type_ops(field->type);
+        ops->measure_field(ops, (int)(field->tag), field);
+        field = field->next;
+    }
+    fprintf(output, "    noise_protobuf_store_size_cache(&(obj->size_cache_), size);\n");
+    fprintf(output, "    return noise_protobuf_size_element(tag, size);\n");
+    fprintf(output, "}\n\n");
+}
+
+/**
+ * \brief Generates the encode function implementation for a message type.
+ *
+ * Fields are encoded in forward order of tag number, using the sizes
+ * that were cached by the measure function.
+ */
+static void generate_implement_encode(Proto3Message *message)
+{
+    const Proto3TypeOps *ops;
+    Proto3Field *field;
+    generate_declare_encode(output, message, 0);
+    fprintf(output, "{\n");
+    if (has_packed(message)) {
+        fprintf(output, "    size_t packed;\n");
+        fprintf(output, "    size_t index;\n");
+    } else if (has_repeated(message)) {
+        fprintf(output, "    size_t index;\n");
+    }
+    fprintf(output, "    if (!pbuf || !obj)\n");
+    fprintf(output, "        return NOISE_ERROR_INVALID_PARAM;\n");
+    fprintf(output, "    noise_protobuf_encode_start_element\n");
+    fprintf(output, "        (pbuf, tag, noise_protobuf_load_size_cache(&(obj->size_cache_)));\n");
+    indent_level = 1;
+    field = message->fields;
+    while (field != 0) {
+        ops = type_ops(field->type);
+        ops->encode_field(ops, (int)(field->tag), field);
+        field = field->next;
+    }
+    fprintf(output, "    return pbuf->error;\n");
+    fprintf(output, "}\n\n");
+}
+
+/**
+ * \brief Gets the name of the table qualifier constant for a field.
+ */
+static const char *table_qualifier(const Proto3Field *field)
+{
+    switch (field->qualifier) {
+    case PROTO3_QUAL_REPEATED:  return "NOISE_PROTOBUF_QUAL_REPEATED";
+    case PROTO3_QUAL_REQUIRED:  return "NOISE_PROTOBUF_QUAL_REQUIRED";
+    case PROTO3_QUAL_OPTIONAL:  break;
+    case PROTO3_QUAL_PACKED:    return "NOISE_PROTOBUF_QUAL_PACKED";
+    }
+    return "NOISE_PROTOBUF_QUAL_OPTIONAL";
+}
+
+/**
+ * \brief Generates an offsetof() expression for a member of a message.
+ */
+static void generate_offsetof
+    (Proto3Message *message, Proto3Field *field, const char *suffix)
+{
+    fprintf(output, "offsetof(");
+    generate_name(output, message->name.name);
+    fprintf(output, ", %s%s)", field->name.name, suffix);
+}
+
+/**
+ * \brief Generates the descriptor tables for a message type.
+ *
+ * The field descriptors are output in declaration order, which is the
+ * order that the shared serializer will encode them in.
+ */
+static void generate_table_desc(Proto3Message *message)
+{
+    const Proto3TypeOps *ops;
+    Proto3Field *field;
+    int num_fields = 0;
+
+    field = message->fields;
+    if (field) {
+        fprintf(output, "static const NoiseProtobufFieldDesc ");
+        generate_name(output, message->name.name);
+        fprintf(output, "_fields[] = {\n");
+    }
+    while (field != 0) {
+        ops = type_ops(field->type);
+        fprintf(output, "    {%d, %s, %s,\n     ", (int)(field->tag),
+                ops->table_name, table_qualifier(field));
+        generate_offsetof(message, field, "");
+        fprintf(output, ",\n     ");
+        if (field->type.id == PROTO3_TYPE_STRING ||
+                field->type.id == PROTO3_TYPE_BYTES)
+            generate_offsetof(message, field, "_size_");
+        else
+            fprintf(output, "0");
+        if (field->qualifier == PROTO3_QUAL_REPEATED ||
+                field->qualifier == PROTO3_QUAL_PACKED) {
+            fprintf(output, ",\n     ");
+            generate_offsetof(message, field, "_count_");
+            fprintf(output, ",\n     ");
+            generate_offsetof(message, field, "_max_");
+        } else {
+            fprintf(output, ", 0, 0");
+        }
+        if (field->type.id == PROTO3_TYPE_NAMED) {
+            fprintf(output, ",\n     &");
+            generate_name(output, field->type.name.name);
+            fprintf(output, "_desc},\n");
+        } else {
+            fprintf(output, ", 0},\n");
+        }
+        ++num_fields;
+        field = field->next;
+    }
+    if (num_fields)
+        fprintf(output, "};\n");
+    fprintf(output, "static const NoiseProtobufMessageDesc ");
+    generate_name(output, message->name.name);
+    fprintf(output, "_desc = {\n");
+    fprintf(output, "    sizeof(");
+    generate_name(output, message->name.name);
+    fprintf(output, "), offsetof(");
+    generate_name(output, message->name.name);
+    fprintf(output, ", size_cache_),\n    %d, ", num_fields);
+    if (num_fields) {
+        generate_name(output, message->name.name);
+        fprintf(output, "_fields\n");
+    } else {
+        fprintf(output, "0\n");
+    }
+    fprintf(output, "};\n\n");
+}
+
+/**
+ * \brief Generates the message-level functions for a message type in
+ * table mode, which all defer to the shared table-driven serializer.
+ */
+static void generate_implement_table(Proto3Message *message)
+{
+    generate_declare_ctor(output, message, 0);
+    fprintf(output, "{\n");
+    fprintf(output, "    return noise_protobuf_table_new(&");
+    generate_name(output, message->name.name);
+    fprintf(output, "_desc, (void **)obj);\n");
+    fprintf(output, "}\n\n");
+
+    generate_declare_dtor(output, message, 0);
+    fprintf(output, "{\n");
+    fprintf(output, "    return noise_protobuf_table_free(&");
+    generate_name(output, message->name.name);
+    fprintf(output, "_desc, obj);\n");
+    fprintf(output, "}\n\n");
+
+    generate_declare_write(output, message, 0);
+    fprintf(output, "{\n");
+    fprintf(output, "    return noise_protobuf_table_write(pbuf, tag, &");
+    generate_name(output, message->name.name);
+    fprintf(output, "_desc, obj);\n");
+    fprintf(output, "}\n\n");
+
+    generate_declare_read(output, message, 0);
+    fprintf(output, "{\n");
+    fprintf(output, "    return noise_protobuf_table_read(pbuf, tag, &");
+    generate_name(output, message->name.name);
+    fprintf(output, "_desc, (void **)obj);\n");
+    fprintf(output, "}\n\n");
+
+    generate_declare_measure(output, message, 0);
+    fprintf(output, "{\n");
+    fprintf(output, "    return noise_protobuf_table_measure(tag, &");
+    generate_name(output, message->name.name);
+    fprintf(output, "_desc, obj);\n");
+    fprintf(output, "}\n\n");
+
+    generate_declare_encode(output, message, 0);
+    fprintf(output, "{\n");
+    fprintf(output, "    return noise_protobuf_table_encode(pbuf, tag, &");
+    generate_name(output, message->name.name);
+    fprintf(output, "_desc, obj);\n");
+    fprintf(output, "}\n\n");
+}
+
 /**
  * \brief Generates the source file for the protobuf definition.
  */
@@ -1637,8 +2235,10 @@ static void generate_c_source(const char *output_c_name,
     indent_level = 0;
     generate_license(output);
     fprintf(output, "#include \"%s\"\n", output_h_name);
-    fprintf(output, "#include <stdlib.h>\n");
-    fprintf(output, "#include <string.h>\n");
+    if (!table_mode) {
+        fprintf(output, "#include <stdlib.h>\n");
+        fprintf(output, "#include <string.h>\n");
+    }
     fprintf(output, "\n");
 
     /* Output the message struct definitions */
@@ -1655,19 +2255,44 @@ static void generate_c_source(const char *output_c_name,
             ops->declare_field(ops, field);
             field = field->next;
         }
+        print_indent();
+        fprintf(output, "size_t size_cache_;\n");
         --indent_level;
         print_indent();
         fprintf(output, "};\n\n");
         message = message->next;
     }
 
+    /* Output the descriptor tables for all message types */
+    if (table_mode) {
+        message = proto3_first_message();
+        while (message != 0) {
+            fprintf(output, "static const NoiseProtobufMessageDesc ");
+            generate_name(output, message->name.name);
+            fprintf(output, "_desc;\n");
+            message = message->next;
+        }
+        fprintf(output, "\n");
+        message = proto3_first_message();
+        while (message != 0) {
+            generate_table_desc(message);
+            message = message->next;
+        }
+    }
+
     /* Output the accessor implementations for all message types */
     message = proto3_first_message();
     while (message != 0) {
-        generate_implement_ctor(output, message);
-        generate_implement_dtor(output, message);
-        generate_implement_write(message);
-        generate_implement_read(output, message);
+        if (table_mode) {
+            generate_implement_table(message);
+        } else {
+            generate_implement_ctor(output, message);
+            generate_implement_dtor(output, message);
+            generate_implement_write(message);
+            generate_implement_read(output, message);
+            generate_implement_measure(message);
+            generate_implement_encode(message);
+        }
         field = message->fields;
         while (field != 0) {
             ops = type_ops(field->type);